@@ -9,6 +9,8 @@
 
 #include <ctime>
 
+class CompiledTimeZone;
+
 #ifndef POPULATE_TM_DATE_TIME
 #define POPULATE_TM_DATE_TIME(tm_info, year, mon, mday, hour, min, sec, isdst)                     \
     do {                                                                                           \
@@ -101,8 +103,16 @@ class CalendarEvent {
     //   - DATE-TIME (TZID): "20251119T140000" with tzid="America/Los_Angeles"
     //   - DATE-TIME (Floating): "20251119T080000" (no tzid, no Z)
     //   - DATE (All-Day): "20251119" with isDate=true
-    bool setStartDateTime(const String& value, const String& tzid = "", bool isDate = false);
-    bool setEndDateTime(const String& value, const String& tzid = "", bool isDate = false);
+    // zone, when given, is the already resolved TZID (e.g. from a VTIMEZONE block)
+    bool setStartDateTime(const String& value, const String& tzid = "", bool isDate = false,
+                          const CompiledTimeZone* zone = nullptr);
+    bool setEndDateTime(const String& value, const String& tzid = "", bool isDate = false,
+                        const CompiledTimeZone* zone = nullptr);
+
+    // Convert a single DATE or DATE-TIME value (e.g. one EXDATE entry) to a Unix
+    // timestamp using the same rules as setStartDateTime(); returns 0 if invalid
+    static time_t parseDateTimeValue(const String& value, const String& tzid = "",
+                                     bool isDate = false, const CompiledTimeZone* zone = nullptr);
 
     // Comparison operators
     bool operator<(const CalendarEvent& other) const;
@@ -114,7 +124,8 @@ class CalendarEvent {
 
   private:
     // Helper method to parse ICS datetime with timezone support
-    time_t parseICSDateTime(const String& value, const String& tzid, bool isDate, bool hasZ) const;
+    static time_t parseICSDateTime(const String& value, const String& tzid, bool isDate, bool hasZ,
+                                   const CompiledTimeZone* zone);
 };
 
 #endif // CALENDAR_EVENT_H
\ No newline at end of file
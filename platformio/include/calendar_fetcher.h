@@ -6,6 +6,13 @@
 #include <LittleFS.h>
 #include <WiFiClient.h>
 
+#include "connection_pool.h"
+#include "feed_tail.h"
+#include "fetch_telemetry.h"
+#include "http_body_stream.h"
+#include "http_validators.h"
+#include "inflate_stream.h"
+
 // Result structure for fetch operations
 struct FetchResult {
     bool success;
@@ -24,12 +31,26 @@ class CalendarFetcher {
     File fileStream;
     int timeout;
     bool debug;
+    int lastHttpCode;
+    HttpValidators responseValidators;
+    InflateStream* inflater; // Decoder over the HTTP stream for gzip/deflate bodies
+    bool compression;        // Ask for gzip/deflate bodies
+    bool partialContent;     // Current stream continues the feed after a FeedTail
+    int contentLength;       // Content-Length of the current response (-1 if unknown)
+    FetchTimings timings;    // Network timings of the last fetchStream() call
+
+    // Keep-alive requests (only with a connection pool)
+    ConnectionPool* pool;
+    PooledConnection* connection; // Borrowed for the current request
+    HttpBodyStream* body;         // Body framing over the pooled connection
+    bool keepAlive;               // Server did not answer "Connection: close"
 
     // Helper functions
     bool isLocalUrl(const String& url) const;
     String getLocalPath(const String& url) const;
     FetchResult fetchFromHttp(const String& url);
     FetchResult fetchFromFile(const String& path);
+    void releaseConnection(bool reusable);
 
   public:
     CalendarFetcher();
@@ -39,13 +60,47 @@ class CalendarFetcher {
     void setTimeout(int timeoutMs) { timeout = timeoutMs; }
     void setDebug(bool enable) { debug = enable; }
 
+    // Send remote requests with HTTP/1.1 keep-alive over connections borrowed
+    // from pool (nullptr = one HTTP/1.0 connection per request)
+    void setConnectionPool(ConnectionPool* connectionPool) { pool = connectionPool; }
+
+    // Ask for gzip/deflate bodies (on by default). Incremental downloads need
+    // identity bodies: Range offsets count the bytes as sent.
+    void setCompression(bool enable) { compression = enable; }
+
     // Main fetch function - automatically determines local vs remote
     FetchResult fetch(const String& url);
 
     // Stream-based fetching for large files
-    Stream* fetchStream(const String& url);
+    // With validators, the request is conditional: a 304 Not Modified
+    // returns nullptr with getLastHttpCode() == HTTP_CODE_NOT_MODIFIED
+    // With a valid resume tail, only the bytes after it are requested; if the
+    // server sends them and the anchor matches, isPartialContent() is set and
+    // the stream starts right after the tail. Otherwise the full feed is
+    // fetched instead.
+    Stream* fetchStream(const String& url,
+                        const HttpValidators* validators = nullptr,
+                        const FeedTail* resume           = nullptr);
     void endStream();
 
+    // Outcome of the last fetchStream() call
+    int getLastHttpCode() const { return lastHttpCode; }
+    const HttpValidators& getResponseValidators() const { return responseValidators; }
+    bool isPartialContent() const { return partialContent; }
+    // Body size on the wire as announced by the server (-1 for chunked or
+    // close-delimited bodies)
+    int getContentLength() const { return contentLength; }
+    // Connection, first-byte and retry figures of the last request (see FetchTimings)
+    const FetchTimings& getLastTimings() const { return timings; }
+
+    // The current stream is decoded from gzip/deflate
+    bool isEncoded() const { return inflater != nullptr; }
+    // Compressed bytes received for the current stream (0 when not encoded)
+    size_t getCompressedBytes() const { return inflater ? inflater->getCompressedBytes() : 0; }
+
+    // Decoding or framing error of the current stream, or nullptr
+    const char* getStreamError() const;
+
     // Utility functions
     static String getFilenameFromUrl(const String& url);
     static bool cacheToFile(const String& data, const String& filename);
@@ -12,18 +12,25 @@
 #include <Arduino.h>
 #endif
 #include "calendar_event.h"
+#include "feed_tail.h"
+#include "fetch_telemetry.h"
+#include "http_validators.h"
+#include "recurrence_overrides.h"
+#include "rrule_cache.h"
+#include "rrule_engine.h"
+#include "timezone_engine.h"
+#include <functional>
 #include <vector>
 
 // Forward declarations
 class Stream;
 class CalendarFetcher;
+class ConnectionPool;
+struct IcsProperty;
 
 // Callback function for processing events as they're parsed
 typedef std::function<void(CalendarEvent*)> EventCallback;
 
-// Enum for recurrence frequency (RFC 5545)
-enum class RecurrenceFrequency { YEARLY, MONTHLY, WEEKLY, DAILY, HOURLY, MINUTELY, SECONDLY, NONE };
-
 // Result structure for filtered events
 struct FilteredEvents {
     std::vector<CalendarEvent*> events;
@@ -31,8 +38,17 @@ struct FilteredEvents {
     size_t totalFiltered; // Events that matched the filter
     bool success;
     String error;
-
-    FilteredEvents() : totalParsed(0), totalFiltered(0), success(true) {}
+    bool notModified;          // Server answered 304: the cached events are still current
+    HttpValidators validators; // ETag / Last-Modified of the response, for the next conditional fetch
+    size_t bytesTransferred;   // Calendar bytes received, compressed size if encoded (0 on 304)
+    bool partial;              // Only the VEVENTs appended after the resume tail were parsed
+    FeedTail tail;             // Resume point for the next incremental fetch (invalid if none)
+    bool spooled;              // Body saved to flash unparsed; parseSpooledEvents() delivers the events
+    FetchTimings timings;      // Connection, first-byte and retry figures of the download
+
+    FilteredEvents()
+        : totalParsed(0), totalFiltered(0), success(true), notModified(false), bytesTransferred(0), partial(false),
+          spooled(false) {}
 
     ~FilteredEvents() {
         // Clean up allocated events
@@ -46,45 +62,76 @@ struct FilteredEvents {
 };
 
 /**
- * Parsed RRULE components according to RFC 5545
- * Represents the structured form of a recurrence rule
+ * Counters collected during the last streamParseFromStream() call
  */
-struct RRuleComponents {
-    // Core frequency (REQUIRED)
-    String freq; // YEARLY, MONTHLY, WEEKLY, DAILY, HOURLY, MINUTELY, SECONDLY
-
-    // Termination rules (mutually exclusive, but COUNT takes precedence if both present)
-    int count;    // Number of occurrences (-1 = not specified)
-    time_t until; // End date for recurrence (0 = not specified)
-
-    // Frequency multiplier
-    int interval; // Interval between occurrences (default: 1)
-
-    // Filters for expanding/restricting occurrences
-    String byDay;      // Comma-separated day codes (e.g., "MO,WE,FR")
-    String byMonthDay; // Comma-separated day numbers (e.g., "1,15,-1")
-    String byMonth;    // Comma-separated month numbers (e.g., "1,7" for Jan, Jul)
-
-    // Constructor with sensible defaults
-    RRuleComponents() : count(-1), until(0), interval(1) {}
-
-    // Helper methods for checking RRULE components
-    bool hasCountLimit() const { return count > 0; }
-    bool hasUntilLimit() const { return until > 0; }
-    bool hasInterval() const { return interval > 1; }
-    bool hasByDay() const { return !byDay.isEmpty(); }
-    bool hasByMonthDay() const { return !byMonthDay.isEmpty(); }
-    bool hasByMonth() const { return !byMonth.isEmpty(); }
-    bool isValid() const { return !freq.isEmpty(); }
-
-    // Helper methods for checking frequency type
-    bool isYearly() const { return freq == "YEARLY"; }
-    bool isMonthly() const { return freq == "MONTHLY"; }
-    bool isWeekly() const { return freq == "WEEKLY"; }
-    bool isDaily() const { return freq == "DAILY"; }
-    bool isHourly() const { return freq == "HOURLY"; }
-    bool isMinutely() const { return freq == "MINUTELY"; }
-    bool isSecondly() const { return freq == "SECONDLY"; }
+struct StreamParseStats {
+    size_t bytesRead;        // Raw bytes pulled from the stream
+    size_t linesRead;        // Unfolded logical lines
+    size_t eventsParsed;     // VEVENT blocks parsed into CalendarEvent objects
+    size_t eventsFiltered;   // Events (and occurrences) passed to the callback
+    size_t eventsRejected;   // Events outside the requested date range
+    size_t eventsSkipped;    // Out-of-range VEVENT blocks dropped by the pre-filter without parsing
+    size_t timezones;        // VTIMEZONE blocks compiled into the calendar zone table
+    size_t overrides;        // EXDATE/RECURRENCE-ID instances in the override index
+    size_t rruleCacheHits;   // Recurring events whose RRULE was already compiled
+    size_t rruleCacheMisses; // Recurring events whose RRULE had to be parsed
+    size_t earlyExpansions;  // Masters expanded before the end of a stream without an override pre-pass
+    unsigned long parseMs;   // Wall time spent in streamParseFromStream
+    unsigned long stallMs;   // Part of parseMs spent waiting for the stream to deliver data
+
+    StreamParseStats()
+        : bytesRead(0), linesRead(0), eventsParsed(0), eventsFiltered(0), eventsRejected(0),
+          eventsSkipped(0), timezones(0), overrides(0), rruleCacheHits(0), rruleCacheMisses(0),
+          earlyExpansions(0), parseMs(0), stallMs(0) {}
+};
+
+/**
+ * Lazy generator for the occurrences of one event within a query range
+ *
+ * Created by CalendarStreamParser::iterateOccurrences(). Every next() call
+ * advances the recurrence rule just far enough to produce the next
+ * occurrence as a (start, end) pair; nothing is allocated per occurrence, so
+ * the consumer decides which ones become CalendarEvent copies and can stop
+ * early. The iterator keeps a pointer to the parser's override index, so the
+ * parser must outlive it.
+ */
+class OccurrenceIterator {
+  public:
+    OccurrenceIterator();
+
+    /**
+     * @brief Produce the next occurrence
+     *
+     * @param start Output: occurrence start (Unix timestamp)
+     * @param end Output: occurrence end (start + event duration)
+     * @return false once the rule, COUNT, UNTIL or the query range is exhausted
+     */
+    bool next(time_t& start, time_t& end);
+
+    /** @brief Number of rule periods expanded so far (in range or not) */
+    int getStepCount() const { return expander.getPeriodCount(); }
+
+  private:
+    friend class CalendarStreamParser;
+
+    bool accept(time_t occurrence, time_t& start, time_t& end);
+
+    RecurrenceFrequency freq; // NONE yields the event itself once
+    bool finished;
+    time_t eventStart;
+    time_t duration;
+    time_t startDate;
+    time_t endDate;
+    time_t effectiveEndDate; // min(endDate, UNTIL)
+    int occurrenceIndex;     // Absolute occurrence number (for COUNT)
+    int maxCount;
+    int yielded;
+    int maxOccurrences;      // Per-query cap on yielded occurrences
+
+    RRuleExpander expander;
+
+    uint32_t uidHash;
+    const RecurrenceOverrideIndex* overrides;
 };
 
 class CalendarStreamParser {
@@ -100,13 +147,20 @@ class CalendarStreamParser {
      * @param startDate Start of date range (Unix timestamp)
      * @param endDate End of date range (Unix timestamp)
      * @param maxEvents Maximum number of events to return (0 = no limit)
-     * @return FilteredEvents containing only events in the specified range
+     * @param validators Validators of the cached copy; makes a remote fetch conditional
+     * @param resume Tail of the previous download (incremental mode only)
+     * @return FilteredEvents containing only events in the specified range.
+     *         On 304 Not Modified: success with notModified set and no events.
+     *         With partial set, events holds only the appended VEVENTs.
+     *         With spooled set, events is empty until parseSpooledEvents().
      */
     FilteredEvents* fetchEventsInRange(const String& url,
                                        time_t startDate,
                                        time_t endDate,
-                                       size_t maxEvents        = 100,
-                                       const String& cachePath = "");
+                                       size_t maxEvents                 = 100,
+                                       const String& cachePath          = "",
+                                       const HttpValidators* validators = nullptr,
+                                       const FeedTail* resume           = nullptr);
 
     /**
      * Stream parse with callback - for custom processing without storing events
@@ -116,13 +170,40 @@ class CalendarStreamParser {
      * @param callback Function called for each parsed event
      * @param startDate Optional start date filter (0 = no filter)
      * @param endDate Optional end date filter (0 = no filter)
-     * @return true if parsing succeeded
+     * @param validators Validators of the cached copy; makes a remote fetch conditional
+     * @param resume Tail of the previous download; in incremental mode only
+     *        the bytes after it are requested (see wasPartial())
+     * @return true if parsing succeeded, or if the server answered 304 Not
+     *         Modified (see wasNotModified(); the callback is not called), or
+     *         if the body was spooled (see wasSpooled(); the callback is not
+     *         called until streamParseSpool())
      */
     bool streamParse(const String& url,
                      EventCallback callback,
-                     time_t startDate        = 0,
-                     time_t endDate          = 0,
-                     const String& cachePath = "");
+                     time_t startDate                 = 0,
+                     time_t endDate                   = 0,
+                     const String& cachePath          = "",
+                     const HttpValidators* validators = nullptr,
+                     const FeedTail* resume           = nullptr);
+
+    /**
+     * Parse the body spooled by the last streamParse() call and delete it
+     * Needs no network: validators, partial state and bytes transferred keep
+     * the values of that download, the feed tail is computed here.
+     *
+     * @param callback Function called for each parsed event
+     * @param startDate Optional start date filter (0 = no filter)
+     * @param endDate Optional end date filter (0 = no filter)
+     * @return true if parsing succeeded
+     */
+    bool streamParseSpool(EventCallback callback, time_t startDate = 0, time_t endDate = 0);
+
+    /**
+     * fetchEventsInRange() counterpart of streamParseSpool()
+     *
+     * @return FilteredEvents of the spooled body, filled in as by fetchEventsInRange()
+     */
+    FilteredEvents* parseSpooledEvents(time_t startDate, time_t endDate, size_t maxEvents = 100);
 
     /**
      * Stream-based parsing from a Stream pointer
@@ -155,76 +236,168 @@ class CalendarStreamParser {
     void setCalendarColor(uint16_t color) { calendarColor = color; }
     void setCalendarName(const String& name) { calendarName = name; }
 
+    // Drop non-recurring out-of-range VEVENTs from their DTSTART/DTEND lines
+    // without buffering or parsing them (on by default)
+    void setSkipAhead(bool enable) { skipAhead = enable; }
+
+    // Borrow keep-alive connections from pool for remote fetches (nullptr = none)
+    void setConnectionPool(ConnectionPool* pool);
+
+    // Track the feed tail of remote downloads and resume after it when asked
+    // to (off by default). Bodies are then requested without compression.
+    void setIncremental(bool enable);
+
+    // Write remote bodies of at least minBytes (Content-Length on the wire; an
+    // unknown length counts as large) to path instead of parsing them as they
+    // arrive, so the download runs at link speed and the radio can be turned
+    // off before streamParseSpool(). An empty path disables spooling.
+    void setSpool(const String& path, size_t minBytes);
+
+    // Statistics of the most recent streamParseFromStream() call
+    const StreamParseStats& getLastParseStats() const { return lastStats; }
+
+    // Outcome of the most recent streamParse() call on a remote URL
+    bool wasNotModified() const { return lastNotModified; }
+    const HttpValidators& getLastValidators() const { return lastValidators; }
+    // Bytes received over the network: compressed size for gzip/deflate bodies
+    size_t getLastBytesTransferred() const { return lastBytesTransferred; }
+    // Only the VEVENTs appended after the resume tail were parsed
+    bool wasPartial() const { return lastPartial; }
+    // Tail of the feed as downloaded (incremental mode, identity bodies only)
+    const FeedTail& getLastFeedTail() const { return lastTail; }
+    // The body was written to the spool file instead of being parsed
+    bool wasSpooled() const { return lastSpooled; }
+    // Time the body took to arrive (includes parsing unless it was spooled)
+    unsigned long getLastDownloadMs() const { return lastDownloadMs; }
+    // Connection, first-byte and retry figures of the request
+    const FetchTimings& getLastTimings() const { return lastTimings; }
+
     // V2: Refactored version without arbitrary limits (public for testing)
+    // Materializes every occurrence; prefer iterateOccurrences() when most are discarded
     std::vector<CalendarEvent*>
     expandRecurringEventV2(CalendarEvent* event, time_t startDate, time_t endDate);
 
-    // RRULE parsing methods (public for testing)
-    RRuleComponents parseRRule(const String& rrule);
-    std::vector<int> parseByDay(const String& byDay);
-    std::vector<int> parseByMonthDay(const String& byMonthDay);
-    std::vector<int> parseByMonth(const String& byMonth);
-    time_t parseUntilDate(const String& untilStr);
+    // Lazily enumerate the occurrences expandRecurringEventV2() would return.
+    // The event must stay alive while the iterator is used.
+    OccurrenceIterator iterateOccurrences(const CalendarEvent* event, time_t startDate, time_t endDate);
 
-    // Helper to find first occurrence on or after startDate (public for testing)
-    // Returns the timestamp of first occurrence, or -1 if no valid occurrence exists
-    // If count > 0, checks if the recurrence has already completed before startDate
-    time_t findFirstOccurrence(time_t eventStart,
-                               time_t startDate,
-                               time_t endDate,
-                               int interval,
-                               RecurrenceFrequency freq,
-                               int count = -1);
+    // Copy an event onto one occurrence produced by an OccurrenceIterator (caller must delete)
+    static CalendarEvent* materializeOccurrence(const CalendarEvent* event, time_t start, time_t end);
 
-    // Convert string frequency to enum
-    static RecurrenceFrequency frequencyFromString(const String& freqStr);
+    // Upper bound on occurrences produced for one event per query, so that a
+    // MINUTELY rule over a long range cannot exhaust the heap
+    static const int MAX_OCCURRENCES_PER_QUERY = 1000;
+
+    // RRULE parsing methods (public for testing); BYxxx lists are turned
+    // into sets by CompiledRRule::compile()
+    RRuleComponents parseRRule(const String& rrule);
+    time_t parseUntilDate(const String& untilStr);
 
     // Parse a single event from buffer (public for testing)
     CalendarEvent* parseEventFromBuffer(const String& eventData);
 
   private:
-    // V2: Frequency-specific expansion methods
-    std::vector<CalendarEvent*> expandYearlyV2(CalendarEvent* event,
-                                               const RRuleComponents& rule,
-                                               time_t startDate,
-                                               time_t endDate);
-
-    std::vector<CalendarEvent*> expandMonthlyV2(CalendarEvent* event,
-                                                const RRuleComponents& rule,
-                                                time_t startDate,
-                                                time_t endDate);
-
-    std::vector<CalendarEvent*> expandWeeklyV2(CalendarEvent* event,
-                                               const RRuleComponents& rule,
-                                               time_t startDate,
-                                               time_t endDate);
-
-    std::vector<CalendarEvent*> expandDailyV2(CalendarEvent* event,
-                                              const RRuleComponents& rule,
-                                              time_t startDate,
-                                              time_t endDate);
-
     // Member variables
     bool debug;
+    bool skipAhead;
+    bool incremental;
     uint16_t calendarColor;
     String calendarName;
     CalendarFetcher* fetcher;
+    StreamParseStats lastStats;
+    bool lastNotModified;
+    HttpValidators lastValidators;
+    size_t lastBytesTransferred;
+    bool lastPartial;
+    FeedTail lastTail;
+
+    // Spooling of large bodies (see setSpool())
+    String spoolPath;
+    size_t spoolMinBytes;
+    bool spoolFailed;     // Last spool could not be written: parse the retry directly
+    bool lastSpooled;
+    bool spoolEncoded;    // Spooled body arrived gzip/deflate-encoded (offsets unusable)
+    FeedTail spoolResume; // Tail the spooled partial body continues
+    unsigned long lastDownloadMs;
+    FetchTimings lastTimings;
+
+    // Copy body to the spool file in CALENDAR_SPOOL_WRITE_BYTES writes.
+    // The body must be expectedBytes long or, when that is unknown (-1),
+    // end with END:VCALENDAR; anything shorter fails
+    bool spoolBody(Stream* body, long expectedBytes, size_t& written);
+
+    // Parse a body, tracking its feed tail in incremental mode; resume is
+    // the tail a partial body continues
+    bool parseBody(Stream* body, EventCallback callback, time_t startDate, time_t endDate,
+                   const FeedTail* resume, FeedTail& tail);
+
+    // Copy the outcome of the last parse into result and sort its events
+    void finishResult(FilteredEvents* result, bool success);
+
+    // Zones defined by VTIMEZONE blocks of the calendar being parsed
+    struct CalendarZone {
+        String tzid;
+        String posix; // Kept for the feed tail of an incremental fetch
+        CompiledTimeZone zone;
+    };
+    std::vector<CalendarZone> calendarZones;
+    std::vector<FeedZone> resumeZones; // Zones of the feed a partial body continues
+
+    // Instances removed from recurring masters by EXDATE or RECURRENCE-ID
+    RecurrenceOverrideIndex overrideIndex;
+
+    // RRULEs compiled during the current calendar, keyed by rule text
+    RRuleCache rruleCache;
+
+    // Compile an RRULE through the cache; false if the rule is invalid
+    bool compileRRule(const String& rrule, CompiledRRule& compiled);
 
     // Parsing state
-    enum ParseState { LOOKING_FOR_CALENDAR, IN_HEADER, IN_EVENT, DONE };
+    enum ParseState { LOOKING_FOR_CALENDAR, IN_HEADER, IN_TIMEZONE, IN_EVENT, DONE };
+
+    // Largest VEVENT block kept in memory; bigger events are skipped
+    static const size_t MAX_EVENT_BUFFER_SIZE = 8192;
+
+    // VTIMEZONE blocks kept per calendar; further ones fall back to the static map
+    static const size_t MAX_CALENDAR_ZONES = 8;
+
+    // Recurring masters held back until the end of a stream that had no
+    // override pre-pass, so overrides that follow them are indexed before
+    // expansion. Past the limit the oldest master is expanded early and an
+    // override listed after it is not applied (counted in earlyExpansions).
+    // Files and spooled bodies are pre-indexed and never hit the limit.
+    static const size_t MAX_PENDING_MASTERS = 32;
+
+    // Overrides of the next streamParseFromStream() call are already indexed
+    bool overridesIndexed;
+
+    // Read a body once for its RECURRENCE-IDs, so that masters can be
+    // expanded as soon as they are parsed; the caller rewinds the body
+    void indexOverrides(Stream* body);
+
+    // Expand a recurring master, pass in-range occurrences to the callback and
+    // delete the master; returns the number of occurrences delivered
+    int emitRecurringEvent(CalendarEvent* event, const EventCallback& callback, time_t startDate, time_t endDate);
+
+    // Parse an EXDATE property (comma list, optional TZID) into instance times
+    void parseExdateProperty(const IcsProperty& property, String& raw, std::vector<time_t>& times);
+
+    // Compile a VTIMEZONE into the calendar zone table
+    bool addCalendarZone(const String& tzid, const String& posix);
+
+    // Empty the calendar zone table; a partial body starts with the zones
+    // of the feed it continues, as its own bytes do not define them
+    void resetCalendarZones();
+
+    // Resolve a TZID: calendar VTIMEZONEs first, then the static IANA map
+    const CompiledTimeZone* resolveZone(const String& tzid);
 
     // Check if event is within date range
     bool isEventInRange(CalendarEvent* event, time_t startDate, time_t endDate);
 
-    // Parse a line from stream
-    String readLineFromStream(Stream* stream, bool& eof);
-
     // Extract value from property line
     String extractValue(const String& line, const String& property);
 
-    // Extract value from event buffer
-    String extractValueFromBuffer(const String& buffer, const String& property);
-
     // Parse date/time string to Unix timestamp
     time_t parseDateTime(const String& dtString);
 
@@ -2,6 +2,9 @@
 #define CALENDAR_WRAPPER_H
 
 #include "calendar_stream_parser.h"
+#include "connection_pool.h"
+#include "fetch_scheduler.h"
+#include "fetch_telemetry.h"
 #include "littlefs_config.h"
 #include <Arduino.h>
 #include <vector>
@@ -35,6 +38,47 @@ class CalendarWrapper {
     bool loaded;           ///< True if calendar has been loaded
     bool debug;            ///< Enable debug output
 
+    unsigned long lastLoadMs;    ///< Time spent by the last load() (download and parse)
+    size_t lastBytesTransferred; ///< Calendar bytes downloaded by the last load()
+    bool lastNotModified;        ///< Last load() reused the cache after a 304 Not Modified
+    unsigned long lastRadioMs;   ///< Time the last load() needed the network
+    unsigned long lastParseMs;   ///< Time the last load() spent parsing the calendar body
+    FetchTimings lastTimings;    ///< Network timings of the last load(), retries of all attempts included
+    bool lastSpooled;            ///< Last load() went through the spool file
+
+    /// State a load() carries from download() to parseSpooled()
+    struct PendingLoad {
+        time_t now              = 0; ///< Start of the requested range
+        time_t parseEndDate     = 0; ///< End of the range the body is parsed for
+        time_t tailCoveredUntil = 0; ///< Range covered by the cache a partial body appends to
+        std::vector<CalendarEvent*> previousEvents; ///< Cached events a partial body appends to
+        bool spooled = false;        ///< The body waits in the spool file
+    } pending;
+
+    /**
+     * @brief Keep the events of a successful download and save the binary cache
+     * @param result Parsed download (deleted here)
+     * @return true
+     */
+    bool storeResult(FilteredEvents* result);
+
+    /**
+     * @brief Fall back to the binary cache after a failed download
+     *
+     * Only the cached events in the range the download was for are loaded.
+     *
+     * @param reason Error recorded if the cache can be used
+     * @param startDate Start of the range the download was for
+     * @param endDate End of the range the download was for
+     * @return true if cached events were loaded
+     */
+    bool loadStaleCache(const String& reason, time_t startDate, time_t endDate);
+
+    /**
+     * @brief Drop the state of a download that will not be parsed
+     */
+    void clearPending();
+
     /**
      * @brief Calculate binary cache filename for this calendar based on URL hash
      *
@@ -85,6 +129,12 @@ class CalendarWrapper {
         parser.setDebug(enable);
     }
 
+    /**
+     * @brief Borrow keep-alive connections from a pool for the next load() calls
+     * @param pool Connection pool shared with other calendars (nullptr = own connection per load)
+     */
+    void setConnectionPool(ConnectionPool* pool) { parser.setConnectionPool(pool); }
+
     // Get configuration properties
     /** @brief Get calendar name */
     const String& getName() const { return config.name; }
@@ -101,9 +151,13 @@ class CalendarWrapper {
      * @brief Load calendar data from network with binary event caching
      *
      * Loading strategy:
-     * 1. If !forceRefresh and binary cache valid: Load from binary cache (fast)
-     * 2. Stream parse from HTTP (no ICS file cache - handles any file size)
-     * 3. Save parsed events to binary cache for future use
+     * 1. If !forceRefresh and the binary cache covers the date range: send a
+     *    conditional request with the saved ETag / Last-Modified; on 304 Not
+     *    Modified, load the binary cache and skip download and parsing
+     * 2. Stream parse from HTTP (no ICS file cache - handles any file size);
+     *    for incremental calendars, only the bytes appended after the saved
+     *    feed tail are requested and their events merged into the cache
+     * 3. Save parsed events and response validators to binary cache for future use
      * 4. If network fails: Fall back to stale binary cache (graceful degradation)
      *
      * This approach:
@@ -112,11 +166,40 @@ class CalendarWrapper {
      * - Provides offline fallback when network fails
      * - Sets isStale flag to indicate cache vs fresh data
      *
+     * Large bodies are spooled to flash and parsed once the download is
+     * done (see download() and parseSpooled()).
+     *
      * @param forceRefresh If true, bypass cache and fetch fresh data
      * @return true if calendar was successfully loaded (fresh or stale)
      */
     bool load(bool forceRefresh = false);
 
+    /**
+     * @brief Network half of load()
+     *
+     * Does everything load() does, except that a body of at least
+     * CALENDAR_SPOOL_MIN_BYTES is only written to the spool file: the
+     * calendar is then not loaded until parseSpooled() is called, which
+     * needs no network.
+     *
+     * @param forceRefresh If true, bypass cache and fetch fresh data
+     * @return true if the calendar was loaded or its body spooled
+     */
+    bool download(bool forceRefresh = false);
+
+    /**
+     * @brief Parse the body spooled by download()
+     *
+     * Falls back to the stale binary cache if the spooled body cannot be
+     * parsed. Does nothing if nothing was spooled.
+     *
+     * @return true if the calendar is loaded (fresh or stale)
+     */
+    bool parseSpooled();
+
+    /** @brief Check if download() left a body in the spool file for parseSpooled() */
+    bool hasSpooledBody() const { return pending.spooled; }
+
     /**
      * @brief Get events within specific date range
      *
@@ -149,6 +232,21 @@ class CalendarWrapper {
     size_t getEventCountInRange(time_t startDate, time_t endDate) const;
     /** @brief Get last error message if loading failed */
     String getLastError() const { return lastError; }
+    /** @brief Time spent by the last load() in milliseconds (download and parse) */
+    unsigned long getLastLoadMs() const { return lastLoadMs; }
+    /** @brief Time the last load() needed the network (includes parsing unless spooled) */
+    unsigned long getLastRadioMs() const { return lastRadioMs; }
+    /** @brief Time the last load() spent parsing the calendar body */
+    unsigned long getLastParseMs() const { return lastParseMs; }
+    /** @brief Calendar bytes downloaded by the last load() (0 after a 304) */
+    size_t getLastBytesTransferred() const { return lastBytesTransferred; }
+    /** @brief Check if the last load() reused the cache after a 304 Not Modified */
+    bool wasNotModified() const { return lastNotModified; }
+    /**
+     * @brief Telemetry record of the last load() (wake number not set)
+     * @return Timings, bytes, parse figures and outcome of the last load()
+     */
+    FetchTelemetryRecord getLastTelemetry() const;
 
     /**
      * @brief Clear cached events from memory
@@ -176,6 +274,8 @@ class CalendarWrapper {
 class CalendarManager {
   private:
     std::vector<CalendarWrapper*> calendars; ///< Collection of calendar wrappers
+    std::vector<bool> loadResults;           ///< Outcome of each calendar's last load
+    FetchTelemetry* telemetry;               ///< Receives one record per calendar load (not owned)
     bool debug;                              ///< Enable debug output
 
   public:
@@ -195,6 +295,12 @@ class CalendarManager {
      */
     void setDebug(bool enable) { debug = enable; }
 
+    /**
+     * @brief Record the outcome of every enabled calendar's load
+     * @param fetchTelemetry Ring buffer of the current wake (nullptr = no telemetry)
+     */
+    void setTelemetry(FetchTelemetry* fetchTelemetry) { telemetry = fetchTelemetry; }
+
     /**
      * @brief Load calendar configurations from RuntimeConfig
      *
@@ -216,11 +322,47 @@ class CalendarManager {
      *
      * Iterates through all calendars and loads their event data.
      * Each calendar loads independently - failures are tracked per calendar.
+     * With a scheduler, every calendar is queued as a job and the scheduler
+     * is run, together with the jobs already queued on it (e.g. weather);
+     * this returns once all of them have finished. Same as downloadAll()
+     * followed by parseSpooled().
      *
      * @param forceRefresh If true, bypass cache and fetch fresh data for all calendars
+     * @param scheduler Run the calendars concurrently on this scheduler (nullptr = one by one)
+     * @param pool Share keep-alive connections between calendars on the same host (nullptr = none)
      * @return true if at least one calendar loaded successfully
      */
-    bool loadAll(bool forceRefresh = false);
+    bool loadAll(bool forceRefresh = false, FetchScheduler* scheduler = nullptr,
+                 ConnectionPool* pool = nullptr);
+
+    /**
+     * @brief Network half of loadAll()
+     *
+     * Downloads every calendar like loadAll(), but large bodies are only
+     * spooled to flash. Call parseSpooled() afterwards; the network can be
+     * shut down in between.
+     *
+     * @param forceRefresh If true, bypass cache and fetch fresh data for all calendars
+     * @param scheduler Run the calendars concurrently on this scheduler (nullptr = one by one)
+     * @param pool Share keep-alive connections between calendars on the same host (nullptr = none)
+     */
+    void downloadAll(bool forceRefresh = false, FetchScheduler* scheduler = nullptr,
+                     ConnectionPool* pool = nullptr);
+
+    /**
+     * @brief Check if downloadAll() spooled any body that still has to be parsed
+     */
+    bool hasSpooledBodies() const;
+
+    /**
+     * @brief Parse the bodies spooled by downloadAll() and report the outcome
+     *
+     * This is where every calendar's load is complete, so the telemetry
+     * records (see setTelemetry()) are added here.
+     *
+     * @return true if every calendar loaded successfully (same as loadAll())
+     */
+    bool parseSpooled();
 
     /**
      * @brief Get merged events from all enabled calendars within date range
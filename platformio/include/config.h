@@ -348,13 +348,62 @@
 
 // Binary event cache settings
 #define EVENT_CACHE_MAGIC 0xCAFEEE00 // Magic number for cache file validation
-#define EVENT_CACHE_VERSION 2 // Cache format version (v2: removed startTimeStr/endTimeStr)
-#define EVENT_CACHE_MAX_EVENTS 200 // Maximum events per cache file
+#define EVENT_CACHE_VERSION 6 // Cache format version (v6: records also keep the UID and RECURRENCE-ID)
+#define EVENT_CACHE_PREVIOUS_VERSION 5 // v5 (records sorted by start time, with a block index and a generation) is still read
+#define EVENT_CACHE_LEGACY_VERSION 2 // Older format still read, so the first wake after an update keeps its cache
+#define EVENT_CACHE_MAX_EVENTS 1000 // Maximum events per cache file
+#define EVENT_CACHE_INDEX_BLOCK 16 // Records per index entry: a query decodes whole blocks from the first one in range
+#define EVENT_CACHE_IO_BUFFER 128 // Bytes read from or written to flash at a time by EventCache
+#define EVENT_CACHE_STRING_SLOTS 128 // Strings EventCache::save() remembers to store repeated ones once (power of two)
 #define EVENT_CACHE_VALIDITY_SECONDS 86400 // Cache validity: 24 hours
 
 // Calendar fetch retry configuration
 #define CALENDAR_FETCH_MAX_RETRIES 3 // Maximum retry attempts before using cache
 #define CALENDAR_FETCH_RETRY_DELAY_MS 2000 // Delay between retries (2 seconds)
+#define CALENDAR_STREAM_READ_TIMEOUT_MS 10000 // Longest wait for more of a calendar body before it counts as ended
+
+// Conditional fetch (ETag / Last-Modified) configuration
+// Events are parsed this far past days_to_fetch so that a 304 Not Modified
+// can keep reusing the cached events on later wakes
+#define CALENDAR_REVALIDATE_SLACK_SECONDS 86400 // 1 day
+
+// Incremental download of append-only feeds (calendars with "incremental": true)
+#define FEED_TAIL_ANCHOR_BYTES 64 // Bytes before the last END:VEVENT sent again and compared by CRC32
+#define CALENDAR_INCREMENTAL_SLACK_SECONDS (7 * 86400) // Parsed past days_to_fetch by a full fetch, so later wakes can append
+
+// Spooling of large calendar bodies to flash (parsed after the radio is off)
+#define CALENDAR_SPOOL_MIN_BYTES 32768 // Bodies this large (or of unknown length) are spooled instead of parsed as they arrive
+#define CALENDAR_SPOOL_WRITE_BYTES 4096 // Size of each sequential write to the spool file
+
+// Parallel fetch configuration (weather and calendars run as concurrent tasks)
+#define FETCH_MAX_CONCURRENT 2 // Simultaneous downloads (each TLS session needs ~40KB of heap)
+#define FETCH_TASK_STACK_SIZE 12288 // Stack of each fetch worker task (bytes)
+#define FETCH_TASK_PRIORITY 1 // FreeRTOS priority of the fetch worker tasks
+
+// Keep-alive connection pool (one per wake, shared by all calendars)
+#define HTTP_POOL_MAX_IDLE FETCH_MAX_CONCURRENT // Open connections kept between requests
+#define HTTP_POOL_DRAIN_LIMIT 16384 // Unread body bytes discarded to keep a connection reusable
+#define HTTP_MAX_REDIRECTS 5 // Redirects followed by a pooled request
+
+// TLS session resumption across deep sleep (session tickets/IDs kept per host)
+#define TLS_SESSION_CACHE_ENTRIES 4 // Hosts remembered (calendar hosts plus the weather API)
+#define TLS_SESSION_MAX_BYTES 4096 // Largest serialized session kept (includes the server certificate)
+#define TLS_SESSION_MAX_AGE_SECONDS 172800 // Sessions older than 2 days are dropped
+#define TLS_SESSION_RTC_BYTES 4096 // RTC slow memory holding the sessions during deep sleep
+#define TLS_SESSION_FILE "/tls_sessions.bin" // LittleFS copy, used when RTC memory was lost
+#define TLS_SESSION_FLUSH_WAKES 4 // Changed sessions reach the LittleFS copy after this many wakes
+#define TLS_SESSION_MAGIC 0x544C5353 // "TLSS"
+#define TLS_SESSION_VERSION 1
+
+// Per-source fetch telemetry (kept in RTC memory across deep sleep)
+#define FETCH_TELEMETRY_WAKES 8 // Wakes kept; older records are dropped
+#define FETCH_TELEMETRY_RECORDS (FETCH_TELEMETRY_WAKES * MAX_CALENDARS) // Ring buffer capacity
+#define FETCH_TELEMETRY_SOURCE_BYTES 16 // Source name stored per record (truncated, NUL included)
+#define FETCH_TELEMETRY_RTC_BYTES 1536 // RTC slow memory holding the records during deep sleep
+#define FETCH_TELEMETRY_FLUSH_WAKES 4 // The LittleFS copy is rewritten every this many wakes
+#define FETCH_TELEMETRY_FILE "/fetch_telemetry.bin" // LittleFS copy, used when RTC memory was lost
+#define FETCH_TELEMETRY_MAGIC 0x46544C4D // "FTLM"
+#define FETCH_TELEMETRY_VERSION 1
 
 // =============================================================================
 // WEATHER CONFIGURATION
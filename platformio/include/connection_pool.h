@@ -0,0 +1,124 @@
+/**
+ * Per-wake pool of keep-alive HTTP(S) connections
+ *
+ * Calendars served from the same origin (e.g. several Google calendars on
+ * calendar.google.com) share one TCP+TLS session instead of paying a full
+ * handshake each. A fetcher acquires a connection for a URL, sends its
+ * request over it with HTTP/1.1 keep-alive, and releases it once the
+ * response body has been read to the end; the next request to the same
+ * scheme+host+port reuses it. A connection is only ever lent to one fetcher
+ * at a time, so concurrent fetch workers to the same host each get their
+ * own. The pool lives for one wake cycle: all connections are closed before
+ * deep sleep.
+ */
+
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+#endif
+
+#include <mutex>
+#include <vector>
+
+#include "config.h"
+#include "tls_session_cache.h"
+
+/**
+ * One pooled connection, lent out by ConnectionPool::acquire()
+ */
+struct PooledConnection {
+    String origin;      // "scheme://host:port" the connection was opened to
+    WiFiClient* client; // WiFiClientSecure for https
+    HTTPClient* http;   // Request state bound to client for its whole lifetime
+    bool inUse;
+    size_t requests;    // Requests sent over this connection
+
+    // Time opening the connection took; DNS and TLS are only split out
+    // by ResumableTlsClient, otherwise connectMs covers all of it
+    unsigned long dnsMs;
+    unsigned long connectMs;
+    unsigned long tlsMs;
+
+    PooledConnection()
+        : client(nullptr), http(nullptr), inUse(false), requests(0), dnsMs(0), connectMs(0), tlsMs(0) {}
+};
+
+class ConnectionPool {
+  public:
+    /**
+     * @param maxIdle Connections kept open between requests; more are closed on release
+     */
+    explicit ConnectionPool(size_t maxIdle = HTTP_POOL_MAX_IDLE);
+    ~ConnectionPool();
+
+    /**
+     * @brief Resume TLS sessions from (and save them to) a session cache
+     *
+     * New https connections then use ResumableTlsClient. Set before the
+     * first acquire(); nullptr (the default) keeps plain WiFiClientSecure.
+     */
+    void setSessionCache(TlsSessionCache* cache) { sessionCache = cache; }
+
+    /**
+     * @brief Borrow a connection to the origin of url
+     *
+     * Reuses an idle, still connected connection to the same origin, or
+     * opens (and handshakes) a new one.
+     *
+     * @return Connected connection, or nullptr if the URL is not http(s) or connecting failed
+     */
+    PooledConnection* acquire(const String& url);
+
+    /**
+     * @brief Return a borrowed connection
+     *
+     * @param reusable The response was read completely and the server allows
+     *                 keep-alive; otherwise the connection is closed
+     */
+    void release(PooledConnection* connection, bool reusable);
+
+    /** @brief Close every idle connection (borrowed ones close on release) */
+    void closeAll();
+
+    /**
+     * @brief Split an http(s) URL into its origin key, host and port
+     *
+     * @return false if the URL is not http:// or https://
+     */
+    static bool parseOrigin(const String& url, String& origin, String& host, uint16_t& port, bool& secure);
+
+    // Statistics since construction
+    /** @brief New connections opened (TCP connect plus TLS handshake for https) */
+    size_t getHandshakeCount() const { return handshakeCount; }
+    /** @brief Total time spent opening connections in milliseconds */
+    unsigned long getHandshakeMs() const { return handshakeMs; }
+    /** @brief Requests that were sent over an already open connection */
+    size_t getReuseCount() const { return reuseCount; }
+    /** @brief Connection attempts that failed */
+    size_t getFailedCount() const { return failedCount; }
+    /** @brief Connections currently open (idle or borrowed) */
+    size_t getOpenCount() const;
+
+  private:
+    // Close and forget a connection; caller holds the mutex
+    void destroy(size_t index);
+
+    size_t maxIdle;
+    TlsSessionCache* sessionCache;
+    std::vector<PooledConnection*> connections;
+    mutable std::mutex mutex;
+
+    size_t handshakeCount;
+    unsigned long handshakeMs;
+    size_t reuseCount;
+    size_t failedCount;
+};
+
+#endif // CONNECTION_POOL_H
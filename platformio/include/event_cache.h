@@ -11,6 +11,8 @@
 
 #include "calendar_event.h"
 #include "config.h"
+#include "feed_tail.h"
+#include "http_validators.h"
 #include <vector>
 
 /**
@@ -19,15 +21,27 @@
  * EventCache provides efficient binary serialization and deserialization of
  * CalendarEvent objects to/from LittleFS. This approach:
  * - Stores only processed events (not raw ICS files)
- * - Uses compact binary format (~200 bytes per event)
+ * - Uses compact variable-length records (~20 bytes per event plus its unique strings)
  * - Enables offline fallback when network fails
  * - Handles unlimited source file sizes via stream parsing
  *
- * Cache file format:
- * - Header: Magic number, version, metadata, checksum
- * - Body: Array of serialized events
+ * Cache file format (v6):
+ * - Header: Magic number, version, counts, timestamp, generation, checksum, then the calendar URL
+ * - Block index: first start time, latest end time so far and record offset
+ *   of every EVENT_CACHE_INDEX_BLOCK records
+ * - String table: offset of every string, then the strings as varint
+ *   length + UTF-8 bytes; repeated strings are stored once
+ * - Records, sorted by start time: varint start time delta within the block,
+ *   varint duration, flags, day of month, then varint string table indices
+ *   (title, summary, location, date, calendar name and color, UID, RECURRENCE-ID)
  *
- * Typical usage: 3 calendars × 50 events = ~30KB total storage
+ * The checksum covers everything after the URL. Files are written and read
+ * in EVENT_CACHE_IO_BUFFER-byte chunks, never whole. query() uses the index
+ * to decode only the records of a date range.
+ * v5 files (the same without UID and RECURRENCE-ID) and v2 files (fixed
+ * 402-byte records) are still loaded, and rewritten as v6 on the next save.
+ *
+ * Typical usage: 3 calendars × 50 events = ~6KB total storage
  */
 class EventCache {
   public:
@@ -37,6 +51,16 @@ class EventCache {
      * Serializes the event vector to a compact binary format with header
      * validation and checksum. Creates parent directories if needed.
      *
+     * The events go to the temp file (getTempPath()), which is renamed over
+     * the cache once complete, so a reset halfway keeps the previous cache;
+     * recover() sorts out what such a reset leaves behind. The file is
+     * written EVENT_CACHE_IO_BUFFER bytes at a time while the checksum is
+     * updated, and the header is written last, over a zeroed one.
+     * Besides that buffer, only the EVENT_CACHE_STRING_SLOTS strings used
+     * to spot repeats are allocated, whatever the number of events; events
+     * not already sorted by start time also take a sorted copy of the
+     * pointers.
+     *
      * @param cachePath Full path to cache file (e.g., "/cache/events_abc123.bin")
      * @param events Vector of CalendarEvent pointers to serialize
      * @param calendarUrl Original calendar URL for validation
@@ -51,6 +75,8 @@ class EventCache {
      *
      * Deserializes events from binary cache. Validates header magic number,
      * version compatibility, and checksum. Returns empty vector on any error.
+     * The file is read in chunks, so beyond the events returned only a
+     * small fixed buffer is allocated.
      *
      * @param cachePath Full path to cache file
      * @param calendarUrl Expected calendar URL (for validation)
@@ -58,6 +84,30 @@ class EventCache {
      */
     static std::vector<CalendarEvent*> load(const String& cachePath, const String& calendarUrl);
 
+    /**
+     * @brief Load only the cached events that overlap a date range
+     *
+     * Binary-searches the block index and decodes the records from the
+     * first block that can reach startDate up to the first event starting
+     * after endDate, reading the file EVENT_CACHE_IO_BUFFER bytes at a
+     * time. Memory use depends on the number of events returned, not on
+     * the size of the cache. The checksum is still verified, in chunks.
+     *
+     * An event overlaps the range if it starts at or before endDate and
+     * ends at or after startDate (an end time of 0 counts as the start
+     * time), the same test as CalendarWrapper::getEvents().
+     *
+     * @param cachePath Full path to cache file
+     * @param startDate Start of the range (Unix epoch)
+     * @param endDate End of the range (Unix epoch, inclusive)
+     * @param limit Maximum events returned, earliest first (0 = no limit)
+     * @return Vector of CalendarEvent pointers sorted by start time (caller must delete), empty on failure
+     */
+    static std::vector<CalendarEvent*> query(const String& cachePath,
+                                             time_t startDate,
+                                             time_t endDate,
+                                             size_t limit = 0);
+
     /**
      * @brief Check if cache file is valid and not expired
      *
@@ -70,10 +120,96 @@ class EventCache {
      */
     static bool isValid(const String& cachePath, time_t maxAge = EVENT_CACHE_VALIDITY_SECONDS);
 
+    /**
+     * @brief Save the HTTP validators of the feed a cache was built from
+     *
+     * Written to a small text sidecar next to the cache file (see
+     * getValidatorsPath()) so the next fetch can be conditional.
+     *
+     * @param cachePath Full path to the event cache file
+     * @param validators ETag / Last-Modified of the response the cache was built from
+     * @param coveredUntil End of the date range the cached events were parsed for
+     * @return true if save succeeded
+     */
+    static bool saveValidators(const String& cachePath,
+                               const HttpValidators& validators,
+                               time_t coveredUntil);
+
+    /**
+     * @brief Load the HTTP validators saved for a cache file
+     *
+     * @param cachePath Full path to the event cache file
+     * @param validators Output: saved ETag / Last-Modified
+     * @param coveredUntil Output: end of the date range covered by the cache
+     * @return false if there is no sidecar or it holds no validator
+     */
+    static bool loadValidators(const String& cachePath,
+                               HttpValidators& validators,
+                               time_t& coveredUntil);
+
+    /**
+     * @brief Path of the validators sidecar ("/cache/events_abc123.etag")
+     */
+    static String getValidatorsPath(const String& cachePath);
+
+    /**
+     * @brief Save where an incrementally downloaded feed can be resumed
+     *
+     * Written to a text sidecar (see getFeedTailPath()) for calendars in
+     * incremental mode; an invalid tail removes the sidecar.
+     *
+     * @param cachePath Full path to the event cache file
+     * @param tail End of the last VEVENT of the feed the cache was built from
+     * @param coveredUntil End of the date range the cached events were parsed for
+     * @return true if save succeeded
+     */
+    static bool saveFeedTail(const String& cachePath, const FeedTail& tail, time_t coveredUntil);
+
+    /**
+     * @brief Load the feed tail saved for a cache file
+     *
+     * @param cachePath Full path to the event cache file
+     * @param tail Output: saved resume point
+     * @param coveredUntil Output: end of the date range covered by the cache
+     * @return false if there is no sidecar or it holds no valid tail
+     */
+    static bool loadFeedTail(const String& cachePath, FeedTail& tail, time_t& coveredUntil);
+
+    /**
+     * @brief Path of the feed tail sidecar ("/cache/events_abc123.tail")
+     */
+    static String getFeedTailPath(const String& cachePath);
+
+    /**
+     * @brief Path of the raw calendar body spooled before parsing ("/cache/events_abc123.ics")
+     */
+    static String getSpoolPath(const String& cachePath);
+
+    /**
+     * @brief Path a save is written to before it replaces the cache ("/cache/events_abc123.tmp")
+     */
+    static String getTempPath(const String& cachePath);
+
+    /**
+     * @brief Finish or undo a save cut short by a reset
+     *
+     * save() writes the temp file and renames it over the cache once it is
+     * complete. A reset in between leaves the temp file behind. It is
+     * renamed over the cache if it passes its checksum and is a newer
+     * generation than the cache (or the cache is missing or broken), and
+     * deleted otherwise. Only reads the files when a temp file exists; call
+     * it once per wake before using the cache.
+     *
+     * @param cachePath Full path to cache file
+     * @return true if the temp file became the cache
+     */
+    static bool recover(const String& cachePath);
+
     /**
      * @brief Delete cache file
      *
-     * Removes the cache file from LittleFS. Safe to call even if file doesn't exist.
+     * Removes the cache file, its temp file and its sidecars from LittleFS. Safe
+     * to call even if the files don't exist.
      *
      * @param cachePath Full path to cache file
      * @return true if file was deleted or didn't exist
@@ -88,16 +224,93 @@ class EventCache {
      */
     static size_t getSize(const String& cachePath);
 
+    /**
+     * @brief Calculate CRC32 checksum of data
+     *
+     * Data can be checksummed in pieces by passing the CRC of the
+     * preceding bytes as crc. The standard CRC-32 (as zlib's crc32()),
+     * computed by the ESP32 ROM routine on the device and by crc32Sliced()
+     * in native builds; all of them give the same values.
+     *
+     * @param data Pointer to data buffer
+     * @param length Data length in bytes
+     * @param crc CRC32 of the data before this piece (0 to start)
+     * @return CRC32 checksum value
+     */
+    static uint32_t calculateCRC32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+    /** @brief calculateCRC32() one byte at a time through a 256-entry table (the reference) */
+    static uint32_t crc32Bytewise(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+    /** @brief calculateCRC32() eight bytes at a time through 8 KB of tables (slicing-by-8) */
+    static uint32_t crc32Sliced(const uint8_t* data, size_t length, uint32_t crc = 0);
+
   private:
     // Cache file format constants (defined in config.h)
     static const uint32_t CACHE_MAGIC   = EVENT_CACHE_MAGIC;   ///< Magic number for file validation
     static const uint32_t CACHE_VERSION = EVENT_CACHE_VERSION; ///< Cache format version
+    static const uint32_t PREVIOUS_VERSION = EVENT_CACHE_PREVIOUS_VERSION; ///< Same layout, fewer strings per record
+    static const uint32_t LEGACY_VERSION = EVENT_CACHE_LEGACY_VERSION; ///< Older version still loaded
     static const size_t MAX_EVENTS = EVENT_CACHE_MAX_EVENTS;   ///< Safety limit on events per cache
 
+    // Longest strings kept, in bytes (the v2 field sizes less their terminator; v2 had no UID)
+    static const size_t MAX_TITLE_LENGTH         = 127;
+    static const size_t MAX_LOCATION_LENGTH      = 63;
+    static const size_t MAX_DATE_LENGTH          = 15;
+    static const size_t MAX_NAME_LENGTH          = 31;
+    static const size_t MAX_COLOR_LENGTH         = 15;
+    static const size_t MAX_URL_LENGTH           = 255;
+    static const size_t MAX_UID_LENGTH           = 255;
+    static const size_t MAX_RECURRENCE_ID_LENGTH = 31;
+
+    static const size_t BLOCK_SIZE = EVENT_CACHE_INDEX_BLOCK; ///< Records per index entry
+
     /**
-     * @brief Binary cache file header structure
+     * @brief Binary cache file header structure (v5 and v6)
+     *
+     * Followed by urlLength bytes of calendar URL, then payloadLength bytes
+     * of block index, string table and records.
      */
     struct __attribute__((packed)) CacheHeader {
+        uint32_t magic;         ///< Magic number (0xCAFEEVNT)
+        uint32_t version;       ///< Cache format version
+        uint32_t eventCount;    ///< Number of events in cache
+        uint32_t stringCount;   ///< Entries in the string table
+        uint32_t stringBytes;   ///< Bytes of string data (after the string offsets)
+        uint16_t blockSize;     ///< Records per index entry
+        uint16_t urlLength;     ///< Calendar URL bytes after the header
+        int64_t timestamp;      ///< Cache creation timestamp (Unix epoch)
+        uint32_t generation;    ///< One more than the file it replaced (see recover())
+        uint32_t payloadLength; ///< Index, string table and records
+        uint32_t checksum;      ///< CRC32 of the payload
+    };
+
+    /**
+     * @brief Block index entry, one per blockSize records
+     */
+    struct __attribute__((packed)) IndexEntry {
+        int64_t firstStart; ///< Start time of the block's first record
+        int64_t maxEnd;     ///< Latest end time of this and all earlier blocks
+        uint32_t offset;    ///< Offset of the block's first record from the first record
+    };
+
+    /**
+     * @brief Where the sections of a v5 payload start, in bytes from its start
+     */
+    struct PayloadLayout {
+        size_t blockCount;
+        size_t offsetsStart;
+        size_t stringsStart;
+        size_t recordsStart;
+
+        /** @return false if the sections do not fit in the payload */
+        bool compute(const CacheHeader& header);
+    };
+
+    /**
+     * @brief v2 file header, read when migrating an older cache
+     */
+    struct __attribute__((packed)) CacheHeaderV2 {
         uint32_t magic;        ///< Magic number (0xCAFEEVNT)
         uint32_t version;      ///< Cache format version
         uint32_t eventCount;   ///< Number of events in cache
@@ -107,10 +320,10 @@ class EventCache {
     };
 
     /**
-     * @brief Serialized event structure (fixed-size binary format)
+     * @brief v2 serialized event structure (fixed-size binary format)
      * Note: startTimeStr and endTimeStr removed in v2 (computed on-demand from timestamps)
      */
-    struct __attribute__((packed)) SerializedEvent {
+    struct __attribute__((packed)) SerializedEventV2 {
         char title[128];        ///< Event title/summary
         char location[64];      ///< Event location
         char date[16];          ///< Date in YYYY-MM-DD format
@@ -123,7 +336,7 @@ class EventCache {
         char summary[128];      ///< Alternative summary field
     };
 
-    // Bit flags for SerializedEvent.flags
+    // Bit flags for the record flags byte (same in v2 and v5)
     static const uint8_t FLAG_ALL_DAY      = 0x01;
     static const uint8_t FLAG_IS_TODAY     = 0x02;
     static const uint8_t FLAG_IS_TOMORROW  = 0x04;
@@ -131,29 +344,79 @@ class EventCache {
     static const uint8_t FLAG_IS_HOLIDAY   = 0x10;
 
     /**
-     * @brief Calculate CRC32 checksum of data
+     * @brief Read the header of a v5 or v2 cache file
      *
-     * @param data Pointer to data buffer
-     * @param length Data length in bytes
-     * @return CRC32 checksum value
+     * A v2 header is converted: its events are the payload and it has no
+     * string table. The file is left at the start of the payload.
+     *
+     * @param file Cache file opened for reading
+     * @param header Output header
+     * @param calendarUrl Output: URL the cache was built from
+     * @return false if the file is too short or not an event cache
+     */
+    static bool readHeader(File& file, CacheHeader& header, String& calendarUrl);
+
+    /**
+     * @brief Decode the v5 records overlapping a date range
+     *
+     * @param file Cache file positioned at the start of a checked payload
+     * @param events Output: events in start time order, empty if the payload is malformed
+     * @return false if the payload is malformed
+     */
+    static bool readEvents(File& file,
+                           const CacheHeader& header,
+                           int64_t startDate,
+                           int64_t endDate,
+                           size_t limit,
+                           std::vector<CalendarEvent*>& events);
+
+    /**
+     * @brief Decode the records of a v2 payload one at a time, checking the checksum
+     *
+     * @param file Cache file positioned at the start of the payload
+     * @param events Output, empty if the checksum does not match
+     * @return false if the payload is short or fails its checksum
+     */
+    static bool loadLegacy(File& file, const CacheHeader& header, std::vector<CalendarEvent*>& events);
+
+    /**
+     * @brief Check a whole cache file, payload length and checksum included
+     *
+     * @param generation Output: generation in its header (0 for v2 files)
      */
-    static uint32_t calculateCRC32(const uint8_t* data, size_t length);
+    static bool checkFile(const String& path, uint32_t& generation);
+
+    /** @brief Generation in the header of a cache file, 0 if it has none */
+    static uint32_t readGeneration(const String& path);
+
+    /**
+     * @brief Check the payload checksum, reading the file in small chunks
+     *
+     * @param file Cache file positioned at the start of the payload
+     */
+    static bool verifyChecksum(File& file, const CacheHeader& header);
+
+    /** @brief Record flags byte of an event */
+    static uint8_t packFlags(const CalendarEvent* event);
 
     /**
-     * @brief Serialize a CalendarEvent to binary format
+     * @brief Build an event from a decoded record
      *
-     * @param event Source CalendarEvent
-     * @param serialized Output SerializedEvent structure
+     * @param strings Title, summary, location, date, calendar name and color
      */
-    static void serializeEvent(const CalendarEvent* event, SerializedEvent& serialized);
+    static CalendarEvent* buildEvent(int64_t startTime,
+                                     int64_t endTime,
+                                     uint8_t flags,
+                                     uint8_t dayOfMonth,
+                                     const String* const* strings);
 
     /**
-     * @brief Deserialize binary data to CalendarEvent
+     * @brief Deserialize v2 binary data to CalendarEvent
      *
-     * @param serialized Input SerializedEvent structure
+     * @param serialized Input SerializedEventV2 structure
      * @return New CalendarEvent pointer (caller must delete)
      */
-    static CalendarEvent* deserializeEvent(const SerializedEvent& serialized);
+    static CalendarEvent* deserializeEventV2(const SerializedEventV2& serialized);
 
     /**
      * @brief Ensure cache directory exists
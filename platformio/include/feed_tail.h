@@ -0,0 +1,119 @@
+/**
+ * Resume point for incremental downloads of append-only calendar feeds
+ *
+ * Some feeds (e.g. exports of booking systems) only ever gain VEVENTs,
+ * inserted just before END:VCALENDAR. For those, a FeedTail records where
+ * the last complete VEVENT ended in the previous download, together with a
+ * CRC32 of the bytes just before that point (the anchor). The next request
+ * asks for "Range: bytes=<offset - anchor>-": if the server answers 206 and
+ * the anchor bytes still match, the feed was only appended to and just the
+ * new VEVENTs are downloaded and parsed. Any other answer (200, 416, a
+ * different anchor or a shorter feed) means a full download. The VTIMEZONEs
+ * of the feed sit before the tail, so a FeedTail also keeps the POSIX rules
+ * they compiled to: appended events still refer to them by TZID.
+ *
+ * FeedTailStream is the stream adapter that records the tail while the
+ * parser reads a feed; for a partial response it also puts a
+ * BEGIN:VCALENDAR line in front of the new VEVENTs.
+ */
+
+#ifndef FEED_TAIL_H
+#define FEED_TAIL_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include "config.h"
+#include <vector>
+
+/** A VTIMEZONE of the feed, as the POSIX rule it compiled to */
+struct FeedZone {
+    String tzid;
+    String posix;
+};
+
+struct FeedTail {
+    size_t offset;      // Byte offset just past the last "END:VEVENT" line
+    uint32_t anchorCrc; // CRC32 of the FEED_TAIL_ANCHOR_BYTES bytes ending at offset
+    size_t length;      // Length of the feed when the tail was recorded
+    std::vector<FeedZone> zones; // VTIMEZONEs before offset (not downloaded again)
+
+    FeedTail() : offset(0), anchorCrc(0), length(0) {}
+
+    /** @brief A VEVENT ending far enough into the feed was recorded */
+    bool isValid() const { return offset >= FEED_TAIL_ANCHOR_BYTES && length >= offset; }
+
+    /** @brief First byte requested when resuming (the anchor is sent again) */
+    size_t rangeStart() const { return offset - FEED_TAIL_ANCHOR_BYTES; }
+
+    /** @brief Value of the Range request header that resumes after this tail */
+    String rangeHeader() const;
+
+    /**
+     * @brief Read the anchor from the start of a partial response and compare it
+     *
+     * @return true if the stream began with the same FEED_TAIL_ANCHOR_BYTES bytes
+     */
+    bool matchesAnchor(Stream* stream) const;
+
+    /**
+     * @brief Parse a "Content-Range: bytes first-last/total" response header
+     *
+     * @param total Set to 0 when the server sent "*" for an unknown length
+     * @return false if the header is missing or not a byte range
+     */
+    static bool parseContentRange(const String& header, size_t& first, size_t& total);
+};
+
+class FeedTailStream : public Stream {
+  public:
+    /**
+     * @param source      Decoded feed body
+     * @param startOffset Feed offset of the first byte of source (after the
+     *                    anchor for a partial response, 0 otherwise)
+     * @param prefix      Text delivered before source (not counted in offsets)
+     */
+    FeedTailStream(Stream* source, size_t startOffset = 0, const char* prefix = "");
+
+    // Stream interface
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    virtual void flush();
+    virtual size_t write(uint8_t);
+    virtual String readString();
+#ifdef NATIVE_TEST
+    virtual size_t readBytes(uint8_t* buffer, size_t length);
+#else
+    virtual size_t readBytes(char* buffer, size_t length);
+#endif
+
+    /**
+     * @brief Tail of everything read so far
+     *
+     * offset is 0 if no VEVENT ended in the bytes read; length is always set.
+     */
+    FeedTail getTail() const;
+
+  private:
+    // Track line boundaries and the anchor window for bytes taken from source
+    void track(const uint8_t* data, size_t length);
+
+    Stream* source;
+    const char* prefix;
+    size_t prefixRemaining;
+    size_t position; // Feed offset of the next byte from source
+
+    uint8_t window[FEED_TAIL_ANCHOR_BYTES]; // Last bytes read, as a ring
+    size_t windowFill;
+    char line[12]; // Start of the current line, enough to recognize END:VEVENT
+    size_t lineLength;
+
+    size_t lastEventEnd;
+    uint32_t lastAnchorCrc;
+};
+
+#endif // FEED_TAIL_H
@@ -0,0 +1,98 @@
+/**
+ * Concurrent runner for the network fetches of one wake cycle
+ *
+ * Each data source (weather, every calendar) is queued as a job. run()
+ * starts up to maxConcurrent worker tasks, spread over both cores of the
+ * ESP32-S3, which take jobs from the queue until it is empty, and returns
+ * once every job has finished. The radio is then busy for about as long as
+ * the slowest source instead of the sum of all of them, while the worker
+ * count bounds the number of simultaneous TLS sessions (and their heap).
+ * Native builds use std::thread workers so the scheduling can be tested on
+ * the host.
+ */
+
+#ifndef FETCH_SCHEDULER_H
+#define FETCH_SCHEDULER_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "config.h"
+
+/**
+ * Outcome of one job of the last run()
+ */
+struct FetchJobResult {
+    String name;
+    bool success;
+    unsigned long startMs;    // Start, relative to the beginning of run()
+    unsigned long durationMs; // Wall time of the job
+
+    FetchJobResult() : success(false), startMs(0), durationMs(0) {}
+};
+
+class FetchScheduler {
+  public:
+    /** Work of one source; returns true on success. Runs on a worker task. */
+    typedef std::function<bool()> Job;
+
+    /**
+     * @param maxConcurrent Upper bound on jobs running at the same time
+     *                      (1 runs the jobs one after the other)
+     */
+    explicit FetchScheduler(size_t maxConcurrent = FETCH_MAX_CONCURRENT);
+
+    /**
+     * @brief Queue a job for the next run()
+     * @return Index of the job's entry in getResults() after that run()
+     */
+    size_t addJob(const String& name, Job job);
+
+    /**
+     * @brief Run all queued jobs and wait for them (join barrier)
+     *
+     * Jobs start in the order they were added. The queue is emptied; the
+     * results stay available until the next run().
+     *
+     * @return Number of jobs that returned true
+     */
+    size_t run();
+
+    /** @brief Jobs queued for the next run() */
+    size_t getPendingCount() const { return jobs.size(); }
+
+    /** @brief Results of the last run(), in the order the jobs were added */
+    const std::vector<FetchJobResult>& getResults() const { return results; }
+
+    /** @brief Wall time of the last run() in milliseconds */
+    unsigned long getLastRunMs() const { return lastRunMs; }
+
+    /** @brief Most jobs that ran at the same time during the last run() */
+    size_t getPeakConcurrency() const { return peakConcurrency; }
+
+  private:
+    // Worker body: take jobs from the queue until it is empty
+    void workerLoop();
+
+    size_t maxConcurrent;
+    std::vector<Job> jobs;
+    std::vector<String> names;
+    std::vector<FetchJobResult> results;
+
+    // Shared between workers during run()
+    std::mutex queueMutex;
+    size_t nextJob;
+    size_t activeJobs;
+    size_t peakConcurrency;
+    unsigned long runStartMs;
+    unsigned long lastRunMs;
+};
+
+#endif // FETCH_SCHEDULER_H
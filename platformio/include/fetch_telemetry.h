@@ -0,0 +1,188 @@
+/**
+ * Per-source fetch telemetry kept across deep sleep
+ *
+ * Every wake, one record per calendar notes where its load spent its time:
+ * DNS lookup, TCP connect, TLS handshake, time to first byte, bytes
+ * received, parse time, events parsed/kept/rejected and retries. The
+ * records of the last FETCH_TELEMETRY_WAKES wakes are kept in a ring
+ * buffer that is written to RTC slow memory before deep sleep and, every
+ * FETCH_TELEMETRY_FLUSH_WAKES wakes, to LittleFS, so that a slow source can
+ * be spotted over several wakes from the debug build's serial menu. Native
+ * builds have no RTC memory: a static buffer stands in for it, and
+ * clearRtcImage() plays the part of a power loss.
+ */
+
+#ifndef FETCH_TELEMETRY_H
+#define FETCH_TELEMETRY_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#include "../test/mock_littlefs.h"
+#else
+#include <Arduino.h>
+#include <LittleFS.h>
+#endif
+
+#include <vector>
+
+#include "config.h"
+
+/**
+ * Network timings of one calendar request, measured by the fetcher
+ *
+ * DNS, connect and TLS are only known for connections opened by a
+ * ConnectionPool (the TLS split needs ResumableTlsClient); without a pool
+ * HTTPClient connects inside the request, so they are 0 and ttfbMs includes
+ * them. They are 0 as well for a request on a reused keep-alive connection.
+ */
+struct FetchTimings {
+    uint32_t dnsMs;     // Host name lookup
+    uint32_t connectMs; // TCP connect
+    uint32_t tlsMs;     // TLS handshake
+    uint32_t ttfbMs;    // Request sent until the response headers arrived
+    uint8_t retries;    // Failed attempts before the one that was answered
+    bool reused;        // Sent over a keep-alive connection opened by an earlier request
+
+    FetchTimings() : dnsMs(0), connectMs(0), tlsMs(0), ttfbMs(0), retries(0), reused(false) {}
+};
+
+/**
+ * One source in one wake, as stored in RTC memory
+ *
+ * Durations saturate at 65535 ms, counts at 65535.
+ */
+struct __attribute__((packed)) FetchTelemetryRecord {
+    uint32_t wake;                              // Wake number (see FetchTelemetry::beginWake())
+    uint32_t time;                              // Unix time of the fetch
+    char source[FETCH_TELEMETRY_SOURCE_BYTES]; // Calendar name, truncated and NUL-terminated
+    uint16_t dnsMs;
+    uint16_t connectMs;
+    uint16_t tlsMs;
+    uint16_t ttfbMs;
+    uint32_t bytes;          // Bytes received (compressed size if encoded, 0 after a 304)
+    uint32_t parseMs;        // Time spent parsing the body
+    uint16_t eventsParsed;   // VEVENTs parsed
+    uint16_t eventsFiltered; // Events (and occurrences) kept for the requested range
+    uint16_t eventsRejected; // Events outside the range, parsed or skipped by the pre-filter
+    uint8_t retries;         // Failed attempts, in the fetcher and in the calendar's own retry loop
+    uint8_t flags;           // FLAG_* below
+
+    static const uint8_t FLAG_LOADED       = 0x01; // Fresh events were loaded
+    static const uint8_t FLAG_NOT_MODIFIED = 0x02; // Server answered 304, the cache was reused
+    static const uint8_t FLAG_SPOOLED      = 0x04; // Body went through the spool file
+    static const uint8_t FLAG_STALE        = 0x08; // Fetch failed, the stale cache was shown
+    static const uint8_t FLAG_REUSED       = 0x10; // Sent over an already open connection
+
+    FetchTelemetryRecord();
+
+    /** @brief Copy the fetcher's timings, saturating them */
+    void setTimings(const FetchTimings& timings);
+
+    /** @brief Set the event counts, saturating them */
+    void setEvents(size_t parsed, size_t filtered, size_t rejected);
+
+    /** @brief Store name, truncated to FETCH_TELEMETRY_SOURCE_BYTES - 1 characters */
+    void setSource(const String& name);
+};
+
+class FetchTelemetry {
+  public:
+    /**
+     * @param capacity  Records kept; the oldest is overwritten beyond this
+     * @param keepWakes Records of older wakes are dropped by beginWake()
+     */
+    explicit FetchTelemetry(size_t capacity = FETCH_TELEMETRY_RECORDS, uint32_t keepWakes = FETCH_TELEMETRY_WAKES);
+
+    /**
+     * @brief Start a new wake; later records are tagged with its number
+     *
+     * Call after load(). Drops the records of wakes that are now too old.
+     *
+     * @return Number of the new wake
+     */
+    uint32_t beginWake();
+
+    /** @brief Number of the current wake (0 before the first beginWake()) */
+    uint32_t getWake() const { return wake; }
+
+    /** @brief Append a record of the current wake, overwriting the oldest when full */
+    void record(const FetchTelemetryRecord& entry);
+
+    /** @brief Records held, oldest first */
+    std::vector<FetchTelemetryRecord> getRecords() const;
+
+    size_t size() const { return count; }
+    void clear();
+
+    /** @brief One line describing a record, for the serial dump */
+    static String format(const FetchTelemetryRecord& entry);
+
+    // Persistence
+    /**
+     * @brief Restore the records of the previous wakes
+     *
+     * Reads the RTC memory image, or LittleFS when that image is missing
+     * (power-on). The file may lag RTC memory by a few wakes.
+     *
+     * @return true if an image was restored
+     */
+    bool load(const char* path = FETCH_TELEMETRY_FILE);
+
+    /**
+     * @brief Keep the records for the next wake
+     *
+     * Always writes the RTC memory image; the LittleFS copy is rewritten
+     * once FETCH_TELEMETRY_FLUSH_WAKES wakes have passed since it was last
+     * written, to spare the flash.
+     *
+     * @return false if the LittleFS copy was due but could not be written
+     */
+    bool save(const char* path = FETCH_TELEMETRY_FILE);
+
+    /** @brief Write the LittleFS copy now */
+    bool flush(const char* path = FETCH_TELEMETRY_FILE);
+
+    /** @brief Invalidate the RTC memory image, as a power loss would */
+    static void clearRtcImage();
+
+    /**
+     * @brief Serialize the wake counters and the records, oldest first
+     *
+     * The newest records are kept when not all of them fit in capacity.
+     *
+     * @return Bytes written (0 if not even the header fits)
+     */
+    size_t serialize(uint8_t* buffer, size_t capacity) const;
+
+    /**
+     * @brief Replace the records with those of a serialized image
+     *
+     * @return false if the image is malformed or fails its checksum (nothing is changed)
+     */
+    bool deserialize(const uint8_t* data, size_t length);
+
+  private:
+    struct __attribute__((packed)) ImageHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t count;
+        uint32_t wake;
+        uint32_t flushedWake;
+        uint32_t payloadLength;
+        uint32_t checksum; // CRC32 of the payload
+    };
+
+    bool loadFile(const char* path);
+
+    // Index of the i-th oldest record in ring
+    size_t slot(size_t i) const { return (first + i) % ring.size(); }
+
+    std::vector<FetchTelemetryRecord> ring;
+    size_t first;          // Oldest record
+    size_t count;          // Records held
+    uint32_t keepWakes;
+    uint32_t wake;         // Current wake number
+    uint32_t flushedWake;  // Wake at which the LittleFS copy was last written
+};
+
+#endif // FETCH_TELEMETRY_H
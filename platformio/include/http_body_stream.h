@@ -0,0 +1,89 @@
+/**
+ * HTTP/1.1 message body framing as a Stream adapter
+ *
+ * On a keep-alive connection the end of a response body is only known from
+ * its framing: a Content-Length, or "Transfer-Encoding: chunked". This
+ * adapter reads exactly one body from the connection stream, strips the
+ * chunk framing, and tells whether the body was consumed completely - only
+ * then may the connection carry the next request.
+ */
+
+#ifndef HTTP_BODY_STREAM_H
+#define HTTP_BODY_STREAM_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#include <Stream.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+class HttpBodyStream : public Stream {
+  public:
+    /**
+     * @param source        Connection stream (not owned)
+     * @param contentLength Body length, or -1 if unknown
+     * @param chunked       Body uses chunked transfer coding (contentLength is ignored)
+     */
+    HttpBodyStream(Stream* source, int contentLength, bool chunked);
+
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    virtual void flush();
+    virtual size_t write(uint8_t); // Not implemented
+    virtual String readString();
+#ifdef NATIVE_TEST
+    virtual size_t readBytes(uint8_t* buffer, size_t length);
+#else
+    virtual size_t readBytes(char* buffer, size_t length);
+#endif
+
+    /**
+     * @brief Read and discard the rest of the body
+     *
+     * @param limit Give up after this many bytes
+     * @return true if the end of the body was reached
+     */
+    bool drain(size_t limit);
+
+    /** @brief True once the whole body, including the final chunk, was read */
+    bool isComplete() const { return complete; }
+
+    /** @brief True if the framing was malformed or the connection ended early */
+    bool hasError() const { return error != nullptr; }
+
+    /** @brief Description of the framing error, or nullptr */
+    const char* getError() const { return error; }
+
+    /** @brief Body bytes (without chunk framing) read from the connection */
+    size_t getBodyBytes() const { return bodyBytes; }
+
+  private:
+    // Bytes of body data that can be read from the source right now; parses
+    // the next chunk header first when the current chunk is used up. With
+    // wait, at least one byte is reported while the body is not over, for a
+    // read that blocks until it arrives.
+    size_t readable(bool wait);
+
+    bool readChunkHeader();
+    int skipLine(); // Rest of the current line: its length without CRLF, or -1
+    size_t take(uint8_t* buffer, size_t length);
+    int nextSourceByte();
+    void fail(const char* message);
+
+    Stream* source;
+    bool chunked;
+    bool lengthKnown;
+    size_t remaining; // Bytes left in the body (identity) or the current chunk
+    bool complete;
+    bool needChunkCrlf; // Chunk data was read, its trailing CRLF was not
+    const char* error;
+    size_t bodyBytes;
+    int peeked; // Byte returned by peek() and not yet consumed, or -1
+};
+
+#endif // HTTP_BODY_STREAM_H
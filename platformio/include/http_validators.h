@@ -0,0 +1,25 @@
+/**
+ * HTTP cache validators of a downloaded calendar feed
+ *
+ * The ETag and Last-Modified response headers identify one version of a
+ * feed. Sent back as If-None-Match / If-Modified-Since on the next request,
+ * they let the server answer 304 Not Modified instead of resending the body.
+ */
+
+#ifndef HTTP_VALIDATORS_H
+#define HTTP_VALIDATORS_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+struct HttpValidators {
+    String etag;         // ETag response header, sent as If-None-Match
+    String lastModified; // Last-Modified response header, sent as If-Modified-Since
+
+    bool isEmpty() const { return etag.isEmpty() && lastModified.isEmpty(); }
+};
+
+#endif // HTTP_VALIDATORS_H
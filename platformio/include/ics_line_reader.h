@@ -0,0 +1,183 @@
+/**
+ * Block-reading tokenizer for ICS (RFC 5545) content lines
+ *
+ * Reads the source stream in large blocks into a fixed buffer and hands out
+ * (const char*, length) views of complete logical lines. Whatever the stream
+ * has available is taken at once; when nothing is, the reader blocks in
+ * readBytes() for the stream's timeout instead of polling. Folded continuation
+ * lines (CRLF followed by a space or tab) are unfolded in place, so callers
+ * never see the physical line structure and no per-line String is built.
+ */
+
+#ifndef ICS_LINE_READER_H
+#define ICS_LINE_READER_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <cstddef>
+#include <cstring>
+
+/**
+ * View of one content line split into its RFC 5545 parts:
+ *   name *(";" param) ":" value
+ * All pointers reference the original line; nothing is copied.
+ */
+struct IcsProperty {
+    const char* name;
+    size_t nameLength;
+    const char* params;  ///< Parameter list without the leading ';' (may be empty)
+    size_t paramsLength;
+    const char* value;
+    size_t valueLength;
+
+    IcsProperty()
+        : name(nullptr), nameLength(0), params(nullptr), paramsLength(0), value(nullptr),
+          valueLength(0) {}
+
+    /** @brief True if the property name equals the literal */
+    bool is(const char* literal) const {
+        size_t literalLength = strlen(literal);
+        return nameLength == literalLength && memcmp(name, literal, literalLength) == 0;
+    }
+};
+
+class IcsLineReader {
+  public:
+    static const size_t DEFAULT_BUFFER_SIZE = 4096; ///< Default block buffer size in bytes
+    static const size_t MIN_READ_CHUNK      = 512;  ///< Free space kept for each block read
+
+    /**
+     * @brief Create a reader on top of a stream
+     *
+     * The buffer is allocated once and never grows. Logical lines longer than
+     * (bufferSize - MIN_READ_CHUNK) bytes are truncated; the remainder of the
+     * line is consumed and dropped.
+     *
+     * @param stream Source stream (not owned)
+     * @param bufferSize Size of the block buffer in bytes
+     */
+    explicit IcsLineReader(Stream* stream, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~IcsLineReader();
+
+    /**
+     * @brief Get the next unfolded logical line
+     *
+     * The returned view points into the internal buffer and stays valid only
+     * until the next call. The line terminator is not included and the view
+     * is not NUL-terminated.
+     *
+     * @param line Output: pointer to the first character of the line
+     * @param length Output: number of characters in the line
+     * @return true if a line was returned, false at end of stream
+     */
+    bool next(const char*& line, size_t& length);
+
+    /** @brief True once the stream is exhausted and every line was returned */
+    bool isEof() const { return finished; }
+
+    /** @brief Total bytes pulled from the stream */
+    size_t getBytesRead() const { return bytesRead; }
+
+    /** @brief Logical lines returned so far */
+    size_t getLinesRead() const { return linesRead; }
+
+    /** @brief Time spent blocked waiting for the stream to deliver data */
+    unsigned long getStallMs() const { return stallMs; }
+
+    /** @brief Logical lines that were cut at the maximum line length */
+    size_t getLinesTruncated() const { return linesTruncated; }
+
+    /** @brief Longest logical line the reader can return */
+    size_t getMaxLineLength() const { return maxLineLength; }
+
+    /**
+     * @brief Check whether a line view starts with a literal
+     *
+     * @param line Line view
+     * @param length Line length
+     * @param prefix NUL-terminated literal to compare with
+     * @return true if the line starts with prefix
+     */
+    static bool startsWith(const char* line, size_t length, const char* prefix) {
+        size_t prefixLength = strlen(prefix);
+        return length >= prefixLength && memcmp(line, prefix, prefixLength) == 0;
+    }
+
+    /**
+     * @brief Check whether a line view contains a literal anywhere
+     */
+    static bool contains(const char* line, size_t length, const char* needle);
+
+    /**
+     * @brief Split a content line into name, parameters and value
+     *
+     * The value starts after the first ':' that is not inside a quoted
+     * parameter value, so DTSTART;TZID="a:b":2025... is handled.
+     *
+     * @param line Line view (unfolded, without terminator)
+     * @param length Line length
+     * @param property Output: views into line
+     * @return false if the line has no ':' separator
+     */
+    static bool splitProperty(const char* line, size_t length, IcsProperty& property);
+
+    /**
+     * @brief Look up a parameter of a split property by name
+     *
+     * Parameter names are matched case-insensitively and may appear in any
+     * order. Surrounding double quotes are stripped from the value.
+     *
+     * @param property Property returned by splitProperty()
+     * @param name Parameter name, e.g. "TZID"
+     * @param value Output: start of the parameter value
+     * @param valueLength Output: length of the parameter value
+     * @return true if the parameter is present
+     */
+    static bool findParameter(const IcsProperty& property, const char* name, const char*& value,
+                              size_t& valueLength);
+
+  private:
+    IcsLineReader(const IcsLineReader&);            // Non-copyable
+    IcsLineReader& operator=(const IcsLineReader&); // Non-copyable
+
+    /**
+     * @brief Make sure buffer[position] holds data, reading more if needed
+     * @return true if the byte is available, false at end of stream
+     */
+    bool ensureAvailable(size_t position);
+
+    /**
+     * @brief Pull the next block from the stream into the buffer
+     * @return false if the stream has no more data
+     */
+    bool fill();
+
+    /**
+     * @brief Move the current line and unread bytes to the front of the buffer
+     */
+    void compact();
+
+    Stream* stream;
+    char* buffer;
+    size_t capacity;
+    size_t maxLineLength;
+
+    size_t lineStart; ///< Start of the line being assembled
+    size_t writePos;  ///< End of the unfolded line content (<= scanPos)
+    size_t scanPos;   ///< Next byte to examine
+    size_t dataEnd;   ///< End of valid data in the buffer
+
+    bool streamEnded;
+    bool finished;
+
+    size_t bytesRead;
+    size_t linesRead;
+    size_t linesTruncated;
+    unsigned long stallMs;
+};
+
+#endif // ICS_LINE_READER_H
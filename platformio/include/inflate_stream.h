@@ -0,0 +1,147 @@
+/**
+ * Streaming gzip / deflate decoder as a Stream adapter
+ *
+ * Wraps a compressed source stream (an HTTP body sent with
+ * "Content-Encoding: gzip" or "deflate") and reads back the inflated bytes.
+ * Decoding is incremental: compressed input is pulled in small blocks and
+ * output is produced into the 32 KB history window that DEFLATE
+ * back-references require, from which the reader consumes it directly. The
+ * whole body is never held in memory. Gzip and zlib trailers are consumed;
+ * the gzip length is checked, checksums are left to TCP/TLS.
+ */
+
+#ifndef INFLATE_STREAM_H
+#define INFLATE_STREAM_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#include <Stream.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+class InflateStream : public Stream {
+  public:
+    enum Format {
+        FORMAT_GZIP,    ///< RFC 1952 gzip member ("Content-Encoding: gzip")
+        FORMAT_DEFLATE, ///< zlib (RFC 1950) or raw deflate, detected from the first bytes
+    };
+
+    static const size_t WINDOW_SIZE       = 32768; ///< DEFLATE history window (also the output buffer)
+    static const size_t INPUT_BUFFER_SIZE = 512;   ///< Compressed bytes pulled per source read
+
+    /**
+     * @param source Compressed stream (not owned)
+     * @param format Container format of the source
+     */
+    InflateStream(Stream* source, Format format);
+    virtual ~InflateStream();
+
+    /**
+     * @brief Format for an HTTP Content-Encoding value
+     *
+     * @param format Output: decoder format for the encoding
+     * @return false for identity (or empty) and for unsupported encodings
+     */
+    static bool formatForEncoding(const String& contentEncoding, Format& format);
+
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    virtual void flush();
+    virtual size_t write(uint8_t); // Not implemented
+    virtual String readString();
+#ifdef NATIVE_TEST
+    virtual size_t readBytes(uint8_t* buffer, size_t length);
+#else
+    virtual size_t readBytes(char* buffer, size_t length);
+#endif
+
+    /** @brief False if the window could not be allocated */
+    bool isValid() const { return window != nullptr; }
+
+    /** @brief True once the compressed data turned out corrupt or truncated */
+    bool hasError() const { return state == STATE_ERROR; }
+
+    /** @brief Description of the decoding error, or nullptr */
+    const char* getError() const { return error; }
+
+    /** @brief True once the end of the compressed data has been decoded */
+    bool isFinished() const { return state == STATE_DONE; }
+
+    /** @brief Compressed bytes read from the source so far */
+    size_t getCompressedBytes() const { return compressedBytes; }
+
+    /** @brief Inflated bytes produced so far */
+    size_t getInflatedBytes() const { return writePos; }
+
+  private:
+    enum State {
+        STATE_HEADER,
+        STATE_BLOCK,
+        STATE_STORED,
+        STATE_CODES,
+        STATE_TRAILER,
+        STATE_DONE,
+        STATE_ERROR,
+    };
+
+    // Canonical Huffman code: number of codes per length and symbols in code order
+    struct Huffman {
+        uint16_t counts[16];
+        uint16_t symbols[288];
+    };
+
+    // Decode until OUTPUT_CHUNK bytes are buffered, the data ends or fails
+    void produce();
+
+    bool readHeader();
+    bool readBlockHeader();
+    bool readDynamicTables();
+    void decodeCodes();
+    void copyStored();
+    bool readTrailer();
+
+    static bool buildHuffman(Huffman& table, const uint8_t* lengths, int count, bool allowIncomplete);
+    int decodeSymbol(const Huffman& table);
+
+    // Bit input (LSB first); a source that ends early sets `truncated`
+    int nextByte();
+    uint32_t getBits(int count);
+    void alignToByte();
+
+    void fail(const char* message);
+    size_t unread() const { return writePos - readPos; }
+    size_t take(uint8_t* buffer, size_t length);
+
+    Stream* source;
+    Format format;
+    State state;
+    const char* error;
+
+    uint8_t* window;
+    size_t writePos; // Total bytes inflated (window index = writePos % WINDOW_SIZE)
+    size_t readPos;  // Total bytes handed to the reader
+
+    uint8_t input[INPUT_BUFFER_SIZE];
+    size_t inputPos;
+    size_t inputEnd;
+    size_t compressedBytes;
+    bool truncated;
+    bool zlibWrapped;
+
+    uint32_t bitBuffer;
+    int bitCount;
+
+    bool finalBlock;
+    size_t storedRemaining;
+    size_t matchRemaining;  // Bytes of the current back-reference not yet copied
+    size_t matchDistance;
+    Huffman literals;
+    Huffman distances;
+};
+
+#endif // INFLATE_STREAM_H
@@ -0,0 +1,81 @@
+/**
+ * Index of recurrence instances that must not be generated from a master
+ *
+ * Built while the calendar is streamed: every EXDATE of a recurring master
+ * and every RECURRENCE-ID of an override VEVENT adds one (UID hash, instance)
+ * entry. Entries live in a single array sorted by UID hash and then instance
+ * time, so the exclusions of one master form a contiguous sorted run and a
+ * lookup is a binary search. The array has a fixed capacity; once full,
+ * further entries are dropped and those instances are simply shown.
+ */
+
+#ifndef RECURRENCE_OVERRIDES_H
+#define RECURRENCE_OVERRIDES_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+class RecurrenceOverrideIndex {
+  public:
+    /** Why an instance is not generated from its master */
+    enum Kind : uint8_t {
+        EXCLUDED = 1,  ///< Listed in the master's EXDATE
+        OVERRIDDEN = 2 ///< Replaced by a VEVENT with a matching RECURRENCE-ID
+    };
+
+    /** Upper bound on stored entries (16 bytes each) */
+    static const size_t MAX_ENTRIES = 512;
+
+    RecurrenceOverrideIndex();
+
+    /** @brief Drop all entries (start of a new calendar) */
+    void clear();
+
+    /**
+     * @brief Record an instance that must not be generated
+     *
+     * @param uid UID shared by the master and its overrides
+     * @param instance Original start time of the instance (UTC)
+     * @param kind EXCLUDED or OVERRIDDEN
+     * @return false if the index is full or the UID is empty
+     */
+    bool add(const String& uid, time_t instance, Kind kind);
+
+    /** @brief True if an entry exists for this UID hash and instance */
+    bool isSuppressed(uint32_t uidHash, time_t instance) const;
+
+    /** @brief True if any entry exists for this UID hash */
+    bool hasEntries(uint32_t uidHash) const;
+
+    /** @brief Number of stored entries */
+    size_t size() const { return entries.size(); }
+
+    /** @brief Entries rejected because the index was full */
+    size_t getDropped() const { return dropped; }
+
+    /** @brief 32-bit FNV-1a hash of a UID */
+    static uint32_t hashUid(const String& uid);
+
+  private:
+    struct Entry {
+        uint32_t uidHash;
+        uint8_t kind;
+        int64_t instance;
+
+        bool operator<(const Entry& other) const {
+            return uidHash != other.uidHash ? uidHash < other.uidHash : instance < other.instance;
+        }
+    };
+
+    std::vector<Entry> entries;
+    size_t dropped;
+};
+
+#endif // RECURRENCE_OVERRIDES_H
@@ -0,0 +1,54 @@
+/**
+ * WiFiClientSecure that resumes TLS sessions from a TlsSessionCache
+ *
+ * arduino-esp32's WiFiClientSecure sets up and completes the mbedTLS
+ * handshake in one call, leaving no point at which a saved session can be
+ * offered. This client performs the same steps itself (TCP connect,
+ * mbedTLS setup with the firmware's setInsecure() policy, handshake) and
+ * calls mbedtls_ssl_set_session() in between when the cache has a session
+ * for the server. After every handshake the negotiated session is written
+ * back to the cache and the handshake time is recorded as full or resumed.
+ * Everything after the handshake (reads, writes, stop()) is the unchanged
+ * WiFiClientSecure code working on the same ssl context.
+ */
+
+#ifndef RESUMABLE_TLS_CLIENT_H
+#define RESUMABLE_TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+
+#include "tls_session_cache.h"
+
+class ResumableTlsClient : public WiFiClientSecure {
+  public:
+    /** @param sessions Session store shared by all clients of the wake (not owned) */
+    explicit ResumableTlsClient(TlsSessionCache* sessions);
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(IPAddress ip, uint16_t port, int32_t timeout);
+    int connect(const char* host, uint16_t port);
+    int connect(const char* host, uint16_t port, int32_t timeout);
+
+    /** @brief Duration of the last successful handshake (TCP connect included) in milliseconds */
+    unsigned long getLastHandshakeMs() const { return lastHandshakeMs; }
+    /** @brief Duration of the DNS lookup of the last successful connect() in milliseconds */
+    unsigned long getLastDnsMs() const { return lastDnsMs; }
+    /** @brief Duration of the TCP connect of the last successful connect() in milliseconds */
+    unsigned long getLastConnectMs() const { return lastConnectMs; }
+    /** @brief The last handshake resumed a cached session */
+    bool wasResumed() const { return lastResumed; }
+
+  private:
+    bool openSocket(const IPAddress& ip, uint16_t port, int32_t timeout);
+    bool offerSession(const String& key, time_t& sessionStart);
+    void rememberSession(const String& key, bool resumed);
+
+    TlsSessionCache* sessions;
+    unsigned long lastHandshakeMs;
+    unsigned long lastDnsMs;
+    unsigned long lastConnectMs;
+    bool lastResumed;
+};
+
+#endif // RESUMABLE_TLS_CLIENT_H
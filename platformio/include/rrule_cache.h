@@ -0,0 +1,80 @@
+/**
+ * Interned compiled RRULEs of one parse session
+ *
+ * Calendar feeds repeat a small set of RRULE strings across many VEVENTs
+ * ("FREQ=WEEKLY;BYDAY=MO,TU,WE,TH,FR"). Each distinct string is parsed and
+ * compiled once; later events with the same rule reuse the CompiledRRule.
+ * Entries live in an array sorted by the FNV-1a hash of the rule text, and
+ * the text itself is compared on a hash match. The array has a fixed
+ * capacity; once full, further rules are compiled per event as before.
+ */
+
+#ifndef RRULE_CACHE_H
+#define RRULE_CACHE_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <cstdint>
+#include <vector>
+
+#include "rrule_engine.h"
+
+class RRuleCache {
+  public:
+    /** Upper bound on interned rules (about 300 bytes each) */
+    static const size_t MAX_ENTRIES = 64;
+
+    RRuleCache();
+
+    /** @brief Drop all rules and reset the counters (start of a new calendar) */
+    void clear();
+
+    /**
+     * @brief Look up a rule by its RRULE text
+     *
+     * Counts a hit when found and a miss otherwise.
+     *
+     * @param valid Output: false if the rule was interned as invalid
+     * @return Compiled rule, or nullptr if not interned. The pointer is only
+     *         valid until the next call to insert() or clear().
+     */
+    const CompiledRRule* find(const String& rrule, bool& valid);
+
+    /**
+     * @brief Intern the compiled form of a rule
+     *
+     * @param valid false to remember that the rule does not compile
+     * @return false if the cache is full
+     */
+    bool insert(const String& rrule, const CompiledRRule& compiled, bool valid);
+
+    /** @brief Number of interned rules */
+    size_t size() const { return entries.size(); }
+
+    /** @brief Lookups answered from the cache */
+    size_t getHits() const { return hits; }
+
+    /** @brief Lookups that had to parse the rule */
+    size_t getMisses() const { return misses; }
+
+    /** @brief 32-bit FNV-1a hash of an RRULE string */
+    static uint32_t hashRule(const String& rrule);
+
+  private:
+    struct Entry {
+        uint32_t hash;
+        bool valid;
+        String text;
+        CompiledRRule compiled;
+    };
+
+    std::vector<Entry> entries;
+    size_t hits;
+    size_t misses;
+};
+
+#endif // RRULE_CACHE_H
@@ -0,0 +1,224 @@
+/**
+ * Compiled RFC 5545 recurrence rules and the generic expansion kernel
+ *
+ * An RRULE is parsed once into RRuleComponents (the raw BYxxx lists) and
+ * then compiled into CompiledRRule, where every BYxxx part is a bitset.
+ * RRuleExpander walks the rule's periods (years, months, weeks, days or
+ * fixed sub-daily steps) from DTSTART in the event's wall-clock time, tests
+ * each candidate day with a few bit operations, applies BYSETPOS and hands
+ * out the resulting instants in ascending order.
+ */
+
+#ifndef RRULE_ENGINE_H
+#define RRULE_ENGINE_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+class CompiledTimeZone;
+
+// Enum for recurrence frequency (RFC 5545)
+enum class RecurrenceFrequency { YEARLY, MONTHLY, WEEKLY, DAILY, HOURLY, MINUTELY, SECONDLY, NONE };
+
+/**
+ * Parsed RRULE components according to RFC 5545
+ * Represents the structured form of a recurrence rule
+ */
+struct RRuleComponents {
+    // Core frequency (REQUIRED)
+    String freq; // YEARLY, MONTHLY, WEEKLY, DAILY, HOURLY, MINUTELY, SECONDLY
+
+    // Termination rules (mutually exclusive, but COUNT takes precedence if both present)
+    int count;    // Number of occurrences (-1 = not specified)
+    time_t until; // End date for recurrence (0 = not specified)
+
+    // Frequency multiplier
+    int interval; // Interval between occurrences (default: 1)
+
+    // Filters for expanding/restricting occurrences
+    String byDay;      // Comma-separated day codes (e.g., "MO,WE,FR")
+    String byMonthDay; // Comma-separated day numbers (e.g., "1,15,-1")
+    String byMonth;    // Comma-separated month numbers (e.g., "1,7" for Jan, Jul)
+    String byHour;     // Comma-separated local hours (e.g., "8,12,20")
+    String byMinute;   // Comma-separated minutes (e.g., "0,30")
+    String bySecond;   // Comma-separated seconds (e.g., "0")
+    String byYearDay;  // Comma-separated days of the year (e.g., "1,100,-1")
+    String byWeekNo;   // Comma-separated week numbers (e.g., "20,-1")
+    String bySetPos;   // Comma-separated positions within a period (e.g., "-1")
+    String wkst;       // Week start day code (default "MO")
+
+    // Constructor with sensible defaults
+    RRuleComponents() : count(-1), until(0), interval(1) {}
+
+    // Helper methods for checking RRULE components
+    bool hasCountLimit() const { return count > 0; }
+    bool hasUntilLimit() const { return until > 0; }
+    bool hasInterval() const { return interval > 1; }
+    bool hasByDay() const { return !byDay.isEmpty(); }
+    bool hasByMonthDay() const { return !byMonthDay.isEmpty(); }
+    bool hasByMonth() const { return !byMonth.isEmpty(); }
+    bool hasByHour() const { return !byHour.isEmpty(); }
+    bool hasByMinute() const { return !byMinute.isEmpty(); }
+    bool hasBySetPos() const { return !bySetPos.isEmpty(); }
+    bool isValid() const { return !freq.isEmpty(); }
+
+    // Helper methods for checking frequency type
+    bool isYearly() const { return freq == "YEARLY"; }
+    bool isMonthly() const { return freq == "MONTHLY"; }
+    bool isWeekly() const { return freq == "WEEKLY"; }
+    bool isDaily() const { return freq == "DAILY"; }
+    bool isHourly() const { return freq == "HOURLY"; }
+    bool isMinutely() const { return freq == "MINUTELY"; }
+    bool isSecondly() const { return freq == "SECONDLY"; }
+};
+
+/**
+ * @brief An RRULE with every BYxxx list turned into a bitset
+ *
+ * Bit n of a positive set stands for value n; bit n of a "Neg" set stands
+ * for -n (counted from the end of the month, year or period).
+ */
+struct CompiledRRule {
+    /** Which BYxxx parts are present */
+    enum Part : uint16_t {
+        BY_MONTH = 1 << 0,
+        BY_WEEKNO = 1 << 1,
+        BY_YEARDAY = 1 << 2,
+        BY_MONTHDAY = 1 << 3,
+        BY_DAY = 1 << 4,     ///< Any BYDAY entry
+        BY_DAY_NTH = 1 << 5, ///< At least one BYDAY entry with an ordinal ("1FR", "-1SU")
+        BY_HOUR = 1 << 6,
+        BY_MINUTE = 1 << 7,
+        BY_SECOND = 1 << 8,
+        BY_SETPOS = 1 << 9
+    };
+
+    /** BYSETPOS entries kept (RFC examples use one or two) */
+    static const int MAX_SETPOS = 8;
+
+    RecurrenceFrequency freq;
+    int interval;
+    int count;    // -1 = no COUNT
+    time_t until; // 0 = no UNTIL
+    uint8_t wkst; // 0=SU ... 6=SA
+    uint16_t parts;
+
+    uint16_t byMonth;             // Bits 1-12
+    uint32_t byMonthDay;          // Bits 1-31
+    uint32_t byMonthDayNeg;       // Bits 1-31 for -1..-31
+    uint8_t byWeekday;            // BYDAY without ordinal, bit 0=SU ... 6=SA
+    uint64_t byWeekdayNth[7];     // BYDAY ordinals 1-53 per weekday
+    uint64_t byWeekdayNthNeg[7];  // BYDAY ordinals -1..-53 per weekday
+    uint64_t byWeekNo;            // Bits 1-53
+    uint64_t byWeekNoNeg;         // Bits 1-53 for -1..-53
+    uint32_t byYearDay[12];       // Bits 1-366
+    uint32_t byYearDayNeg[12];    // Bits 1-366 for -1..-366
+    uint32_t byHour;              // Bits 0-23
+    uint64_t byMinute;            // Bits 0-59
+    uint64_t bySecond;            // Bits 0-60
+    int16_t bySetPos[MAX_SETPOS];
+    uint8_t bySetPosCount;
+
+    CompiledRRule();
+
+    /**
+     * @brief Compile parsed RRULE components
+     *
+     * Out-of-range list values are ignored, as are BYxxx parts RFC 5545 does
+     * not allow for the frequency (e.g. BYWEEKNO outside YEARLY).
+     *
+     * @return false if the frequency is missing or unknown
+     */
+    bool compile(const RRuleComponents& rule);
+
+    bool has(Part part) const { return (parts & part) != 0; }
+
+    /** @brief True if every period yields exactly one occurrence (no BYxxx part) */
+    bool isSimple() const { return parts == 0; }
+
+    static bool testBit(const uint32_t* set, int bit) { return (set[bit >> 5] >> (bit & 31)) & 1; }
+};
+
+/**
+ * @brief Generic RRULE expansion kernel
+ *
+ * Produces the recurrence set in ascending order: DTSTART first (RFC 5545
+ * always counts it as the first instance), then every instant generated by
+ * the rule after it. COUNT, UNTIL, overrides and the query range are left to
+ * the caller, which only needs the ascending order to stop early.
+ */
+class RRuleExpander {
+  public:
+    RRuleExpander();
+
+    /**
+     * @brief Prepare expansion
+     *
+     * @param rule Compiled rule (copied)
+     * @param dtstart First instance (UTC)
+     * @param zone Zone of the event's wall-clock time, nullptr for the local zone
+     * @param from Skip whole periods that end before this instant; pass
+     *             dtstart when every instance must be seen (COUNT)
+     * @param limit Stop once a period starts after this instant
+     */
+    void begin(const CompiledRRule& rule, time_t dtstart, const CompiledTimeZone* zone, time_t from, time_t limit);
+
+    /**
+     * @brief Next instant of the recurrence set
+     *
+     * @return false once the periods pass the limit
+     */
+    bool next(time_t& instant);
+
+    /** @brief Periods expanded so far (including skipped sub-daily blocks) */
+    int getPeriodCount() const { return periods; }
+
+    /** @brief Index of the first period expanded (periods skipped by begin) */
+    int64_t getFirstPeriod() const { return firstPeriod; }
+
+    /** @brief Week number (1-53) of a day in the year it belongs to, weeks starting on wkst */
+    static int weekNumber(int64_t days, int wkst, int& weeksInYear);
+
+  private:
+    bool fillPeriod();
+    bool fillDays(int64_t firstDay, int dayCount);
+    bool fillSubDaily();
+    bool matchesDay(int64_t days, int64_t year, int month, int monthDay) const;
+    void applySetPos();
+    time_t toUtc(int64_t days, int hour, int minute, int second) const;
+    void toLocal(time_t utc, struct tm& local) const;
+
+    CompiledRRule rule;
+    const CompiledTimeZone* zone;
+    time_t dtstart;
+    time_t limit;
+    bool dtstartPending;
+    bool done;
+
+    // DTSTART in wall-clock time
+    int64_t startDays;
+    int64_t startYear;
+    int startMonth;
+    int startMonthDay;
+    int startWeekday;
+    int startHour;
+    int startMinute;
+    int startSecond;
+
+    int64_t period;      // Current period index (0 = the period of DTSTART)
+    int64_t firstPeriod;
+    int periods;
+    time_t step;         // Sub-daily: seconds per period
+
+    std::vector<time_t> candidates;
+    size_t candidatePos;
+};
+
+#endif // RRULE_ENGINE_H
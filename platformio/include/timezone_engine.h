@@ -0,0 +1,171 @@
+#ifndef TIMEZONE_ENGINE_H
+#define TIMEZONE_ENGINE_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+/**
+ * @brief A POSIX TZ rule compiled into offsets and per-year transitions
+ *
+ * Compiling parses the TZ string once ("CET-1CEST,M3.5.0,M10.5.0/3").
+ * The two DST transitions of a year are computed on first use and kept in a
+ * small per-year table, so every later conversion is plain integer
+ * arithmetic: no setenv("TZ"), no tzset() and no global state is touched.
+ */
+class CompiledTimeZone {
+  public:
+    CompiledTimeZone();
+
+    /**
+     * @brief Parse a POSIX TZ string
+     *
+     * Supports "std offset [dst [offset] [,start[/time],end[/time]]]" with
+     * quoted names ("<+03>-3") and Mm.w.d, Jn and n transition rules.
+     *
+     * @param posix POSIX TZ string
+     * @return false if the string is not a valid POSIX TZ rule
+     */
+    bool compile(const char* posix);
+
+    /** @brief True once compile() succeeded */
+    bool isValid() const { return valid; }
+
+    /** @brief True if the zone observes daylight saving time */
+    bool hasDst() const { return dstRules; }
+
+    /** @brief UTC offset in seconds (east positive) in effect at a UTC instant */
+    int32_t offsetAt(time_t utc) const { return isDstAt(utc) ? dstOffset : stdOffset; }
+
+    /** @brief True if DST is in effect at a UTC instant */
+    bool isDstAt(time_t utc) const;
+
+    /**
+     * @brief Convert a UTC instant to broken-down local time (like localtime_r)
+     */
+    void toLocal(time_t utc, struct tm& local) const;
+
+    /**
+     * @brief Convert broken-down local time to UTC (like mktime)
+     *
+     * Out-of-range fields are normalized and written back, including
+     * tm_wday, tm_yday and tm_isdst. A positive or zero tm_isdst forces the
+     * DST or standard offset; a negative value lets the zone decide. Times
+     * in the spring-forward gap resolve with the standard offset and times
+     * in the fall-back overlap resolve to the DST (earlier) instant.
+     */
+    time_t toUtc(struct tm& local) const;
+
+  private:
+    /** Transition rule as written in the TZ string */
+    struct Rule {
+        char type;     // 'M' (month.week.day), 'J' (Julian 1-365) or 'N' (zero-based day)
+        int16_t month; // 1-12 for 'M'
+        int16_t week;  // 1-5 for 'M' (5 = last)
+        int16_t day;   // weekday 0-6 for 'M', day of year for 'J'/'N'
+        int32_t time;  // Seconds after local midnight
+    };
+
+    /** Cached DST window of one year, in UTC */
+    struct YearTransitions {
+        int32_t year;
+        int64_t dstStart;
+        int64_t dstEnd;
+    };
+
+    static const int TRANSITION_CACHE_SIZE = 4;
+
+    YearTransitions transitionsFor(int32_t year) const;
+    int64_t ruleToLocalSeconds(const Rule& rule, int32_t year) const;
+    bool isDstAtSeconds(int64_t utc) const;
+
+    bool valid;
+    bool dstRules;
+    int32_t stdOffset; // Seconds east of UTC
+    int32_t dstOffset; // Seconds east of UTC
+    Rule dstStartRule;
+    Rule dstEndRule;
+
+    mutable YearTransitions transitionCache[TRANSITION_CACHE_SIZE];
+
+    // Guards transitionCache of every zone; zones are shared by parsers
+    // running on concurrent fetch tasks
+    static std::mutex transitionMutex;
+};
+
+/**
+ * @brief Registry of compiled time zones and tz-free date arithmetic
+ *
+ * Zones are compiled the first time a TZID is seen and reused afterwards.
+ * TZIDs are resolved through timezone_map.h (IANA names) or taken as POSIX
+ * strings directly. The local zone follows the TZ environment variable set
+ * at boot; if it is unset or cannot be compiled, the libc functions are used.
+ *
+ * A zone, once returned, is never recompiled or evicted, so the pointer
+ * stays valid without holding any lock. When MAX_ZONES TZIDs have been
+ * seen, further ones resolve to nullptr and take the libc path.
+ */
+class TimeZoneEngine {
+  public:
+    /**
+     * @brief Look up (and compile on first use) the zone for a TZID
+     *
+     * @param tzid IANA name ("Europe/Zurich"), POSIX TZ string or "UTC"
+     * @return Compiled zone, or nullptr if the TZID is unknown
+     */
+    static const CompiledTimeZone* find(const String& tzid);
+
+    /** @brief Compiled zone matching the TZ environment variable, or nullptr */
+    static const CompiledTimeZone* local();
+
+    /** @brief localtime_r() replacement using the compiled local zone */
+    static struct tm* localTime(time_t utc, struct tm& result);
+
+    /** @brief mktime() replacement using the compiled local zone */
+    static time_t makeLocal(struct tm& local);
+
+    /**
+     * @brief mktime() in another TZ, for TZIDs the engine cannot compile
+     *
+     * Temporarily switches the TZ environment variable. Serialized against
+     * find(), local() and the libc fallbacks of localTime() and makeLocal(),
+     * so code going through the engine never sees the borrowed TZ.
+     */
+    static time_t makeInTz(const char* tz, struct tm& local);
+
+    /** @brief gmtime_r() replacement (pure arithmetic) */
+    static struct tm* utcTime(time_t utc, struct tm& result);
+
+    /** @brief timegm() replacement; normalizes the struct like timegm() */
+    static time_t makeUtc(struct tm& utc);
+
+    /** @brief Drop all compiled zones; invalidates every zone returned so far (tests only) */
+    static void clear();
+
+    // Civil calendar helpers (proleptic Gregorian, days since 1970-01-01)
+    static int64_t daysFromCivil(int64_t year, int month, int day);
+    static void civilFromDays(int64_t days, int64_t& year, int& month, int& day);
+    static bool isLeapYear(int64_t year);
+    static int daysInMonth(int64_t year, int month);
+
+    /** @brief Break seconds since the epoch into tm fields (no offset applied) */
+    static void breakDown(int64_t seconds, struct tm& result);
+
+    /** @brief Combine tm fields into seconds since the epoch, normalizing overflow */
+    static int64_t combine(const struct tm& fields);
+
+    /** Distinct TZIDs compiled per boot, the local TZ included */
+    static const int MAX_ZONES = 16;
+
+  private:
+    // find() with registryMutex already held
+    static const CompiledTimeZone* findLocked(const String& tzid);
+};
+
+#endif // TIMEZONE_ENGINE_H
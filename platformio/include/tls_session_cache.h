@@ -0,0 +1,169 @@
+/**
+ * TLS sessions kept across deep sleep for abbreviated handshakes
+ *
+ * After a full handshake the client stores the negotiated session (its
+ * session ticket or ID and master secret, serialized by mbedTLS) under
+ * "host:port". On the next connection to that host the session is offered
+ * to the server, which can then skip the certificate exchange and key
+ * agreement. The cache is written to RTC slow memory before deep sleep and
+ * mirrored to LittleFS every few wakes so that sessions also survive a
+ * power loss, which clears RTC memory. It holds a few entries, evicting the least recently
+ * used one when full and dropping entries older than the configured age.
+ * Handshake timings are recorded here too, so full and resumed handshakes
+ * can be compared per wake.
+ */
+
+#ifndef TLS_SESSION_CACHE_H
+#define TLS_SESSION_CACHE_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#include "../test/mock_littlefs.h"
+#else
+#include <Arduino.h>
+#include <LittleFS.h>
+#endif
+
+#include <mutex>
+#include <vector>
+
+#include "config.h"
+
+class TlsSessionCache {
+  public:
+    /**
+     * @param maxEntries Sessions kept; the least recently used is evicted beyond this
+     * @param maxAge     Seconds after which a stored session is dropped
+     */
+    explicit TlsSessionCache(size_t maxEntries = TLS_SESSION_CACHE_ENTRIES,
+        uint32_t maxAge = TLS_SESSION_MAX_AGE_SECONDS);
+
+    /** @brief Cache key of a server */
+    static String makeKey(const char* host, uint16_t port);
+
+    /**
+     * @brief Store (or replace) the session of a server
+     *
+     * Storing the bytes already held only marks the session as used. A
+     * resumed session keeps the time of the full handshake that created it,
+     * so resuming does not postpone its expiry.
+     *
+     * @param now     Current Unix time, used for expiry
+     * @param resumed The session came from an abbreviated handshake
+     * @return false if the session is empty or larger than TLS_SESSION_MAX_BYTES
+     */
+    bool store(const String& key, const uint8_t* data, size_t length, uint32_t now, bool resumed = false);
+
+    /**
+     * @brief Copy the session of a server into buffer
+     *
+     * Expired sessions are dropped instead of returned.
+     *
+     * @return Session length, or 0 if there is none (or it does not fit in capacity)
+     */
+    size_t lookup(const String& key, uint8_t* buffer, size_t capacity, uint32_t now);
+
+    /** @brief Forget the session of a server (e.g. one the TLS library rejected) */
+    bool remove(const String& key);
+
+    void clear();
+    size_t size() const;
+
+    /** @brief Sessions changed since the LittleFS copy was last written */
+    bool isDirty() const;
+
+    // Persistence
+    /**
+     * @brief Restore the sessions of the previous wake
+     *
+     * Reads the RTC memory image; LittleFS is read when that image is
+     * missing (power-on) or could not hold every session.
+     *
+     * @return true if any session was restored
+     */
+    bool load(uint32_t now, const char* path = TLS_SESSION_FILE);
+
+    /**
+     * @brief Keep the sessions for the next wake
+     *
+     * Always writes the RTC memory image. The LittleFS copy is rewritten
+     * only when the sessions changed, and then once TLS_SESSION_FLUSH_WAKES
+     * wakes have passed with changes it does not hold, to spare the flash;
+     * sessions that do not fit in RTC memory are written at once.
+     *
+     * @return false if the LittleFS copy was due but could not be written
+     */
+    bool save(const char* path = TLS_SESSION_FILE);
+
+    /** @brief Write the LittleFS copy now */
+    bool flush(const char* path = TLS_SESSION_FILE);
+
+    /** @brief Invalidate the RTC memory image, as a power loss would */
+    static void clearRtcImage();
+
+    /**
+     * @brief Serialize the sessions, most recently used first
+     *
+     * @param complete Set to false when not every session fit in capacity
+     * @return Bytes written (a header is always written if capacity allows it)
+     */
+    size_t serialize(uint8_t* buffer, size_t capacity, bool& complete) const;
+
+    /**
+     * @brief Add the sessions of a serialized image
+     *
+     * Sessions already in the cache are kept; expired ones are skipped.
+     *
+     * @param complete Set to whether the image held every session when written
+     * @return false if the image is malformed or fails its checksum
+     */
+    bool deserialize(const uint8_t* data, size_t length, uint32_t now, bool& complete);
+
+    // Handshake instrumentation
+    /** @brief Record one completed handshake */
+    void recordHandshake(bool resumed, unsigned long durationMs);
+    size_t getFullHandshakeCount() const;
+    unsigned long getFullHandshakeMs() const;
+    size_t getResumedHandshakeCount() const;
+    unsigned long getResumedHandshakeMs() const;
+
+  private:
+    struct Entry {
+        String key;
+        std::vector<uint8_t> data;
+        uint32_t savedAt;  // Unix time the session was stored
+        uint32_t lastUse;  // Value of useCounter at the last store/lookup
+    };
+
+    struct __attribute__((packed)) ImageHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t count;
+        uint16_t flags;
+        uint16_t reserved;
+        uint32_t payloadLength;
+        uint32_t checksum; // CRC32 of the payload
+    };
+
+    static const uint16_t FLAG_COMPLETE = 0x01;
+
+    // Callers hold the mutex
+    int find(const String& key) const;
+    bool isExpired(const Entry& entry, uint32_t now) const;
+    void dropExpired(uint32_t now);
+    bool loadFile(const char* path, uint32_t now);
+
+    size_t maxEntries;
+    uint32_t maxAge;
+    std::vector<Entry> entries;
+    uint32_t useCounter;
+    bool dirty;
+    mutable std::mutex mutex;
+
+    size_t fullCount;
+    unsigned long fullMs;
+    size_t resumedCount;
+    unsigned long resumedMs;
+};
+
+#endif // TLS_SESSION_CACHE_H
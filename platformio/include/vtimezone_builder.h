@@ -0,0 +1,85 @@
+/**
+ * Incremental compiler for ICS VTIMEZONE components
+ *
+ * Fed one unfolded content line at a time while the stream parser walks the
+ * calendar header, it keeps only the current STANDARD and DAYLIGHT rules and
+ * turns them into an equivalent POSIX TZ string that CompiledTimeZone can
+ * compile. This covers IANA zones as well as the custom TZIDs used by
+ * Outlook and Exchange ("W. Europe Standard Time").
+ */
+
+#ifndef VTIMEZONE_BUILDER_H
+#define VTIMEZONE_BUILDER_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include "ics_line_reader.h"
+#include <cstdint>
+
+class VTimezoneBuilder {
+  public:
+    VTimezoneBuilder();
+
+    /** @brief Start a new VTIMEZONE (call after BEGIN:VTIMEZONE) */
+    void begin();
+
+    /**
+     * @brief Feed the next content line of the VTIMEZONE block
+     *
+     * @param line Line view (unfolded, without terminator)
+     * @param length Line length
+     * @return true once END:VTIMEZONE has been consumed
+     */
+    bool addLine(const char* line, size_t length);
+
+    /** @brief TZID of the component */
+    const String& getTzid() const { return tzid; }
+
+    /**
+     * @brief Express the current rules as a POSIX TZ string
+     *
+     * Uses the most recent open-ended STANDARD/DAYLIGHT observances. Rules
+     * that POSIX cannot express (e.g. BYDAY=-2SU) make this fail, and the
+     * caller should fall back to the static IANA map.
+     *
+     * @param posix Output: POSIX TZ string, e.g. "STD-1DST-2,M3.5.0/2,M10.5.0/3"
+     * @return true if the rules could be converted
+     */
+    bool toPosix(String& posix) const;
+
+  private:
+    /** One STANDARD or DAYLIGHT observance */
+    struct Observance {
+        bool present;
+        bool recurring;      // Has an RRULE without UNTIL
+        int32_t offsetTo;    // Seconds east of UTC after the transition
+        char dtstart[16];    // Local DTSTART (YYYYMMDDTHHMMSS)
+        int16_t month;       // BYMONTH (1-12)
+        int16_t week;        // 1-5 (5 = last), 0 = fixed day of month
+        int16_t weekday;     // 0 = Sunday, -1 = none
+        int16_t monthDay;    // Fixed day of month when week == 0
+        bool ruleOk;         // RRULE could be expressed as a POSIX rule
+    };
+
+    void resetObservance(Observance& observance);
+    void applyProperty(const IcsProperty& property);
+    void parseRRule(const char* value, size_t length, Observance& observance);
+    void commitObservance();
+
+    static bool parseOffset(const char* value, size_t length, int32_t& seconds);
+    static void appendOffset(String& out, int32_t eastSeconds);
+    static bool appendRule(String& out, const Observance& observance);
+
+    String tzid;
+    int depth;              // 1 inside VTIMEZONE, 2 inside STANDARD/DAYLIGHT
+    bool currentIsDaylight;
+    Observance current;
+    Observance standard;
+    Observance daylight;
+};
+
+#endif // VTIMEZONE_BUILDER_H
@@ -6,40 +6,8 @@
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
-#include <vector>
 
-/**
- * @brief Weather forecast data for a single day
- *
- * Contains all weather information for one day including temperature range,
- * weather conditions, sunrise/sunset times, and precipitation probability.
- * Used by Open-Meteo weather API integration.
- */
-struct WeatherDay {
-    String date;                  ///< ISO format date (YYYY-MM-DD)
-    int weatherCode;              ///< WMO weather code (0-99)
-    float tempMax;                ///< Maximum temperature in degrees Celsius
-    float tempMin;                ///< Minimum temperature in degrees Celsius
-    String sunrise;               ///< Sunrise time in ISO format (YYYY-MM-DDTHH:MM)
-    String sunset;                ///< Sunset time in ISO format (YYYY-MM-DDTHH:MM)
-    int precipitationProbability; ///< Max precipitation probability for the day (0-100%)
-};
-
-/**
- * @brief Complete weather data structure
- *
- * Contains current weather conditions and daily forecast for the next 3 days.
- * Populated by WeatherClient::fetchWeather() from Open-Meteo API.
- */
-struct WeatherData {
-    // Current weather
-    float currentTemp;      ///< Current temperature in degrees Celsius
-    int currentWeatherCode; ///< Current WMO weather code
-    bool isDay;             ///< True if currently daytime (for icon selection)
-
-    // Daily forecast (next 3 days)
-    std::vector<WeatherDay> dailyForecast; ///< Vector of daily forecasts (today + 2 days)
-};
+#include "weather_parser.h"
 
 /**
  * @brief Client for fetching weather data from Open-Meteo API
@@ -77,18 +45,6 @@ class WeatherClient {
      */
     const char* getWeatherIcon(int weatherCode, bool isDay = true);
 
-    /**
-     * @brief Parse JSON response from Open-Meteo API
-     *
-     * Parses the JSON response and populates WeatherData structure with
-     * current conditions and daily forecasts.
-     *
-     * @param jsonData Raw JSON string from API response
-     * @param data Output WeatherData structure to populate
-     * @return true if parsing succeeded
-     */
-    bool parseWeatherData(const String& jsonData, WeatherData& data);
-
     /**
      * @brief Build complete API URL with coordinates
      *
@@ -121,9 +77,9 @@ class WeatherClient {
     /**
      * @brief Fetch weather data from Open-Meteo API
      *
-     * Makes HTTPS request to Open-Meteo API and parses the response.
-     * Populates the provided WeatherData structure with current conditions
-     * and 3-day forecast.
+     * Makes HTTPS request to Open-Meteo API and parses the response as it
+     * arrives (see WeatherParser). Populates the provided WeatherData
+     * structure with current conditions and 3-day forecast.
      *
      * @param data Output WeatherData structure to populate
      * @return true if fetch and parse succeeded
@@ -0,0 +1,89 @@
+/**
+ * Streaming parser for Open-Meteo forecast responses
+ *
+ * The response is deserialized straight from the HTTP stream through an
+ * ArduinoJson filter that keeps only the fields WeatherData needs (current
+ * conditions and the daily arrays). Coordinates, units and anything else
+ * Open-Meteo sends are skipped while reading, so neither the body nor the
+ * unused parts of the document are ever held in memory.
+ */
+
+#ifndef WEATHER_PARSER_H
+#define WEATHER_PARSER_H
+
+#ifdef NATIVE_TEST
+#include "../test/mock_arduino.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <ArduinoJson.h>
+#include <vector>
+
+/**
+ * @brief Weather forecast data for a single day
+ *
+ * Contains all weather information for one day including temperature range,
+ * weather conditions, sunrise/sunset times, and precipitation probability.
+ * Used by Open-Meteo weather API integration.
+ */
+struct WeatherDay {
+    String date;                  ///< ISO format date (YYYY-MM-DD)
+    int weatherCode;              ///< WMO weather code (0-99)
+    float tempMax;                ///< Maximum temperature in degrees Celsius
+    float tempMin;                ///< Minimum temperature in degrees Celsius
+    String sunrise;               ///< Sunrise time in ISO format (YYYY-MM-DDTHH:MM)
+    String sunset;                ///< Sunset time in ISO format (YYYY-MM-DDTHH:MM)
+    int precipitationProbability; ///< Max precipitation probability for the day (0-100%)
+};
+
+/**
+ * @brief Complete weather data structure
+ *
+ * Contains current weather conditions and daily forecast for the next 3 days.
+ * Populated by WeatherClient::fetchWeather() from Open-Meteo API.
+ */
+struct WeatherData {
+    // Current weather
+    float currentTemp;      ///< Current temperature in degrees Celsius
+    int currentWeatherCode; ///< Current WMO weather code
+    bool isDay;             ///< True if currently daytime (for icon selection)
+
+    // Daily forecast (next 3 days)
+    std::vector<WeatherDay> dailyForecast; ///< Vector of daily forecasts (today + 2 days)
+};
+
+class WeatherParser {
+  public:
+    static const size_t MAX_FORECAST_DAYS = 3; ///< Daily entries kept from the response
+
+    /**
+     * @brief Parse an Open-Meteo response from a stream
+     *
+     * @param input Response body; read until the JSON document is complete
+     * @param data Output WeatherData structure to populate
+     * @return true if the response was valid JSON
+     */
+    static bool parse(Stream& input, WeatherData& data);
+
+    /**
+     * @brief Same as parse(), with the JSON documents allocated from allocator
+     *
+     * @param input Response body; read until the JSON document is complete
+     * @param data Output WeatherData structure to populate
+     * @param allocator Heap used for the filter and the document (e.g. to measure it)
+     * @return true if the response was valid JSON
+     */
+    static bool parse(Stream& input, WeatherData& data, ArduinoJson::Allocator* allocator);
+
+    /**
+     * @brief Fill a filter document with the fields parse() keeps
+     * @param filter Empty document to fill
+     */
+    static void buildFilter(JsonDocument& filter);
+
+  private:
+    static bool parseDocument(Stream& input, WeatherData& data, JsonDocument& doc, JsonDocument& filter);
+};
+
+#endif // WEATHER_PARSER_H
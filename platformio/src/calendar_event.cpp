@@ -1,8 +1,7 @@
 #include "calendar_event.h"
 #include "date_utils.h"
-#include "timezone_map.h"
+#include "timezone_engine.h"
 #include <cstdio>
-#include <cstdlib> // for setenv, getenv
 #include <cstring>
 
 CalendarEvent::CalendarEvent() { clear(); }
@@ -55,7 +54,8 @@ bool CalendarEvent::isValid() const {
     return !uid.isEmpty() && startTime > 0;
 }
 
-bool CalendarEvent::setStartDateTime(const String& value, const String& tzid, bool isDate) {
+bool CalendarEvent::setStartDateTime(const String& value, const String& tzid, bool isDate,
+                                     const CompiledTimeZone* zone) {
     // Check if value ends with 'Z' (UTC indicator)
     bool hasZ = !value.isEmpty() && value.charAt(value.length() - 1) == 'Z';
 
@@ -63,7 +63,7 @@ bool CalendarEvent::setStartDateTime(const String& value, const String& tzid, bo
     allDay = isDate;
 
     // Parse the datetime
-    startTime = parseICSDateTime(value, tzid, isDate, hasZ);
+    startTime = parseICSDateTime(value, tzid, isDate, hasZ, zone);
 
     // Automatically populate the date field for backward compatibility
     if (startTime > 0) {
@@ -73,17 +73,25 @@ bool CalendarEvent::setStartDateTime(const String& value, const String& tzid, bo
     return startTime > 0;
 }
 
-bool CalendarEvent::setEndDateTime(const String& value, const String& tzid, bool isDate) {
+bool CalendarEvent::setEndDateTime(const String& value, const String& tzid, bool isDate,
+                                   const CompiledTimeZone* zone) {
     // Check if value ends with 'Z' (UTC indicator)
     bool hasZ = !value.isEmpty() && value.charAt(value.length() - 1) == 'Z';
 
     // Parse the datetime
-    endTime = parseICSDateTime(value, tzid, isDate, hasZ);
+    endTime = parseICSDateTime(value, tzid, isDate, hasZ, zone);
 
     return endTime > 0;
 }
 
-time_t CalendarEvent::parseICSDateTime(const String& value, const String& tzid, bool isDate, bool hasZ) const {
+time_t CalendarEvent::parseDateTimeValue(const String& value, const String& tzid, bool isDate,
+                                         const CompiledTimeZone* zone) {
+    bool hasZ = !value.isEmpty() && value.charAt(value.length() - 1) == 'Z';
+    return parseICSDateTime(value, tzid, isDate, hasZ, zone);
+}
+
+time_t CalendarEvent::parseICSDateTime(const String& value, const String& tzid, bool isDate, bool hasZ,
+                                       const CompiledTimeZone* zone) {
     // Parse ICS date/time format: YYYYMMDD[THHMMSS[Z]]
     // Supports 4 formats:
     //   1. DATE-TIME (UTC): "20251119T103000Z" (hasZ=true)
@@ -95,71 +103,60 @@ time_t CalendarEvent::parseICSDateTime(const String& value, const String& tzid,
         return 0; // Invalid format
     }
 
+    const char* digits = value.c_str();
+    for (int i = 0; i < 8; i++) {
+        if (digits[i] < '0' || digits[i] > '9') {
+            return 0; // Invalid format
+        }
+    }
+
     struct tm timeinfo;
     memset(&timeinfo, 0, sizeof(struct tm));
 
-    // Parse date components (YYYYMMDD)
-    String yearStr  = value.substring(0, 4);
-    String monthStr = value.substring(4, 6);
-    String dayStr   = value.substring(6, 8);
-
-    timeinfo.tm_year = yearStr.toInt() - 1900;
-    timeinfo.tm_mon  = monthStr.toInt() - 1;
-    timeinfo.tm_mday = dayStr.toInt();
-
-    // Parse time components if present (THHMMSS)
-    if (!isDate && value.length() >= 15 && value.charAt(8) == 'T') {
-        String hourStr = value.substring(9, 11);
-        String minStr  = value.substring(11, 13);
-        String secStr  = value.substring(13, 15);
-
-        timeinfo.tm_hour = hourStr.toInt();
-        timeinfo.tm_min  = minStr.toInt();
-        timeinfo.tm_sec  = secStr.toInt();
-    } else {
-        // All-day event or date-only: set time to midnight
-        timeinfo.tm_hour = 0;
-        timeinfo.tm_min  = 0;
-        timeinfo.tm_sec  = 0;
-    }
-
-    timeinfo.tm_isdst = -1; // Let mktime determine DST
+    // Parse date components (YYYYMMDD) without temporary substrings
+    timeinfo.tm_year = (digits[0] - '0') * 1000 + (digits[1] - '0') * 100 + (digits[2] - '0') * 10 +
+                       (digits[3] - '0') - 1900;
+    timeinfo.tm_mon  = (digits[4] - '0') * 10 + (digits[5] - '0') - 1;
+    timeinfo.tm_mday = (digits[6] - '0') * 10 + (digits[7] - '0');
 
-    // Save current timezone
-    char* oldTZ = getenv("TZ");
-    String savedTZ = oldTZ ? String(oldTZ) : "";
+    // Parse time components if present (THHMMSS); midnight otherwise
+    bool hasTime = !isDate && value.length() >= 15 && digits[8] == 'T';
+    for (int i = 9; hasTime && i < 15; i++) {
+        hasTime = digits[i] >= '0' && digits[i] <= '9';
+    }
+    if (hasTime) {
+        timeinfo.tm_hour = (digits[9] - '0') * 10 + (digits[10] - '0');
+        timeinfo.tm_min  = (digits[11] - '0') * 10 + (digits[12] - '0');
+        timeinfo.tm_sec  = (digits[13] - '0') * 10 + (digits[14] - '0');
+    }
 
-    time_t result = 0;
+    timeinfo.tm_isdst = -1; // Let the zone determine DST
 
     if (hasZ) {
         // Format 1: DATE-TIME (UTC) - "20251119T103000Z"
-        // Set timezone to UTC for parsing
-        setenv("TZ", "UTC0", 1);
-        tzset();
-        result = mktime(&timeinfo);
+        return TimeZoneEngine::makeUtc(timeinfo);
+    }
 
-    } else if (!tzid.isEmpty()) {
-        // Format 2: DATE-TIME (TZID) - "20251119T140000" with tzid="America/Los_Angeles"
-        // Set timezone to the specified TZID for parsing
-        setenv("TZ", tzid.c_str(), 1);
-        tzset();
-        result = mktime(&timeinfo);
-
-    } else {
-        // Format 3: DATE-TIME (Floating) or Format 4: DATE (All-Day)
-        // Use local timezone (don't change TZ)
-        result = mktime(&timeinfo);
+    if (zone) {
+        // Format 2 with the zone already resolved by the caller
+        return zone->toUtc(timeinfo);
     }
 
-    // Restore original timezone
-    if (!savedTZ.isEmpty()) {
-        setenv("TZ", savedTZ.c_str(), 1);
-    } else {
-        unsetenv("TZ");
+    if (!tzid.isEmpty()) {
+        // Format 2: DATE-TIME (TZID) - "20251119T140000" with tzid="America/Los_Angeles"
+        // Compiled once per TZID, then converted with plain arithmetic
+        zone = TimeZoneEngine::find(tzid);
+        if (zone) {
+            return zone->toUtc(timeinfo);
+        }
+
+        // Unknown TZID: let the C library try to interpret it
+        return TimeZoneEngine::makeInTz(tzid.c_str(), timeinfo);
     }
-    tzset();
 
-    return result;
+    // Format 3: DATE-TIME (Floating) or Format 4: DATE (All-Day)
+    // Use local timezone
+    return TimeZoneEngine::makeLocal(timeinfo);
 }
 
 String CalendarEvent::formatDate(time_t timestamp) const {
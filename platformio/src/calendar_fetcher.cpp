@@ -5,7 +5,16 @@
 CalendarFetcher::CalendarFetcher() :
     streamClient(nullptr),
     timeout(120000),
-    debug(false) { // Increased to 120 seconds for large calendars
+    debug(false),
+    lastHttpCode(0),
+    inflater(nullptr),
+    compression(true),
+    partialContent(false),
+    contentLength(-1),
+    pool(nullptr),
+    connection(nullptr),
+    body(nullptr),
+    keepAlive(false) { // Increased to 120 seconds for large calendars
     // Initialize HTTP client settings
     http.useHTTP10(true);
     http.setReuse(false);
@@ -228,8 +237,15 @@ bool CalendarFetcher::isCacheValid(const String& filename, unsigned long maxAgeS
     return (now - modTime) < maxAgeSeconds;
 }
 
-Stream* CalendarFetcher::fetchStream(const String& url) {
+Stream* CalendarFetcher::fetchStream(const String& url,
+                                     const HttpValidators* validators,
+                                     const FeedTail* resume) {
     endStream(); // Clean up any existing stream
+    lastHttpCode       = 0;
+    responseValidators = HttpValidators();
+    partialContent     = false;
+    contentLength      = -1;
+    timings            = FetchTimings();
 
     DEBUG_INFO_PRINTLN("=== Calendar Fetcher (Stream) ===");
     DEBUG_INFO_PRINTLN("Fetching stream from: " + url);
@@ -269,15 +285,37 @@ Stream* CalendarFetcher::fetchStream(const String& url) {
 
         int maxRetries = 3;
         int retries    = maxRetries;
+        String requestUrl     = url;
+        int redirects         = 0;
+        const FeedTail* range = resume && resume->isValid() ? resume : nullptr;
+        bool acceptCompressed = compression;
         while (retries > 0) {
             int attemptNum = maxRetries - retries + 1;
 
+            // Timings of this attempt; the failed ones before it count as retries
+            timings         = FetchTimings();
+            timings.retries = (uint8_t)(attemptNum - 1);
+
             // Start HTTP request directly (without explicit WiFiClient)
             DEBUG_INFO_PRINTF(
                 ">>> HTTP Fetch Attempt %d/%d for calendar\n", attemptNum, maxRetries);
             DEBUG_INFO_PRINTLN("Starting HTTP stream request...");
 
-            if (!http.begin(url)) {
+            // Pooled connections keep their own HTTPClient: it must stay bound
+            // to the socket it reuses for as long as the socket is open
+            HTTPClient* request = &http;
+            bool begun;
+            if (pool) {
+                connection = pool->acquire(requestUrl);
+                if (connection) {
+                    request = connection->http;
+                }
+                begun = connection && request->begin(*connection->client, requestUrl);
+            } else {
+                begun = request->begin(requestUrl);
+            }
+            if (!begun) {
+                releaseConnection(false);
                 DEBUG_ERROR_PRINTLN(">>> Attempt " + String(attemptNum) +
                                     " FAILED: Could not begin HTTP request");
                 retries--;
@@ -287,27 +325,66 @@ Stream* CalendarFetcher::fetchStream(const String& url) {
                 }
                 continue;
             }
+            if (connection) {
+                timings.reused = connection->requests > 1;
+                if (!timings.reused) {
+                    timings.dnsMs     = connection->dnsMs;
+                    timings.connectMs = connection->connectMs;
+                    timings.tlsMs     = connection->tlsMs;
+                }
+            }
 
-            http.setTimeout(timeout);
-            http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+            request->setTimeout(timeout);
+            // Keep-alive needs HTTP/1.1 (HttpBodyStream removes the chunked
+            // framing); redirects are followed below so that every hop
+            // borrows a connection to its own host
+            request->useHTTP10(!pool);
+            request->setReuse(pool != nullptr);
+            request->setFollowRedirects(pool ? HTTPC_DISABLE_FOLLOW_REDIRECTS
+                                         : HTTPC_STRICT_FOLLOW_REDIRECTS);
 
             // Add headers
-            http.addHeader("User-Agent", "ESP32-Calendar/1.0");
-            http.addHeader("Accept", "text/calendar");
+            request->addHeader("User-Agent", "ESP32-Calendar/1.0");
+            request->addHeader("Accept", "text/calendar");
+            // ICS compresses 5-10x
+            request->addHeader("Accept-Encoding", acceptCompressed ? "gzip, deflate" : "identity");
+            if (range) {
+                request->addHeader("Range", range->rangeHeader());
+            }
+
+            // Conditional request: let the server answer 304 if the feed is unchanged
+            if (validators) {
+                if (!validators->etag.isEmpty()) {
+                    request->addHeader("If-None-Match", validators->etag);
+                }
+                if (!validators->lastModified.isEmpty()) {
+                    request->addHeader("If-Modified-Since", validators->lastModified);
+                }
+            }
+            const char* responseHeaders[] = {"ETag",
+                                             "Last-Modified",
+                                             "Content-Encoding",
+                                             "Transfer-Encoding",
+                                             "Connection",
+                                             "Location",
+                                             "Content-Range"};
+            request->collectHeaders(responseHeaders, 7);
 
             // Perform GET request
             unsigned long requestStart    = millis();
-            int httpCode                  = http.GET();
+            int httpCode                  = request->GET();
             unsigned long requestDuration = millis() - requestStart;
+            timings.ttfbMs                = requestDuration;
 
             if (httpCode <= 0) {
                 DEBUG_ERROR_PRINTF(">>> Attempt %d FAILED: HTTP request failed (code: %d, error: "
                                    "%s, duration: %lums)\n",
                                    attemptNum,
                                    httpCode,
-                                   http.errorToString(httpCode).c_str(),
+                                   request->errorToString(httpCode).c_str(),
                                    requestDuration);
-                http.end();
+                request->end();
+                releaseConnection(false);
                 retries--;
                 if (retries > 0) {
                     DEBUG_INFO_PRINTLN(">>> Retrying in 5 seconds...");
@@ -320,10 +397,54 @@ Stream* CalendarFetcher::fetchStream(const String& url) {
                               attemptNum,
                               httpCode,
                               requestDuration);
+            lastHttpCode = httpCode;
+
+            String connectionHeader = request->header("Connection");
+            connectionHeader.toLowerCase();
+            keepAlive = connectionHeader.indexOf("close") < 0;
+
+            if (httpCode == HTTP_CODE_NOT_MODIFIED) {
+                DEBUG_INFO_PRINTLN(">>> Calendar not modified since last fetch");
+                request->end();
+                releaseConnection(keepAlive); // A 304 has no body
+                return nullptr;
+            }
+
+            if (pool && (httpCode == HTTP_CODE_MOVED_PERMANENTLY || httpCode == HTTP_CODE_FOUND ||
+                            httpCode == HTTP_CODE_SEE_OTHER ||
+                            httpCode == HTTP_CODE_TEMPORARY_REDIRECT ||
+                            httpCode == HTTP_CODE_PERMANENT_REDIRECT)) {
+                String location = request->header("Location");
+                request->end();
+                releaseConnection(false);
+                if (location.isEmpty() || ++redirects > HTTP_MAX_REDIRECTS) {
+                    DEBUG_ERROR_PRINTF(">>> Attempt %d FAILED: Unusable redirect (%d)\n", attemptNum, httpCode);
+                    return nullptr;
+                }
+                if (location.startsWith("/")) {
+                    // Relative to the current origin
+                    int pathStart = requestUrl.indexOf('/', requestUrl.indexOf("://") + 3);
+                    location = (pathStart < 0 ? requestUrl : requestUrl.substring(0, pathStart)) + location;
+                }
+                DEBUG_INFO_PRINTLN(">>> Redirected to " + location);
+                requestUrl = location;
+                continue;
+            }
+
+            if (range && httpCode == HTTP_CODE_RANGE_NOT_SATISFIABLE) {
+                // The feed is shorter than at the last download: not just appended to
+                DEBUG_INFO_PRINTLN(">>> Saved feed tail is past the end, fetching the full calendar");
+                request->end();
+                releaseConnection(false);
+                range = nullptr;
+                continue;
+            }
 
-            if (httpCode != HTTP_CODE_OK) {
+            bool partial = range && httpCode == HTTP_CODE_PARTIAL_CONTENT;
+            if (httpCode != HTTP_CODE_OK && !partial) {
                 DEBUG_ERROR_PRINTF(">>> Attempt %d FAILED: HTTP error %d\n", attemptNum, httpCode);
-                http.end();
+                request->end();
+                releaseConnection(false);
                 retries--;
                 if (retries > 0) {
                     DEBUG_INFO_PRINTLN(">>> Retrying in 5 seconds...");
@@ -333,11 +454,12 @@ Stream* CalendarFetcher::fetchStream(const String& url) {
             }
 
             // Get the stream
-            Stream* stream = http.getStreamPtr();
+            Stream* stream = request->getStreamPtr();
             if (!stream) {
                 DEBUG_ERROR_PRINTF(">>> Attempt %d FAILED: Could not get HTTP stream pointer\n",
                                    attemptNum);
-                http.end();
+                request->end();
+                releaseConnection(false);
                 retries--;
                 if (retries > 0) {
                     DEBUG_INFO_PRINTLN(">>> Retrying in 5 seconds...");
@@ -345,9 +467,13 @@ Stream* CalendarFetcher::fetchStream(const String& url) {
                 }
                 continue;
             }
+            // Body reads block until data arrives, for at most this long
+            stream->setTimeout(CALENDAR_STREAM_READ_TIMEOUT_MS);
+
+            responseValidators.etag         = request->header("ETag");
+            responseValidators.lastModified = request->header("Last-Modified");
 
-            // Get content length for debugging
-            int contentLength = http.getSize();
+            contentLength = request->getSize();
             if (contentLength >= 0) {
                 DEBUG_INFO_PRINTF(
                     ">>> Attempt %d SUCCESS: HTTP stream opened (Content-Length: %d bytes)\n",
@@ -359,6 +485,62 @@ Stream* CalendarFetcher::fetchStream(const String& url) {
                     attemptNum);
             }
 
+            if (connection) {
+                String transferEncoding = request->header("Transfer-Encoding");
+                transferEncoding.toLowerCase();
+                body   = new HttpBodyStream(
+                    stream, contentLength, transferEncoding.indexOf("chunked") >= 0);
+                stream = body;
+            }
+
+            String contentEncoding = request->header("Content-Encoding");
+
+            // A partial body continues the cached feed only if it starts with
+            // the same anchor bytes; anything else means the feed was edited
+            if (partial) {
+                size_t first = 0;
+                size_t total = 0;
+                bool resumable =
+                    (contentEncoding.isEmpty() || contentEncoding == "identity") &&
+                    FeedTail::parseContentRange(request->header("Content-Range"), first, total) &&
+                    first == range->rangeStart() && (total == 0 || total >= range->length) &&
+                    range->matchesAnchor(stream);
+                if (!resumable) {
+                    DEBUG_INFO_PRINTLN(">>> Feed changed before the saved tail, fetching the full calendar");
+                    endStream();
+                    range = nullptr;
+                    continue;
+                }
+                partialContent = true;
+                DEBUG_INFO_PRINTLN(">>> Feed only appended to, resuming after byte " +
+                                   String((unsigned long)range->offset));
+                return stream;
+            }
+
+            InflateStream::Format format;
+            if (InflateStream::formatForEncoding(contentEncoding, format)) {
+                inflater = new InflateStream(stream, format);
+                if (!inflater->isValid()) {
+                    endStream();
+                    if (!acceptCompressed) {
+                        DEBUG_ERROR_PRINTLN(">>> Not enough memory to decode " + contentEncoding);
+                        return nullptr;
+                    }
+                    // No room for the 32 KB window: ask for the plain body instead
+                    DEBUG_WARN_PRINTLN(">>> Not enough memory to decode " + contentEncoding +
+                                       ", fetching the calendar uncompressed");
+                    acceptCompressed = false;
+                    continue;
+                }
+                DEBUG_INFO_PRINTLN(">>> Decoding Content-Encoding: " + contentEncoding);
+                return inflater;
+            }
+            if (!contentEncoding.isEmpty() && contentEncoding != "identity") {
+                DEBUG_ERROR_PRINTLN(">>> Unsupported Content-Encoding: " + contentEncoding);
+                endStream();
+                return nullptr;
+            }
+
             return stream; // Success
         }
 
@@ -368,6 +550,19 @@ Stream* CalendarFetcher::fetchStream(const String& url) {
 }
 
 void CalendarFetcher::endStream() {
+    delete inflater;
+    inflater = nullptr;
+
+    // Hand the connection back for the next request if its body was read to
+    // the end (a short unread tail is discarded rather than reconnecting)
+    if (connection) {
+        bool reusable = keepAlive && body && body->drain(HTTP_POOL_DRAIN_LIMIT);
+        connection->http->end();
+        releaseConnection(reusable);
+    }
+    delete body;
+    body = nullptr;
+
     // Close file stream if open
     if (fileStream) {
         fileStream.close();
@@ -386,4 +581,22 @@ void CalendarFetcher::endStream() {
         delete streamClient;
         streamClient = nullptr;
     }
-}
\ No newline at end of file
+}
+
+void CalendarFetcher::releaseConnection(bool reusable) {
+    if (!connection) {
+        return;
+    }
+    if (!reusable) {
+        connection->client->stop();
+    }
+    pool->release(connection, reusable);
+    connection = nullptr;
+}
+
+const char* CalendarFetcher::getStreamError() const {
+    if (inflater && inflater->hasError()) {
+        return inflater->getError();
+    }
+    return body ? body->getError() : nullptr;
+}
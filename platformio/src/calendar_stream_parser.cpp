@@ -3,6 +3,9 @@
  */
 
 #include "calendar_stream_parser.h"
+#include "ics_line_reader.h"
+#include "timezone_engine.h"
+#include "vtimezone_builder.h"
 
 #ifdef NATIVE_TEST
 // Mock dependencies for native testing
@@ -37,32 +40,151 @@ inline const char* str_helper(const char* s) { return s; }
         printf("[ERROR] %s\n", _s.c_str()); \
     } while (0)
 
-// Stub TeeStream - not needed for recurring event tests
-class TeeStream : public Stream {
-public:
-    TeeStream(Stream& s1, Stream& s2) { }
-    TeeStream(Stream& s1, File& f2) { } // Also accept File for cache writing
-    int available() { return 0; }
-    int read() { return -1; }
-    int peek() { return -1; }
-    size_t write(uint8_t) { return 0; }
-    String readString() { return ""; }
-};
-
 #else
 #include "calendar_fetcher.h"
 #include "debug_config.h"
-// TeeStream no longer needed - we download first, then parse
 #endif
 
 #include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+const int CalendarStreamParser::MAX_OCCURRENCES_PER_QUERY;
+
+// Event properties handled by parseEventFromBuffer()
+enum EventProperty {
+    PROP_UNKNOWN,
+    PROP_BEGIN,
+    PROP_END,
+    PROP_UID,
+    PROP_SUMMARY,
+    PROP_DESCRIPTION,
+    PROP_STATUS,
+    PROP_RRULE,
+    PROP_DTSTART,
+    PROP_DTEND,
+    PROP_EXDATE,
+    PROP_RECURRENCE_ID
+};
+
+// Map a property name to its id: switch on length, then one memcmp
+static EventProperty classifyEventProperty(const char* name, size_t length)
+{
+    switch (length) {
+    case 3:
+        if (memcmp(name, "UID", 3) == 0)
+            return PROP_UID;
+        if (memcmp(name, "END", 3) == 0)
+            return PROP_END;
+        break;
+    case 5:
+        if (memcmp(name, "BEGIN", 5) == 0)
+            return PROP_BEGIN;
+        if (memcmp(name, "DTEND", 5) == 0)
+            return PROP_DTEND;
+        if (memcmp(name, "RRULE", 5) == 0)
+            return PROP_RRULE;
+        break;
+    case 6:
+        if (memcmp(name, "STATUS", 6) == 0)
+            return PROP_STATUS;
+        if (memcmp(name, "EXDATE", 6) == 0)
+            return PROP_EXDATE;
+        break;
+    case 7:
+        if (memcmp(name, "DTSTART", 7) == 0)
+            return PROP_DTSTART;
+        if (memcmp(name, "SUMMARY", 7) == 0)
+            return PROP_SUMMARY;
+        break;
+    case 11:
+        if (memcmp(name, "DESCRIPTION", 11) == 0)
+            return PROP_DESCRIPTION;
+        break;
+    case 13:
+        if (memcmp(name, "RECURRENCE-ID", 13) == 0)
+            return PROP_RECURRENCE_ID;
+        break;
+    }
+    return PROP_UNKNOWN;
+}
+
+// Copy a property value into a trimmed String
+static String propertyValue(const IcsProperty& property)
+{
+    String value;
+    value.concat(property.value, property.valueLength);
+    value.trim();
+    return value;
+}
+
+// Extract value, TZID and VALUE=DATE from a DTSTART/DTEND property
+static void parseDateTimeProperty(const IcsProperty& property, String& value, String& tzid, bool& isDate)
+{
+    value = propertyValue(property);
+
+    const char* param = nullptr;
+    size_t paramLength = 0;
+    tzid = "";
+    if (IcsLineReader::findParameter(property, "TZID", param, paramLength)) {
+        tzid.concat(param, paramLength);
+        tzid.trim();
+    }
+
+    isDate = IcsLineReader::findParameter(property, "VALUE", param, paramLength) && paramLength == 4 &&
+             memcmp(param, "DATE", 4) == 0;
+
+    // Date-only value without an explicit VALUE=DATE (YYYYMMDD)
+    if (!isDate && tzid.isEmpty() && value.length() == 8) {
+        isDate = true;
+    }
+}
+
+// Cheap range check on the VEVENT being streamed, made from its DTSTART and
+// DTEND lines before the block is buffered in full. A block without RRULE or
+// RECURRENCE-ID whose range is already known to miss the query is skipped.
+struct EventPrefilter {
+    int depth;       // 1 inside the VEVENT, >1 inside VALARM and other sub-components
+    bool recurrence; // RRULE or RECURRENCE-ID seen: the block is always parsed
+    bool skipping;   // Known out of range: only lines needed to recover are buffered
+    time_t start;    // 0 until DTSTART is seen (or if it does not parse)
+    time_t end;      // -1 until DTEND is seen
+
+    void reset()
+    {
+        depth = 1;
+        recurrence = false;
+        skipping = false;
+        start = 0;
+        end = -1;
+    }
+
+    // Same test as isEventInRange(); with complete = false a missing DTEND
+    // may still follow, so only a start after the range is conclusive
+    bool outOfRange(time_t startDate, time_t endDate, bool complete) const
+    {
+        if (recurrence || start <= 0) {
+            return false;
+        }
+        if (start > endDate) {
+            return true;
+        }
+        if (end < 0 && !complete) {
+            return false;
+        }
+        time_t eventEnd = end > 0 ? end : start;
+        return eventEnd < startDate;
+    }
+};
 
 static time_t addLocalDaysPreservingClock(time_t base, int dayOffset)
 {
-    struct tm local = *localtime(&base);
+    struct tm local;
+    TimeZoneEngine::localTime(base, local);
     local.tm_mday += dayOffset;
     local.tm_isdst = -1;
-    return mktime(&local);
+    return TimeZoneEngine::makeLocal(local);
 }
 
 static std::vector<CalendarEvent*> expandMultiDayNonRecurringEvent(CalendarEvent* event)
@@ -113,34 +235,22 @@ static std::vector<CalendarEvent*> expandMultiDayNonRecurringEvent(CalendarEvent
     return expanded;
 }
 
-// Helper function for portable timegm (converts tm in UTC to time_t)
-static time_t portable_timegm(struct tm* tm)
-{
-#ifndef ARDUINO
-    // POSIX systems (including test environment) have timegm
-    return timegm(tm);
-#else
-    // On Arduino/ESP32, temporarily set timezone to UTC
-    char* oldTZ = getenv("TZ");
-    String savedTZ = oldTZ ? String(oldTZ) : "";
-    setenv("TZ", "UTC0", 1);
-    tzset();
-    time_t result = mktime(tm);
-    if (!savedTZ.isEmpty()) {
-        setenv("TZ", savedTZ.c_str(), 1);
-    } else {
-        unsetenv("TZ");
-    }
-    tzset();
-    return result;
-#endif
-}
-
 // Constructor
 CalendarStreamParser::CalendarStreamParser()
     : debug(false)
+    , skipAhead(true)
+    , incremental(false)
     , calendarColor(0)
     , fetcher(nullptr)
+    , lastNotModified(false)
+    , lastBytesTransferred(0)
+    , lastPartial(false)
+    , spoolMinBytes(0)
+    , spoolFailed(false)
+    , lastSpooled(false)
+    , spoolEncoded(false)
+    , lastDownloadMs(0)
+    , overridesIndexed(false)
 {
     fetcher = new CalendarFetcher();
     fetcher->setDebug(debug);
@@ -154,31 +264,50 @@ CalendarStreamParser::~CalendarStreamParser()
     }
 }
 
-FilteredEvents* CalendarStreamParser::fetchEventsInRange(const String& url,
-    time_t startDate,
-    time_t endDate,
-    size_t maxEvents,
-    const String& cachePath)
+void CalendarStreamParser::setConnectionPool(ConnectionPool* pool)
 {
-    FilteredEvents* result = new FilteredEvents();
+    fetcher->setConnectionPool(pool);
+}
 
-    DEBUG_INFO_PRINTLN("=== Stream Parsing Calendar ===");
-    DEBUG_INFO_PRINTLN("URL: " + url);
-    DEBUG_INFO_PRINTLN("Date range: " + String(startDate) + " to " + String(endDate));
-    DEBUG_INFO_PRINTLN("Max events: " + String((unsigned long)maxEvents));
+void CalendarStreamParser::setIncremental(bool enable)
+{
+    incremental = enable;
+    // Range offsets are only meaningful for bodies sent as they are stored
+    fetcher->setCompression(!enable);
+}
+
+void CalendarStreamParser::setSpool(const String& path, size_t minBytes)
+{
+    spoolPath = path;
+    spoolMinBytes = minBytes;
+    spoolFailed = false;
+}
 
-    auto eventCallback = [&](CalendarEvent* event) {
+// Collect parsed events into result, up to maxEvents (0 = no limit)
+static EventCallback collectEvents(FilteredEvents* result, size_t maxEvents)
+{
+    return [result, maxEvents](CalendarEvent* event) {
         if (result->events.size() < maxEvents || maxEvents == 0) {
             result->events.push_back(event);
         } else {
             delete event; // Free memory if maxEvents is reached
         }
     };
+}
 
-    if (streamParse(url, eventCallback, startDate, endDate, cachePath)) {
+void CalendarStreamParser::finishResult(FilteredEvents* result, bool success)
+{
+    result->timings = lastTimings;
+    if (success) {
         result->success = true;
+        result->notModified = lastNotModified;
+        result->validators = lastValidators;
         result->totalFiltered = result->events.size();
-        // totalParsed is not easily available here, would require another callback
+        result->totalParsed = lastStats.eventsParsed;
+        result->bytesTransferred = lastBytesTransferred;
+        result->partial = lastPartial;
+        result->tail = lastTail;
+        result->spooled = lastSpooled;
     } else {
         result->success = false;
         result->error = "Stream parsing failed";
@@ -190,38 +319,151 @@ FilteredEvents* CalendarStreamParser::fetchEventsInRange(const String& url,
     });
 
     DEBUG_INFO_PRINTLN("Parsing complete: " + String((unsigned long)result->totalFiltered) + " events filtered");
+}
+
+FilteredEvents* CalendarStreamParser::fetchEventsInRange(const String& url,
+    time_t startDate,
+    time_t endDate,
+    size_t maxEvents,
+    const String& cachePath,
+    const HttpValidators* validators,
+    const FeedTail* resume)
+{
+    FilteredEvents* result = new FilteredEvents();
+
+    DEBUG_INFO_PRINTLN("=== Stream Parsing Calendar ===");
+    DEBUG_INFO_PRINTLN("URL: " + url);
+    DEBUG_INFO_PRINTLN("Date range: " + String(startDate) + " to " + String(endDate));
+    DEBUG_INFO_PRINTLN("Max events: " + String((unsigned long)maxEvents));
+
+    bool success = streamParse(url, collectEvents(result, maxEvents), startDate, endDate, cachePath, validators, resume);
+    finishResult(result, success);
+    return result;
+}
+
+FilteredEvents* CalendarStreamParser::parseSpooledEvents(time_t startDate, time_t endDate, size_t maxEvents)
+{
+    FilteredEvents* result = new FilteredEvents();
+
+    DEBUG_INFO_PRINTLN("=== Parsing Spooled Calendar ===");
+    DEBUG_INFO_PRINTLN("Spool file: " + spoolPath);
+
+    bool success = streamParseSpool(collectEvents(result, maxEvents), startDate, endDate);
+    finishResult(result, success);
     return result;
 }
 
+void CalendarStreamParser::indexOverrides(Stream* body)
+{
+    resetCalendarZones();
+    overrideIndex.clear();
+
+    IcsLineReader reader(body);
+    VTimezoneBuilder timezoneBuilder;
+    const char* line = nullptr;
+    size_t lineLength = 0;
+    bool inTimezone = false;
+    int depth = 0; // Component nesting, 1 inside a VEVENT
+    String uid, recurrenceId, recurrenceIdTZID;
+    bool recurrenceIdIsDate = false;
+
+    while (reader.next(line, lineLength)) {
+        if (inTimezone) {
+            // RECURRENCE-ID TZIDs must resolve as they will in the real parse
+            if (timezoneBuilder.addLine(line, lineLength)) {
+                String posix;
+                if (timezoneBuilder.toPosix(posix)) {
+                    addCalendarZone(timezoneBuilder.getTzid(), posix);
+                }
+                inTimezone = false;
+            }
+            continue;
+        }
+
+        if (depth == 0) {
+            if (IcsLineReader::startsWith(line, lineLength, "BEGIN:VEVENT")) {
+                depth = 1;
+                uid = "";
+                recurrenceId = "";
+            } else if (IcsLineReader::startsWith(line, lineLength, "BEGIN:VTIMEZONE")) {
+                timezoneBuilder.begin();
+                inTimezone = true;
+            }
+            continue;
+        }
+
+        IcsProperty property;
+        if (!IcsLineReader::splitProperty(line, lineLength, property)) {
+            continue;
+        }
+
+        EventProperty id = classifyEventProperty(property.name, property.nameLength);
+        if (id == PROP_BEGIN) {
+            depth++;
+        } else if (id == PROP_END) {
+            depth--;
+            if (depth == 0 && !recurrenceId.isEmpty()) {
+                const CompiledTimeZone* zone = recurrenceIdTZID.isEmpty() ? nullptr : resolveZone(recurrenceIdTZID);
+                time_t instance = CalendarEvent::parseDateTimeValue(recurrenceId, recurrenceIdTZID, recurrenceIdIsDate, zone);
+                if (instance > 0) {
+                    overrideIndex.add(uid, instance, RecurrenceOverrideIndex::OVERRIDDEN);
+                }
+            }
+        } else if (depth == 1 && id == PROP_UID) {
+            uid = propertyValue(property);
+        } else if (depth == 1 && id == PROP_RECURRENCE_ID) {
+            parseDateTimeProperty(property, recurrenceId, recurrenceIdTZID, recurrenceIdIsDate);
+        }
+    }
+
+    overridesIndexed = true;
+    DEBUG_VERBOSE_PRINTLN(">>> Override pre-pass: " + String((unsigned long)overrideIndex.size()) + " instances in " + String((unsigned long)reader.getBytesRead()) + " bytes");
+}
+
 bool CalendarStreamParser::streamParseFromStream(Stream* stream,
     EventCallback callback,
     time_t startDate,
     time_t endDate)
 {
+    // With the overrides known up front, masters need not wait for the end
+    bool preindexed = overridesIndexed;
+    overridesIndexed = false;
+
+    lastStats = StreamParseStats();
+    resetCalendarZones();
+    if (!preindexed) {
+        overrideIndex.clear();
+    }
+    rruleCache.clear();
+
     if (!callback || !stream) {
         return false;
     }
 
     ParseState state = LOOKING_FOR_CALENDAR;
-    String currentLine = "";
+    IcsLineReader reader(stream);
+    VTimezoneBuilder timezoneBuilder;
+    std::vector<CalendarEvent*> pendingMasters;
+    const char* line = nullptr;
+    size_t lineLength = 0;
     String eventBuffer = "";
-    bool eof = false;
+    eventBuffer.reserve(MAX_EVENT_BUFFER_SIZE);
+    EventPrefilter prefilter;
+    prefilter.reset();
+    unsigned long parseStart = millis();
     int eventCount = 0;
     int lineCount = 0;
     int eventsFiltered = 0;
     int eventsRejected = 0;
+    int eventsSkipped = 0;
+    int earlyExpansions = 0;
     bool parseSuccess = true;
 
     // Convert timestamps to readable dates for debugging
     char dateStartStr[32], dateEndStr[32];
     struct tm tmStartCopy, tmEndCopy;
-
-    // localtime() returns pointer to static buffer, so we need to copy before second call
-    struct tm* tmStart = localtime(&startDate);
-    memcpy(&tmStartCopy, tmStart, sizeof(struct tm));
-
-    struct tm* tmEnd = localtime(&endDate);
-    memcpy(&tmEndCopy, tmEnd, sizeof(struct tm));
+    TimeZoneEngine::localTime(startDate, tmStartCopy);
+    TimeZoneEngine::localTime(endDate, tmEndCopy);
 
     strftime(dateStartStr, sizeof(dateStartStr), "%Y-%m-%d", &tmStartCopy);
     strftime(dateEndStr, sizeof(dateEndStr), "%Y-%m-%d", &tmEndCopy);
@@ -229,11 +471,10 @@ bool CalendarStreamParser::streamParseFromStream(Stream* stream,
     DEBUG_INFO_PRINTLN(">>> Starting stream parsing...");
     DEBUG_INFO_PRINTLN(">>> Date range filter: " + String(dateStartStr) + " (" + String(startDate) + ") to " + String(dateEndStr) + " (" + String(endDate) + ")");
 
-    while (!eof && state != DONE) {
-        currentLine = readLineFromStream(stream, eof);
+    while (state != DONE && reader.next(line, lineLength)) {
         lineCount++;
 
-        if (currentLine.isEmpty() && !eof) {
+        if (lineLength == 0) {
             continue;
         }
 
@@ -244,50 +485,116 @@ bool CalendarStreamParser::streamParseFromStream(Stream* stream,
 
         switch (state) {
         case LOOKING_FOR_CALENDAR:
-            if (currentLine.indexOf("BEGIN:VCALENDAR") != -1) {
+            // Substring match tolerates a leading UTF-8 BOM
+            if (IcsLineReader::contains(line, lineLength, "BEGIN:VCALENDAR")) {
                 DEBUG_VERBOSE_PRINTLN(">>> Found BEGIN:VCALENDAR");
                 state = IN_HEADER;
             }
             break;
 
         case IN_HEADER:
-            if (currentLine.indexOf("BEGIN:VEVENT") != -1) {
-                eventBuffer = currentLine + "\n";
+            if (IcsLineReader::startsWith(line, lineLength, "BEGIN:VEVENT")) {
+                eventBuffer = "";
+                eventBuffer.concat(line, lineLength);
+                eventBuffer += '\n';
+                prefilter.reset();
                 state = IN_EVENT;
-            } else if (currentLine.indexOf("END:VCALENDAR") != -1) {
+            } else if (IcsLineReader::startsWith(line, lineLength, "BEGIN:VTIMEZONE")) {
+                timezoneBuilder.begin();
+                state = IN_TIMEZONE;
+            } else if (IcsLineReader::startsWith(line, lineLength, "END:VCALENDAR")) {
                 DEBUG_VERBOSE_PRINTLN(">>> Found END:VCALENDAR");
                 state = DONE;
             }
             break;
 
-        case IN_EVENT:
-            eventBuffer += currentLine + "\n";
+        case IN_TIMEZONE:
+            if (timezoneBuilder.addLine(line, lineLength)) {
+                String posix;
+                if (timezoneBuilder.toPosix(posix) && addCalendarZone(timezoneBuilder.getTzid(), posix)) {
+                    DEBUG_VERBOSE_PRINTLN(">>> VTIMEZONE " + timezoneBuilder.getTzid() + " -> " + posix);
+                } else {
+                    DEBUG_WARN_PRINTLN(">>> VTIMEZONE " + timezoneBuilder.getTzid() + " not compiled, using static map");
+                }
+                state = IN_HEADER;
+            } else if (IcsLineReader::startsWith(line, lineLength, "END:VCALENDAR")) {
+                DEBUG_WARN_PRINTLN(">>> Found END:VCALENDAR (unexpected in timezone)");
+                state = DONE;
+            }
+            break;
+
+        case IN_EVENT: {
+            bool endOfEvent = IcsLineReader::startsWith(line, lineLength, "END:VEVENT");
+
+            // Only lines that can feed the pre-filter are split before the
+            // decision; once skipping, every line is classified so that the
+            // properties parseEventFromBuffer() reads are still kept
+            EventProperty id = PROP_UNKNOWN;
+            IcsProperty property;
+            char first = line[0];
+            if ((prefilter.skipping || first == 'B' || first == 'D' || first == 'E' || first == 'R') &&
+                IcsLineReader::splitProperty(line, lineLength, property)) {
+                id = classifyEventProperty(property.name, property.nameLength);
+            }
+
+            bool nested = prefilter.depth > 1;
+            if (id == PROP_BEGIN) {
+                prefilter.depth++;
+            } else if (id == PROP_END) {
+                prefilter.depth--;
+            } else if (!nested) {
+                if (id == PROP_RRULE || id == PROP_RECURRENCE_ID) {
+                    // Everything parseEventFromBuffer() needs is still buffered
+                    prefilter.recurrence = true;
+                    prefilter.skipping = false;
+                } else if (id == PROP_DTSTART || id == PROP_DTEND) {
+                    String value, tzid;
+                    bool isDate;
+                    parseDateTimeProperty(property, value, tzid, isDate);
+                    const CompiledTimeZone* zone = tzid.isEmpty() ? nullptr : resolveZone(tzid);
+                    time_t instant = CalendarEvent::parseDateTimeValue(value, tzid, isDate, zone);
+                    if (id == PROP_DTSTART) {
+                        prefilter.start = instant;
+                    } else {
+                        prefilter.end = instant;
+                    }
+                }
+            }
+
+            if (!prefilter.skipping || endOfEvent ||
+                (id != PROP_UNKNOWN && id != PROP_BEGIN && id != PROP_END && !nested)) {
+                eventBuffer.concat(line, lineLength);
+                eventBuffer += '\n';
+            }
+
+            if (skipAhead && !prefilter.skipping && !endOfEvent && prefilter.outOfRange(startDate, endDate, false)) {
+                prefilter.skipping = true;
+            }
 
-            if (currentLine.indexOf("END:VEVENT") != -1) {
+            if (skipAhead && endOfEvent && prefilter.outOfRange(startDate, endDate, true)) {
+                // Non-recurring and out of range: same outcome as the full
+                // parse, without building the event
+                eventsSkipped++;
+                eventBuffer = "";
+                state = IN_HEADER;
+            } else if (endOfEvent) {
                 // Parse event
                 CalendarEvent* event = parseEventFromBuffer(eventBuffer);
                 if (event) {
                     eventCount++;
-                    if (event->isRecurring) {
-                        std::vector<CalendarEvent*> expanded = expandRecurringEventV2(event, startDate, endDate);
-                        int expandedCount = 0;
-                        for (auto expandedEvent : expanded) {
-                            if (isEventInRange(expandedEvent, startDate, endDate)) {
-                                callback(expandedEvent);
-                                eventsFiltered++;
-                                expandedCount++;
-                            } else {
-                                delete expandedEvent;
-                            }
-                        }
-                        // Debug: show recurring event expansion
-                        if (expandedCount > 0) {
-                            DEBUG_VERBOSE_PRINTF(
-                                ">>> Recurring event expanded: '%s' (RRULE: %s) → %d occurrences\n",
-                                event->summary.c_str(),
-                                event->rrule.c_str(),
-                                expandedCount);
+                    if (event->isRecurring && preindexed) {
+                        eventsFiltered += emitRecurringEvent(event, callback, startDate, endDate);
+                    } else if (event->isRecurring) {
+                        // Expansion waits for the rest of the calendar so that
+                        // overrides listed after the master are indexed first
+                        if (pendingMasters.size() >= MAX_PENDING_MASTERS) {
+                            eventsFiltered += emitRecurringEvent(pendingMasters.front(), callback, startDate, endDate);
+                            pendingMasters.erase(pendingMasters.begin());
+                            earlyExpansions++;
                         }
+                        pendingMasters.push_back(event);
+                    } else if (!event->recurrenceId.isEmpty() && event->status == "CANCELLED") {
+                        // Cancelled instance: only its RECURRENCE-ID matters
                         delete event;
                     } else {
                         std::vector<CalendarEvent*> expandedNonRecurring = expandMultiDayNonRecurringEvent(event);
@@ -299,7 +606,8 @@ bool CalendarStreamParser::streamParseFromStream(Stream* stream,
                             } else {
                                 // Event rejected - show first few for debugging
                                 if (eventsRejected < 3) {
-                                    struct tm* tmEvent = localtime(&expandedEvent->startTime);
+                                    struct tm tmEventBuf;
+                                    struct tm* tmEvent = TimeZoneEngine::localTime(expandedEvent->startTime, tmEventBuf);
                                     char eventDateStr[32];
                                     strftime(eventDateStr,
                                         sizeof(eventDateStr),
@@ -317,29 +625,53 @@ bool CalendarStreamParser::streamParseFromStream(Stream* stream,
 
                 eventBuffer = "";
                 state = IN_HEADER;
-
-                if (eventCount % 10 == 0) {
-                    delay(1);
-                }
-            } else if (currentLine.indexOf("END:VCALENDAR") != -1) {
+            } else if (IcsLineReader::startsWith(line, lineLength, "END:VCALENDAR")) {
                 DEBUG_WARN_PRINTLN(">>> Found END:VCALENDAR (unexpected in event)");
                 state = DONE;
             }
             break;
+        }
 
         case DONE:
             break;
         }
 
-        if (eventBuffer.length() > 8192) {
-            DEBUG_ERROR_PRINTLN(">>> ERROR: Event buffer exceeded 8192 bytes, skipping event");
+        if (eventBuffer.length() > MAX_EVENT_BUFFER_SIZE) {
+            DEBUG_ERROR_PRINTLN(">>> ERROR: Event buffer exceeded " + String((unsigned long)MAX_EVENT_BUFFER_SIZE) + " bytes, skipping event");
             eventBuffer = "";
             state = IN_HEADER;
             parseSuccess = false; // Indicate an error
         }
     }
 
-    DEBUG_INFO_PRINTLN(">>> Stream parsing complete: " + String(lineCount) + " lines read, " + String(eventCount) + " events parsed, " + String(eventsFiltered) + " events filtered, " + String(eventsRejected) + " events rejected");
+    for (size_t i = 0; i < pendingMasters.size(); i++) {
+        eventsFiltered += emitRecurringEvent(pendingMasters[i], callback, startDate, endDate);
+    }
+    pendingMasters.clear();
+
+    lastStats.bytesRead = reader.getBytesRead();
+    lastStats.linesRead = reader.getLinesRead();
+    lastStats.eventsParsed = eventCount;
+    lastStats.eventsFiltered = eventsFiltered;
+    lastStats.eventsRejected = eventsRejected;
+    lastStats.eventsSkipped = eventsSkipped;
+    lastStats.timezones = calendarZones.size();
+    lastStats.overrides = overrideIndex.size();
+    lastStats.rruleCacheHits = rruleCache.getHits();
+    lastStats.rruleCacheMisses = rruleCache.getMisses();
+    lastStats.earlyExpansions = earlyExpansions;
+    lastStats.parseMs = millis() - parseStart;
+    lastStats.stallMs = reader.getStallMs();
+
+    if (earlyExpansions > 0) {
+        DEBUG_WARN_PRINTLN(">>> " + String(earlyExpansions) + " recurring events expanded before the end of the calendar (more than " + String((unsigned long)MAX_PENDING_MASTERS) + " pending); overrides listed after them are not applied");
+    }
+    if (reader.getLinesTruncated() > 0) {
+        DEBUG_WARN_PRINTLN(">>> " + String((unsigned long)reader.getLinesTruncated()) + " lines truncated to " + String((unsigned long)reader.getMaxLineLength()) + " bytes");
+    }
+
+    DEBUG_INFO_PRINTLN(">>> Stream parsing complete: " + String((unsigned long)lastStats.bytesRead) + " bytes, " + String(lineCount) + " lines read, " + String(eventCount) + " events parsed, " + String(eventsFiltered) + " events filtered, " + String(eventsRejected) + " events rejected, " + String(eventsSkipped) + " events skipped unparsed");
+    DEBUG_INFO_PRINTLN(">>> Parse time: " + String(lastStats.parseMs - lastStats.stallMs) + "ms parsing, " + String(lastStats.stallMs) + "ms waiting for data");
 
     return parseSuccess;
 }
@@ -348,8 +680,20 @@ bool CalendarStreamParser::streamParse(const String& url,
     EventCallback callback,
     time_t startDate,
     time_t endDate,
-    const String& cachePath)
+    const String& cachePath,
+    const HttpValidators* validators,
+    const FeedTail* resume)
 {
+    lastNotModified = false;
+    lastValidators = HttpValidators();
+    lastBytesTransferred = 0;
+    lastPartial = false;
+    lastTail = FeedTail();
+    resumeZones.clear();
+    lastSpooled = false;
+    lastDownloadMs = 0;
+    lastTimings = FetchTimings();
+
     if (!callback) {
         return false;
     }
@@ -360,19 +704,93 @@ bool CalendarStreamParser::streamParse(const String& url,
         // Parse directly from HTTP stream (no ICS file caching)
         DEBUG_INFO_PRINTLN(">>> Opening HTTP stream for direct parsing: " + url);
 
-        Stream* httpStream = fetcher->fetchStream(url);
+        if (validators && validators->isEmpty()) {
+            validators = nullptr;
+        }
+        unsigned long downloadStart = millis();
+        Stream* httpStream = fetcher->fetchStream(url, validators, incremental ? resume : nullptr);
+        lastTimings = fetcher->getLastTimings();
+        if (!httpStream && validators && fetcher->getLastHttpCode() == HTTP_CODE_NOT_MODIFIED) {
+            // The cached events are still current: nothing to download or parse
+            DEBUG_INFO_PRINTLN(">>> Calendar not modified, skipping parse");
+            lastStats = StreamParseStats();
+            lastNotModified = true;
+            lastValidators = *validators;
+            return true;
+        }
         if (!httpStream) {
             DEBUG_ERROR_PRINTLN(">>> ERROR: Failed to open HTTP stream");
             return false;
         }
 
+        lastValidators = fetcher->getResponseValidators();
+        lastPartial = fetcher->isPartialContent();
+        if (lastPartial) {
+            resumeZones = resume->zones;
+        }
+
+        // Large bodies go to flash first so the radio is only needed while
+        // they arrive; a stall can no longer fail a parse half way through
+        int contentLength = fetcher->getContentLength();
+        if (!spoolPath.isEmpty() && !spoolFailed && (contentLength < 0 || (size_t)contentLength >= spoolMinBytes)) {
+            DEBUG_INFO_PRINTLN(">>> Stream opened, spooling body to " + spoolPath);
+            // Content-Length counts encoded bytes, and a partial body
+            // includes the anchor already read
+            long expectedBytes = -1;
+            if (contentLength >= 0 && !fetcher->isEncoded()) {
+                expectedBytes = lastPartial ? contentLength - FEED_TAIL_ANCHOR_BYTES : contentLength;
+            }
+            size_t spooledBytes = 0;
+            bool spooled = spoolBody(httpStream, expectedBytes, spooledBytes);
+            const char* streamError = fetcher->getStreamError();
+            if (streamError) {
+                DEBUG_ERROR_PRINTLN(">>> ERROR: Failed to decode calendar body: " + String(streamError));
+                spooled = false;
+            }
+            size_t compressedBytes = fetcher->getCompressedBytes();
+            fetcher->endStream();
+            lastDownloadMs = millis() - downloadStart;
+
+            if (!spooled) {
+                LittleFS.remove(spoolPath);
+                return false;
+            }
+            lastStats = StreamParseStats();
+            lastSpooled = true;
+            spoolEncoded = compressedBytes > 0;
+            spoolResume = lastPartial ? *resume : FeedTail();
+            lastBytesTransferred = compressedBytes > 0 ? compressedBytes : spooledBytes;
+            if (lastPartial) {
+                lastBytesTransferred = FEED_TAIL_ANCHOR_BYTES + spooledBytes;
+            }
+            DEBUG_INFO_PRINTLN(">>> Spooled " + String((unsigned long)spooledBytes) + " bytes in " + String(lastDownloadMs) + "ms");
+            return true;
+        }
+
         DEBUG_INFO_PRINTLN(">>> Stream opened, starting direct parse...");
         unsigned long parseStart = millis();
 
-        // Parse directly from HTTP stream
-        bool parseSuccess = streamParseFromStream(httpStream, callback, startDate, endDate);
+        FeedTail tail;
+        bool parseSuccess = parseBody(httpStream, callback, startDate, endDate, resume, tail);
+
+        // A corrupt or truncated compressed body ends the stream early
+        const char* streamError = fetcher->getStreamError();
+        if (streamError) {
+            DEBUG_ERROR_PRINTLN(">>> ERROR: Failed to decode calendar body: " + String(streamError));
+            parseSuccess = false;
+        }
+        size_t compressedBytes = fetcher->getCompressedBytes();
+        lastBytesTransferred = compressedBytes > 0 ? compressedBytes : lastStats.bytesRead;
+        if (lastPartial) {
+            lastBytesTransferred = FEED_TAIL_ANCHOR_BYTES + tail.length - resume->offset;
+        }
+        // Offsets of an encoded body do not match the bytes the server stores
+        if (compressedBytes == 0 && parseSuccess) {
+            lastTail = tail;
+        }
 
         fetcher->endStream();
+        lastDownloadMs = millis() - downloadStart;
 
         unsigned long parseDuration = millis() - parseStart;
         DEBUG_INFO_PRINTLN(">>> Parse complete in " + String(parseDuration) + "ms, success: " + String(parseSuccess ? "true" : "false"));
@@ -393,7 +811,10 @@ bool CalendarStreamParser::streamParse(const String& url,
         DEBUG_INFO_PRINTLN(">>> Starting parse...");
 
         // Parse from the file stream
+        indexOverrides(&file);
+        file.seek(0);
         bool parseSuccess = streamParseFromStream(&file, callback, startDate, endDate);
+        lastBytesTransferred = lastStats.bytesRead;
 
         file.close();
         DEBUG_INFO_PRINTLN(">>> Parse complete, success: " + String(parseSuccess ? "true" : "false"));
@@ -402,195 +823,485 @@ bool CalendarStreamParser::streamParse(const String& url,
     }
 }
 
-bool CalendarStreamParser::parseMetadata(const String& url,
-    String& calendarName,
-    String& timezone)
+bool CalendarStreamParser::streamParseSpool(EventCallback callback, time_t startDate, time_t endDate)
 {
-    // Get stream from fetcher
-    Stream* stream = fetcher->fetchStream(url);
-    if (!stream) {
+    lastTail = FeedTail();
+
+    if (!callback || !lastSpooled) {
         return false;
     }
 
-    bool foundCalendar = false;
-    String line = "";
-    bool eof = false;
+    File file = LittleFS.open(spoolPath, "r");
+    if (!file) {
+        DEBUG_ERROR_PRINTLN(">>> ERROR: Could not open spool file: " + spoolPath);
+        return false;
+    }
+    DEBUG_INFO_PRINTLN(">>> Parsing spooled body, size: " + String((unsigned long)file.size()) + " bytes");
 
-    while (!eof && !foundCalendar) {
-        line = readLineFromStream(stream, eof);
+    indexOverrides(&file);
+    file.seek(0);
 
-        if (line.indexOf("BEGIN:VCALENDAR") != -1) {
-            foundCalendar = true;
-        }
+    FeedTail tail;
+    bool parseSuccess = parseBody(&file, callback, startDate, endDate, lastPartial ? &spoolResume : nullptr, tail);
+    if (!spoolEncoded && parseSuccess) {
+        lastTail = tail;
     }
 
-    if (!foundCalendar) {
-        fetcher->endStream();
-        return false;
-    }
+    file.close();
+    LittleFS.remove(spoolPath);
+    DEBUG_INFO_PRINTLN(">>> Parse complete in " + String(lastStats.parseMs) + "ms, success: " + String(parseSuccess ? "true" : "false"));
 
-    // Parse header until first event
-    while (!eof) {
-        line = readLineFromStream(stream, eof);
-
-        if (line.indexOf("X-WR-CALNAME:") != -1) {
-            calendarName = extractValue(line, "X-WR-CALNAME:");
-        } else if (line.indexOf("X-WR-TIMEZONE:") != -1) {
-            timezone = extractValue(line, "X-WR-TIMEZONE:");
-        } else if (line.indexOf("BEGIN:VEVENT") != -1) {
-            // Stop at first event
-            break;
+    return parseSuccess;
+}
+
+bool CalendarStreamParser::parseBody(Stream* body,
+    EventCallback callback,
+    time_t startDate,
+    time_t endDate,
+    const FeedTail* resume,
+    FeedTail& tail)
+{
+    // In incremental mode, note where the last VEVENT ends; appended
+    // VEVENTs are parsed as a calendar of their own
+    FeedTailStream* tracker = nullptr;
+    if (lastPartial) {
+        tracker = new FeedTailStream(body, resume->offset, "BEGIN:VCALENDAR\r\n");
+    } else if (incremental) {
+        tracker = new FeedTailStream(body);
+    }
+
+    bool parseSuccess = streamParseFromStream(tracker ? tracker : body, callback, startDate, endDate);
+
+    tail = FeedTail();
+    if (tracker) {
+        tail = tracker->getTail();
+        // Nothing appended: the previous tail still marks the last VEVENT
+        if (lastPartial && tail.offset == 0) {
+            tail.offset = resume->offset;
+            tail.anchorCrc = resume->anchorCrc;
         }
+        for (const auto& entry : calendarZones) {
+            FeedZone zone;
+            zone.tzid = entry.tzid;
+            zone.posix = entry.posix;
+            tail.zones.push_back(zone);
+        }
+        delete tracker;
     }
+    return parseSuccess;
+}
 
-    fetcher->endStream();
-    return true;
+// Whether the bytes received so far end with the END:VCALENDAR line
+static bool endsWithCalendarEnd(const char* recent, size_t length)
+{
+    while (length > 0 && (recent[length - 1] == '\r' || recent[length - 1] == '\n' || recent[length - 1] == ' ')) {
+        length--;
+    }
+    return length >= 13 && memcmp(recent + length - 13, "END:VCALENDAR", 13) == 0;
 }
 
-CalendarEvent* CalendarStreamParser::parseEventFromBuffer(const String& eventData)
+bool CalendarStreamParser::spoolBody(Stream* body, long expectedBytes, size_t& written)
 {
-    CalendarEvent* event = new CalendarEvent();
+    written = 0;
 
-    // Extract event fields
-    event->summary = extractValueFromBuffer(eventData, "SUMMARY:");
-    event->description = extractValueFromBuffer(eventData, "DESCRIPTION:");
-    event->uid = extractValueFromBuffer(eventData, "UID:");
-    event->status = extractValueFromBuffer(eventData, "STATUS:");
-    event->rrule = extractValueFromBuffer(eventData, "RRULE:");
-    event->isRecurring = !event->rrule.isEmpty();
+    uint8_t* buffer = (uint8_t*)malloc(CALENDAR_SPOOL_WRITE_BYTES);
+    if (!buffer) {
+        DEBUG_ERROR_PRINTLN(">>> ERROR: No memory for the spool buffer");
+        spoolFailed = true;
+        return false;
+    }
+    File file = LittleFS.open(spoolPath, "w");
+    if (!file) {
+        DEBUG_ERROR_PRINTLN(">>> ERROR: Could not create spool file: " + spoolPath);
+        free(buffer);
+        spoolFailed = true;
+        return false;
+    }
 
-    // Parse start date/time (with full timezone support)
-    String dtStart;
-    String dtStartTZID;
-    bool dtStartIsDate = false;
+    // Last bytes received, to notice the end of the calendar
+    char recent[32];
+    size_t recentLength = 0;
+    size_t fill = 0;
+    bool success = true;
+
+    while (true) {
+        // A body without framing only ends when the server closes the
+        // connection; do not wait out the read timeout after the calendar
+        int available = body->available();
+        if (expectedBytes >= 0 ? written + fill >= (size_t)expectedBytes
+                               : available <= 0 && endsWithCalendarEnd(recent, recentLength)) {
+            break;
+        }
 
-    // Check for TZID parameter first (e.g., DTSTART;TZID=America/Los_Angeles:20251119T140000)
-    int dtStartPos = eventData.indexOf("DTSTART;TZID=");
-    if (dtStartPos >= 0) {
-        int colonPos = eventData.indexOf(":", dtStartPos);
-        int newlinePos = eventData.indexOf("\n", colonPos);
-        if (newlinePos == -1)
-            newlinePos = eventData.length();
-
-        // Extract TZID value
-        String dtStartLine = eventData.substring(dtStartPos, colonPos);
-        int tzidStart = dtStartLine.indexOf("TZID=") + 5;
-        dtStartTZID = dtStartLine.substring(tzidStart);
-        dtStartTZID.trim();
-
-        // Extract datetime value
-        dtStart = eventData.substring(colonPos + 1, newlinePos);
-        dtStart.trim();
-
-    } else if (eventData.indexOf("DTSTART;VALUE=DATE:") >= 0) {
-        // All-day event (DATE format)
-        dtStart = extractValueFromBuffer(eventData, "DTSTART;VALUE=DATE:");
-        dtStartIsDate = true;
+        // Take what has arrived, or block for the next byte
+        size_t space = CALENDAR_SPOOL_WRITE_BYTES - fill;
+        size_t toRead = available > 0 ? ((size_t)available < space ? (size_t)available : space) : 1;
+        size_t received = body->readBytes(buffer + fill, toRead);
+        if (received == 0) {
+            break;
+        }
 
-    } else {
-        // No TZID - could be UTC (ends with Z) or floating time
-        dtStart = extractValueFromBuffer(eventData, "DTSTART:");
-        if (dtStart.isEmpty()) {
-            dtStart = extractValueFromBuffer(eventData, "DTSTART;VALUE=DATE-TIME:");
+        size_t keep = received < sizeof(recent) ? sizeof(recent) - received : 0;
+        if (keep > recentLength) {
+            keep = recentLength;
         }
-        // Check if it's a date-only format (8 chars: YYYYMMDD)
-        if (!dtStart.isEmpty() && dtStart.length() == 8) {
-            dtStartIsDate = true;
+        memmove(recent, recent + recentLength - keep, keep);
+        size_t take = received < sizeof(recent) ? received : sizeof(recent);
+        memcpy(recent + keep, buffer + fill + received - take, take);
+        recentLength = keep + take;
+
+        fill += received;
+        if (fill == CALENDAR_SPOOL_WRITE_BYTES) {
+            if (file.write(buffer, fill) != fill) {
+                success = false;
+                break;
+            }
+            written += fill;
+            fill = 0;
         }
     }
 
-    if (!dtStart.isEmpty()) {
-        event->setStartDateTime(dtStart, dtStartTZID, dtStartIsDate);
+    if (success && fill > 0) {
+        if (file.write(buffer, fill) != fill) {
+            success = false;
+        } else {
+            written += fill;
+        }
     }
+    file.close();
+    free(buffer);
 
-    // Parse end date/time (with full timezone support)
-    String dtEnd;
-    String dtEndTZID;
-    bool dtEndIsDate = false;
-
-    // Check for TZID parameter first
-    int dtEndPos = eventData.indexOf("DTEND;TZID=");
-    if (dtEndPos >= 0) {
-        int colonPos = eventData.indexOf(":", dtEndPos);
-        int newlinePos = eventData.indexOf("\n", colonPos);
-        if (newlinePos == -1)
-            newlinePos = eventData.length();
-
-        // Extract TZID value
-        String dtEndLine = eventData.substring(dtEndPos, colonPos);
-        int tzidStart = dtEndLine.indexOf("TZID=") + 5;
-        dtEndTZID = dtEndLine.substring(tzidStart);
-        dtEndTZID.trim();
-
-        // Extract datetime value
-        dtEnd = eventData.substring(colonPos + 1, newlinePos);
-        dtEnd.trim();
-
-    } else if (eventData.indexOf("DTEND;VALUE=DATE:") >= 0) {
-        // All-day event (DATE format)
-        dtEnd = extractValueFromBuffer(eventData, "DTEND;VALUE=DATE:");
-        dtEndIsDate = true;
+    if (!success) {
+        // Out of flash: parse the next attempt as it arrives
+        DEBUG_ERROR_PRINTLN(">>> ERROR: Failed to write spool file after " + String((unsigned long)written) + " bytes");
+        spoolFailed = true;
+        return false;
+    }
 
-    } else {
-        // No TZID - could be UTC (ends with Z) or floating time
-        dtEnd = extractValueFromBuffer(eventData, "DTEND:");
-        if (dtEnd.isEmpty()) {
-            dtEnd = extractValueFromBuffer(eventData, "DTEND;VALUE=DATE-TIME:");
-        }
-        // Check if it's a date-only format (8 chars: YYYYMMDD)
-        if (!dtEnd.isEmpty() && dtEnd.length() == 8) {
-            dtEndIsDate = true;
+    // A read that timed out or a dropped connection ends the body early
+    bool complete = expectedBytes >= 0 ? written == (size_t)expectedBytes : endsWithCalendarEnd(recent, recentLength);
+    if (!complete) {
+        if (expectedBytes >= 0) {
+            DEBUG_ERROR_PRINTLN(">>> ERROR: Body ended after " + String((unsigned long)written) + " of " +
+                                String(expectedBytes) + " bytes");
+        } else {
+            DEBUG_ERROR_PRINTLN(">>> ERROR: Body ended after " + String((unsigned long)written) +
+                                " bytes without END:VCALENDAR");
         }
+        return false;
     }
+    return true;
+}
 
-    if (!dtEnd.isEmpty()) {
-        event->setEndDateTime(dtEnd, dtEndTZID, dtEndIsDate);
+int CalendarStreamParser::emitRecurringEvent(CalendarEvent* event,
+    const EventCallback& callback,
+    time_t startDate,
+    time_t endDate)
+{
+    // Occurrences are generated lazily and only copied once they are known
+    // to fall inside the query range
+    OccurrenceIterator it = iterateOccurrences(event, startDate, endDate);
+    int expandedCount = 0;
+    time_t occurrenceStart, occurrenceEnd;
+    while (it.next(occurrenceStart, occurrenceEnd)) {
+        callback(materializeOccurrence(event, occurrenceStart, occurrenceEnd));
+        expandedCount++;
+    }
+    // Debug: show recurring event expansion
+    if (expandedCount > 0) {
+        DEBUG_VERBOSE_PRINTF(
+            ">>> Recurring event expanded: '%s' (RRULE: %s) → %d occurrences\n",
+            event->summary.c_str(),
+            event->rrule.c_str(),
+            expandedCount);
     }
+    delete event;
+    return expandedCount;
+}
 
-    // Debug: Track specific event
-    bool isTargetEvent = (event->uid.indexOf("cor64p3165hjabb364qm2b9k68o3abb26gs3gbb5cco3gc1mcorm8p1o68") >= 0);
-    if (isTargetEvent) {
-        struct tm* tmStart = localtime(&event->startTime);
-        struct tm* tmEnd = localtime(&event->endTime);
-        char startStr[32], endStr[32];
-        strftime(startStr, sizeof(startStr), "%Y-%m-%d %H:%M:%S", tmStart);
-        strftime(endStr, sizeof(endStr), "%Y-%m-%d %H:%M:%S", tmEnd);
+bool CalendarStreamParser::addCalendarZone(const String& tzid, const String& posix)
+{
+    CompiledTimeZone zone;
+    if (tzid.isEmpty() || !zone.compile(posix.c_str())) {
+        return false;
+    }
 
-        DEBUG_INFO_PRINTF(">>> PARSING TARGET EVENT (Cambio gomme) <<<\n");
-        DEBUG_INFO_PRINTF("  Summary: %s\n", event->summary.c_str());
-        DEBUG_INFO_PRINTF("  UID: %s\n", event->uid.c_str());
-        DEBUG_INFO_PRINTF("  All-day: %s\n", event->allDay ? "YES" : "NO");
-        DEBUG_INFO_PRINTF("  Parsed startTime: %s (unix: %ld)\n", startStr, event->startTime);
-        DEBUG_INFO_PRINTF("  Parsed endTime: %s (unix: %ld)\n", endStr, event->endTime);
+    // A repeated TZID replaces the earlier definition
+    for (auto& entry : calendarZones) {
+        if (entry.tzid == tzid) {
+            entry.posix = posix;
+            entry.zone = zone;
+            return true;
+        }
     }
 
-    return event;
+    if (calendarZones.size() >= MAX_CALENDAR_ZONES) {
+        return false;
+    }
+    if (calendarZones.empty()) {
+        calendarZones.reserve(MAX_CALENDAR_ZONES);
+    }
+    calendarZones.push_back(CalendarZone());
+    calendarZones.back().tzid = tzid;
+    calendarZones.back().posix = posix;
+    calendarZones.back().zone = zone;
+    return true;
 }
 
-String CalendarStreamParser::extractValueFromBuffer(const String& buffer, const String& property)
+void CalendarStreamParser::resetCalendarZones()
 {
-    int pos = buffer.indexOf(property);
-    if (pos == -1) {
-        return "";
+    calendarZones.clear();
+    if (!lastPartial) {
+        return;
     }
-
-    int valueStart = pos + property.length();
-    int valueEnd = buffer.indexOf("\n", valueStart);
-    if (valueEnd == -1) {
-        valueEnd = buffer.length();
+    for (const auto& zone : resumeZones) {
+        addCalendarZone(zone.tzid, zone.posix);
     }
+}
 
-    String value = buffer.substring(valueStart, valueEnd);
-    value.trim();
-    value.replace("\r", "");
-
-    return value;
+void CalendarStreamParser::parseExdateProperty(const IcsProperty& property,
+    String& raw,
+    std::vector<time_t>& times)
+{
+    String value, tzid;
+    bool isDate = false;
+    parseDateTimeProperty(property, value, tzid, isDate);
+
+    // EXDATE may repeat; keep the raw values comma-joined on the event
+    if (!raw.isEmpty()) {
+        raw += ',';
+    }
+    raw += value;
+
+    const CompiledTimeZone* zone = tzid.isEmpty() ? nullptr : resolveZone(tzid);
+    const char* list = value.c_str();
+    size_t listLength = value.length();
+    size_t start = 0;
+    String item;
+    while (start < listLength) {
+        const char* comma = (const char*)memchr(list + start, ',', listLength - start);
+        size_t end = comma ? (size_t)(comma - list) : listLength;
+
+        item = "";
+        item.concat(list + start, end - start);
+        bool itemIsDate = isDate || (tzid.isEmpty() && item.length() == 8);
+        time_t instance = CalendarEvent::parseDateTimeValue(item, tzid, itemIsDate, zone);
+        if (instance > 0) {
+            times.push_back(instance);
+        }
+        start = end + 1;
+    }
 }
 
-bool CalendarStreamParser::isEventInRange(CalendarEvent* event, time_t startDate, time_t endDate)
+const CompiledTimeZone* CalendarStreamParser::resolveZone(const String& tzid)
 {
-    if (!event)
-        return false;
+    for (const auto& entry : calendarZones) {
+        if (entry.tzid == tzid) {
+            return &entry.zone;
+        }
+    }
+    return TimeZoneEngine::find(tzid);
+}
+
+bool CalendarStreamParser::parseMetadata(const String& url,
+    String& calendarName,
+    String& timezone)
+{
+    // Get stream from fetcher
+    Stream* stream = fetcher->fetchStream(url);
+    if (!stream) {
+        return false;
+    }
+
+    IcsLineReader reader(stream);
+    const char* line = nullptr;
+    size_t lineLength = 0;
+    bool foundCalendar = false;
+
+    while (!foundCalendar && reader.next(line, lineLength)) {
+        if (IcsLineReader::contains(line, lineLength, "BEGIN:VCALENDAR")) {
+            foundCalendar = true;
+        }
+    }
+
+    if (!foundCalendar) {
+        fetcher->endStream();
+        return false;
+    }
+
+    // Parse header until first event
+    while (reader.next(line, lineLength)) {
+        if (IcsLineReader::startsWith(line, lineLength, "X-WR-CALNAME:")) {
+            String value;
+            value.concat(line + 13, lineLength - 13);
+            value.trim();
+            calendarName = value;
+        } else if (IcsLineReader::startsWith(line, lineLength, "X-WR-TIMEZONE:")) {
+            String value;
+            value.concat(line + 14, lineLength - 14);
+            value.trim();
+            timezone = value;
+        } else if (IcsLineReader::startsWith(line, lineLength, "BEGIN:VEVENT")) {
+            // Stop at first event
+            break;
+        }
+    }
+
+    fetcher->endStream();
+    return true;
+}
+
+CalendarEvent* CalendarStreamParser::parseEventFromBuffer(const String& eventData)
+{
+    CalendarEvent* event = new CalendarEvent();
+
+    const char* data = eventData.c_str();
+    size_t dataLength = eventData.length();
+    size_t pos = 0;
+
+    // Nesting level: 1 inside the VEVENT itself, >1 inside VALARM and other
+    // sub-components whose SUMMARY/DESCRIPTION must not override the event's
+    int depth = 0;
+
+    String unfolded; // Only used when the buffer still contains folded lines
+    String dtStart, dtStartTZID, dtEnd, dtEndTZID, recurrenceIdTZID;
+    bool dtStartIsDate = false;
+    bool dtEndIsDate = false;
+    bool recurrenceIdIsDate = false;
+    std::vector<time_t> exdateTimes; // Resolved once the UID is known
+
+    while (pos < dataLength) {
+        // Locate the physical line
+        const char* line = data + pos;
+        const char* newline = (const char*)memchr(line, '\n', dataLength - pos);
+        size_t lineLength = newline ? (size_t)(newline - line) : dataLength - pos;
+        pos += lineLength + 1;
+
+        if (lineLength > 0 && line[lineLength - 1] == '\r') {
+            lineLength--;
+        }
+
+        // Unfold continuation lines (RFC 5545 3.1) into the scratch buffer
+        if (pos < dataLength && (data[pos] == ' ' || data[pos] == '\t')) {
+            unfolded = "";
+            unfolded.concat(line, lineLength);
+            while (pos < dataLength && (data[pos] == ' ' || data[pos] == '\t')) {
+                const char* continuation = data + pos + 1;
+                const char* continuationEnd =
+                    (const char*)memchr(continuation, '\n', dataLength - pos - 1);
+                size_t continuationLength = continuationEnd ? (size_t)(continuationEnd - continuation)
+                                                            : dataLength - pos - 1;
+                pos += continuationLength + 2;
+                if (continuationLength > 0 && continuation[continuationLength - 1] == '\r') {
+                    continuationLength--;
+                }
+                unfolded.concat(continuation, continuationLength);
+            }
+            line = unfolded.c_str();
+            lineLength = unfolded.length();
+        }
+
+        IcsProperty property;
+        if (!IcsLineReader::splitProperty(line, lineLength, property)) {
+            continue;
+        }
+
+        EventProperty id = classifyEventProperty(property.name, property.nameLength);
+        if (id == PROP_BEGIN) {
+            depth++;
+            continue;
+        }
+        if (id == PROP_END) {
+            depth--;
+            continue;
+        }
+        if (id == PROP_UNKNOWN || depth > 1) {
+            continue;
+        }
+
+        switch (id) {
+        case PROP_SUMMARY:
+            event->summary = propertyValue(property);
+            break;
+        case PROP_DESCRIPTION:
+            event->description = propertyValue(property);
+            break;
+        case PROP_UID:
+            event->uid = propertyValue(property);
+            break;
+        case PROP_STATUS:
+            event->status = propertyValue(property);
+            break;
+        case PROP_RRULE:
+            event->rrule = propertyValue(property);
+            break;
+        case PROP_DTSTART:
+            parseDateTimeProperty(property, dtStart, dtStartTZID, dtStartIsDate);
+            break;
+        case PROP_DTEND:
+            parseDateTimeProperty(property, dtEnd, dtEndTZID, dtEndIsDate);
+            break;
+        case PROP_EXDATE:
+            parseExdateProperty(property, event->exdate, exdateTimes);
+            break;
+        case PROP_RECURRENCE_ID:
+            parseDateTimeProperty(property, event->recurrenceId, recurrenceIdTZID, recurrenceIdIsDate);
+            break;
+        default:
+            break;
+        }
+    }
+
+    event->isRecurring = !event->rrule.isEmpty();
+
+    // Register cancelled and moved instances so the master's expansion skips them
+    for (size_t i = 0; i < exdateTimes.size(); i++) {
+        overrideIndex.add(event->uid, exdateTimes[i], RecurrenceOverrideIndex::EXCLUDED);
+    }
+    if (!event->recurrenceId.isEmpty()) {
+        const CompiledTimeZone* zone = recurrenceIdTZID.isEmpty() ? nullptr : resolveZone(recurrenceIdTZID);
+        time_t instance = CalendarEvent::parseDateTimeValue(event->recurrenceId, recurrenceIdTZID, recurrenceIdIsDate, zone);
+        if (instance > 0) {
+            overrideIndex.add(event->uid, instance, RecurrenceOverrideIndex::OVERRIDDEN);
+        }
+    }
+
+    if (!dtStart.isEmpty()) {
+        const CompiledTimeZone* zone = dtStartTZID.isEmpty() ? nullptr : resolveZone(dtStartTZID);
+        event->setStartDateTime(dtStart, dtStartTZID, dtStartIsDate, zone);
+        event->timezone = dtStartTZID;
+    }
+    if (!dtEnd.isEmpty()) {
+        const CompiledTimeZone* zone = dtEndTZID.isEmpty() ? nullptr : resolveZone(dtEndTZID);
+        event->setEndDateTime(dtEnd, dtEndTZID, dtEndIsDate, zone);
+    }
+
+    // Debug: Track specific event
+    bool isTargetEvent = (event->uid.indexOf("cor64p3165hjabb364qm2b9k68o3abb26gs3gbb5cco3gc1mcorm8p1o68") >= 0);
+    if (isTargetEvent) {
+        struct tm tmStartBuf;
+        struct tm* tmStart = TimeZoneEngine::localTime(event->startTime, tmStartBuf);
+        struct tm tmEndBuf;
+        struct tm* tmEnd = TimeZoneEngine::localTime(event->endTime, tmEndBuf);
+        char startStr[32], endStr[32];
+        strftime(startStr, sizeof(startStr), "%Y-%m-%d %H:%M:%S", tmStart);
+        strftime(endStr, sizeof(endStr), "%Y-%m-%d %H:%M:%S", tmEnd);
+
+        DEBUG_INFO_PRINTF(">>> PARSING TARGET EVENT (Cambio gomme) <<<\n");
+        DEBUG_INFO_PRINTF("  Summary: %s\n", event->summary.c_str());
+        DEBUG_INFO_PRINTF("  UID: %s\n", event->uid.c_str());
+        DEBUG_INFO_PRINTF("  All-day: %s\n", event->allDay ? "YES" : "NO");
+        DEBUG_INFO_PRINTF("  Parsed startTime: %s (unix: %ld)\n", startStr, event->startTime);
+        DEBUG_INFO_PRINTF("  Parsed endTime: %s (unix: %ld)\n", endStr, event->endTime);
+    }
+
+    return event;
+}
+
+bool CalendarStreamParser::isEventInRange(CalendarEvent* event, time_t startDate, time_t endDate)
+{
+    if (!event)
+        return false;
 
     time_t eventStart = event->startTime;
     time_t eventEnd = event->endTime;
@@ -653,8 +1364,21 @@ RRuleComponents CalendarStreamParser::parseRRule(const String& rrule)
             result.byMonthDay = value;
         } else if (key == "BYMONTH") {
             result.byMonth = value;
+        } else if (key == "BYHOUR") {
+            result.byHour = value;
+        } else if (key == "BYMINUTE") {
+            result.byMinute = value;
+        } else if (key == "BYSECOND") {
+            result.bySecond = value;
+        } else if (key == "BYYEARDAY") {
+            result.byYearDay = value;
+        } else if (key == "BYWEEKNO") {
+            result.byWeekNo = value;
+        } else if (key == "BYSETPOS") {
+            result.bySetPos = value;
+        } else if (key == "WKST") {
+            result.wkst = value;
         }
-        // Note: Other RRULE properties (BYHOUR, BYMINUTE, etc.) can be added later if needed
     }
 
     return result;
@@ -669,9 +1393,12 @@ time_t CalendarStreamParser::parseUntilDate(const String& untilStr)
     if (untilStr.isEmpty())
         return 0;
 
-    // Remove 'Z' suffix if present (UTC indicator)
+    // A 'Z' suffix means the value is UTC rather than floating local time
     String dateStr = untilStr;
-    dateStr.replace("Z", "");
+    bool isUtc = dateStr.endsWith("Z");
+    if (isUtc) {
+        dateStr.remove(dateStr.length() - 1);
+    }
 
     // Parse: YYYYMMDD or YYYYMMDDTHHMMSS
     if (dateStr.length() < 8)
@@ -704,354 +1431,12 @@ time_t CalendarStreamParser::parseUntilDate(const String& untilStr)
         tm.tm_sec = 59;
     }
 
-    tm.tm_isdst = -1; // Let mktime determine DST
-    return mktime(&tm);
-}
-
-/**
- * Parse BYDAY into weekday numbers
- * Input: "MO,WE,FR" or "1MO,-1FR" (with position prefix)
- * Output: Vector of weekday numbers (0=Sunday, 1=Monday, ..., 6=Saturday)
- * Note: Position prefixes (1MO, -1FR) are stored but not yet fully implemented
- */
-std::vector<int> CalendarStreamParser::parseByDay(const String& byDay)
-{
-    std::vector<int> weekdays;
-    if (byDay.isEmpty())
-        return weekdays;
-
-    int startPos = 0;
-    int commaPos = 0;
-
-    while (commaPos != -1) {
-        commaPos = byDay.indexOf(',', startPos);
-        String day = (commaPos == -1) ? byDay.substring(startPos) : byDay.substring(startPos, commaPos);
-        startPos = commaPos + 1;
-
-        day.trim();
-        if (day.isEmpty())
-            continue;
-
-        // Extract day code (last 2 characters, ignoring position prefix)
-        String dayCode = day.length() >= 2 ? day.substring(day.length() - 2) : day;
-
-        // Map day codes to numbers (0=SU, 1=MO, 2=TU, 3=WE, 4=TH, 5=FR, 6=SA)
-        int weekday = -1;
-        if (dayCode == "SU")
-            weekday = 0;
-        else if (dayCode == "MO")
-            weekday = 1;
-        else if (dayCode == "TU")
-            weekday = 2;
-        else if (dayCode == "WE")
-            weekday = 3;
-        else if (dayCode == "TH")
-            weekday = 4;
-        else if (dayCode == "FR")
-            weekday = 5;
-        else if (dayCode == "SA")
-            weekday = 6;
-
-        if (weekday != -1) {
-            weekdays.push_back(weekday);
-        }
+    if (isUtc) {
+        return TimeZoneEngine::makeUtc(tm);
     }
 
-    return weekdays;
-}
-
-/**
- * Parse BYMONTHDAY into day numbers
- * Input: "1,15,-1" (negative means from end of month)
- * Output: Vector of day numbers
- */
-std::vector<int> CalendarStreamParser::parseByMonthDay(const String& byMonthDay)
-{
-    std::vector<int> days;
-    if (byMonthDay.isEmpty())
-        return days;
-
-    int startPos = 0;
-    int commaPos = 0;
-
-    while (commaPos != -1) {
-        commaPos = byMonthDay.indexOf(',', startPos);
-        String dayStr = (commaPos == -1) ? byMonthDay.substring(startPos)
-                                         : byMonthDay.substring(startPos, commaPos);
-        startPos = commaPos + 1;
-
-        dayStr.trim();
-        if (dayStr.isEmpty())
-            continue;
-
-        int day = dayStr.toInt();
-        if (day != 0) { // toInt returns 0 for invalid strings, but we want to allow 0 to be filtered out
-            days.push_back(day);
-        }
-    }
-
-    return days;
-}
-
-/**
- * Parse BYMONTH into month numbers
- * Input: "1,7" (1=January, 12=December)
- * Output: Vector of month numbers (1-12)
- */
-std::vector<int> CalendarStreamParser::parseByMonth(const String& byMonth)
-{
-    std::vector<int> months;
-    if (byMonth.isEmpty())
-        return months;
-
-    int startPos = 0;
-    int commaPos = 0;
-
-    while (commaPos != -1) {
-        commaPos = byMonth.indexOf(',', startPos);
-        String monthStr = (commaPos == -1) ? byMonth.substring(startPos) : byMonth.substring(startPos, commaPos);
-        startPos = commaPos + 1;
-
-        monthStr.trim();
-        if (monthStr.isEmpty())
-            continue;
-
-        int month = monthStr.toInt();
-        if (month >= 1 && month <= 12) {
-            months.push_back(month);
-        }
-    }
-
-    return months;
-}
-
-/**
- * Convert string frequency to enum
- */
-RecurrenceFrequency CalendarStreamParser::frequencyFromString(const String& freqStr)
-{
-    if (freqStr == "YEARLY")
-        return RecurrenceFrequency::YEARLY;
-    if (freqStr == "MONTHLY")
-        return RecurrenceFrequency::MONTHLY;
-    if (freqStr == "WEEKLY")
-        return RecurrenceFrequency::WEEKLY;
-    if (freqStr == "DAILY")
-        return RecurrenceFrequency::DAILY;
-    if (freqStr == "HOURLY")
-        return RecurrenceFrequency::HOURLY;
-    if (freqStr == "MINUTELY")
-        return RecurrenceFrequency::MINUTELY;
-    if (freqStr == "SECONDLY")
-        return RecurrenceFrequency::SECONDLY;
-    return RecurrenceFrequency::NONE;
-}
-
-/**
- * Find the first occurrence of a recurring event on or after startDate.
- * Uses tm struct arithmetic to efficiently skip forward from eventStart.
- *
- * @param eventStart The DTSTART of the recurring event
- * @param startDate The query range start (find first occurrence on/after this)
- * @param endDate The query range end (first occurrence must be <= this)
- * @param interval The INTERVAL value (1 = every period, 2 = every 2 periods, etc.)
- * @param freq The frequency (YEARLY, MONTHLY, WEEKLY, DAILY)
- * @param count Optional COUNT limit (-1 = no limit). If set, checks if recurrence completed before
- * startDate
- * @return The timestamp of the first occurrence on/after startDate, or -1 if none exists
- */
-time_t CalendarStreamParser::findFirstOccurrence(time_t eventStart,
-    time_t startDate,
-    time_t endDate,
-    int interval,
-    RecurrenceFrequency freq,
-    int count)
-{
-    // Validate input
-    if (eventStart < 0 || startDate < 0 || endDate < 0 || startDate > endDate || interval < 1) {
-        return -1; // Invalid parameters
-    }
-
-    // If event starts after query range, no occurrence in range
-    if (eventStart > endDate) {
-        return -1;
-    }
-
-    // If COUNT is specified, check if the recurrence would complete before startDate
-    if (count > 0) {
-        // Calculate where the Nth (last) occurrence would be (using GMT)
-        struct tm lastOccurrenceTm;
-        memcpy(&lastOccurrenceTm, gmtime(&eventStart), sizeof(struct tm));
-
-        switch (freq) {
-        case RecurrenceFrequency::YEARLY:
-            lastOccurrenceTm.tm_year += (count - 1) * interval;
-            break;
-        case RecurrenceFrequency::MONTHLY:
-            lastOccurrenceTm.tm_mon += (count - 1) * interval;
-            break;
-        case RecurrenceFrequency::WEEKLY:
-            lastOccurrenceTm.tm_mday += (count - 1) * interval * 7;
-            break;
-        case RecurrenceFrequency::DAILY:
-            lastOccurrenceTm.tm_mday += (count - 1) * interval;
-            break;
-        default:
-            break;
-        }
-
-        time_t lastOccurrence = portable_timegm(&lastOccurrenceTm);
-
-        // If the last occurrence is before startDate, the recurrence is complete
-        if (lastOccurrence < startDate) {
-            return -1;
-        }
-    }
-
-    // If event starts within query range, return event start
-    if (eventStart >= startDate && eventStart <= endDate) {
-        return eventStart;
-    }
-
-    // Event starts before query range - calculate first occurrence >= startDate
-    // Use GMT/UTC consistently to avoid timezone conversion issues
-    struct tm eventTm, startTm;
-    memcpy(&eventTm, gmtime(&eventStart), sizeof(struct tm));
-    memcpy(&startTm, gmtime(&startDate), sizeof(struct tm));
-
-    if (freq == RecurrenceFrequency::YEARLY) {
-        // Calculate years between event start and query start
-        int eventYear = eventTm.tm_year + 1900;
-        int startYear = startTm.tm_year + 1900;
-        int yearsDiff = startYear - eventYear;
-
-        if (yearsDiff > 0) {
-            // Calculate how many intervals to skip
-            int intervalsToSkip = (yearsDiff + interval - 1) / interval; // Ceiling division
-            eventTm.tm_year += intervalsToSkip * interval;
-
-            time_t candidate = portable_timegm(&eventTm);
-            // If we undershot, advance one interval
-            if (candidate < startDate) {
-                eventTm.tm_year += interval;
-                candidate = portable_timegm(&eventTm);
-            }
-            // Validate candidate is within range
-            return (candidate <= endDate) ? candidate : -1;
-        }
-    } else if (freq == RecurrenceFrequency::MONTHLY) {
-        // Calculate months between event start and query start
-        int monthsDiff = (startTm.tm_year - eventTm.tm_year) * 12 + (startTm.tm_mon - eventTm.tm_mon);
-
-        if (monthsDiff > 0) {
-            // Calculate how many intervals to skip
-            int intervalsToSkip = (monthsDiff + interval - 1) / interval; // Ceiling division
-            eventTm.tm_mon += intervalsToSkip * interval;
-
-            time_t candidate = portable_timegm(&eventTm); // portable_timegm normalizes year overflow
-            // If we undershot, advance one interval
-            if (candidate < startDate) {
-                eventTm.tm_mon += interval;
-                candidate = portable_timegm(&eventTm);
-            }
-            // Validate candidate is within range
-            return (candidate <= endDate) ? candidate : -1;
-        }
-    } else if (freq == RecurrenceFrequency::WEEKLY) {
-        // Calculate days between event start and query start
-        int daysDiff = (startDate - eventStart) / 86400;
-
-        if (daysDiff > 0) {
-            // Calculate how many week intervals to skip
-            int weeksDiff = daysDiff / 7;
-            int intervalsToSkip = (weeksDiff + interval - 1) / interval; // Ceiling division
-            eventTm.tm_mday += intervalsToSkip * interval * 7;
-
-            time_t candidate = portable_timegm(&eventTm); // portable_timegm normalizes
-            // If we undershot, advance one interval
-            if (candidate < startDate) {
-                eventTm.tm_mday += interval * 7;
-                candidate = portable_timegm(&eventTm);
-            }
-            // Validate candidate is within range
-            return (candidate <= endDate) ? candidate : -1;
-        }
-    } else if (freq == RecurrenceFrequency::DAILY) {
-        // Calculate days between event start and query start
-        int daysDiff = (startDate - eventStart) / 86400;
-
-        if (daysDiff >= 0) { // Changed from > 0 to >= 0 to handle same-day cases
-            // Calculate how many intervals to skip
-            int intervalsToSkip = (daysDiff + interval - 1) / interval; // Ceiling division
-            eventTm.tm_mday += intervalsToSkip * interval;
-
-            time_t candidate = portable_timegm(&eventTm); // portable_timegm normalizes
-            // If we undershot, advance one interval
-            if (candidate < startDate) {
-                eventTm.tm_mday += interval;
-                candidate = portable_timegm(&eventTm);
-            }
-            // Validate candidate is within range
-            return (candidate <= endDate) ? candidate : -1;
-        }
-    }
-
-    // Fallback: no valid occurrence found
-    return -1;
-}
-
-String CalendarStreamParser::readLineFromStream(Stream* stream, bool& eof)
-{
-    String line = "";
-    eof = false;
-
-    if (!stream) {
-        eof = true;
-        return line;
-    }
-
-    // Wait for data with timeout (for network streams)
-    int retries = 0;
-    const int maxRetries = 100; // 10 seconds total (100 * 100ms)
-    while (!stream->available() && retries < maxRetries) {
-        delay(100);
-        retries++;
-    }
-
-    if (!stream->available()) {
-        eof = true;
-        return line;
-    }
-
-    while (stream->available()) {
-        char c = stream->read();
-
-        if (c == '\r') {
-            if (stream->available() && stream->peek() == '\n') {
-                stream->read();
-            }
-            break;
-        } else if (c == '\n') {
-            break;
-        } else {
-            line += c;
-        }
-
-        if (line.length() > 1024) {
-            break;
-        }
-    }
-
-    // Don't set EOF just because buffer is empty - check if we got a line
-    if (line.isEmpty() && !stream->available()) {
-        // Try one more time after a short delay
-        delay(100);
-        if (!stream->available()) {
-            eof = true;
-        }
-    }
-
-    return line;
+    tm.tm_isdst = -1; // Let mktime determine DST
+    return TimeZoneEngine::makeLocal(tm);
 }
 
 String CalendarStreamParser::extractValue(const String& line, const String& property)
@@ -1072,10 +1457,13 @@ String CalendarStreamParser::extractValue(const String& line, const String& prop
  * This version:
  * - Validates all inputs clearly
  * - Handles non-recurring events simply
- * - Uses findFirstOccurrence for efficiency
+ * - Jumps straight to the rule period containing startDate
  * - Stops naturally when COUNT/UNTIL/endDate is reached
  * - No hardcoded iteration limits
  *
+ * Occurrences are produced by iterateOccurrences() and copied one by one;
+ * callers that discard most of them should use the iterator directly.
+ *
  * @param event The event to expand (can be recurring or non-recurring)
  * @param startDate Start of query range (inclusive)
  * @param endDate End of query range (inclusive)
@@ -1087,6 +1475,32 @@ std::vector<CalendarEvent*> CalendarStreamParser::expandRecurringEventV2(Calenda
 {
     std::vector<CalendarEvent*> occurrences;
 
+    OccurrenceIterator it = iterateOccurrences(event, startDate, endDate);
+    time_t start, end;
+    while (it.next(start, end)) {
+        occurrences.push_back(materializeOccurrence(event, start, end));
+    }
+
+    DEBUG_VERBOSE_PRINTF(">>> expandRecurringEventV2: Created %d occurrences in %d steps\n",
+        (int)occurrences.size(),
+        it.getStepCount());
+
+    return occurrences;
+}
+
+/**
+ * Create the lazy occurrence generator for an event
+ *
+ * Performs the input validation of expandRecurringEventV2(), compiles the
+ * RRULE and positions the RRuleExpander on the first period in range.
+ * Invalid input yields an exhausted iterator.
+ */
+OccurrenceIterator CalendarStreamParser::iterateOccurrences(const CalendarEvent* event,
+    time_t startDate,
+    time_t endDate)
+{
+    OccurrenceIterator it;
+
     // ========================================================================
     // Step 1: Input Validation
     // ========================================================================
@@ -1094,31 +1508,40 @@ std::vector<CalendarEvent*> CalendarStreamParser::expandRecurringEventV2(Calenda
     // Validate event pointer
     if (!event) {
         DEBUG_ERROR_PRINTLN("expandRecurringEventV2: NULL event");
-        return occurrences;
+        return it;
     }
 
     // Validate date range
     if (startDate < 0 || endDate < 0) {
         DEBUG_ERROR_PRINTLN("expandRecurringEventV2: Invalid date range (negative values)");
-        return occurrences;
+        return it;
     }
 
     if (startDate > endDate) {
         DEBUG_ERROR_PRINTLN("expandRecurringEventV2: Invalid date range (start > end)");
-        return occurrences;
+        return it;
     }
 
     // Validate event times
     if (event->startTime < 0 || event->endTime < 0) {
         DEBUG_ERROR_PRINTLN("expandRecurringEventV2: Invalid event times (negative values)");
-        return occurrences;
+        return it;
     }
 
     if (event->endTime < event->startTime) {
         DEBUG_ERROR_PRINTLN("expandRecurringEventV2: Invalid event times (end < start)");
-        return occurrences;
+        return it;
     }
 
+    it.eventStart = event->startTime;
+    it.duration = event->endTime - event->startTime;
+    it.startDate = startDate;
+    it.endDate = endDate;
+    it.effectiveEndDate = endDate;
+    it.maxOccurrences = MAX_OCCURRENCES_PER_QUERY;
+    it.uidHash = RecurrenceOverrideIndex::hashUid(event->uid);
+    it.overrides = &overrideIndex;
+
     // ========================================================================
     // Step 2: Handle Non-Recurring Events
     // ========================================================================
@@ -1126,22 +1549,15 @@ std::vector<CalendarEvent*> CalendarStreamParser::expandRecurringEventV2(Calenda
     if (!event->isRecurring) {
         DEBUG_VERBOSE_PRINTLN("expandRecurringEventV2: Non-recurring event");
 
-        // Check if event overlaps with query range
-        // Event overlaps if:
-        //   - Event starts before/at endDate, AND
-        //   - Event ends after/at startDate
+        // Event overlaps if it starts before/at endDate and ends after/at startDate
         bool overlaps = (event->startTime <= endDate) && (event->endTime >= startDate);
+        it.freq = RecurrenceFrequency::NONE;
+        it.finished = !overlaps;
 
-        if (overlaps) {
-            // Create a copy of the event
-            CalendarEvent* occurrence = new CalendarEvent(*event);
-            occurrences.push_back(occurrence);
-            DEBUG_VERBOSE_PRINTLN("expandRecurringEventV2: Added non-recurring event");
-        } else {
+        if (!overlaps) {
             DEBUG_VERBOSE_PRINTLN("expandRecurringEventV2: Non-recurring event outside range");
         }
-
-        return occurrences;
+        return it;
     }
 
     // ========================================================================
@@ -1150,861 +1566,160 @@ std::vector<CalendarEvent*> CalendarStreamParser::expandRecurringEventV2(Calenda
 
     DEBUG_VERBOSE_PRINTLN("expandRecurringEventV2: Recurring event");
 
-    // Parse RRULE
-    RRuleComponents rule = parseRRule(event->rrule);
-    if (!rule.isValid()) {
+    // Parse RRULE (once per distinct rule text)
+    CompiledRRule compiled;
+    if (!compileRRule(event->rrule, compiled)) {
         DEBUG_ERROR_PRINTLN("expandRecurringEventV2: Invalid RRULE");
-        return occurrences;
+        return it;
     }
 
-    // Convert frequency string to enum
-    RecurrenceFrequency freq = frequencyFromString(rule.freq);
-
-    // Dispatch to frequency-specific handler
-    switch (freq) {
-    case RecurrenceFrequency::YEARLY:
-        DEBUG_VERBOSE_PRINTLN("expandRecurringEventV2: YEARLY frequency");
-        return expandYearlyV2(event, rule, startDate, endDate);
-
-    case RecurrenceFrequency::MONTHLY:
-        DEBUG_VERBOSE_PRINTLN("expandRecurringEventV2: MONTHLY frequency");
-        return expandMonthlyV2(event, rule, startDate, endDate);
+    it.freq = compiled.freq;
+    it.maxCount = (compiled.count > 0) ? compiled.count : INT_MAX;
 
-    case RecurrenceFrequency::WEEKLY:
-        DEBUG_VERBOSE_PRINTLN("expandRecurringEventV2: WEEKLY frequency");
-        return expandWeeklyV2(event, rule, startDate, endDate);
-
-    case RecurrenceFrequency::DAILY:
-        DEBUG_VERBOSE_PRINTLN("expandRecurringEventV2: DAILY frequency");
-        return expandDailyV2(event, rule, startDate, endDate);
-
-    case RecurrenceFrequency::HOURLY:
-    case RecurrenceFrequency::MINUTELY:
-    case RecurrenceFrequency::SECONDLY:
-        DEBUG_WARN_PRINTLN("expandRecurringEventV2: Sub-daily frequencies not yet supported");
-        return occurrences;
-
-    case RecurrenceFrequency::NONE:
-    default:
-        DEBUG_ERROR_PRINTLN("expandRecurringEventV2: Unknown frequency");
-        return occurrences;
-    }
-}
-
-/**
- * V2: Expand YEARLY recurring events
- *
- * This method handles expansion of events that recur yearly (e.g., birthdays, anniversaries).
- *
- * Algorithm:
- * 1. Calculate event duration (endTime - startTime) to preserve for all occurrences
- * 2. Determine effective end date (consider UNTIL if present)
- * 3. Use findFirstOccurrence to jump to first valid occurrence >= startDate
- *    - This respects COUNT limit and returns -1 if recurrence already completed
- * 4. Iterate year by year (respecting INTERVAL):
- *    a. Check COUNT limit - stop if reached
- *    b. Check if current year exceeds endDate - stop if yes
- *    c. Check UNTIL limit - stop if exceeded
- *    d. Apply BYMONTH filter (if specified) - only generate on specified months
- *    e. Apply BYMONTHDAY filter (if specified) - only generate on specified days
- *    f. Create occurrence with same time as original event
- *    g. Add to results if within query range [startDate, endDate]
- *    h. Advance to next interval (year += interval)
- * 5. Return list of occurrences
- *
- * No hardcoded limits - stops naturally when:
- * - COUNT limit reached, OR
- * - UNTIL date exceeded, OR
- * - Past endDate (query range end)
- */
-std::vector<CalendarEvent*> CalendarStreamParser::expandYearlyV2(CalendarEvent* event,
-    const RRuleComponents& rule,
-    time_t startDate,
-    time_t endDate)
-{
-    std::vector<CalendarEvent*> occurrences;
-
-    DEBUG_VERBOSE_PRINTLN(">>> expandYearlyV2: Starting YEARLY expansion");
-    DEBUG_VERBOSE_PRINTF("    Event: %s\n", event->summary.c_str());
-    DEBUG_VERBOSE_PRINTF("    RRULE: %s\n", event->rrule.c_str());
-
-    // Print rule components (verbose)
-    DEBUG_VERBOSE_PRINTF("    Frequency: %s\n", rule.freq.c_str());
-    DEBUG_VERBOSE_PRINTF("    Interval: %d\n", rule.interval);
-    DEBUG_VERBOSE_PRINTF("    COUNT: %d\n", rule.count);
-    DEBUG_VERBOSE_PRINTF("    UNTIL: %ld\n", rule.until);
-    DEBUG_VERBOSE_PRINTF("    BYMONTH: %s\n", rule.byMonth.c_str());
-    DEBUG_VERBOSE_PRINTF("    BYMONTHDAY: %s\n", rule.byMonthDay.c_str());
-
-#if DEBUG_LEVEL >= DEBUG_VERBOSE
-    // Print query range (verbose)
-    struct tm* startTm = localtime(&startDate);
-    struct tm* endTm = localtime(&endDate);
-    DEBUG_VERBOSE_PRINTF("    Query range: %04d-%02d-%02d to %04d-%02d-%02d\n",
-        startTm->tm_year + 1900,
-        startTm->tm_mon + 1,
-        startTm->tm_mday,
-        endTm->tm_year + 1900,
-        endTm->tm_mon + 1,
-        endTm->tm_mday);
-
-    // Print event start (verbose)
-    struct tm* eventTm = localtime(&event->startTime);
-    DEBUG_VERBOSE_PRINTF("    Event starts: %04d-%02d-%02d %02d:%02d:%02d\n",
-        eventTm->tm_year + 1900,
-        eventTm->tm_mon + 1,
-        eventTm->tm_mday,
-        eventTm->tm_hour,
-        eventTm->tm_min,
-        eventTm->tm_sec);
-#endif // DEBUG_LEVEL >= DEBUG_VERBOSE
-
-    // ========================================================================
-    // Step 1: Calculate event duration
-    // ========================================================================
-    time_t duration = event->endTime - event->startTime;
-    DEBUG_VERBOSE_PRINTF("    Duration: %ld seconds\n", duration);
-
-    // ========================================================================
-    // Step 2: Determine effective end date (min of query endDate and UNTIL)
-    // ========================================================================
-    time_t effectiveEndDate = endDate;
-    if (rule.until > 0 && rule.until < effectiveEndDate) {
-        effectiveEndDate = rule.until;
+    // Effective end date: min of query endDate and UNTIL
+    if (compiled.until > 0 && compiled.until < it.effectiveEndDate) {
+        it.effectiveEndDate = compiled.until;
         DEBUG_VERBOSE_PRINTLN("    Using UNTIL as effective end date");
     }
 
-    // ========================================================================
-    // Step 3: Use findFirstOccurrence to jump to first valid year
-    // ========================================================================
-    int interval = (rule.interval > 0) ? rule.interval : 1;
-    int count = (rule.count > 0) ? rule.count : -1;
-
-    DEBUG_VERBOSE_PRINTF(
-        "    Calling findFirstOccurrence with interval=%d, count=%d\n", interval, count);
-
-    time_t firstOccurrence = findFirstOccurrence(event->startTime,
-        startDate,
-        effectiveEndDate,
-        interval,
-        RecurrenceFrequency::YEARLY,
-        count);
-
-    if (firstOccurrence < 0) {
-        DEBUG_VERBOSE_PRINTLN(
-            "    findFirstOccurrence returned -1 (recurrence completed or outside range)");
-        return occurrences;
-    }
-
-#if DEBUG_LEVEL >= DEBUG_VERBOSE
-    struct tm* firstTm = localtime(&firstOccurrence);
-    DEBUG_VERBOSE_PRINTF("    First occurrence: %04d-%02d-%02d %02d:%02d:%02d\n",
-        firstTm->tm_year + 1900,
-        firstTm->tm_mon + 1,
-        firstTm->tm_mday,
-        firstTm->tm_hour,
-        firstTm->tm_min,
-        firstTm->tm_sec);
-#endif // DEBUG_LEVEL >= DEBUG_VERBOSE
-
-    // ========================================================================
-    // Step 4: Parse BYMONTH and BYMONTHDAY filters if present
-    // ========================================================================
-    std::vector<int> byMonthList = parseByMonth(rule.byMonth);
-    std::vector<int> byMonthDayList = parseByMonthDay(rule.byMonthDay);
-
-    if (!byMonthList.empty()) {
-        DEBUG_VERBOSE_PRINTF("    BYMONTH filter: %d month(s) specified\n",
-            (int)byMonthList.size());
-        for (size_t i = 0; i < byMonthList.size(); i++) {
-            DEBUG_VERBOSE_PRINTF("      Month: %d\n", byMonthList[i]);
-        }
-    } else {
-        DEBUG_VERBOSE_PRINTLN("    BYMONTH filter: none (all months)");
-    }
-
-    if (!byMonthDayList.empty()) {
-        DEBUG_VERBOSE_PRINTF("    BYMONTHDAY filter: %d day(s) specified\n",
-            (int)byMonthDayList.size());
-        for (size_t i = 0; i < byMonthDayList.size(); i++) {
-            DEBUG_VERBOSE_PRINTF("      Day: %d\n", byMonthDayList[i]);
-        }
-    } else {
-        DEBUG_VERBOSE_PRINTLN("    BYMONTHDAY filter: none (all days)");
-    }
+    DEBUG_VERBOSE_PRINTF("    RRULE: %s (interval=%d, count=%d, until=%ld)\n",
+        event->rrule.c_str(),
+        compiled.interval,
+        compiled.count,
+        (long)compiled.until);
 
-    // ========================================================================
-    // Step 5: Calculate starting occurrence index and iterate year by year
-    // ========================================================================
+    // Expand in the wall-clock time of DTSTART's TZID; UTC and floating
+    // DTSTARTs follow the device's local zone
+    const CompiledTimeZone* zone = event->timezone.isEmpty() ? nullptr : resolveZone(event->timezone);
 
-    // Calculate how many occurrences happened before firstOccurrence
-    int occurrencesBeforeRange = 0;
-    if (count > 0 && firstOccurrence > event->startTime) {
-        struct tm* eventStartTm = localtime(&event->startTime);
-        struct tm* firstOccTm = localtime(&firstOccurrence);
-        int yearsDiff = (firstOccTm->tm_year + 1900) - (eventStartTm->tm_year + 1900);
-        occurrencesBeforeRange = yearsDiff / interval;
-        DEBUG_VERBOSE_PRINTF("    Occurrences before query range: %d\n", occurrencesBeforeRange);
+    it.expander.begin(compiled, event->startTime, zone, startDate, it.effectiveEndDate);
+    if (compiled.count > 0) {
+        // Periods skipped by begin() held exactly one instance each
+        it.occurrenceIndex = (int)it.expander.getFirstPeriod();
+        DEBUG_VERBOSE_PRINTF("    Occurrences before query range: %d\n", it.occurrenceIndex);
     }
 
-    // Start iterating from firstOccurrence
-    struct tm currentTm;
-    memcpy(&currentTm, localtime(&firstOccurrence), sizeof(struct tm));
-
-    int absoluteOccurrenceIndex = occurrencesBeforeRange; // Track absolute occurrence number
-    int maxCount = (count > 0) ? count : INT_MAX;
-
-    DEBUG_VERBOSE_PRINTLN(">>> expandYearlyV2: Starting year-by-year iteration");
-
-    while (true) {
-        // Create occurrence timestamp
-        time_t occurrenceTime = mktime(&currentTm);
-
-        // Check if past effective end date
-        if (occurrenceTime > effectiveEndDate) {
-            DEBUG_VERBOSE_PRINTLN("    Reached effective end date, stopping");
-            break;
-        }
-
-        // Apply BYMONTH filter (if specified)
-        bool monthMatches = byMonthList.empty() || (std::find(byMonthList.begin(), byMonthList.end(), currentTm.tm_mon + 1) != byMonthList.end());
-
-        // Apply BYMONTHDAY filter (if specified)
-        bool dayMatches = byMonthDayList.empty() || (std::find(byMonthDayList.begin(), byMonthDayList.end(), currentTm.tm_mday) != byMonthDayList.end());
-
-        if (monthMatches && dayMatches) {
-            absoluteOccurrenceIndex++;
-
-            DEBUG_VERBOSE_PRINTF("    Occurrence #%d: %04d-%02d-%02d\n",
-                absoluteOccurrenceIndex,
-                currentTm.tm_year + 1900,
-                currentTm.tm_mon + 1,
-                currentTm.tm_mday);
-
-            // Check COUNT limit
-            if (absoluteOccurrenceIndex > maxCount) {
-                DEBUG_VERBOSE_PRINTLN("    Reached COUNT limit, stopping");
-                break;
-            }
+    it.finished = false;
+    return it;
+}
 
-            // Only add to results if within query range
-            if (occurrenceTime >= startDate && occurrenceTime <= endDate) {
-                CalendarEvent* occurrence = new CalendarEvent(*event);
-                occurrence->startTime = occurrenceTime;
-                occurrence->endTime = occurrenceTime + duration;
-
-                // Set date string for display
-                char dateBuffer[32];
-                strftime(dateBuffer, sizeof(dateBuffer), "%Y-%m-%d", &currentTm);
-                occurrence->date = String(dateBuffer);
-
-                occurrences.push_back(occurrence);
-                DEBUG_VERBOSE_PRINTLN("      -> Added to results");
-            } else {
-                DEBUG_VERBOSE_PRINTLN("      -> Outside query range, not added");
-            }
+bool CalendarStreamParser::compileRRule(const String& rrule, CompiledRRule& compiled)
+{
+    bool valid;
+    const CompiledRRule* cached = rruleCache.find(rrule, valid);
+    if (cached) {
+        if (valid) {
+            compiled = *cached;
         }
-
-        // Advance to next year (respecting interval)
-        currentTm.tm_year += interval;
-        mktime(&currentTm); // Normalize
+        return valid;
     }
 
-    DEBUG_INFO_PRINTF(">>> expandYearlyV2: Complete. Created %d occurrences\n",
-        (int)occurrences.size());
-    return occurrences;
+    RRuleComponents rule = parseRRule(rrule);
+    valid = rule.isValid() && compiled.compile(rule);
+    rruleCache.insert(rrule, compiled, valid);
+    return valid;
 }
 
-/**
- * V2: Expand MONTHLY recurring events
- * TODO: Implementation pending
- */
-std::vector<CalendarEvent*> CalendarStreamParser::expandMonthlyV2(CalendarEvent* event,
-    const RRuleComponents& rule,
-    time_t startDate,
-    time_t endDate)
+CalendarEvent* CalendarStreamParser::materializeOccurrence(const CalendarEvent* event,
+    time_t start,
+    time_t end)
 {
-    std::vector<CalendarEvent*> occurrences;
-
-    DEBUG_VERBOSE_PRINTLN(">>> expandMonthlyV2: Starting MONTHLY expansion");
-
-    // ========================================================================
-    // Step 1: Calculate event duration
-    // ========================================================================
-    time_t duration = event->endTime - event->startTime;
-    DEBUG_VERBOSE_PRINTF("    Duration: %ld seconds\n", duration);
-
-    // ========================================================================
-    // Step 2: Determine effective end date (respect UNTIL if present)
-    // ========================================================================
-    time_t effectiveEndDate = endDate;
-    if (rule.until > 0 && rule.until < effectiveEndDate) {
-        effectiveEndDate = rule.until;
-        DEBUG_VERBOSE_PRINTLN("    Using UNTIL as effective end date");
-    }
-
-#if DEBUG_LEVEL >= DEBUG_VERBOSE
-    struct tm* startTm = localtime(&startDate);
-    struct tm* endTm = localtime(&effectiveEndDate);
-    struct tm* eventTm = localtime(&event->startTime);
-
-    DEBUG_VERBOSE_PRINTF("    Query range: %04d-%02d-%02d to %04d-%02d-%02d\n",
-        startTm->tm_year + 1900,
-        startTm->tm_mon + 1,
-        startTm->tm_mday,
-        endTm->tm_year + 1900,
-        endTm->tm_mon + 1,
-        endTm->tm_mday);
-
-    DEBUG_VERBOSE_PRINTF("    Event starts: %04d-%02d-%02d %02d:%02d:%02d\n",
-        eventTm->tm_year + 1900,
-        eventTm->tm_mon + 1,
-        eventTm->tm_mday,
-        eventTm->tm_hour,
-        eventTm->tm_min,
-        eventTm->tm_sec);
-#endif // DEBUG_LEVEL >= DEBUG_VERBOSE
+    CalendarEvent* occurrence = new CalendarEvent(*event);
+    occurrence->startTime = start;
+    occurrence->endTime = end;
+
+    // Set date string for display (local date of the occurrence)
+    struct tm localTm;
+    TimeZoneEngine::localTime(start, localTm);
+    char dateBuffer[32];
+    strftime(dateBuffer, sizeof(dateBuffer), "%Y-%m-%d", &localTm);
+    occurrence->date = String(dateBuffer);
+
+    return occurrence;
+}
 
-    // ========================================================================
-    // Step 3: Use findFirstOccurrence to jump to first valid month
-    // ========================================================================
-    int interval = (rule.interval > 0) ? rule.interval : 1;
-    int count = (rule.count > 0) ? rule.count : -1;
-
-    DEBUG_VERBOSE_PRINTF(
-        "    Calling findFirstOccurrence with interval=%d, count=%d\n", interval, count);
-
-    time_t firstOccurrence = findFirstOccurrence(event->startTime,
-        startDate,
-        effectiveEndDate,
-        interval,
-        RecurrenceFrequency::MONTHLY,
-        count);
-
-    if (firstOccurrence < 0) {
-        DEBUG_VERBOSE_PRINTLN(
-            "    findFirstOccurrence returned -1 (recurrence completed or outside range)");
-        return occurrences;
-    }
-
-#if DEBUG_LEVEL >= DEBUG_VERBOSE
-    struct tm* firstTm = localtime(&firstOccurrence);
-    DEBUG_VERBOSE_PRINTF("    First occurrence: %04d-%02d-%02d %02d:%02d:%02d\n",
-        firstTm->tm_year + 1900,
-        firstTm->tm_mon + 1,
-        firstTm->tm_mday,
-        firstTm->tm_hour,
-        firstTm->tm_min,
-        firstTm->tm_sec);
-#endif // DEBUG_LEVEL >= DEBUG_VERBOSE
+// ============================================================================
+// OccurrenceIterator
+// ============================================================================
 
-    // ========================================================================
-    // Step 4: Parse BYMONTHDAY filter if present
-    // ========================================================================
-    std::vector<int> byMonthDayList = parseByMonthDay(rule.byMonthDay);
+OccurrenceIterator::OccurrenceIterator()
+    : freq(RecurrenceFrequency::NONE)
+    , finished(true)
+    , eventStart(0)
+    , duration(0)
+    , startDate(0)
+    , endDate(0)
+    , effectiveEndDate(0)
+    , occurrenceIndex(0)
+    , maxCount(INT_MAX)
+    , yielded(0)
+    , maxOccurrences(INT_MAX)
+    , uidHash(0)
+    , overrides(nullptr)
+{
+}
 
-    if (!byMonthDayList.empty()) {
-        DEBUG_VERBOSE_PRINTF("    BYMONTHDAY filter: %d day(s) specified\n",
-            (int)byMonthDayList.size());
-        for (size_t i = 0; i < byMonthDayList.size(); i++) {
-            DEBUG_VERBOSE_PRINTF("      Day: %d\n", byMonthDayList[i]);
-        }
-    } else {
-        DEBUG_VERBOSE_PRINTLN("    BYMONTHDAY filter: none (use original day of month)");
+bool OccurrenceIterator::next(time_t& start, time_t& end)
+{
+    if (finished) {
+        return false;
     }
 
-    // ========================================================================
-    // Step 5: Calculate starting occurrence index and iterate month by month
-    // ========================================================================
-
-    // Calculate how many occurrences happened before firstOccurrence
-    int occurrencesBeforeRange = 0;
-    if (count > 0 && firstOccurrence > event->startTime) {
-        struct tm* eventStartTm = localtime(&event->startTime);
-        struct tm* firstOccTm = localtime(&firstOccurrence);
-
-        // Calculate months difference
-        int yearsDiff = (firstOccTm->tm_year) - (eventStartTm->tm_year);
-        int monthsDiff = yearsDiff * 12 + (firstOccTm->tm_mon - eventStartTm->tm_mon);
-
-        occurrencesBeforeRange = monthsDiff / interval;
-        DEBUG_VERBOSE_PRINTF("    Occurrences before query range: %d\n", occurrencesBeforeRange);
+    if (freq == RecurrenceFrequency::NONE) {
+        // Non-recurring event: the event itself, once
+        finished = true;
+        start = eventStart;
+        end = eventStart + duration;
+        return true;
     }
 
-    // Start iterating from firstOccurrence
-    struct tm currentTm;
-    memcpy(&currentTm, localtime(&firstOccurrence), sizeof(struct tm));
-
-    int absoluteOccurrenceIndex = occurrencesBeforeRange; // Track absolute occurrence number
-    int maxCount = (count > 0) ? count : INT_MAX;
-
-    DEBUG_VERBOSE_PRINTLN(">>> expandMonthlyV2: Starting month-by-month iteration");
-
-    while (true) {
-        // Create occurrence timestamp
-        time_t occurrenceTime = mktime(&currentTm);
-
-        // Check if past effective end date
-        if (occurrenceTime > effectiveEndDate) {
+    time_t occurrence;
+    while (!finished) {
+        // Instances come in ascending order, so the first one past the
+        // effective end date (endDate or UNTIL) ends the iteration
+        if (!expander.next(occurrence) || occurrence > effectiveEndDate) {
             DEBUG_VERBOSE_PRINTLN("    Reached effective end date, stopping");
+            finished = true;
             break;
         }
 
-        // Apply BYMONTHDAY filter (if specified)
-        // Note: For MONTHLY recurrence, we don't filter by month (already iterating monthly)
-        bool dayMatches = byMonthDayList.empty() || (std::find(byMonthDayList.begin(), byMonthDayList.end(), currentTm.tm_mday) != byMonthDayList.end());
-
-        if (dayMatches) {
-            absoluteOccurrenceIndex++;
-
-            DEBUG_VERBOSE_PRINTF("    Occurrence #%d: %04d-%02d-%02d\n",
-                absoluteOccurrenceIndex,
-                currentTm.tm_year + 1900,
-                currentTm.tm_mon + 1,
-                currentTm.tm_mday);
-
-            // Check COUNT limit
-            if (absoluteOccurrenceIndex > maxCount) {
-                DEBUG_VERBOSE_PRINTLN("    Reached COUNT limit, stopping");
-                break;
-            }
-
-            // Only add to results if within query range
-            if (occurrenceTime >= startDate && occurrenceTime <= endDate) {
-                CalendarEvent* occurrence = new CalendarEvent(*event);
-                occurrence->startTime = occurrenceTime;
-                occurrence->endTime = occurrenceTime + duration;
-
-                // Set date string for display
-                char dateBuffer[32];
-                strftime(dateBuffer, sizeof(dateBuffer), "%Y-%m-%d", &currentTm);
-                occurrence->date = String(dateBuffer);
-
-                occurrences.push_back(occurrence);
-                DEBUG_VERBOSE_PRINTLN("      -> Added to results");
-            } else {
-                DEBUG_VERBOSE_PRINTLN("      -> Outside query range, not added");
-            }
-        }
-
-        // Advance to next month (respecting interval)
-        currentTm.tm_mon += interval;
-        mktime(&currentTm); // Normalize (handles month/year overflow)
-    }
-
-    DEBUG_INFO_PRINTF(">>> expandMonthlyV2: Complete. Created %d occurrences\n",
-        (int)occurrences.size());
-
-    return occurrences;
-}
-
-/**
- * V2: Expand WEEKLY recurring events
- * TODO: Implementation pending
- */
-std::vector<CalendarEvent*> CalendarStreamParser::expandWeeklyV2(CalendarEvent* event,
-    const RRuleComponents& rule,
-    time_t startDate,
-    time_t endDate)
-{
-    std::vector<CalendarEvent*> occurrences;
-
-    DEBUG_VERBOSE_PRINTLN(">>> expandWeeklyV2: Starting WEEKLY expansion");
-
-    // ========================================================================
-    // Step 1: Calculate event duration
-    // ========================================================================
-    time_t duration = event->endTime - event->startTime;
-    DEBUG_VERBOSE_PRINTF("    Duration: %ld seconds\n", duration);
-
-    // ========================================================================
-    // Step 2: Determine effective end date (respect UNTIL if present)
-    // ========================================================================
-    time_t effectiveEndDate = endDate;
-    if (rule.until > 0 && rule.until < effectiveEndDate) {
-        effectiveEndDate = rule.until;
-        DEBUG_VERBOSE_PRINTLN("    Using UNTIL as effective end date");
-    }
-
-    // Use GMT/UTC consistently to avoid timezone conversion issues
-    struct tm eventTmCopy;
-    memcpy(&eventTmCopy, gmtime(&event->startTime), sizeof(struct tm));
-    struct tm* eventTm = &eventTmCopy;
-#if DEBUG_LEVEL >= DEBUG_VERBOSE
-    struct tm* startTm = gmtime(&startDate);
-    struct tm* endTm = gmtime(&effectiveEndDate);
-
-    DEBUG_VERBOSE_PRINTF("    Query range: %04d-%02d-%02d to %04d-%02d-%02d\n",
-        startTm->tm_year + 1900,
-        startTm->tm_mon + 1,
-        startTm->tm_mday,
-        endTm->tm_year + 1900,
-        endTm->tm_mon + 1,
-        endTm->tm_mday);
-
-    DEBUG_VERBOSE_PRINTF("    Event starts: %04d-%02d-%02d %02d:%02d:%02d (day: %d)\n",
-        eventTm->tm_year + 1900,
-        eventTm->tm_mon + 1,
-        eventTm->tm_mday,
-        eventTm->tm_hour,
-        eventTm->tm_min,
-        eventTm->tm_sec,
-        eventTm->tm_wday);
-#endif // DEBUG_LEVEL >= DEBUG_VERBOSE
-
-    // ========================================================================
-    // Step 3: Use findFirstOccurrence to jump to first valid week
-    // ========================================================================
-    int interval = (rule.interval > 0) ? rule.interval : 1;
-    int count = (rule.count > 0) ? rule.count : -1;
-
-    DEBUG_VERBOSE_PRINTF(
-        "    Calling findFirstOccurrence with interval=%d, count=%d\n", interval, count);
-
-    time_t firstOccurrence = findFirstOccurrence(event->startTime,
-        startDate,
-        effectiveEndDate,
-        interval,
-        RecurrenceFrequency::WEEKLY,
-        count);
-
-    if (firstOccurrence < 0) {
-        DEBUG_VERBOSE_PRINTLN(
-            "    findFirstOccurrence returned -1 (recurrence completed or outside range)");
-        return occurrences;
-    }
-
-#if DEBUG_LEVEL >= DEBUG_VERBOSE
-    struct tm* firstTm = gmtime(&firstOccurrence);
-    DEBUG_VERBOSE_PRINTF("    First occurrence: %04d-%02d-%02d %02d:%02d:%02d (day: %d)\n",
-        firstTm->tm_year + 1900,
-        firstTm->tm_mon + 1,
-        firstTm->tm_mday,
-        firstTm->tm_hour,
-        firstTm->tm_min,
-        firstTm->tm_sec,
-        firstTm->tm_wday);
-#endif // DEBUG_LEVEL >= DEBUG_VERBOSE
-
-    // ========================================================================
-    // Step 4: Parse BYDAY filter if present
-    // ========================================================================
-    std::vector<int> byDayList = parseByDay(rule.byDay);
-
-    if (!byDayList.empty()) {
-        // Sort byDayList to ensure days are processed in chronological order (Sun=0, Mon=1, ...,
-        // Sat=6)
-        std::sort(byDayList.begin(), byDayList.end());
-
-        DEBUG_VERBOSE_PRINTF("    BYDAY filter: %d day(s) specified\n", (int)byDayList.size());
-        for (size_t i = 0; i < byDayList.size(); i++) {
-            DEBUG_VERBOSE_PRINTF("      Day: %d (0=Sun, 1=Mon, ..., 6=Sat)\n", byDayList[i]);
-        }
-    } else {
-        DEBUG_VERBOSE_PRINTLN("    BYDAY filter: none (use event's original day of week)");
-        // If no BYDAY, use the event's original day of week
-        byDayList.push_back(eventTm->tm_wday);
-    }
-
-    // ========================================================================
-    // Step 5: Calculate starting occurrence index and iterate week by week
-    // ========================================================================
-
-    // Calculate how many occurrences happened before firstOccurrence
-    int occurrencesBeforeRange = 0;
-    if (count > 0 && firstOccurrence > event->startTime) {
-        // Calculate weeks difference
-        int daysDiff = (firstOccurrence - event->startTime) / (24 * 3600);
-        int weeksDiff = daysDiff / 7;
-
-        // Each week can have multiple occurrences based on BYDAY
-        occurrencesBeforeRange = (weeksDiff / interval) * byDayList.size();
-        DEBUG_VERBOSE_PRINTF("    Occurrences before query range: %d\n", occurrencesBeforeRange);
-    }
-
-    // Start iterating from the beginning of the week containing firstOccurrence
-    struct tm currentTm;
-    memcpy(&currentTm, gmtime(&firstOccurrence), sizeof(struct tm));
-
-    // Move back to Sunday (start of week) to check all BYDAY days in this week
-    int daysToSunday = currentTm.tm_wday;
-    currentTm.tm_mday -= daysToSunday;
-    portable_timegm(&currentTm); // Normalize
-
-    int absoluteOccurrenceIndex = occurrencesBeforeRange;
-    int maxCount = (count > 0) ? count : INT_MAX;
-
-    // Extract original local time-of-day to correctly handle DST transitions.
-    // PROBLEM: If an event was created in CET (winter, UTC+1) at 20:30 local = 19:30 UTC,
-    // occurrences generated in CEST (summer, UTC+2) would display as 21:30 (wrong).
-    // FIX: Store the original wall-clock hour/min/sec and re-apply them per occurrence
-    // using mktime(), which applies the correct DST offset for each specific date.
-    struct tm origLocalTmBuf;
-    memcpy(&origLocalTmBuf, localtime(&event->startTime), sizeof(struct tm));
-    int origLocalHour = origLocalTmBuf.tm_hour;
-    int origLocalMin = origLocalTmBuf.tm_min;
-    int origLocalSec = origLocalTmBuf.tm_sec;
-
-    DEBUG_VERBOSE_PRINTLN(">>> expandWeeklyV2: Starting week-by-week iteration");
-
-    while (true) {
-        // For each week, check each day in BYDAY list
-        for (size_t i = 0; i < byDayList.size(); i++) {
-            int targetDay = byDayList[i]; // 0=Sun, 1=Mon, ..., 6=Sat
-
-            // Calculate date for this target day in current week
-            struct tm occurrenceTm = currentTm;
-            occurrenceTm.tm_mday += targetDay;
-            time_t occurrenceTime = portable_timegm(&occurrenceTm);
-
-            // Skip if this occurrence is before event start time
-            if (occurrenceTime < event->startTime) {
-                continue;
-            }
-
-            // Check if past effective end date
-            if (occurrenceTime > effectiveEndDate) {
-                DEBUG_VERBOSE_PRINTLN("    Reached effective end date, stopping");
-                goto done; // Break out of nested loop
-            }
-
-            // This is a valid occurrence
-            absoluteOccurrenceIndex++;
-
-            DEBUG_VERBOSE_PRINTF("    Occurrence #%d: %04d-%02d-%02d (day %d)\n",
-                absoluteOccurrenceIndex,
-                occurrenceTm.tm_year + 1900,
-                occurrenceTm.tm_mon + 1,
-                occurrenceTm.tm_mday,
-                occurrenceTm.tm_wday);
-
-            // Check COUNT limit
-            if (absoluteOccurrenceIndex > maxCount) {
-                DEBUG_VERBOSE_PRINTLN("    Reached COUNT limit, stopping");
-                goto done; // Break out of nested loop
-            }
-
-            // Only add to results if within query range
-            if (occurrenceTime >= startDate && occurrenceTime <= endDate) {
-                CalendarEvent* occurrence = new CalendarEvent(*event);
-
-                // DST-safe occurrence time: occurrenceTime from portable_timegm preserves
-                // the UTC hour from the original event, but when DST changed between the
-                // original event date and this occurrence the local wall-clock time shifts
-                // by ±1 hour. We fix this by reconstructing the timestamp from the local
-                // date of the occurrence + the original local hour/min/sec, then calling
-                // mktime() so it correctly resolves DST for this specific date.
-                struct tm localOccTm;
-                memcpy(&localOccTm, localtime(&occurrenceTime), sizeof(struct tm));
-                localOccTm.tm_hour = origLocalHour;
-                localOccTm.tm_min = origLocalMin;
-                localOccTm.tm_sec = origLocalSec;
-                localOccTm.tm_isdst = -1; // Let mktime determine DST for this date
-                time_t dstCorrectedTime = mktime(&localOccTm);
-
-                occurrence->startTime = dstCorrectedTime;
-                occurrence->endTime = dstCorrectedTime + duration;
-
-                // Set date string for display using the corrected local date
-                char dateBuffer[32];
-                strftime(dateBuffer, sizeof(dateBuffer), "%Y-%m-%d", &localOccTm);
-                occurrence->date = String(dateBuffer);
-
-                occurrences.push_back(occurrence);
-                DEBUG_VERBOSE_PRINTLN("      -> Added to results");
-            } else {
-                DEBUG_VERBOSE_PRINTLN("      -> Outside query range, not added");
+        if (accept(occurrence, start, end)) {
+            if (++yielded > maxOccurrences) {
+                DEBUG_WARN_PRINTF("OccurrenceIterator: Stopping after %d occurrences (per-query cap)\n", maxOccurrences);
+                finished = true;
+                return false;
             }
+            return true;
         }
-
-        // Advance to next week (respecting interval)
-        currentTm.tm_mday += interval * 7;
-        portable_timegm(&currentTm); // Normalize
     }
-
-done:
-    DEBUG_INFO_PRINTF(">>> expandWeeklyV2: Complete. Created %d occurrences\n",
-        (int)occurrences.size());
-
-    return occurrences;
+    return false;
 }
 
-/**
- * V2: Expand DAILY recurring events
- * TODO: Implementation pending
- */
-std::vector<CalendarEvent*> CalendarStreamParser::expandDailyV2(CalendarEvent* event,
-    const RRuleComponents& rule,
-    time_t startDate,
-    time_t endDate)
+// COUNT, EXDATE/RECURRENCE-ID and range checks shared by all frequencies
+bool OccurrenceIterator::accept(time_t occurrence, time_t& start, time_t& end)
 {
-    std::vector<CalendarEvent*> occurrences;
-
-    DEBUG_VERBOSE_PRINTLN(">>> expandDailyV2: Starting DAILY expansion");
-
-    // ========================================================================
-    // Step 1: Calculate event duration
-    // ========================================================================
-    time_t duration = event->endTime - event->startTime;
-    DEBUG_VERBOSE_PRINTF("    Duration: %ld seconds\n", duration);
-
-    // ========================================================================
-    // Step 2: Determine effective end date (respect UNTIL if present)
-    // ========================================================================
-    time_t effectiveEndDate = endDate;
-    if (rule.until > 0 && rule.until < effectiveEndDate) {
-        effectiveEndDate = rule.until;
-        DEBUG_VERBOSE_PRINTLN("    Using UNTIL as effective end date");
-    }
-
-#if DEBUG_LEVEL >= DEBUG_VERBOSE
-    struct tm* startTm = localtime(&startDate);
-    struct tm* endTm = localtime(&effectiveEndDate);
-    struct tm* eventTm = localtime(&event->startTime);
-
-    DEBUG_VERBOSE_PRINTF("    Query range: %04d-%02d-%02d to %04d-%02d-%02d\n",
-        startTm->tm_year + 1900,
-        startTm->tm_mon + 1,
-        startTm->tm_mday,
-        endTm->tm_year + 1900,
-        endTm->tm_mon + 1,
-        endTm->tm_mday);
-
-    DEBUG_VERBOSE_PRINTF("    Event starts: %04d-%02d-%02d %02d:%02d:%02d\n",
-        eventTm->tm_year + 1900,
-        eventTm->tm_mon + 1,
-        eventTm->tm_mday,
-        eventTm->tm_hour,
-        eventTm->tm_min,
-        eventTm->tm_sec);
-#endif // DEBUG_LEVEL >= DEBUG_VERBOSE
+    occurrenceIndex++;
 
-    // ========================================================================
-    // Step 3: Use findFirstOccurrence to jump to first valid day
-    // ========================================================================
-    int interval = (rule.interval > 0) ? rule.interval : 1;
-    int count = (rule.count > 0) ? rule.count : -1;
-
-    DEBUG_VERBOSE_PRINTF(
-        "    Calling findFirstOccurrence with interval=%d, count=%d\n", interval, count);
-
-    time_t firstOccurrence = findFirstOccurrence(
-        event->startTime, startDate, effectiveEndDate, interval, RecurrenceFrequency::DAILY, count);
-
-    if (firstOccurrence < 0) {
-        DEBUG_VERBOSE_PRINTLN(
-            "    findFirstOccurrence returned -1 (recurrence completed or outside range)");
-        return occurrences;
-    }
-
-#if DEBUG_LEVEL >= DEBUG_VERBOSE
-    struct tm* firstTm = localtime(&firstOccurrence);
-    DEBUG_VERBOSE_PRINTF("    First occurrence: %04d-%02d-%02d %02d:%02d:%02d\n",
-        firstTm->tm_year + 1900,
-        firstTm->tm_mon + 1,
-        firstTm->tm_mday,
-        firstTm->tm_hour,
-        firstTm->tm_min,
-        firstTm->tm_sec);
-#endif // DEBUG_LEVEL >= DEBUG_VERBOSE
-
-    // ========================================================================
-    // Step 4: Parse BYDAY filter if present (to limit to specific weekdays)
-    // ========================================================================
-    std::vector<int> byDayList = parseByDay(rule.byDay);
-
-    if (!byDayList.empty()) {
-        // Sort byDayList to ensure days are in order
-        std::sort(byDayList.begin(), byDayList.end());
-
-        DEBUG_VERBOSE_PRINTF(
-            "    BYDAY filter: %d day(s) specified (limits to specific weekdays)\n",
-            (int)byDayList.size());
-        for (size_t i = 0; i < byDayList.size(); i++) {
-            DEBUG_VERBOSE_PRINTF("      Day: %d (0=Sun, 1=Mon, ..., 6=Sat)\n", byDayList[i]);
-        }
-    } else {
-        DEBUG_VERBOSE_PRINTLN("    BYDAY filter: none (all days)");
+    // Check COUNT limit
+    if (occurrenceIndex > maxCount) {
+        DEBUG_VERBOSE_PRINTLN("    Reached COUNT limit, stopping");
+        finished = true;
+        return false;
     }
 
-    // ========================================================================
-    // Step 5: Calculate starting occurrence index and iterate day by day
-    // ========================================================================
-
-    // Calculate how many occurrences happened before firstOccurrence
-    int occurrencesBeforeRange = 0;
-    if (count > 0 && firstOccurrence > event->startTime) {
-        // Calculate days difference
-        int daysDiff = (firstOccurrence - event->startTime) / (24 * 3600);
-        occurrencesBeforeRange = daysDiff / interval;
-        DEBUG_VERBOSE_PRINTF("    Occurrences before query range: %d\n", occurrencesBeforeRange);
+    if (overrides && overrides->isSuppressed(uidHash, occurrence)) {
+        DEBUG_VERBOSE_PRINTLN("      -> Excluded by EXDATE/RECURRENCE-ID, not added");
+        return false;
     }
 
-    // Start iterating from firstOccurrence
-    struct tm currentTm;
-    memcpy(&currentTm, localtime(&firstOccurrence), sizeof(struct tm));
-
-    int absoluteOccurrenceIndex = occurrencesBeforeRange;
-    int maxCount = (count > 0) ? count : INT_MAX;
-
-    DEBUG_VERBOSE_PRINTLN(">>> expandDailyV2: Starting day-by-day iteration");
-
-    while (true) {
-        // Create occurrence timestamp
-        time_t occurrenceTime = mktime(&currentTm);
-
-        // Check if past effective end date
-        if (occurrenceTime > effectiveEndDate) {
-            DEBUG_VERBOSE_PRINTLN("    Reached effective end date, stopping");
-            break;
-        }
-
-        // Apply BYDAY filter (if specified) - only include days in the list
-        bool dayMatches = byDayList.empty() || (std::find(byDayList.begin(), byDayList.end(), currentTm.tm_wday) != byDayList.end());
-
-        if (dayMatches) {
-            absoluteOccurrenceIndex++;
-
-            DEBUG_VERBOSE_PRINTF("    Occurrence #%d: %04d-%02d-%02d (day %d)\n",
-                absoluteOccurrenceIndex,
-                currentTm.tm_year + 1900,
-                currentTm.tm_mon + 1,
-                currentTm.tm_mday,
-                currentTm.tm_wday);
-
-            // Check COUNT limit
-            if (absoluteOccurrenceIndex > maxCount) {
-                DEBUG_VERBOSE_PRINTLN("    Reached COUNT limit, stopping");
-                break;
-            }
-
-            // Only add to results if within query range
-            if (occurrenceTime >= startDate && occurrenceTime <= endDate) {
-                CalendarEvent* occurrence = new CalendarEvent(*event);
-                occurrence->startTime = occurrenceTime;
-                occurrence->endTime = occurrenceTime + duration;
-
-                // Set date string for display
-                char dateBuffer[32];
-                strftime(dateBuffer, sizeof(dateBuffer), "%Y-%m-%d", &currentTm);
-                occurrence->date = String(dateBuffer);
-
-                occurrences.push_back(occurrence);
-                DEBUG_VERBOSE_PRINTLN("      -> Added to results");
-            } else {
-                DEBUG_VERBOSE_PRINTLN("      -> Outside query range, not added");
-            }
-        }
-
-        // Advance to next day (respecting interval)
-        currentTm.tm_mday += interval;
-        mktime(&currentTm); // Normalize (handles month/year overflow)
+    // Only yield if within query range
+    if (occurrence < startDate || occurrence > endDate) {
+        return false;
     }
 
-    DEBUG_INFO_PRINTF(">>> expandDailyV2: Complete. Created %d occurrences\n",
-        (int)occurrences.size());
-
-    return occurrences;
+    start = occurrence;
+    end = occurrence + duration;
+    return true;
 }
 
 // ============================================================================
@@ -2116,16 +1831,17 @@ OptimizedCalendarManager::getEventsForRange(time_t startDate,
 std::vector<CalendarEvent*> OptimizedCalendarManager::getEventsForDay(time_t date)
 {
     // Get start and end of day
-    struct tm* tm = localtime(&date);
+    struct tm tmBuf;
+    struct tm* tm = TimeZoneEngine::localTime(date, tmBuf);
     tm->tm_hour = 0;
     tm->tm_min = 0;
     tm->tm_sec = 0;
-    time_t dayStart = mktime(tm);
+    time_t dayStart = TimeZoneEngine::makeLocal(*tm);
 
     tm->tm_hour = 23;
     tm->tm_min = 59;
     tm->tm_sec = 59;
-    time_t dayEnd = mktime(tm);
+    time_t dayEnd = TimeZoneEngine::makeLocal(*tm);
 
     return getEventsForRange(dayStart, dayEnd, 20);
 }
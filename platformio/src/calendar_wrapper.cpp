@@ -3,12 +3,35 @@
 #include "debug_config.h"
 #include "event_cache.h"
 #include <algorithm>
+#include <set>
+
+namespace {
+
+// Identifies one instance of a VEVENT across downloads
+String instanceKey(const CalendarEvent* event) {
+    return event->uid + "\n" + event->recurrenceId + "\n" + String((long)event->startTime);
+}
+
+} // namespace
 
 // CalendarWrapper implementation
 
-CalendarWrapper::CalendarWrapper() : lastFetchTime(0), loaded(false), debug(false) {}
+CalendarWrapper::CalendarWrapper()
+    : lastFetchTime(0), loaded(false), debug(false), lastLoadMs(0), lastBytesTransferred(0),
+      lastNotModified(false), lastRadioMs(0), lastParseMs(0), lastSpooled(false) {}
+
+CalendarWrapper::~CalendarWrapper() {
+    clearPending();
+    clearCache();
+}
 
-CalendarWrapper::~CalendarWrapper() { clearCache(); }
+void CalendarWrapper::clearPending() {
+    for (auto event : pending.previousEvents) {
+        delete event;
+    }
+    pending.previousEvents.clear();
+    pending.spooled = false;
+}
 
 void CalendarWrapper::clearCache() {
     for (auto event : cachedEvents) {
@@ -42,6 +65,11 @@ bool CalendarWrapper::isCacheValid() const {
 }
 
 bool CalendarWrapper::load(bool forceRefresh) {
+    bool success = download(forceRefresh);
+    return pending.spooled ? parseSpooled() : success;
+}
+
+bool CalendarWrapper::download(bool forceRefresh) {
     if (debug) {
         DEBUG_VERBOSE_PRINTLN("=== CalendarWrapper::load ===");
         DEBUG_VERBOSE_PRINTLN("Calendar: " + config.name);
@@ -52,9 +80,17 @@ bool CalendarWrapper::load(bool forceRefresh) {
     }
 
     // Clear previous events
+    clearPending();
     clearCache();
-    loaded  = false;
-    isStale = false; // Reset stale flag
+    loaded               = false;
+    isStale              = false; // Reset stale flag
+    lastBytesTransferred = 0;
+    lastNotModified      = false;
+    lastLoadMs           = 0;
+    lastRadioMs          = 0;
+    lastParseMs          = 0;
+    lastTimings          = FetchTimings();
+    lastSpooled          = false;
 
     // Check if calendar is enabled
     if (!config.enabled) {
@@ -74,9 +110,14 @@ bool CalendarWrapper::load(bool forceRefresh) {
     // Get binary cache path
     String cachePath = getCacheFilename();
 
+    // A save cut short by a reset on an earlier wake may have left a newer cache behind
+    EventCache::recover(cachePath);
+
     // Configure parser with calendar metadata
     parser.setCalendarName(config.name);
     parser.setDebug(debug);
+    parser.setIncremental(config.incremental);
+    parser.setSpool(EventCache::getSpoolPath(cachePath), CALENDAR_SPOOL_MIN_BYTES);
 
     // Get date range for fetching events
     time_t now     = time(nullptr);
@@ -87,10 +128,36 @@ bool CalendarWrapper::load(bool forceRefresh) {
         DEBUG_INFO_PRINTLN("Date range: now to +" + String(config.days_to_fetch) + " days");
     }
 
+    // Revalidate the binary cache instead of downloading the feed again, as
+    // long as the cached events still cover the requested range
+    HttpValidators validators;
+    time_t coveredUntil = 0;
+    bool conditional    = !forceRefresh &&
+                       EventCache::loadValidators(cachePath, validators, coveredUntil) &&
+                       coveredUntil >= endDate;
+    time_t parseEndDate     = endDate + CALENDAR_REVALIDATE_SLACK_SECONDS;
+    unsigned long loadStart = millis();
+
+    // Append-only feeds: download only what follows the last VEVENT seen,
+    // while the cached events still cover the range. Full downloads parse
+    // further ahead so that several wakes can append before the next one.
+    FeedTail tail;
+    time_t tailCoveredUntil = 0;
+    bool resume = config.incremental && !forceRefresh &&
+                  EventCache::loadFeedTail(cachePath, tail, tailCoveredUntil) && tailCoveredUntil >= endDate;
+    if (config.incremental) {
+        parseEndDate = endDate + CALENDAR_INCREMENTAL_SLACK_SECONDS;
+    }
+    pending.now              = now;
+    pending.parseEndDate     = parseEndDate;
+    pending.tailCoveredUntil = tailCoveredUntil;
+
     // Try fetching from remote with retries (cache only used as fallback)
     FilteredEvents* result = nullptr;
     int retryCount         = 0;
+    int fetcherRetries     = 0;
     bool fetchSuccess      = false;
+    bool notModified       = false;
 
     while (retryCount < CALENDAR_FETCH_MAX_RETRIES && !fetchSuccess) {
         if (retryCount > 0) {
@@ -101,9 +168,50 @@ bool CalendarWrapper::load(bool forceRefresh) {
         }
 
         // Stream parse directly from HTTP (no ICS file cache)
-        result = parser.fetchEventsInRange(config.url, now, endDate, 500, "");
+        result = parser.fetchEventsInRange(config.url,
+                                           now,
+                                           parseEndDate,
+                                           500,
+                                           "",
+                                           conditional ? &validators : nullptr,
+                                           resume ? &tail : nullptr);
+        if (result) {
+            lastTimings = result->timings;
+            fetcherRetries += result->timings.retries;
+        }
+
+        if (result && result->success && result->notModified) {
+            delete result;
+            result = nullptr;
+
+            cachedEvents = EventCache::load(cachePath, config.url);
+            if (!cachedEvents.empty()) {
+                notModified = true;
+                break;
+            }
+            // Cached events unreadable - download the feed in full
+            if (debug)
+                DEBUG_WARN_PRINTLN("Calendar not modified but cache unreadable, refetching");
+            conditional = false;
+            continue;
+        }
+
+        if (result && result->success && result->partial) {
+            pending.previousEvents = EventCache::load(cachePath, config.url);
+            if (!pending.previousEvents.empty()) {
+                fetchSuccess = true;
+                break;
+            }
+            // Nothing to append to - download the feed in full
+            if (debug)
+                DEBUG_WARN_PRINTLN("Feed appended to but cache unreadable, refetching");
+            delete result;
+            result = nullptr;
+            resume = false;
+            continue;
+        }
 
-        if (result && result->success && !result->events.empty()) {
+        if (result && result->success && (result->spooled || !result->events.empty())) {
             fetchSuccess = true;
         } else {
             retryCount++;
@@ -119,25 +227,17 @@ bool CalendarWrapper::load(bool forceRefresh) {
         }
     }
 
-    // Successfully fetched from remote
-    if (fetchSuccess && result) {
-        cachedEvents = std::move(result->events);
-        result->events.clear(); // Prevent double deletion
+    lastRadioMs         = millis() - loadStart;
+    lastLoadMs          = lastRadioMs;
+    lastTimings.retries = (uint8_t)std::min(fetcherRetries + retryCount, 255);
 
-        if (debug) {
-            DEBUG_INFO_PRINTLN("Successfully fetched " + String(cachedEvents.size()) +
-                               " events from remote");
-        }
+    // Server confirmed the cached events are current
+    if (notModified) {
+        lastNotModified = true;
 
-        delete result;
-
-        // Save to binary cache for future use
-        if (EventCache::save(cachePath, cachedEvents, config.url)) {
-            if (debug)
-                DEBUG_INFO_PRINTLN("Saved events to binary cache");
-        } else {
-            if (debug)
-                DEBUG_WARN_PRINTLN("Failed to save events to binary cache");
+        if (debug) {
+            DEBUG_INFO_PRINTLN("Calendar not modified, loaded " + String(cachedEvents.size()) +
+                               " events from binary cache in " + String(lastLoadMs) + "ms");
         }
 
         loaded        = true;
@@ -146,23 +246,35 @@ bool CalendarWrapper::load(bool forceRefresh) {
         return true;
     }
 
+    // Body is on flash; parseSpooled() finishes the load without the network
+    if (fetchSuccess && result && result->spooled) {
+        lastBytesTransferred = result->bytesTransferred;
+        pending.spooled      = true;
+        lastSpooled          = true;
+        delete result;
+
+        if (debug) {
+            DEBUG_INFO_PRINTLN("Spooled " + String((unsigned long)lastBytesTransferred) +
+                               " bytes in " + String(lastRadioMs) + "ms, parsing later");
+        }
+        return true;
+    }
+
+    // Successfully fetched from remote
+    if (fetchSuccess && result) {
+        lastParseMs = parser.getLastParseStats().parseMs;
+        return storeResult(result);
+    }
+
     // Remote fetch failed after all retries - try loading binary cache as fallback
     if (debug) {
         DEBUG_WARN_PRINTLN("Remote fetch failed after " + String(retryCount) + " attempts");
-        DEBUG_INFO_PRINTLN("Attempting to load stale binary cache as fallback");
     }
-
-    cachedEvents = EventCache::load(cachePath, config.url);
-
-    if (!cachedEvents.empty()) {
-        if (debug) {
-            DEBUG_WARN_PRINTLN("Using stale cached data (" + String(cachedEvents.size()) +
-                               " events)");
-        }
-        loaded    = true;
-        isStale   = true;
-        lastError = "Using stale cached data - remote fetch failed after " + String(retryCount) +
-                    " retries";
+    clearPending();
+    if (loadStaleCache("Using stale cached data - remote fetch failed after " + String(retryCount) +
+                           " retries",
+                       now,
+                       parseEndDate)) {
         return true;
     }
 
@@ -175,6 +287,166 @@ bool CalendarWrapper::load(bool forceRefresh) {
     return false;
 }
 
+bool CalendarWrapper::parseSpooled() {
+    if (!pending.spooled) {
+        return loaded;
+    }
+    pending.spooled = false;
+
+    unsigned long parseStart = millis();
+    FilteredEvents* result =
+        parser.parseSpooledEvents(pending.now, pending.parseEndDate, 500);
+    lastParseMs = millis() - parseStart;
+    lastLoadMs  = lastRadioMs + lastParseMs;
+
+    if (result->success && (result->partial || !result->events.empty())) {
+        return storeResult(result);
+    }
+
+    if (!result->error.isEmpty()) {
+        lastError = result->error;
+    }
+    if (debug) {
+        DEBUG_WARN_PRINTLN("Spooled calendar could not be parsed: " + lastError);
+    }
+    delete result;
+    clearPending();
+    if (loadStaleCache("Using stale cached data - spooled calendar could not be parsed",
+                       pending.now,
+                       pending.parseEndDate)) {
+        return true;
+    }
+
+    if (debug)
+        DEBUG_ERROR_PRINTLN("Failed to parse the spooled calendar and no cache available");
+    lastError = "Failed to parse the spooled calendar and no cache available";
+    loaded    = false;
+    return false;
+}
+
+FetchTelemetryRecord CalendarWrapper::getLastTelemetry() const {
+    FetchTelemetryRecord entry;
+    entry.time = (uint32_t)pending.now;
+    entry.setSource(config.name);
+    entry.setTimings(lastTimings);
+    entry.bytes   = lastBytesTransferred;
+    entry.parseMs = lastParseMs;
+
+    // A 304 leaves the stats of the parse empty
+    const StreamParseStats& stats = parser.getLastParseStats();
+    entry.setEvents(stats.eventsParsed, stats.eventsFiltered, stats.eventsRejected + stats.eventsSkipped);
+
+    if (lastNotModified) {
+        entry.flags |= FetchTelemetryRecord::FLAG_NOT_MODIFIED;
+    } else if (loaded && !isStale) {
+        entry.flags |= FetchTelemetryRecord::FLAG_LOADED;
+    }
+    if (isStale) {
+        entry.flags |= FetchTelemetryRecord::FLAG_STALE;
+    }
+    if (lastSpooled) {
+        entry.flags |= FetchTelemetryRecord::FLAG_SPOOLED;
+    }
+    return entry;
+}
+
+bool CalendarWrapper::storeResult(FilteredEvents* result) {
+    String cachePath     = getCacheFilename();
+    bool partial         = result->partial;
+    size_t appended      = result->events.size();
+    lastBytesTransferred = result->bytesTransferred;
+
+    time_t coveredUntil = pending.parseEndDate;
+    if (partial) {
+        // Keep the cached events that are not over yet, then add the
+        // appended ones; an appended VEVENT that the cache already holds
+        // (same UID, RECURRENCE-ID and start) replaces the cached copy. The
+        // range is still only covered as far as the last full download parsed
+        std::set<String> appendedKeys;
+        for (CalendarEvent* event : result->events) {
+            if (!event->uid.isEmpty()) {
+                appendedKeys.insert(instanceKey(event));
+            }
+        }
+        for (CalendarEvent* event : pending.previousEvents) {
+            bool replaced = !event->uid.isEmpty() && appendedKeys.count(instanceKey(event)) > 0;
+            if (event->endTime >= pending.now && !replaced) {
+                cachedEvents.push_back(event);
+            } else {
+                delete event;
+            }
+        }
+        pending.previousEvents.clear();
+        cachedEvents.insert(cachedEvents.end(), result->events.begin(), result->events.end());
+        std::sort(cachedEvents.begin(), cachedEvents.end(), [](CalendarEvent* a, CalendarEvent* b) {
+            return a->startTime < b->startTime;
+        });
+        coveredUntil = pending.tailCoveredUntil;
+    } else {
+        cachedEvents = std::move(result->events);
+    }
+    result->events.clear(); // Prevent double deletion
+
+    if (debug) {
+        if (partial) {
+            DEBUG_INFO_PRINTLN("Appended " + String((unsigned long)appended) + " events to " +
+                               String((unsigned long)(cachedEvents.size() - appended)) +
+                               " cached events (" + String((unsigned long)lastBytesTransferred) +
+                               " bytes downloaded)");
+        } else {
+            DEBUG_INFO_PRINTLN("Successfully fetched " + String(cachedEvents.size()) +
+                               " events from remote");
+        }
+    }
+
+    // Save to binary cache for future use; the validators and the feed
+    // tail are only kept alongside a cache that was actually written. They
+    // are dropped before the save: a reset after the new cache is in place
+    // must not leave the old tail, which would append the same bytes again
+    EventCache::saveValidators(cachePath, HttpValidators(), 0);
+    EventCache::saveFeedTail(cachePath, FeedTail(), 0);
+    if (EventCache::save(cachePath, cachedEvents, config.url)) {
+        EventCache::saveValidators(cachePath, result->validators, coveredUntil);
+        EventCache::saveFeedTail(cachePath, result->tail, coveredUntil);
+        if (debug)
+            DEBUG_INFO_PRINTLN("Saved events to binary cache");
+    } else {
+        if (debug)
+            DEBUG_WARN_PRINTLN("Failed to save events to binary cache");
+    }
+    delete result;
+    clearPending();
+
+    loaded        = true;
+    isStale       = false;
+    lastFetchTime = time(nullptr);
+    return true;
+}
+
+bool CalendarWrapper::loadStaleCache(const String& reason, time_t startDate, time_t endDate) {
+    if (debug) {
+        DEBUG_INFO_PRINTLN("Attempting to load stale binary cache as fallback");
+    }
+
+    // Only the events of the range: memory use follows the display, not the cache size
+    cachedEvents = EventCache::query(getCacheFilename(), startDate, endDate);
+    if (cachedEvents.empty()) {
+        // Nothing in range, or no usable cache: a cache of past events still counts as loaded
+        cachedEvents = EventCache::load(getCacheFilename(), config.url);
+    }
+    if (cachedEvents.empty()) {
+        return false;
+    }
+
+    if (debug) {
+        DEBUG_WARN_PRINTLN("Using stale cached data (" + String(cachedEvents.size()) + " events)");
+    }
+    loaded    = true;
+    isStale   = true;
+    lastError = reason;
+    return true;
+}
+
 std::vector<CalendarEvent*> CalendarWrapper::getEvents(time_t startDate, time_t endDate) {
     if (!loaded) {
         return std::vector<CalendarEvent*>();
@@ -255,7 +527,7 @@ size_t CalendarWrapper::getEventCountInRange(time_t startDate, time_t endDate) c
 
 // CalendarManager implementation
 
-CalendarManager::CalendarManager() : debug(false) {}
+CalendarManager::CalendarManager() : telemetry(nullptr), debug(false) {}
 
 CalendarManager::~CalendarManager() { clear(); }
 
@@ -264,6 +536,7 @@ void CalendarManager::clear() {
         delete cal;
     }
     calendars.clear();
+    loadResults.clear();
 }
 
 bool CalendarManager::loadFromConfig(const RuntimeConfig& config) {
@@ -294,25 +567,117 @@ bool CalendarManager::loadFromConfig(const RuntimeConfig& config) {
     return true;
 }
 
-bool CalendarManager::loadAll(bool forceRefresh) {
+bool CalendarManager::loadAll(bool forceRefresh, FetchScheduler* scheduler, ConnectionPool* pool) {
+    downloadAll(forceRefresh, scheduler, pool);
+    return parseSpooled();
+}
+
+void CalendarManager::downloadAll(bool forceRefresh, FetchScheduler* scheduler, ConnectionPool* pool) {
     if (debug) {
-        DEBUG_INFO_PRINTLN("=== CalendarManager::loadAll ===");
-        DEBUG_INFO_PRINTLN("Loading " + String(calendars.size()) + " calendars");
+        DEBUG_INFO_PRINTLN("=== CalendarManager::downloadAll ===");
+        DEBUG_INFO_PRINTLN("Downloading " + String(calendars.size()) + " calendars" +
+                           (scheduler ? " in parallel" : ""));
     }
 
+    loadResults.assign(calendars.size(), false);
+
+    // Calendars on the same host reuse one TLS session; the pool only lives
+    // for this call
+    for (auto cal : calendars) {
+        cal->setConnectionPool(pool);
+    }
+
+    if (scheduler) {
+        // Each calendar downloads (and parses, unless spooled) on its own
+        // fetch task, next to any job the caller queued (weather)
+        std::vector<size_t> jobIds(calendars.size());
+        for (size_t i = 0; i < calendars.size(); i++) {
+            CalendarWrapper* cal = calendars[i];
+            jobIds[i]            = scheduler->addJob("calendar " + cal->getName(),
+                                                     [cal, forceRefresh]() { return cal->download(forceRefresh); });
+        }
+        scheduler->run();
+
+        const std::vector<FetchJobResult>& results = scheduler->getResults();
+        for (size_t i = 0; i < calendars.size(); i++) {
+            loadResults[i] = jobIds[i] < results.size() && results[jobIds[i]].success;
+        }
+    } else {
+        for (size_t i = 0; i < calendars.size(); i++) {
+            if (debug) {
+                DEBUG_INFO_PRINTLN("\nLoading calendar " + String(i + 1) + "/" +
+                                   String(calendars.size()));
+            }
+            loadResults[i] = calendars[i]->download(forceRefresh);
+        }
+    }
+
+    for (auto cal : calendars) {
+        cal->setConnectionPool(nullptr);
+    }
+
+    if (debug) {
+        // Network time, and what conditional fetches saved
+        unsigned long totalRadioMs = 0;
+        size_t totalBytes          = 0;
+        int notModifiedCount       = 0;
+        for (auto cal : calendars) {
+            totalRadioMs += cal->getLastRadioMs();
+            totalBytes += cal->getLastBytesTransferred();
+            if (cal->wasNotModified())
+                notModifiedCount++;
+        }
+        DEBUG_INFO_PRINTLN("Download time: " + String(totalRadioMs) + "ms, downloaded " +
+                           String(totalBytes) + " bytes, " + String(notModifiedCount) +
+                           " calendars not modified");
+        if (scheduler) {
+            DEBUG_INFO_PRINTLN("Parallel fetch: " + String(scheduler->getLastRunMs()) +
+                               "ms wall time, up to " + String(scheduler->getPeakConcurrency()) +
+                               " sources at once");
+        }
+        if (pool) {
+            DEBUG_INFO_PRINTLN("Connections: " + String(pool->getHandshakeCount()) +
+                               " handshakes (" + String(pool->getHandshakeMs()) + "ms), " +
+                               String(pool->getReuseCount()) + " requests on reused connections");
+        }
+    }
+}
+
+bool CalendarManager::hasSpooledBodies() const {
+    for (auto cal : calendars) {
+        if (cal->hasSpooledBody()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CalendarManager::parseSpooled() {
     bool allSuccess = true;
     int loadedCount = 0;
     int errorCount  = 0;
 
+    loadResults.resize(calendars.size(), false);
+
+    // Spooled bodies are parsed one at a time, from flash
+    for (size_t i = 0; i < calendars.size(); i++) {
+        CalendarWrapper* cal = calendars[i];
+        if (cal->hasSpooledBody()) {
+            if (debug) {
+                DEBUG_INFO_PRINTLN("\nParsing spooled calendar: " + cal->getName());
+            }
+            loadResults[i] = cal->parseSpooled();
+        }
+    }
+
     for (size_t i = 0; i < calendars.size(); i++) {
         CalendarWrapper* cal = calendars[i];
 
-        if (debug) {
-            DEBUG_INFO_PRINTLN("\nLoading calendar " + String(i + 1) + "/" +
-                               String(calendars.size()));
+        if (telemetry && cal->isEnabled()) {
+            telemetry->record(cal->getLastTelemetry());
         }
 
-        if (cal->load(forceRefresh)) {
+        if (loadResults[i]) {
             if (cal->isLoaded()) {
                 loadedCount++;
                 if (debug) {
@@ -346,6 +711,18 @@ bool CalendarManager::loadAll(bool forceRefresh) {
                                    " events in next " + String(cal->getDaysToFetch()) + " days");
             }
         }
+
+        // Radio time and parse time overlap for calendars parsed as they arrived
+        unsigned long totalLoadMs  = 0;
+        unsigned long totalRadioMs = 0;
+        unsigned long totalParseMs = 0;
+        for (auto cal : calendars) {
+            totalLoadMs += cal->getLastLoadMs();
+            totalRadioMs += cal->getLastRadioMs();
+            totalParseMs += cal->getLastParseMs();
+        }
+        DEBUG_INFO_PRINTLN("Load time: " + String(totalLoadMs) + "ms (radio on " +
+                           String(totalRadioMs) + "ms, parsing " + String(totalParseMs) + "ms)");
     }
 
     return allSuccess;
@@ -447,6 +824,9 @@ void CalendarManager::printStatus() const {
 
         DEBUG_INFO_PRINTLN("  Days to fetch: " + String(cal->getDaysToFetch()));
         DEBUG_INFO_PRINTLN("  Color: " + cal->getColor());
+        DEBUG_INFO_PRINTLN("  Last load: " + String(cal->getLastLoadMs()) + "ms, " +
+                           String(cal->getLastBytesTransferred()) + " bytes" +
+                           (cal->wasNotModified() ? " (not modified)" : ""));
     }
 
     DEBUG_INFO_PRINTLN("\nSummary:");
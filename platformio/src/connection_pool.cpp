@@ -0,0 +1,226 @@
+/**
+ * Implementation of the keep-alive connection pool
+ */
+
+#include "connection_pool.h"
+
+#ifdef NATIVE_TEST
+#define DEBUG_INFO_PRINTLN(x)                                                                      \
+    do {                                                                                           \
+    } while (0)
+#define DEBUG_WARN_PRINTLN(x)                                                                      \
+    do {                                                                                           \
+    } while (0)
+#else
+#include "debug_config.h"
+#include "resumable_tls_client.h"
+#endif
+
+ConnectionPool::ConnectionPool(size_t maxIdle)
+    : maxIdle(maxIdle)
+    , sessionCache(nullptr)
+    , handshakeCount(0)
+    , handshakeMs(0)
+    , reuseCount(0)
+    , failedCount(0)
+{
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!connections.empty()) {
+        destroy(connections.size() - 1);
+    }
+}
+
+bool ConnectionPool::parseOrigin(const String& url, String& origin, String& host, uint16_t& port, bool& secure)
+{
+    int hostStart;
+    if (url.startsWith("https://")) {
+        secure = true;
+        port = 443;
+        hostStart = 8;
+    } else if (url.startsWith("http://")) {
+        secure = false;
+        port = 80;
+        hostStart = 7;
+    } else {
+        return false;
+    }
+
+    int hostEnd = url.indexOf('/', hostStart);
+    if (hostEnd < 0) {
+        hostEnd = url.length();
+    }
+    String authority = url.substring(hostStart, hostEnd);
+
+    // Drop credentials; they are sent as a header, not part of the origin
+    int at = authority.indexOf('@');
+    if (at >= 0) {
+        authority = authority.substring(at + 1);
+    }
+
+    int colon = authority.indexOf(':');
+    if (colon >= 0) {
+        long explicitPort = authority.substring(colon + 1).toInt();
+        if (explicitPort <= 0 || explicitPort > 65535) {
+            return false;
+        }
+        port = (uint16_t)explicitPort;
+        host = authority.substring(0, colon);
+    } else {
+        host = authority;
+    }
+    if (host.isEmpty()) {
+        return false;
+    }
+    host.toLowerCase();
+
+    origin = String(secure ? "https://" : "http://") + host + ":" + String(port);
+    return true;
+}
+
+PooledConnection* ConnectionPool::acquire(const String& url)
+{
+    String origin;
+    String host;
+    uint16_t port;
+    bool secure;
+    if (!parseOrigin(url, origin, host, port, secure)) {
+        return nullptr;
+    }
+
+    PooledConnection* connection = nullptr;
+#ifndef NATIVE_TEST
+    ResumableTlsClient* resumable = nullptr;
+#endif
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < connections.size();) {
+            PooledConnection* candidate = connections[i];
+            if (candidate->inUse || candidate->origin != origin) {
+                i++;
+                continue;
+            }
+            // The server may have closed it while it sat idle
+            if (!candidate->client->connected()) {
+                destroy(i);
+                continue;
+            }
+            candidate->inUse = true;
+            candidate->requests++;
+            reuseCount++;
+            return candidate;
+        }
+
+        // Reserve a slot so concurrent callers do not share the new connection
+        connection = new PooledConnection();
+        connection->origin = origin;
+        connection->inUse = true;
+        if (secure) {
+#ifdef NATIVE_TEST
+            WiFiClientSecure* secureClient = new WiFiClientSecure();
+#else
+            if (sessionCache) {
+                resumable = new ResumableTlsClient(sessionCache);
+            }
+            WiFiClientSecure* secureClient = resumable ? resumable : new WiFiClientSecure();
+#endif
+            secureClient->setInsecure(); // Same certificate policy as the rest of the firmware
+            connection->client = secureClient;
+        } else {
+            connection->client = new WiFiClient();
+        }
+        connection->http = new HTTPClient();
+        connections.push_back(connection);
+    }
+
+    // Connect outside the lock: a TLS handshake takes seconds
+    unsigned long start = millis();
+    bool connected = connection->client->connect(host.c_str(), port);
+    unsigned long duration = millis() - start;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!connected) {
+        failedCount++;
+        DEBUG_WARN_PRINTLN("Connection to " + origin + " failed after " + String(duration) + "ms");
+        for (size_t i = 0; i < connections.size(); i++) {
+            if (connections[i] == connection) {
+                destroy(i);
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+    handshakeCount++;
+    handshakeMs += duration;
+    connection->requests = 1;
+    connection->connectMs = duration;
+#ifndef NATIVE_TEST
+    if (resumable) {
+        connection->dnsMs     = resumable->getLastDnsMs();
+        connection->connectMs = resumable->getLastConnectMs();
+        connection->tlsMs     = resumable->getLastHandshakeMs() - resumable->getLastConnectMs();
+    }
+#endif
+    DEBUG_INFO_PRINTLN("Opened connection to " + origin + " in " + String(duration) + "ms");
+    return connection;
+}
+
+void ConnectionPool::release(PooledConnection* connection, bool reusable)
+{
+    if (!connection) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t index = connections.size();
+    size_t idle = 0;
+    for (size_t i = 0; i < connections.size(); i++) {
+        if (connections[i] == connection) {
+            index = i;
+        } else if (!connections[i]->inUse) {
+            idle++;
+        }
+    }
+    if (index == connections.size()) {
+        return;
+    }
+
+    if (!reusable || idle >= maxIdle || !connection->client->connected()) {
+        destroy(index);
+        return;
+    }
+    connection->inUse = false;
+}
+
+void ConnectionPool::closeAll()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = connections.size(); i-- > 0;) {
+        if (!connections[i]->inUse) {
+            destroy(i);
+        }
+    }
+}
+
+size_t ConnectionPool::getOpenCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return connections.size();
+}
+
+void ConnectionPool::destroy(size_t index)
+{
+    PooledConnection* connection = connections[index];
+    // HTTPClient stops its client when destroyed: delete it first
+    delete connection->http;
+    if (connection->client) {
+        connection->client->stop();
+        delete connection->client;
+    }
+    delete connection;
+    connections.erase(connections.begin() + index);
+}
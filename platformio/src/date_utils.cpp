@@ -1,5 +1,6 @@
 #include "date_utils.h"
 #include "debug_config.h"
+#include "timezone_engine.h"
 
 bool DateUtils::isToday(time_t timestamp) {
     time_t now = getCurrentTime();
@@ -19,12 +20,14 @@ bool DateUtils::isYesterday(time_t timestamp) {
 }
 
 bool DateUtils::isSameDay(time_t timestamp1, time_t timestamp2) {
-    struct tm* tm1 = localtime(&timestamp1);
+    struct tm tm1Fields;
+    struct tm* tm1 = TimeZoneEngine::localTime(timestamp1, tm1Fields);
     int year1      = tm1->tm_year;
     int month1     = tm1->tm_mon;
     int day1       = tm1->tm_mday;
 
-    struct tm* tm2 = localtime(&timestamp2);
+    struct tm tm2Fields;
+    struct tm* tm2 = TimeZoneEngine::localTime(timestamp2, tm2Fields);
     int year2      = tm2->tm_year;
     int month2     = tm2->tm_mon;
     int day2       = tm2->tm_mday;
@@ -33,19 +36,21 @@ bool DateUtils::isSameDay(time_t timestamp1, time_t timestamp2) {
 }
 
 time_t DateUtils::getStartOfDay(time_t timestamp) {
-    struct tm* tm = localtime(&timestamp);
+    struct tm tmFields;
+    struct tm* tm = TimeZoneEngine::localTime(timestamp, tmFields);
     tm->tm_hour   = 0;
     tm->tm_min    = 0;
     tm->tm_sec    = 0;
-    return mktime(tm);
+    return TimeZoneEngine::makeLocal(*tm);
 }
 
 time_t DateUtils::getEndOfDay(time_t timestamp) {
-    struct tm* tm = localtime(&timestamp);
+    struct tm tmFields;
+    struct tm* tm = TimeZoneEngine::localTime(timestamp, tmFields);
     tm->tm_hour   = 23;
     tm->tm_min    = 59;
     tm->tm_sec    = 59;
-    return mktime(tm);
+    return TimeZoneEngine::makeLocal(*tm);
 }
 
 int DateUtils::getDaysDifference(time_t timestamp1, time_t timestamp2) {
@@ -61,7 +66,8 @@ String DateUtils::formatDate(time_t timestamp) {
     if (timestamp == 0)
         return "";
 
-    struct tm* tm = localtime(&timestamp);
+    struct tm tmFields;
+    struct tm* tm = TimeZoneEngine::localTime(timestamp, tmFields);
     char buffer[32]; // Increased buffer size to avoid truncation warning
     snprintf(
         buffer, sizeof(buffer), "%04d-%02d-%02d", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
@@ -72,7 +78,8 @@ String DateUtils::formatTime(time_t timestamp) {
     if (timestamp == 0)
         return "";
 
-    struct tm* tm = localtime(&timestamp);
+    struct tm tmFields;
+    struct tm* tm = TimeZoneEngine::localTime(timestamp, tmFields);
     char buffer[32]; // Using larger buffer to avoid compiler warnings
     snprintf(buffer, sizeof(buffer), "%02d:%02d", tm->tm_hour, tm->tm_min);
     return String(buffer);
@@ -98,7 +105,7 @@ time_t DateUtils::parseDate(const String& dateStr) {
     tm.tm_sec    = 0;
     tm.tm_isdst  = -1;
 
-    return mktime(&tm);
+    return TimeZoneEngine::makeLocal(tm);
 }
 
 time_t DateUtils::getCurrentTime() {
@@ -118,16 +125,18 @@ bool DateUtils::isTimeSynchronized() {
     time(&now);
 
     // If time is before year 2020, it's probably not synchronized
-    struct tm* tm = localtime(&now);
+    struct tm tmFields;
+    struct tm* tm = TimeZoneEngine::localTime(now, tmFields);
     int year      = tm->tm_year + 1900;
 
     return year >= 2020;
 }
 
 time_t DateUtils::normalizeToMidnight(time_t timestamp) {
-    struct tm* tm = localtime(&timestamp);
+    struct tm tmFields;
+    struct tm* tm = TimeZoneEngine::localTime(timestamp, tmFields);
     tm->tm_hour   = 0;
     tm->tm_min    = 0;
     tm->tm_sec    = 0;
-    return mktime(tm);
+    return TimeZoneEngine::makeLocal(*tm);
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "config.h"
 #include "display_manager.h"
 #include "error_manager.h"
+#include "fetch_telemetry.h"
 #include "littlefs_config.h"
 #include "localization.h"
 #include "version.h"
@@ -52,6 +53,7 @@ void testWeatherFetch();
 void testLittleFSConfig();
 void helloWorld();
 void testDisplayCapabilities();
+void showFetchTelemetry();
 std::vector<CalendarEvent*> generateMockEvents();
 WeatherData generateMockWeather();
 int getBatteryPercentage(float voltage); // Battery percentage calculation
@@ -147,6 +149,7 @@ void showMenu() {
     Serial.println("14 - Test LittleFS Configuration");
     Serial.println("15 - Test Display (hello world)");
     Serial.println("16 - Test Display Capabilities");
+    Serial.println("17 - Show Fetch Telemetry");
     Serial.println("h  - Show this menu");
     Serial.println("================================");
     Serial.print("\nEnter command: ");
@@ -217,6 +220,8 @@ void processCommand(String command) {
         helloWorld();
     } else if (command == "16") {
         testDisplayCapabilities();
+    } else if (command == "17") {
+        showFetchTelemetry();
     } else if (command == "h") {
         showMenu();
     } else {
@@ -1795,4 +1800,26 @@ void testDisplayCapabilities() {
     Serial.println("========================================\n");
 }
 
-#endif // DEBUG_DISPLAY
\ No newline at end of file
+void showFetchTelemetry() {
+    Serial.println("\n========================================");
+    Serial.println("Fetch Telemetry");
+    Serial.println("========================================\n");
+
+    // Records of the normal firmware's last wakes, from RTC memory or LittleFS
+    FetchTelemetry telemetry;
+    if (!telemetry.load()) {
+        Serial.println("No telemetry recorded yet (" + String(FETCH_TELEMETRY_FILE) + " not found)");
+        Serial.println("========================================\n");
+        return;
+    }
+
+    std::vector<FetchTelemetryRecord> records = telemetry.getRecords();
+    Serial.println("Last wake: #" + String(telemetry.getWake()) + ", " + String(records.size()) + " records");
+    Serial.println("(times in ms; events parsed/kept/rejected)\n");
+    for (const FetchTelemetryRecord& entry : records) {
+        Serial.println(FetchTelemetry::format(entry));
+    }
+    Serial.println("========================================\n");
+}
+
+#endif // DEBUG_DISPLAY
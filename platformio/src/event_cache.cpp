@@ -15,8 +15,319 @@
 #else
 #include "debug_config.h"
 #include <LittleFS.h>
+#include <esp_rom_crc.h>
 #endif
 
+#include <algorithm>
+
+namespace {
+
+// Strings stored per event: title, summary, location, date, calendar name, calendar color,
+// UID, RECURRENCE-ID
+const size_t STRINGS_PER_EVENT = 8;
+
+// v5 records end after the calendar color
+const size_t PREVIOUS_STRINGS_PER_EVENT = 6;
+
+// Unsigned LEB128: 7 bits per byte, the high bit set on all but the last
+template <typename Writer> void putVarint(Writer& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.byte((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.byte((uint8_t)value);
+}
+
+template <typename Reader> uint64_t readVarint(Reader& reader) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64 && reader.ok(); shift += 7) {
+        uint8_t next = reader.byte();
+        value |= (uint64_t)(next & 0x7F) << shift;
+        if (!(next & 0x80)) {
+            return value;
+        }
+    }
+    reader.fail();
+    return 0;
+}
+
+// Signed values are zigzag-mapped so that small negative numbers stay short
+uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// End time used for range tests: events without one end when they start
+int64_t effectiveEnd(int64_t startTime, int64_t endTime) {
+    return endTime == 0 ? startTime : endTime;
+}
+
+// Length of the first maxBytes of value at most, without splitting a UTF-8 sequence
+size_t utf8Prefix(const String& value, size_t maxBytes) {
+    if (value.length() <= maxBytes) {
+        return value.length();
+    }
+    size_t end = maxBytes;
+    while (end > 0 && ((uint8_t)value[end] & 0xC0) == 0x80) {
+        end--;
+    }
+    return end;
+}
+
+/**
+ * Bytes of a string stored in the cache, pointing into an event
+ */
+struct StringView {
+    const char* data;
+    size_t length;
+};
+
+/**
+ * String table numbers of a save, from EVENT_CACHE_STRING_SLOTS fixed slots
+ *
+ * A string is looked up by hash among the strings numbered so far and
+ * numbered next when not found. A slot only holds the latest string that
+ * hashed to it, so a string whose slot was taken in between is stored
+ * again: a few repeats, for memory that does not grow with the events.
+ * Starting over from reset() with the same strings gives the same numbers.
+ */
+class StringNumbering {
+  public:
+    StringNumbering() { reset(); }
+
+    void reset() {
+        memset(slots, 0, sizeof(slots));
+        count = 0;
+    }
+
+    // Number of value; fresh is set if it was numbered now
+    uint32_t number(const StringView& value, bool& fresh) {
+        uint32_t hash = 2166136261u; // FNV-1a
+        for (size_t i = 0; i < value.length; i++) {
+            hash = (hash ^ (uint8_t)value.data[i]) * 16777619u;
+        }
+        Slot& slot = slots[hash & (EVENT_CACHE_STRING_SLOTS - 1)];
+        fresh      = !slot.data || slot.length != value.length ||
+                memcmp(slot.data, value.data, value.length) != 0;
+        if (fresh) {
+            slot.data   = value.data;
+            slot.length = value.length;
+            slot.number = count++;
+        }
+        return slot.number;
+    }
+
+    uint32_t size() const { return count; }
+
+  private:
+    struct Slot {
+        const char* data; // nullptr while unused
+        size_t length;
+        uint32_t number;
+    };
+
+    Slot slots[EVENT_CACHE_STRING_SLOTS];
+    uint32_t count;
+};
+
+/**
+ * Buffered writes of a payload, EVENT_CACHE_IO_BUFFER bytes at a time,
+ * keeping the CRC32 and the length of what was written
+ */
+class PayloadWriter {
+  public:
+    explicit PayloadWriter(File& file) : file(file), used(0), written(0), crc(0), failed(false) {}
+
+    void byte(uint8_t value) {
+        if (used == sizeof(buffer)) {
+            flush();
+        }
+        buffer[used++] = value;
+    }
+
+    void bytes(const void* data, size_t count) {
+        const uint8_t* next = (const uint8_t*)data;
+        for (size_t i = 0; i < count; i++) {
+            byte(next[i]);
+        }
+    }
+
+    // Write out the buffer; false if any write so far failed
+    bool flush() {
+        if (used > 0 && !failed) {
+            crc     = EventCache::calculateCRC32(buffer, used, crc);
+            failed  = file.write(buffer, used) != used;
+            written += used;
+        }
+        used = 0;
+        return !failed;
+    }
+
+    size_t length() const { return written + used; }
+    uint32_t checksum() const { return crc; }
+
+  private:
+    File& file;
+    size_t used;
+    size_t written;
+    uint32_t crc;
+    bool failed;
+    uint8_t buffer[EVENT_CACHE_IO_BUFFER];
+};
+
+/**
+ * Writer that only counts bytes, to size records before writing them
+ */
+struct ByteCounter {
+    size_t length;
+
+    ByteCounter() : length(0) {}
+    void byte(uint8_t) { length++; }
+};
+
+// Encode a record after the one that started at previousStart
+template <typename Writer>
+void writeRecord(Writer& out,
+                 int64_t previousStart,
+                 const CalendarEvent* event,
+                 uint8_t flags,
+                 const uint32_t* numbers) {
+    int64_t startTime = event->startTime;
+    putVarint(out, zigzag(startTime - previousStart));
+    putVarint(out, zigzag((int64_t)event->endTime - startTime));
+    out.byte(flags);
+    out.byte((uint8_t)event->dayOfMonth);
+    for (size_t s = 0; s < STRINGS_PER_EVENT; s++) {
+        putVarint(out, numbers[s]);
+    }
+}
+
+/**
+ * Numbers the strings of events from the start, calling
+ * visit(i, event, strings, numbers, fresh) for each event: its strings cut
+ * to limits, their table numbers, and which of them were numbered now
+ */
+template <typename Visitor>
+void numberStrings(const CalendarEvent* const* events,
+                   size_t count,
+                   const size_t* limits,
+                   StringNumbering& numbering,
+                   Visitor visit) {
+    numbering.reset();
+    for (size_t i = 0; i < count; i++) {
+        const CalendarEvent* event = events[i];
+        const String* values[STRINGS_PER_EVENT] = {&event->title,        &event->summary,
+                                                   &event->location,     &event->date,
+                                                   &event->calendarName, &event->calendarColor,
+                                                   &event->uid,          &event->recurrenceId};
+        StringView strings[STRINGS_PER_EVENT];
+        uint32_t numbers[STRINGS_PER_EVENT];
+        bool fresh[STRINGS_PER_EVENT];
+        for (size_t s = 0; s < STRINGS_PER_EVENT; s++) {
+            strings[s].data   = values[s]->c_str();
+            strings[s].length = utf8Prefix(*values[s], limits[s]);
+            numbers[s]        = numbering.number(strings[s], fresh[s]);
+        }
+        visit(i, event, strings, numbers, fresh);
+    }
+}
+
+/**
+ * Bounds-checked random access to the first length bytes of a file,
+ * through a buffer of EVENT_CACHE_IO_BUFFER bytes
+ */
+class ChunkReader {
+  public:
+    ChunkReader(File& file, size_t length)
+        : file(file), length(length), position(0), bufferStart(0), bufferLength(0), failed(false) {}
+
+    void seek(size_t offset) { position = offset; }
+
+    uint8_t byte() {
+        if (failed) {
+            return 0;
+        }
+        if (position < bufferStart || position >= bufferStart + bufferLength) {
+            size_t wanted = length > position ? length - position : 0;
+            if (wanted > sizeof(buffer)) {
+                wanted = sizeof(buffer);
+            }
+            bufferStart  = position;
+            bufferLength = wanted > 0 && file.seek(position) ? file.read(buffer, wanted) : 0;
+            if (bufferLength == 0) {
+                failed = true;
+                return 0;
+            }
+        }
+        return buffer[position++ - bufferStart];
+    }
+
+    bool read(uint8_t* out, size_t count) {
+        for (size_t i = 0; i < count && !failed; i++) {
+            out[i] = byte();
+        }
+        return !failed;
+    }
+
+    size_t tell() const { return position; }
+    void fail() { failed = true; }
+    bool ok() const { return !failed; }
+
+  private:
+    File& file;
+    size_t length;
+    size_t position;
+    size_t bufferStart;
+    size_t bufferLength;
+    bool failed;
+    uint8_t buffer[EVENT_CACHE_IO_BUFFER];
+};
+
+/**
+ * One decoded record; strings are string table indices
+ */
+struct Record {
+    int64_t startTime;
+    int64_t endTime;
+    uint8_t flags;
+    uint8_t dayOfMonth;
+    uint64_t strings[STRINGS_PER_EVENT];
+};
+
+// Decode the record after the one that started at previousStart, and advance previousStart;
+// records of stringsPerEvent strings leave the others unset
+template <typename Reader>
+bool readRecord(Reader& reader,
+                uint32_t stringCount,
+                size_t stringsPerEvent,
+                int64_t& previousStart,
+                Record& record) {
+    record.startTime = previousStart + unzigzag(readVarint(reader));
+    record.endTime   = record.startTime + unzigzag(readVarint(reader));
+    record.flags      = reader.byte();
+    record.dayOfMonth = reader.byte();
+    for (size_t s = 0; s < stringsPerEvent; s++) {
+        record.strings[s] = readVarint(reader);
+        if (record.strings[s] >= stringCount) {
+            reader.fail();
+        }
+    }
+    previousStart = record.startTime;
+    return reader.ok();
+}
+
+void deleteEvents(std::vector<CalendarEvent*>& events) {
+    for (size_t i = 0; i < events.size(); i++) {
+        delete events[i];
+    }
+    events.clear();
+}
+
+} // namespace
+
 // CRC32 lookup table for checksum calculation
 static const uint32_t crc32_table[256] = {
     0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3,
@@ -52,14 +363,67 @@ static const uint32_t crc32_table[256] = {
     0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf,
     0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d};
 
-uint32_t EventCache::calculateCRC32(const uint8_t* data, size_t length) {
-    uint32_t crc = 0xFFFFFFFF;
+namespace {
+
+// crc32_table extended for slicing-by-8: table[k][b] is the CRC of byte b followed by k zero bytes
+struct Crc32Slices {
+    uint32_t table[8][256];
+
+    Crc32Slices() {
+        for (size_t b = 0; b < 256; b++) {
+            table[0][b] = crc32_table[b];
+        }
+        for (size_t k = 1; k < 8; k++) {
+            for (size_t b = 0; b < 256; b++) {
+                uint32_t previous = table[k - 1][b];
+                table[k][b]       = (previous >> 8) ^ crc32_table[previous & 0xFF];
+            }
+        }
+    }
+};
+
+} // namespace
+
+uint32_t EventCache::calculateCRC32(const uint8_t* data, size_t length, uint32_t crc) {
+#ifdef NATIVE_TEST
+    return crc32Sliced(data, length, crc);
+#else
+    // Same convention as this API: the ROM routine inverts the CRC on entry and on exit
+    return esp_rom_crc32_le(crc, data, length);
+#endif
+}
+
+uint32_t EventCache::crc32Bytewise(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
     for (size_t i = 0; i < length; i++) {
         crc = crc32_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
     }
     return ~crc;
 }
 
+uint32_t EventCache::crc32Sliced(const uint8_t* data, size_t length, uint32_t crc) {
+    static const Crc32Slices slices; // 8 KB, built on first use
+    const uint32_t(*table)[256] = slices.table;
+
+    crc = ~crc;
+    // Eight bytes per step, assembled little-endian whatever the host
+    while (length >= 8) {
+        uint32_t low = crc ^ ((uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 |
+                              (uint32_t)data[3] << 24);
+        uint32_t high = (uint32_t)data[4] | (uint32_t)data[5] << 8 | (uint32_t)data[6] << 16 |
+                        (uint32_t)data[7] << 24;
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^
+              table[4][low >> 24] ^ table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^
+              table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+        data += 8;
+        length -= 8;
+    }
+    for (size_t i = 0; i < length; i++) {
+        crc = table[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
 bool EventCache::ensureCacheDirectory() {
     if (!LittleFS.exists("/cache")) {
         DEBUG_INFO_PRINTLN("Creating /cache directory");
@@ -68,42 +432,282 @@ bool EventCache::ensureCacheDirectory() {
     return true;
 }
 
-void EventCache::serializeEvent(const CalendarEvent* event, SerializedEvent& serialized) {
-    memset(&serialized, 0, sizeof(SerializedEvent));
+bool EventCache::readHeader(File& file, CacheHeader& header, String& calendarUrl) {
+    memset(&header, 0, sizeof(header));
+    calendarUrl = "";
+
+    // Both formats start with the magic number and the version
+    const size_t prefixLength = 2 * sizeof(uint32_t);
+    if (file.read((uint8_t*)&header, prefixLength) != prefixLength) {
+        DEBUG_ERROR_PRINTLN("Failed to read cache header");
+        return false;
+    }
+
+    if (header.magic != CACHE_MAGIC) {
+        DEBUG_ERROR_PRINTLN("Invalid cache magic number: 0x" + String(header.magic, HEX));
+        return false;
+    }
 
-    // Copy strings with bounds checking
-    strncpy(serialized.title, event->title.c_str(), sizeof(serialized.title) - 1);
-    strncpy(serialized.location, event->location.c_str(), sizeof(serialized.location) - 1);
-    strncpy(serialized.date, event->date.c_str(), sizeof(serialized.date) - 1);
-    strncpy(
-        serialized.calendarName, event->calendarName.c_str(), sizeof(serialized.calendarName) - 1);
-    strncpy(serialized.calendarColor,
-            event->calendarColor.c_str(),
-            sizeof(serialized.calendarColor) - 1);
-    strncpy(serialized.summary, event->summary.c_str(), sizeof(serialized.summary) - 1);
+    if (header.version == LEGACY_VERSION) {
+        CacheHeaderV2 legacy;
+        memcpy(&legacy, &header, prefixLength);
+        size_t rest = sizeof(legacy) - prefixLength;
+        if (file.read((uint8_t*)&legacy + prefixLength, rest) != rest) {
+            DEBUG_ERROR_PRINTLN("Failed to read cache header");
+            return false;
+        }
+        legacy.calendarUrl[sizeof(legacy.calendarUrl) - 1] = '\0';
 
-    // Copy timestamps and numeric values
-    serialized.startTime  = event->startTime;
-    serialized.endTime    = event->endTime;
-    serialized.dayOfMonth = event->dayOfMonth;
+        // The fixed-size records are the payload; checked against MAX_EVENTS before use
+        header.eventCount    = legacy.eventCount;
+        header.timestamp     = legacy.timestamp;
+        header.payloadLength = legacy.eventCount <= MAX_EVENTS
+                                   ? legacy.eventCount * sizeof(SerializedEventV2)
+                                   : 0;
+        header.checksum = legacy.checksum;
+        calendarUrl     = String(legacy.calendarUrl);
+        return true;
+    }
+
+    if (header.version != CACHE_VERSION && header.version != PREVIOUS_VERSION) {
+        DEBUG_WARN_PRINTLN("Cache version mismatch: " + String(header.version) + " (expected " +
+                           String(CACHE_VERSION) + ")");
+        return false;
+    }
+
+    size_t rest = sizeof(header) - prefixLength;
+    if (file.read((uint8_t*)&header + prefixLength, rest) != rest ||
+        header.urlLength > MAX_URL_LENGTH) {
+        DEBUG_ERROR_PRINTLN("Failed to read cache header");
+        return false;
+    }
+
+    char url[MAX_URL_LENGTH + 1];
+    if (file.read((uint8_t*)url, header.urlLength) != header.urlLength) {
+        DEBUG_ERROR_PRINTLN("Failed to read cache header");
+        return false;
+    }
+    url[header.urlLength] = '\0';
+    calendarUrl           = String(url);
+    return true;
+}
 
-    // Pack boolean flags into single byte
-    serialized.flags = 0;
+bool EventCache::PayloadLayout::compute(const CacheHeader& header) {
+    if (header.blockSize == 0) {
+        return false;
+    }
+    blockCount   = (header.eventCount + header.blockSize - 1) / header.blockSize;
+    offsetsStart = blockCount * sizeof(IndexEntry);
+    stringsStart = offsetsStart + (size_t)header.stringCount * sizeof(uint32_t);
+    recordsStart = stringsStart + header.stringBytes;
+    return header.stringCount <= header.payloadLength && recordsStart <= header.payloadLength;
+}
+
+uint8_t EventCache::packFlags(const CalendarEvent* event) {
+    uint8_t flags = 0;
     if (event->allDay)
-        serialized.flags |= FLAG_ALL_DAY;
+        flags |= FLAG_ALL_DAY;
     if (event->isToday)
-        serialized.flags |= FLAG_IS_TODAY;
+        flags |= FLAG_IS_TODAY;
     if (event->isTomorrow)
-        serialized.flags |= FLAG_IS_TOMORROW;
+        flags |= FLAG_IS_TOMORROW;
     if (event->isHoliday)
-        serialized.flags |= FLAG_IS_HOLIDAY;
+        flags |= FLAG_IS_HOLIDAY;
     // Note: isMultiDay flag reserved for future use
+    return flags;
 }
 
-CalendarEvent* EventCache::deserializeEvent(const SerializedEvent& serialized) {
+CalendarEvent* EventCache::buildEvent(int64_t startTime,
+                                      int64_t endTime,
+                                      uint8_t flags,
+                                      uint8_t dayOfMonth,
+                                      const String* const* strings) {
     CalendarEvent* event = new CalendarEvent();
+    event->title         = *strings[0];
+    event->summary       = *strings[1];
+    event->location      = *strings[2];
+    event->date          = *strings[3];
+    event->calendarName  = *strings[4];
+    event->calendarColor = *strings[5];
+    event->uid           = *strings[6];
+    event->recurrenceId  = *strings[7];
+    event->startTime     = (time_t)startTime;
+    event->endTime       = (time_t)endTime;
+    event->dayOfMonth    = dayOfMonth;
+    event->allDay        = (flags & FLAG_ALL_DAY) != 0;
+    event->isToday       = (flags & FLAG_IS_TODAY) != 0;
+    event->isTomorrow    = (flags & FLAG_IS_TOMORROW) != 0;
+    event->isHoliday     = (flags & FLAG_IS_HOLIDAY) != 0;
+    return event;
+}
 
-    // Copy strings (they're null-terminated in SerializedEvent)
+bool EventCache::readEvents(File& file,
+                            const CacheHeader& header,
+                            int64_t startDate,
+                            int64_t endDate,
+                            size_t limit,
+                            std::vector<CalendarEvent*>& events) {
+    PayloadLayout layout;
+    if (!layout.compute(header)) {
+        return false;
+    }
+    size_t payloadStart = file.position();
+    ChunkReader reader(file, payloadStart + header.payloadLength);
+
+    // First block with an event that can reach the range: maxEnd never decreases
+    IndexEntry entry;
+    size_t low  = 0;
+    size_t high = layout.blockCount;
+    while (low < high && reader.ok()) {
+        size_t middle = (low + high) / 2;
+        reader.seek(payloadStart + middle * sizeof(entry));
+        reader.read((uint8_t*)&entry, sizeof(entry));
+        if (entry.maxEnd < startDate) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    // Strings read lately, by table index: a calendar's name and color are read once
+    const size_t CACHED_STRINGS = 16;
+    String cached[CACHED_STRINGS];
+    uint64_t cachedIndex[CACHED_STRINGS];
+    for (size_t i = 0; i < CACHED_STRINGS; i++) {
+        cachedIndex[i] = UINT64_MAX;
+    }
+
+    size_t stringsPerEvent =
+        header.version == PREVIOUS_VERSION ? PREVIOUS_STRINGS_PER_EVENT : STRINGS_PER_EVENT;
+
+    bool done = false;
+    for (size_t block = low; block < layout.blockCount && !done && reader.ok(); block++) {
+        reader.seek(payloadStart + block * sizeof(entry));
+        if (!reader.read((uint8_t*)&entry, sizeof(entry)) || entry.firstStart > endDate) {
+            break;
+        }
+
+        reader.seek(payloadStart + layout.recordsStart + entry.offset);
+        int64_t previousStart = entry.firstStart;
+        size_t first          = block * header.blockSize;
+        size_t count          = header.eventCount - first;
+        if (count > header.blockSize) {
+            count = header.blockSize;
+        }
+        for (size_t i = 0; i < count; i++) {
+            Record record;
+            if (!readRecord(reader, header.stringCount, stringsPerEvent, previousStart, record)) {
+                break;
+            }
+            if (record.startTime > endDate) {
+                done = true;
+                break;
+            }
+            if (effectiveEnd(record.startTime, record.endTime) < startDate) {
+                continue;
+            }
+
+            // Copied out of the cache: two strings of a record can share a slot
+            size_t next = reader.tell();
+            String strings[STRINGS_PER_EVENT];
+            const String* values[STRINGS_PER_EVENT];
+            for (size_t s = 0; s < STRINGS_PER_EVENT; s++) {
+                values[s] = &strings[s];
+            }
+            for (size_t s = 0; s < stringsPerEvent && reader.ok(); s++) {
+                size_t slot = record.strings[s] % CACHED_STRINGS;
+                if (cachedIndex[slot] != record.strings[s]) {
+                    uint32_t offset = 0;
+                    reader.seek(payloadStart + layout.offsetsStart +
+                                record.strings[s] * sizeof(offset));
+                    reader.read((uint8_t*)&offset, sizeof(offset));
+                    reader.seek(payloadStart + layout.stringsStart + offset);
+                    uint64_t length = readVarint(reader);
+                    if (offset >= header.stringBytes || length > header.stringBytes - offset) {
+                        reader.fail();
+                        break;
+                    }
+                    String& value = cached[slot];
+                    value         = "";
+                    value.reserve(length);
+                    for (uint64_t c = 0; c < length && reader.ok(); c++) {
+                        value += (char)reader.byte();
+                    }
+                    cachedIndex[slot] = record.strings[s];
+                }
+                strings[s] = cached[slot];
+            }
+            if (!reader.ok()) {
+                break;
+            }
+            reader.seek(next);
+
+            events.push_back(buildEvent(
+                record.startTime, record.endTime, record.flags, record.dayOfMonth, values));
+            if (limit > 0 && events.size() >= limit) {
+                done = true;
+                break;
+            }
+        }
+    }
+
+    if (!reader.ok()) {
+        deleteEvents(events);
+        return false;
+    }
+    return true;
+}
+
+bool EventCache::loadLegacy(File& file, const CacheHeader& header, std::vector<CalendarEvent*>& events) {
+    if (header.payloadLength != header.eventCount * sizeof(SerializedEventV2)) {
+        return false;
+    }
+
+    uint32_t crc = 0;
+    events.reserve(header.eventCount);
+    for (size_t i = 0; i < header.eventCount; i++) {
+        SerializedEventV2 serialized;
+        if (file.read((uint8_t*)&serialized, sizeof(serialized)) != sizeof(serialized)) {
+            deleteEvents(events);
+            return false;
+        }
+        crc = calculateCRC32((const uint8_t*)&serialized, sizeof(serialized), crc);
+        serialized.title[sizeof(serialized.title) - 1]                 = '\0';
+        serialized.location[sizeof(serialized.location) - 1]           = '\0';
+        serialized.date[sizeof(serialized.date) - 1]                   = '\0';
+        serialized.calendarName[sizeof(serialized.calendarName) - 1]   = '\0';
+        serialized.calendarColor[sizeof(serialized.calendarColor) - 1] = '\0';
+        serialized.summary[sizeof(serialized.summary) - 1]             = '\0';
+        events.push_back(deserializeEventV2(serialized));
+    }
+
+    if (crc != header.checksum) {
+        deleteEvents(events);
+        return false;
+    }
+    return true;
+}
+
+bool EventCache::verifyChecksum(File& file, const CacheHeader& header) {
+    uint8_t buffer[EVENT_CACHE_IO_BUFFER];
+    uint32_t crc     = 0;
+    size_t remaining = header.payloadLength;
+    while (remaining > 0) {
+        size_t wanted = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
+        size_t read   = file.read(buffer, wanted);
+        if (read == 0) {
+            return false;
+        }
+        crc = calculateCRC32(buffer, read, crc);
+        remaining -= read;
+    }
+    return crc == header.checksum;
+}
+
+CalendarEvent* EventCache::deserializeEventV2(const SerializedEventV2& serialized) {
+    CalendarEvent* event = new CalendarEvent();
+
+    // Copy strings (they're null-terminated in SerializedEventV2)
     event->title    = String(serialized.title);
     event->location = String(serialized.location);
     event->date     = String(serialized.date);
@@ -149,54 +753,150 @@ bool EventCache::save(const String& cachePath,
 
     DEBUG_INFO_PRINTLN("Saving " + String(events.size()) + " events to cache: " + cachePath);
 
-    // Prepare header
-    CacheHeader header;
-    memset(&header, 0, sizeof(header));
-    header.magic      = CACHE_MAGIC;
-    header.version    = CACHE_VERSION;
-    header.eventCount = events.size();
-    header.timestamp  = time(nullptr);
-    strncpy(header.calendarUrl, calendarUrl.c_str(), sizeof(header.calendarUrl) - 1);
-
-    // Serialize all events to buffer for checksum calculation
-    SerializedEvent* serializedEvents = new SerializedEvent[events.size()];
-    for (size_t i = 0; i < events.size(); i++) {
-        serializeEvent(events[i], serializedEvents[i]);
+    // The index needs the records in start time order; CalendarWrapper passes them sorted
+    const CalendarEvent* const* ordered = events.data();
+    std::vector<const CalendarEvent*> sorted;
+    auto byStart = [](const CalendarEvent* a, const CalendarEvent* b) {
+        return a->startTime < b->startTime;
+    };
+    if (!std::is_sorted(events.begin(), events.end(), byStart)) {
+        sorted.assign(events.begin(), events.end());
+        std::stable_sort(sorted.begin(), sorted.end(), byStart);
+        ordered = sorted.data();
     }
+    size_t count = events.size();
 
-    // Calculate checksum of serialized events
-    header.checksum =
-        calculateCRC32((const uint8_t*)serializedEvents, events.size() * sizeof(SerializedEvent));
-
-    // Write to file
-    File file = LittleFS.open(cachePath, "w");
+    // Written beside the cache and renamed over it once complete, so a reset
+    // halfway keeps the previous cache (see recover())
+    String tempPath     = getTempPath(cachePath);
+    uint32_t generation = std::max(readGeneration(cachePath), readGeneration(tempPath)) + 1;
+    File file           = LittleFS.open(tempPath, "w");
     if (!file) {
-        DEBUG_ERROR_PRINTLN("Failed to open cache file for writing: " + cachePath);
-        delete[] serializedEvents;
+        DEBUG_ERROR_PRINTLN("Failed to open cache file for writing: " + tempPath);
         return false;
     }
 
-    // Write header
-    if (file.write((const uint8_t*)&header, sizeof(header)) != sizeof(header)) {
+    // Zeroed until the payload is written, so a save cut short leaves no valid magic
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    String url = calendarUrl.substring(0, utf8Prefix(calendarUrl, MAX_URL_LENGTH));
+    if (file.write((const uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        file.write((const uint8_t*)url.c_str(), url.length()) != url.length()) {
         DEBUG_ERROR_PRINTLN("Failed to write cache header");
         file.close();
-        delete[] serializedEvents;
+        LittleFS.remove(tempPath);
         return false;
     }
 
-    // Write events
-    size_t eventsSize = events.size() * sizeof(SerializedEvent);
-    if (file.write((const uint8_t*)serializedEvents, eventsSize) != eventsSize) {
+    // Every section is written in one pass over the events, numbering their strings again each time
+    const size_t limits[STRINGS_PER_EVENT] = {MAX_TITLE_LENGTH, MAX_TITLE_LENGTH, MAX_LOCATION_LENGTH,
+                                              MAX_DATE_LENGTH,  MAX_NAME_LENGTH,  MAX_COLOR_LENGTH,
+                                              MAX_UID_LENGTH,   MAX_RECURRENCE_ID_LENGTH};
+    StringNumbering* numbering = new StringNumbering();
+    PayloadWriter out(file);
+
+    // Block index; start times are deltas from the previous record, restarting at each block
+    IndexEntry entry;
+    ByteCounter recordBytes;
+    int64_t previousStart = 0;
+    int64_t maxEnd        = INT64_MIN;
+    numberStrings(ordered, count, limits, *numbering,
+                  [&](size_t i, const CalendarEvent* event, const StringView*, const uint32_t* numbers,
+                      const bool*) {
+                      if (i % BLOCK_SIZE == 0) {
+                          if (i > 0) {
+                              out.bytes(&entry, sizeof(entry));
+                          }
+                          entry.firstStart = event->startTime;
+                          entry.offset     = recordBytes.length;
+                          previousStart    = event->startTime;
+                      }
+                      int64_t end = effectiveEnd(event->startTime, event->endTime);
+                      if (end > maxEnd) {
+                          maxEnd = end;
+                      }
+                      entry.maxEnd = maxEnd;
+                      writeRecord(recordBytes, previousStart, event, packFlags(event), numbers);
+                      previousStart = event->startTime;
+                  });
+    out.bytes(&entry, sizeof(entry));
+
+    // String offsets, then the strings, each the first time it is numbered
+    uint32_t stringBytes = 0;
+    numberStrings(ordered, count, limits, *numbering,
+                  [&](size_t, const CalendarEvent*, const StringView* strings, const uint32_t*,
+                      const bool* fresh) {
+                      for (size_t s = 0; s < STRINGS_PER_EVENT; s++) {
+                          if (fresh[s]) {
+                              out.bytes(&stringBytes, sizeof(stringBytes));
+                              ByteCounter prefix;
+                              putVarint(prefix, strings[s].length);
+                              stringBytes += prefix.length + strings[s].length;
+                          }
+                      }
+                  });
+    numberStrings(ordered, count, limits, *numbering,
+                  [&](size_t, const CalendarEvent*, const StringView* strings, const uint32_t*,
+                      const bool* fresh) {
+                      for (size_t s = 0; s < STRINGS_PER_EVENT; s++) {
+                          if (fresh[s]) {
+                              putVarint(out, strings[s].length);
+                              out.bytes(strings[s].data, strings[s].length);
+                          }
+                      }
+                  });
+
+    // Records
+    numberStrings(ordered, count, limits, *numbering,
+                  [&](size_t i, const CalendarEvent* event, const StringView*, const uint32_t* numbers,
+                      const bool*) {
+                      if (i % BLOCK_SIZE == 0) {
+                          previousStart = event->startTime;
+                      }
+                      writeRecord(out, previousStart, event, packFlags(event), numbers);
+                      previousStart = event->startTime;
+                  });
+
+    header.magic         = CACHE_MAGIC;
+    header.version       = CACHE_VERSION;
+    header.eventCount    = count;
+    header.stringCount   = numbering->size();
+    header.stringBytes   = stringBytes;
+    header.blockSize     = BLOCK_SIZE;
+    header.urlLength     = url.length();
+    header.timestamp     = time(nullptr);
+    header.generation    = generation;
+    header.payloadLength = out.length();
+    delete numbering;
+
+    if (!out.flush()) {
         DEBUG_ERROR_PRINTLN("Failed to write cache events");
         file.close();
-        delete[] serializedEvents;
+        LittleFS.remove(tempPath);
+        return false;
+    }
+    header.checksum = out.checksum();
+
+    if (!file.seek(0) || file.write((const uint8_t*)&header, sizeof(header)) != sizeof(header)) {
+        DEBUG_ERROR_PRINTLN("Failed to write cache header");
+        file.close();
+        LittleFS.remove(tempPath);
         return false;
     }
 
     file.close();
-    delete[] serializedEvents;
 
-    DEBUG_INFO_PRINTLN("Successfully saved cache: " + String(file.size()) + " bytes");
+    // LittleFS renames over an existing file atomically; file systems that
+    // refuse are handled by removing it first, which recover() also covers
+    if (!LittleFS.rename(tempPath, cachePath) &&
+        !(LittleFS.remove(cachePath) && LittleFS.rename(tempPath, cachePath))) {
+        DEBUG_ERROR_PRINTLN("Failed to replace cache file: " + cachePath);
+        return false;
+    }
+
+    DEBUG_INFO_PRINTLN("Successfully saved cache: " +
+                       String(sizeof(header) + url.length() + header.payloadLength) + " bytes, " +
+                       String(header.stringCount) + " strings, generation " + String(generation));
     return true;
 }
 
@@ -217,72 +917,119 @@ std::vector<CalendarEvent*> EventCache::load(const String& cachePath, const Stri
 
     DEBUG_INFO_PRINTLN("Loading events from cache: " + cachePath);
 
-    // Read header
+    // Read and validate header (magic number, version)
     CacheHeader header;
-    if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header)) {
-        DEBUG_ERROR_PRINTLN("Failed to read cache header");
+    String cachedUrl;
+    if (!readHeader(file, header, cachedUrl)) {
         file.close();
         return events;
     }
 
-    // Validate magic number
-    if (header.magic != CACHE_MAGIC) {
-        DEBUG_ERROR_PRINTLN("Invalid cache magic number: 0x" + String(header.magic, HEX));
+    // Validate URL (optional - warn if mismatch)
+    if (cachedUrl != calendarUrl) {
+        DEBUG_WARN_PRINTLN("Cache URL mismatch - cache may be stale");
+    }
+
+    // Validate event count and payload length
+    if (header.eventCount == 0 || header.eventCount > MAX_EVENTS ||
+        header.payloadLength > (size_t)file.available()) {
+        DEBUG_ERROR_PRINTLN("Invalid event count in cache: " + String(header.eventCount));
         file.close();
         return events;
     }
 
-    // Validate version
-    if (header.version != CACHE_VERSION) {
-        DEBUG_WARN_PRINTLN("Cache version mismatch: " + String(header.version) + " (expected " +
-                           String(CACHE_VERSION) + ")");
-        file.close();
+    bool loaded;
+    if (header.version == LEGACY_VERSION) {
+        DEBUG_INFO_PRINTLN("Migrating v2 cache, rewritten on next save");
+        loaded = loadLegacy(file, header, events);
+    } else {
+        // Checked first, then decoded: both read the file in chunks
+        size_t payloadStart = file.position();
+        loaded = verifyChecksum(file, header) && file.seek(payloadStart) &&
+                 readEvents(file, header, INT64_MIN, INT64_MAX, 0, events) &&
+                 events.size() == header.eventCount;
+    }
+    file.close();
+
+    if (!loaded) {
+        DEBUG_ERROR_PRINTLN("Cache checksum mismatch or malformed records - data corrupted");
+        deleteEvents(events);
         return events;
     }
 
-    // Validate URL (optional - warn if mismatch)
-    if (String(header.calendarUrl) != calendarUrl) {
-        DEBUG_WARN_PRINTLN("Cache URL mismatch - cache may be stale");
+    DEBUG_INFO_PRINTLN("Successfully loaded " + String(events.size()) + " events from cache");
+    return events;
+}
+
+std::vector<CalendarEvent*> EventCache::query(const String& cachePath,
+                                              time_t startDate,
+                                              time_t endDate,
+                                              size_t limit) {
+    std::vector<CalendarEvent*> events;
+
+    if (!LittleFS.exists(cachePath)) {
+        DEBUG_INFO_PRINTLN("Cache file does not exist: " + cachePath);
+        return events;
     }
 
-    // Validate event count
-    if (header.eventCount == 0 || header.eventCount > MAX_EVENTS) {
-        DEBUG_ERROR_PRINTLN("Invalid event count in cache: " + String(header.eventCount));
-        file.close();
+    File file = LittleFS.open(cachePath, "r");
+    if (!file) {
+        DEBUG_ERROR_PRINTLN("Failed to open cache file for reading: " + cachePath);
         return events;
     }
 
-    // Read events
-    SerializedEvent* serializedEvents = new SerializedEvent[header.eventCount];
-    size_t eventsSize                 = header.eventCount * sizeof(SerializedEvent);
+    CacheHeader header;
+    String cachedUrl;
+    if (!readHeader(file, header, cachedUrl)) {
+        file.close();
+        return events;
+    }
 
-    if (file.read((uint8_t*)serializedEvents, eventsSize) != eventsSize) {
-        DEBUG_ERROR_PRINTLN("Failed to read cache events");
+    if (header.version == LEGACY_VERSION) {
+        // v2 files have no index; they are read whole until the next save rewrites them
         file.close();
-        delete[] serializedEvents;
+        std::vector<CalendarEvent*> all = load(cachePath, cachedUrl);
+        std::stable_sort(all.begin(), all.end(), [](CalendarEvent* a, CalendarEvent* b) {
+            return a->startTime < b->startTime;
+        });
+        for (size_t i = 0; i < all.size(); i++) {
+            CalendarEvent* event = all[i];
+            bool inRange         = event->startTime <= endDate &&
+                           effectiveEnd(event->startTime, event->endTime) >= (int64_t)startDate;
+            if (inRange && (limit == 0 || events.size() < limit)) {
+                events.push_back(event);
+            } else {
+                delete event;
+            }
+        }
         return events;
     }
 
-    file.close();
+    size_t payloadStart = file.position();
+    if (header.eventCount == 0 || header.eventCount > MAX_EVENTS ||
+        header.payloadLength > file.size() - payloadStart) {
+        DEBUG_ERROR_PRINTLN("Invalid event count in cache: " + String(header.eventCount));
+        file.close();
+        return events;
+    }
 
-    // Validate checksum
-    uint32_t calculatedChecksum = calculateCRC32((const uint8_t*)serializedEvents, eventsSize);
-    if (calculatedChecksum != header.checksum) {
+    if (!verifyChecksum(file, header)) {
         DEBUG_ERROR_PRINTLN("Cache checksum mismatch - data corrupted");
-        delete[] serializedEvents;
+        file.close();
         return events;
     }
 
-    // Deserialize events
-    events.reserve(header.eventCount);
-    for (size_t i = 0; i < header.eventCount; i++) {
-        CalendarEvent* event = deserializeEvent(serializedEvents[i]);
-        events.push_back(event);
-    }
+    bool found = file.seek(payloadStart) &&
+                 readEvents(file, header, startDate, endDate, limit, events);
+    file.close();
 
-    delete[] serializedEvents;
+    if (!found) {
+        DEBUG_ERROR_PRINTLN("Malformed cache records");
+        return events;
+    }
 
-    DEBUG_INFO_PRINTLN("Successfully loaded " + String(events.size()) + " events from cache");
+    DEBUG_INFO_PRINTLN("Loaded " + String(events.size()) + " of " + String(header.eventCount) +
+                       " cached events in range: " + cachePath);
     return events;
 }
 
@@ -296,23 +1043,18 @@ bool EventCache::isValid(const String& cachePath, time_t maxAge) {
         return false;
     }
 
-    // Read header
+    // Read and validate header (magic, version)
     CacheHeader header;
-    if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header)) {
-        file.close();
-        return false;
-    }
-
+    String cachedUrl;
+    bool headerRead = readHeader(file, header, cachedUrl);
     file.close();
-
-    // Validate magic and version
-    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) {
+    if (!headerRead) {
         return false;
     }
 
     // Check age
     time_t now = time(nullptr);
-    time_t age = now - header.timestamp;
+    time_t age = now - (time_t)header.timestamp;
 
     if (age < 0 || age >= maxAge) {
         DEBUG_INFO_PRINTLN("Cache expired: age=" + String(age) + "s, maxAge=" + String(maxAge) +
@@ -323,7 +1065,262 @@ bool EventCache::isValid(const String& cachePath, time_t maxAge) {
     return true;
 }
 
+bool EventCache::saveValidators(const String& cachePath,
+                                const HttpValidators& validators,
+                                time_t coveredUntil) {
+    String path = getValidatorsPath(cachePath);
+    if (validators.isEmpty()) {
+        // Nothing to revalidate with - make sure no stale validators remain
+        if (LittleFS.exists(path)) {
+            LittleFS.remove(path);
+        }
+        return false;
+    }
+
+    if (!ensureCacheDirectory()) {
+        DEBUG_ERROR_PRINTLN("Failed to create cache directory");
+        return false;
+    }
+
+    // One value per line: ETag, Last-Modified, covered range end
+    String content = validators.etag + "\n" + validators.lastModified + "\n" +
+                     String((long)coveredUntil) + "\n";
+
+    File file = LittleFS.open(path, "w");
+    if (!file) {
+        DEBUG_ERROR_PRINTLN("Failed to open validators file for writing: " + path);
+        return false;
+    }
+    size_t written = file.write((const uint8_t*)content.c_str(), content.length());
+    file.close();
+
+    if (written != content.length()) {
+        DEBUG_ERROR_PRINTLN("Failed to write validators file: " + path);
+        return false;
+    }
+    return true;
+}
+
+bool EventCache::loadValidators(const String& cachePath,
+                                HttpValidators& validators,
+                                time_t& coveredUntil) {
+    validators   = HttpValidators();
+    coveredUntil = 0;
+
+    String path = getValidatorsPath(cachePath);
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    String content = file.readString();
+    file.close();
+
+    int first  = content.indexOf('\n');
+    int second = first >= 0 ? content.indexOf('\n', first + 1) : -1;
+    if (second < 0) {
+        DEBUG_WARN_PRINTLN("Malformed validators file: " + path);
+        return false;
+    }
+
+    validators.etag         = content.substring(0, first);
+    validators.lastModified = content.substring(first + 1, second);
+    coveredUntil            = (time_t)content.substring(second + 1).toInt();
+    return !validators.isEmpty();
+}
+
+String EventCache::getValidatorsPath(const String& cachePath) {
+    if (cachePath.endsWith(".bin")) {
+        return cachePath.substring(0, cachePath.length() - 4) + ".etag";
+    }
+    return cachePath + ".etag";
+}
+
+bool EventCache::saveFeedTail(const String& cachePath, const FeedTail& tail, time_t coveredUntil) {
+    String path = getFeedTailPath(cachePath);
+    if (!tail.isValid()) {
+        if (LittleFS.exists(path)) {
+            LittleFS.remove(path);
+        }
+        return false;
+    }
+
+    if (!ensureCacheDirectory()) {
+        DEBUG_ERROR_PRINTLN("Failed to create cache directory");
+        return false;
+    }
+
+    // One value per line: tail offset, anchor CRC32, feed length, covered range end,
+    // then one "TZID<tab>POSIX rule" line per VTIMEZONE of the feed
+    String content = String((unsigned long)tail.offset) + "\n" + String((unsigned long)tail.anchorCrc) + "\n" +
+                     String((unsigned long)tail.length) + "\n" + String((long)coveredUntil) + "\n";
+    for (const auto& zone : tail.zones) {
+        content += zone.tzid + "\t" + zone.posix + "\n";
+    }
+
+    File file = LittleFS.open(path, "w");
+    if (!file) {
+        DEBUG_ERROR_PRINTLN("Failed to open feed tail file for writing: " + path);
+        return false;
+    }
+    size_t written = file.write((const uint8_t*)content.c_str(), content.length());
+    file.close();
+
+    if (written != content.length()) {
+        DEBUG_ERROR_PRINTLN("Failed to write feed tail file: " + path);
+        return false;
+    }
+    return true;
+}
+
+bool EventCache::loadFeedTail(const String& cachePath, FeedTail& tail, time_t& coveredUntil) {
+    tail         = FeedTail();
+    coveredUntil = 0;
+
+    String path = getFeedTailPath(cachePath);
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    String content = file.readString();
+    file.close();
+
+    int first  = content.indexOf('\n');
+    int second = first >= 0 ? content.indexOf('\n', first + 1) : -1;
+    int third  = second >= 0 ? content.indexOf('\n', second + 1) : -1;
+    if (third < 0) {
+        DEBUG_WARN_PRINTLN("Malformed feed tail file: " + path);
+        return false;
+    }
+
+    tail.offset    = (size_t)strtoul(content.substring(0, first).c_str(), nullptr, 10);
+    tail.anchorCrc = (uint32_t)strtoul(content.substring(first + 1, second).c_str(), nullptr, 10);
+    tail.length    = (size_t)strtoul(content.substring(second + 1, third).c_str(), nullptr, 10);
+    int fourth     = content.indexOf('\n', third + 1);
+    coveredUntil   = (time_t)content.substring(third + 1, fourth >= 0 ? fourth : content.length()).toInt();
+
+    int lineStart = fourth + 1;
+    while (fourth >= 0 && lineStart < (int)content.length()) {
+        int lineEnd = content.indexOf('\n', lineStart);
+        if (lineEnd < 0) {
+            lineEnd = content.length();
+        }
+        int tab = content.indexOf('\t', lineStart);
+        if (tab > lineStart && tab < lineEnd) {
+            FeedZone zone;
+            zone.tzid  = content.substring(lineStart, tab);
+            zone.posix = content.substring(tab + 1, lineEnd);
+            tail.zones.push_back(zone);
+        }
+        lineStart = lineEnd + 1;
+    }
+    return tail.isValid();
+}
+
+String EventCache::getFeedTailPath(const String& cachePath) {
+    if (cachePath.endsWith(".bin")) {
+        return cachePath.substring(0, cachePath.length() - 4) + ".tail";
+    }
+    return cachePath + ".tail";
+}
+
+String EventCache::getSpoolPath(const String& cachePath) {
+    if (cachePath.endsWith(".bin")) {
+        return cachePath.substring(0, cachePath.length() - 4) + ".ics";
+    }
+    return cachePath + ".ics";
+}
+
+String EventCache::getTempPath(const String& cachePath) {
+    if (cachePath.endsWith(".bin")) {
+        return cachePath.substring(0, cachePath.length() - 4) + ".tmp";
+    }
+    return cachePath + ".tmp";
+}
+
+bool EventCache::recover(const String& cachePath) {
+    String tempPath = getTempPath(cachePath);
+    if (!LittleFS.exists(tempPath)) {
+        return false;
+    }
+
+    // Only a complete save newer than the cache replaces it
+    uint32_t tempGeneration  = 0;
+    uint32_t cacheGeneration = 0;
+    bool promote             = checkFile(tempPath, tempGeneration) &&
+                   (!checkFile(cachePath, cacheGeneration) || tempGeneration > cacheGeneration);
+    if (promote && (LittleFS.rename(tempPath, cachePath) ||
+                    (LittleFS.remove(cachePath) && LittleFS.rename(tempPath, cachePath)))) {
+        DEBUG_INFO_PRINTLN("Recovered cache generation " + String(tempGeneration) + ": " + cachePath);
+        return true;
+    }
+
+    DEBUG_INFO_PRINTLN("Discarding unfinished cache save: " + tempPath);
+    LittleFS.remove(tempPath);
+    return false;
+}
+
+bool EventCache::checkFile(const String& path, uint32_t& generation) {
+    generation = 0;
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    CacheHeader header;
+    String url;
+    bool valid = readHeader(file, header, url) && header.eventCount > 0 &&
+                 header.eventCount <= MAX_EVENTS &&
+                 header.payloadLength == file.size() - file.position() && verifyChecksum(file, header);
+    file.close();
+
+    generation = header.generation;
+    return valid;
+}
+
+uint32_t EventCache::readGeneration(const String& path) {
+    if (!LittleFS.exists(path)) {
+        return 0;
+    }
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return 0;
+    }
+    CacheHeader header;
+    String url;
+    bool read = readHeader(file, header, url);
+    file.close();
+    return read ? header.generation : 0;
+}
+
 bool EventCache::remove(const String& cachePath) {
+    String validatorsPath = getValidatorsPath(cachePath);
+    if (LittleFS.exists(validatorsPath)) {
+        LittleFS.remove(validatorsPath);
+    }
+    String feedTailPath = getFeedTailPath(cachePath);
+    if (LittleFS.exists(feedTailPath)) {
+        LittleFS.remove(feedTailPath);
+    }
+    String spoolPath = getSpoolPath(cachePath);
+    if (LittleFS.exists(spoolPath)) {
+        LittleFS.remove(spoolPath);
+    }
+    String tempPath = getTempPath(cachePath);
+    if (LittleFS.exists(tempPath)) {
+        LittleFS.remove(tempPath);
+    }
+
     if (LittleFS.exists(cachePath)) {
         DEBUG_INFO_PRINTLN("Removing cache file: " + cachePath);
         return LittleFS.remove(cachePath);
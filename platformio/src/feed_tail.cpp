@@ -0,0 +1,184 @@
+/**
+ * Implementation of the feed tail tracker for incremental downloads
+ */
+
+#include "feed_tail.h"
+
+#include <string.h>
+
+#include "event_cache.h"
+
+namespace {
+
+const char END_VEVENT[] = "END:VEVENT";
+const size_t END_VEVENT_LENGTH = sizeof(END_VEVENT) - 1;
+
+} // namespace
+
+// ============================================================================
+// FeedTail
+// ============================================================================
+
+String FeedTail::rangeHeader() const
+{
+    return "bytes=" + String((unsigned long)rangeStart()) + "-";
+}
+
+bool FeedTail::matchesAnchor(Stream* stream) const
+{
+    uint8_t anchor[FEED_TAIL_ANCHOR_BYTES];
+    size_t received = 0;
+    while (received < sizeof(anchor)) {
+#ifdef NATIVE_TEST
+        size_t count = stream->readBytes(anchor + received, sizeof(anchor) - received);
+#else
+        size_t count = stream->readBytes((char*)anchor + received, sizeof(anchor) - received);
+#endif
+        if (count == 0) {
+            return false;
+        }
+        received += count;
+    }
+    return EventCache::calculateCRC32(anchor, sizeof(anchor)) == anchorCrc;
+}
+
+bool FeedTail::parseContentRange(const String& header, size_t& first, size_t& total)
+{
+    // bytes <first>-<last>/<total or *>
+    if (!header.startsWith("bytes ")) {
+        return false;
+    }
+    int dash  = header.indexOf('-', 6);
+    int slash = header.indexOf('/', dash + 1);
+    if (dash <= 6 || slash < 0) {
+        return false;
+    }
+    for (int i = 6; i < dash; i++) {
+        if (header[i] < '0' || header[i] > '9') {
+            return false;
+        }
+    }
+    first = (size_t)header.substring(6, dash).toInt();
+    String totalText = header.substring(slash + 1);
+    total = totalText == "*" ? 0 : (size_t)totalText.toInt();
+    return true;
+}
+
+// ============================================================================
+// FeedTailStream
+// ============================================================================
+
+FeedTailStream::FeedTailStream(Stream* source, size_t startOffset, const char* prefix)
+    : source(source)
+    , prefix(prefix ? prefix : "")
+    , prefixRemaining(strlen(this->prefix))
+    , position(startOffset)
+    , windowFill(0)
+    , lineLength(0)
+    , lastEventEnd(0)
+    , lastAnchorCrc(0)
+{
+}
+
+int FeedTailStream::available()
+{
+    return prefixRemaining > 0 ? (int)prefixRemaining : source->available();
+}
+
+int FeedTailStream::read()
+{
+    if (prefixRemaining > 0) {
+        prefixRemaining--;
+        return (uint8_t)*prefix++;
+    }
+    int c = source->read();
+    if (c >= 0) {
+        uint8_t byte = (uint8_t)c;
+        track(&byte, 1);
+    }
+    return c;
+}
+
+int FeedTailStream::peek()
+{
+    return prefixRemaining > 0 ? (uint8_t)*prefix : source->peek();
+}
+
+void FeedTailStream::flush() {}
+
+size_t FeedTailStream::write(uint8_t)
+{
+    return 0;
+}
+
+String FeedTailStream::readString()
+{
+    String result;
+    int c;
+    while ((c = read()) >= 0) {
+        result += (char)c;
+    }
+    return result;
+}
+
+#ifdef NATIVE_TEST
+size_t FeedTailStream::readBytes(uint8_t* buffer, size_t length)
+#else
+size_t FeedTailStream::readBytes(char* buffer, size_t length)
+#endif
+{
+    size_t copied = 0;
+    while (prefixRemaining > 0 && copied < length) {
+        buffer[copied++] = *prefix++;
+        prefixRemaining--;
+    }
+    if (copied == length) {
+        return copied;
+    }
+    size_t received = source->readBytes(buffer + copied, length - copied);
+    track((const uint8_t*)buffer + copied, received);
+    return copied + received;
+}
+
+FeedTail FeedTailStream::getTail() const
+{
+    FeedTail tail;
+    tail.offset    = lastEventEnd;
+    tail.anchorCrc = lastAnchorCrc;
+    tail.length    = position;
+    return tail;
+}
+
+void FeedTailStream::track(const uint8_t* data, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        uint8_t c = data[i];
+        window[position % FEED_TAIL_ANCHOR_BYTES] = c;
+        if (windowFill < FEED_TAIL_ANCHOR_BYTES) {
+            windowFill++;
+        }
+        position++;
+
+        if (c != '\n') {
+            if (c != '\r' && lineLength < sizeof(line)) {
+                line[lineLength] = (char)c;
+            }
+            if (c != '\r') {
+                lineLength++;
+            }
+            continue;
+        }
+
+        if (lineLength == END_VEVENT_LENGTH && memcmp(line, END_VEVENT, END_VEVENT_LENGTH) == 0 &&
+            windowFill == FEED_TAIL_ANCHOR_BYTES) {
+            // The ring starts at the oldest byte: unroll it for the checksum
+            uint8_t anchor[FEED_TAIL_ANCHOR_BYTES];
+            size_t oldest = position % FEED_TAIL_ANCHOR_BYTES;
+            memcpy(anchor, window + oldest, FEED_TAIL_ANCHOR_BYTES - oldest);
+            memcpy(anchor + FEED_TAIL_ANCHOR_BYTES - oldest, window, oldest);
+            lastEventEnd  = position;
+            lastAnchorCrc = EventCache::calculateCRC32(anchor, sizeof(anchor));
+        }
+        lineLength = 0;
+    }
+}
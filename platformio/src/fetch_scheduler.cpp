@@ -0,0 +1,167 @@
+/**
+ * Implementation of the concurrent fetch runner
+ */
+
+#include "fetch_scheduler.h"
+
+#ifdef NATIVE_TEST
+#include <chrono>
+#include <thread>
+#else
+#include "debug_config.h"
+#include <condition_variable>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+namespace {
+
+unsigned long elapsedMs()
+{
+#ifdef NATIVE_TEST
+    // The mock millis() is a call counter, not a clock
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - origin).count();
+#else
+    return millis();
+#endif
+}
+
+#ifndef NATIVE_TEST
+// Join barrier of one run(): each worker task signals once before deleting itself
+struct WorkerGroup {
+    std::function<void()> body;
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t running;
+};
+
+void workerTask(void* parameter)
+{
+    WorkerGroup* group = static_cast<WorkerGroup*>(parameter);
+    group->body();
+    {
+        // Notify under the lock: run() may destroy the group right after
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->running--;
+        group->finished.notify_one();
+    }
+    vTaskDelete(nullptr);
+}
+#endif
+
+} // namespace
+
+FetchScheduler::FetchScheduler(size_t maxConcurrent)
+    : maxConcurrent(maxConcurrent > 0 ? maxConcurrent : 1)
+    , nextJob(0)
+    , activeJobs(0)
+    , peakConcurrency(0)
+    , runStartMs(0)
+    , lastRunMs(0)
+{
+}
+
+size_t FetchScheduler::addJob(const String& name, Job job)
+{
+    jobs.push_back(job);
+    names.push_back(name);
+    return jobs.size() - 1;
+}
+
+size_t FetchScheduler::run()
+{
+    results.assign(jobs.size(), FetchJobResult());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        results[i].name = names[i];
+    }
+    nextJob = 0;
+    activeJobs = 0;
+    peakConcurrency = 0;
+    runStartMs = elapsedMs();
+
+    size_t workers = jobs.size() < maxConcurrent ? jobs.size() : maxConcurrent;
+
+#ifdef NATIVE_TEST
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers; i++) {
+        threads.push_back(std::thread(&FetchScheduler::workerLoop, this));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+#else
+    WorkerGroup group;
+    group.body = [this]() { workerLoop(); };
+    group.running = 0;
+
+    for (size_t i = 0; i < workers; i++) {
+        char taskName[16];
+        snprintf(taskName, sizeof(taskName), "fetch%u", (unsigned)i);
+        {
+            std::lock_guard<std::mutex> lock(group.mutex);
+            group.running++;
+        }
+        // Alternate cores so parsing on one core overlaps the radio on the other
+        if (xTaskCreatePinnedToCore(workerTask, taskName, FETCH_TASK_STACK_SIZE, &group,
+                                    FETCH_TASK_PRIORITY, nullptr, (BaseType_t)(i % 2)) != pdPASS) {
+            DEBUG_ERROR_PRINTLN("Failed to start fetch task " + String(taskName));
+            std::lock_guard<std::mutex> lock(group.mutex);
+            group.running--;
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(group.mutex);
+        group.finished.wait(lock, [&group]() { return group.running == 0; });
+    }
+
+    // No task could be started: run the jobs on the calling task
+    if (workers > 0 && nextJob == 0) {
+        workerLoop();
+    }
+#endif
+
+    lastRunMs = elapsedMs() - runStartMs;
+    jobs.clear();
+    names.clear();
+
+    size_t succeeded = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        if (results[i].success) {
+            succeeded++;
+        }
+    }
+    return succeeded;
+}
+
+void FetchScheduler::workerLoop()
+{
+    while (true) {
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (nextJob >= jobs.size()) {
+                return;
+            }
+            index = nextJob++;
+            activeJobs++;
+            if (activeJobs > peakConcurrency) {
+                peakConcurrency = activeJobs;
+            }
+        }
+
+        // Each job writes only its own result slot
+        FetchJobResult& result = results[index];
+        unsigned long start = elapsedMs();
+        result.startMs = start - runStartMs;
+        result.success = jobs[index] ? jobs[index]() : false;
+        result.durationMs = elapsedMs() - start;
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            activeJobs--;
+        }
+    }
+}
@@ -0,0 +1,292 @@
+/**
+ * Implementation of the fetch telemetry ring buffer
+ */
+
+#include "fetch_telemetry.h"
+
+#include <string.h>
+
+#include "event_cache.h"
+
+#ifdef NATIVE_TEST
+#define DEBUG_WARN_PRINTLN(x)                                                                      \
+    do {                                                                                           \
+    } while (0)
+// Native builds have no RTC memory; a static buffer outlives the telemetry objects the same way
+#define RTC_DATA_ATTR
+#else
+#include "debug_config.h"
+#include <esp_attr.h>
+#endif
+
+namespace {
+
+// Survives deep sleep; zeroed on power-on
+RTC_DATA_ATTR uint8_t rtcImage[FETCH_TELEMETRY_RTC_BYTES];
+RTC_DATA_ATTR uint32_t rtcImageLength = 0;
+
+uint16_t saturate16(size_t value)
+{
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+} // namespace
+
+const uint8_t FetchTelemetryRecord::FLAG_LOADED;
+const uint8_t FetchTelemetryRecord::FLAG_NOT_MODIFIED;
+const uint8_t FetchTelemetryRecord::FLAG_SPOOLED;
+const uint8_t FetchTelemetryRecord::FLAG_STALE;
+const uint8_t FetchTelemetryRecord::FLAG_REUSED;
+
+// ============================================================================
+// Records
+// ============================================================================
+
+FetchTelemetryRecord::FetchTelemetryRecord()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+void FetchTelemetryRecord::setTimings(const FetchTimings& timings)
+{
+    dnsMs     = saturate16(timings.dnsMs);
+    connectMs = saturate16(timings.connectMs);
+    tlsMs     = saturate16(timings.tlsMs);
+    ttfbMs    = saturate16(timings.ttfbMs);
+    retries   = timings.retries;
+    if (timings.reused) {
+        flags |= FLAG_REUSED;
+    }
+}
+
+void FetchTelemetryRecord::setEvents(size_t parsed, size_t filtered, size_t rejected)
+{
+    eventsParsed   = saturate16(parsed);
+    eventsFiltered = saturate16(filtered);
+    eventsRejected = saturate16(rejected);
+}
+
+void FetchTelemetryRecord::setSource(const String& name)
+{
+    memset(source, 0, sizeof(source));
+    strncpy(source, name.c_str(), sizeof(source) - 1);
+}
+
+FetchTelemetry::FetchTelemetry(size_t capacity, uint32_t keepWakes)
+    : ring(capacity > 0 ? capacity : 1)
+    , first(0)
+    , count(0)
+    , keepWakes(keepWakes > 0 ? keepWakes : 1)
+    , wake(0)
+    , flushedWake(0)
+{
+}
+
+uint32_t FetchTelemetry::beginWake()
+{
+    wake++;
+    while (count > 0 && wake - ring[first].wake >= keepWakes) {
+        first = (first + 1) % ring.size();
+        count--;
+    }
+    return wake;
+}
+
+void FetchTelemetry::record(const FetchTelemetryRecord& entry)
+{
+    FetchTelemetryRecord stamped = entry;
+    stamped.wake = wake;
+    stamped.source[sizeof(stamped.source) - 1] = '\0';
+
+    if (count < ring.size()) {
+        ring[slot(count)] = stamped;
+        count++;
+    } else {
+        ring[first] = stamped;
+        first = (first + 1) % ring.size();
+    }
+}
+
+std::vector<FetchTelemetryRecord> FetchTelemetry::getRecords() const
+{
+    std::vector<FetchTelemetryRecord> records;
+    records.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        records.push_back(ring[slot(i)]);
+    }
+    return records;
+}
+
+void FetchTelemetry::clear()
+{
+    first = 0;
+    count = 0;
+}
+
+String FetchTelemetry::format(const FetchTelemetryRecord& entry)
+{
+    const char* outcome = "failed";
+    if (entry.flags & FetchTelemetryRecord::FLAG_NOT_MODIFIED) {
+        outcome = "304";
+    } else if (entry.flags & FetchTelemetryRecord::FLAG_LOADED) {
+        outcome = "ok";
+    } else if (entry.flags & FetchTelemetryRecord::FLAG_STALE) {
+        outcome = "stale";
+    }
+
+    char line[200];
+    snprintf(line, sizeof(line),
+        "#%lu %-15s %-6s dns %u connect %u tls %u ttfb %u ms%s, %lu bytes, parse %lu ms%s, "
+        "events %u/%u/%u, retries %u",
+        (unsigned long)entry.wake,
+        entry.source,
+        outcome,
+        (unsigned)entry.dnsMs,
+        (unsigned)entry.connectMs,
+        (unsigned)entry.tlsMs,
+        (unsigned)entry.ttfbMs,
+        (entry.flags & FetchTelemetryRecord::FLAG_REUSED) ? " (reused)" : "",
+        (unsigned long)entry.bytes,
+        (unsigned long)entry.parseMs,
+        (entry.flags & FetchTelemetryRecord::FLAG_SPOOLED) ? " (spooled)" : "",
+        (unsigned)entry.eventsParsed,
+        (unsigned)entry.eventsFiltered,
+        (unsigned)entry.eventsRejected,
+        (unsigned)entry.retries);
+    return String(line);
+}
+
+// ============================================================================
+// Serialization
+// ============================================================================
+
+size_t FetchTelemetry::serialize(uint8_t* buffer, size_t capacity) const
+{
+    if (capacity < sizeof(ImageHeader)) {
+        return 0;
+    }
+
+    // Newest records win when the buffer is short
+    size_t fit = (capacity - sizeof(ImageHeader)) / sizeof(FetchTelemetryRecord);
+    size_t skip = count > fit ? count - fit : 0;
+    uint8_t* payload = buffer + sizeof(ImageHeader);
+    size_t payloadLength = 0;
+    for (size_t i = skip; i < count; i++) {
+        memcpy(payload + payloadLength, &ring[slot(i)], sizeof(FetchTelemetryRecord));
+        payloadLength += sizeof(FetchTelemetryRecord);
+    }
+
+    ImageHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic         = FETCH_TELEMETRY_MAGIC;
+    header.version       = FETCH_TELEMETRY_VERSION;
+    header.count         = (uint16_t)(count - skip);
+    header.wake          = wake;
+    header.flushedWake   = flushedWake;
+    header.payloadLength = payloadLength;
+    header.checksum      = EventCache::calculateCRC32(payload, payloadLength);
+    memcpy(buffer, &header, sizeof(header));
+    return sizeof(header) + payloadLength;
+}
+
+bool FetchTelemetry::deserialize(const uint8_t* data, size_t length)
+{
+    if (!data || length < sizeof(ImageHeader)) {
+        return false;
+    }
+
+    ImageHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != FETCH_TELEMETRY_MAGIC || header.version != FETCH_TELEMETRY_VERSION ||
+        header.payloadLength > length - sizeof(header) ||
+        header.payloadLength != (uint32_t)header.count * sizeof(FetchTelemetryRecord)) {
+        return false;
+    }
+    const uint8_t* payload = data + sizeof(header);
+    if (EventCache::calculateCRC32(payload, header.payloadLength) != header.checksum) {
+        DEBUG_WARN_PRINTLN("Fetch telemetry image checksum mismatch");
+        return false;
+    }
+
+    clear();
+    wake        = header.wake;
+    flushedWake = header.flushedWake;
+    // An image from a larger ring keeps its newest records
+    size_t skip = header.count > ring.size() ? header.count - ring.size() : 0;
+    for (size_t i = skip; i < header.count; i++) {
+        FetchTelemetryRecord entry;
+        memcpy(&entry, payload + i * sizeof(FetchTelemetryRecord), sizeof(entry));
+        entry.source[sizeof(entry.source) - 1] = '\0';
+        ring[slot(count)] = entry;
+        count++;
+    }
+    return true;
+}
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+bool FetchTelemetry::load(const char* path)
+{
+    if (rtcImageLength > 0 && rtcImageLength <= sizeof(rtcImage) && deserialize(rtcImage, rtcImageLength)) {
+        return true;
+    }
+    // Power-on: the file holds the records as of its last flush
+    return loadFile(path);
+}
+
+bool FetchTelemetry::loadFile(const char* path)
+{
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> image(file.size());
+    size_t read = image.empty() ? 0 : file.read(image.data(), image.size());
+    file.close();
+
+    return read == image.size() && deserialize(image.data(), image.size());
+}
+
+bool FetchTelemetry::save(const char* path)
+{
+    rtcImageLength = serialize(rtcImage, sizeof(rtcImage));
+
+    if (wake - flushedWake < FETCH_TELEMETRY_FLUSH_WAKES) {
+        return true;
+    }
+    return flush(path);
+}
+
+bool FetchTelemetry::flush(const char* path)
+{
+    uint32_t previousFlush = flushedWake;
+    flushedWake = wake;
+
+    std::vector<uint8_t> image(sizeof(ImageHeader) + count * sizeof(FetchTelemetryRecord));
+    size_t length = serialize(image.data(), image.size());
+
+    File file = LittleFS.open(path, "w");
+    bool written = file && file.write(image.data(), length) == length;
+    if (file) {
+        file.close();
+    }
+    if (!written) {
+        DEBUG_WARN_PRINTLN("Failed to write " + String(path));
+        flushedWake = previousFlush;
+        return false;
+    }
+
+    // The RTC image carries the new flush wake too
+    rtcImageLength = serialize(rtcImage, sizeof(rtcImage));
+    return true;
+}
+
+void FetchTelemetry::clearRtcImage()
+{
+    rtcImageLength = 0;
+}
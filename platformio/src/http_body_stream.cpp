@@ -0,0 +1,289 @@
+/**
+ * Implementation of the HTTP/1.1 body framing adapter
+ */
+
+#include "http_body_stream.h"
+
+namespace {
+
+// Longest chunk size accepted (8 hex digits)
+const int MAX_CHUNK_SIZE_DIGITS = 8;
+
+int hexValue(int c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+} // namespace
+
+HttpBodyStream::HttpBodyStream(Stream* source, int contentLength, bool chunked)
+    : source(source)
+    , chunked(chunked)
+    , lengthKnown(!chunked && contentLength >= 0)
+    , remaining(lengthKnown ? (size_t)contentLength : 0)
+    , complete(false)
+    , needChunkCrlf(false)
+    , error(nullptr)
+    , bodyBytes(0)
+    , peeked(-1)
+{
+}
+
+// ============================================================================
+// Stream interface
+// ============================================================================
+
+int HttpBodyStream::available()
+{
+    if (peeked >= 0) {
+        return 1;
+    }
+    size_t count = readable(false);
+    return count > 0x7FFF ? 0x7FFF : (int)count;
+}
+
+int HttpBodyStream::read()
+{
+    if (peeked >= 0) {
+        int c = peeked;
+        peeked = -1;
+        return c;
+    }
+    uint8_t c;
+    return take(&c, 1) == 1 ? c : -1;
+}
+
+int HttpBodyStream::peek()
+{
+    if (peeked < 0) {
+        uint8_t c;
+        if (take(&c, 1) == 1) {
+            peeked = c;
+        }
+    }
+    return peeked;
+}
+
+void HttpBodyStream::flush() {}
+
+size_t HttpBodyStream::write(uint8_t)
+{
+    return 0;
+}
+
+String HttpBodyStream::readString()
+{
+    String result;
+    int c;
+    while ((c = read()) >= 0) {
+        result += (char)c;
+    }
+    return result;
+}
+
+#ifdef NATIVE_TEST
+size_t HttpBodyStream::readBytes(uint8_t* buffer, size_t length)
+#else
+size_t HttpBodyStream::readBytes(char* buffer, size_t length)
+#endif
+{
+    if (length == 0) {
+        return 0;
+    }
+    size_t copied = 0;
+    if (peeked >= 0) {
+        buffer[0] = (char)peeked;
+        peeked = -1;
+        copied = 1;
+    }
+    return copied + take((uint8_t*)buffer + copied, length - copied);
+}
+
+bool HttpBodyStream::drain(size_t limit)
+{
+    uint8_t scratch[256];
+    size_t discarded = 0;
+    peeked = -1;
+    while (!complete && !error && discarded < limit) {
+        size_t want = limit - discarded < sizeof(scratch) ? limit - discarded : sizeof(scratch);
+        size_t count = take(scratch, want);
+        if (count == 0) {
+            break;
+        }
+        discarded += count;
+    }
+    // Reaching the end of the last chunk still leaves its terminator to read
+    if (!complete && !error) {
+        readable(false);
+    }
+    return complete;
+}
+
+// ============================================================================
+// Framing
+// ============================================================================
+
+void HttpBodyStream::fail(const char* message)
+{
+    if (!error) {
+        error = message;
+    }
+}
+
+size_t HttpBodyStream::take(uint8_t* buffer, size_t length)
+{
+    size_t copied = 0;
+    while (copied < length) {
+        // Block for the first byte only; then take what has already arrived
+        size_t count = readable(copied == 0);
+        if (count == 0) {
+            break;
+        }
+        if (count > length - copied) {
+            count = length - copied;
+        }
+#ifdef NATIVE_TEST
+        size_t received = source->readBytes(buffer + copied, count);
+#else
+        size_t received = source->readBytes((char*)buffer + copied, count);
+#endif
+        if (received == 0) {
+            if (chunked || lengthKnown) {
+                fail("Connection ended before the end of the body");
+            } else {
+                complete = true;
+            }
+            break;
+        }
+        copied += received;
+        bodyBytes += received;
+        if (chunked || lengthKnown) {
+            remaining -= received;
+            needChunkCrlf = chunked && remaining == 0;
+        }
+    }
+    return copied;
+}
+
+size_t HttpBodyStream::readable(bool wait)
+{
+    if (complete || error) {
+        return 0;
+    }
+
+    if (lengthKnown && remaining == 0) {
+        complete = true;
+        return 0;
+    }
+
+    if (chunked && remaining == 0) {
+        if (needChunkCrlf) {
+            needChunkCrlf = false;
+            if (skipLine() != 0) {
+                fail("Missing CRLF after chunk data");
+                return 0;
+            }
+        }
+        if (!readChunkHeader() || complete) {
+            return 0;
+        }
+    }
+
+    // When waiting, ask for one byte even if none has arrived: the caller's
+    // readBytes() blocks on the source until it does or the source times out
+    int available = source->available();
+    if (available <= 0) {
+        if (!wait) {
+            return 0;
+        }
+        available = 1;
+    }
+    if ((chunked || lengthKnown) && (size_t)available > remaining) {
+        return remaining;
+    }
+    return (size_t)available;
+}
+
+bool HttpBodyStream::readChunkHeader()
+{
+    // chunk-size [ chunk-ext ] CRLF
+    size_t size = 0;
+    int digits = 0;
+    int c;
+    while ((c = nextSourceByte()) >= 0) {
+        int value = hexValue(c);
+        if (value < 0) {
+            break;
+        }
+        if (++digits > MAX_CHUNK_SIZE_DIGITS) {
+            fail("Chunk size too large");
+            return false;
+        }
+        size = size * 16 + (size_t)value;
+    }
+    if (c < 0) {
+        fail("Connection ended in a chunk header");
+        return false;
+    }
+    if (digits == 0) {
+        fail("Malformed chunk size");
+        return false;
+    }
+    if (c != '\n' && skipLine() < 0) {
+        return false;
+    }
+
+    if (size > 0) {
+        remaining = size;
+        return true;
+    }
+
+    // Last chunk: skip the trailer fields up to the empty line
+    while (true) {
+        int length = skipLine();
+        if (length < 0) {
+            return false;
+        }
+        if (length == 0) {
+            break;
+        }
+    }
+    complete = true;
+    return true;
+}
+
+int HttpBodyStream::skipLine()
+{
+    int length = 0;
+    int c;
+    while ((c = nextSourceByte()) >= 0) {
+        if (c == '\n') {
+            return length;
+        }
+        if (c != '\r') {
+            length++;
+        }
+    }
+    fail("Connection ended in a chunk header");
+    return -1;
+}
+
+int HttpBodyStream::nextSourceByte()
+{
+    uint8_t c;
+#ifdef NATIVE_TEST
+    size_t received = source->readBytes(&c, 1);
+#else
+    size_t received = source->readBytes((char*)&c, 1);
+#endif
+    return received == 1 ? c : -1;
+}
@@ -0,0 +1,271 @@
+/**
+ * Implementation of the block-reading ICS line tokenizer
+ */
+
+#include "ics_line_reader.h"
+
+#include <cctype>
+#include <cstdlib>
+
+IcsLineReader::IcsLineReader(Stream* stream, size_t bufferSize)
+    : stream(stream)
+    , buffer(nullptr)
+    , capacity(bufferSize < 2 * MIN_READ_CHUNK ? 2 * MIN_READ_CHUNK : bufferSize)
+    , maxLineLength(0)
+    , lineStart(0)
+    , writePos(0)
+    , scanPos(0)
+    , dataEnd(0)
+    , streamEnded(stream == nullptr)
+    , finished(false)
+    , bytesRead(0)
+    , linesRead(0)
+    , linesTruncated(0)
+    , stallMs(0)
+{
+    maxLineLength = capacity - MIN_READ_CHUNK;
+    buffer = (char*)malloc(capacity);
+    if (!buffer) {
+        streamEnded = true;
+        finished = true;
+    }
+}
+
+IcsLineReader::~IcsLineReader()
+{
+    free(buffer);
+}
+
+bool IcsLineReader::contains(const char* line, size_t length, const char* needle)
+{
+    size_t needleLength = strlen(needle);
+    if (needleLength == 0) {
+        return true;
+    }
+    if (length < needleLength) {
+        return false;
+    }
+
+    const char* last = line + (length - needleLength);
+    for (const char* p = line; p <= last; p++) {
+        p = (const char*)memchr(p, needle[0], (last - p) + 1);
+        if (!p) {
+            return false;
+        }
+        if (memcmp(p, needle, needleLength) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IcsLineReader::splitProperty(const char* line, size_t length, IcsProperty& property)
+{
+    size_t i = 0;
+    while (i < length && line[i] != ';' && line[i] != ':') {
+        i++;
+    }
+    if (i == length) {
+        return false;
+    }
+
+    property.name = line;
+    property.nameLength = i;
+    property.params = line + i;
+    property.paramsLength = 0;
+
+    if (line[i] == ';') {
+        size_t paramsStart = i + 1;
+        bool quoted = false;
+        for (i = paramsStart; i < length; i++) {
+            if (line[i] == '"') {
+                quoted = !quoted;
+            } else if (line[i] == ':' && !quoted) {
+                break;
+            }
+        }
+        if (i == length) {
+            return false;
+        }
+        property.params = line + paramsStart;
+        property.paramsLength = i - paramsStart;
+    }
+
+    property.value = line + i + 1;
+    property.valueLength = length - i - 1;
+    return true;
+}
+
+bool IcsLineReader::findParameter(const IcsProperty& property, const char* name, const char*& value,
+                                  size_t& valueLength)
+{
+    size_t nameLength = strlen(name);
+    const char* p = property.params;
+    const char* end = property.params + property.paramsLength;
+
+    while (p < end) {
+        // Find the end of this parameter, skipping ';' inside quotes
+        const char* paramEnd = p;
+        bool quoted = false;
+        while (paramEnd < end && (quoted || *paramEnd != ';')) {
+            if (*paramEnd == '"') {
+                quoted = !quoted;
+            }
+            paramEnd++;
+        }
+
+        const char* equals = (const char*)memchr(p, '=', paramEnd - p);
+        if (equals && (size_t)(equals - p) == nameLength) {
+            bool match = true;
+            for (size_t k = 0; k < nameLength; k++) {
+                if (toupper((unsigned char)p[k]) != toupper((unsigned char)name[k])) {
+                    match = false;
+                    break;
+                }
+            }
+            if (match) {
+                value = equals + 1;
+                valueLength = paramEnd - value;
+                if (valueLength >= 2 && value[0] == '"' && value[valueLength - 1] == '"') {
+                    value++;
+                    valueLength -= 2;
+                }
+                return true;
+            }
+        }
+
+        p = paramEnd + 1;
+    }
+
+    return false;
+}
+
+void IcsLineReader::compact()
+{
+    // Keep the unfolded line content [lineStart, writePos) and the unread
+    // bytes [scanPos, dataEnd). Everything else (consumed lines and the gap
+    // left behind by removed folds) is dropped.
+    size_t lineBytes = writePos - lineStart;
+    size_t pendingBytes = dataEnd - scanPos;
+
+    if (lineStart > 0 && lineBytes > 0) {
+        memmove(buffer, buffer + lineStart, lineBytes);
+    }
+    if (scanPos != lineBytes && pendingBytes > 0) {
+        memmove(buffer + lineBytes, buffer + scanPos, pendingBytes);
+    }
+
+    lineStart = 0;
+    writePos = lineBytes;
+    scanPos = lineBytes;
+    dataEnd = lineBytes + pendingBytes;
+}
+
+bool IcsLineReader::fill()
+{
+    if (streamEnded) {
+        return false;
+    }
+
+    if (capacity - dataEnd < MIN_READ_CHUNK) {
+        compact();
+    }
+
+    // Take what has already arrived without waiting. Otherwise block in
+    // readBytes() until the next byte arrives or the stream's own timeout
+    // (Stream::setTimeout) expires, which ends the stream.
+    size_t space = capacity - dataEnd;
+    int available = stream->available();
+    size_t received;
+    if (available > 0) {
+        size_t toRead = ((size_t)available < space) ? (size_t)available : space;
+        received = stream->readBytes((uint8_t*)(buffer + dataEnd), toRead);
+    } else {
+        unsigned long waitStart = millis();
+        received = stream->readBytes((uint8_t*)(buffer + dataEnd), 1);
+        stallMs += millis() - waitStart;
+    }
+    if (received == 0) {
+        streamEnded = true;
+        return false;
+    }
+
+    dataEnd += received;
+    bytesRead += received;
+    return true;
+}
+
+bool IcsLineReader::ensureAvailable(size_t position)
+{
+    // fill() may compact the buffer, which shifts every offset by the same
+    // amount; callers pass positions relative to scanPos so re-derive them.
+    size_t offset = position - scanPos;
+    while (scanPos + offset >= dataEnd) {
+        if (!fill()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IcsLineReader::next(const char*& line, size_t& length)
+{
+    if (finished) {
+        return false;
+    }
+
+    lineStart = scanPos;
+    writePos = scanPos;
+    bool truncated = false;
+    bool consumedAny = false;
+
+    while (true) {
+        if (scanPos >= dataEnd && !ensureAvailable(scanPos)) {
+            // End of stream: return the trailing line if it has content
+            finished = true;
+            if (!consumedAny) {
+                return false;
+            }
+            break;
+        }
+
+        consumedAny = true;
+        char c = buffer[scanPos];
+
+        if (c == '\r' || c == '\n') {
+            size_t terminatorLength = 1;
+            if (c == '\r' && ensureAvailable(scanPos + 1) && buffer[scanPos + 1] == '\n') {
+                terminatorLength = 2;
+            }
+
+            // RFC 5545 folding: a line break followed by a single space or tab
+            // continues the previous line. Drop the break and the whitespace.
+            if (ensureAvailable(scanPos + terminatorLength)) {
+                char following = buffer[scanPos + terminatorLength];
+                if (following == ' ' || following == '\t') {
+                    scanPos += terminatorLength + 1;
+                    continue;
+                }
+            }
+
+            scanPos += terminatorLength;
+            break;
+        }
+
+        if (writePos - lineStart < maxLineLength) {
+            buffer[writePos++] = c;
+        } else {
+            truncated = true;
+        }
+        scanPos++;
+    }
+
+    if (truncated) {
+        linesTruncated++;
+    }
+    linesRead++;
+
+    line = buffer + lineStart;
+    length = writePos - lineStart;
+    return true;
+}
@@ -0,0 +1,637 @@
+/**
+ * Implementation of the streaming gzip / deflate decoder (RFC 1950-1952)
+ */
+
+#include "inflate_stream.h"
+
+#include <cstring>
+#include <new>
+
+const size_t InflateStream::WINDOW_SIZE;
+const size_t InflateStream::INPUT_BUFFER_SIZE;
+
+namespace {
+
+// Output buffered per produce() call before handing control back to the reader
+const size_t OUTPUT_CHUNK = 4096;
+
+// Longest back-reference; decoding pauses while less space than this is left
+const size_t MAX_MATCH = 258;
+
+const uint16_t LENGTH_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                  31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                  2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t DIST_BASE[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Order in which code length code lengths are stored (RFC 1951 3.2.7)
+const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// gzip header flags
+const uint8_t GZIP_FHCRC = 0x02;
+const uint8_t GZIP_FEXTRA = 0x04;
+const uint8_t GZIP_FNAME = 0x08;
+const uint8_t GZIP_FCOMMENT = 0x10;
+
+} // namespace
+
+InflateStream::InflateStream(Stream* source, Format format)
+    : source(source)
+    , format(format)
+    , state(STATE_HEADER)
+    , error(nullptr)
+    , window(nullptr)
+    , writePos(0)
+    , readPos(0)
+    , inputPos(0)
+    , inputEnd(0)
+    , compressedBytes(0)
+    , truncated(false)
+    , zlibWrapped(false)
+    , bitBuffer(0)
+    , bitCount(0)
+    , finalBlock(false)
+    , storedRemaining(0)
+    , matchRemaining(0)
+    , matchDistance(0)
+{
+    window = new (std::nothrow) uint8_t[WINDOW_SIZE];
+    if (!window) {
+        fail("Out of memory for inflate window");
+    }
+}
+
+InflateStream::~InflateStream()
+{
+    delete[] window;
+}
+
+bool InflateStream::formatForEncoding(const String& contentEncoding, Format& format)
+{
+    String encoding = contentEncoding;
+    encoding.trim();
+    encoding.toLowerCase();
+    if (encoding == "gzip" || encoding == "x-gzip") {
+        format = FORMAT_GZIP;
+        return true;
+    }
+    if (encoding == "deflate") {
+        format = FORMAT_DEFLATE;
+        return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// Stream interface
+// ============================================================================
+
+int InflateStream::available()
+{
+    // Only decode input that has already arrived: available() does not block
+    if (unread() == 0 && (inputPos < inputEnd || (source && source->available() > 0))) {
+        produce();
+    }
+    size_t count = unread();
+    return count > 0x7FFF ? 0x7FFF : (int)count;
+}
+
+int InflateStream::read()
+{
+    uint8_t c;
+    return take(&c, 1) == 1 ? c : -1;
+}
+
+int InflateStream::peek()
+{
+    if (unread() == 0) {
+        produce();
+    }
+    return unread() > 0 ? window[readPos % WINDOW_SIZE] : -1;
+}
+
+void InflateStream::flush() {}
+
+size_t InflateStream::write(uint8_t)
+{
+    return 0;
+}
+
+String InflateStream::readString()
+{
+    String result;
+    char chunk[129];
+    size_t count;
+    while ((count = take((uint8_t*)chunk, sizeof(chunk) - 1)) > 0) {
+        chunk[count] = '\0';
+        result += chunk;
+    }
+    return result;
+}
+
+#ifdef NATIVE_TEST
+size_t InflateStream::readBytes(uint8_t* buffer, size_t length)
+{
+    return take(buffer, length);
+}
+#else
+size_t InflateStream::readBytes(char* buffer, size_t length)
+{
+    return take((uint8_t*)buffer, length);
+}
+#endif
+
+size_t InflateStream::take(uint8_t* buffer, size_t length)
+{
+    size_t copied = 0;
+    while (copied < length) {
+        if (unread() == 0) {
+            produce();
+            if (unread() == 0) {
+                break;
+            }
+        }
+
+        // Contiguous run up to the end of the ring
+        size_t offset = readPos % WINDOW_SIZE;
+        size_t run = WINDOW_SIZE - offset;
+        if (run > unread()) {
+            run = unread();
+        }
+        if (run > length - copied) {
+            run = length - copied;
+        }
+        memcpy(buffer + copied, window + offset, run);
+        readPos += run;
+        copied += run;
+    }
+    return copied;
+}
+
+// ============================================================================
+// Decoder
+// ============================================================================
+
+void InflateStream::fail(const char* message)
+{
+    if (state != STATE_ERROR) {
+        state = STATE_ERROR;
+        error = message;
+    }
+}
+
+void InflateStream::produce()
+{
+    size_t target = readPos + OUTPUT_CHUNK;
+    while (writePos < target && state != STATE_DONE && state != STATE_ERROR) {
+        // Keep room for the longest back-reference without touching unread output
+        if (WINDOW_SIZE - unread() < MAX_MATCH) {
+            break;
+        }
+
+        switch (state) {
+        case STATE_HEADER:
+            if (readHeader()) {
+                state = STATE_BLOCK;
+            }
+            break;
+        case STATE_BLOCK:
+            readBlockHeader();
+            break;
+        case STATE_STORED:
+            copyStored();
+            break;
+        case STATE_CODES:
+            decodeCodes();
+            break;
+        case STATE_TRAILER:
+            if (readTrailer()) {
+                state = STATE_DONE;
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (truncated) {
+            fail("Compressed data ends early");
+        }
+    }
+}
+
+bool InflateStream::readHeader()
+{
+    int first = nextByte();
+    int second = nextByte();
+    if (truncated) {
+        return false;
+    }
+
+    if (format == FORMAT_GZIP) {
+        if (first != 0x1F || second != 0x8B || nextByte() != 8) {
+            fail("Not a gzip stream");
+            return false;
+        }
+        int flags = nextByte();
+        for (int i = 0; i < 6; i++) {
+            nextByte(); // MTIME, XFL, OS
+        }
+        if (flags & GZIP_FEXTRA) {
+            int extraLength = nextByte();
+            extraLength |= nextByte() << 8;
+            for (int i = 0; i < extraLength && !truncated; i++) {
+                nextByte();
+            }
+        }
+        if (flags & GZIP_FNAME) {
+            while (nextByte() > 0) {
+            }
+        }
+        if (flags & GZIP_FCOMMENT) {
+            while (nextByte() > 0) {
+            }
+        }
+        if (flags & GZIP_FHCRC) {
+            nextByte();
+            nextByte();
+        }
+        return !truncated;
+    }
+
+    // "deflate" is zlib-wrapped per RFC 9110, but some servers send raw deflate
+    bool zlib = (first & 0x0F) == 8 && (first >> 4) <= 7 && ((first << 8) | second) % 31 == 0;
+    if (!zlib) {
+        // Raw deflate: hand both bytes back to the bit reader
+        bitBuffer = (uint32_t)first | ((uint32_t)second << 8);
+        bitCount = 16;
+        return true;
+    }
+    if (second & 0x20) {
+        fail("zlib preset dictionaries are not supported");
+        return false;
+    }
+    zlibWrapped = true;
+    return true;
+}
+
+bool InflateStream::readBlockHeader()
+{
+    finalBlock = getBits(1) != 0;
+    uint32_t type = getBits(2);
+    if (truncated) {
+        return false;
+    }
+
+    if (type == 0) {
+        alignToByte();
+        uint32_t length = getBits(16);
+        uint32_t complement = getBits(16);
+        if (truncated) {
+            return false;
+        }
+        if ((length ^ 0xFFFF) != complement) {
+            fail("Stored block length mismatch");
+            return false;
+        }
+        storedRemaining = length;
+        state = STATE_STORED;
+        return true;
+    }
+
+    if (type == 1) {
+        // Fixed codes (RFC 1951 3.2.6)
+        uint8_t lengths[288 + 30];
+        int symbol = 0;
+        for (; symbol < 144; symbol++) {
+            lengths[symbol] = 8;
+        }
+        for (; symbol < 256; symbol++) {
+            lengths[symbol] = 9;
+        }
+        for (; symbol < 280; symbol++) {
+            lengths[symbol] = 7;
+        }
+        for (; symbol < 288; symbol++) {
+            lengths[symbol] = 8;
+        }
+        for (int i = 0; i < 30; i++) {
+            lengths[288 + i] = 5;
+        }
+        buildHuffman(literals, lengths, 288, false);
+        buildHuffman(distances, lengths + 288, 30, true);
+        state = STATE_CODES;
+        return true;
+    }
+
+    if (type == 2) {
+        if (readDynamicTables()) {
+            state = STATE_CODES;
+            return true;
+        }
+        return false;
+    }
+
+    fail("Invalid block type");
+    return false;
+}
+
+bool InflateStream::readDynamicTables()
+{
+    int literalCount = (int)getBits(5) + 257;
+    int distanceCount = (int)getBits(5) + 1;
+    int codeLengthCount = (int)getBits(4) + 4;
+    if (truncated) {
+        return false;
+    }
+    if (literalCount > 286 || distanceCount > 30) {
+        fail("Too many length or distance codes");
+        return false;
+    }
+
+    uint8_t lengths[288 + 30];
+    memset(lengths, 0, 19);
+    for (int i = 0; i < codeLengthCount; i++) {
+        lengths[CODE_LENGTH_ORDER[i]] = (uint8_t)getBits(3);
+    }
+
+    Huffman codeLengths;
+    if (!buildHuffman(codeLengths, lengths, 19, false)) {
+        fail("Invalid code length code");
+        return false;
+    }
+
+    int index = 0;
+    while (index < literalCount + distanceCount && !truncated) {
+        int symbol = decodeSymbol(codeLengths);
+        if (symbol < 0) {
+            fail("Invalid code length");
+            return false;
+        }
+        if (symbol < 16) {
+            lengths[index++] = (uint8_t)symbol;
+            continue;
+        }
+
+        uint8_t repeated = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                fail("Length repeat with no previous length");
+                return false;
+            }
+            repeated = lengths[index - 1];
+            repeat = 3 + (int)getBits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + (int)getBits(3);
+        } else {
+            repeat = 11 + (int)getBits(7);
+        }
+        if (index + repeat > literalCount + distanceCount) {
+            fail("Code lengths overflow");
+            return false;
+        }
+        while (repeat-- > 0) {
+            lengths[index++] = repeated;
+        }
+    }
+    if (truncated) {
+        return false;
+    }
+
+    if (lengths[256] == 0) {
+        fail("No end-of-block code");
+        return false;
+    }
+    // Incomplete literal/length codes are only valid with a single code
+    if (!buildHuffman(literals, lengths, literalCount, false) ||
+        !buildHuffman(distances, lengths + literalCount, distanceCount, true)) {
+        fail("Invalid literal/length or distance code");
+        return false;
+    }
+    return true;
+}
+
+void InflateStream::decodeCodes()
+{
+    const size_t target = readPos + OUTPUT_CHUNK;
+
+    while (!truncated) {
+        // Finish a back-reference interrupted by a full window
+        while (matchRemaining > 0) {
+            size_t space = WINDOW_SIZE - unread();
+            if (space == 0) {
+                return;
+            }
+            size_t count = matchRemaining < space ? matchRemaining : space;
+            for (size_t i = 0; i < count; i++) {
+                window[writePos % WINDOW_SIZE] = window[(writePos - matchDistance) % WINDOW_SIZE];
+                writePos++;
+            }
+            matchRemaining -= count;
+        }
+
+        if (writePos >= target || WINDOW_SIZE - unread() < MAX_MATCH) {
+            return;
+        }
+
+        int symbol = decodeSymbol(literals);
+        if (symbol < 0) {
+            fail("Invalid literal/length code");
+            return;
+        }
+        if (symbol < 256) {
+            window[writePos % WINDOW_SIZE] = (uint8_t)symbol;
+            writePos++;
+            continue;
+        }
+        if (symbol == 256) {
+            state = finalBlock ? STATE_TRAILER : STATE_BLOCK;
+            return;
+        }
+
+        symbol -= 257;
+        if (symbol >= 29) {
+            fail("Invalid length symbol");
+            return;
+        }
+        size_t length = LENGTH_BASE[symbol] + getBits(LENGTH_EXTRA[symbol]);
+
+        int distanceSymbol = decodeSymbol(distances);
+        if (distanceSymbol < 0 || distanceSymbol >= 30) {
+            fail("Invalid distance code");
+            return;
+        }
+        size_t distance = DIST_BASE[distanceSymbol] + getBits(DIST_EXTRA[distanceSymbol]);
+        if (distance > writePos || distance > WINDOW_SIZE) {
+            fail("Distance too far back");
+            return;
+        }
+
+        matchRemaining = length;
+        matchDistance = distance;
+    }
+}
+
+void InflateStream::copyStored()
+{
+    while (storedRemaining > 0 && unread() < WINDOW_SIZE && !truncated) {
+        window[writePos % WINDOW_SIZE] = (uint8_t)getBits(8);
+        writePos++;
+        storedRemaining--;
+    }
+    if (storedRemaining == 0) {
+        state = finalBlock ? STATE_TRAILER : STATE_BLOCK;
+    }
+}
+
+bool InflateStream::readTrailer()
+{
+    alignToByte();
+    if (format == FORMAT_GZIP) {
+        getBits(16); // CRC32
+        getBits(16);
+        uint32_t size = getBits(16);
+        size |= getBits(16) << 16;
+        if (truncated) {
+            return false;
+        }
+        if (size != (uint32_t)writePos) {
+            fail("gzip length mismatch");
+            return false;
+        }
+        return true;
+    }
+    if (zlibWrapped) {
+        getBits(16); // Adler-32
+        getBits(16);
+        return !truncated;
+    }
+    // Raw deflate has no trailer
+    return true;
+}
+
+// ============================================================================
+// Huffman codes and bit input
+// ============================================================================
+
+bool InflateStream::buildHuffman(Huffman& table, const uint8_t* lengths, int count, bool allowIncomplete)
+{
+    memset(table.counts, 0, sizeof(table.counts));
+    for (int symbol = 0; symbol < count; symbol++) {
+        table.counts[lengths[symbol]]++;
+    }
+    table.counts[0] = 0;
+
+    // Over-subscribed codes are never valid; incomplete ones only where allowed
+    int left = 1;
+    for (int length = 1; length < 16; length++) {
+        left <<= 1;
+        left -= table.counts[length];
+        if (left < 0) {
+            return false;
+        }
+    }
+    if (left > 0 && !allowIncomplete) {
+        // A single code of length one is the one incomplete code zlib emits
+        int used = 0;
+        for (int length = 1; length < 16; length++) {
+            used += table.counts[length];
+        }
+        if (used > 1) {
+            return false;
+        }
+    }
+
+    uint16_t offsets[16];
+    offsets[1] = 0;
+    for (int length = 1; length < 15; length++) {
+        offsets[length + 1] = offsets[length] + table.counts[length];
+    }
+    for (int symbol = 0; symbol < count; symbol++) {
+        if (lengths[symbol] != 0) {
+            table.symbols[offsets[lengths[symbol]]++] = (uint16_t)symbol;
+        }
+    }
+    return true;
+}
+
+int InflateStream::decodeSymbol(const Huffman& table)
+{
+    // Canonical decoding one bit at a time (codes are stored MSB first)
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int length = 1; length < 16; length++) {
+        if (bitCount == 0) {
+            bitBuffer = (uint32_t)nextByte();
+            bitCount = 8;
+        }
+        code |= (int)(bitBuffer & 1);
+        bitBuffer >>= 1;
+        bitCount--;
+
+        int count = table.counts[length];
+        if (code - first < count) {
+            return table.symbols[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+int InflateStream::nextByte()
+{
+    if (inputPos == inputEnd) {
+        if (truncated || !source) {
+            truncated = true;
+            return 0;
+        }
+
+        // Take what has arrived, or block in readBytes() for at least one
+        // byte until the source's timeout expires
+        int available = source->available();
+        size_t toRead = 1;
+        if (available > 0) {
+            toRead = (size_t)available < INPUT_BUFFER_SIZE ? (size_t)available : INPUT_BUFFER_SIZE;
+        }
+#ifdef NATIVE_TEST
+        size_t received = source->readBytes(input, toRead);
+#else
+        size_t received = source->readBytes((char*)input, toRead);
+#endif
+        if (received == 0) {
+            truncated = true;
+            return 0;
+        }
+        inputPos = 0;
+        inputEnd = received;
+        compressedBytes += received;
+    }
+    return input[inputPos++];
+}
+
+uint32_t InflateStream::getBits(int count)
+{
+    while (bitCount < count) {
+        bitBuffer |= (uint32_t)nextByte() << bitCount;
+        bitCount += 8;
+    }
+    uint32_t value = bitBuffer & ((1u << count) - 1);
+    bitBuffer >>= count;
+    bitCount -= count;
+    return value;
+}
+
+void InflateStream::alignToByte()
+{
+    int drop = bitCount % 8;
+    bitBuffer >>= drop;
+    bitCount -= drop;
+}
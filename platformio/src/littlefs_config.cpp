@@ -159,6 +159,7 @@ bool LittleFSConfig::loadConfiguration() {
                 calConfig.enabled          = cal["enabled"] | true;
                 calConfig.days_to_fetch    = cal["days_to_fetch"] | DEFAULT_DAYS_TO_FETCH;
                 calConfig.holiday_calendar = cal["holiday_calendar"] | false;
+                calConfig.incremental      = cal["incremental"] | false;
 
                 Serial.println("  Calendar " + String(calendarCount + 1) + ":");
                 Serial.println("    Name: " + calConfig.name);
@@ -170,6 +171,9 @@ bool LittleFSConfig::loadConfiguration() {
                 Serial.println("    Days to fetch: " + String(calConfig.days_to_fetch));
                 Serial.println("    Holiday calendar: " +
                                String(calConfig.holiday_calendar ? "yes" : "no"));
+                if (calConfig.incremental) {
+                    Serial.println("    Incremental download: yes");
+                }
 
                 if (!calConfig.url.isEmpty()) {
                     config.calendars.push_back(calConfig);
@@ -327,6 +331,9 @@ bool LittleFSConfig::saveConfiguration() {
         calObj["color"]         = cal.color;
         calObj["enabled"]       = cal.enabled;
         calObj["days_to_fetch"] = cal.days_to_fetch;
+        if (cal.incremental) {
+            calObj["incremental"] = true;
+        }
     }
 
     // Add display settings
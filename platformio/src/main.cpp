@@ -4,10 +4,15 @@
 #include "calendar_display_adapter.h"
 #include "calendar_wrapper.h"
 #include "config.h"
+#include "connection_pool.h"
 #include "debug_config.h"
 #include "display_manager.h"
 #include "error_manager.h"
+#include "fetch_scheduler.h"
+#include "fetch_telemetry.h"
 #include "littlefs_config.h"
+#include "resumable_tls_client.h"
+#include "tls_session_cache.h"
 #include "version.h"
 #include "weather_client.h"
 #include "wifi_manager.h"
@@ -302,8 +307,11 @@ void performUpdate()
     // Successful WiFi connection
     lastError = ErrorCode::SUCCESS;
 
+    // TLS sessions of the previous wake, for abbreviated handshakes (restored once the clock is set)
+    TlsSessionCache tlsSessions;
+
     // Initialize WiFiClientSecure
-    WiFiClientSecure* client = new WiFiClientSecure();
+    WiFiClientSecure* client = new ResumableTlsClient(&tlsSessions);
     if (!client) {
         DEBUG_ERROR_PRINTLN("Failed to create WiFiClientSecure");
         return;
@@ -318,24 +326,30 @@ void performUpdate()
     calendarManager = new CalendarManager();
     calendarManager->setDebug(true); // Enable debug output
 
-    // Fetch weather data
-    DEBUG_INFO_PRINTLN("\n--- Weather Update ---");
-    WeatherData weatherData;
-    bool weatherSuccess = false;
-    if (weatherClient) {
-        weatherSuccess = weatherClient->fetchWeather(weatherData);
-        if (weatherSuccess) {
-            DEBUG_INFO_PRINTLN("Weather fetched successfully");
-        } else {
-            DEBUG_WARN_PRINTLN("Weather fetch failed (non-critical)");
-        }
-    }
-
-    // Sync time from NTP
+    // Sync time from NTP (calendar date ranges depend on it)
     DEBUG_INFO_PRINTLN("\n--- Time Sync ---");
     if (!wifiManager.syncTimeFromNTP(config.timezone, NTP_SERVER_1, NTP_SERVER_2)) {
         DEBUG_WARN_PRINTLN("Warning: NTP sync failed");
     }
+    tlsSessions.load((uint32_t)time(nullptr));
+
+    // Per-calendar timings of the last wakes, added to by parseSpooled()
+    FetchTelemetry fetchTelemetry;
+    fetchTelemetry.load();
+    fetchTelemetry.beginWake();
+    calendarManager->setTelemetry(&fetchTelemetry);
+
+    // Weather and calendars are fetched concurrently; the weather job is
+    // queued here and runs together with the calendars in loadAll()
+    FetchScheduler fetchScheduler(FETCH_MAX_CONCURRENT);
+    WeatherData weatherData;
+    bool weatherSuccess = false;
+    if (weatherClient) {
+        fetchScheduler.addJob("weather", [&weatherData, &weatherSuccess]() {
+            weatherSuccess = weatherClient->fetchWeather(weatherData);
+            return weatherSuccess;
+        });
+    }
 
     // Get current time
     time_t now;
@@ -367,9 +381,46 @@ void performUpdate()
     // Load calendar configuration
     calendarManager->loadFromConfig(config);
 
-    // Load all calendars
-    bool allCalendarsSuccess = calendarManager->loadAll(false); // false = use cache if available
-    DEBUG_INFO_PRINTLN("Calendar loadAll returned: " + String(allCalendarsSuccess ? "all success" : "some failures"));
+    // Load all calendars, in parallel with the weather (join barrier before rendering);
+    // calendars on the same host share keep-alive connections
+    ConnectionPool connectionPool;
+    connectionPool.setSessionCache(&tlsSessions);
+    unsigned long downloadStart = millis();
+    calendarManager->downloadAll(false, &fetchScheduler, &connectionPool); // false = use cache if available
+    DEBUG_INFO_PRINTLN("Handshakes this wake: " + String(connectionPool.getHandshakeCount()) + " (" +
+                       String(connectionPool.getHandshakeMs()) + "ms), " +
+                       String(connectionPool.getReuseCount()) + " reused");
+    connectionPool.closeAll(); // Release the TLS sessions' heap before rendering
+    DEBUG_INFO_PRINTLN("TLS handshakes: " + String(tlsSessions.getFullHandshakeCount()) + " full (" +
+                       String(tlsSessions.getFullHandshakeMs()) + "ms), " +
+                       String(tlsSessions.getResumedHandshakeCount()) + " resumed (" +
+                       String(tlsSessions.getResumedHandshakeMs()) + "ms)");
+    tlsSessions.save();
+
+    // Large calendars were only spooled to flash: turn the radio off before
+    // parsing them (the status bar still shows the signal of this wake)
+    bool wifiConnected = wifiManager.isConnected();
+    int wifiRssi       = wifiManager.getRSSI();
+    if (calendarManager->hasSpooledBodies()) {
+        wifiManager.disconnect();
+        DEBUG_INFO_PRINTLN("Radio on for " + String(millis() - downloadStart) + "ms of calendar downloads, parsing spooled calendars offline");
+    }
+    bool allCalendarsSuccess = calendarManager->parseSpooled();
+    DEBUG_INFO_PRINTLN("Calendar load returned: " + String(allCalendarsSuccess ? "all success" : "some failures"));
+    std::vector<FetchTelemetryRecord> telemetryRecords = fetchTelemetry.getRecords();
+    for (const FetchTelemetryRecord& entry : telemetryRecords) {
+        if (entry.wake == fetchTelemetry.getWake()) {
+            DEBUG_INFO_PRINTLN("Telemetry " + FetchTelemetry::format(entry));
+        }
+    }
+    fetchTelemetry.save();
+
+    DEBUG_INFO_PRINTLN("\n--- Weather Update ---");
+    if (weatherSuccess) {
+        DEBUG_INFO_PRINTLN("Weather fetched successfully");
+    } else {
+        DEBUG_WARN_PRINTLN("Weather fetch failed (non-critical)");
+    }
 
     // Get current time
     now = time(nullptr);
@@ -415,8 +466,8 @@ void performUpdate()
         currentDate,
         currentTime,
         weatherSuccess ? &weatherData : nullptr,
-        wifiManager.isConnected(),
-        wifiManager.getRSSI(),
+        wifiConnected,
+        wifiRssi,
         batteryMonitor.getVoltage(),
         batteryMonitor.getPercentage(),
         isStale);
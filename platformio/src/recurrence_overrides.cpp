@@ -0,0 +1,87 @@
+/**
+ * Implementation of the EXDATE / RECURRENCE-ID override index
+ */
+
+#include "recurrence_overrides.h"
+
+#include <algorithm>
+
+const size_t RecurrenceOverrideIndex::MAX_ENTRIES;
+
+RecurrenceOverrideIndex::RecurrenceOverrideIndex() : dropped(0) {}
+
+void RecurrenceOverrideIndex::clear()
+{
+    entries.clear();
+    dropped = 0;
+}
+
+bool RecurrenceOverrideIndex::add(const String& uid, time_t instance, Kind kind)
+{
+    if (uid.isEmpty()) {
+        return false;
+    }
+
+    Entry entry;
+    entry.uidHash = hashUid(uid);
+    entry.kind = kind;
+    entry.instance = instance;
+
+    if (entries.empty()) {
+        entries.reserve(32);
+    }
+
+    std::vector<Entry>::iterator it = std::lower_bound(entries.begin(), entries.end(), entry);
+    if (it != entries.end() && it->uidHash == entry.uidHash && it->instance == entry.instance) {
+        it->kind |= kind;
+        return true;
+    }
+
+    if (entries.size() >= MAX_ENTRIES) {
+        dropped++;
+        return false;
+    }
+    entries.insert(it, entry);
+    return true;
+}
+
+bool RecurrenceOverrideIndex::isSuppressed(uint32_t uidHash, time_t instance) const
+{
+    if (entries.empty()) {
+        return false;
+    }
+
+    Entry key;
+    key.uidHash = uidHash;
+    key.kind = 0;
+    key.instance = instance;
+
+    std::vector<Entry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), key);
+    return it != entries.end() && it->uidHash == uidHash && it->instance == key.instance;
+}
+
+bool RecurrenceOverrideIndex::hasEntries(uint32_t uidHash) const
+{
+    if (entries.empty()) {
+        return false;
+    }
+
+    Entry key;
+    key.uidHash = uidHash;
+    key.kind = 0;
+    key.instance = INT64_MIN;
+
+    std::vector<Entry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), key);
+    return it != entries.end() && it->uidHash == uidHash;
+}
+
+uint32_t RecurrenceOverrideIndex::hashUid(const String& uid)
+{
+    uint32_t hash = 2166136261u;
+    const char* p = uid.c_str();
+    for (unsigned int i = 0; i < uid.length(); i++) {
+        hash ^= (uint8_t)p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
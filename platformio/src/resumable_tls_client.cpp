@@ -0,0 +1,251 @@
+/**
+ * Implementation of the session-resuming TLS client
+ *
+ * The socket and mbedTLS setup mirror start_ssl_client() in arduino-esp32's
+ * ssl_client.cpp for the insecure (no certificate validation) case.
+ */
+
+#include "resumable_tls_client.h"
+
+#include <WiFi.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <lwip/netdb.h>
+#include <lwip/sockets.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#include <time.h>
+#include <vector>
+
+#include "debug_config.h"
+
+namespace {
+
+const char* DRBG_PERSONALIZATION = "esp32-calendar-tls";
+const int32_t DEFAULT_CONNECT_TIMEOUT_MS = 30000; // Same default as ssl_client.cpp
+
+} // namespace
+
+ResumableTlsClient::ResumableTlsClient(TlsSessionCache* sessions)
+    : sessions(sessions)
+    , lastHandshakeMs(0)
+    , lastDnsMs(0)
+    , lastConnectMs(0)
+    , lastResumed(false)
+{
+    setInsecure();
+}
+
+int ResumableTlsClient::connect(IPAddress ip, uint16_t port)
+{
+    return connect(ip.toString().c_str(), port, _timeout);
+}
+
+int ResumableTlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout)
+{
+    return connect(ip.toString().c_str(), port, timeout);
+}
+
+int ResumableTlsClient::connect(const char* host, uint16_t port)
+{
+    return connect(host, port, _timeout);
+}
+
+int ResumableTlsClient::connect(const char* host, uint16_t port, int32_t timeout)
+{
+    stop();
+
+    IPAddress ip;
+    unsigned long lookupStart = millis();
+    if (!WiFi.hostByName(host, ip)) {
+        DEBUG_WARN_PRINTLN("DNS lookup failed for " + String(host));
+        return 0;
+    }
+    if (timeout <= 0) {
+        timeout = DEFAULT_CONNECT_TIMEOUT_MS;
+    }
+
+    unsigned long start = millis();
+    unsigned long lookupDuration = start - lookupStart;
+    if (!openSocket(ip, port, timeout)) {
+        DEBUG_WARN_PRINTLN("TCP connect to " + String(host) + ":" + String(port) + " failed");
+        stop();
+        return 0;
+    }
+    unsigned long connectDuration = millis() - start;
+
+    mbedtls_ssl_init(&sslclient->ssl_ctx);
+    mbedtls_ssl_config_init(&sslclient->ssl_conf);
+    mbedtls_ctr_drbg_init(&sslclient->drbg_ctx);
+    mbedtls_entropy_init(&sslclient->entropy_ctx);
+
+    int ret = mbedtls_ctr_drbg_seed(&sslclient->drbg_ctx,
+        mbedtls_entropy_func,
+        &sslclient->entropy_ctx,
+        (const unsigned char*)DRBG_PERSONALIZATION,
+        strlen(DRBG_PERSONALIZATION));
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(
+            &sslclient->ssl_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0) {
+        // Same certificate policy as setInsecure(): resumption does not change it
+        mbedtls_ssl_conf_authmode(&sslclient->ssl_conf, MBEDTLS_SSL_VERIFY_NONE);
+        mbedtls_ssl_conf_rng(&sslclient->ssl_conf, mbedtls_ctr_drbg_random, &sslclient->drbg_ctx);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_conf_session_tickets(&sslclient->ssl_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+        ret = mbedtls_ssl_setup(&sslclient->ssl_ctx, &sslclient->ssl_conf);
+    }
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_hostname(&sslclient->ssl_ctx, host);
+    }
+    if (ret != 0) {
+        DEBUG_WARN_PRINTLN("TLS setup failed: -0x" + String(-ret, HEX));
+        _lastError = ret;
+        stop();
+        return 0;
+    }
+    mbedtls_ssl_set_bio(&sslclient->ssl_ctx, &sslclient->socket, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+    String key = TlsSessionCache::makeKey(host, port);
+    time_t offeredStart = 0;
+    bool offered = sessions && offerSession(key, offeredStart);
+
+    while ((ret = mbedtls_ssl_handshake(&sslclient->ssl_ctx)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            break;
+        }
+        if (millis() - start > sslclient->handshake_timeout) {
+            ret = MBEDTLS_ERR_SSL_TIMEOUT;
+            break;
+        }
+        vTaskDelay(2);
+    }
+    unsigned long duration = millis() - start;
+
+    if (ret != 0) {
+        DEBUG_WARN_PRINTLN("TLS handshake with " + key + " failed: -0x" + String(-ret, HEX));
+        if (offered) {
+            // Do not offer the same session again if it is what the server choked on
+            sessions->remove(key);
+        }
+        _lastError = ret;
+        stop();
+        return 0;
+    }
+
+    // A resumed session keeps the start time of the handshake that created it
+    bool resumed = offered && sslclient->ssl_ctx.session != nullptr &&
+                   (time_t)sslclient->ssl_ctx.session->start == offeredStart;
+    lastHandshakeMs = duration;
+    lastDnsMs       = lookupDuration;
+    lastConnectMs   = connectDuration;
+    lastResumed     = resumed;
+    if (sessions) {
+        sessions->recordHandshake(resumed, duration);
+        rememberSession(key, resumed);
+    }
+    DEBUG_INFO_PRINTLN(String(resumed ? "Resumed" : "Full") + " TLS handshake with " + key + " in " +
+                       String(duration) + "ms");
+
+    _connected = true;
+    _lastError = 0;
+    return 1;
+}
+
+bool ResumableTlsClient::openSocket(const IPAddress& ip, uint16_t port, int32_t timeout)
+{
+    int fd = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct sockaddr_in serverAddress;
+    memset(&serverAddress, 0, sizeof(serverAddress));
+    serverAddress.sin_family      = AF_INET;
+    serverAddress.sin_addr.s_addr = (uint32_t)ip;
+    serverAddress.sin_port        = htons(port);
+
+    // Connect without blocking so the timeout applies
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int result = lwip_connect(fd, (struct sockaddr*)&serverAddress, sizeof(serverAddress));
+    if (result < 0 && errno != EINPROGRESS) {
+        lwip_close(fd);
+        return false;
+    }
+
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(fd, &writable);
+    struct timeval wait;
+    wait.tv_sec  = timeout / 1000;
+    wait.tv_usec = (timeout % 1000) * 1000;
+    result = select(fd + 1, nullptr, &writable, nullptr, &wait);
+
+    int socketError = 0;
+    socklen_t errorLength = sizeof(socketError);
+    if (result <= 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &socketError, &errorLength) < 0 || socketError != 0) {
+        lwip_close(fd);
+        return false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+
+    lwip_setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof(wait));
+    lwip_setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &wait, sizeof(wait));
+    int enable = 1;
+    lwip_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    lwip_setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+
+    sslclient->socket = fd;
+    return true;
+}
+
+bool ResumableTlsClient::offerSession(const String& key, time_t& sessionStart)
+{
+    std::vector<uint8_t> buffer(TLS_SESSION_MAX_BYTES);
+    size_t length = sessions->lookup(key, buffer.data(), buffer.size(), (uint32_t)time(nullptr));
+    if (length == 0) {
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    bool offered = mbedtls_ssl_session_load(&session, buffer.data(), length) == 0 &&
+                   mbedtls_ssl_set_session(&sslclient->ssl_ctx, &session) == 0;
+    if (offered) {
+        sessionStart = (time_t)session.start;
+    } else {
+        // Saved by a differently configured mbedTLS (e.g. after a firmware update)
+        DEBUG_WARN_PRINTLN("Discarding unusable TLS session for " + key);
+        sessions->remove(key);
+    }
+    mbedtls_ssl_session_free(&session);
+    return offered;
+}
+
+void ResumableTlsClient::rememberSession(const String& key, bool resumed)
+{
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(&sslclient->ssl_ctx, &session) != 0) {
+        mbedtls_ssl_session_free(&session);
+        return;
+    }
+
+    bool resumable = session.id_len > 0;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    resumable = resumable || session.ticket_len > 0;
+#endif
+    if (resumable) {
+        std::vector<uint8_t> buffer(TLS_SESSION_MAX_BYTES);
+        size_t length = 0;
+        int ret = mbedtls_ssl_session_save(&session, buffer.data(), buffer.size(), &length);
+        if (ret == 0) {
+            sessions->store(key, buffer.data(), length, (uint32_t)time(nullptr), resumed);
+        } else {
+            DEBUG_WARN_PRINTLN("TLS session for " + key + " not kept (" + String(length) + " bytes)");
+        }
+    }
+    mbedtls_ssl_session_free(&session);
+}
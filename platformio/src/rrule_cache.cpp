@@ -0,0 +1,74 @@
+/**
+ * Implementation of the interned RRULE cache
+ */
+
+#include "rrule_cache.h"
+
+#include <algorithm>
+
+const size_t RRuleCache::MAX_ENTRIES;
+
+RRuleCache::RRuleCache() : hits(0), misses(0) {}
+
+void RRuleCache::clear()
+{
+    entries.clear();
+    hits = 0;
+    misses = 0;
+}
+
+namespace {
+
+struct HashLess {
+    template <typename Entry> bool operator()(const Entry& entry, uint32_t hash) const { return entry.hash < hash; }
+};
+
+} // namespace
+
+const CompiledRRule* RRuleCache::find(const String& rrule, bool& valid)
+{
+    uint32_t hash = hashRule(rrule);
+    std::vector<Entry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), hash, HashLess());
+    for (; it != entries.end() && it->hash == hash; ++it) {
+        if (it->text == rrule) {
+            hits++;
+            valid = it->valid;
+            return &it->compiled;
+        }
+    }
+
+    misses++;
+    valid = false;
+    return nullptr;
+}
+
+bool RRuleCache::insert(const String& rrule, const CompiledRRule& compiled, bool valid)
+{
+    if (entries.size() >= MAX_ENTRIES) {
+        return false;
+    }
+    if (entries.empty()) {
+        entries.reserve(16);
+    }
+
+    Entry entry;
+    entry.hash = hashRule(rrule);
+    entry.valid = valid;
+    entry.text = rrule;
+    entry.compiled = compiled;
+
+    std::vector<Entry>::iterator it = std::lower_bound(entries.begin(), entries.end(), entry.hash, HashLess());
+    entries.insert(it, entry);
+    return true;
+}
+
+uint32_t RRuleCache::hashRule(const String& rrule)
+{
+    uint32_t hash = 2166136261u;
+    const char* p = rrule.c_str();
+    for (unsigned int i = 0; i < rrule.length(); i++) {
+        hash ^= (uint8_t)p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
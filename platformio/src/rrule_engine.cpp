@@ -0,0 +1,658 @@
+/**
+ * Implementation of the RRULE compiler and expansion kernel
+ */
+
+#include "rrule_engine.h"
+#include "timezone_engine.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const char* const WEEKDAY_CODES[7] = {"SU", "MO", "TU", "WE", "TH", "FR", "SA"};
+
+// Upper bound on instants generated for one period (e.g. BYHOUR x BYMINUTE
+// over a whole year); further instants of that period are dropped
+static const size_t MAX_PERIOD_CANDIDATES = 1024;
+
+// Day of the week for days since 1970-01-01 (a Thursday), 0=Sunday
+static int weekdayOf(int64_t days)
+{
+    int weekday = (int)((days + 4) % 7);
+    return weekday < 0 ? weekday + 7 : weekday;
+}
+
+static int64_t floorDiv(int64_t value, int64_t divisor)
+{
+    int64_t quotient = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+static int weekdayFromCode(const char* code, size_t length)
+{
+    if (length != 2) {
+        return -1;
+    }
+    for (int d = 0; d < 7; d++) {
+        if (code[0] == WEEKDAY_CODES[d][0] && code[1] == WEEKDAY_CODES[d][1]) {
+            return d;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Walk a comma-separated list, returning each item's signed leading number
+ * and the text that follows it ("-1SU" -> -1, "SU"; "15" -> 15, "")
+ */
+class ListReader {
+  public:
+    explicit ListReader(const String& list) : p(list.c_str()), end(list.c_str() + list.length()) {}
+
+    bool next(int& number, bool& hasNumber, const char*& suffix, size_t& suffixLength)
+    {
+        while (p < end && (*p == ',' || *p == ' ')) {
+            p++;
+        }
+        if (p >= end) {
+            return false;
+        }
+        const char* itemEnd = (const char*)memchr(p, ',', end - p);
+        if (!itemEnd) {
+            itemEnd = end;
+        }
+
+        int sign = 1;
+        if (*p == '+' || *p == '-') {
+            sign = (*p == '-') ? -1 : 1;
+            p++;
+        }
+        number = 0;
+        hasNumber = false;
+        while (p < itemEnd && *p >= '0' && *p <= '9') {
+            number = number * 10 + (*p - '0');
+            hasNumber = true;
+            p++;
+        }
+        number *= sign;
+        suffix = p;
+        suffixLength = itemEnd - p;
+        while (suffixLength > 0 && suffix[suffixLength - 1] == ' ') {
+            suffixLength--;
+        }
+        p = itemEnd;
+        return true;
+    }
+
+    // Next plain number within [minValue, maxValue]; skips malformed items
+    bool nextNumber(int& number, int minValue, int maxValue)
+    {
+        bool hasNumber;
+        const char* suffix;
+        size_t suffixLength;
+        while (next(number, hasNumber, suffix, suffixLength)) {
+            if (hasNumber && suffixLength == 0 && number >= minValue && number <= maxValue) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    const char* p;
+    const char* end;
+};
+
+// ============================================================================
+// CompiledRRule
+// ============================================================================
+
+CompiledRRule::CompiledRRule()
+{
+    memset(this, 0, sizeof(*this));
+    freq = RecurrenceFrequency::NONE;
+    interval = 1;
+    count = -1;
+    wkst = 1;
+}
+
+bool CompiledRRule::compile(const RRuleComponents& rule)
+{
+    *this = CompiledRRule();
+
+    static const char* const FREQUENCIES[] = {"YEARLY", "MONTHLY", "WEEKLY", "DAILY", "HOURLY", "MINUTELY", "SECONDLY"};
+    for (int f = 0; f < 7; f++) {
+        if (rule.freq == FREQUENCIES[f]) {
+            freq = (RecurrenceFrequency)f;
+        }
+    }
+    if (freq == RecurrenceFrequency::NONE) {
+        return false;
+    }
+
+    interval = rule.interval > 0 ? rule.interval : 1;
+    count = rule.count > 0 ? rule.count : -1;
+    until = rule.until;
+
+    int weekStart = weekdayFromCode(rule.wkst.c_str(), rule.wkst.length());
+    wkst = weekStart >= 0 ? weekStart : 1;
+
+    bool yearly = freq == RecurrenceFrequency::YEARLY;
+    bool monthly = freq == RecurrenceFrequency::MONTHLY;
+    bool weekly = freq == RecurrenceFrequency::WEEKLY;
+    bool daily = freq == RecurrenceFrequency::DAILY;
+    int value;
+
+    ListReader months(rule.byMonth);
+    while (months.nextNumber(value, 1, 12)) {
+        byMonth |= 1u << value;
+        parts |= BY_MONTH;
+    }
+
+    // BYMONTHDAY is not valid for WEEKLY
+    if (!weekly) {
+        ListReader monthDays(rule.byMonthDay);
+        while (monthDays.nextNumber(value, -31, 31)) {
+            if (value > 0) {
+                byMonthDay |= 1u << value;
+            } else if (value < 0) {
+                byMonthDayNeg |= 1u << -value;
+            }
+            parts |= value != 0 ? BY_MONTHDAY : 0;
+        }
+    }
+
+    // BYYEARDAY is only valid for YEARLY and sub-daily rules
+    if (!monthly && !weekly && !daily) {
+        ListReader yearDays(rule.byYearDay);
+        while (yearDays.nextNumber(value, -366, 366)) {
+            if (value > 0) {
+                byYearDay[value >> 5] |= 1u << (value & 31);
+            } else if (value < 0) {
+                byYearDayNeg[-value >> 5] |= 1u << (-value & 31);
+            }
+            parts |= value != 0 ? BY_YEARDAY : 0;
+        }
+    }
+
+    if (yearly) {
+        ListReader weeks(rule.byWeekNo);
+        while (weeks.nextNumber(value, -53, 53)) {
+            if (value > 0) {
+                byWeekNo |= 1ull << value;
+            } else if (value < 0) {
+                byWeekNoNeg |= 1ull << -value;
+            }
+            parts |= value != 0 ? BY_WEEKNO : 0;
+        }
+    }
+
+    // Ordinals ("2MO", "-1FR") only mean something within a month or year
+    bool ordinals = monthly || (yearly && !has(BY_WEEKNO));
+    ListReader days(rule.byDay);
+    bool hasNumber;
+    const char* code;
+    size_t codeLength;
+    while (days.next(value, hasNumber, code, codeLength)) {
+        int weekday = weekdayFromCode(code, codeLength);
+        if (weekday < 0 || value < -53 || value > 53) {
+            continue;
+        }
+        parts |= BY_DAY;
+        if (!hasNumber || value == 0 || !ordinals) {
+            byWeekday |= 1u << weekday;
+        } else if (value > 0) {
+            byWeekdayNth[weekday] |= 1ull << value;
+            parts |= BY_DAY_NTH;
+        } else {
+            byWeekdayNthNeg[weekday] |= 1ull << -value;
+            parts |= BY_DAY_NTH;
+        }
+    }
+
+    ListReader hours(rule.byHour);
+    while (hours.nextNumber(value, 0, 23)) {
+        byHour |= 1u << value;
+        parts |= BY_HOUR;
+    }
+    ListReader minutes(rule.byMinute);
+    while (minutes.nextNumber(value, 0, 59)) {
+        byMinute |= 1ull << value;
+        parts |= BY_MINUTE;
+    }
+    ListReader seconds(rule.bySecond);
+    while (seconds.nextNumber(value, 0, 60)) {
+        bySecond |= 1ull << value;
+        parts |= BY_SECOND;
+    }
+
+    ListReader positions(rule.bySetPos);
+    while (bySetPosCount < MAX_SETPOS && positions.nextNumber(value, -366, 366)) {
+        if (value != 0) {
+            bySetPos[bySetPosCount++] = (int16_t)value;
+            parts |= BY_SETPOS;
+        }
+    }
+
+    return true;
+}
+
+// ============================================================================
+// RRuleExpander
+// ============================================================================
+
+RRuleExpander::RRuleExpander()
+    : zone(nullptr)
+    , dtstart(0)
+    , limit(0)
+    , dtstartPending(false)
+    , done(true)
+    , startDays(0)
+    , startYear(1970)
+    , startMonth(1)
+    , startMonthDay(1)
+    , startWeekday(4)
+    , startHour(0)
+    , startMinute(0)
+    , startSecond(0)
+    , period(0)
+    , firstPeriod(0)
+    , periods(0)
+    , step(0)
+    , candidatePos(0)
+{
+}
+
+void RRuleExpander::begin(const CompiledRRule& compiled,
+    time_t start,
+    const CompiledTimeZone* eventZone,
+    time_t from,
+    time_t until)
+{
+    rule = compiled;
+    zone = eventZone;
+    dtstart = start;
+    limit = until;
+    dtstartPending = true;
+    done = false;
+    period = 0;
+    periods = 0;
+    candidates.clear();
+    candidatePos = 0;
+
+    struct tm local;
+    toLocal(dtstart, local);
+    startYear = local.tm_year + 1900;
+    startMonth = local.tm_mon + 1;
+    startMonthDay = local.tm_mday;
+    startHour = local.tm_hour;
+    startMinute = local.tm_min;
+    startSecond = local.tm_sec;
+    startDays = TimeZoneEngine::daysFromCivil(startYear, startMonth, startMonthDay);
+    startWeekday = weekdayOf(startDays);
+
+    switch (rule.freq) {
+    case RecurrenceFrequency::HOURLY:
+        step = 3600;
+        break;
+    case RecurrenceFrequency::MINUTELY:
+        step = 60;
+        break;
+    case RecurrenceFrequency::SECONDLY:
+        step = 1;
+        break;
+    default:
+        step = 0;
+        break;
+    }
+    step *= rule.interval;
+
+    // With COUNT every instance has to be numbered, which only works without
+    // walking the skipped periods when each of them holds exactly one
+    // instance (no BYxxx part and a day that exists in every month/year)
+    bool onePerPeriod = rule.isSimple() &&
+                        (startMonthDay <= 28 || (rule.freq != RecurrenceFrequency::MONTHLY &&
+                                                    rule.freq != RecurrenceFrequency::YEARLY));
+    if (rule.count > 0 && !onePerPeriod) {
+        from = dtstart;
+    }
+
+    // Jump to the period containing 'from' instead of walking from DTSTART
+    if (from > dtstart) {
+        int64_t skip = 0;
+        if (step > 0) {
+            skip = (from - dtstart + step - 1) / step; // First instant >= from
+        } else {
+            toLocal(from, local);
+            int64_t fromYear = local.tm_year + 1900;
+            int64_t fromDays = TimeZoneEngine::daysFromCivil(fromYear, local.tm_mon + 1, local.tm_mday);
+            switch (rule.freq) {
+            case RecurrenceFrequency::YEARLY:
+                skip = (fromYear - startYear) / rule.interval;
+                break;
+            case RecurrenceFrequency::MONTHLY:
+                skip = ((fromYear - startYear) * 12 + (local.tm_mon + 1 - startMonth)) / rule.interval;
+                break;
+            case RecurrenceFrequency::WEEKLY: {
+                int64_t fromWeek = fromDays - (weekdayOf(fromDays) - rule.wkst + 7) % 7;
+                int64_t startWeek = startDays - (startWeekday - rule.wkst + 7) % 7;
+                skip = (fromWeek - startWeek) / 7 / rule.interval;
+                break;
+            }
+            default:
+                skip = (fromDays - startDays) / rule.interval;
+                break;
+            }
+        }
+        if (skip > 0) {
+            period = skip;
+            dtstartPending = false;
+        }
+    }
+    firstPeriod = period;
+}
+
+bool RRuleExpander::next(time_t& instant)
+{
+    while (true) {
+        if (candidatePos < candidates.size()) {
+            time_t candidate = candidates[candidatePos++];
+            // Instances before DTSTART are not part of the set
+            if (candidate < dtstart) {
+                continue;
+            }
+            if (dtstartPending) {
+                dtstartPending = false;
+                if (candidate > dtstart) {
+                    candidatePos--;
+                    instant = dtstart;
+                    return true;
+                }
+            }
+            instant = candidate;
+            return true;
+        }
+
+        if (done) {
+            if (dtstartPending && dtstart <= limit) {
+                dtstartPending = false;
+                instant = dtstart;
+                return true;
+            }
+            return false;
+        }
+
+        if (!fillPeriod()) {
+            done = true;
+        }
+    }
+}
+
+bool RRuleExpander::fillPeriod()
+{
+    candidates.clear();
+    candidatePos = 0;
+    periods++;
+
+    int64_t firstDay;
+    int dayCount;
+    int64_t offset = period * rule.interval;
+
+    switch (rule.freq) {
+    case RecurrenceFrequency::YEARLY: {
+        int64_t year = startYear + offset;
+        firstDay = TimeZoneEngine::daysFromCivil(year, 1, 1);
+        dayCount = TimeZoneEngine::isLeapYear(year) ? 366 : 365;
+        break;
+    }
+    case RecurrenceFrequency::MONTHLY: {
+        int64_t monthIndex = startYear * 12 + (startMonth - 1) + offset;
+        int64_t year = floorDiv(monthIndex, 12);
+        int month = (int)(monthIndex - year * 12) + 1;
+        firstDay = TimeZoneEngine::daysFromCivil(year, month, 1);
+        dayCount = TimeZoneEngine::daysInMonth(year, month);
+        break;
+    }
+    case RecurrenceFrequency::WEEKLY:
+        firstDay = startDays - (startWeekday - rule.wkst + 7) % 7 + offset * 7;
+        dayCount = 7;
+        break;
+    case RecurrenceFrequency::DAILY:
+        firstDay = startDays + offset;
+        dayCount = 1;
+        break;
+    default:
+        return fillSubDaily();
+    }
+
+    if (toUtc(firstDay, 0, 0, 0) > limit) {
+        return false;
+    }
+    period++;
+    return fillDays(firstDay, dayCount);
+}
+
+bool RRuleExpander::fillDays(int64_t firstDay, int dayCount)
+{
+    for (int64_t days = firstDay; days < firstDay + dayCount; days++) {
+        int64_t year;
+        int month, monthDay;
+        TimeZoneEngine::civilFromDays(days, year, month, monthDay);
+        if (!matchesDay(days, year, month, monthDay)) {
+            continue;
+        }
+
+        // BYHOUR/BYMINUTE/BYSECOND expand the day; otherwise DTSTART's time is used
+        for (int hour = 0; hour < 24; hour++) {
+            if (rule.has(CompiledRRule::BY_HOUR) ? !((rule.byHour >> hour) & 1) : hour != startHour) {
+                continue;
+            }
+            for (int minute = 0; minute < 60; minute++) {
+                if (rule.has(CompiledRRule::BY_MINUTE) ? !((rule.byMinute >> minute) & 1) : minute != startMinute) {
+                    continue;
+                }
+                for (int second = 0; second <= 60; second++) {
+                    if (rule.has(CompiledRRule::BY_SECOND) ? !((rule.bySecond >> second) & 1)
+                                                           : second != startSecond) {
+                        continue;
+                    }
+                    if (candidates.size() >= MAX_PERIOD_CANDIDATES) {
+                        applySetPos();
+                        return true;
+                    }
+                    candidates.push_back(toUtc(days, hour, minute, second));
+                }
+            }
+        }
+    }
+
+    applySetPos();
+    return true;
+}
+
+bool RRuleExpander::fillSubDaily()
+{
+    time_t instant = dtstart + (time_t)period * step;
+    if (instant > limit) {
+        return false;
+    }
+    period++;
+
+    struct tm local;
+    toLocal(instant, local);
+    int64_t days = TimeZoneEngine::daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+    int secondOfDay = local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+
+    // On a mismatch, skip every instant left in the same day/hour/minute
+    time_t skipTo = 0;
+    if (!matchesDay(days, local.tm_year + 1900, local.tm_mon + 1, local.tm_mday)) {
+        skipTo = instant + 86400 - secondOfDay;
+    } else if (rule.has(CompiledRRule::BY_HOUR) && !((rule.byHour >> local.tm_hour) & 1)) {
+        skipTo = instant + 3600 - (local.tm_min * 60 + local.tm_sec);
+    } else if (rule.has(CompiledRRule::BY_MINUTE) && !((rule.byMinute >> local.tm_min) & 1)) {
+        skipTo = instant + 60 - local.tm_sec;
+    } else if (rule.has(CompiledRRule::BY_SECOND) && !((rule.bySecond >> local.tm_sec) & 1)) {
+        return true;
+    }
+
+    if (skipTo > 0) {
+        int64_t nextPeriod = (skipTo - dtstart + step - 1) / step;
+        if (nextPeriod > period) {
+            period = nextPeriod;
+        }
+        return true;
+    }
+
+    candidates.push_back(instant);
+    return true;
+}
+
+bool RRuleExpander::matchesDay(int64_t days, int64_t year, int month, int monthDay) const
+{
+    int weekday = weekdayOf(days);
+
+    if (rule.has(CompiledRRule::BY_MONTH) && !((rule.byMonth >> month) & 1)) {
+        return false;
+    }
+
+    if (rule.has(CompiledRRule::BY_WEEKNO)) {
+        int weeksInYear;
+        int week = weekNumber(days, rule.wkst, weeksInYear);
+        if (!((rule.byWeekNo >> week) & 1) && !((rule.byWeekNoNeg >> (weeksInYear - week + 1)) & 1)) {
+            return false;
+        }
+    }
+
+    int yearLength = TimeZoneEngine::isLeapYear(year) ? 366 : 365;
+    int yearDay = (int)(days - TimeZoneEngine::daysFromCivil(year, 1, 1)) + 1;
+    if (rule.has(CompiledRRule::BY_YEARDAY) && !CompiledRRule::testBit(rule.byYearDay, yearDay) &&
+        !CompiledRRule::testBit(rule.byYearDayNeg, yearLength - yearDay + 1)) {
+        return false;
+    }
+
+    int monthLength = TimeZoneEngine::daysInMonth(year, month);
+    if (rule.has(CompiledRRule::BY_MONTHDAY) && !((rule.byMonthDay >> monthDay) & 1) &&
+        !((rule.byMonthDayNeg >> (monthLength - monthDay + 1)) & 1)) {
+        return false;
+    }
+
+    if (rule.has(CompiledRRule::BY_DAY)) {
+        bool match = (rule.byWeekday >> weekday) & 1;
+        if (!match && rule.has(CompiledRRule::BY_DAY_NTH)) {
+            // "2MO" counts within the month for MONTHLY and YEARLY;BYMONTH,
+            // otherwise within the year
+            int nth, nthFromEnd;
+            if (rule.freq == RecurrenceFrequency::MONTHLY || rule.has(CompiledRRule::BY_MONTH)) {
+                nth = (monthDay - 1) / 7 + 1;
+                nthFromEnd = (monthLength - monthDay) / 7 + 1;
+            } else {
+                nth = (yearDay - 1) / 7 + 1;
+                nthFromEnd = (yearLength - yearDay) / 7 + 1;
+            }
+            match = ((rule.byWeekdayNth[weekday] >> nth) & 1) || ((rule.byWeekdayNthNeg[weekday] >> nthFromEnd) & 1);
+        }
+        if (!match) {
+            return false;
+        }
+    }
+
+    // Without a day-level part the day comes from DTSTART
+    const uint16_t dayParts =
+        CompiledRRule::BY_WEEKNO | CompiledRRule::BY_YEARDAY | CompiledRRule::BY_MONTHDAY | CompiledRRule::BY_DAY;
+    if ((rule.parts & dayParts) == 0) {
+        switch (rule.freq) {
+        case RecurrenceFrequency::YEARLY:
+            return monthDay == startMonthDay && (rule.has(CompiledRRule::BY_MONTH) || month == startMonth);
+        case RecurrenceFrequency::MONTHLY:
+            return monthDay == startMonthDay;
+        case RecurrenceFrequency::WEEKLY:
+            return weekday == startWeekday;
+        default:
+            return true;
+        }
+    }
+    if ((rule.parts & dayParts) == CompiledRRule::BY_WEEKNO) {
+        return weekday == startWeekday;
+    }
+    return true;
+}
+
+void RRuleExpander::applySetPos()
+{
+    if (!rule.has(CompiledRRule::BY_SETPOS) || candidates.empty()) {
+        return;
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    std::vector<time_t> selected;
+    int size = (int)candidates.size();
+    for (int i = 0; i < rule.bySetPosCount; i++) {
+        int position = rule.bySetPos[i];
+        int index = position > 0 ? position - 1 : size + position;
+        if (index >= 0 && index < size) {
+            selected.push_back(candidates[index]);
+        }
+    }
+    std::sort(selected.begin(), selected.end());
+    selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+    candidates.swap(selected);
+}
+
+int RRuleExpander::weekNumber(int64_t days, int wkst, int& weeksInYear)
+{
+    // Week 1 is the first week with at least four days in the year
+    struct WeekOne {
+        static int64_t start(int64_t year, int wkst)
+        {
+            int64_t january1 = TimeZoneEngine::daysFromCivil(year, 1, 1);
+            int offset = (weekdayOf(january1) - wkst + 7) % 7;
+            int64_t first = january1 - offset;
+            return offset >= 4 ? first + 7 : first;
+        }
+    };
+
+    int64_t year;
+    int month, monthDay;
+    TimeZoneEngine::civilFromDays(days, year, month, monthDay);
+
+    int64_t weekOne = WeekOne::start(year, wkst);
+    if (days < weekOne) {
+        year--;
+        weekOne = WeekOne::start(year, wkst);
+    } else {
+        int64_t nextWeekOne = WeekOne::start(year + 1, wkst);
+        if (days >= nextWeekOne) {
+            year++;
+            weekOne = nextWeekOne;
+        }
+    }
+
+    weeksInYear = (int)((WeekOne::start(year + 1, wkst) - weekOne) / 7);
+    return (int)((days - weekOne) / 7) + 1;
+}
+
+time_t RRuleExpander::toUtc(int64_t days, int hour, int minute, int second) const
+{
+    int64_t year;
+    int month, monthDay;
+    TimeZoneEngine::civilFromDays(days, year, month, monthDay);
+
+    struct tm local;
+    memset(&local, 0, sizeof(local));
+    local.tm_year = (int)(year - 1900);
+    local.tm_mon = month - 1;
+    local.tm_mday = monthDay;
+    local.tm_hour = hour;
+    local.tm_min = minute;
+    local.tm_sec = second;
+    local.tm_isdst = -1; // Let the zone determine DST for this date
+    return zone ? zone->toUtc(local) : TimeZoneEngine::makeLocal(local);
+}
+
+void RRuleExpander::toLocal(time_t utc, struct tm& local) const
+{
+    if (zone) {
+        zone->toLocal(utc, local);
+    } else {
+        TimeZoneEngine::localTime(utc, local);
+    }
+}
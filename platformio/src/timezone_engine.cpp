@@ -0,0 +1,512 @@
+/**
+ * Implementation of the compiled POSIX time zone engine
+ */
+
+#include "timezone_engine.h"
+#include "timezone_map.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// ============================================================================
+// Civil calendar arithmetic
+// Based on Howard Hinnant's days_from_civil / civil_from_days algorithms
+// ============================================================================
+
+static int64_t floorDiv(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+int64_t TimeZoneEngine::daysFromCivil(int64_t year, int month, int day)
+{
+    year -= month <= 2;
+    const int64_t era = floorDiv(year, 400);
+    const int64_t yoe = year - era * 400;                                     // [0, 399]
+    const int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1; // [0, 365]
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+void TimeZoneEngine::civilFromDays(int64_t days, int64_t& year, int& month, int& day)
+{
+    days += 719468;
+    const int64_t era = floorDiv(days, 146097);
+    const int64_t doe = days - era * 146097;                              // [0, 146096]
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);          // [0, 365]
+    const int64_t mp = (5 * doy + 2) / 153;                               // [0, 11]
+    day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    year = yoe + era * 400 + (month <= 2);
+}
+
+bool TimeZoneEngine::isLeapYear(int64_t year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int TimeZoneEngine::daysInMonth(int64_t year, int month)
+{
+    static const int DAYS[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (month == 2 && isLeapYear(year)) ? 29 : DAYS[month - 1];
+}
+
+void TimeZoneEngine::breakDown(int64_t seconds, struct tm& result)
+{
+    int64_t days = floorDiv(seconds, 86400);
+    int64_t secondsOfDay = seconds - days * 86400;
+
+    int64_t year;
+    int month, day;
+    civilFromDays(days, year, month, day);
+
+    result.tm_year = (int)(year - 1900);
+    result.tm_mon = month - 1;
+    result.tm_mday = day;
+    result.tm_hour = (int)(secondsOfDay / 3600);
+    result.tm_min = (int)(secondsOfDay % 3600 / 60);
+    result.tm_sec = (int)(secondsOfDay % 60);
+    result.tm_wday = (int)((days % 7 + 11) % 7); // 1970-01-01 was a Thursday
+    result.tm_yday = (int)(days - daysFromCivil(year, 1, 1));
+}
+
+int64_t TimeZoneEngine::combine(const struct tm& fields)
+{
+    int64_t year = (int64_t)fields.tm_year + 1900 + floorDiv(fields.tm_mon, 12);
+    int month = (int)(fields.tm_mon - floorDiv(fields.tm_mon, 12) * 12) + 1;
+    int64_t days = daysFromCivil(year, month, 1) + fields.tm_mday - 1;
+    return days * 86400 + (int64_t)fields.tm_hour * 3600 + (int64_t)fields.tm_min * 60 + fields.tm_sec;
+}
+
+// ============================================================================
+// POSIX TZ string parsing
+// ============================================================================
+
+// Parse "std"/"dst" zone abbreviation: alphabetic or <quoted>
+static bool parseZoneName(const char*& p)
+{
+    if (*p == '<') {
+        const char* close = strchr(p, '>');
+        if (!close || close - p < 4) {
+            return false;
+        }
+        p = close + 1;
+        return true;
+    }
+
+    const char* start = p;
+    while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) {
+        p++;
+    }
+    return p - start >= 3;
+}
+
+// Parse "[+|-]hh[:mm[:ss]]" into seconds
+static bool parseClock(const char*& p, int32_t& seconds)
+{
+    int sign = 1;
+    if (*p == '+' || *p == '-') {
+        sign = (*p == '-') ? -1 : 1;
+        p++;
+    }
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+
+    int32_t parts[3] = {0, 0, 0};
+    for (int i = 0; i < 3; i++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        while (*p >= '0' && *p <= '9') {
+            parts[i] = parts[i] * 10 + (*p - '0');
+            p++;
+        }
+        if (*p != ':' || i == 2) {
+            break;
+        }
+        p++;
+    }
+
+    seconds = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+    return true;
+}
+
+static bool parseNumber(const char*& p, int& value)
+{
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+    value = 0;
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    return true;
+}
+
+CompiledTimeZone::CompiledTimeZone()
+    : valid(false)
+    , dstRules(false)
+    , stdOffset(0)
+    , dstOffset(0)
+{
+    memset(&dstStartRule, 0, sizeof(dstStartRule));
+    memset(&dstEndRule, 0, sizeof(dstEndRule));
+    for (int i = 0; i < TRANSITION_CACHE_SIZE; i++) {
+        transitionCache[i].year = INT32_MIN;
+    }
+}
+
+bool CompiledTimeZone::compile(const char* posix)
+{
+    valid = false;
+    dstRules = false;
+    for (int i = 0; i < TRANSITION_CACHE_SIZE; i++) {
+        transitionCache[i].year = INT32_MIN;
+    }
+
+    if (!posix) {
+        return false;
+    }
+
+    const char* p = posix;
+    if (*p == ':') {
+        return false; // Implementation-defined (zoneinfo file), not a rule
+    }
+
+    int32_t offset;
+    if (!parseZoneName(p) || !parseClock(p, offset)) {
+        return false;
+    }
+    // POSIX offsets are west-positive; store east-positive
+    stdOffset = -offset;
+    dstOffset = stdOffset;
+
+    if (*p == '\0') {
+        valid = true;
+        return true;
+    }
+
+    if (!parseZoneName(p)) {
+        return false;
+    }
+    dstRules = true;
+    dstOffset = stdOffset + 3600;
+    if (*p != ',' && *p != '\0') {
+        if (!parseClock(p, offset)) {
+            return false;
+        }
+        dstOffset = -offset;
+    }
+
+    // Default rule (US, since 2007) when the string names DST without rules
+    Rule* rules[2] = {&dstStartRule, &dstEndRule};
+    if (*p == '\0') {
+        dstStartRule = {'M', 3, 2, 0, 7200};
+        dstEndRule = {'M', 11, 1, 0, 7200};
+        valid = true;
+        return true;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (*p != ',') {
+            return false;
+        }
+        p++;
+
+        Rule& rule = *rules[i];
+        rule.time = 7200;
+        int a, b, c;
+        if (*p == 'M') {
+            p++;
+            if (!parseNumber(p, a) || *p++ != '.' || !parseNumber(p, b) || *p++ != '.' || !parseNumber(p, c)) {
+                return false;
+            }
+            if (a < 1 || a > 12 || b < 1 || b > 5 || c > 6) {
+                return false;
+            }
+            rule.type = 'M';
+            rule.month = a;
+            rule.week = b;
+            rule.day = c;
+        } else if (*p == 'J') {
+            p++;
+            if (!parseNumber(p, a) || a < 1 || a > 365) {
+                return false;
+            }
+            rule.type = 'J';
+            rule.day = a;
+        } else {
+            if (!parseNumber(p, a) || a > 365) {
+                return false;
+            }
+            rule.type = 'N';
+            rule.day = a;
+        }
+
+        if (*p == '/') {
+            p++;
+            if (!parseClock(p, rule.time)) {
+                return false;
+            }
+        }
+    }
+
+    if (*p != '\0') {
+        return false;
+    }
+
+    valid = true;
+    return true;
+}
+
+int64_t CompiledTimeZone::ruleToLocalSeconds(const Rule& rule, int32_t year) const
+{
+    int64_t days;
+    if (rule.type == 'M') {
+        int64_t first = TimeZoneEngine::daysFromCivil(year, rule.month, 1);
+        int firstWeekday = (int)((first % 7 + 11) % 7);
+        int mday = 1 + (rule.day - firstWeekday + 7) % 7 + (rule.week - 1) * 7;
+        int monthLength = TimeZoneEngine::daysInMonth(year, rule.month);
+        while (mday > monthLength) {
+            mday -= 7;
+        }
+        days = first + mday - 1;
+    } else if (rule.type == 'J') {
+        // Julian day 1-365, February 29 is never counted
+        int yday = rule.day - 1;
+        if (TimeZoneEngine::isLeapYear(year) && rule.day >= 60) {
+            yday++;
+        }
+        days = TimeZoneEngine::daysFromCivil(year, 1, 1) + yday;
+    } else {
+        days = TimeZoneEngine::daysFromCivil(year, 1, 1) + rule.day;
+    }
+    return days * 86400 + rule.time;
+}
+
+std::mutex CompiledTimeZone::transitionMutex;
+
+CompiledTimeZone::YearTransitions CompiledTimeZone::transitionsFor(int32_t year) const
+{
+    std::lock_guard<std::mutex> lock(transitionMutex);
+    YearTransitions& slot = transitionCache[(uint32_t)year % TRANSITION_CACHE_SIZE];
+    if (slot.year != year) {
+        // Start is expressed in standard time, end in daylight time
+        slot.year = year;
+        slot.dstStart = ruleToLocalSeconds(dstStartRule, year) - stdOffset;
+        slot.dstEnd = ruleToLocalSeconds(dstEndRule, year) - dstOffset;
+    }
+    return slot;
+}
+
+bool CompiledTimeZone::isDstAtSeconds(int64_t utc) const
+{
+    if (!dstRules) {
+        return false;
+    }
+
+    int64_t year;
+    int month, day;
+    TimeZoneEngine::civilFromDays(floorDiv(utc + stdOffset, 86400), year, month, day);
+
+    const YearTransitions t = transitionsFor((int32_t)year);
+    if (t.dstStart < t.dstEnd) {
+        return utc >= t.dstStart && utc < t.dstEnd; // Northern hemisphere
+    }
+    return !(utc >= t.dstEnd && utc < t.dstStart); // Southern hemisphere
+}
+
+bool CompiledTimeZone::isDstAt(time_t utc) const
+{
+    return isDstAtSeconds((int64_t)utc);
+}
+
+void CompiledTimeZone::toLocal(time_t utc, struct tm& local) const
+{
+    bool dst = isDstAtSeconds((int64_t)utc);
+    TimeZoneEngine::breakDown((int64_t)utc + (dst ? dstOffset : stdOffset), local);
+    local.tm_isdst = dst ? 1 : 0;
+}
+
+time_t CompiledTimeZone::toUtc(struct tm& local) const
+{
+    int64_t wall = TimeZoneEngine::combine(local);
+    int64_t asStandard = wall - stdOffset;
+    int64_t asDaylight = wall - dstOffset;
+    int64_t utc;
+
+    if (!dstRules) {
+        utc = asStandard;
+    } else if (local.tm_isdst > 0) {
+        utc = asDaylight;
+    } else if (local.tm_isdst == 0) {
+        utc = asStandard;
+    } else if (isDstAtSeconds(asDaylight)) {
+        utc = asDaylight; // DST, or the first of two instants in the overlap
+    } else {
+        utc = asStandard; // Standard time, or a wall time inside the gap
+    }
+
+    toLocal((time_t)utc, local);
+    return (time_t)utc;
+}
+
+// ============================================================================
+// Zone registry
+// ============================================================================
+
+namespace {
+
+struct ZoneEntry {
+    String tzid;
+    CompiledTimeZone zone;
+    bool used;
+    bool ok;
+
+    ZoneEntry() : used(false), ok(false) {}
+};
+
+// Filled in order and never evicted: find() and local() hand out pointers
+// into the table that concurrent parsers keep using without the lock
+ZoneEntry zoneTable[TimeZoneEngine::MAX_ZONES];
+int zoneCount = 0;
+
+String localTzString;
+const CompiledTimeZone* localZone = nullptr;
+bool localZoneKnown = false;
+
+// Registry and TZ environment access from concurrent fetch tasks
+std::mutex registryMutex;
+
+} // namespace
+
+const CompiledTimeZone* TimeZoneEngine::find(const String& tzid)
+{
+    if (tzid.isEmpty()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return findLocked(tzid);
+}
+
+const CompiledTimeZone* TimeZoneEngine::findLocked(const String& tzid)
+{
+    for (int i = 0; i < zoneCount; i++) {
+        if (zoneTable[i].tzid == tzid) {
+            return zoneTable[i].ok ? &zoneTable[i].zone : nullptr;
+        }
+    }
+
+    // A full table compiles nothing more; callers fall back to the C library
+    if (zoneCount >= MAX_ZONES) {
+        return nullptr;
+    }
+
+    // Compile once; unknown TZIDs are remembered too so they stay cheap
+    ZoneEntry& entry = zoneTable[zoneCount++];
+    entry.used = true;
+    entry.tzid = tzid;
+
+    if (tzid == "UTC" || tzid == "Etc/UTC" || tzid == "GMT" || tzid == "Z") {
+        entry.ok = entry.zone.compile("UTC0");
+    } else {
+        String posix = getPosixTZ(tzid);
+        entry.ok = entry.zone.compile(posix.isEmpty() ? tzid.c_str() : posix.c_str());
+    }
+
+    return entry.ok ? &entry.zone : nullptr;
+}
+
+const CompiledTimeZone* TimeZoneEngine::local()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    const char* tz = getenv("TZ");
+    if (!tz || !*tz) {
+        return nullptr;
+    }
+
+    // A new TZ gets its own registry entry; the previous local zone stays
+    // valid for whoever still holds it
+    if (!localZoneKnown || strcmp(localTzString.c_str(), tz) != 0) {
+        localTzString = tz;
+        localZoneKnown = true;
+        localZone = findLocked(localTzString);
+    }
+
+    return localZone;
+}
+
+struct tm* TimeZoneEngine::localTime(time_t utc, struct tm& result)
+{
+    const CompiledTimeZone* zone = local();
+    if (zone) {
+        zone->toLocal(utc, result);
+        return &result;
+    }
+
+    // libc reads the process TZ, which makeInTz() may be borrowing
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return localtime_r(&utc, &result);
+}
+
+time_t TimeZoneEngine::makeLocal(struct tm& local)
+{
+    const CompiledTimeZone* zone = TimeZoneEngine::local();
+    if (zone) {
+        return zone->toUtc(local);
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return mktime(&local);
+}
+
+time_t TimeZoneEngine::makeInTz(const char* tz, struct tm& local)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    const char* oldTZ = getenv("TZ");
+    String savedTZ = oldTZ ? String(oldTZ) : "";
+
+    setenv("TZ", tz, 1);
+    tzset();
+    time_t result = mktime(&local);
+
+    if (!savedTZ.isEmpty()) {
+        setenv("TZ", savedTZ.c_str(), 1);
+    } else {
+        unsetenv("TZ");
+    }
+    tzset();
+    return result;
+}
+
+struct tm* TimeZoneEngine::utcTime(time_t utc, struct tm& result)
+{
+    breakDown((int64_t)utc, result);
+    result.tm_isdst = 0;
+    return &result;
+}
+
+time_t TimeZoneEngine::makeUtc(struct tm& utc)
+{
+    int64_t seconds = combine(utc);
+    utcTime((time_t)seconds, utc);
+    return (time_t)seconds;
+}
+
+void TimeZoneEngine::clear()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (int i = 0; i < MAX_ZONES; i++) {
+        zoneTable[i] = ZoneEntry();
+    }
+    zoneCount = 0;
+    localZone = nullptr;
+    localZoneKnown = false;
+    localTzString = "";
+}
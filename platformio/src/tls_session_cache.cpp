@@ -0,0 +1,457 @@
+/**
+ * Implementation of the TLS session cache
+ */
+
+#include "tls_session_cache.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "event_cache.h"
+
+#ifdef NATIVE_TEST
+#define DEBUG_INFO_PRINTLN(x)                                                                      \
+    do {                                                                                           \
+    } while (0)
+#define DEBUG_WARN_PRINTLN(x)                                                                      \
+    do {                                                                                           \
+    } while (0)
+// Native builds have no RTC memory; a static buffer outlives the cache objects the same way
+#define RTC_DATA_ATTR
+#else
+#include "debug_config.h"
+#include <esp_attr.h>
+#endif
+
+namespace {
+
+// Survives deep sleep; zeroed on power-on
+RTC_DATA_ATTR uint8_t rtcImage[TLS_SESSION_RTC_BYTES];
+RTC_DATA_ATTR uint32_t rtcImageLength = 0;
+// Wakes saved with changes the LittleFS copy does not hold yet
+RTC_DATA_ATTR uint32_t rtcUnflushedWakes = 0;
+
+// Per entry: key length, key, savedAt, data length, data
+const size_t ENTRY_OVERHEAD = 1 + 4 + 2;
+
+void putU16(std::vector<uint8_t>& out, uint16_t value)
+{
+    out.push_back((uint8_t)value);
+    out.push_back((uint8_t)(value >> 8));
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back((uint8_t)(value >> shift));
+    }
+}
+
+uint16_t getU16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+} // namespace
+
+const uint16_t TlsSessionCache::FLAG_COMPLETE;
+
+TlsSessionCache::TlsSessionCache(size_t maxEntries, uint32_t maxAge)
+    : maxEntries(maxEntries > 0 ? maxEntries : 1)
+    , maxAge(maxAge)
+    , useCounter(0)
+    , dirty(false)
+    , fullCount(0)
+    , fullMs(0)
+    , resumedCount(0)
+    , resumedMs(0)
+{
+}
+
+String TlsSessionCache::makeKey(const char* host, uint16_t port)
+{
+    String key = String(host) + ":" + String(port);
+    key.toLowerCase();
+    return key;
+}
+
+// ============================================================================
+// Entries
+// ============================================================================
+
+bool TlsSessionCache::store(const String& key, const uint8_t* data, size_t length, uint32_t now, bool resumed)
+{
+    if (!data || length == 0 || length > TLS_SESSION_MAX_BYTES || key.isEmpty() || key.length() > 255) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    dropExpired(now);
+
+    int index = find(key);
+    bool added = index < 0;
+    if (added) {
+        if (entries.size() >= maxEntries) {
+            size_t oldest = 0;
+            for (size_t i = 1; i < entries.size(); i++) {
+                if (entries[i].lastUse < entries[oldest].lastUse) {
+                    oldest = i;
+                }
+            }
+            DEBUG_INFO_PRINTLN("TLS session cache full, evicting " + entries[oldest].key);
+            entries.erase(entries.begin() + oldest);
+        }
+        entries.push_back(Entry());
+        index = (int)entries.size() - 1;
+        entries[index].key = key;
+    }
+
+    Entry& entry = entries[index];
+    entry.lastUse = ++useCounter;
+    if (!added && entry.data.size() == length && memcmp(entry.data.data(), data, length) == 0) {
+        return true;
+    }
+    entry.data.assign(data, data + length);
+    if (added || !resumed) {
+        entry.savedAt = now;
+    }
+    dirty = true;
+    return true;
+}
+
+size_t TlsSessionCache::lookup(const String& key, uint8_t* buffer, size_t capacity, uint32_t now)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    int index = find(key);
+    if (index < 0) {
+        return 0;
+    }
+    Entry& entry = entries[index];
+    if (isExpired(entry, now)) {
+        entries.erase(entries.begin() + index);
+        dirty = true;
+        return 0;
+    }
+    if (entry.data.size() > capacity) {
+        return 0;
+    }
+    memcpy(buffer, entry.data.data(), entry.data.size());
+    entry.lastUse = ++useCounter;
+    return entry.data.size();
+}
+
+bool TlsSessionCache::remove(const String& key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    int index = find(key);
+    if (index < 0) {
+        return false;
+    }
+    entries.erase(entries.begin() + index);
+    dirty = true;
+    return true;
+}
+
+void TlsSessionCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!entries.empty()) {
+        dirty = true;
+    }
+    entries.clear();
+}
+
+size_t TlsSessionCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+bool TlsSessionCache::isDirty() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return dirty;
+}
+
+int TlsSessionCache::find(const String& key) const
+{
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].key == key) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+bool TlsSessionCache::isExpired(const Entry& entry, uint32_t now) const
+{
+    // A clock behind the stored time (not yet synced) does not expire anything
+    return now >= entry.savedAt && now - entry.savedAt > maxAge;
+}
+
+void TlsSessionCache::dropExpired(uint32_t now)
+{
+    for (size_t i = entries.size(); i-- > 0;) {
+        if (isExpired(entries[i], now)) {
+            entries.erase(entries.begin() + i);
+            dirty = true;
+        }
+    }
+}
+
+// ============================================================================
+// Serialization
+// ============================================================================
+
+size_t TlsSessionCache::serialize(uint8_t* buffer, size_t capacity, bool& complete) const
+{
+    complete = true;
+    if (capacity < sizeof(ImageHeader)) {
+        complete = false;
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Most recently used first, so a short buffer keeps the sessions that matter
+    std::vector<const Entry*> order;
+    for (size_t i = 0; i < entries.size(); i++) {
+        order.push_back(&entries[i]);
+    }
+    std::sort(order.begin(), order.end(), [](const Entry* a, const Entry* b) { return a->lastUse > b->lastUse; });
+
+    std::vector<uint8_t> payload;
+    uint16_t count = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        const Entry& entry = *order[i];
+        size_t entrySize = ENTRY_OVERHEAD + entry.key.length() + entry.data.size();
+        if (sizeof(ImageHeader) + payload.size() + entrySize > capacity) {
+            complete = false;
+            continue;
+        }
+        payload.push_back((uint8_t)entry.key.length());
+        payload.insert(payload.end(), entry.key.c_str(), entry.key.c_str() + entry.key.length());
+        putU32(payload, entry.savedAt);
+        putU16(payload, (uint16_t)entry.data.size());
+        payload.insert(payload.end(), entry.data.begin(), entry.data.end());
+        count++;
+    }
+
+    ImageHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic         = TLS_SESSION_MAGIC;
+    header.version       = TLS_SESSION_VERSION;
+    header.count         = count;
+    header.flags         = complete ? FLAG_COMPLETE : 0;
+    header.payloadLength = payload.size();
+    header.checksum      = EventCache::calculateCRC32(payload.data(), payload.size());
+
+    memcpy(buffer, &header, sizeof(header));
+    if (!payload.empty()) {
+        memcpy(buffer + sizeof(header), payload.data(), payload.size());
+    }
+    return sizeof(header) + payload.size();
+}
+
+bool TlsSessionCache::deserialize(const uint8_t* data, size_t length, uint32_t now, bool& complete)
+{
+    complete = false;
+    if (!data || length < sizeof(ImageHeader)) {
+        return false;
+    }
+
+    ImageHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != TLS_SESSION_MAGIC || header.version != TLS_SESSION_VERSION ||
+        header.payloadLength > length - sizeof(header)) {
+        return false;
+    }
+    const uint8_t* payload = data + sizeof(header);
+    if (EventCache::calculateCRC32(payload, header.payloadLength) != header.checksum) {
+        DEBUG_WARN_PRINTLN("TLS session image checksum mismatch");
+        return false;
+    }
+
+    // Parse everything before touching the cache: a malformed image adds nothing
+    std::vector<Entry> parsed;
+    size_t offset = 0;
+    for (uint16_t i = 0; i < header.count; i++) {
+        if (offset + 1 > header.payloadLength) {
+            return false;
+        }
+        size_t keyLength = payload[offset++];
+        if (offset + keyLength + 6 > header.payloadLength) {
+            return false;
+        }
+        Entry entry;
+        entry.key = String(std::string((const char*)payload + offset, keyLength).c_str());
+        offset += keyLength;
+        entry.savedAt = getU32(payload + offset);
+        size_t dataLength = getU16(payload + offset + 4);
+        offset += 6;
+        if (dataLength == 0 || dataLength > TLS_SESSION_MAX_BYTES || offset + dataLength > header.payloadLength) {
+            return false;
+        }
+        entry.data.assign(payload + offset, payload + offset + dataLength);
+        offset += dataLength;
+        parsed.push_back(entry);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // The image is most recently used first: add from the back so the order carries over
+    for (size_t i = parsed.size(); i-- > 0;) {
+        if (isExpired(parsed[i], now) || find(parsed[i].key) >= 0) {
+            continue;
+        }
+        if (entries.size() >= maxEntries) {
+            break;
+        }
+        parsed[i].lastUse = ++useCounter;
+        entries.push_back(parsed[i]);
+    }
+    complete = (header.flags & FLAG_COMPLETE) != 0;
+    return true;
+}
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+bool TlsSessionCache::load(uint32_t now, const char* path)
+{
+    bool complete = false;
+    bool fromRtc = rtcImageLength > 0 && rtcImageLength <= sizeof(rtcImage) &&
+                   deserialize(rtcImage, rtcImageLength, now, complete);
+    if (fromRtc) {
+        DEBUG_INFO_PRINTLN("Restored " + String(size()) + " TLS sessions from RTC memory");
+    }
+
+    // Power-on, or sessions that only fit in the file
+    if (!fromRtc || !complete) {
+        if (loadFile(path, now)) {
+            DEBUG_INFO_PRINTLN("Restored TLS sessions from " + String(path) + " (" + String(size()) + " total)");
+        }
+    }
+
+    // The file lags RTC memory by the wakes not yet flushed
+    if (!fromRtc) {
+        rtcUnflushedWakes = 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    dirty = rtcUnflushedWakes > 0;
+    return !entries.empty();
+}
+
+bool TlsSessionCache::loadFile(const char* path, uint32_t now)
+{
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> image(file.size());
+    size_t read = image.empty() ? 0 : file.read(image.data(), image.size());
+    file.close();
+
+    bool complete;
+    return read == image.size() && deserialize(image.data(), image.size(), now, complete);
+}
+
+bool TlsSessionCache::save(const char* path)
+{
+    bool complete;
+    rtcImageLength = serialize(rtcImage, sizeof(rtcImage), complete);
+
+    if (!isDirty()) {
+        return true;
+    }
+    // Sessions left out of the RTC image only survive in the file
+    if (complete && ++rtcUnflushedWakes < TLS_SESSION_FLUSH_WAKES) {
+        return true;
+    }
+    return flush(path);
+}
+
+bool TlsSessionCache::flush(const char* path)
+{
+    bool complete;
+    size_t needed = sizeof(ImageHeader);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < entries.size(); i++) {
+            needed += ENTRY_OVERHEAD + entries[i].key.length() + entries[i].data.size();
+        }
+    }
+    std::vector<uint8_t> image(needed);
+    size_t length = serialize(image.data(), image.size(), complete);
+
+    File file = LittleFS.open(path, "w");
+    if (!file) {
+        DEBUG_WARN_PRINTLN("Failed to open " + String(path) + " for writing");
+        return false;
+    }
+    bool written = file.write(image.data(), length) == length;
+    file.close();
+    if (!written) {
+        DEBUG_WARN_PRINTLN("Failed to write " + String(path));
+        return false;
+    }
+
+    rtcUnflushedWakes = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    dirty = false;
+    return true;
+}
+
+void TlsSessionCache::clearRtcImage()
+{
+    rtcImageLength    = 0;
+    rtcUnflushedWakes = 0;
+}
+
+// ============================================================================
+// Instrumentation
+// ============================================================================
+
+void TlsSessionCache::recordHandshake(bool resumed, unsigned long durationMs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (resumed) {
+        resumedCount++;
+        resumedMs += durationMs;
+    } else {
+        fullCount++;
+        fullMs += durationMs;
+    }
+}
+
+size_t TlsSessionCache::getFullHandshakeCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return fullCount;
+}
+
+unsigned long TlsSessionCache::getFullHandshakeMs() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return fullMs;
+}
+
+size_t TlsSessionCache::getResumedHandshakeCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return resumedCount;
+}
+
+unsigned long TlsSessionCache::getResumedHandshakeMs() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return resumedMs;
+}
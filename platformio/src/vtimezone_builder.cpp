@@ -0,0 +1,312 @@
+/**
+ * Implementation of the VTIMEZONE to POSIX TZ compiler
+ */
+
+#include "vtimezone_builder.h"
+
+#include <cstdio>
+#include <cstring>
+
+static const char* const WEEKDAY_CODES[7] = {"SU", "MO", "TU", "WE", "TH", "FR", "SA"};
+
+// Parse a run of decimal digits; returns false if there are none
+static bool parseDigits(const char*& p, const char* end, int& value)
+{
+    if (p >= end || *p < '0' || *p > '9') {
+        return false;
+    }
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    return true;
+}
+
+VTimezoneBuilder::VTimezoneBuilder()
+{
+    begin();
+}
+
+void VTimezoneBuilder::begin()
+{
+    tzid = "";
+    depth = 1;
+    currentIsDaylight = false;
+    resetObservance(current);
+    resetObservance(standard);
+    resetObservance(daylight);
+}
+
+void VTimezoneBuilder::resetObservance(Observance& observance)
+{
+    memset(&observance, 0, sizeof(observance));
+    observance.weekday = -1;
+}
+
+bool VTimezoneBuilder::addLine(const char* line, size_t length)
+{
+    IcsProperty property;
+    if (!IcsLineReader::splitProperty(line, length, property)) {
+        return false;
+    }
+
+    if (property.is("BEGIN")) {
+        if (IcsLineReader::startsWith(property.value, property.valueLength, "DAYLIGHT") ||
+            IcsLineReader::startsWith(property.value, property.valueLength, "STANDARD")) {
+            resetObservance(current);
+            current.present = true;
+            currentIsDaylight = property.value[0] == 'D';
+        }
+        depth++;
+        return false;
+    }
+
+    if (property.is("END")) {
+        depth--;
+        if (depth == 1 && current.present) {
+            commitObservance();
+        }
+        return depth <= 0;
+    }
+
+    applyProperty(property);
+    return false;
+}
+
+void VTimezoneBuilder::applyProperty(const IcsProperty& property)
+{
+    if (depth == 1) {
+        if (property.is("TZID")) {
+            tzid = "";
+            tzid.concat(property.value, property.valueLength);
+            tzid.trim();
+        }
+        return;
+    }
+
+    if (depth != 2 || !current.present) {
+        return;
+    }
+
+    if (property.is("TZOFFSETTO")) {
+        parseOffset(property.value, property.valueLength, current.offsetTo);
+    } else if (property.is("DTSTART")) {
+        size_t copy = property.valueLength < sizeof(current.dtstart) - 1 ? property.valueLength
+                                                                          : sizeof(current.dtstart) - 1;
+        memcpy(current.dtstart, property.value, copy);
+        current.dtstart[copy] = '\0';
+    } else if (property.is("RRULE")) {
+        parseRRule(property.value, property.valueLength, current);
+    }
+}
+
+void VTimezoneBuilder::parseRRule(const char* value, size_t length, Observance& observance)
+{
+    const char* p = value;
+    const char* end = value + length;
+
+    bool yearly = false;
+    bool hasUntil = false;
+    int ordinal = 0;
+    bool hasOrdinal = false;
+    int monthDayMin = 32, monthDayMax = 0, monthDayCount = 0;
+    bool listOk = true;
+
+    while (p < end) {
+        const char* partEnd = (const char*)memchr(p, ';', end - p);
+        if (!partEnd) {
+            partEnd = end;
+        }
+        const char* equals = (const char*)memchr(p, '=', partEnd - p);
+        if (equals) {
+            size_t keyLength = equals - p;
+            const char* v = equals + 1;
+
+            if (keyLength == 4 && memcmp(p, "FREQ", 4) == 0) {
+                yearly = (partEnd - v == 6) && memcmp(v, "YEARLY", 6) == 0;
+            } else if (keyLength == 5 && memcmp(p, "UNTIL", 5) == 0) {
+                hasUntil = true;
+            } else if (keyLength == 7 && memcmp(p, "BYMONTH", 7) == 0) {
+                int month;
+                listOk = listOk && parseDigits(v, partEnd, month) && v == partEnd && month >= 1 && month <= 12;
+                observance.month = month;
+            } else if (keyLength == 5 && memcmp(p, "BYDAY", 5) == 0) {
+                int sign = 1;
+                if (v < partEnd && (*v == '-' || *v == '+')) {
+                    sign = (*v == '-') ? -1 : 1;
+                    v++;
+                }
+                hasOrdinal = parseDigits(v, partEnd, ordinal);
+                ordinal *= sign;
+                observance.weekday = -1;
+                if (partEnd - v == 2) {
+                    for (int d = 0; d < 7; d++) {
+                        if (memcmp(v, WEEKDAY_CODES[d], 2) == 0) {
+                            observance.weekday = d;
+                        }
+                    }
+                }
+                listOk = listOk && observance.weekday >= 0;
+            } else if (keyLength == 10 && memcmp(p, "BYMONTHDAY", 10) == 0) {
+                while (v < partEnd) {
+                    int day;
+                    if (!parseDigits(v, partEnd, day)) {
+                        listOk = false;
+                        break;
+                    }
+                    monthDayMin = day < monthDayMin ? day : monthDayMin;
+                    monthDayMax = day > monthDayMax ? day : monthDayMax;
+                    monthDayCount++;
+                    if (v < partEnd && *v == ',') {
+                        v++;
+                    }
+                }
+            }
+        }
+        p = partEnd + 1;
+    }
+
+    observance.recurring = !hasUntil;
+    observance.ruleOk = false;
+    if (!yearly || !listOk || observance.month == 0) {
+        return;
+    }
+
+    if (observance.weekday >= 0 && hasOrdinal) {
+        // BYDAY=-1SU (last), BYDAY=2SU (second)
+        if (ordinal == -1 || ordinal == 5) {
+            observance.week = 5;
+        } else if (ordinal >= 1 && ordinal <= 4) {
+            observance.week = ordinal;
+        } else {
+            return;
+        }
+    } else if (observance.weekday >= 0 && monthDayCount == 7 && monthDayMax - monthDayMin == 6) {
+        // Older Outlook form: BYDAY=SU;BYMONTHDAY=8,9,10,11,12,13,14
+        if ((monthDayMin - 1) % 7 == 0 && monthDayMin <= 22) {
+            observance.week = (monthDayMin - 1) / 7 + 1;
+        } else if (monthDayMax >= 31) {
+            observance.week = 5;
+        } else {
+            return;
+        }
+    } else if (observance.weekday < 0 && monthDayCount == 1) {
+        // Fixed date every year
+        observance.week = 0;
+        observance.monthDay = monthDayMin;
+    } else {
+        return;
+    }
+
+    observance.ruleOk = true;
+}
+
+void VTimezoneBuilder::commitObservance()
+{
+    Observance& slot = currentIsDaylight ? daylight : standard;
+
+    // Keep the observance in force today: open-ended rules beat one-off
+    // transitions, and among equals the latest DTSTART wins
+    bool replace = !slot.present || (current.recurring && !slot.recurring) ||
+                   (current.recurring == slot.recurring && strcmp(current.dtstart, slot.dtstart) > 0);
+    if (replace) {
+        slot = current;
+    }
+    resetObservance(current);
+}
+
+bool VTimezoneBuilder::parseOffset(const char* value, size_t length, int32_t& seconds)
+{
+    // [+-]HHMM[SS]
+    if (length != 5 && length != 7) {
+        return false;
+    }
+    if (value[0] != '+' && value[0] != '-') {
+        return false;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if (value[i] < '0' || value[i] > '9') {
+            return false;
+        }
+    }
+
+    int32_t hours = (value[1] - '0') * 10 + (value[2] - '0');
+    int32_t minutes = (value[3] - '0') * 10 + (value[4] - '0');
+    int32_t secs = length == 7 ? (value[5] - '0') * 10 + (value[6] - '0') : 0;
+    seconds = hours * 3600 + minutes * 60 + secs;
+    if (value[0] == '-') {
+        seconds = -seconds;
+    }
+    return true;
+}
+
+void VTimezoneBuilder::appendOffset(String& out, int32_t eastSeconds)
+{
+    // POSIX offsets are positive west of Greenwich
+    int32_t west = -eastSeconds;
+    char buffer[16];
+    const char* sign = west < 0 ? "-" : "";
+    if (west < 0) {
+        west = -west;
+    }
+
+    if (west % 60 != 0) {
+        snprintf(buffer, sizeof(buffer), "%s%d:%02d:%02d", sign, (int)(west / 3600), (int)(west % 3600 / 60),
+                 (int)(west % 60));
+    } else if (west % 3600 != 0) {
+        snprintf(buffer, sizeof(buffer), "%s%d:%02d", sign, (int)(west / 3600), (int)(west % 3600 / 60));
+    } else {
+        snprintf(buffer, sizeof(buffer), "%s%d", sign, (int)(west / 3600));
+    }
+    out += buffer;
+}
+
+bool VTimezoneBuilder::appendRule(String& out, const Observance& observance)
+{
+    static const int DAYS_BEFORE_MONTH[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+    char buffer[32];
+    if (observance.week > 0) {
+        snprintf(buffer, sizeof(buffer), ",M%d.%d.%d", observance.month, observance.week, observance.weekday);
+    } else {
+        // Julian day 1-365 ignores February 29, like the fixed date itself
+        snprintf(buffer, sizeof(buffer), ",J%d", DAYS_BEFORE_MONTH[observance.month - 1] + observance.monthDay);
+    }
+    out += buffer;
+
+    // Transition time is the local DTSTART time in the previous observance
+    const char* dtstart = observance.dtstart;
+    if (strlen(dtstart) >= 15 && dtstart[8] == 'T') {
+        int hour = (dtstart[9] - '0') * 10 + (dtstart[10] - '0');
+        int minute = (dtstart[11] - '0') * 10 + (dtstart[12] - '0');
+        int second = (dtstart[13] - '0') * 10 + (dtstart[14] - '0');
+        snprintf(buffer, sizeof(buffer), "/%d:%02d:%02d", hour, minute, second);
+        out += buffer;
+    }
+    return true;
+}
+
+bool VTimezoneBuilder::toPosix(String& posix) const
+{
+    if (!standard.present) {
+        return false;
+    }
+
+    posix = "STD";
+    appendOffset(posix, standard.offsetTo);
+
+    bool hasDst = daylight.present && daylight.recurring && standard.recurring;
+    if (!hasDst) {
+        return true;
+    }
+    if (!daylight.ruleOk || !standard.ruleOk) {
+        return false;
+    }
+
+    posix += "DST";
+    appendOffset(posix, daylight.offsetTo);
+    appendRule(posix, daylight);
+    appendRule(posix, standard);
+    return true;
+}
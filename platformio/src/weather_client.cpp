@@ -50,17 +50,24 @@ bool WeatherClient::fetchWeather(WeatherData& data) {
 
     Serial.println("Fetching weather from: " + url);
 
+    // HTTP/1.0 keeps the body free of chunk framing, so it can be parsed
+    // straight from the connection
+    http.useHTTP10(true);
     http.begin(*client, url);
     http.setTimeout(10000); // 10 second timeout
 
     int httpCode = http.GET();
 
     if (httpCode == HTTP_CODE_OK) {
-        String payload = http.getString();
         Serial.println("Weather data received, parsing...");
 
-        bool success = parseWeatherData(payload, data);
+        bool success = WeatherParser::parse(http.getStream(), data);
         http.end();
+        if (success) {
+            Serial.println("Weather data parsed successfully");
+            Serial.println("Current temp: " + String(data.currentTemp) + "°C");
+            Serial.println("Daily forecast items: " + String(data.dailyForecast.size()));
+        }
         return success;
     } else {
         Serial.println("Weather fetch failed, HTTP code: " + String(httpCode));
@@ -72,57 +79,6 @@ bool WeatherClient::fetchWeather(WeatherData& data) {
     }
 }
 
-bool WeatherClient::parseWeatherData(const String& jsonData, WeatherData& data) {
-    // Use PSRAM if available for large JSON document
-    DynamicJsonDocument doc(16384);
-
-    DeserializationError error = deserializeJson(doc, jsonData);
-    if (error) {
-        Serial.println("Failed to parse weather JSON: " + String(error.c_str()));
-        return false;
-    }
-
-    // Parse current weather
-    if (doc.containsKey("current")) {
-        JsonObject current      = doc["current"];
-        data.currentTemp        = current["apparent_temperature"];
-        data.currentWeatherCode = current["weather_code"];
-        data.isDay              = current["is_day"] == 1;
-    }
-
-    // Parse daily forecast
-    data.dailyForecast.clear();
-    if (doc.containsKey("daily")) {
-        JsonObject daily     = doc["daily"];
-        JsonArray dates      = daily["time"];
-        JsonArray codes      = daily["weather_code"];
-        JsonArray maxTemps   = daily["temperature_2m_max"];
-        JsonArray minTemps   = daily["temperature_2m_min"];
-        JsonArray sunrises   = daily["sunrise"];
-        JsonArray sunsets    = daily["sunset"];
-        JsonArray precipProb = daily["precipitation_probability_max"];
-
-        for (int i = 0; i < dates.size() && i < 3; i++) {
-            WeatherDay day;
-            day.date                     = dates[i].as<String>();
-            day.weatherCode              = codes[i];
-            day.tempMax                  = maxTemps[i];
-            day.tempMin                  = minTemps[i];
-            day.sunrise                  = sunrises[i].as<String>();
-            day.sunset                   = sunsets[i].as<String>();
-            day.precipitationProbability = precipProb[i];
-
-            data.dailyForecast.push_back(day);
-        }
-    }
-
-    Serial.println("Weather data parsed successfully");
-    Serial.println("Current temp: " + String(data.currentTemp) + "°C");
-    Serial.println("Daily forecast items: " + String(data.dailyForecast.size()));
-
-    return true;
-}
-
 // Macro to select icon based on size
 #define GET_WEATHER_ICON(name, size)                                                               \
     ((size) == 16    ? name##_16x16                                                                \
@@ -0,0 +1,102 @@
+/**
+ * Implementation of the streaming Open-Meteo response parser
+ */
+
+#include "weather_parser.h"
+
+namespace {
+
+// ArduinoJson reads from any type with read() and readBytes(char*, size_t).
+// read() goes through readBytes() so that it waits for the stream timeout
+// like the block reads do, instead of failing when no byte has arrived yet.
+class JsonStreamReader {
+  public:
+    explicit JsonStreamReader(Stream& stream) : stream(stream) {}
+
+    int read() {
+        uint8_t c;
+        return stream.readBytes(&c, 1) == 1 ? c : -1;
+    }
+
+    size_t readBytes(char* buffer, size_t length) { return stream.readBytes((uint8_t*)buffer, length); }
+
+  private:
+    Stream& stream;
+};
+
+} // namespace
+
+const size_t WeatherParser::MAX_FORECAST_DAYS;
+
+void WeatherParser::buildFilter(JsonDocument& filter) {
+    filter["current"]["apparent_temperature"] = true;
+    filter["current"]["weather_code"]         = true;
+    filter["current"]["is_day"]               = true;
+
+    filter["daily"]["time"]                          = true;
+    filter["daily"]["weather_code"]                  = true;
+    filter["daily"]["temperature_2m_max"]            = true;
+    filter["daily"]["temperature_2m_min"]            = true;
+    filter["daily"]["sunrise"]                       = true;
+    filter["daily"]["sunset"]                        = true;
+    filter["daily"]["precipitation_probability_max"] = true;
+}
+
+bool WeatherParser::parse(Stream& input, WeatherData& data) {
+    JsonDocument filter;
+    JsonDocument doc;
+    return parseDocument(input, data, doc, filter);
+}
+
+bool WeatherParser::parse(Stream& input, WeatherData& data, ArduinoJson::Allocator* allocator) {
+    JsonDocument filter(allocator);
+    JsonDocument doc(allocator);
+    return parseDocument(input, data, doc, filter);
+}
+
+bool WeatherParser::parseDocument(Stream& input, WeatherData& data, JsonDocument& doc, JsonDocument& filter) {
+    buildFilter(filter);
+
+    JsonStreamReader reader(input);
+    DeserializationError error = deserializeJson(doc, reader, DeserializationOption::Filter(filter));
+    if (error) {
+        Serial.println("Failed to parse weather JSON: " + String(error.c_str()));
+        return false;
+    }
+
+    // Parse current weather
+    JsonObject current = doc["current"];
+    if (current) {
+        data.currentTemp        = current["apparent_temperature"];
+        data.currentWeatherCode = current["weather_code"];
+        data.isDay              = current["is_day"] == 1;
+    }
+
+    // Parse daily forecast
+    data.dailyForecast.clear();
+    JsonObject daily = doc["daily"];
+    if (daily) {
+        JsonArray dates      = daily["time"];
+        JsonArray codes      = daily["weather_code"];
+        JsonArray maxTemps   = daily["temperature_2m_max"];
+        JsonArray minTemps   = daily["temperature_2m_min"];
+        JsonArray sunrises   = daily["sunrise"];
+        JsonArray sunsets    = daily["sunset"];
+        JsonArray precipProb = daily["precipitation_probability_max"];
+
+        for (size_t i = 0; i < dates.size() && i < MAX_FORECAST_DAYS; i++) {
+            WeatherDay day;
+            day.date                     = dates[i].as<const char*>();
+            day.weatherCode              = codes[i];
+            day.tempMax                  = maxTemps[i];
+            day.tempMin                  = minTemps[i];
+            day.sunrise                  = sunrises[i].as<const char*>();
+            day.sunset                   = sunsets[i].as<const char*>();
+            day.precipitationProbability = precipProb[i];
+
+            data.dailyForecast.push_back(day);
+        }
+    }
+
+    return true;
+}
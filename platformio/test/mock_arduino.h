@@ -2,7 +2,9 @@
 #define MOCK_ARDUINO_H
 
 // Mock Arduino types and functions for native testing
+#include <atomic>
 #include <string>
+#include <cctype>
 #include <cstring>
 #include <cstdint>
 #include <ctime>
@@ -83,6 +85,12 @@ public:
         buffer = buffer.substr(start, end - start + 1);
     }
 
+    void toLowerCase() {
+        for (size_t i = 0; i < buffer.length(); i++) {
+            buffer[i] = (char)tolower((unsigned char)buffer[i]);
+        }
+    }
+
     void replace(const String& from, const String& to) {
         size_t pos = 0;
         while ((pos = buffer.find(from.buffer, pos)) != std::string::npos) {
@@ -106,6 +114,17 @@ public:
         return *this;
     }
 
+    bool concat(const char* str, unsigned int len) {
+        if (!str) return false;
+        buffer.append(str, len);
+        return true;
+    }
+
+    bool reserve(unsigned int size) {
+        buffer.reserve(size);
+        return true;
+    }
+
     bool operator==(const String& other) const {
         return buffer == other.buffer;
     }
@@ -161,6 +180,11 @@ public:
         return buffer.find(prefix) == 0;
     }
 
+    bool endsWith(const String& suffix) const {
+        return buffer.length() >= suffix.buffer.length() &&
+               buffer.compare(buffer.length() - suffix.buffer.length(), suffix.buffer.length(), suffix.buffer) == 0;
+    }
+
     String repeat(size_t count) const {
         std::string result;
         result.reserve(buffer.length() * count);
@@ -218,13 +242,20 @@ extern MockSerial Serial;
 // Mock Stream class
 class Stream {
 public:
+    Stream() : timeout(1000) {}
     virtual ~Stream() {}
+    // Longest wait of a blocking read, in milliseconds (as in Arduino)
+    void setTimeout(unsigned long timeoutMs) { timeout = timeoutMs; }
+    unsigned long getTimeout() const { return timeout; }
     virtual int available() = 0;
     virtual String readString() = 0;
     virtual int read() = 0;
     virtual int peek() = 0;
     virtual void flush() {}
     virtual size_t readBytes(uint8_t* buffer, size_t length) = 0;
+
+protected:
+    unsigned long timeout;
 };
 
 // Mock StringStream for testing
@@ -283,6 +314,13 @@ private:
 // Mock File and LittleFS - using separate header for proper file persistence
 #include "mock_littlefs.h"
 
+// HTTP status codes used by the fetchers
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_PARTIAL_CONTENT 206
+#define HTTP_CODE_NOT_MODIFIED 304
+#define HTTP_CODE_NOT_FOUND 404
+#define HTTP_CODE_RANGE_NOT_SATISFIABLE 416
+
 // Mock HTTPClient
 class HTTPClient {
 public:
@@ -293,9 +331,28 @@ public:
 };
 
 // Mock WiFiClient
+// Connections always succeed, except to hosts ending in ".invalid"
 class WiFiClient {
 public:
-    // Add any necessary member functions for WiFiClient
+    WiFiClient() : open(false) {}
+    virtual ~WiFiClient() {}
+
+    virtual int connect(const char* host, uint16_t port) {
+        (void)port;
+        size_t length = strlen(host);
+        open = !(length >= 8 && strcmp(host + length - 8, ".invalid") == 0);
+        return open ? 1 : 0;
+    }
+    virtual uint8_t connected() { return open ? 1 : 0; }
+    virtual void stop() { open = false; }
+
+private:
+    bool open;
+};
+
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setInsecure() {}
 };
 
 
@@ -306,15 +363,16 @@ typedef long time_t;
 #endif
 
 // Mock Arduino timing functions
+// Atomic so parsers on concurrent fetch workers can share them
 inline unsigned long millis() {
     // Return incrementing timestamp to avoid infinite loops
-    static unsigned long mockTime = 0;
+    static std::atomic<unsigned long> mockTime(0);
     return mockTime++;
 }
 
 inline void delay(unsigned long ms) {
     // Mock implementation - advance mock time
-    static unsigned long mockTime = 0;
+    static std::atomic<unsigned long> mockTime(0);
     mockTime += ms;
 }
 
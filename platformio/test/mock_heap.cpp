@@ -0,0 +1,105 @@
+#include "mock_heap.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Each block starts with the size it counted for (0 if untracked), padded to
+// keep the alignment of malloc()
+const size_t HEADER = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t) : sizeof(size_t);
+
+std::atomic<size_t> allocated(0);
+std::atomic<size_t> highest(0);
+
+// Untracked objects alive on this thread
+thread_local int untrackedDepth = 0;
+
+void* take(size_t size) {
+    char* block = static_cast<char*>(std::malloc(size + HEADER));
+    if (!block) {
+        return nullptr;
+    }
+    if (untrackedDepth > 0) {
+        *reinterpret_cast<size_t*>(block) = 0;
+        return block + HEADER;
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    size_t now = allocated += size;
+    size_t seen = highest.load();
+    while (now > seen && !highest.compare_exchange_weak(seen, now)) {
+    }
+    return block + HEADER;
+}
+
+void give(void* pointer) {
+    if (!pointer) {
+        return;
+    }
+    char* block = static_cast<char*>(pointer) - HEADER;
+    allocated -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+} // namespace
+
+namespace MockHeap {
+
+size_t current() {
+    return allocated.load();
+}
+
+size_t peak() {
+    return highest.load();
+}
+
+void resetPeak() {
+    highest = allocated.load();
+}
+
+Untracked::Untracked() {
+    untrackedDepth++;
+}
+
+Untracked::~Untracked() {
+    untrackedDepth--;
+}
+
+} // namespace MockHeap
+
+void* operator new(size_t size) {
+    void* pointer = take(size);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return take(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return take(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    give(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    give(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    give(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    give(pointer);
+}
@@ -0,0 +1,47 @@
+#ifndef MOCK_HEAP_H
+#define MOCK_HEAP_H
+
+#include <cstddef>
+
+/**
+ * Heap accounting for native tests
+ *
+ * mock_heap.cpp replaces the global operator new and delete of the test
+ * binary, so that a test can measure the most memory a piece of code had
+ * allocated at once:
+ *
+ *     MockHeap::resetPeak();
+ *     size_t before = MockHeap::current();
+ *     ...
+ *     size_t used = MockHeap::peak() - before;
+ *
+ * Memory taken with malloc() directly is not counted, nor memory allocated
+ * while an Untracked object is alive: the mock file system keeps its file
+ * contents that way, so that they do not count against the code under test.
+ */
+namespace MockHeap {
+
+// Bytes allocated through operator new and not yet deleted
+size_t current();
+
+// Most bytes allocated at once since the last resetPeak()
+size_t peak();
+
+// Start a new measurement from the current allocation
+void resetPeak();
+
+// Allocations made while one of these is in scope are not counted, even
+// once they are deleted later
+class Untracked {
+  public:
+    Untracked();
+    ~Untracked();
+
+  private:
+    Untracked(const Untracked&);
+    Untracked& operator=(const Untracked&);
+};
+
+} // namespace MockHeap
+
+#endif // MOCK_HEAP_H
@@ -6,7 +6,12 @@
 #include <string>
 #include <memory>
 
+#include "mock_heap.h"
+
 // Note: This header must be included AFTER mock_arduino.h defines String and Stream
+//
+// File contents are allocated under MockHeap::Untracked, so that heap
+// measurements only see the memory of the code using the files.
 
 // Forward declaration
 class MockLittleFS;
@@ -43,6 +48,7 @@ public:
         data->isOpen = true;
         data->position = 0;
         if (!initialData.empty()) {
+            MockHeap::Untracked untracked;
             data->binaryData = initialData;
         }
     }
@@ -73,21 +79,10 @@ public:
 
     size_t write(uint8_t c) {
         if (!data || !data->isOpen) return 0;
-        if (data->mode.find('w') != std::string::npos || data->mode.find('a') != std::string::npos) {
-            data->binaryData.push_back(c);
-            return 1;
-        }
-        return 0;
+        return write(&c, 1);
     }
 
-    size_t write(const uint8_t* buffer, size_t size) {
-        if (!data || !data->isOpen || !buffer) return 0;
-        if (data->mode.find('w') != std::string::npos || data->mode.find('a') != std::string::npos) {
-            data->binaryData.insert(data->binaryData.end(), buffer, buffer + size);
-            return size;
-        }
-        return 0;
-    }
+    size_t write(const uint8_t* buffer, size_t size);  // Implemented after MockLittleFS definition
 
     size_t read(uint8_t* buffer, size_t size) {
         if (!data || !data->isOpen || !buffer || data->position >= data->binaryData.size()) return 0;
@@ -114,6 +109,16 @@ public:
         return data ? data->binaryData.size() : 0;
     }
 
+    bool seek(uint32_t pos) {
+        if (!data || !data->isOpen || pos > data->binaryData.size()) return false;
+        data->position = pos;
+        return true;
+    }
+
+    size_t position() const {
+        return data ? data->position : 0;
+    }
+
 private:
     std::shared_ptr<FileData> data;
 };
@@ -157,8 +162,24 @@ public:
         return File(false);
     }
 
+    bool rename(const String& from, const String& to) {
+        return rename(from.c_str(), to.c_str());
+    }
+
+    // Replaces an existing file at to, as LittleFS does
+    bool rename(const char* from, const char* to) {
+        auto it = files.find(from);
+        if (it == files.end() || spendWrite(1) == 0) return false;
+        MockHeap::Untracked untracked;
+        std::vector<uint8_t> moved = it->second;
+        files.erase(it);
+        files[to] = moved;
+        return true;
+    }
+
     // Called by File::close() to persist data
     void persistFile(const std::string& path, const std::vector<uint8_t>& data) {
+        MockHeap::Untracked untracked;
         files[path] = data;
     }
 
@@ -169,6 +190,7 @@ public:
     bool remove(const char* path) {
         auto it = files.find(path);
         if (it != files.end()) {
+            if (spendWrite(1) == 0) return false;
             files.erase(it);
         }
         return true;
@@ -199,6 +221,32 @@ public:
     void clear() {
         files.clear();
         mounted = false;
+        writesDone = 0;
+        clearWriteFailure();
+    }
+
+    // Power loss after bytes more bytes: later writes are cut short and
+    // renames and removes fail (each counts as one byte). What was written
+    // before stays in the file, as a torn write would leave it.
+    void failWritesAfter(size_t bytes) {
+        writeBudget = bytes;
+        writesLimited = true;
+    }
+
+    void clearWriteFailure() {
+        writesLimited = false;
+        writeBudget = 0;
+    }
+
+    // Bytes written, renames and removes since the last clear()
+    size_t writeCount() const { return writesDone; }
+
+    // Part of size that can still be written
+    size_t spendWrite(size_t size) {
+        if (writesLimited && size > writeBudget) size = writeBudget;
+        if (writesLimited) writeBudget -= size;
+        writesDone += size;
+        return size;
     }
 
     void setMountFails(bool fails) {
@@ -209,6 +257,9 @@ private:
     std::map<std::string, std::vector<uint8_t>> files;
     bool mounted = false;
     bool mountFails = false;
+    bool writesLimited = false;
+    size_t writeBudget = 0;
+    size_t writesDone = 0;
 
     friend class File;
 };
@@ -233,6 +284,28 @@ inline void File::close() {
     }
 }
 
+// File::write() implementation: counts against MockLittleFS::failWritesAfter()
+inline size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!data || !data->isOpen || !buffer) return 0;
+    bool append = data->mode.find('a') != std::string::npos;
+    if (!append && data->mode.find('w') == std::string::npos) return 0;
+    if (data->fs) size = data->fs->spendWrite(size);
+
+    MockHeap::Untracked untracked;
+    if (append) {
+        data->binaryData.insert(data->binaryData.end(), buffer, buffer + size);
+        return size;
+    }
+    // Written at the position, overwriting what is there after a seek()
+    size_t end = data->position + size;
+    if (end > data->binaryData.size()) {
+        data->binaryData.resize(end);
+    }
+    std::copy(buffer, buffer + size, data->binaryData.begin() + data->position);
+    data->position = end;
+    return size;
+}
+
 extern MockLittleFS LittleFS;
 
 #endif // MOCK_LITTLEFS_H
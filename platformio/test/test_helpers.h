@@ -0,0 +1,122 @@
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mock_arduino.h"
+#include "mock_littlefs.h"
+#include "calendar_event.h"
+#include "timezone_engine.h"
+
+/**
+ * Helpers shared by the native test suites
+ *
+ * Times are built in UTC whatever the TZ of the test run, and fixtures are
+ * read from test/fixtures relative to the platformio directory, where the
+ * test binary runs. The event cache suites share one event factory, so
+ * that they all store the same fields.
+ */
+
+// UTC timestamp for a calendar date and time
+inline time_t utcFor(int year, int month, int day, int hour, int minute) {
+    struct tm fields;
+    memset(&fields, 0, sizeof(fields));
+    POPULATE_TM_DATE_TIME(fields, year, month, day, hour, minute, 0, 0);
+    return TimeZoneEngine::makeUtc(fields);
+}
+
+// Whole content of a fixture file (empty if it cannot be read)
+inline std::string loadFixture(const char* filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// Byte offsets in the event cache file header (the same in formats v5 and v6)
+const size_t CACHE_VERSION_OFFSET        = 4;
+const size_t CACHE_EVENT_COUNT_OFFSET    = 8;
+const size_t CACHE_URL_LENGTH_OFFSET     = 22;
+const size_t CACHE_GENERATION_OFFSET     = 32;
+const size_t CACHE_PAYLOAD_LENGTH_OFFSET = 36;
+const size_t CACHE_CHECKSUM_OFFSET       = 40;
+const size_t CACHE_HEADER_SIZE           = 44;
+
+const time_t TEST_MONDAY = 1773014400; // 2026-03-09 00:00 UTC
+
+/**
+ * @brief An event of the "Team" calendar, with every field the parser sets
+ *
+ * @param duration Seconds from start to end; 0 for an event without end time
+ */
+inline CalendarEvent* testEvent(const String& title, time_t start, time_t duration = 1800) {
+    struct tm day;
+    gmtime_r(&start, &day);
+    char date[16];
+    strftime(date, sizeof(date), "%Y-%m-%d", &day);
+
+    CalendarEvent* event = new CalendarEvent();
+    event->title         = title;
+    event->summary       = title;
+    event->location      = "Room " + String((int)(start / 3600 % 40));
+    event->date          = date;
+    event->calendarName  = "Team";
+    event->calendarColor = "#0b8043";
+    event->startTime     = start;
+    event->endTime       = duration > 0 ? start + duration : 0;
+    event->dayOfMonth    = day.tm_mday;
+    return event;
+}
+
+// count events titled "<prefix> <n>", one every spacing seconds from TEST_MONDAY
+inline std::vector<CalendarEvent*> testEvents(const char* prefix, size_t count, time_t spacing = 3600,
+                                              time_t duration = 1800) {
+    std::vector<CalendarEvent*> events;
+    for (size_t i = 0; i < count; i++) {
+        events.push_back(testEvent(String(prefix) + " " + String((int)i), TEST_MONDAY + i * spacing, duration));
+    }
+    return events;
+}
+
+inline void deleteAll(std::vector<CalendarEvent*>& events) {
+    for (size_t i = 0; i < events.size(); i++) {
+        delete events[i];
+    }
+    events.clear();
+}
+
+inline std::vector<String> titlesOf(const std::vector<CalendarEvent*>& events) {
+    std::vector<String> titles;
+    for (size_t i = 0; i < events.size(); i++) {
+        titles.push_back(events[i]->title);
+    }
+    return titles;
+}
+
+inline std::vector<uint8_t> readFile(const char* path) {
+    File file = LittleFS.open(path, "r");
+    std::vector<uint8_t> bytes(file.size());
+    file.read(bytes.data(), bytes.size());
+    file.close();
+    return bytes;
+}
+
+inline void writeFile(const char* path, const std::vector<uint8_t>& bytes) {
+    File file = LittleFS.open(path, "w");
+    file.write(bytes.data(), bytes.size());
+    file.close();
+}
+
+// A value stored at offset in bytes (e.g. one of the CACHE_*_OFFSET fields)
+template <typename T> T fieldAt(const std::vector<uint8_t>& bytes, size_t offset) {
+    T value;
+    memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+#endif // TEST_HELPERS_H
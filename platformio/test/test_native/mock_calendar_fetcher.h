@@ -2,32 +2,311 @@
 #define MOCK_CALENDAR_FETCHER_H
 
 #include "mock_arduino.h"
+#include "connection_pool.h"
+#include "feed_tail.h"
+#include "fetch_telemetry.h"
+#include "http_body_stream.h"
+#include "http_validators.h"
+#include "inflate_stream.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * Mock HTTP server for native testing
+ * Serves calendar bodies by URL with ETag / Last-Modified validators and
+ * answers conditional requests the way a real server would (304 when the
+ * validators still match). Bodies may be stored pre-compressed with a
+ * Content-Encoding, and sent with chunked transfer coding. Range requests
+ * are answered with 206 Partial Content (or 416 past the end) unless
+ * ignoreRange is set. Counts requests and body bytes sent.
+ */
+class MockHttpServer {
+public:
+    struct Resource {
+        String body;
+        String etag;
+        String lastModified;
+        String encoding; // Content-Encoding of body ("" for identity)
+    };
+
+    static MockHttpServer& instance() {
+        static MockHttpServer server;
+        return server;
+    }
+
+    // Publish (or replace) the resource served at url
+    void setResource(const String& url, const String& body, const String& etag, const String& lastModified,
+                     const String& encoding = "") {
+        Resource resource;
+        resource.body = body;
+        resource.etag = etag;
+        resource.lastModified = lastModified;
+        resource.encoding = encoding;
+        resources[url.c_str()] = resource;
+    }
+
+    const Resource* find(const String& url) const {
+        std::map<std::string, Resource>::const_iterator it = resources.find(url.c_str());
+        return it != resources.end() ? &it->second : nullptr;
+    }
+
+    // If-None-Match wins over If-Modified-Since when both are sent
+    static bool notModified(const Resource& resource, const HttpValidators& request) {
+        if (!request.etag.isEmpty()) {
+            return request.etag == resource.etag;
+        }
+        return !request.lastModified.isEmpty() && request.lastModified == resource.lastModified;
+    }
+
+    void reset() {
+        resources.clear();
+        requests = 0;
+        notModifiedResponses = 0;
+        bytesSent = 0;
+        chunkedTransfer = false;
+        ignoreRange = false;
+        closeDelimited = false;
+        cutBodyAt = 0;
+        rangeRequests = 0;
+        partialResponses = 0;
+        lastRequest = HttpValidators();
+    }
+
+    // Traffic counters
+    size_t requests;
+    size_t notModifiedResponses;
+    size_t bytesSent;
+    size_t rangeRequests;
+    size_t partialResponses;
+    HttpValidators lastRequest; // Conditional headers of the last request
+
+    // Send bodies of keep-alive responses chunked instead of with a Content-Length
+    bool chunkedTransfer;
+
+    // Answer Range requests with the full body (200), like servers without range support
+    bool ignoreRange;
+
+    // Answer requests without a pool with no Content-Length (the body ends when the connection closes)
+    bool closeDelimited;
+
+    // Stop every body after this many bytes, as a dropped connection would (0 = send it all)
+    size_t cutBodyAt;
+
+    // Held while a request is served (fetchers may run on concurrent workers)
+    std::mutex mutex;
+
+    // Body with chunked transfer coding, in chunks of at most chunkSize bytes
+    static String chunk(const String& body, size_t chunkSize) {
+        std::string framed;
+        std::string data(body.c_str(), body.length());
+        for (size_t offset = 0; offset < data.size(); offset += chunkSize) {
+            size_t length = std::min(chunkSize, data.size() - offset);
+            char header[16];
+            snprintf(header, sizeof(header), "%zx\r\n", length);
+            framed += header;
+            framed.append(data, offset, length);
+            framed += "\r\n";
+        }
+        framed += "0\r\n\r\n";
+        return String(framed);
+    }
+
+private:
+    MockHttpServer()
+        : requests(0), notModifiedResponses(0), bytesSent(0), rangeRequests(0), partialResponses(0),
+          chunkedTransfer(false), ignoreRange(false), closeDelimited(false), cutBodyAt(0) {}
+
+    std::map<std::string, Resource> resources;
+};
 
 /**
  * Mock CalendarFetcher for native testing
- * Provides minimal stub implementation to satisfy CalendarStreamParser
- * Does not actually fetch from network or files
+ * Fetches remote URLs from MockHttpServer instead of the network. With a
+ * connection pool, every request borrows a connection the way the real
+ * fetcher does and keep-alive bodies are framed through HttpBodyStream.
+ * Resumed downloads check Content-Range and the anchor like the real fetcher
+ * and fall back to a full request when they do not match.
  */
 class CalendarFetcher {
 private:
     bool debug;
+    int lastHttpCode;
+    HttpValidators responseValidators;
+    StringStream* stream;
+    InflateStream* inflater;
+    ConnectionPool* pool;
+    PooledConnection* connection;
+    HttpBodyStream* body;
+    bool compression;
+    bool partialContent;
+    int contentLength;
+    FetchTimings timings;
 
 public:
-    CalendarFetcher() : debug(false) {}
-    ~CalendarFetcher() {}
+    CalendarFetcher()
+        : debug(false), lastHttpCode(0), stream(nullptr), inflater(nullptr), pool(nullptr), connection(nullptr),
+          body(nullptr), compression(true), partialContent(false), contentLength(-1) {}
+    ~CalendarFetcher() { endStream(); }
 
     // Configuration
     void setTimeout(int timeoutMs) { (void)timeoutMs; }
     void setDebug(bool enable) { debug = enable; }
+    void setConnectionPool(ConnectionPool* connectionPool) { pool = connectionPool; }
+    void setCompression(bool enable) { compression = enable; }
+
+    // Stream-based fetching from the mock server
+    Stream* fetchStream(const String& url, const HttpValidators* validators = nullptr,
+                        const FeedTail* resume = nullptr) {
+        endStream();
+        lastHttpCode = 0;
+        responseValidators = HttpValidators();
+        partialContent = false;
+        contentLength = -1;
+        timings = FetchTimings();
+
+        const FeedTail* range = resume && resume->isValid() ? resume : nullptr;
+        for (;;) {
+            if (pool) {
+                connection = pool->acquire(url);
+                if (!connection) {
+                    return nullptr;
+                }
+                timings = FetchTimings();
+                timings.reused = connection->requests > 1;
+                if (!timings.reused) {
+                    timings.connectMs = connection->connectMs;
+                }
+            }
 
-    // Stream-based fetching - returns nullptr in mock
-    Stream* fetchStream(const String& url) {
-        (void)url;
-        return nullptr;
+            MockHttpServer& server = MockHttpServer::instance();
+            std::unique_lock<std::mutex> lock(server.mutex);
+            server.requests++;
+            server.lastRequest = validators ? *validators : HttpValidators();
+
+            const MockHttpServer::Resource* resource = server.find(url);
+            if (!resource) {
+                lastHttpCode = HTTP_CODE_NOT_FOUND;
+                releaseConnection(false);
+                return nullptr;
+            }
+            if (validators && MockHttpServer::notModified(*resource, *validators)) {
+                server.notModifiedResponses++;
+                lastHttpCode = HTTP_CODE_NOT_MODIFIED;
+                releaseConnection(true);
+                return nullptr;
+            }
+
+            String content = resource->body;
+            String encoding = resource->encoding;
+            String contentRange;
+            lastHttpCode = HTTP_CODE_OK;
+            if (range) {
+                server.rangeRequests++;
+            }
+            if (range && !server.ignoreRange) {
+                size_t first = range->rangeStart();
+                if (first >= content.length()) {
+                    lastHttpCode = HTTP_CODE_RANGE_NOT_SATISFIABLE;
+                    releaseConnection(false);
+                    lock.unlock();
+                    range = nullptr;
+                    continue;
+                }
+                lastHttpCode = HTTP_CODE_PARTIAL_CONTENT;
+                server.partialResponses++;
+                contentRange = "bytes " + String((unsigned long)first) + "-" +
+                               String((unsigned long)(content.length() - 1)) + "/" +
+                               String((unsigned long)content.length());
+                content = content.substring(first);
+            }
+
+            responseValidators.etag = resource->etag;
+            responseValidators.lastModified = resource->lastModified;
+            int announced = (int)content.length();
+            if (server.cutBodyAt > 0 && server.cutBodyAt < content.length()) {
+                content = content.substring(0, server.cutBodyAt);
+            }
+            server.bytesSent += content.length();
+            Stream* response;
+            if (connection && server.chunkedTransfer) {
+                stream = new StringStream(MockHttpServer::chunk(content, 4000));
+                body = new HttpBodyStream(stream, -1, true);
+                response = body;
+            } else if (connection) {
+                stream = new StringStream(content);
+                body = new HttpBodyStream(stream, announced, false);
+                response = body;
+                contentLength = announced;
+            } else {
+                stream = new StringStream(content);
+                response = stream;
+                contentLength = server.closeDelimited ? -1 : announced;
+            }
+            lock.unlock();
+
+            if (lastHttpCode == HTTP_CODE_PARTIAL_CONTENT) {
+                size_t first = 0;
+                size_t total = 0;
+                bool resumable = encoding.isEmpty() &&
+                                 FeedTail::parseContentRange(contentRange, first, total) &&
+                                 first == range->rangeStart() && (total == 0 || total >= range->length) &&
+                                 range->matchesAnchor(response);
+                if (!resumable) {
+                    endStream();
+                    range = nullptr;
+                    continue;
+                }
+                partialContent = true;
+                return response;
+            }
+
+            InflateStream::Format format;
+            if (InflateStream::formatForEncoding(encoding, format)) {
+                inflater = new InflateStream(response, format);
+                return inflater;
+            }
+            return response;
+        }
     }
 
     void endStream() {
-        // No-op in mock
+        delete inflater;
+        inflater = nullptr;
+        if (connection) {
+            releaseConnection(body && body->drain(HTTP_POOL_DRAIN_LIMIT));
+        }
+        delete body;
+        body = nullptr;
+        delete stream;
+        stream = nullptr;
+    }
+
+    void releaseConnection(bool reusable) {
+        if (!connection) {
+            return;
+        }
+        if (!reusable) {
+            connection->client->stop();
+        }
+        pool->release(connection, reusable);
+        connection = nullptr;
+    }
+
+    int getLastHttpCode() const { return lastHttpCode; }
+    const HttpValidators& getResponseValidators() const { return responseValidators; }
+    bool isPartialContent() const { return partialContent; }
+    int getContentLength() const { return contentLength; }
+    const FetchTimings& getLastTimings() const { return timings; }
+    bool isEncoded() const { return inflater != nullptr; }
+    size_t getCompressedBytes() const { return inflater ? inflater->getCompressedBytes() : 0; }
+    const char* getStreamError() const {
+        if (inflater && inflater->hasError()) {
+            return inflater->getError();
+        }
+        return body ? body->getError() : nullptr;
     }
 };
 
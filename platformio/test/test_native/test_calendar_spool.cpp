@@ -0,0 +1,305 @@
+/**
+ * @file test_calendar_spool.cpp
+ * @brief Tests for spooling large calendar bodies to flash before parsing
+ *
+ * Tests cover:
+ * - Bodies at or above the size threshold are written to the spool file
+ *   unparsed, and parsed later with the same result as a direct parse
+ * - Smaller bodies are still parsed as they arrive
+ * - Bodies of unknown length (chunked) count as large
+ * - Spooled partial downloads of incremental feeds keep the feed tail
+ * - Bodies cut short fail instead of leaving half a calendar to parse: short
+ *   of their Content-Length, or without END:VCALENDAR when it is unknown
+ * - 304 responses leave no spool file; remove() deletes it with the cache
+ */
+
+#include <doctest.h>
+#include <string>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "connection_pool.h"
+#include "event_cache.h"
+#include "feed_tail.h"
+#include "mock_calendar_fetcher.h"
+#include "timezone_engine.h"
+
+namespace {
+
+const char* const FEED_URL = "https://rooms.example.com/calendar.ics";
+const char* const CACHE_PATH = "/cache/events_spool.bin";
+const char* const SPOOL_PATH = "/cache/events_spool.ics";
+
+const char* const FEED_FOOTER = "END:VCALENDAR\r\n";
+
+// One event per hour of March 2026, from 08:00 to 17:00
+String roomFeed(int days) {
+    String ics = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Test//Rooms//EN\r\n";
+    char text[256];
+    for (int day = 1; day <= days; day++) {
+        for (int hour = 8; hour < 18; hour++) {
+            snprintf(text, sizeof(text),
+                     "BEGIN:VEVENT\r\nUID:room-%d-%d@example.com\r\nDTSTART:202603%02dT%02d0000Z\r\n"
+                     "DTEND:202603%02dT%02d3000Z\r\nSUMMARY:Meeting %d/%d\r\nEND:VEVENT\r\n",
+                     day, hour, day, hour, day, hour, day, hour);
+            ics += text;
+        }
+    }
+    ics += FEED_FOOTER;
+    return ics;
+}
+
+FilteredEvents* fetchMarch(CalendarStreamParser& parser, const HttpValidators* validators = nullptr,
+                           const FeedTail* resume = nullptr) {
+    return parser.fetchEventsInRange(FEED_URL, utcFor(2026, 3, 1, 0, 0), utcFor(2026, 4, 1, 0, 0), 0, "",
+                                     validators, resume);
+}
+
+FilteredEvents* parseMarch(CalendarStreamParser& parser) {
+    return parser.parseSpooledEvents(utcFor(2026, 3, 1, 0, 0), utcFor(2026, 4, 1, 0, 0), 0);
+}
+
+size_t spoolSize() {
+    File file = LittleFS.open(SPOOL_PATH, "r");
+    if (!file) {
+        return 0;
+    }
+    size_t size = file.size();
+    file.close();
+    return size;
+}
+
+void resetServer() {
+    MockHttpServer::instance().reset();
+    LittleFS.remove(SPOOL_PATH);
+}
+
+} // namespace
+
+TEST_SUITE("Spooling - Downloads")
+{
+    TEST_CASE("Large bodies are spooled and parsed later like a direct parse")
+    {
+        resetServer();
+        String ics = roomFeed(20);
+        MockHttpServer::instance().setResource(FEED_URL, ics, "\"r1\"", "");
+
+        CalendarStreamParser direct;
+        FilteredEvents* expected = fetchMarch(direct);
+        REQUIRE(expected->success);
+        REQUIRE(expected->events.size() == 200);
+        CHECK_FALSE(expected->spooled);
+
+        CalendarStreamParser parser;
+        parser.setSpool(SPOOL_PATH, ics.length());
+        FilteredEvents* downloaded = fetchMarch(parser);
+        REQUIRE(downloaded->success);
+        CHECK(downloaded->spooled);
+        CHECK(parser.wasSpooled());
+        CHECK(downloaded->events.empty());
+        CHECK(downloaded->bytesTransferred == ics.length());
+        CHECK(downloaded->validators.etag == "\"r1\"");
+        CHECK(spoolSize() == ics.length());
+        delete downloaded;
+
+        // No request is needed to parse the spooled body
+        size_t requests = MockHttpServer::instance().requests;
+        FilteredEvents* parsed = parseMarch(parser);
+        REQUIRE(parsed->success);
+        CHECK(MockHttpServer::instance().requests == requests);
+        CHECK(parsed->validators.etag == "\"r1\"");
+        CHECK(parsed->totalParsed == expected->totalParsed);
+        REQUIRE(parsed->events.size() == expected->events.size());
+        for (size_t i = 0; i < parsed->events.size(); i++) {
+            CHECK(parsed->events[i]->summary == expected->events[i]->summary);
+            CHECK(parsed->events[i]->startTime == expected->events[i]->startTime);
+        }
+        CHECK_FALSE(LittleFS.exists(SPOOL_PATH));
+        delete parsed;
+        delete expected;
+
+        // The spool file is gone: nothing left to parse
+        FilteredEvents* again = parseMarch(parser);
+        CHECK_FALSE(again->success);
+        delete again;
+    }
+
+    TEST_CASE("Bodies below the threshold are parsed as they arrive")
+    {
+        resetServer();
+        String ics = roomFeed(2);
+        MockHttpServer::instance().setResource(FEED_URL, ics, "", "");
+
+        CalendarStreamParser parser;
+        parser.setSpool(SPOOL_PATH, ics.length() + 1);
+        FilteredEvents* result = fetchMarch(parser);
+        REQUIRE(result->success);
+        CHECK_FALSE(result->spooled);
+        CHECK_FALSE(parser.wasSpooled());
+        CHECK(result->events.size() == 20);
+        CHECK_FALSE(LittleFS.exists(SPOOL_PATH));
+        delete result;
+
+        // An empty path turns spooling off
+        parser.setSpool("", 0);
+        result = fetchMarch(parser);
+        CHECK_FALSE(result->spooled);
+        CHECK(result->events.size() == 20);
+        delete result;
+    }
+
+    TEST_CASE("Bodies of unknown length count as large")
+    {
+        resetServer();
+        String ics = roomFeed(3);
+        MockHttpServer& server = MockHttpServer::instance();
+        server.setResource(FEED_URL, ics, "", "");
+        server.chunkedTransfer = true;
+
+        ConnectionPool pool(2);
+        CalendarStreamParser parser;
+        parser.setConnectionPool(&pool);
+        parser.setSpool(SPOOL_PATH, ics.length() * 100);
+        FilteredEvents* downloaded = fetchMarch(parser);
+        REQUIRE(downloaded->success);
+        CHECK(downloaded->spooled);
+        CHECK(spoolSize() == ics.length());
+        delete downloaded;
+        parser.setConnectionPool(nullptr);
+
+        FilteredEvents* parsed = parseMarch(parser);
+        REQUIRE(parsed->success);
+        CHECK(parsed->events.size() == 30);
+        delete parsed;
+    }
+
+    TEST_CASE("Spooled partial downloads continue the feed tail")
+    {
+        resetServer();
+        MockHttpServer& server = MockHttpServer::instance();
+        String first = roomFeed(5);
+        server.setResource(FEED_URL, first, "", "");
+
+        CalendarStreamParser parser;
+        parser.setIncremental(true);
+        parser.setSpool(SPOOL_PATH, 0);
+        FilteredEvents* downloaded = fetchMarch(parser);
+        REQUIRE(downloaded->success);
+        REQUIRE(downloaded->spooled);
+        delete downloaded;
+        FilteredEvents* full = parseMarch(parser);
+        REQUIRE(full->success);
+        CHECK(full->events.size() == 50);
+        REQUIRE(full->tail.isValid());
+        CHECK(full->tail.length == first.length());
+        FeedTail tail = full->tail;
+        delete full;
+
+        String appended = "BEGIN:VEVENT\r\nUID:late@example.com\r\nDTSTART:20260320T190000Z\r\n"
+                          "DTEND:20260320T200000Z\r\nSUMMARY:Late meeting\r\nEND:VEVENT\r\n";
+        String second = first.substring(0, first.length() - strlen(FEED_FOOTER)) + appended + FEED_FOOTER;
+        server.setResource(FEED_URL, second, "", "");
+
+        downloaded = fetchMarch(parser, nullptr, &tail);
+        REQUIRE(downloaded->success);
+        CHECK(downloaded->spooled);
+        CHECK(downloaded->partial);
+        CHECK(downloaded->bytesTransferred == second.length() - tail.rangeStart());
+        delete downloaded;
+
+        FilteredEvents* partial = parseMarch(parser);
+        REQUIRE(partial->success);
+        CHECK(partial->partial);
+        REQUIRE(partial->events.size() == 1);
+        CHECK(partial->events[0]->summary == "Late meeting");
+        CHECK(partial->tail.length == second.length());
+        CHECK(partial->tail.offset == second.length() - strlen(FEED_FOOTER));
+        delete partial;
+    }
+
+    TEST_CASE("A body short of its Content-Length is not spooled")
+    {
+        resetServer();
+        String ics = roomFeed(10);
+        MockHttpServer& server = MockHttpServer::instance();
+        server.setResource(FEED_URL, ics, "", "");
+        // Cut right after an event: the part received parses cleanly
+        server.cutBodyAt = ics.indexOf("BEGIN:VEVENT", ics.length() / 2);
+
+        CalendarStreamParser parser;
+        parser.setSpool(SPOOL_PATH, 0);
+        FilteredEvents* downloaded = fetchMarch(parser);
+        CHECK_FALSE(downloaded->success);
+        CHECK_FALSE(downloaded->spooled);
+        CHECK_FALSE(LittleFS.exists(SPOOL_PATH));
+        delete downloaded;
+
+        // Not a flash failure: the next attempt is spooled again
+        server.cutBodyAt = 0;
+        downloaded = fetchMarch(parser);
+        REQUIRE(downloaded->success);
+        CHECK(downloaded->spooled);
+        CHECK(spoolSize() == ics.length());
+        delete downloaded;
+        LittleFS.remove(SPOOL_PATH);
+    }
+
+    TEST_CASE("A body of unknown length must end with END:VCALENDAR")
+    {
+        resetServer();
+        String ics = roomFeed(10);
+        MockHttpServer& server = MockHttpServer::instance();
+        server.setResource(FEED_URL, ics, "", "");
+        server.closeDelimited = true;
+        server.cutBodyAt = ics.indexOf("BEGIN:VEVENT", ics.length() / 2);
+
+        CalendarStreamParser parser;
+        parser.setSpool(SPOOL_PATH, 0);
+        FilteredEvents* downloaded = fetchMarch(parser);
+        CHECK_FALSE(downloaded->success);
+        CHECK_FALSE(LittleFS.exists(SPOOL_PATH));
+        delete downloaded;
+
+        server.cutBodyAt = 0;
+        downloaded = fetchMarch(parser);
+        REQUIRE(downloaded->success);
+        CHECK(downloaded->spooled);
+        delete downloaded;
+
+        FilteredEvents* parsed = parseMarch(parser);
+        REQUIRE(parsed->success);
+        CHECK(parsed->events.size() == 100);
+        delete parsed;
+    }
+
+    TEST_CASE("Not modified responses are not spooled")
+    {
+        resetServer();
+        String ics = roomFeed(2);
+        MockHttpServer::instance().setResource(FEED_URL, ics, "\"same\"", "");
+
+        CalendarStreamParser parser;
+        parser.setSpool(SPOOL_PATH, 0);
+        HttpValidators validators;
+        validators.etag = "\"same\"";
+        FilteredEvents* result = fetchMarch(parser, &validators);
+        REQUIRE(result->success);
+        CHECK(result->notModified);
+        CHECK_FALSE(result->spooled);
+        CHECK_FALSE(LittleFS.exists(SPOOL_PATH));
+        delete result;
+    }
+
+    TEST_CASE("The spool file sits next to the cache and is removed with it")
+    {
+        CHECK(EventCache::getSpoolPath(CACHE_PATH) == SPOOL_PATH);
+
+        File file = LittleFS.open(SPOOL_PATH, "w");
+        file.write((const uint8_t*)"BEGIN:VCALENDAR", 15);
+        file.close();
+        REQUIRE(LittleFS.exists(SPOOL_PATH));
+        EventCache::remove(CACHE_PATH);
+        CHECK_FALSE(LittleFS.exists(SPOOL_PATH));
+    }
+}
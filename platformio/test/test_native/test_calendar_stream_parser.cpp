@@ -1,6 +1,7 @@
 #include <doctest.h>
 #include <ctime>
 #include <cstring>
+#include <initializer_list>
 #include <set>
 
 // Mock Arduino environment for native testing
@@ -427,7 +428,7 @@ END:VEVENT
 END:VCALENDAR
 )";
 
-        StringStream stream(String(icsData));
+        StringStream stream((String(icsData)));
         CalendarStreamParser parser;
 
         std::vector<CalendarEvent*> parsedEvents;
@@ -587,93 +588,90 @@ TEST_SUITE("CalendarStreamParser - RRULE Parser")
     }
 }
 
-TEST_SUITE("CalendarStreamParser - RRULE Helper Methods")
+// Compile an RRULE the way the parser does before expanding it
+CompiledRRule compileRRule(CalendarStreamParser& parser, const String& rrule)
+{
+    CompiledRRule compiled;
+    compiled.compile(parser.parseRRule(rrule));
+    return compiled;
+}
+
+// Bit mask of the given values
+uint64_t bits(std::initializer_list<int> values)
+{
+    uint64_t mask = 0;
+    for (int value : values) {
+        mask |= 1ull << value;
+    }
+    return mask;
+}
+
+TEST_SUITE("CalendarStreamParser - Compiled BYxxx Lists")
 {
     CalendarStreamParser parser;
 
-    TEST_CASE("Parse BYDAY - Single Day")
+    TEST_CASE("BYDAY - Single Day")
     {
-        std::vector<int> days = parser.parseByDay("MO");
-
-        CHECK(days.size() == 1);
-        CHECK(days[0] == 1); // Monday
+        CompiledRRule rule = compileRRule(parser, "FREQ=WEEKLY;BYDAY=MO");
+        CHECK(rule.has(CompiledRRule::BY_DAY));
+        CHECK(rule.byWeekday == bits({ 1 })); // Monday
     }
 
-    TEST_CASE("Parse BYDAY - Multiple Days")
+    TEST_CASE("BYDAY - Multiple Days")
     {
-        std::vector<int> days = parser.parseByDay("MO,WE,FR");
-
-        CHECK(days.size() == 3);
-        CHECK(days[0] == 1); // Monday
-        CHECK(days[1] == 3); // Wednesday
-        CHECK(days[2] == 5); // Friday
+        CompiledRRule rule = compileRRule(parser, "FREQ=WEEKLY;BYDAY=MO,WE,FR");
+        CHECK(rule.byWeekday == bits({ 1, 3, 5 }));
     }
 
-    TEST_CASE("Parse BYDAY - All Days")
+    TEST_CASE("BYDAY - All Days")
     {
-        std::vector<int> days = parser.parseByDay("SU,MO,TU,WE,TH,FR,SA");
-
-        CHECK(days.size() == 7);
-        CHECK(days[0] == 0); // Sunday
-        CHECK(days[6] == 6); // Saturday
+        CompiledRRule rule = compileRRule(parser, "FREQ=WEEKLY;BYDAY=SU,MO,TU,WE,TH,FR,SA");
+        CHECK(rule.byWeekday == 0x7F);
     }
 
-    TEST_CASE("Parse BYDAY - Empty String")
+    TEST_CASE("BYDAY - Empty String")
     {
-        std::vector<int> days = parser.parseByDay("");
-
-        CHECK(days.size() == 0);
+        CompiledRRule rule = compileRRule(parser, "FREQ=WEEKLY;BYDAY=");
+        CHECK_FALSE(rule.has(CompiledRRule::BY_DAY));
+        CHECK(rule.isSimple());
     }
 
-    TEST_CASE("Parse BYMONTHDAY - Single Day")
+    TEST_CASE("BYMONTHDAY - Single Day")
     {
-        std::vector<int> days = parser.parseByMonthDay("15");
-
-        CHECK(days.size() == 1);
-        CHECK(days[0] == 15);
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYMONTHDAY=15");
+        CHECK(rule.byMonthDay == bits({ 15 }));
+        CHECK(rule.byMonthDayNeg == 0);
     }
 
-    TEST_CASE("Parse BYMONTHDAY - Multiple Days")
+    TEST_CASE("BYMONTHDAY - Multiple Days")
     {
-        std::vector<int> days = parser.parseByMonthDay("1,15,30");
-
-        CHECK(days.size() == 3);
-        CHECK(days[0] == 1);
-        CHECK(days[1] == 15);
-        CHECK(days[2] == 30);
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYMONTHDAY=1,15,30");
+        CHECK(rule.byMonthDay == bits({ 1, 15, 30 }));
     }
 
-    TEST_CASE("Parse BYMONTHDAY - Negative (Last Day)")
+    TEST_CASE("BYMONTHDAY - Negative (Last Day)")
     {
-        std::vector<int> days = parser.parseByMonthDay("-1");
-
-        CHECK(days.size() == 1);
-        CHECK(days[0] == -1);
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYMONTHDAY=-1");
+        CHECK(rule.byMonthDay == 0);
+        CHECK(rule.byMonthDayNeg == bits({ 1 }));
     }
 
-    TEST_CASE("Parse BYMONTH - Single Month")
+    TEST_CASE("BYMONTH - Single Month")
     {
-        std::vector<int> months = parser.parseByMonth("7");
-
-        CHECK(months.size() == 1);
-        CHECK(months[0] == 7);
+        CompiledRRule rule = compileRRule(parser, "FREQ=YEARLY;BYMONTH=7");
+        CHECK(rule.byMonth == bits({ 7 }));
     }
 
-    TEST_CASE("Parse BYMONTH - Multiple Months")
+    TEST_CASE("BYMONTH - Multiple Months")
     {
-        std::vector<int> months = parser.parseByMonth("1,7,12");
-
-        CHECK(months.size() == 3);
-        CHECK(months[0] == 1); // January
-        CHECK(months[1] == 7); // July
-        CHECK(months[2] == 12); // December
+        CompiledRRule rule = compileRRule(parser, "FREQ=YEARLY;BYMONTH=1,7,12");
+        CHECK(rule.byMonth == bits({ 1, 7, 12 }));
     }
 
-    TEST_CASE("Parse BYMONTH - Invalid Month Filtered")
+    TEST_CASE("BYMONTH - Invalid Month Filtered")
     {
-        std::vector<int> months = parser.parseByMonth("0,13,15");
-
-        CHECK(months.size() == 0); // All invalid
+        CompiledRRule rule = compileRRule(parser, "FREQ=YEARLY;BYMONTH=0,13,15");
+        CHECK(rule.byMonth == 0); // All invalid
     }
 }
 
@@ -834,6 +832,29 @@ TEST_SUITE("CalendarStreamParser - UNTIL Date Parsing")
         CHECK(tm->tm_mday == 31);
     }
 
+    TEST_CASE("Parse UNTIL - UTC value is not shifted by the local offset")
+    {
+        // Local time 9 hours ahead of UTC all year
+        char* savedTZ = getenv("TZ");
+        String savedTZStr = savedTZ ? String(savedTZ) : "";
+        setenv("TZ", "JST-9", 1);
+        tzset();
+
+        // 2025-12-31 23:59:59 UTC, whatever the local zone
+        CHECK(parser.parseUntilDate("20251231T235959Z") == 1767225599);
+        CHECK(parser.parseUntilDate("20250615T120000Z") == 1749988800);
+
+        // Without 'Z' the value is local: 9 hours earlier in UTC
+        CHECK(parser.parseUntilDate("20251231T235959") == 1767225599 - 9 * 3600);
+
+        if (!savedTZStr.isEmpty()) {
+            setenv("TZ", savedTZStr.c_str(), 1);
+        } else {
+            unsetenv("TZ");
+        }
+        tzset();
+    }
+
     TEST_CASE("Parse UNTIL - Empty string")
     {
         time_t until = parser.parseUntilDate("");
@@ -877,67 +898,58 @@ TEST_SUITE("CalendarStreamParser - BYDAY Advanced")
 {
     CalendarStreamParser parser;
 
-    TEST_CASE("Parse BYDAY - With position prefix (1MO)")
+    TEST_CASE("BYDAY - With position prefix (1MO)")
     {
-        std::vector<int> days = parser.parseByDay("1MO");
-
-        // Position prefix is ignored for now, just extract day code
-        CHECK(days.size() == 1);
-        CHECK(days[0] == 1); // Monday
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYDAY=1MO");
+        CHECK(rule.has(CompiledRRule::BY_DAY_NTH));
+        CHECK(rule.byWeekday == 0);
+        CHECK(rule.byWeekdayNth[1] == bits({ 1 })); // First Monday
     }
 
-    TEST_CASE("Parse BYDAY - Multiple with positions (1MO,-1FR)")
+    TEST_CASE("BYDAY - Multiple with positions (1MO,-1FR)")
     {
-        std::vector<int> days = parser.parseByDay("1MO,-1FR");
-
-        CHECK(days.size() == 2);
-        CHECK(days[0] == 1); // Monday
-        CHECK(days[1] == 5); // Friday
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYDAY=1MO,-1FR");
+        CHECK(rule.byWeekdayNth[1] == bits({ 1 }));
+        CHECK(rule.byWeekdayNthNeg[5] == bits({ 1 })); // Last Friday
     }
 
-    TEST_CASE("Parse BYDAY - Mixed with and without positions")
+    TEST_CASE("BYDAY - Mixed with and without positions")
     {
-        std::vector<int> days = parser.parseByDay("MO,2WE,FR");
-
-        CHECK(days.size() == 3);
-        CHECK(days[0] == 1); // Monday
-        CHECK(days[1] == 3); // Wednesday
-        CHECK(days[2] == 5); // Friday
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYDAY=MO,2WE,FR");
+        CHECK(rule.byWeekday == bits({ 1, 5 }));
+        CHECK(rule.byWeekdayNth[3] == bits({ 2 })); // Second Wednesday
     }
 
-    TEST_CASE("Parse BYDAY - Invalid day code ignored")
+    TEST_CASE("BYDAY - Position prefix ignored for WEEKLY")
     {
-        std::vector<int> days = parser.parseByDay("MO,XX,FR");
-
-        CHECK(days.size() == 2); // Only MO and FR
-        CHECK(days[0] == 1);
-        CHECK(days[1] == 5);
+        CompiledRRule rule = compileRRule(parser, "FREQ=WEEKLY;BYDAY=1MO,-1FR");
+        CHECK_FALSE(rule.has(CompiledRRule::BY_DAY_NTH));
+        CHECK(rule.byWeekday == bits({ 1, 5 }));
     }
 
-    TEST_CASE("Parse BYDAY - Spaces in list")
+    TEST_CASE("BYDAY - Invalid day code ignored")
     {
-        std::vector<int> days = parser.parseByDay("MO, WE, FR");
-
-        // Should handle spaces after commas
-        CHECK(days.size() == 3);
+        CompiledRRule rule = compileRRule(parser, "FREQ=WEEKLY;BYDAY=MO,XX,FR");
+        CHECK(rule.byWeekday == bits({ 1, 5 })); // Only MO and FR
     }
 
-    TEST_CASE("Parse BYDAY - Trailing comma")
+    TEST_CASE("BYDAY - Spaces in list")
     {
-        std::vector<int> days = parser.parseByDay("MO,WE,");
-
-        CHECK(days.size() == 2);
+        CompiledRRule rule = compileRRule(parser, "FREQ=WEEKLY;BYDAY=MO, WE, FR");
+        CHECK(rule.byWeekday == bits({ 1, 3, 5 }));
     }
 
-    TEST_CASE("Parse BYDAY - Duplicate days")
+    TEST_CASE("BYDAY - Trailing comma")
     {
-        std::vector<int> days = parser.parseByDay("MO,WE,MO");
+        CompiledRRule rule = compileRRule(parser, "FREQ=WEEKLY;BYDAY=MO,WE,");
+        CHECK(rule.byWeekday == bits({ 1, 3 }));
+    }
 
-        // Duplicates are allowed (will be in vector twice)
-        CHECK(days.size() == 3);
-        CHECK(days[0] == 1);
-        CHECK(days[1] == 3);
-        CHECK(days[2] == 1); // Duplicate Monday
+    TEST_CASE("BYDAY - Duplicate days")
+    {
+        // A set: the second Monday changes nothing
+        CompiledRRule rule = compileRRule(parser, "FREQ=WEEKLY;BYDAY=MO,WE,MO");
+        CHECK(rule.byWeekday == bits({ 1, 3 }));
     }
 }
 
@@ -945,59 +957,44 @@ TEST_SUITE("CalendarStreamParser - BYMONTHDAY Advanced")
 {
     CalendarStreamParser parser;
 
-    TEST_CASE("Parse BYMONTHDAY - Mixed positive and negative")
+    TEST_CASE("BYMONTHDAY - Mixed positive and negative")
     {
-        std::vector<int> days = parser.parseByMonthDay("1,15,-1");
-
-        CHECK(days.size() == 3);
-        CHECK(days[0] == 1);
-        CHECK(days[1] == 15);
-        CHECK(days[2] == -1);
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYMONTHDAY=1,15,-1");
+        CHECK(rule.byMonthDay == bits({ 1, 15 }));
+        CHECK(rule.byMonthDayNeg == bits({ 1 }));
     }
 
-    TEST_CASE("Parse BYMONTHDAY - Last two days (-1,-2)")
+    TEST_CASE("BYMONTHDAY - Last two days (-1,-2)")
     {
-        std::vector<int> days = parser.parseByMonthDay("-1,-2");
-
-        CHECK(days.size() == 2);
-        CHECK(days[0] == -1);
-        CHECK(days[1] == -2);
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYMONTHDAY=-1,-2");
+        CHECK(rule.byMonthDay == 0);
+        CHECK(rule.byMonthDayNeg == bits({ 1, 2 }));
     }
 
-    TEST_CASE("Parse BYMONTHDAY - Out of range days")
+    TEST_CASE("BYMONTHDAY - Out of range days")
     {
-        std::vector<int> days = parser.parseByMonthDay("1,32,15");
-
-        // All values parsed (no validation yet)
-        CHECK(days.size() == 3);
-        CHECK(days[0] == 1);
-        CHECK(days[1] == 32); // Will be validated during expansion
-        CHECK(days[2] == 15);
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYMONTHDAY=1,32,15,-32");
+        CHECK(rule.byMonthDay == bits({ 1, 15 }));
+        CHECK(rule.byMonthDayNeg == 0);
     }
 
-    TEST_CASE("Parse BYMONTHDAY - Zero day invalid")
+    TEST_CASE("BYMONTHDAY - Zero day invalid")
     {
-        std::vector<int> days = parser.parseByMonthDay("0,15");
-
-        // 0 is not a valid day (days are 1-31 or -1 to -31)
-        CHECK(days.size() == 1); // Only 15
-        CHECK(days[0] == 15);
+        // Days are 1 to 31 or -1 to -31
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYMONTHDAY=0,15");
+        CHECK(rule.byMonthDay == bits({ 15 }));
     }
 
-    TEST_CASE("Parse BYMONTHDAY - Spaces in list")
+    TEST_CASE("BYMONTHDAY - Spaces in list")
     {
-        std::vector<int> days = parser.parseByMonthDay("1, 15, 30");
-
-        CHECK(days.size() == 3);
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYMONTHDAY=1, 15, 30");
+        CHECK(rule.byMonthDay == bits({ 1, 15, 30 }));
     }
 
-    TEST_CASE("Parse BYMONTHDAY - All days of month")
+    TEST_CASE("BYMONTHDAY - All days of month")
     {
-        std::vector<int> days = parser.parseByMonthDay("1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31");
-
-        CHECK(days.size() == 31);
-        CHECK(days[0] == 1);
-        CHECK(days[30] == 31);
+        CompiledRRule rule = compileRRule(parser, "FREQ=MONTHLY;BYMONTHDAY=1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31");
+        CHECK(rule.byMonthDay == 0xFFFFFFFEu);
     }
 }
 
@@ -1005,52 +1002,36 @@ TEST_SUITE("CalendarStreamParser - BYMONTH Advanced")
 {
     CalendarStreamParser parser;
 
-    TEST_CASE("Parse BYMONTH - All months")
+    TEST_CASE("BYMONTH - All months")
     {
-        std::vector<int> months = parser.parseByMonth("1,2,3,4,5,6,7,8,9,10,11,12");
-
-        CHECK(months.size() == 12);
-        CHECK(months[0] == 1);
-        CHECK(months[11] == 12);
+        CompiledRRule rule = compileRRule(parser, "FREQ=YEARLY;BYMONTH=1,2,3,4,5,6,7,8,9,10,11,12");
+        CHECK(rule.byMonth == 0x1FFE);
     }
 
-    TEST_CASE("Parse BYMONTH - Quarters (Q1, Q2, Q3, Q4)")
+    TEST_CASE("BYMONTH - Quarters (Q1, Q2, Q3, Q4)")
     {
-        std::vector<int> q1 = parser.parseByMonth("1,2,3");
-        std::vector<int> q2 = parser.parseByMonth("4,5,6");
-        std::vector<int> q3 = parser.parseByMonth("7,8,9");
-        std::vector<int> q4 = parser.parseByMonth("10,11,12");
-
-        CHECK(q1.size() == 3);
-        CHECK(q2.size() == 3);
-        CHECK(q3.size() == 3);
-        CHECK(q4.size() == 3);
+        CHECK(compileRRule(parser, "FREQ=YEARLY;BYMONTH=1,2,3").byMonth == bits({ 1, 2, 3 }));
+        CHECK(compileRRule(parser, "FREQ=YEARLY;BYMONTH=4,5,6").byMonth == bits({ 4, 5, 6 }));
+        CHECK(compileRRule(parser, "FREQ=YEARLY;BYMONTH=7,8,9").byMonth == bits({ 7, 8, 9 }));
+        CHECK(compileRRule(parser, "FREQ=YEARLY;BYMONTH=10,11,12").byMonth == bits({ 10, 11, 12 }));
     }
 
-    TEST_CASE("Parse BYMONTH - Out of range filtered")
+    TEST_CASE("BYMONTH - Out of range filtered")
     {
-        std::vector<int> months = parser.parseByMonth("0,1,13,7,100");
-
         // Only 1 and 7 are valid
-        CHECK(months.size() == 2);
-        CHECK(months[0] == 1);
-        CHECK(months[1] == 7);
+        CompiledRRule rule = compileRRule(parser, "FREQ=YEARLY;BYMONTH=0,1,13,7,100");
+        CHECK(rule.byMonth == bits({ 1, 7 }));
     }
 
-    TEST_CASE("Parse BYMONTH - Negative values filtered")
+    TEST_CASE("BYMONTH - Negative values filtered")
     {
-        std::vector<int> months = parser.parseByMonth("-1,1,7");
-
-        // Negative months not supported
-        CHECK(months.size() == 2);
-        CHECK(months[0] == 1);
-        CHECK(months[1] == 7);
+        CompiledRRule rule = compileRRule(parser, "FREQ=YEARLY;BYMONTH=-1,1,7");
+        CHECK(rule.byMonth == bits({ 1, 7 }));
     }
 
-    TEST_CASE("Parse BYMONTH - Spaces in list")
+    TEST_CASE("BYMONTH - Spaces in list")
     {
-        std::vector<int> months = parser.parseByMonth("1, 7, 12");
-
-        CHECK(months.size() == 3);
+        CompiledRRule rule = compileRRule(parser, "FREQ=YEARLY;BYMONTH=1, 7, 12");
+        CHECK(rule.byMonth == bits({ 1, 7, 12 }));
     }
 }
@@ -0,0 +1,297 @@
+/**
+ * @file test_conditional_get.cpp
+ * @brief Tests for conditional calendar fetches (ETag / Last-Modified)
+ *
+ * Tests cover:
+ * - Validators sidecar next to the binary event cache
+ * - Validators returned by a full download
+ * - 304 Not Modified with If-None-Match and If-Modified-Since: no download,
+ *   no parse, no events
+ * - A changed feed is downloaded and parsed again
+ * - Two wakes against the mock server: the second one reuses the event cache
+ * - Bytes and time of a full fetch compared to a revalidated one
+ */
+
+#include <doctest.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "event_cache.h"
+#include "mock_calendar_fetcher.h"
+#include "timezone_engine.h"
+
+namespace {
+
+const char* const FEED_URL = "https://calendar.example.com/feed.ics";
+const char* const CACHE_PATH = "/cache/events_conditional.bin";
+
+String smallFeed(const char* summary) {
+    String ics = "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//Conditional//EN\n"
+                 "BEGIN:VEVENT\nUID:one@example.com\nDTSTART:20260210T090000Z\nDTEND:20260210T100000Z\nSUMMARY:";
+    ics += summary;
+    ics += "\nEND:VEVENT\n"
+           "BEGIN:VEVENT\nUID:two@example.com\nDTSTART:20260212T090000Z\nDTEND:20260212T100000Z\nSUMMARY:Review\n"
+           "END:VEVENT\nEND:VCALENDAR\n";
+    return ics;
+}
+
+FilteredEvents* fetchFebruary(CalendarStreamParser& parser, const HttpValidators* validators) {
+    return parser.fetchEventsInRange(FEED_URL, utcFor(2026, 2, 1, 0, 0), utcFor(2026, 3, 1, 0, 0), 500, "",
+                                     validators);
+}
+
+void resetStorage() {
+    EventCache::remove(CACHE_PATH);
+    MockHttpServer::instance().reset();
+}
+
+} // namespace
+
+TEST_SUITE("Conditional GET - Validators sidecar")
+{
+    TEST_CASE("Validators round-trip next to the cache file")
+    {
+        resetStorage();
+        CHECK(EventCache::getValidatorsPath(CACHE_PATH) == "/cache/events_conditional.etag");
+
+        HttpValidators saved;
+        saved.etag = "\"abc-123\"";
+        saved.lastModified = "Tue, 10 Feb 2026 08:00:00 GMT";
+        REQUIRE(EventCache::saveValidators(CACHE_PATH, saved, 1773000000));
+
+        HttpValidators loaded;
+        time_t coveredUntil = 0;
+        REQUIRE(EventCache::loadValidators(CACHE_PATH, loaded, coveredUntil));
+        CHECK(loaded.etag == saved.etag);
+        CHECK(loaded.lastModified == saved.lastModified);
+        CHECK(coveredUntil == 1773000000);
+
+        // remove() drops the sidecar with the cache
+        CHECK(EventCache::remove(CACHE_PATH));
+        CHECK_FALSE(LittleFS.exists(EventCache::getValidatorsPath(CACHE_PATH)));
+        CHECK_FALSE(EventCache::loadValidators(CACHE_PATH, loaded, coveredUntil));
+        CHECK(loaded.isEmpty());
+    }
+
+    TEST_CASE("Saving empty validators clears the sidecar")
+    {
+        resetStorage();
+        HttpValidators saved;
+        saved.etag = "\"v1\"";
+        REQUIRE(EventCache::saveValidators(CACHE_PATH, saved, 100));
+
+        CHECK_FALSE(EventCache::saveValidators(CACHE_PATH, HttpValidators(), 0));
+        CHECK_FALSE(LittleFS.exists(EventCache::getValidatorsPath(CACHE_PATH)));
+    }
+
+    TEST_CASE("ETag alone is enough")
+    {
+        resetStorage();
+        HttpValidators saved;
+        saved.etag = "W/\"weak\"";
+        REQUIRE(EventCache::saveValidators(CACHE_PATH, saved, 100));
+
+        HttpValidators loaded;
+        time_t coveredUntil = 0;
+        REQUIRE(EventCache::loadValidators(CACHE_PATH, loaded, coveredUntil));
+        CHECK(loaded.etag == "W/\"weak\"");
+        CHECK(loaded.lastModified.isEmpty());
+        CHECK(coveredUntil == 100);
+        resetStorage();
+    }
+}
+
+TEST_SUITE("Conditional GET - Fetch")
+{
+    TEST_CASE("Full download returns the response validators")
+    {
+        resetStorage();
+        MockHttpServer& server = MockHttpServer::instance();
+        String body = smallFeed("Planning");
+        server.setResource(FEED_URL, body, "\"v1\"", "Mon, 09 Feb 2026 12:00:00 GMT");
+
+        CalendarStreamParser parser;
+        FilteredEvents* result = fetchFebruary(parser, nullptr);
+
+        REQUIRE(result->success);
+        CHECK_FALSE(result->notModified);
+        CHECK(result->events.size() == 2);
+        CHECK(result->validators.etag == "\"v1\"");
+        CHECK(result->validators.lastModified == "Mon, 09 Feb 2026 12:00:00 GMT");
+        CHECK(result->bytesTransferred == body.length());
+        CHECK(server.requests == 1);
+        CHECK(server.lastRequest.isEmpty());
+        delete result;
+    }
+
+    TEST_CASE("Matching ETag answers 304 without parsing")
+    {
+        resetStorage();
+        MockHttpServer& server = MockHttpServer::instance();
+        server.setResource(FEED_URL, smallFeed("Planning"), "\"v1\"", "Mon, 09 Feb 2026 12:00:00 GMT");
+
+        CalendarStreamParser parser;
+        HttpValidators validators;
+        validators.etag = "\"v1\"";
+        validators.lastModified = "Mon, 09 Feb 2026 12:00:00 GMT";
+
+        size_t callbacks = 0;
+        CHECK(parser.streamParse(
+            FEED_URL, [&callbacks](CalendarEvent* event) {
+                callbacks++;
+                delete event;
+            },
+            0, 0, "", &validators));
+        CHECK(parser.wasNotModified());
+        CHECK(callbacks == 0);
+        CHECK(parser.getLastParseStats().bytesRead == 0);
+        CHECK(parser.getLastParseStats().eventsParsed == 0);
+
+        FilteredEvents* result = fetchFebruary(parser, &validators);
+        REQUIRE(result->success);
+        CHECK(result->notModified);
+        CHECK(result->events.empty());
+        CHECK(result->bytesTransferred == 0);
+        CHECK(result->validators.etag == "\"v1\"");
+
+        CHECK(server.notModifiedResponses == 2);
+        CHECK(server.bytesSent == 0);
+        CHECK(server.lastRequest.etag == "\"v1\"");
+        CHECK(server.lastRequest.lastModified == "Mon, 09 Feb 2026 12:00:00 GMT");
+        delete result;
+    }
+
+    TEST_CASE("Last-Modified alone revalidates")
+    {
+        resetStorage();
+        MockHttpServer& server = MockHttpServer::instance();
+        server.setResource(FEED_URL, smallFeed("Planning"), "", "Mon, 09 Feb 2026 12:00:00 GMT");
+
+        CalendarStreamParser parser;
+        HttpValidators validators;
+        validators.lastModified = "Mon, 09 Feb 2026 12:00:00 GMT";
+
+        FilteredEvents* result = fetchFebruary(parser, &validators);
+        REQUIRE(result->success);
+        CHECK(result->notModified);
+        CHECK(server.lastRequest.etag.isEmpty());
+        delete result;
+    }
+
+    TEST_CASE("Changed feed is downloaded and parsed again")
+    {
+        resetStorage();
+        MockHttpServer& server = MockHttpServer::instance();
+        server.setResource(FEED_URL, smallFeed("Planning (moved)"), "\"v2\"", "Tue, 10 Feb 2026 07:00:00 GMT");
+
+        CalendarStreamParser parser;
+        HttpValidators validators;
+        validators.etag = "\"v1\"";
+        validators.lastModified = "Mon, 09 Feb 2026 12:00:00 GMT";
+
+        FilteredEvents* result = fetchFebruary(parser, &validators);
+        REQUIRE(result->success);
+        CHECK_FALSE(result->notModified);
+        REQUIRE(result->events.size() == 2);
+        CHECK(result->events[0]->summary == "Planning (moved)");
+        CHECK(result->validators.etag == "\"v2\"");
+        CHECK(result->bytesTransferred > 0);
+        CHECK(server.notModifiedResponses == 0);
+        delete result;
+    }
+
+    TEST_CASE("Empty validators send an unconditional request")
+    {
+        resetStorage();
+        MockHttpServer& server = MockHttpServer::instance();
+        server.setResource(FEED_URL, smallFeed("Planning"), "", "");
+
+        CalendarStreamParser parser;
+        HttpValidators validators;
+        FilteredEvents* result = fetchFebruary(parser, &validators);
+        REQUIRE(result->success);
+        CHECK_FALSE(result->notModified);
+        CHECK(result->events.size() == 2);
+        CHECK(result->validators.isEmpty());
+        delete result;
+    }
+
+    TEST_CASE("Unknown feed fails")
+    {
+        resetStorage();
+        CalendarStreamParser parser;
+        HttpValidators validators;
+        validators.etag = "\"v1\"";
+        FilteredEvents* result = fetchFebruary(parser, &validators);
+        CHECK_FALSE(result->success);
+        CHECK_FALSE(result->notModified);
+        delete result;
+    }
+}
+
+TEST_SUITE("Conditional GET - Wakes")
+{
+    TEST_CASE("Second wake reuses the event cache after a 304")
+    {
+        resetStorage();
+        std::string content = loadFixture("test/fixtures/google_calendar.ics");
+        REQUIRE(!content.empty());
+        MockHttpServer& server = MockHttpServer::instance();
+        server.setResource(FEED_URL, String(content.c_str()), "\"feed-1\"", "Wed, 01 Oct 2025 06:00:00 GMT");
+
+        time_t startDate = utcFor(2025, 10, 1, 0, 0);
+        time_t endDate = utcFor(2025, 11, 1, 0, 0);
+
+        // Wake 1: no validators yet, full download; cache events and validators
+        CalendarStreamParser firstWake;
+        std::chrono::steady_clock::time_point fullStart = std::chrono::steady_clock::now();
+        FilteredEvents* full = firstWake.fetchEventsInRange(FEED_URL, startDate, endDate, 500, "", nullptr);
+        REQUIRE(full->success);
+        REQUIRE(!full->events.empty());
+        REQUIRE(EventCache::save(CACHE_PATH, full->events, FEED_URL));
+        REQUIRE(EventCache::saveValidators(CACHE_PATH, full->validators, endDate));
+        double fullSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fullStart).count();
+
+        // Wake 2: conditional request, 304, events come from the cache
+        CalendarStreamParser secondWake;
+        std::chrono::steady_clock::time_point revalidateStart = std::chrono::steady_clock::now();
+        HttpValidators validators;
+        time_t coveredUntil = 0;
+        REQUIRE(EventCache::loadValidators(CACHE_PATH, validators, coveredUntil));
+        CHECK(coveredUntil >= endDate);
+        FilteredEvents* revalidated =
+            secondWake.fetchEventsInRange(FEED_URL, startDate, endDate, 500, "", &validators);
+        REQUIRE(revalidated->success);
+        REQUIRE(revalidated->notModified);
+        std::vector<CalendarEvent*> cached = EventCache::load(CACHE_PATH, FEED_URL);
+        double revalidateSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - revalidateStart).count();
+
+        REQUIRE(cached.size() == full->events.size());
+        for (size_t i = 0; i < cached.size(); i++) {
+            CHECK(cached[i]->startTime == full->events[i]->startTime);
+            CHECK(cached[i]->summary == full->events[i]->summary);
+        }
+        CHECK(server.requests == 2);
+        CHECK(server.notModifiedResponses == 1);
+        CHECK(revalidated->bytesTransferred == 0);
+        CHECK(secondWake.getLastParseStats().eventsParsed == 0);
+
+        MESSAGE("google_calendar.ics, ", (unsigned long)cached.size(), " events in October 2025");
+        MESSAGE("  full fetch:  ", (unsigned long)full->bytesTransferred, " bytes, ",
+                (unsigned long)(fullSeconds * 1e6), " us");
+        MESSAGE("  revalidated: ", (unsigned long)revalidated->bytesTransferred, " bytes, ",
+                (unsigned long)(revalidateSeconds * 1e6), " us");
+
+        for (CalendarEvent* event : cached) {
+            delete event;
+        }
+        delete full;
+        delete revalidated;
+        resetStorage();
+    }
+}
@@ -0,0 +1,304 @@
+/**
+ * @file test_connection_pool.cpp
+ * @brief Tests for the per-wake keep-alive connection pool
+ *
+ * Tests cover:
+ * - Origin keys (scheme, host, port) of calendar URLs
+ * - Reuse of idle connections, one borrower per connection, idle limit
+ * - Connections that are not reusable, went stale or failed to connect
+ * - Several calendars on one host through the stream parser: one handshake,
+ *   same events as separate connections, chunked and gzip bodies
+ * - Concurrent fetch workers sharing the pool
+ */
+
+#include <doctest.h>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "connection_pool.h"
+#include "fetch_scheduler.h"
+#include "mock_calendar_fetcher.h"
+#include "timezone_engine.h"
+
+namespace {
+
+const char* const WORK_URL = "https://calendar.google.com/calendar/ical/work/basic.ics";
+const char* const FAMILY_URL = "https://calendar.google.com/calendar/ical/family/basic.ics";
+const char* const HOLIDAYS_URL = "https://calendar.google.com/calendar/ical/holidays/basic.ics";
+const char* const OTHER_URL = "https://example.com/team.ics";
+
+/**
+ * @brief Publish the calendar fixtures on the mock server
+ */
+void publishCalendars(const char* encoding = "") {
+    std::string holidays = loadFixture("test/fixtures/holidays.ics");
+    std::string google = std::string(encoding) == "gzip" ? loadFixture("test/fixtures/google_calendar.ics.gz")
+                                                         : loadFixture("test/fixtures/google_calendar.ics");
+    REQUIRE(!holidays.empty());
+    REQUIRE(!google.empty());
+
+    MockHttpServer& server = MockHttpServer::instance();
+    server.reset();
+    server.setResource(WORK_URL, String(google), "\"w1\"", "", encoding);
+    server.setResource(FAMILY_URL, String(google), "\"f1\"", "", encoding);
+    server.setResource(HOLIDAYS_URL, String(holidays), "\"h1\"", "");
+    server.setResource(OTHER_URL, String(holidays), "\"o1\"", "");
+}
+
+/**
+ * @brief Start times of the events of one calendar, fetched with an optional pool
+ */
+std::vector<time_t> fetchStarts(const char* url, ConnectionPool* pool, time_t startDate, time_t endDate) {
+    CalendarStreamParser parser;
+    parser.setConnectionPool(pool);
+    FilteredEvents* result = parser.fetchEventsInRange(url, startDate, endDate, 0);
+    std::vector<time_t> starts;
+    CHECK(result->success);
+    for (size_t i = 0; i < result->events.size(); i++) {
+        starts.push_back(result->events[i]->startTime);
+    }
+    delete result;
+    return starts;
+}
+
+} // namespace
+
+TEST_SUITE("ConnectionPool")
+{
+    TEST_CASE("Origin of calendar URLs")
+    {
+        String origin;
+        String host;
+        uint16_t port = 0;
+        bool secure = false;
+
+        REQUIRE(ConnectionPool::parseOrigin(WORK_URL, origin, host, port, secure));
+        CHECK(origin == "https://calendar.google.com:443");
+        CHECK(host == "calendar.google.com");
+        CHECK(port == 443);
+        CHECK(secure);
+
+        REQUIRE(ConnectionPool::parseOrigin("http://User:pw@Cal.Example.com:8080", origin, host, port, secure));
+        CHECK(origin == "http://cal.example.com:8080");
+        CHECK(host == "cal.example.com");
+        CHECK(port == 8080);
+        CHECK_FALSE(secure);
+
+        CHECK_FALSE(ConnectionPool::parseOrigin("file:///calendar.ics", origin, host, port, secure));
+        CHECK_FALSE(ConnectionPool::parseOrigin("https:///calendar.ics", origin, host, port, secure));
+        CHECK_FALSE(ConnectionPool::parseOrigin("https://host:0/calendar.ics", origin, host, port, secure));
+    }
+
+    TEST_CASE("Idle connection to the same origin is reused")
+    {
+        ConnectionPool pool(2);
+        PooledConnection* first = pool.acquire(WORK_URL);
+        REQUIRE(first != nullptr);
+        CHECK(first->client->connected());
+        pool.release(first, true);
+
+        PooledConnection* second = pool.acquire(FAMILY_URL);
+        CHECK(second == first);
+        CHECK(second->requests == 2);
+        pool.release(second, true);
+
+        // Different host, port or scheme: new connection
+        PooledConnection* other = pool.acquire(OTHER_URL);
+        REQUIRE(other != nullptr);
+        CHECK(other != first);
+        pool.release(other, true);
+        PooledConnection* plain = pool.acquire("http://calendar.google.com/feed.ics");
+        REQUIRE(plain != nullptr);
+        CHECK(plain != first);
+        pool.release(plain, true);
+
+        CHECK(pool.getHandshakeCount() == 3);
+        CHECK(pool.getReuseCount() == 1);
+        CHECK(pool.getOpenCount() == 2); // Idle limit
+    }
+
+    TEST_CASE("A connection is lent to one borrower at a time")
+    {
+        ConnectionPool pool(2);
+        PooledConnection* first = pool.acquire(WORK_URL);
+        PooledConnection* second = pool.acquire(FAMILY_URL);
+        REQUIRE(first != nullptr);
+        REQUIRE(second != nullptr);
+        CHECK(first != second);
+        CHECK(pool.getHandshakeCount() == 2);
+
+        pool.release(first, true);
+        pool.release(second, true);
+        CHECK(pool.getOpenCount() == 2);
+
+        PooledConnection* third = pool.acquire(HOLIDAYS_URL);
+        CHECK((third == first || third == second));
+        pool.release(third, true);
+        CHECK(pool.getHandshakeCount() == 2);
+    }
+
+    TEST_CASE("Unusable connections are closed")
+    {
+        ConnectionPool pool(2);
+        PooledConnection* connection = pool.acquire(WORK_URL);
+        REQUIRE(connection != nullptr);
+        pool.release(connection, false);
+        CHECK(pool.getOpenCount() == 0);
+
+        // Closed by the server while idle
+        connection = pool.acquire(WORK_URL);
+        pool.release(connection, true);
+        connection->client->stop();
+        PooledConnection* fresh = pool.acquire(WORK_URL);
+        REQUIRE(fresh != nullptr);
+        CHECK(fresh->client->connected());
+        CHECK(fresh->requests == 1);
+        pool.release(fresh, true);
+        CHECK(pool.getHandshakeCount() == 3);
+        CHECK(pool.getReuseCount() == 0);
+
+        pool.closeAll();
+        CHECK(pool.getOpenCount() == 0);
+    }
+
+    TEST_CASE("Failed connections are counted and not pooled")
+    {
+        ConnectionPool pool;
+        CHECK(pool.acquire("https://calendar.invalid/feed.ics") == nullptr);
+        CHECK(pool.acquire("local://calendar.ics") == nullptr);
+        CHECK(pool.getFailedCount() == 1);
+        CHECK(pool.getHandshakeCount() == 0);
+        CHECK(pool.getOpenCount() == 0);
+    }
+}
+
+TEST_SUITE("ConnectionPool - Calendars")
+{
+    TEST_CASE("Calendars on one host share a connection")
+    {
+        publishCalendars();
+        time_t startDate = utcFor(2024, 1, 1, 0, 0);
+        time_t endDate = utcFor(2026, 1, 1, 0, 0);
+        const char* const urls[] = {WORK_URL, FAMILY_URL, HOLIDAYS_URL, OTHER_URL};
+
+        std::vector<time_t> expected[4];
+        for (int i = 0; i < 4; i++) {
+            expected[i] = fetchStarts(urls[i], nullptr, startDate, endDate);
+            CHECK(!expected[i].empty());
+        }
+
+        const bool chunkedTransfer[] = {false, true};
+        for (int mode = 0; mode < 2; mode++) {
+            CAPTURE(chunkedTransfer[mode]);
+            MockHttpServer::instance().chunkedTransfer = chunkedTransfer[mode];
+            ConnectionPool pool(2);
+            for (int i = 0; i < 4; i++) {
+                CAPTURE(i);
+                CHECK(fetchStarts(urls[i], &pool, startDate, endDate) == expected[i]);
+            }
+            // calendar.google.com once, example.com once
+            CHECK(pool.getHandshakeCount() == 2);
+            CHECK(pool.getReuseCount() == 2);
+            MESSAGE("4 calendars, chunked=", chunkedTransfer[mode], ": ", pool.getHandshakeCount(),
+                    " handshakes instead of 4");
+        }
+        MockHttpServer::instance().reset();
+    }
+
+    TEST_CASE("Gzip bodies over keep-alive connections")
+    {
+        publishCalendars("gzip");
+        MockHttpServer::instance().chunkedTransfer = true;
+        time_t startDate = utcFor(2020, 1, 1, 0, 0);
+        time_t endDate = utcFor(2026, 1, 1, 0, 0);
+
+        std::vector<time_t> expected = fetchStarts(WORK_URL, nullptr, startDate, endDate);
+        REQUIRE(!expected.empty());
+
+        ConnectionPool pool;
+        CHECK(fetchStarts(WORK_URL, &pool, startDate, endDate) == expected);
+        CHECK(fetchStarts(FAMILY_URL, &pool, startDate, endDate) == expected);
+        CHECK(pool.getHandshakeCount() == 1);
+        MockHttpServer::instance().reset();
+    }
+
+    TEST_CASE("Not modified responses keep the connection")
+    {
+        publishCalendars();
+        ConnectionPool pool;
+        CalendarStreamParser parser;
+        parser.setConnectionPool(&pool);
+
+        HttpValidators validators;
+        validators.etag = "\"h1\"";
+        for (int i = 0; i < 3; i++) {
+            FilteredEvents* result = parser.fetchEventsInRange(HOLIDAYS_URL, utcFor(2024, 1, 1, 0, 0),
+                                                               utcFor(2025, 1, 1, 0, 0), 0, "", &validators);
+            CHECK(result->notModified);
+            delete result;
+        }
+        CHECK(pool.getHandshakeCount() == 1);
+        CHECK(pool.getReuseCount() == 2);
+        MockHttpServer::instance().reset();
+    }
+
+    TEST_CASE("A body abandoned early closes its connection")
+    {
+        publishCalendars();
+        ConnectionPool pool;
+        CalendarStreamParser parser;
+        parser.setConnectionPool(&pool);
+
+        // Reading only the calendar header leaves most of the feed unread
+        String name;
+        String timezone;
+        CHECK(parser.parseMetadata(WORK_URL, name, timezone));
+        CHECK(pool.getOpenCount() == 0);
+
+        // A short tail is drained instead
+        MockHttpServer::instance().setResource(
+            "https://calendar.google.com/short.ics",
+            "BEGIN:VCALENDAR\r\nX-WR-CALNAME:Short\r\nBEGIN:VEVENT\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n", "", "");
+        CHECK(parser.parseMetadata("https://calendar.google.com/short.ics", name, timezone));
+        CHECK(name == "Short");
+        CHECK(pool.getOpenCount() == 1);
+        CHECK(pool.getHandshakeCount() == 2);
+        MockHttpServer::instance().reset();
+    }
+
+    TEST_CASE("Concurrent fetch workers share the pool")
+    {
+        publishCalendars();
+        time_t startDate = utcFor(2024, 1, 1, 0, 0);
+        time_t endDate = utcFor(2026, 1, 1, 0, 0);
+        const char* const urls[] = {WORK_URL, FAMILY_URL, HOLIDAYS_URL, WORK_URL};
+
+        std::vector<time_t> expected[4];
+        for (int i = 0; i < 4; i++) {
+            expected[i] = fetchStarts(urls[i], nullptr, startDate, endDate);
+        }
+
+        ConnectionPool pool(2);
+        std::vector<time_t> actual[4];
+        FetchScheduler scheduler(2);
+        for (int i = 0; i < 4; i++) {
+            scheduler.addJob("calendar", [&pool, &urls, &actual, startDate, endDate, i]() {
+                actual[i] = fetchStarts(urls[i], &pool, startDate, endDate);
+                return !actual[i].empty();
+            });
+        }
+        CHECK(scheduler.run() == 4);
+
+        for (int i = 0; i < 4; i++) {
+            CAPTURE(i);
+            CHECK(actual[i] == expected[i]);
+        }
+        // At most one connection per concurrent worker
+        CHECK(pool.getHandshakeCount() <= 2);
+        CHECK(pool.getHandshakeCount() + pool.getReuseCount() == 4);
+        MockHttpServer::instance().reset();
+    }
+}
@@ -0,0 +1,122 @@
+/**
+ * @file test_crc32.cpp
+ * @brief Tests for the CRC32 implementations behind EventCache::calculateCRC32()
+ *
+ * Tests cover:
+ * - Check values of the standard CRC-32
+ * - Slicing-by-8 against the byte-at-a-time table for every length and alignment
+ * - Checksums computed in pieces of any size
+ * - Throughput of both in MB/s
+ */
+
+#include <doctest.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "event_cache.h"
+
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t count, unsigned seed) {
+    std::vector<uint8_t> bytes(count);
+    srand(seed);
+    for (size_t i = 0; i < count; i++) {
+        bytes[i] = (uint8_t)(rand() & 0xFF);
+    }
+    return bytes;
+}
+
+typedef uint32_t (*Crc32Function)(const uint8_t*, size_t, uint32_t);
+
+// MB/s of crc over data, the best of a few rounds
+double throughput(Crc32Function crc, const std::vector<uint8_t>& data, uint32_t& result) {
+    double best = 0;
+    for (int round = 0; round < 5; round++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        result = crc(data.data(), data.size(), 0);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double rate    = seconds > 0 ? data.size() / seconds / 1e6 : 0;
+        if (rate > best) {
+            best = rate;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+TEST_SUITE("CRC32")
+{
+    TEST_CASE("Check values of the standard CRC-32")
+    {
+        const uint8_t* digits = (const uint8_t*)"123456789";
+        CHECK(EventCache::crc32Bytewise(digits, 9) == 0xCBF43926);
+        CHECK(EventCache::crc32Sliced(digits, 9) == 0xCBF43926);
+        CHECK(EventCache::calculateCRC32(digits, 9) == 0xCBF43926);
+
+        const char* fox = "The quick brown fox jumps over the lazy dog";
+        CHECK(EventCache::crc32Sliced((const uint8_t*)fox, strlen(fox)) == 0x414FA339);
+        CHECK(EventCache::crc32Sliced(nullptr, 0) == 0);
+        CHECK(EventCache::crc32Sliced((const uint8_t*)"a", 1) == 0xE8B7BE43);
+
+        std::vector<uint8_t> zeros(32, 0);
+        CHECK(EventCache::crc32Sliced(zeros.data(), zeros.size()) == 0x190A55AD);
+    }
+
+    TEST_CASE("Slicing-by-8 matches the table implementation at every length and alignment")
+    {
+        std::vector<uint8_t> data = randomBytes(4096 + 8, 11);
+        for (size_t offset = 0; offset < 8; offset++) {
+            for (size_t length = 0; length <= 200; length++) {
+                const uint8_t* start = data.data() + offset;
+                CHECK(EventCache::crc32Sliced(start, length) == EventCache::crc32Bytewise(start, length));
+            }
+            const uint8_t* start = data.data() + offset;
+            CHECK(EventCache::crc32Sliced(start, 4096) == EventCache::crc32Bytewise(start, 4096));
+            CHECK(EventCache::calculateCRC32(start, 4096) == EventCache::crc32Bytewise(start, 4096));
+        }
+
+        // Runs of 0x00 and 0xFF, which a wrong table entry would show up on
+        std::vector<uint8_t> ones(1000, 0xFF);
+        CHECK(EventCache::crc32Sliced(ones.data(), ones.size()) ==
+              EventCache::crc32Bytewise(ones.data(), ones.size()));
+        std::vector<uint8_t> zeros(1000, 0);
+        CHECK(EventCache::crc32Sliced(zeros.data(), zeros.size()) ==
+              EventCache::crc32Bytewise(zeros.data(), zeros.size()));
+    }
+
+    TEST_CASE("Checksums computed in pieces equal the one of the whole")
+    {
+        std::vector<uint8_t> data = randomBytes(3000, 23);
+        uint32_t whole            = EventCache::crc32Bytewise(data.data(), data.size());
+
+        const size_t pieceSizes[] = {1, 3, 7, 8, 9, 64, 128, 1000};
+        for (size_t p = 0; p < sizeof(pieceSizes) / sizeof(pieceSizes[0]); p++) {
+            uint32_t sliced = 0;
+            uint32_t api    = 0;
+            for (size_t at = 0; at < data.size(); at += pieceSizes[p]) {
+                size_t length = std::min(pieceSizes[p], data.size() - at);
+                sliced        = EventCache::crc32Sliced(data.data() + at, length, sliced);
+                api           = EventCache::calculateCRC32(data.data() + at, length, api);
+            }
+            CHECK(sliced == whole);
+            CHECK(api == whole);
+        }
+    }
+
+    TEST_CASE("Throughput in MB/s")
+    {
+        std::vector<uint8_t> data = randomBytes(4 * 1024 * 1024, 5);
+        uint32_t bytewise         = 0;
+        uint32_t sliced           = 0;
+        double bytewiseRate       = throughput(EventCache::crc32Bytewise, data, bytewise);
+        double slicedRate         = throughput(EventCache::crc32Sliced, data, sliced);
+
+        MESSAGE("CRC32 over 4 MB: table ", bytewiseRate, " MB/s, slicing-by-8 ", slicedRate, " MB/s (",
+                bytewiseRate > 0 ? slicedRate / bytewiseRate : 0, "x)");
+        CHECK(sliced == bytewise);
+    }
+}
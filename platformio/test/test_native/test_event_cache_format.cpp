@@ -0,0 +1,487 @@
+/**
+ * @file test_event_cache_format.cpp
+ * @brief Tests for the variable-length, string-pooled event cache format
+ *
+ * Tests cover:
+ * - Round trip of timestamps out of order, far apart and negative; events come back sorted
+ * - Shared strings (calendar name/color, summary equal to title) stored once
+ * - UID and RECURRENCE-ID kept per event
+ * - UTF-8 strings cut on a character boundary
+ * - Caches larger than the old 200-event limit
+ * - v2 and v5 caches written by older firmware still loaded and rewritten in the current format
+ * - Corrupted and truncated files rejected
+ * - File size and save/load throughput against v2
+ */
+
+#include <doctest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../mock_littlefs.h"
+#include "../test_helpers.h"
+#include "event_cache.h"
+
+namespace {
+
+const char* const CACHE_PATH   = "/cache/events_format.bin";
+const char* const CALENDAR_URL = "https://calendar.example.com/work.ics";
+
+// Layout of a v2 cache file, as older firmware wrote it
+struct __attribute__((packed)) HeaderV2 {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t eventCount;
+    time_t timestamp;
+    char calendarUrl[256];
+    uint32_t checksum;
+};
+
+struct __attribute__((packed)) EventV2 {
+    char title[128];
+    char location[64];
+    char date[16];
+    time_t startTime;
+    time_t endTime;
+    uint8_t flags;
+    uint8_t dayOfMonth;
+    char calendarName[32];
+    char calendarColor[16];
+    char summary[128];
+};
+
+void writeV2(const char* path, const std::vector<CalendarEvent*>& events) {
+    std::vector<EventV2> records(events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        EventV2& record = records[i];
+        memset(&record, 0, sizeof(record));
+        strncpy(record.title, events[i]->title.c_str(), sizeof(record.title) - 1);
+        strncpy(record.location, events[i]->location.c_str(), sizeof(record.location) - 1);
+        strncpy(record.date, events[i]->date.c_str(), sizeof(record.date) - 1);
+        strncpy(record.calendarName, events[i]->calendarName.c_str(), sizeof(record.calendarName) - 1);
+        strncpy(record.calendarColor, events[i]->calendarColor.c_str(), sizeof(record.calendarColor) - 1);
+        strncpy(record.summary, events[i]->summary.c_str(), sizeof(record.summary) - 1);
+        record.startTime  = events[i]->startTime;
+        record.endTime    = events[i]->endTime;
+        record.flags      = (events[i]->allDay ? 0x01 : 0) | (events[i]->isToday ? 0x02 : 0);
+        record.dayOfMonth = events[i]->dayOfMonth;
+    }
+
+    HeaderV2 header;
+    memset(&header, 0, sizeof(header));
+    header.magic      = EVENT_CACHE_MAGIC;
+    header.version    = 2;
+    header.eventCount = events.size();
+    header.timestamp  = time(nullptr);
+    strncpy(header.calendarUrl, CALENDAR_URL, sizeof(header.calendarUrl) - 1);
+    header.checksum = EventCache::calculateCRC32((const uint8_t*)records.data(),
+                                                 records.size() * sizeof(EventV2));
+
+    File file = LittleFS.open(path, "w");
+    file.write((const uint8_t*)&header, sizeof(header));
+    file.write((const uint8_t*)records.data(), records.size() * sizeof(EventV2));
+    file.close();
+}
+
+// Layout of a v5 cache file header, followed by the URL and the payload
+struct __attribute__((packed)) HeaderV5 {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t eventCount;
+    uint32_t stringCount;
+    uint32_t stringBytes;
+    uint16_t blockSize;
+    uint16_t urlLength;
+    int64_t timestamp;
+    uint32_t generation;
+    uint32_t payloadLength;
+    uint32_t checksum;
+};
+static_assert(sizeof(HeaderV5) == CACHE_HEADER_SIZE, "v6 kept the v5 header");
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+template <typename T> void putBytes(std::vector<uint8_t>& out, const T& value) {
+    out.insert(out.end(), (const uint8_t*)&value, (const uint8_t*)&value + sizeof(value));
+}
+
+// A v5 file as the previous firmware wrote it: six strings per record, no
+// UID or RECURRENCE-ID; events sorted by start time, every string stored
+void writeV5(const char* path, const std::vector<CalendarEvent*>& events) {
+    const size_t BLOCK = EVENT_CACHE_INDEX_BLOCK;
+    std::vector<uint8_t> index, offsets, strings, records;
+    int64_t previousStart = 0;
+    int64_t maxEnd        = INT64_MIN;
+    uint32_t stringCount  = 0;
+    for (size_t i = 0; i < events.size(); i++) {
+        const CalendarEvent* event = events[i];
+        if (i % BLOCK == 0) {
+            previousStart = event->startTime;
+            putBytes(index, (int64_t)event->startTime);
+            putBytes(index, maxEnd); // Raised below
+            putBytes(index, (uint32_t)records.size());
+        }
+        int64_t end = event->endTime == 0 ? event->startTime : event->endTime;
+        maxEnd      = std::max(maxEnd, end);
+        memcpy(&index[index.size() - 12], &maxEnd, sizeof(maxEnd));
+
+        putVarint(records, zigzag((int64_t)event->startTime - previousStart));
+        putVarint(records, zigzag((int64_t)event->endTime - event->startTime));
+        records.push_back((event->allDay ? 0x01 : 0) | (event->isToday ? 0x02 : 0));
+        records.push_back((uint8_t)event->dayOfMonth);
+        const String* values[] = {&event->title, &event->summary, &event->location,
+                                  &event->date, &event->calendarName, &event->calendarColor};
+        for (size_t v = 0; v < 6; v++) {
+            putBytes(offsets, (uint32_t)strings.size());
+            putVarint(strings, values[v]->length());
+            strings.insert(strings.end(), values[v]->c_str(), values[v]->c_str() + values[v]->length());
+            putVarint(records, stringCount++);
+        }
+        previousStart = event->startTime;
+    }
+
+    std::vector<uint8_t> payload = index;
+    payload.insert(payload.end(), offsets.begin(), offsets.end());
+    payload.insert(payload.end(), strings.begin(), strings.end());
+    payload.insert(payload.end(), records.begin(), records.end());
+
+    HeaderV5 header;
+    memset(&header, 0, sizeof(header));
+    header.magic         = EVENT_CACHE_MAGIC;
+    header.version       = 5;
+    header.eventCount    = events.size();
+    header.stringCount   = stringCount;
+    header.stringBytes   = strings.size();
+    header.blockSize     = BLOCK;
+    header.urlLength     = strlen(CALENDAR_URL);
+    header.timestamp     = time(nullptr);
+    header.generation    = 1;
+    header.payloadLength = payload.size();
+    header.checksum      = EventCache::calculateCRC32(payload.data(), payload.size());
+
+    File file = LittleFS.open(path, "w");
+    file.write((const uint8_t*)&header, sizeof(header));
+    file.write((const uint8_t*)CALENDAR_URL, header.urlLength);
+    file.write(payload.data(), payload.size());
+    file.close();
+}
+
+// A work calendar: recurring meetings mixed with one-off events, a few per day
+std::vector<CalendarEvent*> workEvents(size_t count) {
+    static const char* const RECURRING[] = {"Daily Standup", "1:1 with Maria", "Sprint Planning",
+                                            "Design Review", "Lunch"};
+    static const char* const LOCATIONS[] = {"", "Zoom", "Room 4.12 (Building B)", "Cafeteria"};
+
+    std::vector<CalendarEvent*> events;
+    time_t start = 1773100800; // 2026-03-10 00:00 UTC
+    for (size_t i = 0; i < count; i++) {
+        start += 3600 * (2 + i % 3);
+        struct tm day;
+        gmtime_r(&start, &day);
+        char date[16];
+        strftime(date, sizeof(date), "%Y-%m-%d", &day);
+
+        CalendarEvent* event = new CalendarEvent();
+        event->title = i % 2 == 0 ? String(RECURRING[i % 5])
+                                  : "Customer call: renewal of contract " + String((int)i);
+        event->summary       = event->title;
+        event->location      = LOCATIONS[i % 4];
+        event->date          = date;
+        event->calendarName  = "Work";
+        event->calendarColor = "#1a73e8";
+        event->startTime     = start;
+        event->endTime       = start + 1800 * (1 + i % 4);
+        event->dayOfMonth    = day.tm_mday;
+        event->isToday       = i < 3;
+        events.push_back(event);
+    }
+    return events;
+}
+
+bool sameEvent(const CalendarEvent* a, const CalendarEvent* b) {
+    return a->title == b->title && a->summary == b->summary && a->location == b->location &&
+           a->date == b->date && a->calendarName == b->calendarName &&
+           a->calendarColor == b->calendarColor && a->startTime == b->startTime &&
+           a->endTime == b->endTime && a->allDay == b->allDay && a->isToday == b->isToday &&
+           a->isTomorrow == b->isTomorrow && a->isHoliday == b->isHoliday &&
+           a->dayOfMonth == b->dayOfMonth && a->uid == b->uid && a->recurrenceId == b->recurrenceId;
+}
+
+void checkSameEvents(const std::vector<CalendarEvent*>& expected,
+                     const std::vector<CalendarEvent*>& loaded) {
+    REQUIRE(loaded.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        CHECK(sameEvent(expected[i], loaded[i]));
+    }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+TEST_SUITE("EventCache - file format")
+{
+    TEST_CASE("Timestamps round-trip in any order")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events = workEvents(6);
+        events[1]->startTime = events[4]->startTime + 86400 * 400; // Far ahead
+        events[2]->startTime = 0;
+        events[2]->endTime   = 0;
+        events[3]->endTime   = events[3]->startTime - 60; // Ends before it starts
+        events[5]->startTime = -86400;                    // Before 1970
+        events[5]->allDay    = true;
+        events[5]->isHoliday = true;
+        events[5]->isTomorrow = true;
+
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+        CHECK(fieldAt<uint32_t>(readFile(CACHE_PATH), CACHE_VERSION_OFFSET) == EVENT_CACHE_VERSION);
+        std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+
+        // Records are stored by start time
+        std::vector<CalendarEvent*> sorted = events;
+        std::stable_sort(sorted.begin(), sorted.end(), [](CalendarEvent* a, CalendarEvent* b) {
+            return a->startTime < b->startTime;
+        });
+        CHECK(sorted[0] == events[5]);
+        checkSameEvents(sorted, loaded);
+
+        deleteAll(events);
+        deleteAll(loaded);
+    }
+
+    TEST_CASE("Shared strings are stored once")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events;
+        for (int i = 0; i < 50; i++) {
+            CalendarEvent* event = new CalendarEvent();
+            event->title         = "Daily Standup with the whole platform team";
+            event->summary       = event->title;
+            event->location      = "Zoom";
+            event->date          = "2026-03-10";
+            event->calendarName  = "Work";
+            event->calendarColor = "#1a73e8";
+            event->startTime     = 1773133200 + i * 86400;
+            event->endTime       = event->startTime + 900;
+            event->dayOfMonth    = 10;
+            events.push_back(event);
+        }
+
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+        // Every record repeats the same strings: only a few bytes per event remain
+        size_t size = EventCache::getSize(CACHE_PATH);
+        CHECK(size < 100 + strlen(CALENDAR_URL) + 80 + 50 * 16);
+
+        std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        checkSameEvents(events, loaded);
+
+        deleteAll(events);
+        deleteAll(loaded);
+    }
+
+    TEST_CASE("UID and RECURRENCE-ID are kept per event")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events = workEvents(40);
+        for (size_t i = 0; i < events.size(); i++) {
+            // Recurring meetings share their UID, one-off events have their own
+            events[i]->uid = i % 2 == 0 ? "standup-" + String((int)(i % 5)) + "@example.com"
+                                        : "call-" + String((int)i) + "@example.com";
+        }
+        events[10]->recurrenceId = "20260312T090000Z";
+
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+        std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        checkSameEvents(events, loaded);
+        CHECK(loaded[10]->recurrenceId == "20260312T090000Z");
+        CHECK(loaded[11]->recurrenceId.isEmpty());
+
+        deleteAll(events);
+        deleteAll(loaded);
+    }
+
+    TEST_CASE("UTF-8 strings are cut on a character boundary")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events = workEvents(1);
+        String accents;
+        for (int i = 0; i < 100; i++) {
+            accents += "\xC3\xA9"; // é, two bytes
+        }
+        events[0]->title    = accents;
+        events[0]->summary  = accents;
+        events[0]->location = "\xE4\xBC\x9A\xE8\xAD\xB0\xE5\xAE\xA4 " + accents; // 会議室
+
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+        std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        REQUIRE(loaded.size() == 1);
+        CHECK(loaded[0]->title.length() == 126);
+        CHECK(loaded[0]->title == accents.substring(0, 126));
+        CHECK(loaded[0]->summary == loaded[0]->title);
+        CHECK(loaded[0]->location.length() == 62);
+        CHECK(loaded[0]->location == events[0]->location.substring(0, 62));
+
+        deleteAll(events);
+        deleteAll(loaded);
+    }
+
+    TEST_CASE("Caches hold more than the old 200-event limit")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events = workEvents(EVENT_CACHE_MAX_EVENTS);
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+        std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        checkSameEvents(events, loaded);
+
+        deleteAll(events);
+        deleteAll(loaded);
+    }
+
+    TEST_CASE("v2 caches are loaded and rewritten in the current format")
+    {
+        LittleFS.clear();
+        LittleFS.mkdir("/cache");
+        std::vector<CalendarEvent*> events = workEvents(20);
+        writeV2(CACHE_PATH, events);
+        CHECK(EventCache::isValid(CACHE_PATH));
+
+        std::vector<CalendarEvent*> migrated = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        checkSameEvents(events, migrated);
+
+        // The next save writes the new format
+        REQUIRE(EventCache::save(CACHE_PATH, migrated, CALENDAR_URL));
+        CHECK(fieldAt<uint32_t>(readFile(CACHE_PATH), CACHE_VERSION_OFFSET) == EVENT_CACHE_VERSION);
+        std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        checkSameEvents(events, loaded);
+
+        deleteAll(events);
+        deleteAll(migrated);
+        deleteAll(loaded);
+    }
+
+    TEST_CASE("v5 caches are loaded without UIDs and rewritten in the current format")
+    {
+        LittleFS.clear();
+        LittleFS.mkdir("/cache");
+        std::vector<CalendarEvent*> events = workEvents(40);
+        writeV5(CACHE_PATH, events);
+        CHECK(EventCache::isValid(CACHE_PATH));
+
+        std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        checkSameEvents(events, loaded);
+
+        // The block index of the old file still serves range queries
+        std::vector<CalendarEvent*> range =
+            EventCache::query(CACHE_PATH, events[20]->startTime, events[25]->startTime, 0);
+        CHECK(range.size() >= 6);
+        CHECK(range[0]->startTime <= events[20]->startTime);
+
+        events[0]->uid = "standup-0@example.com";
+        loaded[0]->uid = events[0]->uid;
+        REQUIRE(EventCache::save(CACHE_PATH, loaded, CALENDAR_URL));
+        CHECK(fieldAt<uint32_t>(readFile(CACHE_PATH), CACHE_VERSION_OFFSET) == EVENT_CACHE_VERSION);
+        std::vector<CalendarEvent*> rewritten = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        checkSameEvents(events, rewritten);
+
+        deleteAll(events);
+        deleteAll(loaded);
+        deleteAll(range);
+        deleteAll(rewritten);
+    }
+
+    TEST_CASE("Corrupted and truncated files are rejected")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events = workEvents(10);
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+        std::vector<uint8_t> good = readFile(CACHE_PATH);
+
+        std::vector<uint8_t> corrupt = good;
+        corrupt[good.size() - 5] ^= 0x40;
+        writeFile(CACHE_PATH, corrupt);
+        CHECK(EventCache::load(CACHE_PATH, CALENDAR_URL).empty());
+
+        for (size_t length = 0; length < good.size(); length += 7) {
+            writeFile(CACHE_PATH, std::vector<uint8_t>(good.begin(), good.begin() + length));
+            CHECK(EventCache::load(CACHE_PATH, CALENDAR_URL).empty());
+        }
+
+        // An unknown version is neither loaded nor valid
+        std::vector<uint8_t> future = good;
+        future[sizeof(uint32_t)] = 9;
+        writeFile(CACHE_PATH, future);
+        CHECK(EventCache::load(CACHE_PATH, CALENDAR_URL).empty());
+        CHECK_FALSE(EventCache::isValid(CACHE_PATH));
+
+        writeFile(CACHE_PATH, good);
+        std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        checkSameEvents(events, loaded);
+
+        deleteAll(events);
+        deleteAll(loaded);
+    }
+
+    TEST_CASE("File size and throughput against v2")
+    {
+        LittleFS.clear();
+        LittleFS.mkdir("/cache");
+        const char* const V2_PATH = "/cache/events_format_v2.bin";
+        const int ROUNDS          = 20;
+        std::vector<CalendarEvent*> events = workEvents(200);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            writeV2(V2_PATH, events);
+        }
+        double v2Save = secondsSince(start) / ROUNDS;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+        }
+        double v5Save = secondsSince(start) / ROUNDS;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            std::vector<CalendarEvent*> loaded = EventCache::load(V2_PATH, CALENDAR_URL);
+            REQUIRE(loaded.size() == events.size());
+            deleteAll(loaded);
+        }
+        double v2Load = secondsSince(start) / ROUNDS;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+            REQUIRE(loaded.size() == events.size());
+            deleteAll(loaded);
+        }
+        double v5Load = secondsSince(start) / ROUNDS;
+
+        size_t v2Size = EventCache::getSize(V2_PATH);
+        size_t v5Size = EventCache::getSize(CACHE_PATH);
+        MESSAGE("200 events: v2 ", (unsigned long)v2Size, " bytes, v5 ", (unsigned long)v5Size,
+                " bytes (", (double)v2Size / v5Size, "x smaller)");
+        MESSAGE("  save: v2 ", v2Save * 1e3, " ms, v5 ", v5Save * 1e3, " ms");
+        MESSAGE("  load: v2 ", v2Load * 1e3, " ms, v5 ", v5Load * 1e3, " ms");
+
+        CHECK(v5Size * 4 <= v2Size);
+
+        deleteAll(events);
+    }
+}
@@ -0,0 +1,209 @@
+/**
+ * @file test_event_cache_query.cpp
+ * @brief Tests for range queries on the indexed event cache
+ *
+ * Tests cover:
+ * - Events overlapping a range, earliest first, with a limit
+ * - Long events that started before the range
+ * - Ranges across block boundaries, against filtering a full load()
+ * - v2 caches without an index
+ * - Corrupted caches
+ * - Peak heap of a query, against the cache size
+ */
+
+#include <doctest.h>
+#include <cstdlib>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../mock_heap.h"
+#include "../mock_littlefs.h"
+#include "../test_helpers.h"
+#include "event_cache.h"
+
+namespace {
+
+const char* const CACHE_PATH   = "/cache/events_query.bin";
+const char* const CALENDAR_URL = "https://calendar.example.com/team.ics";
+const time_t DAY               = 86400;
+
+// The events of all that query() should return, with the same test as CalendarWrapper::getEvents()
+std::vector<String> expectedTitles(const std::vector<CalendarEvent*>& all, time_t start, time_t end, size_t limit) {
+    std::vector<String> titles;
+    for (size_t i = 0; i < all.size() && (limit == 0 || titles.size() < limit); i++) {
+        time_t eventEnd = all[i]->endTime == 0 ? all[i]->startTime : all[i]->endTime;
+        if (all[i]->startTime <= end && eventEnd >= start) {
+            titles.push_back(all[i]->title);
+        }
+    }
+    return titles;
+}
+
+// Most heap in use at once during a query (the mock file system's copy of
+// the file is not counted)
+size_t queryPeak(time_t start, time_t end, size_t limit, size_t& returned) {
+    MockHeap::resetPeak();
+    size_t before = MockHeap::current();
+    std::vector<CalendarEvent*> events = EventCache::query(CACHE_PATH, start, end, limit);
+    size_t peak = MockHeap::peak() - before;
+    returned = events.size();
+    deleteAll(events);
+    return peak;
+}
+
+} // namespace
+
+TEST_SUITE("EventCache - range queries")
+{
+    TEST_CASE("Events overlapping the range come back earliest first")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events;
+        events.push_back(testEvent("Friday review", TEST_MONDAY + 4 * DAY + 36000, 3600));
+        events.push_back(testEvent("Conference", TEST_MONDAY - 2 * DAY, 5 * DAY)); // Saturday to Thursday
+        events.push_back(testEvent("Tuesday lunch", TEST_MONDAY + DAY + 43200, 3600));
+        events.push_back(testEvent("Reminder", TEST_MONDAY + 2 * DAY, 0)); // No end time
+        events.push_back(testEvent("Last week", TEST_MONDAY - 5 * DAY, 3600));
+        events.push_back(testEvent("Next month", TEST_MONDAY + 30 * DAY, 3600));
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+
+        std::vector<CalendarEvent*> week = EventCache::query(CACHE_PATH, TEST_MONDAY, TEST_MONDAY + 7 * DAY);
+        CHECK(titlesOf(week) ==
+              std::vector<String>{"Conference", "Tuesday lunch", "Reminder", "Friday review"});
+        CHECK(week[0]->startTime == TEST_MONDAY - 2 * DAY);
+        CHECK(week[0]->calendarName == "Team");
+        CHECK(week[2]->endTime == 0);
+
+        std::vector<CalendarEvent*> firstTwo = EventCache::query(CACHE_PATH, TEST_MONDAY, TEST_MONDAY + 7 * DAY, 2);
+        CHECK(titlesOf(firstTwo) == std::vector<String>{"Conference", "Tuesday lunch"});
+
+        // Range bounds are inclusive, as in CalendarWrapper::getEvents()
+        std::vector<CalendarEvent*> edge = EventCache::query(CACHE_PATH, TEST_MONDAY + 2 * DAY, TEST_MONDAY + 2 * DAY);
+        CHECK(titlesOf(edge) == std::vector<String>{"Conference", "Reminder"});
+
+        std::vector<CalendarEvent*> none =
+            EventCache::query(CACHE_PATH, TEST_MONDAY + 60 * DAY, TEST_MONDAY + 61 * DAY);
+        CHECK(none.empty());
+        CHECK(EventCache::query("/cache/missing.bin", TEST_MONDAY, TEST_MONDAY + DAY).empty());
+
+        deleteAll(events);
+        deleteAll(week);
+        deleteAll(firstTwo);
+        deleteAll(edge);
+    }
+
+    TEST_CASE("Ranges across blocks match filtering the whole cache")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events = testEvents("Meeting", EVENT_CACHE_MAX_EVENTS - 3, 7200, 3600);
+        // A long event in the middle keeps the blocks after it in reach
+        events.push_back(testEvent("Offsite", TEST_MONDAY + 20 * DAY, 10 * DAY));
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+        std::vector<CalendarEvent*> all = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        REQUIRE(all.size() == events.size());
+
+        srand(7);
+        for (int round = 0; round < 200; round++) {
+            time_t start = TEST_MONDAY - DAY + rand() % (90 * DAY);
+            time_t end   = start + rand() % (3 * DAY);
+            size_t limit = round % 3 == 0 ? 1 + rand() % 10 : 0;
+            std::vector<CalendarEvent*> found = EventCache::query(CACHE_PATH, start, end, limit);
+            CHECK(titlesOf(found) == expectedTitles(all, start, end, limit));
+            deleteAll(found);
+        }
+
+        deleteAll(events);
+        deleteAll(all);
+    }
+
+    TEST_CASE("v2 caches are queried through a full load")
+    {
+        LittleFS.clear();
+        LittleFS.mkdir("/cache");
+        std::vector<CalendarEvent*> events = testEvents("Meeting", 3, 7200, 3600);
+
+        // Header then one 402-byte record, as older firmware wrote them
+        std::vector<uint8_t> records(events.size() * 402, 0);
+        for (size_t i = 0; i < events.size(); i++) {
+            uint8_t* record = records.data() + i * 402;
+            memcpy(record, events[i]->title.c_str(), events[i]->title.length());
+            time_t start = events[i]->startTime;
+            time_t end   = events[i]->endTime;
+            memcpy(record + 208, &start, sizeof(start));
+            memcpy(record + 216, &end, sizeof(end));
+        }
+        std::vector<uint8_t> header(4 + 4 + 4 + sizeof(time_t) + 256 + 4, 0);
+        uint32_t fields[3]   = {EVENT_CACHE_MAGIC, 2, (uint32_t)events.size()};
+        time_t now           = time(nullptr);
+        uint32_t checksum    = EventCache::calculateCRC32(records.data(), records.size());
+        memcpy(header.data(), fields, sizeof(fields));
+        memcpy(header.data() + 12, &now, sizeof(now));
+        memcpy(header.data() + header.size() - 4, &checksum, sizeof(checksum));
+        File file = LittleFS.open(CACHE_PATH, "w");
+        file.write(header.data(), header.size());
+        file.write(records.data(), records.size());
+        file.close();
+
+        std::vector<CalendarEvent*> found = EventCache::query(CACHE_PATH, TEST_MONDAY + 7200, TEST_MONDAY + DAY, 1);
+        CHECK(titlesOf(found) == std::vector<String>{"Meeting 1"});
+
+        deleteAll(events);
+        deleteAll(found);
+    }
+
+    TEST_CASE("Corrupted caches return nothing")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events = testEvents("Meeting", 40, 7200, 3600);
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+
+        File file = LittleFS.open(CACHE_PATH, "r");
+        std::vector<uint8_t> bytes(file.size());
+        file.read(bytes.data(), bytes.size());
+        file.close();
+
+        // Every byte after the header and the URL is covered by the checksum
+        for (size_t offset = 100; offset < bytes.size(); offset += 97) {
+            std::vector<uint8_t> corrupt = bytes;
+            corrupt[offset] ^= 0x21;
+            file = LittleFS.open(CACHE_PATH, "w");
+            file.write(corrupt.data(), corrupt.size());
+            file.close();
+            CHECK(EventCache::query(CACHE_PATH, TEST_MONDAY, TEST_MONDAY + 30 * DAY).empty());
+        }
+
+        deleteAll(events);
+    }
+
+    TEST_CASE("Peak heap follows the result, not the cache size")
+    {
+        LittleFS.clear();
+        size_t returned = 0;
+
+        std::vector<CalendarEvent*> small = testEvents("Meeting", 50, 7200, 3600);
+        REQUIRE(EventCache::save(CACHE_PATH, small, CALENDAR_URL));
+        size_t smallPeak = queryPeak(TEST_MONDAY + DAY, TEST_MONDAY + 30 * DAY, 7, returned);
+        CHECK(returned == 7);
+        deleteAll(small);
+
+        std::vector<CalendarEvent*> large = testEvents("Meeting", EVENT_CACHE_MAX_EVENTS, 7200, 3600);
+        REQUIRE(EventCache::save(CACHE_PATH, large, CALENDAR_URL));
+        size_t largePeak = queryPeak(TEST_MONDAY + DAY, TEST_MONDAY + 30 * DAY, 7, returned);
+        CHECK(returned == 7);
+
+        size_t fileSize = EventCache::getSize(CACHE_PATH);
+        MockHeap::resetPeak();
+        size_t before = MockHeap::current();
+        std::vector<CalendarEvent*> all = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        size_t loadPeak = MockHeap::peak() - before;
+        deleteAll(all);
+
+        MESSAGE("Peak heap for the next 7 events: ", (unsigned long)smallPeak, " bytes from 50 events, ",
+                (unsigned long)largePeak, " bytes from ", EVENT_CACHE_MAX_EVENTS, " (", (unsigned long)fileSize,
+                " byte file); load() of all of them: ", (unsigned long)loadPeak, " bytes");
+        CHECK(largePeak <= smallPeak + 256);
+        CHECK(largePeak * 20 < loadPeak);
+
+        deleteAll(large);
+    }
+}
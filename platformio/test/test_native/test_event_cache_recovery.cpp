@@ -0,0 +1,172 @@
+/**
+ * @file test_event_cache_recovery.cpp
+ * @brief Tests for atomic event cache saves and their recovery after a reset
+ *
+ * Tests cover:
+ * - Saves going through the temp file, with a generation one higher each time
+ * - recover() promoting a complete, newer temp file and discarding torn or older ones
+ * - A power loss at every byte of a save, then recovery: the old or the new events, never none
+ * - remove() deleting a leftover temp file
+ */
+
+#include <doctest.h>
+#include <cstring>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../mock_littlefs.h"
+#include "../test_helpers.h"
+#include "event_cache.h"
+
+namespace {
+
+const char* const CACHE_PATH   = "/cache/events_recovery.bin";
+const char* const TEMP_PATH    = "/cache/events_recovery.tmp";
+const char* const CALENDAR_URL = "https://calendar.example.com/recovery.ics";
+
+uint32_t generationOf(const char* path) {
+    std::vector<uint8_t> bytes = readFile(path);
+    if (bytes.size() < CACHE_GENERATION_OFFSET + sizeof(uint32_t)) {
+        return 0;
+    }
+    return fieldAt<uint32_t>(bytes, CACHE_GENERATION_OFFSET);
+}
+
+// Titles loaded from the cache, in order
+std::vector<String> cachedTitles() {
+    std::vector<CalendarEvent*> events = EventCache::load(CACHE_PATH, CALENDAR_URL);
+    std::vector<String> titles         = titlesOf(events);
+    deleteAll(events);
+    return titles;
+}
+
+} // namespace
+
+TEST_SUITE("EventCache - atomic saves")
+{
+    TEST_CASE("Saves go through the temp file and count generations")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> first  = testEvents("First", 5);
+        std::vector<CalendarEvent*> second = testEvents("Second", 7);
+
+        CHECK(EventCache::getTempPath(CACHE_PATH) == TEMP_PATH);
+        REQUIRE(EventCache::save(CACHE_PATH, first, CALENDAR_URL));
+        CHECK_FALSE(LittleFS.exists(TEMP_PATH));
+        CHECK(generationOf(CACHE_PATH) == 1);
+
+        REQUIRE(EventCache::save(CACHE_PATH, second, CALENDAR_URL));
+        CHECK_FALSE(LittleFS.exists(TEMP_PATH));
+        CHECK(generationOf(CACHE_PATH) == 2);
+        CHECK(cachedTitles() == titlesOf(second));
+
+        // Nothing to recover after a save that completed
+        CHECK_FALSE(EventCache::recover(CACHE_PATH));
+        CHECK(cachedTitles() == titlesOf(second));
+
+        deleteAll(first);
+        deleteAll(second);
+    }
+
+    TEST_CASE("A complete newer temp file is promoted, a torn or older one discarded")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> older = testEvents("Older", 4);
+        std::vector<CalendarEvent*> newer = testEvents("Newer", 6);
+        REQUIRE(EventCache::save(CACHE_PATH, older, CALENDAR_URL));
+        std::vector<uint8_t> olderFile = readFile(CACHE_PATH);
+        REQUIRE(EventCache::save(CACHE_PATH, newer, CALENDAR_URL));
+        std::vector<uint8_t> newerFile = readFile(CACHE_PATH);
+
+        // Reset after the temp file was closed, before the rename
+        writeFile(CACHE_PATH, olderFile);
+        writeFile(TEMP_PATH, newerFile);
+        CHECK(EventCache::recover(CACHE_PATH));
+        CHECK_FALSE(LittleFS.exists(TEMP_PATH));
+        CHECK(cachedTitles() == titlesOf(newer));
+
+        // A temp file cut short
+        std::vector<uint8_t> torn(newerFile.begin(), newerFile.end() - 5);
+        writeFile(CACHE_PATH, olderFile);
+        writeFile(TEMP_PATH, torn);
+        CHECK_FALSE(EventCache::recover(CACHE_PATH));
+        CHECK_FALSE(LittleFS.exists(TEMP_PATH));
+        CHECK(cachedTitles() == titlesOf(older));
+
+        // An older generation never replaces the cache
+        writeFile(CACHE_PATH, newerFile);
+        writeFile(TEMP_PATH, olderFile);
+        CHECK_FALSE(EventCache::recover(CACHE_PATH));
+        CHECK(cachedTitles() == titlesOf(newer));
+
+        // ...unless the cache itself is broken
+        std::vector<uint8_t> corrupt = newerFile;
+        corrupt[corrupt.size() - 1] ^= 0x40;
+        writeFile(CACHE_PATH, corrupt);
+        writeFile(TEMP_PATH, olderFile);
+        CHECK(EventCache::recover(CACHE_PATH));
+        CHECK(cachedTitles() == titlesOf(older));
+
+        // The first save of a calendar, cut before the rename
+        LittleFS.remove(CACHE_PATH);
+        writeFile(TEMP_PATH, newerFile);
+        CHECK(EventCache::recover(CACHE_PATH));
+        CHECK(cachedTitles() == titlesOf(newer));
+
+        deleteAll(older);
+        deleteAll(newer);
+    }
+
+    TEST_CASE("A power loss anywhere in a save keeps the old or the new events")
+    {
+        std::vector<CalendarEvent*> before = testEvents("Before", 20);
+        std::vector<CalendarEvent*> after  = testEvents("After", 30);
+
+        // Bytes written by a save over an existing cache, the rename included
+        LittleFS.clear();
+        REQUIRE(EventCache::save(CACHE_PATH, before, CALENDAR_URL));
+        size_t start = LittleFS.writeCount();
+        REQUIRE(EventCache::save(CACHE_PATH, after, CALENDAR_URL));
+        size_t total = LittleFS.writeCount() - start;
+        REQUIRE(total > 100);
+
+        size_t keptOld = 0;
+        for (size_t cut = 0; cut <= total; cut++) {
+            LittleFS.clear();
+            REQUIRE(EventCache::save(CACHE_PATH, before, CALENDAR_URL));
+            LittleFS.failWritesAfter(cut);
+            bool saved = EventCache::save(CACHE_PATH, after, CALENDAR_URL);
+            LittleFS.clearWriteFailure();
+            CHECK(saved == (cut == total));
+
+            // Next wake
+            EventCache::recover(CACHE_PATH);
+            CHECK_FALSE(LittleFS.exists(TEMP_PATH));
+            std::vector<String> titles = cachedTitles();
+            if (titles == titlesOf(before)) {
+                keptOld++;
+            } else {
+                CHECK(titles == titlesOf(after));
+            }
+        }
+        // A cut at the rename leaves a complete temp file, which recovery promotes
+        CHECK(keptOld == total - 1);
+
+        deleteAll(before);
+        deleteAll(after);
+    }
+
+    TEST_CASE("remove() deletes a leftover temp file")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events = testEvents("Event", 3);
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+        writeFile(TEMP_PATH, readFile(CACHE_PATH));
+
+        CHECK(EventCache::remove(CACHE_PATH));
+        CHECK_FALSE(LittleFS.exists(CACHE_PATH));
+        CHECK_FALSE(LittleFS.exists(TEMP_PATH));
+
+        deleteAll(events);
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * @file test_event_cache_streaming.cpp
+ * @brief Tests for the chunked writing and reading of event cache files
+ *
+ * Tests cover:
+ * - CRC32 computed in pieces, and the checksum in the header written last
+ * - Peak heap of save(), which does not grow with the number of events
+ * - Peak heap of load() beyond the events it returns
+ */
+
+#include <doctest.h>
+#include <cstring>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../mock_heap.h"
+#include "../mock_littlefs.h"
+#include "../test_helpers.h"
+#include "event_cache.h"
+
+namespace {
+
+const char* const CACHE_PATH   = "/cache/events_streaming.bin";
+const char* const CALENDAR_URL = "https://calendar.example.com/streaming.ics";
+
+// Most heap in use at once during a save
+size_t savePeak(const std::vector<CalendarEvent*>& events) {
+    MockHeap::resetPeak();
+    size_t before = MockHeap::current();
+    bool saved    = EventCache::save(CACHE_PATH, events, CALENDAR_URL);
+    size_t peak   = MockHeap::peak() - before;
+    CHECK(saved);
+    return peak;
+}
+
+// Most heap in use at once during a load, less what the returned events hold
+size_t loadOverhead(size_t expectedCount) {
+    MockHeap::resetPeak();
+    size_t before                      = MockHeap::current();
+    std::vector<CalendarEvent*> events = EventCache::load(CACHE_PATH, CALENDAR_URL);
+    size_t peak                        = MockHeap::peak() - before;
+    size_t kept                        = MockHeap::current() - before;
+    CHECK(events.size() == expectedCount);
+    deleteAll(events);
+    return peak - kept;
+}
+
+} // namespace
+
+TEST_SUITE("EventCache - streaming")
+{
+    TEST_CASE("A CRC32 computed in pieces equals the one of the whole data")
+    {
+        const char* text = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nEND:VCALENDAR\r\n";
+        const uint8_t* data = (const uint8_t*)text;
+        size_t length       = strlen(text);
+        uint32_t whole      = EventCache::calculateCRC32(data, length);
+        CHECK(EventCache::calculateCRC32((const uint8_t*)"123456789", 9) == 0xCBF43926);
+
+        for (size_t split = 0; split <= length; split += 7) {
+            uint32_t crc = EventCache::calculateCRC32(data, split);
+            CHECK(EventCache::calculateCRC32(data + split, length - split, crc) == whole);
+        }
+    }
+
+    TEST_CASE("The header written last holds the checksum of the payload")
+    {
+        LittleFS.clear();
+        std::vector<CalendarEvent*> events = testEvents("Session", 300);
+        REQUIRE(EventCache::save(CACHE_PATH, events, CALENDAR_URL));
+
+        std::vector<uint8_t> bytes = readFile(CACHE_PATH);
+        REQUIRE(bytes.size() > CACHE_HEADER_SIZE);
+        CHECK(fieldAt<uint32_t>(bytes, 0) == EVENT_CACHE_MAGIC);
+        CHECK(fieldAt<uint32_t>(bytes, CACHE_VERSION_OFFSET) == EVENT_CACHE_VERSION);
+        CHECK(fieldAt<uint32_t>(bytes, CACHE_EVENT_COUNT_OFFSET) == 300);
+
+        // The payload is everything after the URL, several write buffers long
+        size_t payloadStart    = CACHE_HEADER_SIZE + fieldAt<uint16_t>(bytes, CACHE_URL_LENGTH_OFFSET);
+        uint32_t payloadLength = fieldAt<uint32_t>(bytes, CACHE_PAYLOAD_LENGTH_OFFSET);
+        CHECK(payloadStart + payloadLength == bytes.size());
+        CHECK(payloadLength > 10 * EVENT_CACHE_IO_BUFFER);
+        CHECK(EventCache::calculateCRC32(bytes.data() + payloadStart, payloadLength) ==
+              fieldAt<uint32_t>(bytes, CACHE_CHECKSUM_OFFSET));
+
+        std::vector<CalendarEvent*> loaded = EventCache::load(CACHE_PATH, CALENDAR_URL);
+        REQUIRE(loaded.size() == events.size());
+        CHECK(loaded[299]->title == "Session 299");
+        CHECK(loaded[299]->location == events[299]->location);
+        CHECK(loaded[299]->date == "2026-03-21");
+        CHECK(loaded[299]->calendarName == "Team");
+
+        deleteAll(events);
+        deleteAll(loaded);
+    }
+
+    TEST_CASE("save() and load() allocate a fixed amount whatever the number of events")
+    {
+        LittleFS.clear();
+
+        std::vector<CalendarEvent*> small = testEvents("Session", 50);
+        size_t smallSave                  = savePeak(small);
+        size_t smallLoad                  = loadOverhead(small.size());
+        size_t smallFile                  = EventCache::getSize(CACHE_PATH);
+        deleteAll(small);
+
+        std::vector<CalendarEvent*> large = testEvents("Session", EVENT_CACHE_MAX_EVENTS);
+        size_t largeSave                  = savePeak(large);
+        size_t largeLoad                  = loadOverhead(large.size());
+        size_t largeFile                  = EventCache::getSize(CACHE_PATH);
+        deleteAll(large);
+
+        MESSAGE("Peak heap of save(): ", (unsigned long)smallSave, " bytes for 50 events (",
+                (unsigned long)smallFile, " byte file), ", (unsigned long)largeSave, " bytes for ",
+                EVENT_CACHE_MAX_EVENTS, " (", (unsigned long)largeFile, " byte file); load() beyond its events: ",
+                (unsigned long)smallLoad, " and ", (unsigned long)largeLoad, " bytes");
+
+        // The string slots and a few Strings; nothing in proportion to the events or the file
+        CHECK(largeSave == smallSave);
+        CHECK(largeSave < 4096);
+        CHECK(largeSave * 5 < largeFile);
+        CHECK(largeLoad <= smallLoad + 256);
+        CHECK(largeLoad < 4096);
+    }
+}
@@ -0,0 +1,274 @@
+/**
+ * @file test_event_prefilter.cpp
+ * @brief Tests for the VEVENT skip-ahead pre-filter in streamParseFromStream
+ *
+ * Tests cover:
+ * - Past and future non-recurring events dropped without parsing
+ * - Events that must still be parsed (in range, recurring, overrides,
+ *   multi-day events reaching into the range, late RRULE lines)
+ * - Same output with and without skip-ahead on the fixture feeds
+ * - Parse time with and without skip-ahead
+ */
+
+#include <doctest.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "timezone_engine.h"
+
+namespace {
+
+struct Occurrence {
+    time_t start;
+    time_t end;
+    std::string summary;
+    std::string description;
+
+    bool operator<(const Occurrence& other) const {
+        return start != other.start ? start < other.start : summary < other.summary;
+    }
+    bool operator==(const Occurrence& other) const {
+        return start == other.start && end == other.end && summary == other.summary &&
+               description == other.description;
+    }
+};
+
+/**
+ * @brief Stream-parse a calendar and return the occurrences sorted by start
+ */
+std::vector<Occurrence> parseCalendar(CalendarStreamParser& parser, const std::string& ics, time_t startDate,
+                                      time_t endDate) {
+    StringStream stream((String(ics.c_str())));
+    std::vector<Occurrence> occurrences;
+    parser.streamParseFromStream(
+        &stream,
+        [&occurrences](CalendarEvent* event) {
+            Occurrence occurrence;
+            occurrence.start = event->startTime;
+            occurrence.end = event->endTime;
+            occurrence.summary = event->summary.c_str();
+            occurrence.description = event->description.c_str();
+            occurrences.push_back(occurrence);
+            delete event;
+        },
+        startDate, endDate);
+    std::sort(occurrences.begin(), occurrences.end());
+    return occurrences;
+}
+
+std::vector<Occurrence> parseFebruary(CalendarStreamParser& parser, const std::string& body) {
+    std::string ics = "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//Prefilter//EN\n" + body + "END:VCALENDAR\n";
+    return parseCalendar(parser, ics, utcFor(2026, 2, 1, 0, 0), utcFor(2026, 3, 1, 0, 0));
+}
+
+std::string singleEvent(const char* uid, const char* dtstart, const char* dtend) {
+    std::string text = "BEGIN:VEVENT\nUID:";
+    text += uid;
+    text += "\nSUMMARY:Single\nDTSTART:";
+    text += dtstart;
+    text += "\n";
+    if (dtend) {
+        text += "DTEND:";
+        text += dtend;
+        text += "\n";
+    }
+    text += "DESCRIPTION:Notes\nBEGIN:VALARM\nACTION:DISPLAY\nDESCRIPTION:Reminder\nEND:VALARM\nEND:VEVENT\n";
+    return text;
+}
+
+} // namespace
+
+TEST_SUITE("Event pre-filter")
+{
+    TEST_CASE("Past and future non-recurring events are skipped unparsed")
+    {
+        CalendarStreamParser parser;
+        std::vector<Occurrence> events = parseFebruary(
+            parser, singleEvent("old@example.com", "20140310T090000Z", "20140310T100000Z") +
+                        singleEvent("no-end@example.com", "20140311T090000Z", nullptr) +
+                        singleEvent("future@example.com", "20270310T090000Z", "20270310T100000Z") +
+                        singleEvent("current@example.com", "20260210T090000Z", "20260210T100000Z"));
+
+        REQUIRE(events.size() == 1);
+        CHECK(events[0].summary == "Single");
+        CHECK(events[0].description == "Notes");
+        CHECK(parser.getLastParseStats().eventsSkipped == 3);
+        CHECK(parser.getLastParseStats().eventsParsed == 1);
+        CHECK(parser.getLastParseStats().eventsRejected == 0);
+    }
+
+    TEST_CASE("Skip-ahead can be turned off")
+    {
+        CalendarStreamParser parser;
+        parser.setSkipAhead(false);
+        std::vector<Occurrence> events =
+            parseFebruary(parser, singleEvent("old@example.com", "20140310T090000Z", "20140310T100000Z"));
+
+        CHECK(events.empty());
+        CHECK(parser.getLastParseStats().eventsSkipped == 0);
+        CHECK(parser.getLastParseStats().eventsParsed == 1);
+        CHECK(parser.getLastParseStats().eventsRejected == 1);
+    }
+
+    TEST_CASE("Multi-day event reaching into the range is kept")
+    {
+        std::string trip = singleEvent("trip@example.com", "20260129T090000Z", "20260202T090000Z");
+        CalendarStreamParser reference;
+        reference.setSkipAhead(false);
+        std::vector<Occurrence> expected = parseFebruary(reference, trip);
+
+        CalendarStreamParser parser;
+        std::vector<Occurrence> events = parseFebruary(parser, trip);
+
+        CHECK(!events.empty());
+        CHECK(events == expected);
+        CHECK(parser.getLastParseStats().eventsSkipped == 0);
+    }
+
+    TEST_CASE("RRULE after the decision rescues the block")
+    {
+        // DTSTART/DTEND already place the block in 2014 when the RRULE shows up;
+        // SUMMARY and DESCRIPTION follow it
+        CalendarStreamParser parser;
+        std::vector<Occurrence> events = parseFebruary(parser,
+                                                       "BEGIN:VEVENT\n"
+                                                       "UID:weekly@example.com\n"
+                                                       "DTSTART:20140106T090000Z\n"
+                                                       "DTEND:20140106T093000Z\n"
+                                                       "DTSTAMP:20140101T000000Z\n"
+                                                       "BEGIN:VALARM\n"
+                                                       "DESCRIPTION:Reminder\n"
+                                                       "END:VALARM\n"
+                                                       "X-EXTRA:ignored\n"
+                                                       "RRULE:FREQ=WEEKLY;BYDAY=MO\n"
+                                                       "SUMMARY:Standup\n"
+                                                       "DESCRIPTION:Daily sync\n"
+                                                       "END:VEVENT\n");
+
+        REQUIRE(events.size() == 4);
+        for (const Occurrence& occurrence : events) {
+            CHECK(occurrence.summary == "Standup");
+            CHECK(occurrence.description == "Daily sync");
+        }
+        CHECK(parser.getLastParseStats().eventsSkipped == 0);
+    }
+
+    TEST_CASE("Properties kept while skipping precede a late RRULE")
+    {
+        CalendarStreamParser parser;
+        std::vector<Occurrence> events = parseFebruary(parser,
+                                                       "BEGIN:VEVENT\n"
+                                                       "DTSTART:20140106T090000Z\n"
+                                                       "DTEND:20140106T093000Z\n"
+                                                       "SUMMARY:Standup\n"
+                                                       "UID:weekly@example.com\n"
+                                                       "EXDATE:20260209T090000Z\n"
+                                                       "BEGIN:VALARM\n"
+                                                       "SUMMARY:Alarm\n"
+                                                       "END:VALARM\n"
+                                                       "RRULE:FREQ=WEEKLY;BYDAY=MO\n"
+                                                       "END:VEVENT\n");
+
+        REQUIRE(events.size() == 3);
+        CHECK(events[0].summary == "Standup");
+        CHECK(events[1].start == utcFor(2026, 2, 16, 9, 0));
+    }
+
+    TEST_CASE("Out-of-range override still suppresses its instance")
+    {
+        // The instance of February 9 moved to 2027: the override is out of range
+        // but its RECURRENCE-ID must reach the override index
+        CalendarStreamParser parser;
+        std::vector<Occurrence> events = parseFebruary(parser,
+                                                       "BEGIN:VEVENT\n"
+                                                       "UID:standup@example.com\n"
+                                                       "DTSTART:20270105T090000Z\n"
+                                                       "DTEND:20270105T093000Z\n"
+                                                       "RECURRENCE-ID:20260209T090000Z\n"
+                                                       "SUMMARY:Standup (moved)\n"
+                                                       "END:VEVENT\n"
+                                                       "BEGIN:VEVENT\n"
+                                                       "UID:standup@example.com\n"
+                                                       "DTSTART:20260105T090000Z\n"
+                                                       "DTEND:20260105T093000Z\n"
+                                                       "RRULE:FREQ=WEEKLY;BYDAY=MO\n"
+                                                       "SUMMARY:Standup\n"
+                                                       "END:VEVENT\n");
+
+        CHECK(events.size() == 3);
+        for (const Occurrence& occurrence : events) {
+            CHECK(occurrence.start != utcFor(2026, 2, 9, 9, 0));
+        }
+    }
+
+    TEST_CASE("Fixture feeds give the same output with and without skip-ahead")
+    {
+        const char* const fixtures[] = {"test/fixtures/google_calendar.ics", "test/fixtures/holidays.ics"};
+        const time_t ranges[][2] = {
+            {utcFor(2025, 10, 1, 0, 0), utcFor(2025, 11, 1, 0, 0)},
+            {utcFor(2024, 1, 1, 0, 0), utcFor(2024, 12, 31, 0, 0)},
+            {utcFor(2020, 6, 1, 0, 0), utcFor(2020, 6, 15, 0, 0)},
+        };
+
+        for (const char* fixture : fixtures) {
+            std::string content = loadFixture(fixture);
+            REQUIRE(!content.empty());
+
+            for (const auto& range : ranges) {
+                CAPTURE(std::string(fixture));
+                CAPTURE(range[0]);
+
+                CalendarStreamParser reference;
+                reference.setSkipAhead(false);
+                std::vector<Occurrence> expected = parseCalendar(reference, content, range[0], range[1]);
+
+                CalendarStreamParser parser;
+                std::vector<Occurrence> actual = parseCalendar(parser, content, range[0], range[1]);
+
+                CHECK(actual == expected);
+                CHECK(parser.getLastParseStats().eventsSkipped + parser.getLastParseStats().eventsParsed ==
+                      reference.getLastParseStats().eventsParsed);
+            }
+        }
+    }
+}
+
+TEST_SUITE("Event pre-filter - Benchmark")
+{
+    TEST_CASE("Parse time on google_calendar.ics with and without skip-ahead")
+    {
+        const int iterations = 5;
+        std::string content = loadFixture("test/fixtures/google_calendar.ics");
+        REQUIRE(!content.empty());
+        time_t startDate = utcFor(2025, 10, 1, 0, 0);
+        time_t endDate = utcFor(2025, 11, 1, 0, 0);
+
+        CalendarStreamParser full;
+        full.setSkipAhead(false);
+        std::chrono::steady_clock::time_point fullStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            parseCalendar(full, content, startDate, endDate);
+        }
+        double fullSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fullStart).count();
+
+        CalendarStreamParser skipping;
+        std::chrono::steady_clock::time_point skipStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            parseCalendar(skipping, content, startDate, endDate);
+        }
+        double skipSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - skipStart).count();
+
+        const StreamParseStats& stats = skipping.getLastParseStats();
+        MESSAGE("google_calendar.ics: ", (unsigned long)stats.eventsParsed, " parsed, ",
+                (unsigned long)stats.eventsSkipped, " skipped unparsed");
+        MESSAGE("  full parse:  ", (unsigned long)(fullSeconds * 1e3 / iterations), " ms");
+        MESSAGE("  skip-ahead:  ", (unsigned long)(skipSeconds * 1e3 / iterations), " ms");
+
+        CHECK(stats.eventsSkipped > 0);
+    }
+}
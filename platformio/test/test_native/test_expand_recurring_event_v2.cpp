@@ -2528,4 +2528,191 @@ TEST_SUITE("expandRecurringEventV2 - DAILY Recurring Events")
     }
 }
 
+TEST_SUITE("expandRecurringEventV2 - Sub-daily Recurring Events")
+{
+    TEST_CASE("HOURLY - COUNT=6 every 4 hours")
+    {
+        String icsEvent = "BEGIN:VEVENT\n"
+                          "DTSTART:20250113T080000Z\n"
+                          "DTEND:20250113T081500Z\n"
+                          "RRULE:FREQ=HOURLY;INTERVAL=4;COUNT=6\n"
+                          "SUMMARY:Medication\n"
+                          "END:VEVENT";
+
+        CalendarEvent* event = parseICSEvent(icsEvent);
+        REQUIRE(event != nullptr);
+
+        time_t startDate = makeTime(2025, 1, 1, 0, 0, 0);
+        time_t endDate = makeTime(2025, 1, 31, 23, 59, 59);
+
+        auto occurrences = parser.expandRecurringEventV2(event, startDate, endDate);
+
+        REQUIRE(occurrences.size() == 6);
+        for (size_t i = 0; i < occurrences.size(); i++) {
+            CHECK(occurrences[i]->startTime == event->startTime + (time_t)i * 4 * 3600);
+            CHECK(occurrences[i]->endTime - occurrences[i]->startTime == 15 * 60);
+        }
+
+        for (auto* occ : occurrences)
+            delete occ;
+        delete event;
+    }
+
+    TEST_CASE("HOURLY - Old rule starts in the query range without stepping from DTSTART")
+    {
+        String icsEvent = "BEGIN:VEVENT\n"
+                          "DTSTART:20230301T003000Z\n"
+                          "DTEND:20230301T010000Z\n"
+                          "RRULE:FREQ=HOURLY;INTERVAL=3\n"
+                          "SUMMARY:Shift Check\n"
+                          "END:VEVENT";
+
+        CalendarEvent* event = parseICSEvent(icsEvent);
+        REQUIRE(event != nullptr);
+
+        time_t startDate = event->startTime + 2 * 365 * 86400 + 3600;
+        time_t endDate = startDate + 86400 - 1;
+
+        OccurrenceIterator it = parser.iterateOccurrences(event, startDate, endDate);
+        time_t start, end;
+        int count = 0;
+        time_t first = 0;
+        while (it.next(start, end)) {
+            if (count == 0)
+                first = start;
+            CHECK((start - event->startTime) % (3 * 3600) == 0);
+            count++;
+        }
+
+        CHECK(count == 8);
+        CHECK(first >= startDate);
+        CHECK(first - startDate < 3 * 3600);
+        CHECK(it.getStepCount() <= 9);
+        delete event;
+    }
+
+    TEST_CASE("HOURLY - COUNT already completed before the query range")
+    {
+        String icsEvent = "BEGIN:VEVENT\n"
+                          "DTSTART:20250113T080000Z\n"
+                          "DTEND:20250113T090000Z\n"
+                          "RRULE:FREQ=HOURLY;COUNT=10\n"
+                          "SUMMARY:Short Series\n"
+                          "END:VEVENT";
+
+        CalendarEvent* event = parseICSEvent(icsEvent);
+        REQUIRE(event != nullptr);
+
+        auto occurrences = parser.expandRecurringEventV2(event, makeTime(2025, 1, 14), makeTime(2025, 1, 31));
+        CHECK(occurrences.size() == 0);
+        delete event;
+    }
+
+    TEST_CASE("HOURLY - COUNT continues across the query start")
+    {
+        String icsEvent = "BEGIN:VEVENT\n"
+                          "DTSTART:20250113T000000Z\n"
+                          "DTEND:20250113T003000Z\n"
+                          "RRULE:FREQ=HOURLY;COUNT=30\n"
+                          "SUMMARY:Monitoring\n"
+                          "END:VEVENT";
+
+        CalendarEvent* event = parseICSEvent(icsEvent);
+        REQUIRE(event != nullptr);
+
+        // 24 occurrences on Jan 13, the remaining 6 on Jan 14
+        time_t startDate = event->startTime + 24 * 3600;
+        auto occurrences = parser.expandRecurringEventV2(event, startDate, startDate + 7 * 86400);
+        CHECK(occurrences.size() == 6);
+
+        for (auto* occ : occurrences)
+            delete occ;
+        delete event;
+    }
+
+    TEST_CASE("HOURLY - BYHOUR keeps only the listed local hours")
+    {
+        String icsEvent = "BEGIN:VEVENT\n"
+                          "DTSTART:20250113T000000Z\n"
+                          "DTEND:20250113T001000Z\n"
+                          "RRULE:FREQ=HOURLY;BYHOUR=8,12,20\n"
+                          "SUMMARY:Pills\n"
+                          "END:VEVENT";
+
+        CalendarEvent* event = parseICSEvent(icsEvent);
+        REQUIRE(event != nullptr);
+
+        time_t startDate = event->startTime + 86400;
+        time_t endDate = startDate + 7 * 86400 - 1;
+
+        auto occurrences = parser.expandRecurringEventV2(event, startDate, endDate);
+
+        // 3 per local day; the window is 7 days long but need not align with local midnight
+        CHECK(occurrences.size() >= 20);
+        CHECK(occurrences.size() <= 22);
+        for (auto* occ : occurrences) {
+            struct tm* tm = localtime(&occ->startTime);
+            CHECK((tm->tm_hour == 8 || tm->tm_hour == 12 || tm->tm_hour == 20));
+            delete occ;
+        }
+        delete event;
+    }
+
+    TEST_CASE("MINUTELY - BYHOUR and BYMINUTE")
+    {
+        String icsEvent = "BEGIN:VEVENT\n"
+                          "DTSTART:20250113T000000Z\n"
+                          "DTEND:20250113T000500Z\n"
+                          "RRULE:FREQ=MINUTELY;INTERVAL=15;BYHOUR=9,10;BYMINUTE=0,30\n"
+                          "SUMMARY:Rounds\n"
+                          "END:VEVENT";
+
+        CalendarEvent* event = parseICSEvent(icsEvent);
+        REQUIRE(event != nullptr);
+
+        time_t startDate = event->startTime + 86400;
+        time_t endDate = startDate + 3 * 86400 - 1;
+
+        OccurrenceIterator it = parser.iterateOccurrences(event, startDate, endDate);
+        time_t start, end;
+        int count = 0;
+        while (it.next(start, end)) {
+            struct tm* tm = localtime(&start);
+            CHECK((tm->tm_hour == 9 || tm->tm_hour == 10));
+            CHECK((tm->tm_min == 0 || tm->tm_min == 30));
+            count++;
+        }
+
+        // 4 per local day
+        CHECK(count >= 8);
+        CHECK(count <= 12);
+        // Rejected hours are skipped as a block, not one 15-minute step at a time
+        CHECK(it.getStepCount() < 3 * 24 * 4 / 2);
+        delete event;
+    }
+
+    TEST_CASE("MINUTELY - Per-query occurrence cap")
+    {
+        String icsEvent = "BEGIN:VEVENT\n"
+                          "DTSTART:20250113T000000Z\n"
+                          "DTEND:20250113T000100Z\n"
+                          "RRULE:FREQ=MINUTELY\n"
+                          "SUMMARY:Every Minute\n"
+                          "END:VEVENT";
+
+        CalendarEvent* event = parseICSEvent(icsEvent);
+        REQUIRE(event != nullptr);
+
+        time_t startDate = event->startTime;
+        time_t endDate = startDate + 30 * 86400;
+
+        auto occurrences = parser.expandRecurringEventV2(event, startDate, endDate);
+        CHECK(occurrences.size() == (size_t)CalendarStreamParser::MAX_OCCURRENCES_PER_QUERY);
+
+        for (auto* occ : occurrences)
+            delete occ;
+        delete event;
+    }
+}
+
 } // namespace V2Tests
@@ -0,0 +1,442 @@
+/**
+ * @file test_feed_tail.cpp
+ * @brief Tests for incremental downloads of append-only calendar feeds
+ *
+ * Tests cover:
+ * - Feed tail tracking: offset after the last END:VEVENT, anchor checksum
+ * - Content-Range parsing and anchor comparison
+ * - Feed tail sidecar next to the binary event cache
+ * - Resumed downloads against the mock server: appended events only, their
+ *   TZIDs resolved through the VTIMEZONEs of the feed header, and full downloads when the server ignores Range, the feed was edited or
+ *   shrank, or the body was compressed
+ */
+
+#include <doctest.h>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "event_cache.h"
+#include "feed_tail.h"
+#include "mock_calendar_fetcher.h"
+#include "timezone_engine.h"
+
+namespace {
+
+const char* const FEED_URL = "https://bookings.example.com/export.ics";
+const char* const CACHE_PATH = "/cache/events_incremental.bin";
+
+String booking(int day, const char* summary) {
+    char text[256];
+    snprintf(text, sizeof(text),
+             "BEGIN:VEVENT\r\nUID:booking-%d@example.com\r\nDTSTART:202603%02dT090000Z\r\n"
+             "DTEND:202603%02dT100000Z\r\nSUMMARY:%s\r\nEND:VEVENT\r\n",
+             day, day, day, summary);
+    return String(text);
+}
+
+const char* const FEED_HEADER = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Test//Bookings//EN\r\n";
+const char* const FEED_FOOTER = "END:VCALENDAR\r\n";
+
+// Outlook-style feed: its only zone is the VTIMEZONE in the header
+const char* const OUTLOOK_FEED_HEADER = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Test//Outlook//EN\r\n"
+                                        "BEGIN:VTIMEZONE\r\nTZID:W. Europe Standard Time\r\n"
+                                        "BEGIN:STANDARD\r\nDTSTART:16010101T030000\r\nTZOFFSETFROM:+0200\r\n"
+                                        "TZOFFSETTO:+0100\r\nRRULE:FREQ=YEARLY;INTERVAL=1;BYDAY=-1SU;BYMONTH=10\r\n"
+                                        "END:STANDARD\r\n"
+                                        "BEGIN:DAYLIGHT\r\nDTSTART:16010101T020000\r\nTZOFFSETFROM:+0100\r\n"
+                                        "TZOFFSETTO:+0200\r\nRRULE:FREQ=YEARLY;INTERVAL=1;BYDAY=-1SU;BYMONTH=3\r\n"
+                                        "END:DAYLIGHT\r\nEND:VTIMEZONE\r\n";
+
+String localBooking(int day, const char* summary) {
+    char text[320];
+    snprintf(text, sizeof(text),
+             "BEGIN:VEVENT\r\nUID:local-%d@example.com\r\n"
+             "DTSTART;TZID=\"W. Europe Standard Time\":202603%02dT090000\r\n"
+             "DTEND;TZID=\"W. Europe Standard Time\":202603%02dT100000\r\nSUMMARY:%s\r\nEND:VEVENT\r\n",
+             day, day, day, summary);
+    return String(text);
+}
+
+String feedWith(int bookings) {
+    String ics = FEED_HEADER;
+    for (int i = 1; i <= bookings; i++) {
+        ics += booking(i, "Room booking");
+    }
+    ics += FEED_FOOTER;
+    return ics;
+}
+
+FeedTail tailOf(const String& ics, size_t readSize) {
+    StringStream source(ics);
+    FeedTailStream tracker(&source);
+    std::vector<uint8_t> buffer(readSize);
+    while (tracker.readBytes(buffer.data(), buffer.size()) > 0) {
+    }
+    return tracker.getTail();
+}
+
+FilteredEvents* fetchMarch(CalendarStreamParser& parser, const FeedTail* resume) {
+    return parser.fetchEventsInRange(FEED_URL, utcFor(2026, 3, 1, 0, 0), utcFor(2026, 4, 1, 0, 0), 500, "",
+                                     nullptr, resume);
+}
+
+void resetServer() {
+    MockHttpServer::instance().reset();
+}
+
+} // namespace
+
+TEST_SUITE("FeedTail - Tracking")
+{
+    TEST_CASE("The tail points just past the last END:VEVENT line")
+    {
+        String ics = feedWith(3);
+        FeedTail tail = tailOf(ics, 4096);
+
+        size_t expected = ics.length() - strlen(FEED_FOOTER);
+        CHECK(tail.offset == expected);
+        CHECK(tail.length == ics.length());
+        CHECK(tail.isValid());
+
+        uint32_t anchorCrc = EventCache::calculateCRC32(
+            (const uint8_t*)ics.c_str() + expected - FEED_TAIL_ANCHOR_BYTES, FEED_TAIL_ANCHOR_BYTES);
+        CHECK(tail.anchorCrc == anchorCrc);
+        CHECK(tail.rangeStart() == expected - FEED_TAIL_ANCHOR_BYTES);
+        CHECK(tail.rangeHeader() == "bytes=" + String((unsigned long)tail.rangeStart()) + "-");
+    }
+
+    TEST_CASE("Read sizes do not change the tail")
+    {
+        String ics = feedWith(4);
+        FeedTail whole = tailOf(ics, 8192);
+        size_t sizes[] = {1, 7, 64, 65, 300};
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            FeedTail tail = tailOf(ics, sizes[i]);
+            CHECK(tail.offset == whole.offset);
+            CHECK(tail.anchorCrc == whole.anchorCrc);
+        }
+
+        // Byte-wise reads track the same way
+        StringStream source(ics);
+        FeedTailStream tracker(&source);
+        while (tracker.read() >= 0) {
+        }
+        CHECK(tracker.getTail().offset == whole.offset);
+        CHECK(tracker.getTail().anchorCrc == whole.anchorCrc);
+    }
+
+    TEST_CASE("LF line endings and indented text are handled")
+    {
+        String ics = "BEGIN:VCALENDAR\nBEGIN:VEVENT\nUID:a@example.com\nDESCRIPTION:see END:VEVENT\n"
+                     " END:VEVENT folded\nSUMMARY:Lunch with the whole team\nEND:VEVENT\nEND:VCALENDAR\n";
+        FeedTail tail = tailOf(ics, 16);
+        CHECK(tail.offset == (size_t)ics.indexOf("END:VCALENDAR"));
+    }
+
+    TEST_CASE("A feed without VEVENTs has no tail")
+    {
+        FeedTail tail = tailOf(String(FEED_HEADER) + FEED_FOOTER, 64);
+        CHECK(tail.offset == 0);
+        CHECK_FALSE(tail.isValid());
+    }
+
+    TEST_CASE("The prefix is delivered first and not counted")
+    {
+        String appended = booking(9, "Late booking") + FEED_FOOTER;
+        StringStream source(appended);
+        FeedTailStream tracker(&source, 5000, "BEGIN:VCALENDAR\r\n");
+
+        String text = tracker.readString();
+        CHECK(text == "BEGIN:VCALENDAR\r\n" + appended);
+        FeedTail tail = tracker.getTail();
+        CHECK(tail.offset == 5000 + appended.length() - strlen(FEED_FOOTER));
+        CHECK(tail.length == 5000 + appended.length());
+    }
+}
+
+TEST_SUITE("FeedTail - Resume checks")
+{
+    TEST_CASE("Content-Range headers are parsed")
+    {
+        size_t first = 0;
+        size_t total = 0;
+        CHECK(FeedTail::parseContentRange("bytes 1200-4999/5000", first, total));
+        CHECK(first == 1200);
+        CHECK(total == 5000);
+
+        CHECK(FeedTail::parseContentRange("bytes 0-99/*", first, total));
+        CHECK(first == 0);
+        CHECK(total == 0);
+
+        CHECK_FALSE(FeedTail::parseContentRange("", first, total));
+        CHECK_FALSE(FeedTail::parseContentRange("bytes */5000", first, total));
+        CHECK_FALSE(FeedTail::parseContentRange("items 0-9/10", first, total));
+        CHECK_FALSE(FeedTail::parseContentRange("bytes 10-20", first, total));
+    }
+
+    TEST_CASE("The anchor must match the first bytes of the partial body")
+    {
+        String ics = feedWith(2);
+        FeedTail tail = tailOf(ics, 512);
+
+        StringStream same((ics.substring(tail.rangeStart())));
+        CHECK(tail.matchesAnchor(&same));
+        CHECK(same.readString() == FEED_FOOTER);
+
+        String edited = ics;
+        edited.setCharAt(tail.offset - 10, 'X');
+        StringStream changed((edited.substring(tail.rangeStart())));
+        CHECK_FALSE(tail.matchesAnchor(&changed));
+
+        StringStream shortBody((ics.substring(tail.offset - 10)));
+        CHECK_FALSE(tail.matchesAnchor(&shortBody));
+    }
+
+    TEST_CASE("Feed tails round-trip next to the cache file")
+    {
+        EventCache::remove(CACHE_PATH);
+        CHECK(EventCache::getFeedTailPath(CACHE_PATH) == "/cache/events_incremental.tail");
+
+        FeedTail saved = tailOf(feedWith(3), 256);
+        REQUIRE(EventCache::saveFeedTail(CACHE_PATH, saved, 1775000000));
+
+        FeedTail loaded;
+        time_t coveredUntil = 0;
+        REQUIRE(EventCache::loadFeedTail(CACHE_PATH, loaded, coveredUntil));
+        CHECK(loaded.offset == saved.offset);
+        CHECK(loaded.anchorCrc == saved.anchorCrc);
+        CHECK(loaded.length == saved.length);
+        CHECK(coveredUntil == 1775000000);
+        CHECK(loaded.zones.empty());
+
+        // The VTIMEZONEs of the feed follow, one per line
+        FeedZone zone;
+        zone.tzid  = "W. Europe Standard Time";
+        zone.posix = "CET-1CEST,M3.5.0/2,M10.5.0/3";
+        saved.zones.push_back(zone);
+        REQUIRE(EventCache::saveFeedTail(CACHE_PATH, saved, 1775000000));
+        REQUIRE(EventCache::loadFeedTail(CACHE_PATH, loaded, coveredUntil));
+        CHECK(loaded.offset == saved.offset);
+        CHECK(coveredUntil == 1775000000);
+        REQUIRE(loaded.zones.size() == 1);
+        CHECK(loaded.zones[0].tzid == zone.tzid);
+        CHECK(loaded.zones[0].posix == zone.posix);
+
+        // An invalid tail clears the sidecar, and so does remove()
+        CHECK_FALSE(EventCache::saveFeedTail(CACHE_PATH, FeedTail(), 0));
+        CHECK_FALSE(LittleFS.exists(EventCache::getFeedTailPath(CACHE_PATH)));
+        REQUIRE(EventCache::saveFeedTail(CACHE_PATH, saved, 1775000000));
+        CHECK(EventCache::remove(CACHE_PATH));
+        CHECK_FALSE(EventCache::loadFeedTail(CACHE_PATH, loaded, coveredUntil));
+    }
+}
+
+TEST_SUITE("FeedTail - Incremental fetch")
+{
+    TEST_CASE("Only the appended events are downloaded and parsed")
+    {
+        resetServer();
+        MockHttpServer& server = MockHttpServer::instance();
+        String first = feedWith(20);
+        server.setResource(FEED_URL, first, "\"v1\"", "");
+
+        CalendarStreamParser parser;
+        parser.setIncremental(true);
+        FilteredEvents* full = fetchMarch(parser, nullptr);
+        REQUIRE(full->success);
+        CHECK_FALSE(full->partial);
+        CHECK(full->events.size() == 20);
+        REQUIRE(full->tail.isValid());
+        CHECK(full->tail.length == first.length());
+        FeedTail tail = full->tail;
+        delete full;
+
+        String second = first.substring(0, first.length() - strlen(FEED_FOOTER)) + booking(25, "New booking") +
+                        booking(26, "Another booking") + FEED_FOOTER;
+        server.setResource(FEED_URL, second, "\"v2\"", "");
+        size_t bytesBefore = server.bytesSent;
+
+        FilteredEvents* partial = fetchMarch(parser, &tail);
+        REQUIRE(partial->success);
+        CHECK(partial->partial);
+        REQUIRE(partial->events.size() == 2);
+        CHECK(partial->events[0]->summary == "New booking");
+        CHECK(partial->events[1]->summary == "Another booking");
+        CHECK(partial->validators.etag == "\"v2\"");
+        CHECK(server.partialResponses == 1);
+
+        size_t sent = server.bytesSent - bytesBefore;
+        CHECK(sent == second.length() - tail.rangeStart());
+        CHECK(partial->bytesTransferred == sent);
+        CHECK(sent * 5 < second.length());
+
+        // The new tail is the one a full download would record
+        FeedTail expected = tailOf(second, 1024);
+        CHECK(partial->tail.offset == expected.offset);
+        CHECK(partial->tail.anchorCrc == expected.anchorCrc);
+        CHECK(partial->tail.length == second.length());
+        delete partial;
+    }
+
+    TEST_CASE("Appended events use the VTIMEZONEs of the feed header")
+    {
+        resetServer();
+        EventCache::remove(CACHE_PATH);
+        MockHttpServer& server = MockHttpServer::instance();
+        String first = OUTLOOK_FEED_HEADER;
+        for (int day = 2; day <= 20; day++) {
+            first += localBooking(day, "Room booking");
+        }
+        first += FEED_FOOTER;
+        server.setResource(FEED_URL, first, "\"v1\"", "");
+
+        CalendarStreamParser parser;
+        parser.setIncremental(true);
+        FilteredEvents* full = fetchMarch(parser, nullptr);
+        REQUIRE(full->success);
+        REQUIRE(full->tail.isValid());
+        REQUIRE(full->tail.zones.size() == 1);
+        CHECK(full->tail.zones[0].tzid == "W. Europe Standard Time");
+
+        // The tail goes through its sidecar, as between two wakes
+        REQUIRE(EventCache::saveFeedTail(CACHE_PATH, full->tail, utcFor(2026, 4, 1, 0, 0)));
+        delete full;
+        FeedTail tail;
+        time_t coveredUntil = 0;
+        REQUIRE(EventCache::loadFeedTail(CACHE_PATH, tail, coveredUntil));
+
+        // One booking before and one after the switch to summer time
+        String second = first.substring(0, first.length() - strlen(FEED_FOOTER)) + localBooking(27, "Before DST") +
+                        localBooking(30, "After DST") + FEED_FOOTER;
+        server.setResource(FEED_URL, second, "\"v2\"", "");
+
+        FilteredEvents* partial = fetchMarch(parser, &tail);
+        REQUIRE(partial->success);
+        REQUIRE(partial->partial);
+        REQUIRE(partial->events.size() == 2);
+        CHECK(partial->events[0]->startTime == utcFor(2026, 3, 27, 8, 0));
+        CHECK(partial->events[1]->startTime == utcFor(2026, 3, 30, 7, 0));
+
+        // The same times as a full parse of the grown feed
+        CalendarStreamParser fresh;
+        FilteredEvents* reference = fetchMarch(fresh, nullptr);
+        REQUIRE(reference->success);
+        REQUIRE(reference->events.size() == 21);
+        for (size_t i = 0; i < partial->events.size(); i++) {
+            const CalendarEvent* expected = reference->events[19 + i];
+            CHECK(partial->events[i]->summary == expected->summary);
+            CHECK(partial->events[i]->startTime == expected->startTime);
+            CHECK(partial->events[i]->endTime == expected->endTime);
+        }
+
+        // The zones carry over to the tail of the partial download
+        REQUIRE(partial->tail.zones.size() == 1);
+        CHECK(partial->tail.zones[0].posix == tail.zones[0].posix);
+        delete reference;
+        delete partial;
+        EventCache::remove(CACHE_PATH);
+    }
+
+    TEST_CASE("Nothing appended keeps the previous tail")
+    {
+        resetServer();
+        String ics = feedWith(5);
+        MockHttpServer::instance().setResource(FEED_URL, ics, "", "");
+        FeedTail tail = tailOf(ics, 512);
+
+        CalendarStreamParser parser;
+        parser.setIncremental(true);
+        FilteredEvents* result = fetchMarch(parser, &tail);
+        REQUIRE(result->success);
+        CHECK(result->partial);
+        CHECK(result->events.empty());
+        CHECK(result->tail.offset == tail.offset);
+        CHECK(result->tail.anchorCrc == tail.anchorCrc);
+        CHECK(result->tail.length == ics.length());
+        delete result;
+    }
+
+    TEST_CASE("Servers without range support send the full feed")
+    {
+        resetServer();
+        MockHttpServer& server = MockHttpServer::instance();
+        String ics = feedWith(6);
+        server.setResource(FEED_URL, ics, "", "");
+        server.ignoreRange = true;
+        FeedTail tail = tailOf(feedWith(4), 512);
+
+        CalendarStreamParser parser;
+        parser.setIncremental(true);
+        FilteredEvents* result = fetchMarch(parser, &tail);
+        REQUIRE(result->success);
+        CHECK_FALSE(result->partial);
+        CHECK(result->events.size() == 6);
+        CHECK(result->tail.offset == tailOf(ics, 512).offset);
+        CHECK(server.requests == 1);
+        delete result;
+    }
+
+    TEST_CASE("An edited feed is downloaded again in full")
+    {
+        resetServer();
+        MockHttpServer& server = MockHttpServer::instance();
+        String original = feedWith(6);
+        FeedTail tail = tailOf(original, 512);
+
+        // The last booking was renamed and one added: the anchor differs
+        String edited = String(FEED_HEADER);
+        for (int i = 1; i <= 5; i++) {
+            edited += booking(i, "Room booking");
+        }
+        edited += booking(6, "Room booking (moved)") + booking(7, "Room booking") + FEED_FOOTER;
+        server.setResource(FEED_URL, edited, "", "");
+
+        CalendarStreamParser parser;
+        parser.setIncremental(true);
+        FilteredEvents* result = fetchMarch(parser, &tail);
+        REQUIRE(result->success);
+        CHECK_FALSE(result->partial);
+        CHECK(result->events.size() == 7);
+        CHECK(server.requests == 2);
+        CHECK(server.rangeRequests == 1);
+        delete result;
+    }
+
+    TEST_CASE("A shorter feed is downloaded again in full")
+    {
+        resetServer();
+        MockHttpServer& server = MockHttpServer::instance();
+        FeedTail tail = tailOf(feedWith(30), 512);
+        server.setResource(FEED_URL, feedWith(3), "", "");
+
+        CalendarStreamParser parser;
+        parser.setIncremental(true);
+        FilteredEvents* result = fetchMarch(parser, &tail);
+        REQUIRE(result->success);
+        CHECK_FALSE(result->partial);
+        CHECK(result->events.size() == 3);
+        CHECK(server.requests == 2);
+        delete result;
+    }
+
+    TEST_CASE("Calendars that are not incremental never send Range")
+    {
+        resetServer();
+        MockHttpServer& server = MockHttpServer::instance();
+        String ics = feedWith(4);
+        server.setResource(FEED_URL, ics, "", "");
+        FeedTail tail = tailOf(ics, 512);
+
+        CalendarStreamParser parser;
+        FilteredEvents* result = fetchMarch(parser, &tail);
+        REQUIRE(result->success);
+        CHECK_FALSE(result->partial);
+        CHECK_FALSE(result->tail.isValid());
+        CHECK(result->events.size() == 4);
+        CHECK(server.rangeRequests == 0);
+        delete result;
+    }
+}
@@ -0,0 +1,261 @@
+/**
+ * @file test_fetch_scheduler.cpp
+ * @brief Tests for the concurrent fetch scheduler
+ *
+ * Tests cover:
+ * - Every queued job runs once and reports its result
+ * - The concurrency bound (number of simultaneous "TLS sessions")
+ * - Simulated wake cycles with mocked source latencies: wall time close to
+ *   the slowest source instead of the sum
+ * - Calendars parsed on concurrent workers match a sequential parse
+ */
+
+#include <doctest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "fetch_scheduler.h"
+#include "timezone_engine.h"
+
+namespace {
+
+/**
+ * @brief Mocked source: holds a "session" for latencyMs and tracks overlap
+ */
+struct SimulatedSource {
+    std::atomic<int>* active;
+    std::atomic<int>* peak;
+    int latencyMs;
+    bool result;
+
+    bool operator()() const {
+        int now = ++(*active);
+        int seen = peak->load();
+        while (now > seen && !peak->compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(latencyMs));
+        --(*active);
+        return result;
+    }
+};
+
+/**
+ * @brief One wake cycle: weather plus three calendars with the given latencies
+ */
+unsigned long simulateWake(size_t maxConcurrent, const int (&latencies)[4], size_t& peakSessions) {
+    const char* const names[] = {"weather", "calendar work", "calendar family", "calendar holidays"};
+    std::atomic<int> active(0);
+    std::atomic<int> peak(0);
+
+    FetchScheduler scheduler(maxConcurrent);
+    for (int i = 0; i < 4; i++) {
+        SimulatedSource source = {&active, &peak, latencies[i], true};
+        scheduler.addJob(names[i], source);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t succeeded = scheduler.run();
+    unsigned long wallMs = (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+
+    CHECK(succeeded == 4);
+    CHECK(scheduler.getPeakConcurrency() == (size_t)peak.load());
+    peakSessions = (size_t)peak.load();
+    return wallMs;
+}
+
+struct Occurrence {
+    time_t start;
+    std::string summary;
+
+    bool operator<(const Occurrence& other) const {
+        return start != other.start ? start < other.start : summary < other.summary;
+    }
+    bool operator==(const Occurrence& other) const { return start == other.start && summary == other.summary; }
+};
+
+std::vector<Occurrence> parseCalendar(const std::string& ics, time_t startDate, time_t endDate) {
+    CalendarStreamParser parser;
+    StringStream stream((String(ics.c_str())));
+    std::vector<Occurrence> occurrences;
+    parser.streamParseFromStream(
+        &stream,
+        [&occurrences](CalendarEvent* event) {
+            Occurrence occurrence;
+            occurrence.start = event->startTime;
+            occurrence.summary = event->summary.c_str();
+            occurrences.push_back(occurrence);
+            delete event;
+        },
+        startDate, endDate);
+    std::sort(occurrences.begin(), occurrences.end());
+    return occurrences;
+}
+
+} // namespace
+
+TEST_SUITE("FetchScheduler")
+{
+    TEST_CASE("Every job runs once and reports its result")
+    {
+        FetchScheduler scheduler(2);
+        std::atomic<int> calls[3];
+        for (int i = 0; i < 3; i++) {
+            calls[i] = 0;
+        }
+        scheduler.addJob("weather", [&calls]() {
+            calls[0]++;
+            return true;
+        });
+        scheduler.addJob("calendar ok", [&calls]() {
+            calls[1]++;
+            return true;
+        });
+        scheduler.addJob("calendar down", [&calls]() {
+            calls[2]++;
+            return false;
+        });
+        CHECK(scheduler.getPendingCount() == 3);
+
+        CHECK(scheduler.run() == 2);
+        CHECK(scheduler.getPendingCount() == 0);
+        for (int i = 0; i < 3; i++) {
+            CHECK(calls[i] == 1);
+        }
+
+        const std::vector<FetchJobResult>& results = scheduler.getResults();
+        REQUIRE(results.size() == 3);
+        CHECK(results[0].name == "weather");
+        CHECK(results[0].success);
+        CHECK(results[1].success);
+        CHECK(results[2].name == "calendar down");
+        CHECK_FALSE(results[2].success);
+    }
+
+    TEST_CASE("Empty queue returns immediately")
+    {
+        FetchScheduler scheduler;
+        CHECK(scheduler.run() == 0);
+        CHECK(scheduler.getResults().empty());
+        CHECK(scheduler.getPeakConcurrency() == 0);
+    }
+
+    TEST_CASE("One worker runs the jobs in order")
+    {
+        FetchScheduler scheduler(1);
+        std::vector<int> order;
+        for (int i = 0; i < 4; i++) {
+            scheduler.addJob("job", [&order, i]() {
+                order.push_back(i);
+                return true;
+            });
+        }
+        CHECK(scheduler.run() == 4);
+        CHECK(scheduler.getPeakConcurrency() == 1);
+        REQUIRE(order.size() == 4);
+        for (int i = 0; i < 4; i++) {
+            CHECK(order[i] == i);
+        }
+    }
+
+    TEST_CASE("Scheduler can be reused for the next wake")
+    {
+        FetchScheduler scheduler(2);
+        scheduler.addJob("first", []() { return true; });
+        CHECK(scheduler.run() == 1);
+
+        // Ids index the results of the next run, whatever was queued before
+        CHECK(scheduler.addJob("second", []() { return false; }) == 0);
+        size_t third = scheduler.addJob("third", []() { return true; });
+        CHECK(third == 1);
+        CHECK(scheduler.run() == 1);
+        REQUIRE(scheduler.getResults().size() == 2);
+        CHECK(scheduler.getResults()[0].name == "second");
+        CHECK(scheduler.getResults()[third].name == "third");
+        CHECK(scheduler.getResults()[third].success);
+    }
+}
+
+TEST_SUITE("FetchScheduler - Simulation")
+{
+    TEST_CASE("Simultaneous sessions never exceed the bound")
+    {
+        const int latencies[4] = {30, 30, 30, 30};
+        for (size_t bound = 1; bound <= 4; bound++) {
+            CAPTURE(bound);
+            size_t peak = 0;
+            simulateWake(bound, latencies, peak);
+            CHECK(peak <= bound);
+            CHECK(peak >= 1);
+        }
+    }
+
+    TEST_CASE("Wall time approaches the slowest source")
+    {
+        // Weather, then three calendars of different size
+        const int latencies[4] = {40, 160, 90, 60};
+        const int slowest = 160;
+        const int sum = 40 + 160 + 90 + 60;
+
+        size_t peak = 0;
+        unsigned long sequentialMs = simulateWake(1, latencies, peak);
+        CHECK(peak == 1);
+        unsigned long pairMs = simulateWake(2, latencies, peak);
+        unsigned long parallelMs = simulateWake(4, latencies, peak);
+        CHECK(peak == 4);
+
+        MESSAGE("weather 40 ms + calendars 160/90/60 ms (sum ", sum, " ms, slowest ", slowest, " ms)");
+        MESSAGE("  sequential:    ", sequentialMs, " ms");
+        MESSAGE("  2 concurrent:  ", pairMs, " ms");
+        MESSAGE("  4 concurrent:  ", parallelMs, " ms");
+
+        CHECK(sequentialMs >= (unsigned long)sum);
+        CHECK(parallelMs >= (unsigned long)slowest);
+        // Generous margins: the host may be loaded
+        CHECK(parallelMs < (unsigned long)(slowest + sum) / 2);
+        CHECK(pairMs < sequentialMs);
+    }
+
+    TEST_CASE("Calendars parsed concurrently match a sequential parse")
+    {
+        std::string calendars[3] = {
+            loadFixture("test/fixtures/google_calendar.ics"),
+            loadFixture("test/fixtures/holidays.ics"),
+            loadFixture("test/fixtures/google_calendar.ics"),
+        };
+        const time_t ranges[3][2] = {
+            {utcFor(2025, 10, 1, 0, 0), utcFor(2025, 11, 1, 0, 0)},
+            {utcFor(2024, 1, 1, 0, 0), utcFor(2024, 12, 31, 0, 0)},
+            {utcFor(2020, 1, 1, 0, 0), utcFor(2026, 1, 1, 0, 0)},
+        };
+
+        std::vector<Occurrence> expected[3];
+        for (int i = 0; i < 3; i++) {
+            REQUIRE(!calendars[i].empty());
+            expected[i] = parseCalendar(calendars[i], ranges[i][0], ranges[i][1]);
+        }
+
+        std::vector<Occurrence> actual[3];
+        FetchScheduler scheduler(3);
+        for (int i = 0; i < 3; i++) {
+            scheduler.addJob("calendar", [&calendars, &ranges, &actual, i]() {
+                actual[i] = parseCalendar(calendars[i], ranges[i][0], ranges[i][1]);
+                return !actual[i].empty();
+            });
+        }
+        CHECK(scheduler.run() == 3);
+
+        for (int i = 0; i < 3; i++) {
+            CAPTURE(i);
+            CHECK(actual[i] == expected[i]);
+        }
+    }
+}
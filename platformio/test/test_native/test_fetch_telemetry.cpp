@@ -0,0 +1,272 @@
+/**
+ * @file test_fetch_telemetry.cpp
+ * @brief Tests for the per-source fetch telemetry kept across deep sleep
+ *
+ * Tests cover:
+ * - Ring buffer order, overwriting and dropping of old wakes
+ * - Truncated source names, saturated figures and the serial dump line
+ * - Serialized image: round trip, short buffers, corruption
+ * - RTC image with a LittleFS copy flushed every few wakes
+ * - Timings of calendar requests through the stream parser
+ */
+
+#include <doctest.h>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../mock_littlefs.h"
+#include "calendar_stream_parser.h"
+#include "connection_pool.h"
+#include "fetch_telemetry.h"
+#include "mock_calendar_fetcher.h"
+
+namespace {
+
+FetchTelemetryRecord entryFor(const char* source, uint32_t parseMs) {
+    FetchTelemetryRecord entry;
+    entry.setSource(source);
+    entry.parseMs = parseMs;
+    return entry;
+}
+
+// Source names of the records held, oldest first
+std::vector<std::string> sourcesOf(const FetchTelemetry& telemetry) {
+    std::vector<std::string> sources;
+    std::vector<FetchTelemetryRecord> records = telemetry.getRecords();
+    for (size_t i = 0; i < records.size(); i++) {
+        sources.push_back(records[i].source);
+    }
+    return sources;
+}
+
+// One wake recording a record per source, then saved for the next wake
+void runWake(const char* const* sources, size_t count) {
+    FetchTelemetry telemetry;
+    telemetry.load();
+    telemetry.beginWake();
+    for (size_t i = 0; i < count; i++) {
+        telemetry.record(entryFor(sources[i], 10 * (i + 1)));
+    }
+    CHECK(telemetry.save());
+}
+
+const char* const CALENDARS[] = {"Work", "Family"};
+
+} // namespace
+
+TEST_SUITE("FetchTelemetry")
+{
+    TEST_CASE("Records are kept oldest first and the oldest is overwritten when full")
+    {
+        FetchTelemetry telemetry(3, 10);
+        CHECK(telemetry.beginWake() == 1);
+        telemetry.record(entryFor("A", 1));
+        telemetry.record(entryFor("B", 2));
+        CHECK(telemetry.beginWake() == 2);
+        telemetry.record(entryFor("C", 3));
+        telemetry.record(entryFor("D", 4));
+
+        CHECK(telemetry.size() == 3);
+        CHECK(sourcesOf(telemetry) == std::vector<std::string>{"B", "C", "D"});
+        std::vector<FetchTelemetryRecord> records = telemetry.getRecords();
+        CHECK(records[0].wake == 1);
+        CHECK(records[1].wake == 2);
+        CHECK(records[2].parseMs == 4);
+    }
+
+    TEST_CASE("Records of wakes past the kept number are dropped")
+    {
+        FetchTelemetry telemetry(10, 2);
+        telemetry.beginWake();
+        telemetry.record(entryFor("wake1", 0));
+        telemetry.beginWake();
+        telemetry.record(entryFor("wake2", 0));
+        CHECK(telemetry.size() == 2);
+
+        telemetry.beginWake();
+        CHECK(sourcesOf(telemetry) == std::vector<std::string>{"wake2"});
+        telemetry.beginWake();
+        CHECK(telemetry.size() == 0);
+    }
+
+    TEST_CASE("Names are truncated and figures saturate")
+    {
+        FetchTelemetryRecord entry;
+        entry.setSource("A calendar with a very long name");
+        CHECK(std::string(entry.source) == std::string("A calendar with a very long name").substr(0, 15));
+
+        FetchTimings timings;
+        timings.dnsMs = 12;
+        timings.connectMs = 40;
+        timings.tlsMs = 900;
+        timings.ttfbMs = 100000;
+        timings.retries = 2;
+        timings.reused = true;
+        entry.setTimings(timings);
+        entry.setEvents(70000, 25, 3);
+        CHECK(entry.dnsMs == 12);
+        CHECK(entry.tlsMs == 900);
+        CHECK(entry.ttfbMs == 65535);
+        CHECK(entry.eventsParsed == 65535);
+        CHECK(entry.eventsFiltered == 25);
+        CHECK(entry.retries == 2);
+        CHECK((entry.flags & FetchTelemetryRecord::FLAG_REUSED) != 0);
+
+        entry.bytes = 48213;
+        entry.flags |= FetchTelemetryRecord::FLAG_LOADED | FetchTelemetryRecord::FLAG_SPOOLED;
+        String line = FetchTelemetry::format(entry);
+        CHECK(line.indexOf("A calendar with") >= 0);
+        CHECK(line.indexOf(" ok ") >= 0);
+        CHECK(line.indexOf("tls 900") >= 0);
+        CHECK(line.indexOf("(reused)") >= 0);
+        CHECK(line.indexOf("48213 bytes") >= 0);
+        CHECK(line.indexOf("(spooled)") >= 0);
+        CHECK(line.indexOf("events 65535/25/3") >= 0);
+        CHECK(line.indexOf("retries 2") >= 0);
+    }
+
+    TEST_CASE("Serialized image round-trips")
+    {
+        FetchTelemetry telemetry(6, 4);
+        telemetry.beginWake();
+        telemetry.record(entryFor("Work", 120));
+        telemetry.beginWake();
+        telemetry.record(entryFor("Family", 80));
+
+        std::vector<uint8_t> image(1024);
+        size_t length = telemetry.serialize(image.data(), image.size());
+        REQUIRE(length > 0);
+
+        FetchTelemetry restored(6, 4);
+        REQUIRE(restored.deserialize(image.data(), length));
+        CHECK(restored.getWake() == 2);
+        CHECK(sourcesOf(restored) == std::vector<std::string>{"Work", "Family"});
+        CHECK(restored.getRecords()[0].parseMs == 120);
+
+        // The wake number continues where the image left off
+        CHECK(restored.beginWake() == 3);
+    }
+
+    TEST_CASE("A short image keeps the newest records")
+    {
+        FetchTelemetry telemetry(6, 4);
+        telemetry.beginWake();
+        telemetry.record(entryFor("A", 1));
+        telemetry.record(entryFor("B", 2));
+        telemetry.record(entryFor("C", 3));
+
+        std::vector<uint8_t> full(1024);
+        size_t fullLength = telemetry.serialize(full.data(), full.size());
+        size_t headerLength = fullLength - 3 * sizeof(FetchTelemetryRecord);
+        std::vector<uint8_t> image(headerLength + 2 * sizeof(FetchTelemetryRecord) + 5);
+        size_t length = telemetry.serialize(image.data(), image.size());
+        CHECK(length == headerLength + 2 * sizeof(FetchTelemetryRecord));
+
+        FetchTelemetry restored(6, 4);
+        REQUIRE(restored.deserialize(image.data(), length));
+        CHECK(sourcesOf(restored) == std::vector<std::string>{"B", "C"});
+
+        // A smaller ring keeps the newest records of a larger image
+        FetchTelemetry small(1, 4);
+        REQUIRE(small.deserialize(full.data(), fullLength));
+        CHECK(sourcesOf(small) == std::vector<std::string>{"C"});
+
+        CHECK(telemetry.serialize(image.data(), 4) == 0);
+    }
+
+    TEST_CASE("Corrupted or foreign images are rejected")
+    {
+        FetchTelemetry telemetry(4, 4);
+        telemetry.beginWake();
+        telemetry.record(entryFor("Work", 1));
+        std::vector<uint8_t> image(512);
+        size_t length = telemetry.serialize(image.data(), image.size());
+
+        FetchTelemetry target(4, 4);
+        target.beginWake();
+        target.record(entryFor("Kept", 1));
+
+        std::vector<uint8_t> corrupt(image.begin(), image.begin() + length);
+        corrupt[length - 3] ^= 0xFF;
+        CHECK_FALSE(target.deserialize(corrupt.data(), corrupt.size()));
+        CHECK_FALSE(target.deserialize(image.data(), length - 1));
+        std::vector<uint8_t> foreign(image.begin(), image.begin() + length);
+        foreign[0] ^= 0xFF;
+        CHECK_FALSE(target.deserialize(foreign.data(), foreign.size()));
+        CHECK_FALSE(target.deserialize(nullptr, 0));
+
+        CHECK(sourcesOf(target) == std::vector<std::string>{"Kept"});
+    }
+
+    TEST_CASE("Records survive deep sleep in RTC memory and are flushed every few wakes")
+    {
+        LittleFS.clear();
+        FetchTelemetry::clearRtcImage();
+
+        for (int wake = 1; wake < FETCH_TELEMETRY_FLUSH_WAKES; wake++) {
+            runWake(CALENDARS, 2);
+        }
+        CHECK_FALSE(LittleFS.exists(FETCH_TELEMETRY_FILE));
+
+        FetchTelemetry beforeFlush;
+        REQUIRE(beforeFlush.load());
+        CHECK(beforeFlush.getWake() == FETCH_TELEMETRY_FLUSH_WAKES - 1);
+        CHECK(beforeFlush.size() == 2 * (FETCH_TELEMETRY_FLUSH_WAKES - 1));
+
+        runWake(CALENDARS, 2);
+        CHECK(LittleFS.exists(FETCH_TELEMETRY_FILE));
+
+        // The wake after a flush only updates RTC memory
+        runWake(CALENDARS, 1);
+        FetchTelemetry current;
+        REQUIRE(current.load());
+        CHECK(current.getWake() == FETCH_TELEMETRY_FLUSH_WAKES + 1);
+
+        // After a power loss the file holds the records up to its flush
+        FetchTelemetry::clearRtcImage();
+        FetchTelemetry afterPowerLoss;
+        REQUIRE(afterPowerLoss.load());
+        CHECK(afterPowerLoss.getWake() == FETCH_TELEMETRY_FLUSH_WAKES);
+        CHECK(afterPowerLoss.size() == 2 * FETCH_TELEMETRY_FLUSH_WAKES);
+        CHECK(sourcesOf(afterPowerLoss).back() == "Family");
+
+        LittleFS.clear();
+        FetchTelemetry::clearRtcImage();
+        FetchTelemetry empty;
+        CHECK_FALSE(empty.load());
+        CHECK(empty.size() == 0);
+    }
+
+    TEST_CASE("Calendar requests report their connection and retries")
+    {
+        const char* const workUrl = "https://calendar.example.com/work.ics";
+        const char* const familyUrl = "https://calendar.example.com/family.ics";
+        String ics = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nBEGIN:VEVENT\r\nUID:1@example.com\r\n"
+                     "DTSTART:20260310T090000Z\r\nDTEND:20260310T100000Z\r\nSUMMARY:Standup\r\n"
+                     "END:VEVENT\r\nEND:VCALENDAR\r\n";
+        MockHttpServer& server = MockHttpServer::instance();
+        server.reset();
+        server.setResource(workUrl, ics, "", "");
+        server.setResource(familyUrl, ics, "", "");
+
+        ConnectionPool pool(2);
+        CalendarStreamParser parser;
+        parser.setConnectionPool(&pool);
+
+        FilteredEvents* first = parser.fetchEventsInRange(workUrl, 0, 0x7FFFFFFF, 0);
+        REQUIRE(first->success);
+        CHECK_FALSE(first->timings.reused);
+        CHECK(first->timings.retries == 0);
+        delete first;
+
+        // Same host: the second calendar goes over the open connection
+        FilteredEvents* second = parser.fetchEventsInRange(familyUrl, 0, 0x7FFFFFFF, 0);
+        REQUIRE(second->success);
+        CHECK(second->timings.reused);
+        CHECK(second->timings.connectMs == 0);
+        CHECK(parser.getLastTimings().reused);
+        delete second;
+        parser.setConnectionPool(nullptr);
+    }
+}
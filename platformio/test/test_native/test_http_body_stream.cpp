@@ -0,0 +1,152 @@
+/**
+ * @file test_http_body_stream.cpp
+ * @brief Tests for the HTTP/1.1 body framing adapter
+ *
+ * Tests cover:
+ * - Content-Length bodies stop at the end of the body
+ * - Chunked bodies: framing removed, extensions and trailers skipped
+ * - Completion tracking and drain() for reusing the connection
+ * - Malformed and truncated framing
+ */
+
+#include <doctest.h>
+#include <string>
+
+#include "../mock_arduino.h"
+#include "http_body_stream.h"
+#include "mock_calendar_fetcher.h"
+
+namespace {
+
+std::string readAll(HttpBodyStream& body, size_t chunkSize) {
+    std::string output;
+    uint8_t buffer[256];
+    size_t count;
+    while ((count = body.readBytes(buffer, chunkSize < sizeof(buffer) ? chunkSize : sizeof(buffer))) > 0) {
+        output.append((const char*)buffer, count);
+    }
+    return output;
+}
+
+} // namespace
+
+TEST_SUITE("HttpBodyStream")
+{
+    TEST_CASE("Content-Length body ends at its length")
+    {
+        // The next response on the connection must not be read
+        StringStream connection((String("BEGIN:VCALENDARHTTP/1.1 200 OK")));
+        HttpBodyStream body(&connection, 15, false);
+
+        CHECK(readAll(body, 4) == "BEGIN:VCALENDAR");
+        CHECK(body.isComplete());
+        CHECK_FALSE(body.hasError());
+        CHECK(body.getBodyBytes() == 15);
+        CHECK(connection.available() == 15);
+    }
+
+    TEST_CASE("Chunked body is unframed")
+    {
+        std::string framed = "4\r\nBEGI\r\nb;name=value\r\nN:VCALENDAR\r\n0\r\n\r\nNEXT";
+        StringStream connection((String(framed)));
+        HttpBodyStream body(&connection, -1, true);
+
+        CHECK(body.peek() == 'B');
+        CHECK(readAll(body, 3) == "BEGIN:VCALENDAR");
+        CHECK(body.isComplete());
+        CHECK_FALSE(body.hasError());
+        CHECK(body.getBodyBytes() == 15);
+        CHECK(connection.readString() == "NEXT");
+    }
+
+    TEST_CASE("Trailer fields after the last chunk are skipped")
+    {
+        StringStream connection((String("3\r\nabc\r\n0\r\nExpires: never\r\nX-Check: 1\r\n\r\n")));
+        HttpBodyStream body(&connection, -1, true);
+        CHECK(body.readString() == "abc");
+        CHECK(body.isComplete());
+        CHECK(connection.available() == 0);
+    }
+
+    TEST_CASE("Chunked framing of a calendar round-trips")
+    {
+        std::string calendar(10000, 'x');
+        for (size_t i = 0; i < calendar.size(); i += 75) {
+            calendar[i] = '\n';
+        }
+        const size_t chunkSizes[] = {1, 7, 4000, 20000};
+        for (size_t i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++) {
+            CAPTURE(chunkSizes[i]);
+            StringStream connection(MockHttpServer::chunk(String(calendar), chunkSizes[i]));
+            HttpBodyStream body(&connection, -1, true);
+            CHECK(readAll(body, 97) == calendar);
+            CHECK(body.isComplete());
+        }
+    }
+
+    TEST_CASE("Empty bodies are complete")
+    {
+        StringStream empty((String("")));
+        HttpBodyStream lengthBody(&empty, 0, false);
+        CHECK(lengthBody.available() == 0);
+        CHECK(lengthBody.isComplete());
+
+        StringStream lastChunk((String("0\r\n\r\n")));
+        HttpBodyStream chunkedBody(&lastChunk, -1, true);
+        CHECK(chunkedBody.read() == -1);
+        CHECK(chunkedBody.isComplete());
+    }
+
+    TEST_CASE("Body without framing ends with the connection")
+    {
+        StringStream connection((String("BEGIN:VCALENDAR")));
+        HttpBodyStream body(&connection, -1, false);
+        CHECK(readAll(body, 64) == "BEGIN:VCALENDAR");
+        CHECK(body.isComplete());
+        CHECK_FALSE(body.hasError());
+    }
+
+    TEST_CASE("drain() discards an unread tail within the limit")
+    {
+        std::string calendar(3000, 'y');
+        StringStream connection(MockHttpServer::chunk(String(calendar), 500));
+        HttpBodyStream body(&connection, -1, true);
+
+        uint8_t head[100];
+        CHECK(body.readBytes(head, sizeof(head)) == sizeof(head));
+        CHECK_FALSE(body.isComplete());
+        CHECK(body.drain(4096));
+        CHECK(body.isComplete());
+        CHECK(connection.available() == 0);
+
+        StringStream longConnection(MockHttpServer::chunk(String(calendar), 500));
+        HttpBodyStream longBody(&longConnection, -1, true);
+        CHECK_FALSE(longBody.drain(1000));
+        CHECK_FALSE(longBody.isComplete());
+    }
+
+    TEST_CASE("Malformed and truncated framing is an error")
+    {
+        StringStream badSize((String("zz\r\nabc\r\n0\r\n\r\n")));
+        HttpBodyStream badSizeBody(&badSize, -1, true);
+        CHECK(readAll(badSizeBody, 64).empty());
+        CHECK(badSizeBody.hasError());
+
+        StringStream missingCrlf((String("3\r\nabcX\r\n0\r\n\r\n")));
+        HttpBodyStream missingCrlfBody(&missingCrlf, -1, true);
+        readAll(missingCrlfBody, 64);
+        CHECK(missingCrlfBody.hasError());
+        CHECK_FALSE(missingCrlfBody.isComplete());
+
+        StringStream cutChunk((String("10\r\nabc")));
+        HttpBodyStream cutChunkBody(&cutChunk, -1, true);
+        CHECK(readAll(cutChunkBody, 64) == "abc");
+        CHECK(cutChunkBody.hasError());
+
+        StringStream cutLength((String("abc")));
+        HttpBodyStream cutLengthBody(&cutLength, 10, false);
+        CHECK(readAll(cutLengthBody, 64) == "abc");
+        CHECK(cutLengthBody.hasError());
+        CHECK_FALSE(cutLengthBody.isComplete());
+    }
+}
@@ -0,0 +1,393 @@
+/**
+ * @file test_ics_line_reader.cpp
+ * @brief Unit tests and benchmark for the block-reading ICS line tokenizer
+ *
+ * Tests cover:
+ * - CRLF, LF and bare CR line terminators
+ * - RFC 5545 unfolding, including folds split across block reads
+ * - Line truncation at the buffer limit
+ * - Slow streams: blocking reads instead of polling, read timeout, stall time
+ * - Throughput on the Google Calendar fixture versus the previous
+ *   char-by-char String implementation
+ */
+
+#include <doctest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "ics_line_reader.h"
+
+namespace {
+
+/**
+ * @brief Stream that hands out at most chunkSize bytes per available() call,
+ * emulating a network stream delivering data in small TCP segments
+ */
+class ChunkedStream : public Stream {
+  public:
+    ChunkedStream(const std::string& data, size_t chunkSize)
+        : content(data), position(0), chunkSize(chunkSize) {}
+
+    int available() override {
+        size_t remaining = content.size() - position;
+        return (int)(remaining < chunkSize ? remaining : chunkSize);
+    }
+    String readString() override { return ""; }
+    int read() override { return position < content.size() ? (unsigned char)content[position++] : -1; }
+    int peek() override { return position < content.size() ? (unsigned char)content[position] : -1; }
+    size_t readBytes(uint8_t* buffer, size_t length) override {
+        size_t toRead = (size_t)available();
+        if (length < toRead) toRead = length;
+        memcpy(buffer, content.data() + position, toRead);
+        position += toRead;
+        return toRead;
+    }
+
+  private:
+    std::string content;
+    size_t position;
+    size_t chunkSize;
+};
+
+/**
+ * @brief Stream that delivers segmentSize bytes every intervalMs of real
+ * time, like a slow TLS connection. readBytes() blocks until data arrives or
+ * the stream timeout expires; after stallAt bytes nothing more arrives.
+ */
+class ThrottledStream : public Stream {
+  public:
+    ThrottledStream(const std::string& data, size_t segmentSize, unsigned intervalMs,
+                    size_t stallAt = std::string::npos)
+        : content(data), position(0), segmentSize(segmentSize), intervalMs(intervalMs),
+          stallAt(stallAt < data.size() ? stallAt : data.size()), start(std::chrono::steady_clock::now()) {}
+
+    int available() override { return (int)(arrived() - position); }
+    String readString() override { return ""; }
+    int read() override {
+        uint8_t c;
+        return readBytes(&c, 1) == 1 ? c : -1;
+    }
+    int peek() override { return available() > 0 ? (unsigned char)content[position] : -1; }
+    size_t readBytes(uint8_t* buffer, size_t length) override {
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(getTimeout());
+        while (available() == 0 && position < content.size() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        size_t toRead = (size_t)available();
+        if (length < toRead) toRead = length;
+        memcpy(buffer, content.data() + position, toRead);
+        position += toRead;
+        return toRead;
+    }
+
+    /** @brief Real time until the whole content (up to stallAt) has arrived */
+    double deliverySeconds() const {
+        size_t segments = (stallAt + segmentSize - 1) / segmentSize;
+        return segments > 0 ? (segments - 1) * intervalMs / 1000.0 : 0;
+    }
+
+  private:
+    size_t arrived() const {
+        long long elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+        size_t bytes = (size_t)(elapsedMs / intervalMs + 1) * segmentSize;
+        return bytes < stallAt ? bytes : stallAt;
+    }
+
+    std::string content;
+    size_t position;
+    size_t segmentSize;
+    unsigned intervalMs;
+    size_t stallAt;
+    std::chrono::steady_clock::time_point start;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<std::string> readAllLines(Stream* stream, size_t bufferSize = IcsLineReader::DEFAULT_BUFFER_SIZE) {
+    IcsLineReader reader(stream, bufferSize);
+    std::vector<std::string> lines;
+    const char* line = nullptr;
+    size_t length = 0;
+    while (reader.next(line, length)) {
+        lines.push_back(std::string(line, length));
+    }
+    return lines;
+}
+
+/**
+ * @brief The line reader used by CalendarStreamParser before IcsLineReader:
+ * one read() and one String append per byte, no unfolding
+ */
+String legacyReadLine(Stream* stream, bool& eof) {
+    String line = "";
+    eof = false;
+
+    if (!stream->available()) {
+        eof = true;
+        return line;
+    }
+
+    while (stream->available()) {
+        char c = stream->read();
+        if (c == '\r') {
+            if (stream->available() && stream->peek() == '\n') {
+                stream->read();
+            }
+            break;
+        } else if (c == '\n') {
+            break;
+        } else {
+            line += c;
+        }
+        if (line.length() > 1024) {
+            break;
+        }
+    }
+    return line;
+}
+
+} // namespace
+
+TEST_SUITE("IcsLineReader - Tokenizing") {
+
+    TEST_CASE("Line terminators - CRLF, LF and bare CR") {
+        StringStream stream(String("A:1\r\nB:2\nC:3\rD:4"));
+        std::vector<std::string> lines = readAllLines(&stream);
+
+        REQUIRE(lines.size() == 4);
+        CHECK(lines[0] == "A:1");
+        CHECK(lines[1] == "B:2");
+        CHECK(lines[2] == "C:3");
+        CHECK(lines[3] == "D:4");
+    }
+
+    TEST_CASE("Empty lines are returned with zero length") {
+        StringStream stream(String("A:1\r\n\r\nB:2\r\n"));
+        std::vector<std::string> lines = readAllLines(&stream);
+
+        REQUIRE(lines.size() == 3);
+        CHECK(lines[1].empty());
+    }
+
+    TEST_CASE("Empty stream returns no lines") {
+        StringStream stream(String(""));
+        IcsLineReader reader(&stream);
+        const char* line = nullptr;
+        size_t length = 0;
+
+        CHECK_FALSE(reader.next(line, length));
+        CHECK(reader.isEof());
+        CHECK(reader.getBytesRead() == 0);
+    }
+
+    TEST_CASE("Folded lines are unfolded") {
+        StringStream stream(String("SUMMARY:Long sum\r\n mary text\r\n\tcontinued\r\nUID:1\r\n"));
+        std::vector<std::string> lines = readAllLines(&stream);
+
+        REQUIRE(lines.size() == 2);
+        CHECK(lines[0] == "SUMMARY:Long summary textcontinued");
+        CHECK(lines[1] == "UID:1");
+    }
+
+    TEST_CASE("Folded lines fixture") {
+        std::string content = loadFixture("test/fixtures/folded_lines.ics");
+        REQUIRE(!content.empty());
+
+        StringStream stream((String(content)));
+        std::vector<std::string> lines = readAllLines(&stream);
+
+        bool foundSummary = false;
+        for (size_t i = 0; i < lines.size(); i++) {
+            CHECK(lines[i].find("\n") == std::string::npos);
+            if (lines[i].compare(0, 8, "SUMMARY:") == 0) {
+                foundSummary = true;
+                CHECK(lines[i] == "SUMMARY:Event with a very long summary that will be folded across multiple "
+                                  "lines to test the line folding functionality of the ICS parser");
+            }
+        }
+        CHECK(foundSummary);
+    }
+
+    TEST_CASE("Folds split across block reads") {
+        // Build a file much larger than the buffer with folds at every offset
+        std::string content;
+        std::vector<std::string> expected;
+        for (int i = 0; i < 200; i++) {
+            std::string value = "DESCRIPTION:" + std::string(i % 70 + 1, 'a' + (i % 26));
+            std::string folded = value.substr(0, value.size() / 2) + "\r\n " + value.substr(value.size() / 2);
+            content += folded + "\r\n";
+            expected.push_back(value);
+        }
+
+        for (size_t chunk = 1; chunk <= 7; chunk += 3) {
+            ChunkedStream stream(content, chunk);
+            std::vector<std::string> lines = readAllLines(&stream, 1024);
+            CHECK(lines == expected);
+        }
+    }
+
+    TEST_CASE("Overlong lines are truncated and the remainder dropped") {
+        std::string longLine = "X-LONG:" + std::string(5000, 'x');
+        StringStream stream((String(longLine + "\r\nUID:after\r\n")));
+        IcsLineReader reader(&stream, 1024);
+        const char* line = nullptr;
+        size_t length = 0;
+
+        REQUIRE(reader.next(line, length));
+        CHECK(length == reader.getMaxLineLength());
+        CHECK(IcsLineReader::startsWith(line, length, "X-LONG:"));
+
+        REQUIRE(reader.next(line, length));
+        CHECK(std::string(line, length) == "UID:after");
+        CHECK(reader.getLinesTruncated() == 1);
+        CHECK_FALSE(reader.next(line, length));
+    }
+
+    TEST_CASE("Counters") {
+        String data("BEGIN:VCALENDAR\r\nVERSION:2.0\r\nEND:VCALENDAR\r\n");
+        StringStream stream(data);
+        IcsLineReader reader(&stream);
+        const char* line = nullptr;
+        size_t length = 0;
+        while (reader.next(line, length)) {
+        }
+
+        CHECK(reader.getBytesRead() == data.length());
+        CHECK(reader.getLinesRead() == 3);
+        CHECK(reader.getLinesTruncated() == 0);
+    }
+
+    TEST_CASE("startsWith and contains helpers") {
+        const char* line = "\xEF\xBB\xBF" "BEGIN:VCALENDAR";
+        size_t length = strlen(line);
+
+        CHECK_FALSE(IcsLineReader::startsWith(line, length, "BEGIN:VCALENDAR"));
+        CHECK(IcsLineReader::contains(line, length, "BEGIN:VCALENDAR"));
+        CHECK(IcsLineReader::startsWith("END:VEVENT", 10, "END:"));
+        CHECK_FALSE(IcsLineReader::startsWith("END", 3, "END:"));
+        CHECK_FALSE(IcsLineReader::contains("BEGIN:VEVEN", 11, "VEVENT"));
+    }
+}
+
+TEST_SUITE("IcsLineReader - Slow streams") {
+
+    TEST_CASE("Reading keeps pace with the stream instead of polling") {
+        std::string content = loadFixture("test/fixtures/google_calendar.ics");
+        REQUIRE(content.size() > 20000);
+        content.resize(20000);
+
+        // 20 segments, 10 ms apart: the last one arrives after ~190 ms
+        ThrottledStream stream(content, 1000, 10);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        IcsLineReader reader(&stream);
+        const char* line = nullptr;
+        size_t length = 0;
+        while (reader.next(line, length)) {
+        }
+        double elapsed = secondsSince(start);
+
+        MESSAGE("Delivery ", stream.deliverySeconds() * 1000, " ms, read in ", elapsed * 1000, " ms");
+        CHECK(reader.getBytesRead() == content.size());
+        CHECK(elapsed >= stream.deliverySeconds());
+        // Polling with 100 ms sleeps would add up to one interval per segment
+        CHECK(elapsed < stream.deliverySeconds() + 0.1);
+    }
+
+    TEST_CASE("A stream that stops delivering ends after its timeout") {
+        std::string content = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nBEGIN:VEVENT\r\nUID:a\r\nEND:VEVENT\r\n";
+        ThrottledStream stream(content, 16, 5, 40);
+        stream.setTimeout(50);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::string> lines = readAllLines(&stream);
+        double elapsed = secondsSince(start);
+
+        CHECK(lines.size() == 3);
+        CHECK(lines[0] == "BEGIN:VCALENDAR");
+        CHECK(elapsed >= 0.05);
+        CHECK(elapsed < 0.5);
+    }
+
+    TEST_CASE("Parsing a slow stream takes about its delivery time") {
+        std::string content = loadFixture("test/fixtures/google_calendar.ics");
+        REQUIRE(!content.empty());
+
+        // The whole fixture in 25 segments, 8 ms apart
+        size_t segmentSize = content.size() / 24 + 1;
+        ThrottledStream stream(content, segmentSize, 8);
+        CalendarStreamParser parser;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool parsed = parser.streamParseFromStream(&stream, [](CalendarEvent* event) { delete event; });
+        double elapsed = secondsSince(start);
+
+        MESSAGE("Delivery ", stream.deliverySeconds() * 1000, " ms, parsed in ", elapsed * 1000, " ms");
+        CHECK(parsed);
+        CHECK(parser.getLastParseStats().eventsParsed > 0);
+        CHECK(parser.getLastParseStats().bytesRead == content.size());
+        CHECK(parser.getLastParseStats().stallMs <= parser.getLastParseStats().parseMs);
+        CHECK(elapsed < stream.deliverySeconds() + 0.15);
+    }
+}
+
+TEST_SUITE("IcsLineReader - Benchmark") {
+
+    TEST_CASE("Throughput on google_calendar.ics versus legacy readLineFromStream") {
+        std::string content = loadFixture("test/fixtures/google_calendar.ics");
+        REQUIRE(!content.empty());
+
+        const int iterations = 5;
+        String data(content);
+        size_t legacyLines = 0;
+        size_t readerLines = 0;
+
+        std::chrono::steady_clock::time_point legacyStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            StringStream stream(data);
+            bool eof = false;
+            legacyLines = 0;
+            while (!eof) {
+                String line = legacyReadLine(&stream, eof);
+                if (!eof) {
+                    legacyLines++;
+                }
+            }
+        }
+        double legacySeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - legacyStart).count();
+
+        std::chrono::steady_clock::time_point readerStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            StringStream stream(data);
+            IcsLineReader reader(&stream);
+            const char* line = nullptr;
+            size_t length = 0;
+            while (reader.next(line, length)) {
+            }
+            readerLines = reader.getLinesRead();
+        }
+        double readerSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - readerStart).count();
+
+        double totalBytes = (double)content.size() * iterations;
+        double legacyRate = legacySeconds > 0 ? totalBytes / legacySeconds : 0;
+        double readerRate = readerSeconds > 0 ? totalBytes / readerSeconds : 0;
+
+        MESSAGE("google_calendar.ics: ", content.size(), " bytes x ", iterations, " iterations");
+        MESSAGE("  legacy readLineFromStream: ", (unsigned long)legacyRate, " bytes/s (", legacyLines, " physical lines)");
+        MESSAGE("  IcsLineReader:             ", (unsigned long)readerRate, " bytes/s (", readerLines, " logical lines)");
+
+        // Unfolding can only merge lines
+        CHECK(readerLines > 0);
+        CHECK(readerLines <= legacyLines);
+    }
+}
@@ -0,0 +1,364 @@
+/**
+ * @file test_inflate_stream.cpp
+ * @brief Tests for the streaming gzip / deflate decoder
+ *
+ * Tests cover:
+ * - Content-Encoding negotiation
+ * - Stored, fixed and dynamic Huffman blocks in gzip, zlib and raw deflate
+ * - Optional gzip header fields
+ * - Byte-exact inflation of a gzipped calendar larger than the window
+ * - Parsing a gzipped calendar through the stream parser and the mock server
+ * - Truncated and corrupt input
+ * - Throughput benchmark (inflate alone and inflate + parse)
+ */
+
+#include <doctest.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "inflate_stream.h"
+#include "mock_calendar_fetcher.h"
+#include "timezone_engine.h"
+
+namespace {
+
+// Uncompressed form of the small vectors below
+const char SMALL_ICS[] = "BEGIN:VCALENDAR\r\nBEGIN:VEVENT\r\nSUMMARY:Standup\r\nEND:VEVENT\r\n"
+                         "BEGIN:VEVENT\r\nSUMMARY:Standup\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n";
+
+// SMALL_ICS as one fixed Huffman block (zlib level 9, raw deflate)
+const uint8_t SMALL_DEFLATE[] = {
+    0x73, 0x72, 0x75, 0xf7, 0xf4, 0xb3, 0x0a, 0x73, 0x76, 0xf4, 0x71, 0xf5, 0x73, 0x71,
+    0x0c, 0xe2, 0xe5, 0x72, 0x82, 0x08, 0xb8, 0x86, 0xb9, 0xfa, 0x85, 0xf0, 0x72, 0x05,
+    0x87, 0xfa, 0xfa, 0x3a, 0x06, 0x45, 0x5a, 0x05, 0x97, 0x24, 0xe6, 0xa5, 0x94, 0x16,
+    0xf0, 0x72, 0x01, 0x55, 0xc1, 0x25, 0x49, 0x50, 0x0a, 0x66, 0x23, 0x2c, 0x01, 0x00};
+
+const uint8_t ZLIB_HEADER[] = {0x78, 0xda};
+const uint8_t ZLIB_TRAILER[] = {0x78, 0xa3, 0x1f, 0xd7};
+const uint8_t GZIP_HEADER[] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03};
+const uint8_t GZIP_TRAILER[] = {0x6d, 0xe6, 0x2a, 0x2e, 0x76, 0x00, 0x00, 0x00};
+
+std::string bytes(const uint8_t* data, size_t length) {
+    return std::string((const char*)data, length);
+}
+
+std::string smallZlib() {
+    return bytes(ZLIB_HEADER, sizeof(ZLIB_HEADER)) + bytes(SMALL_DEFLATE, sizeof(SMALL_DEFLATE)) +
+           bytes(ZLIB_TRAILER, sizeof(ZLIB_TRAILER));
+}
+
+std::string smallGzip() {
+    return bytes(GZIP_HEADER, sizeof(GZIP_HEADER)) + bytes(SMALL_DEFLATE, sizeof(SMALL_DEFLATE)) +
+           bytes(GZIP_TRAILER, sizeof(GZIP_TRAILER));
+}
+
+/**
+ * @brief Inflate a whole compressed body, reading chunkSize bytes at a time
+ */
+std::string inflateAll(const std::string& compressed, InflateStream::Format format, size_t chunkSize,
+                       bool* error = nullptr) {
+    StringStream source((String(compressed)));
+    InflateStream inflater(&source, format);
+    REQUIRE(inflater.isValid());
+
+    std::string output;
+    std::vector<uint8_t> chunk(chunkSize);
+    size_t count;
+    while ((count = inflater.readBytes(chunk.data(), chunkSize)) > 0) {
+        output.append((const char*)chunk.data(), count);
+    }
+    if (error) {
+        *error = inflater.hasError();
+    } else {
+        CHECK_FALSE(inflater.hasError());
+        CHECK(inflater.isFinished());
+        CHECK(inflater.getInflatedBytes() == output.size());
+    }
+    return output;
+}
+
+struct Occurrence {
+    time_t start;
+    std::string summary;
+
+    bool operator<(const Occurrence& other) const {
+        return start != other.start ? start < other.start : summary < other.summary;
+    }
+    bool operator==(const Occurrence& other) const { return start == other.start && summary == other.summary; }
+};
+
+std::vector<Occurrence> parseStream(Stream* stream, time_t startDate, time_t endDate) {
+    CalendarStreamParser parser;
+    std::vector<Occurrence> occurrences;
+    bool ok = parser.streamParseFromStream(
+        stream,
+        [&occurrences](CalendarEvent* event) {
+            Occurrence occurrence;
+            occurrence.start = event->startTime;
+            occurrence.summary = event->summary.c_str();
+            occurrences.push_back(occurrence);
+            delete event;
+        },
+        startDate, endDate);
+    CHECK(ok);
+    std::sort(occurrences.begin(), occurrences.end());
+    return occurrences;
+}
+
+} // namespace
+
+TEST_SUITE("InflateStream")
+{
+    TEST_CASE("Content-Encoding negotiation")
+    {
+        InflateStream::Format format = InflateStream::FORMAT_DEFLATE;
+        CHECK(InflateStream::formatForEncoding("gzip", format));
+        CHECK(format == InflateStream::FORMAT_GZIP);
+        CHECK(InflateStream::formatForEncoding(" X-GZIP ", format));
+        CHECK(format == InflateStream::FORMAT_GZIP);
+        CHECK(InflateStream::formatForEncoding("deflate", format));
+        CHECK(format == InflateStream::FORMAT_DEFLATE);
+
+        CHECK_FALSE(InflateStream::formatForEncoding("", format));
+        CHECK_FALSE(InflateStream::formatForEncoding("identity", format));
+        CHECK_FALSE(InflateStream::formatForEncoding("br", format));
+    }
+
+    TEST_CASE("Fixed Huffman block in every container")
+    {
+        std::string raw = bytes(SMALL_DEFLATE, sizeof(SMALL_DEFLATE));
+        CHECK(inflateAll(raw, InflateStream::FORMAT_DEFLATE, 64) == SMALL_ICS);
+        CHECK(inflateAll(smallZlib(), InflateStream::FORMAT_DEFLATE, 64) == SMALL_ICS);
+        CHECK(inflateAll(smallGzip(), InflateStream::FORMAT_GZIP, 64) == SMALL_ICS);
+    }
+
+    TEST_CASE("Stored block")
+    {
+        // zlib header, final stored block of 5 bytes, Adler-32
+        const uint8_t stored[] = {0x78, 0x01, 0x01, 0x05, 0x00, 0xfa, 0xff, 'h', 'e',
+                                  'l',  'l',  'o',  0x06, 0x2c, 0x02, 0x15};
+        CHECK(inflateAll(bytes(stored, sizeof(stored)), InflateStream::FORMAT_DEFLATE, 3) == "hello");
+    }
+
+    TEST_CASE("Optional gzip header fields are skipped")
+    {
+        // FEXTRA, FNAME and FCOMMENT in front of the same body
+        std::string header = bytes(GZIP_HEADER, sizeof(GZIP_HEADER));
+        header[3] = 0x04 | 0x08 | 0x10;
+        header += std::string("\x03\x00xyz", 5);
+        header += std::string("calendar.ics", 13);
+        header += std::string("exported", 9);
+        std::string gzip = header + bytes(SMALL_DEFLATE, sizeof(SMALL_DEFLATE)) +
+                           bytes(GZIP_TRAILER, sizeof(GZIP_TRAILER));
+        CHECK(inflateAll(gzip, InflateStream::FORMAT_GZIP, 64) == SMALL_ICS);
+    }
+
+    TEST_CASE("Byte reads match block reads")
+    {
+        StringStream source((String(smallGzip())));
+        InflateStream inflater(&source, InflateStream::FORMAT_GZIP);
+        CHECK(inflater.peek() == 'B');
+        CHECK(inflater.available() > 0);
+
+        std::string output;
+        int c;
+        while ((c = inflater.read()) >= 0) {
+            output += (char)c;
+        }
+        CHECK(output == SMALL_ICS);
+        CHECK(inflater.peek() == -1);
+        CHECK(inflater.available() == 0);
+        CHECK(inflater.getCompressedBytes() == smallGzip().size());
+    }
+
+    TEST_CASE("Gzipped calendar inflates byte-exact")
+    {
+        std::string plain = loadFixture("test/fixtures/google_calendar.ics");
+        std::string gzip = loadFixture("test/fixtures/google_calendar.ics.gz");
+        REQUIRE(!plain.empty());
+        REQUIRE(!gzip.empty());
+        REQUIRE(plain.size() > InflateStream::WINDOW_SIZE * 4);
+
+        // Odd chunk sizes exercise reads across the ring boundary
+        const size_t chunkSizes[] = {1, 97, 4096, 65536};
+        for (size_t i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++) {
+            CAPTURE(chunkSizes[i]);
+            std::string inflated = inflateAll(gzip, InflateStream::FORMAT_GZIP, chunkSizes[i]);
+            CHECK(inflated.size() == plain.size());
+            CHECK(inflated == plain);
+        }
+    }
+
+    TEST_CASE("Truncated input is an error")
+    {
+        std::string gzip = loadFixture("test/fixtures/google_calendar.ics.gz");
+        REQUIRE(!gzip.empty());
+
+        const size_t cuts[] = {5, 20, gzip.size() / 2, gzip.size() - 3};
+        for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+            CAPTURE(cuts[i]);
+            bool error = false;
+            inflateAll(gzip.substr(0, cuts[i]), InflateStream::FORMAT_GZIP, 512, &error);
+            CHECK(error);
+        }
+    }
+
+    TEST_CASE("Corrupt input is an error")
+    {
+        bool error = false;
+        CHECK(inflateAll("BEGIN:VCALENDAR", InflateStream::FORMAT_GZIP, 64, &error).empty());
+        CHECK(error);
+
+        // Invalid block type 3
+        const uint8_t badBlock[] = {0x07, 0x00};
+        error = false;
+        inflateAll(bytes(badBlock, sizeof(badBlock)), InflateStream::FORMAT_DEFLATE, 64, &error);
+        CHECK(error);
+
+        // Stored length and its complement disagree
+        const uint8_t badStored[] = {0x01, 0x05, 0x00, 0x00, 0x00, 'h', 'e', 'l', 'l', 'o'};
+        error = false;
+        inflateAll(bytes(badStored, sizeof(badStored)), InflateStream::FORMAT_DEFLATE, 64, &error);
+        CHECK(error);
+
+        // gzip length that does not match the body
+        std::string gzip = smallGzip();
+        gzip[gzip.size() - 4] = 0x10;
+        error = false;
+        inflateAll(gzip, InflateStream::FORMAT_GZIP, 64, &error);
+        CHECK(error);
+
+        // Flipped bits in the middle of a dynamic block
+        std::string calendar = loadFixture("test/fixtures/google_calendar.ics.gz");
+        REQUIRE(calendar.size() > 1000);
+        for (size_t i = 0; i < 64; i++) {
+            calendar[500 + i] = (char)(calendar[500 + i] ^ 0x5a);
+        }
+        error = false;
+        inflateAll(calendar, InflateStream::FORMAT_GZIP, 4096, &error);
+        CHECK(error);
+    }
+}
+
+TEST_SUITE("InflateStream - Parser")
+{
+    TEST_CASE("Gzipped calendar parses like the plain file")
+    {
+        std::string plain = loadFixture("test/fixtures/google_calendar.ics");
+        std::string gzip = loadFixture("test/fixtures/google_calendar.ics.gz");
+        REQUIRE(!gzip.empty());
+        time_t startDate = utcFor(2020, 1, 1, 0, 0);
+        time_t endDate = utcFor(2026, 1, 1, 0, 0);
+
+        StringStream plainStream((String(plain)));
+        std::vector<Occurrence> expected = parseStream(&plainStream, startDate, endDate);
+        REQUIRE(!expected.empty());
+
+        StringStream gzipSource((String(gzip)));
+        InflateStream inflater(&gzipSource, InflateStream::FORMAT_GZIP);
+        std::vector<Occurrence> actual = parseStream(&inflater, startDate, endDate);
+        CHECK_FALSE(inflater.hasError());
+        CHECK(actual == expected);
+    }
+
+    TEST_CASE("Encoded response through fetchEventsInRange")
+    {
+        std::string plain = loadFixture("test/fixtures/google_calendar.ics");
+        std::string gzip = loadFixture("test/fixtures/google_calendar.ics.gz");
+        time_t startDate = utcFor(2025, 1, 1, 0, 0);
+        time_t endDate = utcFor(2026, 1, 1, 0, 0);
+
+        MockHttpServer& server = MockHttpServer::instance();
+        server.reset();
+        server.setResource("https://example.com/plain.ics", String(plain), "\"p\"", "");
+        server.setResource("https://example.com/gzip.ics", String(gzip), "\"g\"", "", "gzip");
+
+        CalendarStreamParser parser;
+        FilteredEvents* expected = parser.fetchEventsInRange("https://example.com/plain.ics", startDate, endDate, 0);
+        FilteredEvents* actual = parser.fetchEventsInRange("https://example.com/gzip.ics", startDate, endDate, 0);
+        REQUIRE(expected->success);
+        REQUIRE(actual->success);
+        REQUIRE(actual->events.size() == expected->events.size());
+        CHECK(!actual->events.empty());
+        for (size_t i = 0; i < actual->events.size(); i++) {
+            CHECK(actual->events[i]->startTime == expected->events[i]->startTime);
+            CHECK(actual->events[i]->summary == expected->events[i]->summary);
+        }
+
+        CHECK(expected->bytesTransferred == plain.size());
+        CHECK(actual->bytesTransferred == gzip.size());
+        CHECK(parser.getLastParseStats().bytesRead == plain.size());
+        MESSAGE("transferred ", actual->bytesTransferred, " bytes instead of ", expected->bytesTransferred);
+
+        delete expected;
+        delete actual;
+        server.reset();
+    }
+
+    TEST_CASE("Corrupt encoded response fails the fetch")
+    {
+        std::string gzip = loadFixture("test/fixtures/google_calendar.ics.gz");
+        REQUIRE(!gzip.empty());
+
+        MockHttpServer& server = MockHttpServer::instance();
+        server.reset();
+        server.setResource("https://example.com/cut.ics", String(gzip.substr(0, gzip.size() / 2)), "", "",
+                           "gzip");
+
+        CalendarStreamParser parser;
+        FilteredEvents* result =
+            parser.fetchEventsInRange("https://example.com/cut.ics", utcFor(2025, 1, 1, 0, 0), utcFor(2026, 1, 1, 0, 0), 0);
+        CHECK_FALSE(result->success);
+        delete result;
+        server.reset();
+    }
+}
+
+TEST_SUITE("InflateStream - Benchmark")
+{
+    TEST_CASE("Inflate and parse throughput")
+    {
+        std::string plain = loadFixture("test/fixtures/google_calendar.ics");
+        std::string gzip = loadFixture("test/fixtures/google_calendar.ics.gz");
+        REQUIRE(!gzip.empty());
+        time_t startDate = utcFor(2025, 1, 1, 0, 0);
+        time_t endDate = utcFor(2026, 1, 1, 0, 0);
+        const int iterations = 5;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            CHECK(inflateAll(gzip, InflateStream::FORMAT_GZIP, 1024).size() == plain.size());
+        }
+        double inflateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                           iterations;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            StringStream stream((String(plain)));
+            parseStream(&stream, startDate, endDate);
+        }
+        double plainMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                         iterations;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            StringStream source((String(gzip)));
+            InflateStream inflater(&source, InflateStream::FORMAT_GZIP);
+            parseStream(&inflater, startDate, endDate);
+        }
+        double gzipMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                        iterations;
+
+        MESSAGE("google_calendar.ics: ", plain.size(), " bytes, gzip ", gzip.size(), " bytes (",
+                (double)plain.size() / gzip.size(), "x)");
+        MESSAGE("  inflate only:    ", inflateMs, " ms (", plain.size() / 1048.576 / inflateMs, " MB/s)");
+        MESSAGE("  parse plain:     ", plainMs, " ms");
+        MESSAGE("  inflate + parse: ", gzipMs, " ms");
+        CHECK(inflateMs > 0.0);
+    }
+}
@@ -0,0 +1,218 @@
+/**
+ * @file test_occurrence_iterator.cpp
+ * @brief Tests for lazy recurrence expansion with OccurrenceIterator
+ *
+ * Tests cover:
+ * - Iterator output matches expandRecurringEventV2 for every frequency
+ * - COUNT/UNTIL limits and invalid input
+ * - Non-recurring events
+ * - Allocations and time per expansion compared to the vector path
+ */
+
+#include <doctest.h>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "timezone_engine.h"
+
+namespace {
+
+CalendarEvent* makeEvent(CalendarStreamParser& parser, const char* rrule) {
+    String ics = "BEGIN:VEVENT\n"
+                 "UID:iterator@example.com\n"
+                 "SUMMARY:Recurring\n"
+                 "DTSTART:20250106T090000Z\n"
+                 "DTEND:20250106T100000Z\n";
+    if (rrule) {
+        ics += "RRULE:";
+        ics += rrule;
+        ics += "\n";
+    }
+    ics += "END:VEVENT\n";
+    return parser.parseEventFromBuffer(ics);
+}
+
+/**
+ * @brief Check that the iterator yields exactly what the vector path returns
+ *
+ * @return number of occurrences
+ */
+size_t checkMatchesVector(CalendarStreamParser& parser, CalendarEvent* event, time_t startDate, time_t endDate) {
+    std::vector<CalendarEvent*> expanded = parser.expandRecurringEventV2(event, startDate, endDate);
+
+    OccurrenceIterator it = parser.iterateOccurrences(event, startDate, endDate);
+    size_t index = 0;
+    time_t start, end;
+    while (it.next(start, end)) {
+        REQUIRE(index < expanded.size());
+        CHECK(start == expanded[index]->startTime);
+        CHECK(end == expanded[index]->endTime);
+        index++;
+    }
+    CHECK(index == expanded.size());
+    CHECK_FALSE(it.next(start, end));
+
+    for (auto occurrence : expanded) {
+        delete occurrence;
+    }
+    return index;
+}
+
+const char* const BENCHMARK_RULES[] = {
+    "FREQ=DAILY",
+    "FREQ=DAILY;BYDAY=MO,TU,WE,TH,FR",
+    "FREQ=WEEKLY;BYDAY=MO,WE,FR",
+    "FREQ=WEEKLY;INTERVAL=2",
+    "FREQ=MONTHLY;BYMONTHDAY=6",
+    "FREQ=YEARLY",
+};
+
+} // namespace
+
+TEST_SUITE("OccurrenceIterator")
+{
+    TEST_CASE("Matches expandRecurringEventV2 for every frequency")
+    {
+        CalendarStreamParser parser;
+        time_t startDate = utcFor(2025, 1, 1, 0, 0);
+        time_t endDate = utcFor(2027, 3, 1, 0, 0);
+
+        for (const char* rule : BENCHMARK_RULES) {
+            CAPTURE(std::string(rule));
+            CalendarEvent* event = makeEvent(parser, rule);
+            REQUIRE(event != nullptr);
+            CHECK(checkMatchesVector(parser, event, startDate, endDate) > 0);
+            delete event;
+        }
+    }
+
+    TEST_CASE("COUNT and UNTIL end the sequence")
+    {
+        CalendarStreamParser parser;
+        time_t startDate = utcFor(2025, 1, 1, 0, 0);
+        time_t endDate = utcFor(2026, 1, 1, 0, 0);
+
+        CalendarEvent* counted = makeEvent(parser, "FREQ=DAILY;COUNT=5");
+        REQUIRE(counted != nullptr);
+        CHECK(checkMatchesVector(parser, counted, startDate, endDate) == 5);
+        delete counted;
+
+        CalendarEvent* until = makeEvent(parser, "FREQ=WEEKLY;UNTIL=20250203T090000Z");
+        REQUIRE(until != nullptr);
+        CHECK(checkMatchesVector(parser, until, startDate, endDate) == 5);
+        delete until;
+    }
+
+    TEST_CASE("Non-recurring event is yielded once")
+    {
+        CalendarStreamParser parser;
+        CalendarEvent* event = makeEvent(parser, nullptr);
+        REQUIRE(event != nullptr);
+
+        OccurrenceIterator it = parser.iterateOccurrences(event, utcFor(2025, 1, 1, 0, 0), utcFor(2025, 2, 1, 0, 0));
+        time_t start, end;
+        REQUIRE(it.next(start, end));
+        CHECK(start == event->startTime);
+        CHECK(end == event->endTime);
+        CHECK_FALSE(it.next(start, end));
+
+        OccurrenceIterator outside =
+            parser.iterateOccurrences(event, utcFor(2025, 2, 1, 0, 0), utcFor(2025, 3, 1, 0, 0));
+        CHECK_FALSE(outside.next(start, end));
+        delete event;
+    }
+
+    TEST_CASE("Invalid input yields nothing")
+    {
+        CalendarStreamParser parser;
+        time_t start, end;
+
+        OccurrenceIterator none = parser.iterateOccurrences(nullptr, 0, 100);
+        CHECK_FALSE(none.next(start, end));
+
+        CalendarEvent* event = makeEvent(parser, "FREQ=DAILY");
+        REQUIRE(event != nullptr);
+        OccurrenceIterator reversed =
+            parser.iterateOccurrences(event, utcFor(2025, 2, 1, 0, 0), utcFor(2025, 1, 1, 0, 0));
+        CHECK_FALSE(reversed.next(start, end));
+        delete event;
+    }
+
+    TEST_CASE("Materialized occurrence carries the event data")
+    {
+        CalendarStreamParser parser;
+        CalendarEvent* event = makeEvent(parser, "FREQ=DAILY");
+        REQUIRE(event != nullptr);
+
+        time_t start = utcFor(2025, 2, 10, 9, 0);
+        CalendarEvent* occurrence = CalendarStreamParser::materializeOccurrence(event, start, start + 3600);
+        CHECK(occurrence->summary == "Recurring");
+        CHECK(occurrence->startTime == start);
+        CHECK(occurrence->endTime == start + 3600);
+        CHECK(occurrence->date.length() == 10);
+        delete occurrence;
+        delete event;
+    }
+}
+
+TEST_SUITE("OccurrenceIterator - Benchmark")
+{
+    TEST_CASE("Allocations and time per expansion")
+    {
+        const int rounds = 200;
+        CalendarStreamParser parser;
+        time_t startDate = utcFor(2025, 1, 1, 0, 0);
+        time_t endDate = utcFor(2026, 1, 1, 0, 0);
+
+        for (const char* rule : BENCHMARK_RULES) {
+            CalendarEvent* event = makeEvent(parser, rule);
+            REQUIRE(event != nullptr);
+
+            // Vector path: one CalendarEvent per occurrence plus vector growth.
+            // Both paths share the RRULE parsing, which is not counted here.
+            size_t vectorAllocations = 0;
+            size_t vectorOccurrences = 0;
+            std::chrono::steady_clock::time_point vectorStart = std::chrono::steady_clock::now();
+            for (int i = 0; i < rounds; i++) {
+                std::vector<CalendarEvent*> expanded = parser.expandRecurringEventV2(event, startDate, endDate);
+                vectorOccurrences = expanded.size();
+                vectorAllocations = expanded.size();
+                for (size_t capacity = 1; capacity < expanded.size(); capacity *= 2) {
+                    vectorAllocations++;
+                }
+                for (auto occurrence : expanded) {
+                    delete occurrence;
+                }
+            }
+            double vectorSeconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - vectorStart).count();
+
+            // Iterator path: occurrences are only (start, end) pairs
+            size_t iteratorOccurrences = 0;
+            std::chrono::steady_clock::time_point iteratorStart = std::chrono::steady_clock::now();
+            for (int i = 0; i < rounds; i++) {
+                OccurrenceIterator it = parser.iterateOccurrences(event, startDate, endDate);
+                time_t start, end;
+                iteratorOccurrences = 0;
+                while (it.next(start, end)) {
+                    iteratorOccurrences++;
+                }
+            }
+            double iteratorSeconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - iteratorStart).count();
+
+            MESSAGE(std::string(rule), ": ", (unsigned long)vectorOccurrences, " occurrences");
+            MESSAGE("  vector:   ", (unsigned long)vectorAllocations, " event/vector allocations, ",
+                    (unsigned long)(vectorSeconds * 1e6 / rounds), " us/expansion");
+            MESSAGE("  iterator: 0 event/vector allocations, ", (unsigned long)(iteratorSeconds * 1e6 / rounds), " us/expansion");
+
+            CHECK(iteratorOccurrences == vectorOccurrences);
+            delete event;
+        }
+    }
+}
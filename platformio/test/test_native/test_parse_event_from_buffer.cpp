@@ -0,0 +1,284 @@
+/**
+ * @file test_parse_event_from_buffer.cpp
+ * @brief Tests and benchmark for the single-pass VEVENT property parser
+ *
+ * Tests cover:
+ * - Parameters in any order (DTSTART;VALUE=DATE;TZID=...)
+ * - Quoted parameter values and properties with extra parameters
+ * - VALARM sub-components not overriding event properties
+ * - Raw (still folded, CRLF) buffers
+ * - Throughput on holidays.ics and google_calendar.ics versus the previous
+ *   extractValueFromBuffer-based implementation
+ */
+
+#include <doctest.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "calendar_event.h"
+#include "calendar_stream_parser.h"
+#include "ics_line_reader.h"
+
+namespace {
+
+std::string readFixture(const char* filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+/**
+ * @brief Split a calendar into unfolded VEVENT blocks, the same way
+ * streamParseFromStream() assembles its event buffer
+ */
+std::vector<String> collectEventBlocks(const std::string& content) {
+    StringStream stream((String(content)));
+    IcsLineReader reader(&stream);
+    std::vector<String> blocks;
+    String block;
+    bool inEvent = false;
+    const char* line = nullptr;
+    size_t length = 0;
+
+    while (reader.next(line, length)) {
+        if (IcsLineReader::startsWith(line, length, "BEGIN:VEVENT")) {
+            block = "";
+            inEvent = true;
+        }
+        if (inEvent) {
+            block.concat(line, length);
+            block += '\n';
+        }
+        if (inEvent && IcsLineReader::startsWith(line, length, "END:VEVENT")) {
+            blocks.push_back(block);
+            inEvent = false;
+        }
+    }
+    return blocks;
+}
+
+String legacyExtractValue(const String& buffer, const String& property) {
+    int pos = buffer.indexOf(property);
+    if (pos == -1) {
+        return "";
+    }
+
+    int valueStart = pos + property.length();
+    int valueEnd = buffer.indexOf("\n", valueStart);
+    if (valueEnd == -1) {
+        valueEnd = buffer.length();
+    }
+
+    String value = buffer.substring(valueStart, valueEnd);
+    value.trim();
+    value.replace("\r", "");
+    return value;
+}
+
+/**
+ * @brief Previous parseEventFromBuffer: one indexOf scan per property
+ */
+CalendarEvent* legacyParseEvent(const String& eventData) {
+    CalendarEvent* event = new CalendarEvent();
+
+    event->summary = legacyExtractValue(eventData, "SUMMARY:");
+    event->description = legacyExtractValue(eventData, "DESCRIPTION:");
+    event->uid = legacyExtractValue(eventData, "UID:");
+    event->status = legacyExtractValue(eventData, "STATUS:");
+    event->rrule = legacyExtractValue(eventData, "RRULE:");
+    event->isRecurring = !event->rrule.isEmpty();
+
+    const char* props[2] = {"DTSTART", "DTEND"};
+    for (int i = 0; i < 2; i++) {
+        String prop(props[i]);
+        String value;
+        String tzid;
+        bool isDate = false;
+
+        int tzPos = eventData.indexOf(prop + ";TZID=");
+        if (tzPos >= 0) {
+            int colonPos = eventData.indexOf(":", tzPos);
+            int newlinePos = eventData.indexOf("\n", colonPos);
+            if (newlinePos == -1)
+                newlinePos = eventData.length();
+            String paramLine = eventData.substring(tzPos, colonPos);
+            tzid = paramLine.substring(paramLine.indexOf("TZID=") + 5);
+            tzid.trim();
+            value = eventData.substring(colonPos + 1, newlinePos);
+            value.trim();
+        } else if (eventData.indexOf(prop + ";VALUE=DATE:") >= 0) {
+            value = legacyExtractValue(eventData, prop + ";VALUE=DATE:");
+            isDate = true;
+        } else {
+            value = legacyExtractValue(eventData, prop + ":");
+            if (value.isEmpty()) {
+                value = legacyExtractValue(eventData, prop + ";VALUE=DATE-TIME:");
+            }
+            isDate = !value.isEmpty() && value.length() == 8;
+        }
+
+        if (!value.isEmpty()) {
+            if (i == 0) {
+                event->setStartDateTime(value, tzid, isDate);
+            } else {
+                event->setEndDateTime(value, tzid, isDate);
+            }
+        }
+    }
+
+    return event;
+}
+
+void benchmarkFixture(const char* filepath) {
+    std::string content = readFixture(filepath);
+    REQUIRE(!content.empty());
+
+    std::vector<String> blocks = collectEventBlocks(content);
+    REQUIRE(!blocks.empty());
+
+    CalendarStreamParser parser;
+    const int iterations = 3;
+
+    // Both implementations must agree on every event before timing them
+    size_t mismatches = 0;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        CalendarEvent* legacy = legacyParseEvent(blocks[i]);
+        CalendarEvent* current = parser.parseEventFromBuffer(blocks[i]);
+        if (!(legacy->uid == current->uid) || !(legacy->summary == current->summary) ||
+            legacy->startTime != current->startTime || legacy->endTime != current->endTime ||
+            legacy->allDay != current->allDay || !(legacy->rrule == current->rrule)) {
+            mismatches++;
+        }
+        delete legacy;
+        delete current;
+    }
+    CHECK(mismatches == 0);
+
+    std::chrono::steady_clock::time_point legacyStart = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < blocks.size(); i++) {
+            delete legacyParseEvent(blocks[i]);
+        }
+    }
+    double legacySeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - legacyStart).count();
+
+    std::chrono::steady_clock::time_point currentStart = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < blocks.size(); i++) {
+            delete parser.parseEventFromBuffer(blocks[i]);
+        }
+    }
+    double currentSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - currentStart).count();
+
+    double totalEvents = (double)blocks.size() * iterations;
+    MESSAGE(std::string(filepath), ": ", blocks.size(), " events x ", iterations, " iterations");
+    MESSAGE("  legacy extractValueFromBuffer: ",
+            (unsigned long)(legacySeconds > 0 ? totalEvents / legacySeconds : 0), " events/s");
+    MESSAGE("  single-pass dispatcher:        ",
+            (unsigned long)(currentSeconds > 0 ? totalEvents / currentSeconds : 0), " events/s");
+}
+
+} // namespace
+
+TEST_SUITE("parseEventFromBuffer - Single-pass property parser") {
+
+    TEST_CASE("Parameters in any order") {
+        CalendarStreamParser parser;
+        String ics = "BEGIN:VEVENT\n"
+                     "UID:order@test\n"
+                     "DTSTART;VALUE=DATE;TZID=Europe/Zurich:20251119\n"
+                     "DTEND;TZID=Europe/Zurich;VALUE=DATE:20251120\n"
+                     "END:VEVENT\n";
+
+        CalendarEvent* event = parser.parseEventFromBuffer(ics);
+        REQUIRE(event != nullptr);
+        CHECK(event->allDay);
+        CHECK(event->startTime > 0);
+        CHECK(event->endTime > event->startTime);
+        delete event;
+    }
+
+    TEST_CASE("TZID and VALUE=DATE-TIME combined") {
+        CalendarStreamParser parser;
+        String plain = "BEGIN:VEVENT\nUID:a\nDTSTART;TZID=UTC0:20251119T140000\nEND:VEVENT\n";
+        String reordered = "BEGIN:VEVENT\nUID:a\nDTSTART;VALUE=DATE-TIME;TZID=\"UTC0\":20251119T140000\nEND:VEVENT\n";
+
+        CalendarEvent* first = parser.parseEventFromBuffer(plain);
+        CalendarEvent* second = parser.parseEventFromBuffer(reordered);
+        CHECK_FALSE(second->allDay);
+        CHECK(first->startTime == second->startTime);
+        delete first;
+        delete second;
+    }
+
+    TEST_CASE("Properties with parameters are recognized") {
+        CalendarStreamParser parser;
+        String ics = "BEGIN:VEVENT\n"
+                     "UID:lang@test\n"
+                     "SUMMARY;LANGUAGE=it:Riunione: budget\n"
+                     "DTSTART:20251119T100000Z\n"
+                     "END:VEVENT\n";
+
+        CalendarEvent* event = parser.parseEventFromBuffer(ics);
+        CHECK(event->summary == "Riunione: budget");
+        delete event;
+    }
+
+    TEST_CASE("VALARM properties do not override the event") {
+        CalendarStreamParser parser;
+        String ics = "BEGIN:VEVENT\n"
+                     "UID:alarm@test\n"
+                     "BEGIN:VALARM\n"
+                     "ACTION:DISPLAY\n"
+                     "DESCRIPTION:This is an event reminder\n"
+                     "SUMMARY:Alarm\n"
+                     "END:VALARM\n"
+                     "SUMMARY:Dentist\n"
+                     "DESCRIPTION:Check-up\n"
+                     "DTSTART:20251119T100000Z\n"
+                     "END:VEVENT\n";
+
+        CalendarEvent* event = parser.parseEventFromBuffer(ics);
+        CHECK(event->summary == "Dentist");
+        CHECK(event->description == "Check-up");
+        delete event;
+    }
+
+    TEST_CASE("Raw folded CRLF buffer") {
+        CalendarStreamParser parser;
+        String ics = "BEGIN:VEVENT\r\n"
+                     "UID:folded@test\r\n"
+                     "SUMMARY:A summary that was fol\r\n"
+                     " ded by the server\r\n"
+                     "DTSTART:20251119T100000Z\r\n"
+                     "RRULE:FREQ=WEEKLY;\r\n"
+                     " BYDAY=MO\r\n"
+                     "END:VEVENT\r\n";
+
+        CalendarEvent* event = parser.parseEventFromBuffer(ics);
+        CHECK(event->uid == "folded@test");
+        CHECK(event->summary == "A summary that was folded by the server");
+        CHECK(event->rrule == "FREQ=WEEKLY;BYDAY=MO");
+        CHECK(event->isRecurring);
+        CHECK(event->startTime == 1763546400);
+        delete event;
+    }
+}
+
+TEST_SUITE("parseEventFromBuffer - Benchmark") {
+
+    TEST_CASE("Events/second on holidays.ics") {
+        benchmarkFixture("test/fixtures/holidays.ics");
+    }
+
+    TEST_CASE("Events/second on google_calendar.ics") {
+        benchmarkFixture("test/fixtures/google_calendar.ics");
+    }
+}
@@ -0,0 +1,274 @@
+/**
+ * @file test_recurrence_overrides.cpp
+ * @brief Tests for EXDATE / RECURRENCE-ID handling during streaming expansion
+ *
+ * Tests cover:
+ * - RecurrenceOverrideIndex ordering, duplicates and capacity
+ * - EXDATE lists (single, comma-separated, repeated, TZID and DATE values)
+ * - Moved instances whose override appears before or after the master
+ * - Cancelled instances
+ * - Overrides listed after more masters than can be held back
+ */
+
+#include <doctest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "../mock_littlefs.h"
+#include "calendar_stream_parser.h"
+#include "recurrence_overrides.h"
+#include "timezone_engine.h"
+
+namespace {
+
+/**
+ * @brief Stream-parse a calendar and return the occurrences sorted by start
+ */
+std::vector<CalendarEvent*> parseCalendar(CalendarStreamParser& parser, const std::string& body) {
+    std::string ics = "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//Overrides//EN\n" + body + "END:VCALENDAR\n";
+    StringStream stream((String(ics.c_str())));
+    std::vector<CalendarEvent*> events;
+    parser.streamParseFromStream(
+        &stream,
+        [&events](CalendarEvent* event) { events.push_back(event); },
+        utcFor(2026, 2, 1, 0, 0),
+        utcFor(2026, 3, 1, 0, 0));
+    std::sort(events.begin(), events.end(),
+              [](CalendarEvent* a, CalendarEvent* b) { return a->startTime < b->startTime; });
+    return events;
+}
+
+// count unrelated daily masters, enough to push the standup master out of the pending list
+std::string otherMasters(int count) {
+    std::string text;
+    for (int i = 0; i < count; i++) {
+        text += "BEGIN:VEVENT\nUID:daily-" + std::to_string(i) +
+                "@example.com\nSUMMARY:Daily\nDTSTART:20260201T120000Z\nDTEND:20260201T123000Z\n"
+                "RRULE:FREQ=DAILY;COUNT=1\nEND:VEVENT\n";
+    }
+    return text;
+}
+
+size_t countSummary(const std::vector<CalendarEvent*>& events, const char* summary) {
+    size_t count = 0;
+    for (auto event : events) {
+        if (event->summary == summary) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void freeEvents(std::vector<CalendarEvent*>& events) {
+    for (auto event : events) {
+        delete event;
+    }
+    events.clear();
+}
+
+// Weekly on Mondays at 09:00 UTC: February 2026 has 4 Mondays (2, 9, 16, 23),
+// all before any DST change so the wall-clock time is the same in every zone
+const char* WEEKLY_MASTER = "BEGIN:VEVENT\n"
+                            "UID:standup@example.com\n"
+                            "SUMMARY:Standup\n"
+                            "DTSTART:20260105T090000Z\n"
+                            "DTEND:20260105T093000Z\n"
+                            "RRULE:FREQ=WEEKLY;BYDAY=MO\n"
+                            "%EXDATE%"
+                            "END:VEVENT\n";
+
+std::string master(const std::string& exdate) {
+    std::string text = WEEKLY_MASTER;
+    text.replace(text.find("%EXDATE%"), 8, exdate);
+    return text;
+}
+
+const char* MOVED_OVERRIDE = "BEGIN:VEVENT\n"
+                             "UID:standup@example.com\n"
+                             "RECURRENCE-ID:20260216T090000Z\n"
+                             "SUMMARY:Standup (moved)\n"
+                             "DTSTART:20260217T140000Z\n"
+                             "DTEND:20260217T143000Z\n"
+                             "END:VEVENT\n";
+
+} // namespace
+
+TEST_SUITE("RecurrenceOverrideIndex")
+{
+    TEST_CASE("Lookups are per UID and per instance")
+    {
+        RecurrenceOverrideIndex index;
+        CHECK(index.add("a@example.com", 2000, RecurrenceOverrideIndex::EXCLUDED));
+        CHECK(index.add("a@example.com", 1000, RecurrenceOverrideIndex::OVERRIDDEN));
+        CHECK(index.add("b@example.com", 1500, RecurrenceOverrideIndex::EXCLUDED));
+        CHECK_FALSE(index.add("", 1500, RecurrenceOverrideIndex::EXCLUDED));
+
+        uint32_t a = RecurrenceOverrideIndex::hashUid("a@example.com");
+        uint32_t b = RecurrenceOverrideIndex::hashUid("b@example.com");
+        uint32_t c = RecurrenceOverrideIndex::hashUid("c@example.com");
+
+        CHECK(index.isSuppressed(a, 1000));
+        CHECK(index.isSuppressed(a, 2000));
+        CHECK_FALSE(index.isSuppressed(a, 1500));
+        CHECK(index.isSuppressed(b, 1500));
+        CHECK_FALSE(index.isSuppressed(c, 1500));
+        CHECK(index.hasEntries(a));
+        CHECK_FALSE(index.hasEntries(c));
+    }
+
+    TEST_CASE("Duplicates are merged and capacity is bounded")
+    {
+        RecurrenceOverrideIndex index;
+        CHECK(index.add("a@example.com", 1000, RecurrenceOverrideIndex::EXCLUDED));
+        CHECK(index.add("a@example.com", 1000, RecurrenceOverrideIndex::OVERRIDDEN));
+        CHECK(index.size() == 1);
+
+        for (size_t i = 0; i < RecurrenceOverrideIndex::MAX_ENTRIES + 10; i++) {
+            index.add("a@example.com", 5000 + (time_t)i, RecurrenceOverrideIndex::EXCLUDED);
+        }
+        CHECK(index.size() == RecurrenceOverrideIndex::MAX_ENTRIES);
+        CHECK(index.getDropped() == 11);
+
+        index.clear();
+        CHECK(index.size() == 0);
+        CHECK_FALSE(index.isSuppressed(RecurrenceOverrideIndex::hashUid("a@example.com"), 1000));
+    }
+}
+
+TEST_SUITE("CalendarStreamParser - EXDATE and RECURRENCE-ID")
+{
+    TEST_CASE("Without overrides every Monday is generated")
+    {
+        CalendarStreamParser parser;
+        std::vector<CalendarEvent*> events = parseCalendar(parser, master(""));
+        CHECK(events.size() == 4);
+        CHECK(parser.getLastParseStats().overrides == 0);
+        freeEvents(events);
+    }
+
+    TEST_CASE("EXDATE removes instances")
+    {
+        CalendarStreamParser parser;
+        std::vector<CalendarEvent*> events =
+            parseCalendar(parser, master("EXDATE:20260202T090000Z,20260216T090000Z\n"
+                                         "EXDATE:20260223T090000Z\n"));
+        REQUIRE(events.size() == 1);
+        CHECK(events[0]->startTime == utcFor(2026, 2, 9, 9, 0));
+        CHECK(parser.getLastParseStats().overrides == 3);
+        freeEvents(events);
+    }
+
+    TEST_CASE("EXDATE with TZID")
+    {
+        // 10:00 Europe/Rome in February (CET) is 09:00 UTC
+        CalendarStreamParser parser;
+        std::vector<CalendarEvent*> events =
+            parseCalendar(parser, master("EXDATE;TZID=Europe/Rome:20260216T100000\n"));
+        CHECK(events.size() == 3);
+        for (auto event : events) {
+            CHECK(event->startTime != utcFor(2026, 2, 16, 9, 0));
+        }
+        freeEvents(events);
+    }
+
+    TEST_CASE("Moved instance listed after the master replaces the original")
+    {
+        CalendarStreamParser parser;
+        std::vector<CalendarEvent*> events = parseCalendar(parser, master("") + MOVED_OVERRIDE);
+        REQUIRE(events.size() == 4);
+        CHECK(events[2]->startTime == utcFor(2026, 2, 17, 14, 0));
+        CHECK(events[2]->summary == "Standup (moved)");
+        for (auto event : events) {
+            CHECK(event->startTime != utcFor(2026, 2, 16, 9, 0));
+        }
+        freeEvents(events);
+    }
+
+    TEST_CASE("Moved instance listed before the master replaces the original")
+    {
+        CalendarStreamParser parser;
+        std::vector<CalendarEvent*> events = parseCalendar(parser, MOVED_OVERRIDE + master(""));
+        REQUIRE(events.size() == 4);
+        CHECK(events[2]->summary == "Standup (moved)");
+        freeEvents(events);
+    }
+
+    TEST_CASE("Cancelled instance is dropped")
+    {
+        CalendarStreamParser parser;
+        std::vector<CalendarEvent*> events = parseCalendar(parser, master("") +
+                                                                       "BEGIN:VEVENT\n"
+                                                                       "UID:standup@example.com\n"
+                                                                       "RECURRENCE-ID:20260223T090000Z\n"
+                                                                       "STATUS:CANCELLED\n"
+                                                                       "DTSTART:20260223T090000Z\n"
+                                                                       "DTEND:20260223T093000Z\n"
+                                                                       "END:VEVENT\n");
+        CHECK(events.size() == 3);
+        for (auto event : events) {
+            CHECK(event->startTime != utcFor(2026, 2, 23, 9, 0));
+        }
+        freeEvents(events);
+    }
+
+    TEST_CASE("Overrides do not leak into other UIDs or later parses")
+    {
+        CalendarStreamParser parser;
+        std::string other = master("");
+        other.replace(other.find("standup@example.com"), 19, "retro@example.com");
+
+        std::vector<CalendarEvent*> events =
+            parseCalendar(parser, master("EXDATE:20260209T090000Z\n") + other);
+        CHECK(events.size() == 7);
+        freeEvents(events);
+
+        events = parseCalendar(parser, master(""));
+        CHECK(events.size() == 4);
+        freeEvents(events);
+    }
+
+    TEST_CASE("An override after more masters than the pending limit is applied to files")
+    {
+        const int others = 40;
+        std::string body = master("") + otherMasters(others) + MOVED_OVERRIDE;
+        std::string ics = "BEGIN:VCALENDAR\nVERSION:2.0\n" + body + "END:VCALENDAR\n";
+
+        LittleFS.clear();
+        File file = LittleFS.open("/overrides.ics", "w");
+        file.write((const uint8_t*)ics.data(), ics.size());
+        file.close();
+
+        CalendarStreamParser parser;
+        std::vector<CalendarEvent*> events;
+        REQUIRE(parser.streamParse(
+            "file:///overrides.ics",
+            [&events](CalendarEvent* event) { events.push_back(event); },
+            utcFor(2026, 2, 1, 0, 0),
+            utcFor(2026, 3, 1, 0, 0)));
+
+        // The pre-pass indexed the override before the master was expanded
+        CHECK(parser.getLastParseStats().earlyExpansions == 0);
+        CHECK(events.size() == (size_t)(4 + others));
+        CHECK(countSummary(events, "Standup") == 3);
+        CHECK(countSummary(events, "Standup (moved)") == 1);
+        for (auto event : events) {
+            CHECK(event->startTime != utcFor(2026, 2, 16, 9, 0));
+        }
+        freeEvents(events);
+    }
+
+    TEST_CASE("Early expansions of a stream without a pre-pass are counted")
+    {
+        CalendarStreamParser parser;
+        std::vector<CalendarEvent*> events = parseCalendar(parser, master("") + otherMasters(40) + MOVED_OVERRIDE);
+
+        // The standup master left the pending list before its override arrived
+        CHECK(parser.getLastParseStats().earlyExpansions == 41 - 32);
+        CHECK(countSummary(events, "Standup (moved)") == 1);
+        CHECK(countSummary(events, "Standup") == 4);
+        freeEvents(events);
+    }
+}
@@ -0,0 +1,180 @@
+/**
+ * @file test_rrule_cache.cpp
+ * @brief Tests for the interned RRULE cache
+ *
+ * Tests cover:
+ * - Lookups, hit/miss counters, invalid rules and capacity
+ * - Cache use while streaming a calendar (one miss per distinct rule)
+ * - Time per rule compared to parsing and compiling every time
+ */
+
+#include <doctest.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "rrule_cache.h"
+#include "timezone_engine.h"
+
+namespace {
+
+const char* const FEED_RULES[] = {
+    "FREQ=WEEKLY;BYDAY=MO,TU,WE,TH,FR",
+    "FREQ=WEEKLY;BYDAY=MO",
+    "FREQ=MONTHLY;BYDAY=1TU",
+};
+
+/**
+ * @brief A calendar with `events` recurring VEVENTs cycling through FEED_RULES
+ */
+std::string buildFeed(int events) {
+    std::string ics = "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//RRULE cache//EN\n";
+    for (int i = 0; i < events; i++) {
+        char uid[32];
+        snprintf(uid, sizeof(uid), "event-%d@example.com", i);
+        ics += "BEGIN:VEVENT\nUID:";
+        ics += uid;
+        ics += "\nSUMMARY:Recurring\nDTSTART:20260105T090000Z\nDTEND:20260105T093000Z\nRRULE:";
+        ics += FEED_RULES[i % 3];
+        ics += "\nEND:VEVENT\n";
+    }
+    ics += "END:VCALENDAR\n";
+    return ics;
+}
+
+size_t streamFeed(CalendarStreamParser& parser, const std::string& ics) {
+    StringStream stream((String(ics.c_str())));
+    size_t occurrences = 0;
+    parser.streamParseFromStream(
+        &stream,
+        [&occurrences](CalendarEvent* event) {
+            occurrences++;
+            delete event;
+        },
+        utcFor(2026, 2, 1, 0, 0),
+        utcFor(2026, 3, 1, 0, 0));
+    return occurrences;
+}
+
+} // namespace
+
+TEST_SUITE("RRuleCache")
+{
+    TEST_CASE("Lookups count hits and misses")
+    {
+        RRuleCache cache;
+        CalendarStreamParser parser;
+        bool valid = true;
+
+        CHECK(cache.find("FREQ=DAILY", valid) == nullptr);
+        CHECK_FALSE(valid);
+
+        CompiledRRule compiled;
+        REQUIRE(compiled.compile(parser.parseRRule("FREQ=DAILY;INTERVAL=3")));
+        CHECK(cache.insert("FREQ=DAILY;INTERVAL=3", compiled, true));
+
+        const CompiledRRule* cached = cache.find("FREQ=DAILY;INTERVAL=3", valid);
+        REQUIRE(cached != nullptr);
+        CHECK(valid);
+        CHECK(cached->freq == RecurrenceFrequency::DAILY);
+        CHECK(cached->interval == 3);
+
+        // Rule text must match exactly
+        CHECK(cache.find("FREQ=DAILY;INTERVAL=3;", valid) == nullptr);
+
+        CHECK(cache.getHits() == 1);
+        CHECK(cache.getMisses() == 2);
+
+        cache.clear();
+        CHECK(cache.size() == 0);
+        CHECK(cache.getHits() == 0);
+        CHECK(cache.getMisses() == 0);
+    }
+
+    TEST_CASE("Invalid rules are remembered")
+    {
+        RRuleCache cache;
+        CHECK(cache.insert("FREQ=FORTNIGHTLY", CompiledRRule(), false));
+
+        bool valid = true;
+        CHECK(cache.find("FREQ=FORTNIGHTLY", valid) != nullptr);
+        CHECK_FALSE(valid);
+    }
+
+    TEST_CASE("Capacity is bounded")
+    {
+        RRuleCache cache;
+        for (size_t i = 0; i < RRuleCache::MAX_ENTRIES; i++) {
+            String rule = "FREQ=DAILY;INTERVAL=" + String((int)i + 1);
+            CHECK(cache.insert(rule, CompiledRRule(), true));
+        }
+        CHECK_FALSE(cache.insert("FREQ=YEARLY", CompiledRRule(), true));
+        CHECK(cache.size() == RRuleCache::MAX_ENTRIES);
+
+        // Every interned rule is still found
+        bool valid;
+        for (size_t i = 0; i < RRuleCache::MAX_ENTRIES; i++) {
+            String rule = "FREQ=DAILY;INTERVAL=" + String((int)i + 1);
+            CHECK(cache.find(rule, valid) != nullptr);
+        }
+    }
+}
+
+TEST_SUITE("RRuleCache - Streaming")
+{
+    TEST_CASE("Each distinct rule is parsed once per calendar")
+    {
+        CalendarStreamParser parser;
+        size_t occurrences = streamFeed(parser, buildFeed(30));
+
+        // Per 10 events: 20 weekdays x 10 + 4 Mondays x 10 + 1 first Tuesday x 10 in February 2026
+        CHECK(occurrences == 200 + 40 + 10);
+        CHECK(parser.getLastParseStats().rruleCacheMisses == 3);
+        CHECK(parser.getLastParseStats().rruleCacheHits == 27);
+
+        // Counters and entries start over with the next calendar
+        streamFeed(parser, buildFeed(3));
+        CHECK(parser.getLastParseStats().rruleCacheMisses == 3);
+        CHECK(parser.getLastParseStats().rruleCacheHits == 0);
+    }
+}
+
+TEST_SUITE("RRuleCache - Benchmark")
+{
+    TEST_CASE("Time per rule with and without interning")
+    {
+        const int rounds = 2000;
+        CalendarStreamParser parser;
+
+        std::chrono::steady_clock::time_point parseStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            CompiledRRule compiled;
+            compiled.compile(parser.parseRRule(FEED_RULES[i % 3]));
+        }
+        double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - parseStart).count();
+
+        RRuleCache cache;
+        String rules[3] = {FEED_RULES[0], FEED_RULES[1], FEED_RULES[2]};
+        std::chrono::steady_clock::time_point cacheStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            bool valid;
+            if (!cache.find(rules[i % 3], valid)) {
+                CompiledRRule compiled;
+                valid = compiled.compile(parser.parseRRule(rules[i % 3]));
+                cache.insert(rules[i % 3], compiled, valid);
+            }
+        }
+        double cacheSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - cacheStart).count();
+
+        MESSAGE("parse + compile: ", (unsigned long)(parseSeconds * 1e9 / rounds), " ns/rule");
+        MESSAGE("interned:        ", (unsigned long)(cacheSeconds * 1e9 / rounds), " ns/rule (",
+                (unsigned long)cache.getHits(), " hits, ", (unsigned long)cache.getMisses(), " misses)");
+
+        CHECK(cache.getMisses() == 3);
+        CHECK(cache.getHits() == (size_t)rounds - 3);
+    }
+}
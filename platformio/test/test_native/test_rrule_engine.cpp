@@ -0,0 +1,337 @@
+/**
+ * @file test_rrule_engine.cpp
+ * @brief Tests for the compiled RRULE engine
+ *
+ * Tests cover:
+ * - Compilation of BYxxx lists into bitsets (ranges, negatives, frequency rules)
+ * - Week numbering with different week starts
+ * - Conformance with the RFC 5545 section 3.8.5.3 examples, expanded in
+ *   America/New_York through the parser
+ */
+
+#include <doctest.h>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "rrule_engine.h"
+#include "timezone_engine.h"
+
+namespace {
+
+CompiledRRule compileRule(const char* text) {
+    CalendarStreamParser parser;
+    RRuleComponents components = parser.parseRRule(text);
+    CompiledRRule rule;
+    rule.compile(components);
+    return rule;
+}
+
+/**
+ * One RFC 5545 example: the rule, DTSTART in America/New_York wall-clock
+ * time and the expected instances in the same zone. With total = -1 only
+ * the listed prefix is checked (the rule is unbounded); otherwise the
+ * expansion must produce exactly `total` instances.
+ */
+struct ConformanceCase {
+    const char* name;
+    const char* rrule;
+    const char* dtstart;
+    const char* expected;
+    int total;
+};
+
+// Shared by the two forms of the "every 20 minutes" example
+const char* const EVERY_20_MINUTES =
+    "19970902T090000 19970902T092000 19970902T094000 19970902T100000 19970902T102000 "
+    "19970902T104000 19970902T110000 19970902T112000 19970902T114000 19970902T120000 "
+    "19970902T122000 19970902T124000 19970902T130000 19970902T132000 19970902T134000 "
+    "19970902T140000 19970902T142000 19970902T144000 19970902T150000 19970902T152000 "
+    "19970902T154000 19970902T160000 19970902T162000 19970902T164000 19970903T090000";
+
+const ConformanceCase RFC5545_EXAMPLES[] = {
+    {"Daily for 10 occurrences", "FREQ=DAILY;COUNT=10", "19970902T090000",
+     "19970902T090000 19970903T090000 19970904T090000 19970905T090000 19970906T090000 "
+     "19970907T090000 19970908T090000 19970909T090000 19970910T090000 19970911T090000",
+     10},
+    {"Daily until December 24, 1997", "FREQ=DAILY;UNTIL=19971224T000000Z", "19970902T090000",
+     "19970902T090000 19970903T090000 19970904T090000", 113},
+    {"Every other day", "FREQ=DAILY;INTERVAL=2", "19970902T090000",
+     "19970902T090000 19970904T090000 19970906T090000 19970908T090000", -1},
+    {"Every 10 days, 5 occurrences", "FREQ=DAILY;INTERVAL=10;COUNT=5", "19970902T090000",
+     "19970902T090000 19970912T090000 19970922T090000 19971002T090000 19971012T090000", 5},
+    {"Every day in January for 3 years (yearly)",
+     "FREQ=YEARLY;UNTIL=20000131T140000Z;BYMONTH=1;BYDAY=SU,MO,TU,WE,TH,FR,SA", "19980101T090000",
+     "19980101T090000 19980102T090000 19980103T090000", 93},
+    {"Every day in January for 3 years (daily)", "FREQ=DAILY;UNTIL=20000131T140000Z;BYMONTH=1",
+     "19980101T090000", "19980101T090000 19980102T090000 19980103T090000", 93},
+    {"Weekly for 10 occurrences", "FREQ=WEEKLY;COUNT=10", "19970902T090000",
+     "19970902T090000 19970909T090000 19970916T090000 19970923T090000 19970930T090000 "
+     "19971007T090000 19971014T090000 19971021T090000 19971028T090000 19971104T090000",
+     10},
+    {"Weekly on Tuesday and Thursday for five weeks", "FREQ=WEEKLY;UNTIL=19971007T000000Z;WKST=SU;BYDAY=TU,TH",
+     "19970902T090000",
+     "19970902T090000 19970904T090000 19970909T090000 19970911T090000 19970916T090000 "
+     "19970918T090000 19970923T090000 19970925T090000 19970930T090000 19971002T090000",
+     10},
+    {"Every other week on Monday, Wednesday and Friday",
+     "FREQ=WEEKLY;INTERVAL=2;UNTIL=19971224T000000Z;WKST=SU;BYDAY=MO,WE,FR", "19970901T090000",
+     "19970901T090000 19970903T090000 19970905T090000 19970915T090000 19970917T090000 "
+     "19970919T090000 19970929T090000 19971001T090000 19971003T090000 19971013T090000 "
+     "19971015T090000 19971017T090000 19971027T090000 19971029T090000 19971031T090000 "
+     "19971110T090000 19971112T090000 19971114T090000 19971124T090000 19971126T090000 "
+     "19971128T090000 19971208T090000 19971210T090000 19971212T090000 19971222T090000",
+     25},
+    {"Every other week on Tuesday and Thursday, 8 occurrences", "FREQ=WEEKLY;INTERVAL=2;COUNT=8;WKST=SU;BYDAY=TU,TH",
+     "19970902T090000",
+     "19970902T090000 19970904T090000 19970916T090000 19970918T090000 19970930T090000 "
+     "19971002T090000 19971014T090000 19971016T090000",
+     8},
+    {"Monthly on the first Friday for 10 occurrences", "FREQ=MONTHLY;COUNT=10;BYDAY=1FR", "19970905T090000",
+     "19970905T090000 19971003T090000 19971107T090000 19971205T090000 19980102T090000 "
+     "19980206T090000 19980306T090000 19980403T090000 19980501T090000 19980605T090000",
+     10},
+    {"Every other month on the first and last Sunday", "FREQ=MONTHLY;INTERVAL=2;COUNT=10;BYDAY=1SU,-1SU",
+     "19970907T090000",
+     "19970907T090000 19970928T090000 19971102T090000 19971130T090000 19980104T090000 "
+     "19980125T090000 19980301T090000 19980329T090000 19980503T090000 19980531T090000",
+     10},
+    {"Monthly on the second-to-last Monday for 6 months", "FREQ=MONTHLY;COUNT=6;BYDAY=-2MO", "19970922T090000",
+     "19970922T090000 19971020T090000 19971117T090000 19971222T090000 19980119T090000 19980216T090000", 6},
+    {"Monthly on the third-to-last day", "FREQ=MONTHLY;BYMONTHDAY=-3", "19970928T090000",
+     "19970928T090000 19971029T090000 19971128T090000 19971229T090000 19980129T090000 19980226T090000", -1},
+    {"Monthly on the 2nd and 15th for 10 occurrences", "FREQ=MONTHLY;COUNT=10;BYMONTHDAY=2,15", "19970902T090000",
+     "19970902T090000 19970915T090000 19971002T090000 19971015T090000 19971102T090000 "
+     "19971115T090000 19971202T090000 19971215T090000 19980102T090000 19980115T090000",
+     10},
+    {"Monthly on the first and last day for 10 occurrences", "FREQ=MONTHLY;COUNT=10;BYMONTHDAY=1,-1",
+     "19970930T090000",
+     "19970930T090000 19971001T090000 19971031T090000 19971101T090000 19971130T090000 "
+     "19971201T090000 19971231T090000 19980101T090000 19980131T090000 19980201T090000",
+     10},
+    {"Every 18 months on the 10th through 15th", "FREQ=MONTHLY;INTERVAL=18;COUNT=10;BYMONTHDAY=10,11,12,13,14,15",
+     "19970910T090000",
+     "19970910T090000 19970911T090000 19970912T090000 19970913T090000 19970914T090000 "
+     "19970915T090000 19990310T090000 19990311T090000 19990312T090000 19990313T090000",
+     10},
+    {"Every Tuesday, every other month", "FREQ=MONTHLY;INTERVAL=2;BYDAY=TU", "19970902T090000",
+     "19970902T090000 19970909T090000 19970916T090000 19970923T090000 19970930T090000 "
+     "19971104T090000 19971111T090000 19971118T090000 19971125T090000 19980106T090000",
+     -1},
+    {"Yearly in June and July for 10 occurrences", "FREQ=YEARLY;COUNT=10;BYMONTH=6,7", "19970610T090000",
+     "19970610T090000 19970710T090000 19980610T090000 19980710T090000 19990610T090000 "
+     "19990710T090000 20000610T090000 20000710T090000 20010610T090000 20010710T090000",
+     10},
+    {"Every other year in January, February and March", "FREQ=YEARLY;INTERVAL=2;COUNT=10;BYMONTH=1,2,3",
+     "19970310T090000",
+     "19970310T090000 19990110T090000 19990210T090000 19990310T090000 20010110T090000 "
+     "20010210T090000 20010310T090000 20030110T090000 20030210T090000 20030310T090000",
+     10},
+    {"Every third year on the 1st, 100th and 200th day", "FREQ=YEARLY;INTERVAL=3;COUNT=10;BYYEARDAY=1,100,200",
+     "19970101T090000",
+     "19970101T090000 19970410T090000 19970719T090000 20000101T090000 20000409T090000 "
+     "20000718T090000 20030101T090000 20030410T090000 20030719T090000 20060101T090000",
+     10},
+    {"Every 20th Monday of the year", "FREQ=YEARLY;BYDAY=20MO", "19970519T090000",
+     "19970519T090000 19980518T090000 19990517T090000", -1},
+    {"Monday of week number 20", "FREQ=YEARLY;BYWEEKNO=20;BYDAY=MO", "19970512T090000",
+     "19970512T090000 19980511T090000 19990517T090000", -1},
+    {"Every Thursday in March", "FREQ=YEARLY;BYMONTH=3;BYDAY=TH", "19970313T090000",
+     "19970313T090000 19970320T090000 19970327T090000 19980305T090000 19980312T090000 "
+     "19980319T090000 19980326T090000 19990304T090000 19990311T090000 19990318T090000 19990325T090000",
+     -1},
+    {"Every Thursday, but only during June, July and August", "FREQ=YEARLY;BYDAY=TH;BYMONTH=6,7,8",
+     "19970605T090000",
+     "19970605T090000 19970612T090000 19970619T090000 19970626T090000 19970703T090000 "
+     "19970710T090000 19970717T090000 19970724T090000 19970731T090000 19970807T090000 "
+     "19970814T090000 19970821T090000 19970828T090000 19980604T090000",
+     -1},
+    // RFC 5545 excludes DTSTART with EXDATE here; without it DTSTART is the first instance
+    {"Every Friday the 13th", "FREQ=MONTHLY;BYDAY=FR;BYMONTHDAY=13", "19970902T090000",
+     "19970902T090000 19980213T090000 19980313T090000 19981113T090000 19990813T090000 20001013T090000", -1},
+    {"First Saturday that follows the first Sunday of the month",
+     "FREQ=MONTHLY;BYDAY=SA;BYMONTHDAY=7,8,9,10,11,12,13", "19970913T090000",
+     "19970913T090000 19971011T090000 19971108T090000 19971213T090000 19980110T090000 "
+     "19980207T090000 19980307T090000 19980411T090000 19980509T090000 19980613T090000",
+     -1},
+    {"US Presidential Election day", "FREQ=YEARLY;INTERVAL=4;BYMONTH=11;BYDAY=TU;BYMONTHDAY=2,3,4,5,6,7,8",
+     "19961105T090000", "19961105T090000 20001107T090000 20041102T090000", -1},
+    {"Third instance of Tuesday, Wednesday or Thursday", "FREQ=MONTHLY;COUNT=3;BYDAY=TU,WE,TH;BYSETPOS=3",
+     "19970904T090000", "19970904T090000 19971007T090000 19971106T090000", 3},
+    {"Second-to-last weekday of the month", "FREQ=MONTHLY;BYDAY=MO,TU,WE,TH,FR;BYSETPOS=-2", "19970929T090000",
+     "19970929T090000 19971030T090000 19971127T090000 19971230T090000 19980129T090000 "
+     "19980226T090000 19980330T090000",
+     -1},
+    // COUNT=3 stands in for UNTIL=19970902T170000Z, which the RFC intends as 17:00 New York time
+    {"Every 3 hours from 9:00 to 17:00", "FREQ=HOURLY;INTERVAL=3;COUNT=3", "19970902T090000",
+     "19970902T090000 19970902T120000 19970902T150000", 3},
+    {"Every 15 minutes for 6 occurrences", "FREQ=MINUTELY;INTERVAL=15;COUNT=6", "19970902T090000",
+     "19970902T090000 19970902T091500 19970902T093000 19970902T094500 19970902T100000 19970902T101500", 6},
+    {"Every hour and a half for 4 occurrences", "FREQ=MINUTELY;INTERVAL=90;COUNT=4", "19970902T090000",
+     "19970902T090000 19970902T103000 19970902T120000 19970902T133000", 4},
+    {"Every 20 minutes from 9:00 to 16:40 (daily)", "FREQ=DAILY;BYHOUR=9,10,11,12,13,14,15,16;BYMINUTE=0,20,40",
+     "19970902T090000", EVERY_20_MINUTES, -1},
+    {"Every 20 minutes from 9:00 to 16:40 (minutely)", "FREQ=MINUTELY;INTERVAL=20;BYHOUR=9,10,11,12,13,14,15,16",
+     "19970902T090000", EVERY_20_MINUTES, -1},
+    {"WKST=MO", "FREQ=WEEKLY;INTERVAL=2;COUNT=4;BYDAY=TU,SU;WKST=MO", "19970805T090000",
+     "19970805T090000 19970810T090000 19970819T090000 19970824T090000", 4},
+    {"WKST=SU", "FREQ=WEEKLY;INTERVAL=2;COUNT=4;BYDAY=TU,SU;WKST=SU", "19970805T090000",
+     "19970805T090000 19970817T090000 19970819T090000 19970831T090000", 4},
+    {"Invalid dates are skipped", "FREQ=MONTHLY;BYMONTHDAY=15,30;COUNT=5", "20070115T090000",
+     "20070115T090000 20070130T090000 20070215T090000 20070315T090000 20070330T090000", 5},
+};
+
+std::vector<std::string> splitTokens(const char* text) {
+    std::vector<std::string> tokens;
+    std::istringstream stream(text);
+    std::string token;
+    while (stream >> token) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+/**
+ * @brief Expand an example and return its instances as New York wall-clock times
+ */
+std::vector<std::string> expandInNewYork(CalendarStreamParser& parser, const ConformanceCase& example) {
+    String ics = "BEGIN:VEVENT\nUID:rfc5545@example.com\nSUMMARY:Example\nDTSTART;TZID=America/New_York:";
+    ics += example.dtstart;
+    ics += "\nDTEND;TZID=America/New_York:";
+    ics += example.dtstart;
+    ics += "\nRRULE:";
+    ics += example.rrule;
+    ics += "\nEND:VEVENT\n";
+
+    std::vector<std::string> instances;
+    CalendarEvent* event = parser.parseEventFromBuffer(ics);
+    REQUIRE(event != nullptr);
+
+    const CompiledTimeZone* zone = TimeZoneEngine::find("America/New_York");
+    REQUIRE(zone != nullptr);
+
+    OccurrenceIterator it = parser.iterateOccurrences(event, utcFor(1996, 1, 1, 0, 0), utcFor(2008, 1, 1, 0, 0));
+    time_t start, end;
+    while (it.next(start, end)) {
+        struct tm local;
+        zone->toLocal(start, local);
+        char text[32];
+        snprintf(text, sizeof(text), "%04d%02d%02dT%02d%02d%02d", local.tm_year + 1900, local.tm_mon + 1,
+                 local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec);
+        instances.push_back(text);
+    }
+    delete event;
+    return instances;
+}
+
+} // namespace
+
+TEST_SUITE("CompiledRRule")
+{
+    TEST_CASE("BYxxx lists become bitsets")
+    {
+        CompiledRRule rule = compileRule("FREQ=MONTHLY;BYMONTHDAY=1,15,-1;BYDAY=MO,2TU,-1FR;BYMONTH=3,12");
+        CHECK(rule.freq == RecurrenceFrequency::MONTHLY);
+        CHECK(rule.byMonth == ((1u << 3) | (1u << 12)));
+        CHECK(rule.byMonthDay == ((1u << 1) | (1u << 15)));
+        CHECK(rule.byMonthDayNeg == (1u << 1));
+        CHECK(rule.byWeekday == (1u << 1));
+        CHECK(rule.byWeekdayNth[2] == (1ull << 2));
+        CHECK(rule.byWeekdayNthNeg[5] == (1ull << 1));
+        CHECK(rule.has(CompiledRRule::BY_DAY_NTH));
+        CHECK_FALSE(rule.isSimple());
+    }
+
+    TEST_CASE("Year days, week numbers, times and positions")
+    {
+        CompiledRRule rule =
+            compileRule("FREQ=YEARLY;BYYEARDAY=1,366,-1;BYWEEKNO=20,-1;BYHOUR=0,23;BYMINUTE=59;BYSECOND=60;"
+                        "BYSETPOS=1,-2;WKST=SU");
+        CHECK(CompiledRRule::testBit(rule.byYearDay, 1));
+        CHECK(CompiledRRule::testBit(rule.byYearDay, 366));
+        CHECK(CompiledRRule::testBit(rule.byYearDayNeg, 1));
+        CHECK_FALSE(CompiledRRule::testBit(rule.byYearDay, 2));
+        CHECK(rule.byWeekNo == (1ull << 20));
+        CHECK(rule.byWeekNoNeg == (1ull << 1));
+        CHECK(rule.byHour == ((1u << 0) | (1u << 23)));
+        CHECK(rule.byMinute == (1ull << 59));
+        CHECK(rule.bySecond == (1ull << 60));
+        REQUIRE(rule.bySetPosCount == 2);
+        CHECK(rule.bySetPos[0] == 1);
+        CHECK(rule.bySetPos[1] == -2);
+        CHECK(rule.wkst == 0);
+    }
+
+    TEST_CASE("Out-of-range values and parts invalid for the frequency are ignored")
+    {
+        CompiledRRule rule = compileRule("FREQ=WEEKLY;BYMONTHDAY=5;BYYEARDAY=10;BYWEEKNO=3;BYMONTH=13,0;BYHOUR=24");
+        CHECK(rule.freq == RecurrenceFrequency::WEEKLY);
+        CHECK(rule.isSimple());
+
+        // Ordinal BYDAY entries only apply to MONTHLY and YEARLY
+        CompiledRRule weekly = compileRule("FREQ=WEEKLY;BYDAY=1MO,WE");
+        CHECK_FALSE(weekly.has(CompiledRRule::BY_DAY_NTH));
+        CHECK(weekly.byWeekday == ((1u << 1) | (1u << 3)));
+    }
+
+    TEST_CASE("Unknown frequency does not compile")
+    {
+        CalendarStreamParser parser;
+        CompiledRRule rule;
+        CHECK_FALSE(rule.compile(parser.parseRRule("FREQ=FORTNIGHTLY")));
+        CHECK_FALSE(rule.compile(parser.parseRRule("COUNT=3")));
+    }
+}
+
+TEST_SUITE("RRuleExpander - Week numbers")
+{
+    TEST_CASE("ISO weeks (WKST=MO)")
+    {
+        int weeks;
+        // 1997-12-29 (Monday) starts week 1 of 1998
+        CHECK(RRuleExpander::weekNumber(TimeZoneEngine::daysFromCivil(1997, 12, 29), 1, weeks) == 1);
+        CHECK(weeks == 53);
+        // 2021-01-03 (Sunday) still belongs to week 53 of 2020
+        CHECK(RRuleExpander::weekNumber(TimeZoneEngine::daysFromCivil(2021, 1, 3), 1, weeks) == 53);
+        CHECK(weeks == 53);
+        CHECK(RRuleExpander::weekNumber(TimeZoneEngine::daysFromCivil(1997, 5, 12), 1, weeks) == 20);
+        CHECK(weeks == 52);
+    }
+
+    TEST_CASE("Week start changes the boundaries")
+    {
+        int weeks;
+        // 2023-01-01 is a Sunday: week 52 of 2022 with ISO weeks, week 1 of 2023 with Sunday weeks
+        int64_t day = TimeZoneEngine::daysFromCivil(2023, 1, 1);
+        CHECK(RRuleExpander::weekNumber(day, 1, weeks) == 52);
+        CHECK(RRuleExpander::weekNumber(day, 0, weeks) == 1);
+    }
+}
+
+TEST_SUITE("RRuleExpander - RFC 5545 examples")
+{
+    TEST_CASE("Recurrence rule examples from section 3.8.5.3")
+    {
+        CalendarStreamParser parser;
+        for (const ConformanceCase& example : RFC5545_EXAMPLES) {
+            CAPTURE(std::string(example.name));
+            CAPTURE(std::string(example.rrule));
+
+            std::vector<std::string> expected = splitTokens(example.expected);
+            std::vector<std::string> actual = expandInNewYork(parser, example);
+
+            if (example.total >= 0) {
+                CHECK(actual.size() == (size_t)example.total);
+            }
+            REQUIRE(actual.size() >= expected.size());
+            for (size_t i = 0; i < expected.size(); i++) {
+                CHECK(actual[i] == expected[i]);
+            }
+        }
+    }
+}
@@ -0,0 +1,351 @@
+/**
+ * @file test_timezone_engine.cpp
+ * @brief Tests and benchmark for the compiled POSIX time zone engine
+ *
+ * Tests cover:
+ * - POSIX TZ string parsing (valid and invalid forms)
+ * - Civil calendar arithmetic and timegm-style normalization
+ * - DST boundaries (spring-forward gap, fall-back overlap, southern hemisphere)
+ * - Agreement with libc localtime/mktime for every zone in timezone_map.h
+ * - Registry entries staying in place once handed out, local zone included
+ * - Conversions/second versus the setenv("TZ") + tzset() + mktime() path
+ */
+
+#include <doctest.h>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+
+#include "../mock_arduino.h"
+#include "timezone_engine.h"
+#include "timezone_map.h"
+
+namespace {
+
+/**
+ * @brief Sets TZ for the lifetime of the object and restores it afterwards
+ */
+class ScopedTZ {
+  public:
+    explicit ScopedTZ(const char* tz) {
+        const char* old = getenv("TZ");
+        hadOld = old != nullptr;
+        if (hadOld) {
+            saved = old;
+        }
+        setenv("TZ", tz, 1);
+        tzset();
+    }
+    ~ScopedTZ() {
+        if (hadOld) {
+            setenv("TZ", saved.c_str(), 1);
+        } else {
+            unsetenv("TZ");
+        }
+        tzset();
+    }
+
+  private:
+    bool hadOld;
+    std::string saved;
+};
+
+struct tm makeTm(int year, int month, int day, int hour, int min, int sec = 0, int isdst = -1) {
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    t.tm_year = year - 1900;
+    t.tm_mon = month - 1;
+    t.tm_mday = day;
+    t.tm_hour = hour;
+    t.tm_min = min;
+    t.tm_sec = sec;
+    t.tm_isdst = isdst;
+    return t;
+}
+
+} // namespace
+
+TEST_SUITE("TimeZoneEngine - Parsing") {
+
+    TEST_CASE("Valid POSIX strings compile") {
+        const char* valid[] = {"UTC0", "JST-9", "CET-1CEST,M3.5.0,M10.5.0/3", "EST5EDT",
+                               "<+03>-3", "IST-5:30", "AEST-10AEDT,M10.1.0,M4.1.0/3",
+                               "XXX3YYY,J60/2,300/3", "EST5EDT4,M3.2.0/-1,M11.1.0/26"};
+        for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+            CompiledTimeZone zone;
+            CHECK_MESSAGE(zone.compile(valid[i]), std::string(valid[i]));
+        }
+    }
+
+    TEST_CASE("Invalid strings are rejected") {
+        const char* invalid[] = {"", "Europe/Rome", ":Europe/Rome", "CE-1", "CET", "CET-1CEST,M13.1.0,M10.5.0",
+                                 "CET-1CEST,M3.5.0", "CET-1CEST,M3.5.0,M10.5.0/3junk"};
+        for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+            CompiledTimeZone zone;
+            CHECK_MESSAGE(!zone.compile(invalid[i]), std::string(invalid[i]));
+        }
+    }
+
+    TEST_CASE("Offsets and DST flag") {
+        CompiledTimeZone zone;
+        REQUIRE(zone.compile("IST-5:30"));
+        CHECK_FALSE(zone.hasDst());
+        CHECK(zone.offsetAt(0) == 19800);
+
+        REQUIRE(zone.compile("PST8PDT,M3.2.0,M11.1.0"));
+        CHECK(zone.hasDst());
+        CHECK(zone.offsetAt(1768000000) == -8 * 3600); // January 2026
+        CHECK(zone.offsetAt(1783000000) == -7 * 3600); // July 2026
+    }
+
+    TEST_CASE("Registry resolves IANA names, POSIX strings and UTC") {
+        TimeZoneEngine::clear();
+        const CompiledTimeZone* zurich = TimeZoneEngine::find("Europe/Zurich");
+        REQUIRE(zurich != nullptr);
+        CHECK(zurich->offsetAt(1768000000) == 3600);
+
+        CHECK(TimeZoneEngine::find("Europe/Zurich") == zurich); // Compiled once
+        CHECK(TimeZoneEngine::find("CET-1CEST,M3.5.0,M10.5.0/3") != nullptr);
+        CHECK(TimeZoneEngine::find("UTC") != nullptr);
+        CHECK(TimeZoneEngine::find("Mars/Olympus_Mons") == nullptr);
+        CHECK(TimeZoneEngine::find("") == nullptr);
+    }
+
+    TEST_CASE("Zones handed out are never recompiled or evicted") {
+        TimeZoneEngine::clear();
+        const CompiledTimeZone* zurich = TimeZoneEngine::find("Europe/Zurich");
+        REQUIRE(zurich != nullptr);
+
+        const CompiledTimeZone* rome = nullptr;
+        {
+            ScopedTZ tz("Europe/Rome");
+            rome = TimeZoneEngine::local();
+            REQUIRE(rome != nullptr);
+        }
+        {
+            // A new local TZ gets its own entry instead of overwriting Rome's
+            ScopedTZ tz("JST-9");
+            const CompiledTimeZone* tokyo = TimeZoneEngine::local();
+            REQUIRE(tokyo != nullptr);
+            CHECK(tokyo != rome);
+            CHECK(rome->offsetAt(1768000000) == 3600);
+        }
+
+        // Fill the table: the first zones keep their slots, new TZIDs get nullptr
+        int compiled = 3;
+        for (int hours = 1; compiled < TimeZoneEngine::MAX_ZONES; hours++, compiled++) {
+            String posix = "XYZ" + String(hours);
+            REQUIRE(TimeZoneEngine::find(posix) != nullptr);
+        }
+        CHECK(TimeZoneEngine::find("EST5EDT,M3.2.0,M11.1.0") == nullptr);
+        CHECK(TimeZoneEngine::find("Europe/Zurich") == zurich);
+        CHECK(zurich->offsetAt(1768000000) == 3600);
+        CHECK(rome->offsetAt(1783000000) == 7200);
+
+        // Conversions still work through libc once the table is full
+        struct tm t = makeTm(2026, 1, 15, 12, 0);
+        CHECK(TimeZoneEngine::makeInTz("EST5", t) == 1768496400);
+        TimeZoneEngine::clear();
+    }
+}
+
+TEST_SUITE("TimeZoneEngine - Civil arithmetic") {
+
+    TEST_CASE("daysFromCivil and civilFromDays round-trip") {
+        CHECK(TimeZoneEngine::daysFromCivil(1970, 1, 1) == 0);
+        CHECK(TimeZoneEngine::daysFromCivil(2000, 3, 1) == 11017);
+        CHECK(TimeZoneEngine::daysFromCivil(1969, 12, 31) == -1);
+
+        for (int64_t days = -800000; days < 800000; days += 997) {
+            int64_t year;
+            int month, day;
+            TimeZoneEngine::civilFromDays(days, year, month, day);
+            CHECK(TimeZoneEngine::daysFromCivil(year, month, day) == days);
+        }
+    }
+
+    TEST_CASE("makeUtc matches timegm and normalizes like it") {
+        struct tm fields[] = {makeTm(2025, 1, 31, 10, 0), makeTm(2024, 14, 1, 0, 0), makeTm(2025, 3, 0, 0, 0),
+                              makeTm(2025, 1, 1, -1, 0), makeTm(2023, 2, 29, 12, 30, 75)};
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+            struct tm ours = fields[i];
+            struct tm libc = fields[i];
+            CHECK(TimeZoneEngine::makeUtc(ours) == timegm(&libc));
+            CHECK(ours.tm_year == libc.tm_year);
+            CHECK(ours.tm_mon == libc.tm_mon);
+            CHECK(ours.tm_mday == libc.tm_mday);
+            CHECK(ours.tm_hour == libc.tm_hour);
+            CHECK(ours.tm_wday == libc.tm_wday);
+            CHECK(ours.tm_yday == libc.tm_yday);
+        }
+    }
+
+    TEST_CASE("utcTime matches gmtime") {
+        for (int64_t t = -2000000000LL; t < 4000000000LL; t += 7777777) {
+            time_t value = (time_t)t;
+            struct tm ours, libc;
+            TimeZoneEngine::utcTime(value, ours);
+            gmtime_r(&value, &libc);
+            CHECK(ours.tm_year == libc.tm_year);
+            CHECK(ours.tm_yday == libc.tm_yday);
+            CHECK(ours.tm_hour == libc.tm_hour);
+            CHECK(ours.tm_sec == libc.tm_sec);
+            CHECK(ours.tm_wday == libc.tm_wday);
+        }
+    }
+}
+
+TEST_SUITE("TimeZoneEngine - DST boundaries") {
+
+    TEST_CASE("Europe spring-forward gap and fall-back overlap") {
+        CompiledTimeZone cet;
+        REQUIRE(cet.compile("CET-1CEST,M3.5.0,M10.5.0/3"));
+
+        // 2026-03-29 00:59:59 UTC is the last second of CET
+        CHECK_FALSE(cet.isDstAt(1774745999));
+        CHECK(cet.isDstAt(1774746000));
+
+        // 02:30 does not exist on 2026-03-29: resolved with the standard offset (03:30 CEST)
+        struct tm gap = makeTm(2026, 3, 29, 2, 30);
+        time_t gapUtc = cet.toUtc(gap);
+        CHECK(gapUtc == 1774747800);
+        CHECK(gap.tm_hour == 3);
+        CHECK(gap.tm_isdst == 1);
+
+        // 02:30 occurs twice on 2026-10-25: the DST instant comes first
+        struct tm overlap = makeTm(2026, 10, 25, 2, 30);
+        CHECK(cet.toUtc(overlap) == 1792888200);
+        CHECK(overlap.tm_isdst == 1);
+
+        struct tm overlapStd = makeTm(2026, 10, 25, 2, 30, 0, 0);
+        CHECK(cet.toUtc(overlapStd) == 1792891800);
+        CHECK(overlapStd.tm_isdst == 0);
+    }
+
+    TEST_CASE("Southern hemisphere DST spans the new year") {
+        CompiledTimeZone sydney;
+        REQUIRE(sydney.compile("AEST-10AEDT,M10.1.0,M4.1.0/3"));
+
+        struct tm newYear = makeTm(2026, 1, 1, 12, 0);
+        sydney.toUtc(newYear);
+        CHECK(newYear.tm_isdst == 1);
+
+        struct tm winter = makeTm(2026, 7, 1, 12, 0);
+        sydney.toUtc(winter);
+        CHECK(winter.tm_isdst == 0);
+    }
+
+    TEST_CASE("Weekly 20:30 event keeps wall time across the DST switch") {
+        CompiledTimeZone cet;
+        REQUIRE(cet.compile("CET-1CEST,M3.5.0,M10.5.0/3"));
+
+        struct tm t = makeTm(2026, 3, 17, 20, 30);
+        for (int week = 0; week < 4; week++) {
+            struct tm occurrence = t;
+            occurrence.tm_mday += week * 7;
+            cet.toUtc(occurrence);
+            CHECK(occurrence.tm_hour == 20);
+            CHECK(occurrence.tm_min == 30);
+        }
+    }
+
+    TEST_CASE("Every mapped zone agrees with libc") {
+        for (std::map<String, String>::const_iterator it = IANA_TO_POSIX_TZ.begin(); it != IANA_TO_POSIX_TZ.end();
+             ++it) {
+            const char* posix = it->second.c_str();
+            CompiledTimeZone zone;
+            REQUIRE_MESSAGE(zone.compile(posix), std::string(posix));
+            ScopedTZ tz(posix);
+
+            int localMismatches = 0;
+            int utcMismatches = 0;
+
+            // 2020-2031, sampled every two hours plus an odd stride to hit all minutes
+            for (int64_t t = 1577836800LL; t < 1924992000LL; t += 2 * 3600 + 61) {
+                time_t value = (time_t)t;
+                struct tm ours, libc;
+                zone.toLocal(value, ours);
+                localtime_r(&value, &libc);
+                if (ours.tm_hour != libc.tm_hour || ours.tm_mday != libc.tm_mday ||
+                    ours.tm_min != libc.tm_min || ours.tm_isdst != libc.tm_isdst) {
+                    localMismatches++;
+                }
+
+                // Round-trip the libc wall time (isdst pinned, so the overlap is unambiguous)
+                struct tm wall = libc;
+                if (zone.toUtc(wall) != value) {
+                    utcMismatches++;
+                }
+            }
+
+            CHECK_MESSAGE(localMismatches == 0, std::string(it->first.c_str()));
+            CHECK_MESSAGE(utcMismatches == 0, std::string(it->first.c_str()));
+        }
+    }
+
+    TEST_CASE("Local zone follows the TZ environment variable") {
+        TimeZoneEngine::clear();
+        {
+            ScopedTZ tz("Europe/Rome");
+            const CompiledTimeZone* local = TimeZoneEngine::local();
+            REQUIRE(local != nullptr);
+            CHECK(local->offsetAt(1768000000) == 3600);
+
+            struct tm t = makeTm(2026, 7, 1, 12, 0);
+            CHECK(TimeZoneEngine::makeLocal(t) == 1782900000);
+        }
+        {
+            ScopedTZ tz("JST-9");
+            struct tm t;
+            TimeZoneEngine::localTime(0, t);
+            CHECK(t.tm_hour == 9);
+        }
+    }
+}
+
+TEST_SUITE("TimeZoneEngine - Benchmark") {
+
+    TEST_CASE("Conversions/second versus setenv + tzset + mktime") {
+        const char* posix = "CET-1CEST,M3.5.0,M10.5.0/3";
+        const int conversions = 20000;
+
+        const char* old = getenv("TZ");
+        std::string saved = old ? old : "";
+
+        // Previous path: switch the process TZ around every conversion
+        time_t legacySum = 0;
+        std::chrono::steady_clock::time_point legacyStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < conversions; i++) {
+            struct tm t = makeTm(2026, 1 + i % 12, 1 + i % 28, i % 24, i % 60);
+            setenv("TZ", posix, 1);
+            tzset();
+            legacySum += mktime(&t);
+            if (!saved.empty()) {
+                setenv("TZ", saved.c_str(), 1);
+            } else {
+                unsetenv("TZ");
+            }
+            tzset();
+        }
+        double legacySeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - legacyStart).count();
+
+        TimeZoneEngine::clear();
+        time_t engineSum = 0;
+        std::chrono::steady_clock::time_point engineStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < conversions; i++) {
+            struct tm t = makeTm(2026, 1 + i % 12, 1 + i % 28, i % 24, i % 60);
+            engineSum += TimeZoneEngine::find(posix)->toUtc(t);
+        }
+        double engineSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - engineStart).count();
+
+        MESSAGE("Local->UTC conversions: ", conversions);
+        MESSAGE("  setenv + tzset + mktime: ",
+                (unsigned long)(legacySeconds > 0 ? conversions / legacySeconds : 0), " conversions/s");
+        MESSAGE("  CompiledTimeZone:        ",
+                (unsigned long)(engineSeconds > 0 ? conversions / engineSeconds : 0), " conversions/s");
+
+        CHECK(engineSum == legacySum);
+    }
+}
@@ -0,0 +1,345 @@
+/**
+ * @file test_tls_session_cache.cpp
+ * @brief Tests for the TLS session cache kept across deep sleep
+ *
+ * Tests cover:
+ * - Store, replace and lookup by host:port key
+ * - Least recently used eviction and age expiry
+ * - Resumed handshakes storing their session again: no change, same age
+ * - Serialized image: round trip, short buffers, corruption
+ * - RTC image with LittleFS fallback, the file rewritten every few wakes
+ * - Full and resumed handshake statistics
+ */
+
+#include <doctest.h>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../mock_littlefs.h"
+#include "tls_session_cache.h"
+
+namespace {
+
+const uint32_t NOW = 1760000000;
+
+std::vector<uint8_t> session(uint8_t fill, size_t length) {
+    return std::vector<uint8_t>(length, fill);
+}
+
+// Stored session of key, or empty if none
+std::vector<uint8_t> sessionOf(TlsSessionCache& cache, const char* key, uint32_t now = NOW) {
+    std::vector<uint8_t> buffer(TLS_SESSION_MAX_BYTES);
+    size_t length = cache.lookup(key, buffer.data(), buffer.size(), now);
+    buffer.resize(length);
+    return buffer;
+}
+
+bool storeSession(TlsSessionCache& cache, const char* key, const std::vector<uint8_t>& data, uint32_t now = NOW,
+    bool resumed = false) {
+    return cache.store(key, data.data(), data.size(), now, resumed);
+}
+
+} // namespace
+
+TEST_SUITE("TlsSessionCache")
+{
+    TEST_CASE("Keys combine lowercased host and port")
+    {
+        CHECK(TlsSessionCache::makeKey("Calendar.Google.com", 443) == "calendar.google.com:443");
+        CHECK(TlsSessionCache::makeKey("api.open-meteo.com", 8443) == "api.open-meteo.com:8443");
+    }
+
+    TEST_CASE("Stored sessions are returned by key")
+    {
+        TlsSessionCache cache;
+        CHECK(storeSession(cache, "calendar.google.com:443", session(0xA1, 300)));
+        CHECK(storeSession(cache, "api.open-meteo.com:443", session(0xB2, 120)));
+
+        CHECK(sessionOf(cache, "calendar.google.com:443") == session(0xA1, 300));
+        CHECK(sessionOf(cache, "api.open-meteo.com:443") == session(0xB2, 120));
+        CHECK(sessionOf(cache, "outlook.office365.com:443").empty());
+        CHECK(cache.size() == 2);
+        CHECK(cache.isDirty());
+    }
+
+    TEST_CASE("A new session for the same host replaces the old one")
+    {
+        TlsSessionCache cache;
+        storeSession(cache, "calendar.google.com:443", session(0x01, 200));
+        storeSession(cache, "calendar.google.com:443", session(0x02, 250));
+        CHECK(cache.size() == 1);
+        CHECK(sessionOf(cache, "calendar.google.com:443") == session(0x02, 250));
+    }
+
+    TEST_CASE("Empty and oversized sessions are rejected")
+    {
+        TlsSessionCache cache;
+        std::vector<uint8_t> tooLarge = session(0x01, TLS_SESSION_MAX_BYTES + 1);
+        CHECK_FALSE(storeSession(cache, "a:443", tooLarge));
+        CHECK_FALSE(cache.store("a:443", nullptr, 0, NOW));
+        CHECK_FALSE(storeSession(cache, "", session(0x01, 10)));
+        CHECK(cache.size() == 0);
+        CHECK_FALSE(cache.isDirty());
+    }
+
+    TEST_CASE("The least recently used session is evicted when full")
+    {
+        TlsSessionCache cache(3);
+        storeSession(cache, "a:443", session(0x0A, 50));
+        storeSession(cache, "b:443", session(0x0B, 50));
+        storeSession(cache, "c:443", session(0x0C, 50));
+
+        // Using "a" makes "b" the oldest
+        CHECK_FALSE(sessionOf(cache, "a:443").empty());
+        storeSession(cache, "d:443", session(0x0D, 50));
+
+        CHECK(cache.size() == 3);
+        CHECK(sessionOf(cache, "b:443").empty());
+        CHECK_FALSE(sessionOf(cache, "a:443").empty());
+        CHECK_FALSE(sessionOf(cache, "c:443").empty());
+        CHECK_FALSE(sessionOf(cache, "d:443").empty());
+    }
+
+    TEST_CASE("Sessions older than the maximum age are dropped")
+    {
+        TlsSessionCache cache(4, 3600);
+        storeSession(cache, "old:443", session(0x01, 40), NOW);
+        storeSession(cache, "new:443", session(0x02, 40), NOW + 3000);
+
+        CHECK_FALSE(sessionOf(cache, "old:443", NOW + 3600).empty());
+        CHECK(sessionOf(cache, "old:443", NOW + 3601).empty());
+        CHECK(cache.size() == 1);
+
+        // A clock that is not set yet does not expire anything
+        CHECK_FALSE(sessionOf(cache, "new:443", 1000).empty());
+    }
+
+    TEST_CASE("A resumed handshake keeps the session's age and only dirties new bytes")
+    {
+        TlsSessionCache cache(4, 3600);
+        storeSession(cache, "a:443", session(0x01, 80), NOW);
+        storeSession(cache, "b:443", session(0x02, 80), NOW);
+        storeSession(cache, "c:443", session(0x03, 80), NOW);
+        LittleFS.clear();
+        REQUIRE(cache.flush());
+        CHECK_FALSE(cache.isDirty());
+
+        // The same bytes again: nothing for the file
+        CHECK(storeSession(cache, "a:443", session(0x01, 80), NOW + 3000, true));
+        CHECK_FALSE(cache.isDirty());
+
+        // A renewed ticket is new bytes, but still dates from the full handshake
+        CHECK(storeSession(cache, "b:443", session(0x22, 90), NOW + 3000, true));
+        CHECK(cache.isDirty());
+
+        // A full handshake starts the age over
+        storeSession(cache, "c:443", session(0x33, 80), NOW + 3000);
+
+        CHECK(sessionOf(cache, "a:443", NOW + 3601).empty());
+        CHECK(sessionOf(cache, "b:443", NOW + 3601).empty());
+        CHECK(sessionOf(cache, "c:443", NOW + 3601) == session(0x33, 80));
+        LittleFS.clear();
+    }
+
+    TEST_CASE("Lookup into a short buffer returns nothing")
+    {
+        TlsSessionCache cache;
+        storeSession(cache, "a:443", session(0x01, 100));
+        uint8_t buffer[50];
+        CHECK(cache.lookup("a:443", buffer, sizeof(buffer), NOW) == 0);
+        CHECK(cache.size() == 1);
+    }
+
+    TEST_CASE("Serialized image round-trips")
+    {
+        TlsSessionCache cache;
+        storeSession(cache, "calendar.google.com:443", session(0x11, 1500));
+        storeSession(cache, "api.open-meteo.com:443", session(0x22, 200));
+
+        std::vector<uint8_t> image(8192);
+        bool complete = false;
+        size_t length = cache.serialize(image.data(), image.size(), complete);
+        CHECK(complete);
+        CHECK(length > 1700);
+
+        TlsSessionCache restored;
+        CHECK(restored.deserialize(image.data(), length, NOW, complete));
+        CHECK(complete);
+        CHECK(restored.size() == 2);
+        CHECK(sessionOf(restored, "calendar.google.com:443") == session(0x11, 1500));
+        CHECK(sessionOf(restored, "api.open-meteo.com:443") == session(0x22, 200));
+    }
+
+    TEST_CASE("A short image keeps the most recently used sessions")
+    {
+        TlsSessionCache cache;
+        storeSession(cache, "a:443", session(0x0A, 1000));
+        storeSession(cache, "b:443", session(0x0B, 1000));
+        storeSession(cache, "c:443", session(0x0C, 1000));
+        sessionOf(cache, "a:443");
+
+        std::vector<uint8_t> image(2100);
+        bool complete = true;
+        size_t length = cache.serialize(image.data(), image.size(), complete);
+        CHECK_FALSE(complete);
+
+        TlsSessionCache restored;
+        CHECK(restored.deserialize(image.data(), length, NOW, complete));
+        CHECK_FALSE(complete);
+        CHECK(restored.size() == 2);
+        CHECK_FALSE(sessionOf(restored, "a:443").empty());
+        CHECK_FALSE(sessionOf(restored, "c:443").empty());
+        CHECK(sessionOf(restored, "b:443").empty());
+    }
+
+    TEST_CASE("Corrupted or foreign images are rejected")
+    {
+        TlsSessionCache cache;
+        storeSession(cache, "a:443", session(0x0A, 100));
+        std::vector<uint8_t> image(1024);
+        bool complete;
+        size_t length = cache.serialize(image.data(), image.size(), complete);
+
+        TlsSessionCache restored;
+        std::vector<uint8_t> flipped(image.begin(), image.begin() + length);
+        flipped[length - 1] ^= 0xFF;
+        CHECK_FALSE(restored.deserialize(flipped.data(), flipped.size(), NOW, complete));
+        CHECK_FALSE(restored.deserialize(image.data(), length - 1, NOW, complete));
+        CHECK_FALSE(restored.deserialize(image.data(), 10, NOW, complete));
+
+        std::vector<uint8_t> zeros(length, 0);
+        CHECK_FALSE(restored.deserialize(zeros.data(), zeros.size(), NOW, complete));
+        CHECK(restored.size() == 0);
+    }
+
+    TEST_CASE("Sessions survive a wake through RTC memory")
+    {
+        LittleFS.clear();
+        TlsSessionCache::clearRtcImage();
+        {
+            TlsSessionCache cache;
+            storeSession(cache, "calendar.google.com:443", session(0x33, 800));
+            CHECK(cache.save());
+        }
+
+        // RTC memory alone is enough: the file is not needed, and not written yet
+        CHECK_FALSE(LittleFS.exists(TLS_SESSION_FILE));
+        TlsSessionCache nextWake;
+        CHECK(nextWake.load(NOW + 86400));
+        CHECK(sessionOf(nextWake, "calendar.google.com:443", NOW + 86400) == session(0x33, 800));
+        CHECK(nextWake.isDirty());
+        TlsSessionCache::clearRtcImage();
+    }
+
+    TEST_CASE("Changed sessions reach LittleFS every few wakes")
+    {
+        LittleFS.clear();
+        TlsSessionCache::clearRtcImage();
+        {
+            TlsSessionCache cache;
+            storeSession(cache, "calendar.google.com:443", session(0x66, 500));
+            CHECK(cache.save());
+        }
+        for (int wake = 2; wake < TLS_SESSION_FLUSH_WAKES; wake++) {
+            TlsSessionCache cache;
+            cache.load(NOW);
+            CHECK(cache.save());
+            CHECK_FALSE(LittleFS.exists(TLS_SESSION_FILE));
+        }
+        {
+            TlsSessionCache cache;
+            cache.load(NOW);
+            CHECK(cache.save());
+            CHECK(LittleFS.exists(TLS_SESSION_FILE));
+            CHECK_FALSE(cache.isDirty());
+        }
+
+        // Written: the next wakes have nothing to flush
+        size_t writes = LittleFS.writeCount();
+        for (int wake = 0; wake < TLS_SESSION_FLUSH_WAKES; wake++) {
+            TlsSessionCache cache;
+            cache.load(NOW);
+            CHECK_FALSE(cache.isDirty());
+            CHECK(cache.save());
+        }
+        CHECK(LittleFS.writeCount() == writes);
+
+        TlsSessionCache::clearRtcImage(); // Power loss
+        TlsSessionCache afterPowerLoss;
+        CHECK(afterPowerLoss.load(NOW));
+        CHECK(sessionOf(afterPowerLoss, "calendar.google.com:443") == session(0x66, 500));
+        LittleFS.clear();
+    }
+
+    TEST_CASE("LittleFS restores the sessions after RTC memory was lost")
+    {
+        LittleFS.clear();
+        TlsSessionCache::clearRtcImage();
+        {
+            TlsSessionCache cache;
+            storeSession(cache, "calendar.google.com:443", session(0x44, 600));
+            storeSession(cache, "api.open-meteo.com:443", session(0x55, 300));
+            CHECK(cache.flush());
+        }
+        CHECK(LittleFS.exists(TLS_SESSION_FILE));
+
+        TlsSessionCache::clearRtcImage(); // Power loss
+        TlsSessionCache afterPowerLoss;
+        CHECK(afterPowerLoss.load(NOW + 60));
+        CHECK(afterPowerLoss.size() == 2);
+        CHECK(sessionOf(afterPowerLoss, "api.open-meteo.com:443", NOW + 60) == session(0x55, 300));
+        LittleFS.clear();
+    }
+
+    TEST_CASE("Sessions that do not fit in RTC memory come from LittleFS")
+    {
+        LittleFS.clear();
+        TlsSessionCache::clearRtcImage();
+        {
+            TlsSessionCache cache;
+            storeSession(cache, "a:443", session(0x0A, 3000));
+            storeSession(cache, "b:443", session(0x0B, 3000));
+            CHECK(cache.save());
+        }
+
+        TlsSessionCache nextWake;
+        CHECK(nextWake.load(NOW));
+        CHECK(nextWake.size() == 2);
+        CHECK(sessionOf(nextWake, "a:443") == session(0x0A, 3000));
+        CHECK(sessionOf(nextWake, "b:443") == session(0x0B, 3000));
+        LittleFS.clear();
+        TlsSessionCache::clearRtcImage();
+    }
+
+    TEST_CASE("An unchanged cache does not rewrite LittleFS")
+    {
+        LittleFS.clear();
+        TlsSessionCache::clearRtcImage();
+        {
+            TlsSessionCache cache;
+            storeSession(cache, "a:443", session(0x0A, 100));
+            CHECK(cache.save());
+            CHECK(cache.flush());
+        }
+        LittleFS.remove(TLS_SESSION_FILE);
+
+        TlsSessionCache nextWake;
+        nextWake.load(NOW);
+        CHECK(nextWake.save());
+        CHECK_FALSE(LittleFS.exists(TLS_SESSION_FILE));
+        TlsSessionCache::clearRtcImage();
+    }
+
+    TEST_CASE("Handshake statistics separate full and resumed handshakes")
+    {
+        TlsSessionCache cache;
+        cache.recordHandshake(false, 1800);
+        cache.recordHandshake(true, 350);
+        cache.recordHandshake(true, 250);
+        CHECK(cache.getFullHandshakeCount() == 1);
+        CHECK(cache.getFullHandshakeMs() == 1800);
+        CHECK(cache.getResumedHandshakeCount() == 2);
+        CHECK(cache.getResumedHandshakeMs() == 600);
+    }
+}
@@ -0,0 +1,297 @@
+/**
+ * @file test_vtimezone_builder.cpp
+ * @brief Tests for VTIMEZONE compilation and per-calendar zone resolution
+ *
+ * Tests cover:
+ * - Outlook/Exchange custom TZIDs ("W. Europe Standard Time")
+ * - Historical observances (UNTIL) next to the current open-ended rules
+ * - Zones without DST, southern hemisphere rules and older BYMONTHDAY forms
+ * - Rules POSIX cannot express
+ * - Stream parsing of events whose TZID is only defined by a VTIMEZONE
+ */
+
+#include <doctest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "calendar_stream_parser.h"
+#include "timezone_engine.h"
+#include "vtimezone_builder.h"
+
+namespace {
+
+/**
+ * @brief Feed a VTIMEZONE block (starting after BEGIN:VTIMEZONE) line by line
+ *
+ * @return true if END:VTIMEZONE was reached
+ */
+bool feedTimezone(VTimezoneBuilder& builder, const char* block) {
+    builder.begin();
+    const char* p = block;
+    while (*p) {
+        const char* end = strchr(p, '\n');
+        size_t length = end ? (size_t)(end - p) : strlen(p);
+        if (length > 0 && builder.addLine(p, length)) {
+            return true;
+        }
+        p += length + (end ? 1 : 0);
+    }
+    return false;
+}
+
+std::string posixFor(const char* block) {
+    VTimezoneBuilder builder;
+    String posix;
+    if (!feedTimezone(builder, block) || !builder.toPosix(posix)) {
+        return "";
+    }
+    return posix.c_str();
+}
+
+const char* OUTLOOK_WEST_EUROPE = R"(TZID:W. Europe Standard Time
+BEGIN:STANDARD
+DTSTART:16010101T030000
+TZOFFSETFROM:+0200
+TZOFFSETTO:+0100
+RRULE:FREQ=YEARLY;INTERVAL=1;BYDAY=-1SU;BYMONTH=10
+END:STANDARD
+BEGIN:DAYLIGHT
+DTSTART:16010101T020000
+TZOFFSETFROM:+0100
+TZOFFSETTO:+0200
+RRULE:FREQ=YEARLY;INTERVAL=1;BYDAY=-1SU;BYMONTH=3
+END:DAYLIGHT
+END:VTIMEZONE
+)";
+
+const char* US_EASTERN_HISTORY = R"(TZID:America/New_York
+X-LIC-LOCATION:America/New_York
+BEGIN:DAYLIGHT
+TZOFFSETFROM:-0500
+TZOFFSETTO:-0400
+TZNAME:EDT
+DTSTART:19870405T020000
+RRULE:FREQ=YEARLY;BYMONTH=4;BYDAY=1SU;UNTIL=20060402T070000Z
+END:DAYLIGHT
+BEGIN:DAYLIGHT
+TZOFFSETFROM:-0500
+TZOFFSETTO:-0400
+TZNAME:EDT
+DTSTART:20070311T020000
+RRULE:FREQ=YEARLY;BYMONTH=3;BYDAY=2SU
+END:DAYLIGHT
+BEGIN:STANDARD
+TZOFFSETFROM:-0400
+TZOFFSETTO:-0500
+TZNAME:EST
+DTSTART:20071104T020000
+RRULE:FREQ=YEARLY;BYMONTH=11;BYDAY=1SU
+END:STANDARD
+BEGIN:STANDARD
+TZOFFSETFROM:-0400
+TZOFFSETTO:-0500
+TZNAME:EST
+DTSTART:19671029T020000
+RRULE:FREQ=YEARLY;BYMONTH=10;BYDAY=-1SU;UNTIL=20061029T060000Z
+END:STANDARD
+END:VTIMEZONE
+)";
+
+} // namespace
+
+TEST_SUITE("VTimezoneBuilder - POSIX Conversion")
+{
+    TEST_CASE("Outlook custom TZID")
+    {
+        VTimezoneBuilder builder;
+        REQUIRE(feedTimezone(builder, OUTLOOK_WEST_EUROPE));
+        CHECK(builder.getTzid() == "W. Europe Standard Time");
+
+        String posix;
+        REQUIRE(builder.toPosix(posix));
+        CHECK(std::string(posix.c_str()) == "STD-1DST-2,M3.5.0/2:00:00,M10.5.0/3:00:00");
+    }
+
+    TEST_CASE("Historical observances are superseded by open-ended rules")
+    {
+        CHECK(posixFor(US_EASTERN_HISTORY) == "STD5DST4,M3.2.0/2:00:00,M11.1.0/2:00:00");
+    }
+
+    TEST_CASE("Zone without DST")
+    {
+        const char* india = R"(TZID:India Standard Time
+BEGIN:STANDARD
+DTSTART:16010101T000000
+TZOFFSETFROM:+0530
+TZOFFSETTO:+0530
+END:STANDARD
+END:VTIMEZONE
+)";
+        CHECK(posixFor(india) == "STD-5:30");
+    }
+
+    TEST_CASE("DST that ended is ignored")
+    {
+        const char* moscow = R"(TZID:Russian Standard Time
+BEGIN:DAYLIGHT
+DTSTART:20100328T020000
+TZOFFSETTO:+0400
+RRULE:FREQ=YEARLY;BYMONTH=3;BYDAY=-1SU;UNTIL=20100327T230000Z
+END:DAYLIGHT
+BEGIN:STANDARD
+DTSTART:20141026T020000
+TZOFFSETTO:+0300
+END:STANDARD
+END:VTIMEZONE
+)";
+        CHECK(posixFor(moscow) == "STD-3");
+    }
+
+    TEST_CASE("Southern hemisphere rules")
+    {
+        const char* sydney = R"(TZID:AUS Eastern Standard Time
+BEGIN:STANDARD
+DTSTART:16010101T030000
+TZOFFSETTO:+1000
+RRULE:FREQ=YEARLY;BYDAY=1SU;BYMONTH=4
+END:STANDARD
+BEGIN:DAYLIGHT
+DTSTART:16010101T020000
+TZOFFSETTO:+1100
+RRULE:FREQ=YEARLY;BYDAY=1SU;BYMONTH=10
+END:DAYLIGHT
+END:VTIMEZONE
+)";
+        std::string posix = posixFor(sydney);
+        CHECK(posix == "STD-10DST-11,M10.1.0/2:00:00,M4.1.0/3:00:00");
+
+        CompiledTimeZone zone;
+        REQUIRE(zone.compile(posix.c_str()));
+        CHECK(zone.offsetAt(utcFor(2026, 1, 15, 0, 0)) == 11 * 3600);
+        CHECK(zone.offsetAt(utcFor(2026, 7, 15, 0, 0)) == 10 * 3600);
+    }
+
+    TEST_CASE("Older BYMONTHDAY week form")
+    {
+        const char* eastern = R"(TZID:Eastern
+BEGIN:DAYLIGHT
+DTSTART:20070311T020000
+TZOFFSETTO:-0400
+RRULE:FREQ=YEARLY;BYMONTH=3;BYDAY=SU;BYMONTHDAY=8,9,10,11,12,13,14
+END:DAYLIGHT
+BEGIN:STANDARD
+DTSTART:20071104T020000
+TZOFFSETTO:-0500
+RRULE:FREQ=YEARLY;BYMONTH=11;BYDAY=SU;BYMONTHDAY=1,2,3,4,5,6,7
+END:STANDARD
+END:VTIMEZONE
+)";
+        CHECK(posixFor(eastern) == "STD5DST4,M3.2.0/2:00:00,M11.1.0/2:00:00");
+    }
+
+    TEST_CASE("Fixed-date transitions become Julian days")
+    {
+        const char* tehran = R"(TZID:Iran
+BEGIN:DAYLIGHT
+DTSTART:20080321T000000
+TZOFFSETTO:+043000
+RRULE:FREQ=YEARLY;BYMONTH=3;BYMONTHDAY=21
+END:DAYLIGHT
+BEGIN:STANDARD
+DTSTART:20080921T000000
+TZOFFSETTO:+033000
+RRULE:FREQ=YEARLY;BYMONTH=9;BYMONTHDAY=21
+END:STANDARD
+END:VTIMEZONE
+)";
+        CHECK(posixFor(tehran) == "STD-3:30DST-4:30,J80/0:00:00,J264/0:00:00");
+    }
+
+    TEST_CASE("Rules POSIX cannot express are rejected")
+    {
+        const char* secondToLast = R"(TZID:Odd
+BEGIN:DAYLIGHT
+DTSTART:20070311T020000
+TZOFFSETTO:-0400
+RRULE:FREQ=YEARLY;BYMONTH=3;BYDAY=-2SU
+END:DAYLIGHT
+BEGIN:STANDARD
+DTSTART:20071104T020000
+TZOFFSETTO:-0500
+RRULE:FREQ=YEARLY;BYMONTH=11;BYDAY=1SU
+END:STANDARD
+END:VTIMEZONE
+)";
+        CHECK(posixFor(secondToLast) == "");
+    }
+
+    TEST_CASE("Builder can be reused")
+    {
+        VTimezoneBuilder builder;
+        REQUIRE(feedTimezone(builder, US_EASTERN_HISTORY));
+        REQUIRE(feedTimezone(builder, OUTLOOK_WEST_EUROPE));
+
+        String posix;
+        REQUIRE(builder.toPosix(posix));
+        CHECK(std::string(posix.c_str()) == "STD-1DST-2,M3.5.0/2:00:00,M10.5.0/3:00:00");
+    }
+}
+
+TEST_SUITE("VTimezoneBuilder - Stream Parsing")
+{
+    TEST_CASE("Events resolve TZIDs defined in the calendar")
+    {
+        std::string ics = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Microsoft Corporation//Outlook 16.0//EN\r\n"
+                          "BEGIN:VTIMEZONE\r\n";
+        for (const char* p = OUTLOOK_WEST_EUROPE; *p; p++) {
+            if (*p == '\n') {
+                ics += "\r\n";
+            } else {
+                ics += *p;
+            }
+        }
+        ics += "BEGIN:VTIMEZONE\r\n";
+        ics += US_EASTERN_HISTORY;
+        ics += "BEGIN:VEVENT\r\n"
+               "UID:summer@example.com\r\n"
+               "SUMMARY:Summer\r\n"
+               "DTSTART;TZID=\"W. Europe Standard Time\":20260715T100000\r\n"
+               "DTEND;TZID=\"W. Europe Standard Time\":20260715T110000\r\n"
+               "END:VEVENT\r\n"
+               "BEGIN:VEVENT\r\n"
+               "UID:winter@example.com\r\n"
+               "SUMMARY:Winter\r\n"
+               "DTSTART;TZID=W. Europe Standard Time:20260115T100000\r\n"
+               "DTEND;TZID=America/New_York:20260115T050000\r\n"
+               "END:VEVENT\r\n"
+               "END:VCALENDAR\r\n";
+
+        StringStream stream((String(ics.c_str())));
+        CalendarStreamParser parser;
+        std::vector<CalendarEvent*> events;
+
+        bool ok = parser.streamParseFromStream(
+            &stream,
+            [&events](CalendarEvent* event) { events.push_back(event); },
+            utcFor(2026, 1, 1, 0, 0),
+            utcFor(2027, 1, 1, 0, 0));
+
+        CHECK(ok);
+        CHECK(parser.getLastParseStats().timezones == 2);
+        REQUIRE(events.size() == 2);
+
+        for (auto event : events) {
+            if (event->summary == "Summer") {
+                CHECK(event->startTime == utcFor(2026, 7, 15, 8, 0));
+                CHECK(event->endTime == utcFor(2026, 7, 15, 9, 0));
+            } else {
+                CHECK(event->startTime == utcFor(2026, 1, 15, 9, 0));
+                CHECK(event->endTime == utcFor(2026, 1, 15, 10, 0));
+            }
+            delete event;
+        }
+    }
+}
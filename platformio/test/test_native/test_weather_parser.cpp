@@ -0,0 +1,182 @@
+/**
+ * @file test_weather_parser.cpp
+ * @brief Tests for the streaming Open-Meteo response parser
+ *
+ * Tests cover:
+ * - Recorded Open-Meteo responses parsed from a stream
+ * - Peak heap of the filtered parse, compared with holding the body in a
+ *   String and deserializing all of it
+ * - Invalid and truncated responses
+ */
+
+#include <doctest.h>
+#include <cstdlib>
+#include <map>
+#include <string>
+
+#include "../mock_arduino.h"
+#include "../test_helpers.h"
+#include "weather_parser.h"
+
+namespace {
+
+// Heap for JSON documents that records the largest amount in use at once
+class PeakAllocator : public ArduinoJson::Allocator {
+  public:
+    PeakAllocator() : current(0), peak(0) {}
+
+    void* allocate(size_t size) override {
+        void* block = malloc(size);
+        if (block) {
+            track(block, 0, size);
+        }
+        return block;
+    }
+
+    void deallocate(void* block) override {
+        if (!block) {
+            return;
+        }
+        current -= sizes[block];
+        sizes.erase(block);
+        free(block);
+    }
+
+    void* reallocate(void* block, size_t size) override {
+        size_t previous = 0;
+        if (block) {
+            previous = sizes[block];
+            sizes.erase(block);
+        }
+        void* moved = realloc(block, size);
+        if (moved) {
+            track(moved, previous, size);
+        } else if (block) {
+            sizes[block] = previous;
+        }
+        return moved;
+    }
+
+    size_t current;
+    size_t peak;
+
+  private:
+    void track(void* block, size_t previous, size_t size) {
+        sizes[block] = size;
+        current = current - previous + size;
+        if (current > peak) {
+            peak = current;
+        }
+    }
+
+    std::map<void*, size_t> sizes;
+};
+
+// Peak heap of WeatherParser::parse() on a response
+size_t filteredPeak(const std::string& json, WeatherData& data) {
+    PeakAllocator allocator;
+    StringStream stream((String(json)));
+    REQUIRE(WeatherParser::parse(stream, data, &allocator));
+    CHECK(allocator.current == 0);
+    return allocator.peak;
+}
+
+// Peak heap of deserializing a whole response without a filter
+size_t unfilteredPeak(const std::string& json) {
+    PeakAllocator allocator;
+    {
+        JsonDocument doc(&allocator);
+        REQUIRE_FALSE(deserializeJson(doc, json.c_str()));
+    }
+    return allocator.peak;
+}
+
+} // namespace
+
+TEST_SUITE("WeatherParser - Open-Meteo")
+{
+    TEST_CASE("The recorded daily forecast is parsed from a stream")
+    {
+        std::string json = loadFixture("test/fixtures/open_meteo_forecast.json");
+        REQUIRE(!json.empty());
+
+        WeatherData data;
+        data.currentTemp = -99;
+        StringStream stream((String(json)));
+        REQUIRE(WeatherParser::parse(stream, data));
+
+        // Only daily data was requested: current conditions are left alone
+        CHECK(data.currentTemp == doctest::Approx(-99));
+        REQUIRE(data.dailyForecast.size() == 3);
+        CHECK(data.dailyForecast[0].date == "2026-03-10");
+        CHECK(data.dailyForecast[0].weatherCode == 3);
+        CHECK(data.dailyForecast[0].tempMax == doctest::Approx(15.8));
+        CHECK(data.dailyForecast[0].tempMin == doctest::Approx(7.1));
+        CHECK(data.dailyForecast[0].sunrise == "2026-03-10T06:31");
+        CHECK(data.dailyForecast[0].sunset == "2026-03-10T18:12");
+        CHECK(data.dailyForecast[0].precipitationProbability == 12);
+        CHECK(data.dailyForecast[1].weatherCode == 61);
+        CHECK(data.dailyForecast[1].precipitationProbability == 85);
+        CHECK(data.dailyForecast[2].date == "2026-03-12");
+        CHECK(data.dailyForecast[2].sunset == "2026-03-12T18:14");
+    }
+
+    TEST_CASE("Current conditions are read and hourly data is skipped")
+    {
+        std::string json = loadFixture("test/fixtures/open_meteo_forecast_hourly.json");
+        REQUIRE(!json.empty());
+
+        WeatherData data;
+        StringStream stream((String(json)));
+        REQUIRE(WeatherParser::parse(stream, data));
+        CHECK(data.currentTemp == doctest::Approx(6.4));
+        CHECK(data.currentWeatherCode == 3);
+        CHECK(data.isDay);
+        REQUIRE(data.dailyForecast.size() == 3);
+        CHECK(data.dailyForecast[1].date == "2026-03-11");
+        CHECK(data.dailyForecast[1].tempMax == doctest::Approx(13.2));
+    }
+
+    TEST_CASE("Peak heap does not depend on the fields that are skipped")
+    {
+        std::string hourly = loadFixture("test/fixtures/open_meteo_forecast_hourly.json");
+        REQUIRE(!hourly.empty());
+
+        // The same response without its hourly block
+        size_t hourlyStart = hourly.find("\"hourly_units\"");
+        size_t hourlyEnd = hourly.find("\"daily_units\"");
+        REQUIRE(hourlyStart != std::string::npos);
+        REQUIRE(hourlyEnd > hourlyStart);
+        std::string withoutHourly = hourly.substr(0, hourlyStart) + hourly.substr(hourlyEnd);
+
+        WeatherData data;
+        size_t hourlyPeak = filteredPeak(hourly, data);
+        size_t withoutHourlyPeak = filteredPeak(withoutHourly, data);
+
+        // Previously the body was held in a String and deserialized in full
+        size_t previousPeak = hourly.size() + unfilteredPeak(hourly);
+        MESSAGE("Peak heap: ", (unsigned long)hourlyPeak, " bytes streaming with the filter, ",
+                (unsigned long)previousPeak, " bytes with the body in a String");
+
+        // Only the filter and the kept fields are allocated
+        CHECK(hourlyPeak <= withoutHourlyPeak + 64);
+        CHECK(hourlyPeak < unfilteredPeak(hourly));
+        CHECK(hourlyPeak * 2 < previousPeak);
+    }
+
+    TEST_CASE("Invalid and truncated responses fail")
+    {
+        std::string json = loadFixture("test/fixtures/open_meteo_forecast.json");
+        REQUIRE(!json.empty());
+
+        WeatherData data;
+        StringStream truncated((String(json.substr(0, json.size() / 2))));
+        CHECK_FALSE(WeatherParser::parse(truncated, data));
+
+        StringStream html((String("<html><body>Bad Gateway</body></html>")));
+        CHECK_FALSE(WeatherParser::parse(html, data));
+
+        StringStream empty((String("")));
+        CHECK_FALSE(WeatherParser::parse(empty, data));
+    }
+}